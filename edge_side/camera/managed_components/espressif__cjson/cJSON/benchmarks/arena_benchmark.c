@@ -0,0 +1,172 @@
+/*
+  Copyright (c) 2009-2017 Dave Gamble and cJSON contributors
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+/* Compares parsing and deleting a document with the malloc hooks against parsing it into an arena and resetting that,
+ * counting the calls that reach the hooks and timing both per document.
+ * usage: arena_benchmark [iterations] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../cJSON.h"
+
+static unsigned long allocations = 0;
+static unsigned long deallocations = 0;
+
+static void *CJSON_CDECL counting_malloc(size_t size)
+{
+    allocations++;
+    return malloc(size);
+}
+
+static void CJSON_CDECL counting_free(void *pointer)
+{
+    deallocations++;
+    free(pointer);
+}
+
+/* a status report like the camera sends, with the given number of detections */
+static char *create_document(size_t detections)
+{
+    cJSON *root = cJSON_CreateObject();
+    cJSON *list = cJSON_AddArrayToObject(root, "detections");
+    char *printed = NULL;
+    size_t i = 0;
+
+    cJSON_AddStringToObject(root, "camera", "entrance-north");
+    cJSON_AddNumberToObject(root, "timestamp", 1700000000123.0);
+    cJSON_AddNumberToObject(root, "frame", 48213);
+    cJSON_AddBoolToObject(root, "motion", 1);
+    for (i = 0; i < detections; i++)
+    {
+        cJSON *detection = cJSON_CreateObject();
+        cJSON *box = cJSON_AddArrayToObject(detection, "box");
+        cJSON_AddStringToObject(detection, "label", (i % 3) ? "person" : "vehicle");
+        cJSON_AddNumberToObject(detection, "score", 0.5 + (double)(i % 50) / 100.0);
+        cJSON_AddNumberToObject(detection, "track", (double)(1000 + i));
+        cJSON_AddItemToArray(box, cJSON_CreateNumber((double)(i * 13 % 640)));
+        cJSON_AddItemToArray(box, cJSON_CreateNumber((double)(i * 7 % 480)));
+        cJSON_AddItemToArray(box, cJSON_CreateNumber(64));
+        cJSON_AddItemToArray(box, cJSON_CreateNumber(128));
+        cJSON_AddItemToArray(list, detection);
+    }
+
+    printed = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    if (printed == NULL)
+    {
+        fprintf(stderr, "Failed to create the document.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return printed;
+}
+
+static void benchmark(size_t detections, unsigned long iterations)
+{
+    cJSON_Hooks hooks = { counting_malloc, counting_free };
+    char *document = create_document(detections);
+    size_t length = strlen(document);
+    size_t buffer_size = length * 16 + 4096;
+    void *buffer = malloc(buffer_size);
+    cJSON_Arena arena;
+    unsigned long iteration = 0;
+    unsigned long hook_allocations = 0;
+    unsigned long arena_allocations = 0;
+    double hook_seconds = 0;
+    double arena_seconds = 0;
+    size_t arena_usage = 0;
+    clock_t start = 0;
+
+    if (buffer == NULL)
+    {
+        fprintf(stderr, "Failed to allocate the arena.\n");
+        exit(EXIT_FAILURE);
+    }
+    cJSON_InitArena(&arena, buffer, buffer_size);
+    cJSON_InitHooks(&hooks);
+
+    allocations = deallocations = 0;
+    start = clock();
+    for (iteration = 0; iteration < iterations; iteration++)
+    {
+        cJSON *root = cJSON_ParseWithLength(document, length);
+        if (root == NULL)
+        {
+            fprintf(stderr, "Failed to parse the document.\n");
+            exit(EXIT_FAILURE);
+        }
+        cJSON_Delete(root);
+    }
+    hook_seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    hook_allocations = allocations;
+
+    allocations = deallocations = 0;
+    start = clock();
+    for (iteration = 0; iteration < iterations; iteration++)
+    {
+        cJSON *root = cJSON_ParseWithArena(document, length, &arena);
+        if (root == NULL)
+        {
+            fprintf(stderr, "Failed to parse the document into the arena.\n");
+            exit(EXIT_FAILURE);
+        }
+        arena_usage = cJSON_GetArenaUsage(&arena);
+        cJSON_ResetArena(&arena);
+    }
+    arena_seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    arena_allocations = allocations;
+
+    cJSON_InitHooks(NULL);
+
+    printf("%4lu detections (%6lu bytes)  malloc: %5.1f allocations %8.2f us   arena: %5.1f allocations %8.2f us (%lu bytes used)\n",
+            (unsigned long)detections, (unsigned long)length,
+            (double)hook_allocations / (double)iterations, hook_seconds * 1e6 / (double)iterations,
+            (double)arena_allocations / (double)iterations, arena_seconds * 1e6 / (double)iterations,
+            (unsigned long)arena_usage);
+
+    free(buffer);
+    free(document);
+}
+
+int CJSON_CDECL main(int argc, char **argv)
+{
+    unsigned long iterations = 100000;
+
+    if (argc > 1)
+    {
+        iterations = strtoul(argv[1], NULL, 10);
+    }
+    if (iterations == 0)
+    {
+        iterations = 1;
+    }
+
+    benchmark(0, iterations);
+    benchmark(4, iterations);
+    benchmark(32, iterations / 4 + 1);
+    benchmark(256, iterations / 32 + 1);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,278 @@
+/*
+  Copyright (c) 2009-2017 Dave Gamble and cJSON contributors
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+/* Compares the size and the encode/decode speed of CBOR and MessagePack with cJSON_PrintUnformatted and cJSON_Parse
+ * for a camera command and detection results with 0 to 200 boxes, and the streaming writer with building a tree first.
+ * usage: binary_benchmark [iterations] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../cJSON.h"
+#include "../cJSON_Binary.h"
+
+typedef struct
+{
+    double x;
+    double y;
+    double w;
+    double h;
+    double score;
+} box;
+
+static void create_boxes(unsigned long seed, box *boxes, int count)
+{
+    int i = 0;
+
+    for (i = 0; i < count; i++)
+    {
+        seed = (seed * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+        /* model output scaled back to the frame, so coordinates are rarely integers */
+        boxes[i].x = (double)(seed % 64000UL) / 100.0 + 0.3;
+        boxes[i].y = (double)(seed % 48000UL) / 100.0;
+        boxes[i].w = (double)(seed % 12000UL) / 97.0;
+        boxes[i].h = (double)(seed % 20000UL) / 101.0;
+        boxes[i].score = (double)(seed % 1000UL) / 1000.0;
+    }
+}
+
+static cJSON *create_detections(const box *boxes, int count)
+{
+    cJSON *detections = cJSON_CreateObject();
+    cJSON *array = NULL;
+    int i = 0;
+
+    cJSON_AddStringToObject(detections, "camera", "cam-1");
+    cJSON_AddNumberToObject(detections, "timestamp", 1700000000.0 + ((double)count / 15.0));
+    cJSON_AddNumberToObject(detections, "people_count", count);
+    array = cJSON_AddArrayToObject(detections, "boxes");
+    for (i = 0; i < count; i++)
+    {
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddNumberToObject(item, "x", boxes[i].x);
+        cJSON_AddNumberToObject(item, "y", boxes[i].y);
+        cJSON_AddNumberToObject(item, "w", boxes[i].w);
+        cJSON_AddNumberToObject(item, "h", boxes[i].h);
+        cJSON_AddStringToObject(item, "label", "person");
+        cJSON_AddNumberToObject(item, "score", boxes[i].score);
+        cJSON_AddItemToArray(array, item);
+    }
+
+    return detections;
+}
+
+/* the same message as create_detections without a tree */
+static void write_detections(cJSON_BinaryWriter *writer, const box *boxes, int count)
+{
+    int i = 0;
+
+    cJSON_BinaryStartObject(writer, 4);
+    cJSON_BinaryWriteString(writer, "camera");
+    cJSON_BinaryWriteString(writer, "cam-1");
+    cJSON_BinaryWriteString(writer, "timestamp");
+    cJSON_BinaryWriteNumber(writer, 1700000000.0 + ((double)count / 15.0));
+    cJSON_BinaryWriteString(writer, "people_count");
+    cJSON_BinaryWriteNumber(writer, count);
+    cJSON_BinaryWriteString(writer, "boxes");
+    cJSON_BinaryStartArray(writer, (size_t)count);
+    for (i = 0; i < count; i++)
+    {
+        cJSON_BinaryStartObject(writer, 6);
+        cJSON_BinaryWriteString(writer, "x");
+        cJSON_BinaryWriteNumber(writer, boxes[i].x);
+        cJSON_BinaryWriteString(writer, "y");
+        cJSON_BinaryWriteNumber(writer, boxes[i].y);
+        cJSON_BinaryWriteString(writer, "w");
+        cJSON_BinaryWriteNumber(writer, boxes[i].w);
+        cJSON_BinaryWriteString(writer, "h");
+        cJSON_BinaryWriteNumber(writer, boxes[i].h);
+        cJSON_BinaryWriteString(writer, "label");
+        cJSON_BinaryWriteString(writer, "person");
+        cJSON_BinaryWriteString(writer, "score");
+        cJSON_BinaryWriteNumber(writer, boxes[i].score);
+    }
+}
+
+static double microseconds_since(clock_t start, unsigned long iterations)
+{
+    return ((double)(clock() - start) * 1e6) / ((double)CLOCKS_PER_SEC * (double)iterations);
+}
+
+static void fail(const char *message)
+{
+    fprintf(stderr, "%s\n", message);
+    exit(EXIT_FAILURE);
+}
+
+static void benchmark(const char *name, const cJSON *message, unsigned long iterations)
+{
+    static const char * const format_names[] = { "cbor", "msgpack" };
+    char *json = cJSON_PrintUnformatted(message);
+    size_t json_length = strlen(json);
+    unsigned long iteration = 0;
+    clock_t start = 0;
+    double print_time = 0;
+    double parse_time = 0;
+    int format = 0;
+
+    start = clock();
+    for (iteration = 0; iteration < iterations; iteration++)
+    {
+        cJSON_free(cJSON_PrintUnformatted(message));
+    }
+    print_time = microseconds_since(start, iterations);
+
+    start = clock();
+    for (iteration = 0; iteration < iterations; iteration++)
+    {
+        cJSON_Delete(cJSON_ParseWithLength(json, json_length));
+    }
+    parse_time = microseconds_since(start, iterations);
+
+    printf("%-18s json    %6lu bytes, print  %8.2f us, parse  %8.2f us\n", name, (unsigned long)json_length, print_time, parse_time);
+
+    for (format = cJSON_CBOR; format <= cJSON_MessagePack; format++)
+    {
+        size_t length = 0;
+        unsigned char *encoded = cJSON_EncodeBinary(message, format, &length);
+        cJSON *decoded = cJSON_DecodeBinary(encoded, length, format);
+        double encode_time = 0;
+        double decode_time = 0;
+
+        if (!cJSON_Compare(message, decoded, 1))
+        {
+            fail("The decoded message differs.");
+        }
+        cJSON_Delete(decoded);
+
+        start = clock();
+        for (iteration = 0; iteration < iterations; iteration++)
+        {
+            size_t unused = 0;
+            cJSON_free(cJSON_EncodeBinary(message, format, &unused));
+        }
+        encode_time = microseconds_since(start, iterations);
+
+        start = clock();
+        for (iteration = 0; iteration < iterations; iteration++)
+        {
+            cJSON_Delete(cJSON_DecodeBinary(encoded, length, format));
+        }
+        decode_time = microseconds_since(start, iterations);
+
+        printf("%-18s %-7s %6lu bytes, encode %8.2f us, decode %8.2f us\n", "", format_names[format], (unsigned long)length, encode_time, decode_time);
+        cJSON_free(encoded);
+    }
+
+    cJSON_free(json);
+}
+
+/* what the camera does for every frame: results to bytes on the wire */
+static void benchmark_streaming(const box *boxes, int count, unsigned long iterations)
+{
+    unsigned char chunk[1024];
+    unsigned char *expected = NULL;
+    size_t expected_length = 0;
+    cJSON_BinaryWriter writer;
+    cJSON *tree = create_detections(boxes, count);
+    unsigned long iteration = 0;
+    clock_t start = 0;
+    double tree_json_time = 0;
+    double tree_cbor_time = 0;
+    double writer_time = 0;
+
+    expected = cJSON_EncodeBinary(tree, cJSON_CBOR, &expected_length);
+    cJSON_InitBinaryWriter(&writer, cJSON_CBOR, chunk, sizeof(chunk), NULL, NULL);
+    write_detections(&writer, boxes, count);
+    if ((cJSON_FinishBinaryWriter(&writer) != expected_length) || (memcmp(chunk, expected, expected_length) != 0))
+    {
+        fail("The writer output differs.");
+    }
+    cJSON_free(expected);
+    cJSON_Delete(tree);
+
+    start = clock();
+    for (iteration = 0; iteration < iterations; iteration++)
+    {
+        tree = create_detections(boxes, count);
+        cJSON_free(cJSON_PrintUnformatted(tree));
+        cJSON_Delete(tree);
+    }
+    tree_json_time = microseconds_since(start, iterations);
+
+    start = clock();
+    for (iteration = 0; iteration < iterations; iteration++)
+    {
+        tree = create_detections(boxes, count);
+        cJSON_free(cJSON_EncodeBinary(tree, cJSON_CBOR, &expected_length));
+        cJSON_Delete(tree);
+    }
+    tree_cbor_time = microseconds_since(start, iterations);
+
+    start = clock();
+    for (iteration = 0; iteration < iterations; iteration++)
+    {
+        cJSON_InitBinaryWriter(&writer, cJSON_CBOR, chunk, sizeof(chunk), NULL, NULL);
+        write_detections(&writer, boxes, count);
+        if (cJSON_FinishBinaryWriter(&writer) == 0)
+        {
+            fail("The writer failed.");
+        }
+    }
+    writer_time = microseconds_since(start, iterations);
+
+    printf("%d boxes to bytes: tree + json %8.2f us, tree + cbor %8.2f us, cbor writer %8.2f us\n", count, tree_json_time, tree_cbor_time, writer_time);
+}
+
+int CJSON_CDECL main(int argc, char **argv)
+{
+    static const int box_counts[] = { 0, 1, 10, 50, 200 };
+    box boxes[200];
+    cJSON *command = NULL;
+    unsigned long iterations = 200000;
+    char name[32];
+    size_t i = 0;
+
+    if (argc > 1)
+    {
+        iterations = strtoul(argv[1], NULL, 10);
+    }
+
+    command = cJSON_Parse("{\"brightness\":1,\"contrast\":-1,\"saturation\":0,\"quality\":12}");
+    benchmark("camera command", command, iterations);
+    cJSON_Delete(command);
+
+    create_boxes(1, boxes, 200);
+    for (i = 0; i < (sizeof(box_counts) / sizeof(box_counts[0])); i++)
+    {
+        cJSON *detections = create_detections(boxes, box_counts[i]);
+        sprintf(name, "%d boxes", box_counts[i]);
+        benchmark(name, detections, iterations / (unsigned long)(box_counts[i] + 1));
+        cJSON_Delete(detections);
+    }
+
+    benchmark_streaming(boxes, 10, iterations / 10);
+
+    return EXIT_SUCCESS;
+}
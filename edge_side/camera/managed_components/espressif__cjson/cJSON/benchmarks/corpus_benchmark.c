@@ -0,0 +1,468 @@
+/*
+  Copyright (c) 2009-2017 Dave Gamble and cJSON contributors
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+/* Measures parse, print, lookup, create and delete over corpora shaped like the project's traffic:
+ * camera commands, detection results with 0 to 200 boxes, a history of results and a large formatted config.
+ * Reports ops/s and bytes/s with the default allocator, and allocations per op and peak memory from a separate
+ * run with counting hooks (with custom hooks cJSON doesn't use realloc, so printing allocates a bit differently).
+ * usage: corpus_benchmark [seconds per measurement] [corpus name filter] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../cJSON.h"
+
+/* every allocation is prefixed with its size so that the peak can be tracked */
+typedef union
+{
+    size_t size;
+    double alignment;
+} allocation_header;
+
+static size_t allocation_count = 0;
+static size_t allocated_bytes = 0;
+static size_t peak_bytes = 0;
+
+static void * CJSON_CDECL counting_malloc(size_t size)
+{
+    allocation_header *header = (allocation_header*)malloc(sizeof(allocation_header) + size);
+    if (header == NULL)
+    {
+        return NULL;
+    }
+
+    header->size = size;
+    allocation_count++;
+    allocated_bytes += size;
+    if (allocated_bytes > peak_bytes)
+    {
+        peak_bytes = allocated_bytes;
+    }
+
+    return header + 1;
+}
+
+static void CJSON_CDECL counting_free(void *pointer)
+{
+    allocation_header *header = NULL;
+
+    if (pointer == NULL)
+    {
+        return;
+    }
+
+    header = ((allocation_header*)pointer) - 1;
+    allocated_bytes -= header->size;
+    free(header);
+}
+
+static unsigned long next_random(unsigned long *seed)
+{
+    *seed = (*seed * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+    return *seed;
+}
+
+/* the settings the server sends to the camera */
+static cJSON *create_command(void)
+{
+    return cJSON_Parse("{\"brightness\":1,\"contrast\":1,\"saturation\":1,\"quality\":8}");
+}
+
+/* a result as the server produces it, coordinates are float32 model outputs converted to double */
+static cJSON *create_detections(unsigned long *seed, int count)
+{
+    cJSON *result = cJSON_CreateObject();
+    cJSON *detections = NULL;
+    char timestamp[32];
+    int i = 0;
+
+    cJSON_AddNumberToObject(result, "people_count", count);
+    detections = cJSON_AddArrayToObject(result, "detections");
+    for (i = 0; i < count; i++)
+    {
+        cJSON *detection = cJSON_CreateObject();
+        double bbox[4];
+        float x = (float)(next_random(seed) % 60000UL) / 97.0f;
+        float y = (float)(next_random(seed) % 44000UL) / 97.0f;
+
+        bbox[0] = (double)x;
+        bbox[1] = (double)y;
+        bbox[2] = (double)(x + ((float)(next_random(seed) % 12000UL) / 89.0f));
+        bbox[3] = (double)(y + ((float)(next_random(seed) % 20000UL) / 89.0f));
+        cJSON_AddNumberToObject(detection, "class_id", 0);
+        cJSON_AddStringToObject(detection, "class_name", "person");
+        cJSON_AddNumberToObject(detection, "confidence", (double)((float)(250 + (next_random(seed) % 750UL)) / 1000.0f));
+        cJSON_AddItemToObject(detection, "bbox", cJSON_CreateDoubleArray(bbox, 4));
+        cJSON_AddItemToArray(detections, detection);
+    }
+    sprintf(timestamp, "2026-10-17T12:%02lu:%02lu.%06lu", next_random(seed) % 60UL, next_random(seed) % 60UL, next_random(seed) % 1000000UL);
+    cJSON_AddStringToObject(result, "timestamp", timestamp);
+    cJSON_AddStringToObject(result, "camera_id", "esp32_cam");
+
+    return result;
+}
+
+static cJSON *create_history(int results)
+{
+    cJSON *history = cJSON_CreateArray();
+    unsigned long seed = 7;
+    int i = 0;
+
+    for (i = 0; i < results; i++)
+    {
+        cJSON_AddItemToArray(history, create_detections(&seed, (int)(next_random(&seed) % 8UL)));
+    }
+
+    return history;
+}
+
+static cJSON *create_config(int cameras)
+{
+    static const char * const labels[] = { "person", "bicycle", "car", "motorcycle", "bus", "truck", "dog", "cat", "backpack", "umbrella" };
+    cJSON *config = cJSON_CreateObject();
+    cJSON *list = NULL;
+    cJSON *section = NULL;
+    unsigned long seed = 3;
+    char text[64];
+    int i = 0;
+    int j = 0;
+
+    cJSON_AddNumberToObject(config, "version", 3);
+    section = cJSON_AddObjectToObject(config, "server");
+    cJSON_AddStringToObject(section, "host", "0.0.0.0");
+    cJSON_AddNumberToObject(section, "ws_port", 8080);
+    cJSON_AddStringToObject(section, "backend_url", "http://localhost:8000/api/v1/edge/count");
+    cJSON_AddNumberToObject(section, "queue_size", 3);
+    section = cJSON_AddObjectToObject(config, "model");
+    cJSON_AddStringToObject(section, "weights", "weights/yolov11n_ncnn_model");
+    cJSON_AddNumberToObject(section, "input_size", 640);
+    cJSON_AddNumberToObject(section, "confidence", 0.25);
+    cJSON_AddNumberToObject(section, "iou", 0.45);
+    list = cJSON_AddArrayToObject(section, "labels");
+    for (i = 0; i < 80; i++)
+    {
+        sprintf(text, "%s_%d", labels[i % 10], i / 10);
+        cJSON_AddItemToArray(list, cJSON_CreateString(text));
+    }
+
+    list = cJSON_AddArrayToObject(config, "cameras");
+    for (i = 0; i < cameras; i++)
+    {
+        cJSON *camera = cJSON_CreateObject();
+        cJSON *zones = NULL;
+
+        sprintf(text, "cam-%03d", i);
+        cJSON_AddStringToObject(camera, "id", text);
+        sprintf(text, "Entrance %d, floor %d", i % 8, i / 8);
+        cJSON_AddStringToObject(camera, "name", text);
+        sprintf(text, "rtsp://10.0.%d.%d:554/stream1", i / 200, (i % 200) + 20);
+        cJSON_AddStringToObject(camera, "url", text);
+        cJSON_AddBoolToObject(camera, "enabled", (i % 5) != 0);
+        section = cJSON_AddObjectToObject(camera, "settings");
+        cJSON_AddNumberToObject(section, "brightness", (double)(i % 5) - 2.0);
+        cJSON_AddNumberToObject(section, "contrast", (double)(i % 3) - 1.0);
+        cJSON_AddNumberToObject(section, "saturation", 0);
+        cJSON_AddNumberToObject(section, "quality", 8 + (i % 10));
+        cJSON_AddStringToObject(section, "framesize", "VGA");
+        zones = cJSON_AddArrayToObject(camera, "zones");
+        for (j = 0; j < 3; j++)
+        {
+            cJSON *zone = cJSON_CreateObject();
+            cJSON *polygon = cJSON_AddArrayToObject(zone, "polygon");
+            int point = 0;
+
+            sprintf(text, "zone-%d", j);
+            cJSON_AddStringToObject(zone, "name", text);
+            for (point = 0; point < 6; point++)
+            {
+                int coordinates[2];
+                coordinates[0] = (int)(next_random(&seed) % 640UL);
+                coordinates[1] = (int)(next_random(&seed) % 480UL);
+                cJSON_AddItemToArray(polygon, cJSON_CreateIntArray(coordinates, 2));
+            }
+            cJSON_AddNumberToObject(zone, "max_people", 5 + (int)(next_random(&seed) % 20UL));
+            cJSON_AddItemToArray(zones, zone);
+        }
+        cJSON_AddItemToArray(list, camera);
+    }
+
+    return config;
+}
+
+typedef struct
+{
+    char name[24];
+    cJSON *tree;
+    char *json;
+    size_t length;
+    cJSON_bool formatted;
+} corpus;
+
+static void load_corpus(corpus *entry, const char *name, cJSON *tree, cJSON_bool formatted)
+{
+    strcpy(entry->name, name);
+    entry->tree = tree;
+    entry->formatted = formatted;
+    entry->json = formatted ? cJSON_Print(tree) : cJSON_PrintUnformatted(tree);
+    if (entry->json == NULL)
+    {
+        fprintf(stderr, "Failed to create the %s corpus.\n", name);
+        exit(EXIT_FAILURE);
+    }
+    entry->length = strlen(entry->json);
+}
+
+/* the same tree again through the create API, the way application code builds messages */
+static cJSON *rebuild(const cJSON *item)
+{
+    const cJSON *child = NULL;
+    cJSON *copy = NULL;
+
+    switch (item->type & 0xFF)
+    {
+        case cJSON_False:
+            return cJSON_CreateFalse();
+        case cJSON_True:
+            return cJSON_CreateTrue();
+        case cJSON_Number:
+            return cJSON_CreateNumber(item->valuedouble);
+        case cJSON_String:
+            return cJSON_CreateString(item->valuestring);
+        case cJSON_Array:
+        case cJSON_Object:
+            copy = cJSON_IsArray(item) ? cJSON_CreateArray() : cJSON_CreateObject();
+            for (child = item->child; child != NULL; child = child->next)
+            {
+                if (cJSON_IsArray(item))
+                {
+                    cJSON_AddItemToArray(copy, rebuild(child));
+                }
+                else
+                {
+                    cJSON_AddItemToObject(copy, child->string, rebuild(child));
+                }
+            }
+            return copy;
+        default:
+            return cJSON_CreateNull();
+    }
+}
+
+/* looks up every member of every object by its key */
+static size_t lookup_members(const cJSON *item)
+{
+    const cJSON *child = NULL;
+    size_t found = 0;
+
+    for (child = item->child; child != NULL; child = child->next)
+    {
+        if (cJSON_IsObject(item) && (cJSON_GetObjectItemCaseSensitive(item, child->string) != NULL))
+        {
+            found++;
+        }
+        found += lookup_members(child);
+    }
+
+    return found;
+}
+
+#define operation_parse 0
+#define operation_print 1
+#define operation_lookup 2
+#define operation_create 3
+#define operation_delete 4
+#define operation_count 5
+
+static const char * const operation_names[operation_count] = { "parse", "print", "lookup", "create", "delete" };
+
+/* trees that are parsed or created in one batch and deleted in the next step */
+#define max_batch 4096
+static cJSON *batch[max_batch];
+static size_t checksum = 0;
+
+/* runs operation count times, returns the seconds it took */
+static double run(const corpus *entry, int operation, size_t count)
+{
+    clock_t start = 0;
+    double seconds = 0;
+    size_t i = 0;
+
+    switch (operation)
+    {
+        case operation_parse:
+        case operation_create:
+            start = clock();
+            for (i = 0; i < count; i++)
+            {
+                batch[i] = (operation == operation_parse) ? cJSON_ParseWithLength(entry->json, entry->length) : rebuild(entry->tree);
+            }
+            seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+            for (i = 0; i < count; i++)
+            {
+                checksum += (batch[i] != NULL) ? 1 : 0;
+                cJSON_Delete(batch[i]);
+            }
+            return seconds;
+
+        case operation_delete:
+            for (i = 0; i < count; i++)
+            {
+                batch[i] = cJSON_ParseWithLength(entry->json, entry->length);
+            }
+            start = clock();
+            for (i = 0; i < count; i++)
+            {
+                cJSON_Delete(batch[i]);
+            }
+            return (double)(clock() - start) / CLOCKS_PER_SEC;
+
+        case operation_print:
+            start = clock();
+            for (i = 0; i < count; i++)
+            {
+                char *printed = entry->formatted ? cJSON_Print(entry->tree) : cJSON_PrintUnformatted(entry->tree);
+                checksum += (size_t)printed[0];
+                cJSON_free(printed);
+            }
+            return (double)(clock() - start) / CLOCKS_PER_SEC;
+
+        default:
+            start = clock();
+            for (i = 0; i < count; i++)
+            {
+                checksum += lookup_members(entry->tree);
+            }
+            return (double)(clock() - start) / CLOCKS_PER_SEC;
+    }
+}
+
+static void measure(const corpus *entry, int operation, double minimum_seconds)
+{
+    /* about a megabyte of input per batch, so that clock() resolution doesn't matter */
+    size_t count = (1024 * 1024) / entry->length;
+    size_t operations = 0;
+    size_t baseline = 0;
+    double seconds = 0;
+    char *printed = NULL;
+    cJSON *tree = NULL;
+    cJSON_Hooks hooks = { counting_malloc, counting_free };
+
+    if (count < 1)
+    {
+        count = 1;
+    }
+    if (count > max_batch)
+    {
+        count = max_batch;
+    }
+
+    while (seconds < minimum_seconds)
+    {
+        seconds += run(entry, operation, count);
+        operations += count;
+    }
+
+    /* one more op with counting hooks, the corpus tree was allocated with the default ones so use a copy */
+    cJSON_InitHooks(&hooks);
+    tree = cJSON_ParseWithLength(entry->json, entry->length);
+    baseline = allocated_bytes;
+    peak_bytes = baseline;
+    allocation_count = 0;
+    switch (operation)
+    {
+        case operation_parse:
+            cJSON_Delete(cJSON_ParseWithLength(entry->json, entry->length));
+            break;
+        case operation_create:
+            cJSON_Delete(rebuild(tree));
+            break;
+        case operation_print:
+            printed = entry->formatted ? cJSON_Print(tree) : cJSON_PrintUnformatted(tree);
+            cJSON_free(printed);
+            break;
+        case operation_lookup:
+            checksum += lookup_members(tree);
+            break;
+        default:
+            break;
+    }
+    cJSON_Delete(tree);
+    cJSON_InitHooks(NULL);
+
+    printf("%-16s %8lu  %-7s %12.0f %10.2f %10lu %11lu\n", entry->name, (unsigned long)entry->length, operation_names[operation],
+            (double)operations / seconds, ((double)operations * (double)entry->length / (1024.0 * 1024.0)) / seconds,
+            (unsigned long)allocation_count, (unsigned long)(peak_bytes - baseline));
+}
+
+int CJSON_CDECL main(int argc, char **argv)
+{
+    static const int box_counts[] = { 0, 1, 10, 50, 200 };
+    corpus corpora[8];
+    size_t corpus_count = 0;
+    double minimum_seconds = 0.2;
+    const char *filter = "";
+    unsigned long seed = 1;
+    char name[24];
+    size_t i = 0;
+    int operation = 0;
+
+    if (argc > 1)
+    {
+        minimum_seconds = strtod(argv[1], NULL);
+    }
+    if (argc > 2)
+    {
+        filter = argv[2];
+    }
+    if (minimum_seconds <= 0)
+    {
+        fprintf(stderr, "usage: %s [seconds per measurement] [corpus name filter]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    load_corpus(&corpora[corpus_count++], "command", create_command(), 0);
+    for (i = 0; i < (sizeof(box_counts) / sizeof(box_counts[0])); i++)
+    {
+        sprintf(name, "detections-%d", box_counts[i]);
+        load_corpus(&corpora[corpus_count++], name, create_detections(&seed, box_counts[i]), 0);
+    }
+    load_corpus(&corpora[corpus_count++], "history", create_history(2000), 0);
+    load_corpus(&corpora[corpus_count++], "config", create_config(256), 1);
+
+    printf("%-16s %8s  %-7s %12s %10s %10s %11s\n", "corpus", "bytes", "op", "ops/s", "MB/s", "allocs/op", "peak bytes");
+    for (i = 0; i < corpus_count; i++)
+    {
+        if (strstr(corpora[i].name, filter) != NULL)
+        {
+            for (operation = 0; operation < operation_count; operation++)
+            {
+                measure(&corpora[i], operation, minimum_seconds);
+            }
+        }
+        cJSON_Delete(corpora[i].tree);
+        cJSON_free(corpora[i].json);
+    }
+
+    return (checksum > 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
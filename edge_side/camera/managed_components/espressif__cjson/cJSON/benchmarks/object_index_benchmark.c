@@ -0,0 +1,117 @@
+/*
+  Copyright (c) 2009-2017 Dave Gamble and cJSON contributors
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+/* Compares cJSON_GetObjectItemCaseSensitive on a plain object against the same object with cJSON_EnableObjectIndex,
+ * looking up every member of objects with 10 to 10000 members.
+ * usage: object_index_benchmark [lookups] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../cJSON.h"
+
+static double lookup_seconds(const cJSON *object, char (*keys)[24], size_t member_count, unsigned long lookups)
+{
+    unsigned long lookup = 0;
+    size_t found = 0;
+    clock_t start = clock();
+
+    for (lookup = 0; lookup < lookups; lookup++)
+    {
+        /* step through the members in a different order than they were added */
+        if (cJSON_GetObjectItemCaseSensitive(object, keys[(lookup * 7919) % member_count]) != NULL)
+        {
+            found++;
+        }
+    }
+
+    if (found != lookups)
+    {
+        fprintf(stderr, "Found %lu of %lu members.\n", (unsigned long)found, lookups);
+        exit(EXIT_FAILURE);
+    }
+
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static void benchmark(size_t member_count, unsigned long lookups)
+{
+    char (*keys)[24] = (char (*)[24])malloc(member_count * sizeof(*keys));
+    cJSON *object = cJSON_CreateObject();
+    double plain_seconds = 0;
+    double indexed_seconds = 0;
+    size_t i = 0;
+
+    if (lookups == 0)
+    {
+        lookups = 1;
+    }
+    if ((keys == NULL) || (object == NULL))
+    {
+        fprintf(stderr, "Failed to create the object.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < member_count; i++)
+    {
+        sprintf(keys[i], "member_%lu", (unsigned long)i);
+        if (cJSON_AddNumberToObject(object, keys[i], (double)i) == NULL)
+        {
+            fprintf(stderr, "Failed to add member %lu.\n", (unsigned long)i);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    plain_seconds = lookup_seconds(object, keys, member_count, lookups);
+    if (!cJSON_EnableObjectIndex(object))
+    {
+        fprintf(stderr, "Failed to enable the index.\n");
+        exit(EXIT_FAILURE);
+    }
+    /* the first lookup builds the index, which is part of the measurement */
+    indexed_seconds = lookup_seconds(object, keys, member_count, lookups);
+
+    printf("%6lu members   linear %9.1f ns/lookup, indexed %6.1f ns/lookup\n", (unsigned long)member_count,
+            plain_seconds * 1e9 / (double)lookups, indexed_seconds * 1e9 / (double)lookups);
+
+    cJSON_Delete(object);
+    free(keys);
+}
+
+int CJSON_CDECL main(int argc, char **argv)
+{
+    unsigned long lookups = 1000000;
+    size_t member_count = 0;
+
+    if (argc > 1)
+    {
+        lookups = strtoul(argv[1], NULL, 10);
+    }
+    for (member_count = 10; member_count <= 10000; member_count *= 10)
+    {
+        /* the linear scan gets slow, keep the big objects to a comparable run time */
+        benchmark(member_count, (member_count > 100) ? lookups / (member_count / 100) : lookups);
+    }
+
+    return EXIT_SUCCESS;
+}
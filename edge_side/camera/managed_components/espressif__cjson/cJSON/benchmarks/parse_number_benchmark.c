@@ -0,0 +1,204 @@
+/*
+  Copyright (c) 2009-2017 Dave Gamble and cJSON contributors
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+/* Parses numeric-heavy JSON (detection results with float coordinates and scores, integer heavy frame
+ * indices and a plain array of doubles) and compares the number conversion with the previous
+ * copy + strtod approach.
+ * usage: parse_number_benchmark [iterations] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../cJSON.h"
+
+static size_t append_detections(char *json, unsigned long seed, int boxes)
+{
+    size_t length = (size_t)sprintf(json, "{\"camera\":\"cam-1\",\"frame\":%lu,\"timestamp\":%.3f,\"people_count\":%d,\"boxes\":[",
+            seed, 1700000000.0 + ((double)seed / 15.0), boxes);
+    int i = 0;
+
+    for (i = 0; i < boxes; i++)
+    {
+        seed = (seed * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+        length += (size_t)sprintf(json + length, "%s{\"x\":%.2f,\"y\":%.2f,\"w\":%.4g,\"h\":%.4g,\"label\":\"person\",\"score\":%.3f}",
+                (i == 0) ? "" : ",", (double)(seed % 64000UL) / 100.0 + 0.3, (double)(seed % 48000UL) / 100.0,
+                (double)(seed % 12000UL) / 97.0, (double)(seed % 20000UL) / 101.0, (double)(seed % 1000UL) / 1000.0);
+    }
+    length += (size_t)sprintf(json + length, "]}");
+
+    return length;
+}
+
+/* the number conversion cJSON used before, without the locale handling */
+static double previous_parse_number(const char *json, const char **end)
+{
+    size_t length = 0;
+    char *copy = NULL;
+    char *copy_end = NULL;
+    double number = 0;
+
+    while (strchr("0123456789+-eE.", json[length]) != NULL)
+    {
+        length++;
+    }
+    copy = (char*)malloc(length + 1);
+    if (copy == NULL)
+    {
+        exit(EXIT_FAILURE);
+    }
+    memcpy(copy, json, length);
+    copy[length] = '\0';
+    number = strtod(copy, &copy_end);
+    *end = json + (copy_end - copy);
+    free(copy);
+
+    return number;
+}
+
+/* skip to the numbers in the document and convert them */
+static double sum_numbers(const char *json)
+{
+    double sum = 0;
+
+    while (*json != '\0')
+    {
+        if ((*json == '-') || ((*json >= '0') && (*json <= '9')))
+        {
+            sum += previous_parse_number(json, &json);
+        }
+        else if (*json == '"')
+        {
+            json = strchr(json + 1, '"') + 1;
+        }
+        else
+        {
+            json++;
+        }
+    }
+
+    return sum;
+}
+
+/* add up in document order, exactly like sum_numbers */
+static void sum_tree(const cJSON *item, double *sum)
+{
+    for (; item != NULL; item = item->next)
+    {
+        if (cJSON_IsNumber(item))
+        {
+            *sum += item->valuedouble;
+        }
+        sum_tree(item->child, sum);
+    }
+}
+
+static void benchmark(const char *name, const char *json, size_t length, unsigned long iterations)
+{
+    double tree_sum = 0;
+    double previous_sum = 0;
+    double seconds = 0;
+    unsigned long iteration = 0;
+    clock_t start = clock();
+
+    for (iteration = 0; iteration < iterations; iteration++)
+    {
+        cJSON *parsed = cJSON_ParseWithLength(json, length);
+        if (parsed == NULL)
+        {
+            fprintf(stderr, "Failed to parse %s.\n", name);
+            exit(EXIT_FAILURE);
+        }
+        tree_sum = 0;
+        sum_tree(parsed, &tree_sum);
+        cJSON_Delete(parsed);
+    }
+    seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    printf("%-28s cJSON_Parse %8.2f MB/s", name, ((double)length * (double)iterations / (1024.0 * 1024.0)) / seconds);
+
+    start = clock();
+    for (iteration = 0; iteration < iterations; iteration++)
+    {
+        previous_sum = sum_numbers(json);
+    }
+    seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    printf(", numbers only with copy + strtod %8.2f MB/s\n", ((double)length * (double)iterations / (1024.0 * 1024.0)) / seconds);
+
+    if (tree_sum != previous_sum)
+    {
+        fprintf(stderr, "Results differ for %s.\n", name);
+        exit(EXIT_FAILURE);
+    }
+}
+
+int CJSON_CDECL main(int argc, char **argv)
+{
+    static const int box_counts[] = { 0, 1, 10, 50, 200 };
+    unsigned long iterations = 2000;
+    char *detections = NULL;
+    char *doubles = NULL;
+    size_t detections_length = 0;
+    size_t doubles_length = 0;
+    unsigned long seed = 1;
+    size_t i = 0;
+
+    if (argc > 1)
+    {
+        iterations = strtoul(argv[1], NULL, 10);
+    }
+
+    detections = (char*)malloc(256 * 1024);
+    doubles = (char*)malloc(256 * 1024);
+    if ((detections == NULL) || (doubles == NULL))
+    {
+        free(detections);
+        return EXIT_FAILURE;
+    }
+
+    detections[detections_length++] = '[';
+    for (i = 0; i < (sizeof(box_counts) / sizeof(box_counts[0])); i++)
+    {
+        detections_length += append_detections(detections + detections_length, (unsigned long)i, box_counts[i]);
+        detections[detections_length++] = ',';
+    }
+    detections[detections_length - 1] = ']';
+    detections[detections_length] = '\0';
+
+    /* arbitrary doubles with up to 17 digits, as printed by other JSON libraries */
+    doubles[doubles_length++] = '[';
+    for (i = 0; i < 5000; i++)
+    {
+        seed = (seed * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+        doubles_length += (size_t)sprintf(doubles + doubles_length, "%.17g,", (double)seed / 2147483648.0 * 1000.0);
+    }
+    doubles[doubles_length - 1] = ']';
+    doubles[doubles_length] = '\0';
+
+    benchmark("detections, 0-200 boxes", detections, detections_length, iterations);
+    benchmark("17 digit doubles", doubles, doubles_length, iterations / 20 + 1);
+
+    free(doubles);
+    free(detections);
+
+    return EXIT_SUCCESS;
+}
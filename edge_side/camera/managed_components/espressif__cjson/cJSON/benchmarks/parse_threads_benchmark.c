@@ -0,0 +1,246 @@
+/*
+  Copyright (c) 2009-2017 Dave Gamble and cJSON contributors
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+/* Parses detection results on 1, 2, 4, ... threads at the same time with cJSON_ParseCtx and reports
+ * the throughput and the speedup over one thread, once with malloc and once with an arena per thread.
+ * Every thread also checks that it gets the error positions of its own invalid documents.
+ * usage: parse_threads_benchmark [maximum threads] [seconds per measurement] */
+
+/* for clock_gettime */
+#define _POSIX_C_SOURCE 200112L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../cJSON.h"
+
+#define DOCUMENT_COUNT 64
+#define ARENA_SIZE (256 * 1024)
+
+typedef struct
+{
+    char *documents[DOCUMENT_COUNT];
+    size_t lengths[DOCUMENT_COUNT];
+    size_t total_length;
+    double seconds;
+    cJSON_bool use_arena;
+} corpus;
+
+typedef struct
+{
+    pthread_t thread;
+    const corpus *input;
+    /* where the invalid document of this thread breaks, different for every thread */
+    char invalid[64];
+    size_t error_offset;
+    unsigned long parsed_bytes;
+    cJSON_bool failed;
+} worker;
+
+static double now(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + ((double)time.tv_nsec / 1e9);
+}
+
+/* results in the shape the ws server sends, with 0 to 63 boxes */
+static char *create_detections(unsigned long frame, size_t boxes, size_t *length)
+{
+    static const char * const labels[] = { "person", "person", "bicycle", "car" };
+    char *json = (char*)malloc(256 + (boxes * 128));
+    size_t used = 0;
+    size_t i = 0;
+
+    if (json == NULL)
+    {
+        return NULL;
+    }
+
+    used += (size_t)sprintf(json + used, "{\"camera\":\"cam-%lu\",\"frame\":%lu,\"timestamp\":%.3f,\"people_count\":%lu,\"boxes\":[",
+            frame % 4, frame, 1700000000.0 + ((double)frame / 15.0), (unsigned long)boxes);
+    for (i = 0; i < boxes; i++)
+    {
+        used += (size_t)sprintf(json + used, "%s{\"x\":%.1f,\"y\":%.1f,\"w\":%lu,\"h\":%lu,\"label\":\"%s\",\"score\":%.4f}",
+                (i == 0) ? "" : ",", (double)((frame * 7 + i * 13) % 6400) / 10.0, (double)((frame * 3 + i * 29) % 4800) / 10.0,
+                40 + (i * 11) % 120, 80 + (i * 17) % 200, labels[(frame + i) % 4], 0.5 + ((double)((frame + i) % 500) / 1000.0));
+    }
+    used += (size_t)sprintf(json + used, "]}");
+
+    *length = used;
+    return json;
+}
+
+static void *run_worker(void *argument)
+{
+    worker *self = (worker*)argument;
+    const corpus *input = self->input;
+    double memory[ARENA_SIZE / sizeof(double)];
+    cJSON_Arena arena;
+    cJSON_Context context;
+    double end = now() + input->seconds;
+    size_t i = 0;
+
+    cJSON_InitContext(&context, NULL);
+    if (input->use_arena)
+    {
+        cJSON_InitArena(&arena, memory, sizeof(memory));
+        context.arena = &arena;
+    }
+
+    do
+    {
+        for (i = 0; i < DOCUMENT_COUNT; i++)
+        {
+            cJSON *item = cJSON_ParseCtx(&context, input->documents[i], input->lengths[i], NULL, 0);
+            if ((item == NULL) || (context.error != NULL))
+            {
+                self->failed = 1;
+                return NULL;
+            }
+            cJSON_DeleteCtx(&context, item);
+            if (input->use_arena)
+            {
+                cJSON_ResetArena(&arena);
+            }
+        }
+        self->parsed_bytes += (unsigned long)input->total_length;
+
+        /* another thread failing at the same time must not move this error */
+        if ((cJSON_ParseCtx(&context, self->invalid, strlen(self->invalid), NULL, 0) != NULL)
+                || (context.error != (self->invalid + self->error_offset)))
+        {
+            self->failed = 1;
+            return NULL;
+        }
+    } while (now() < end);
+
+    return NULL;
+}
+
+static double measure(const corpus *input, worker *workers, size_t thread_count)
+{
+    double start = now();
+    unsigned long parsed_bytes = 0;
+    size_t i = 0;
+
+    for (i = 0; i < thread_count; i++)
+    {
+        workers[i].input = input;
+        workers[i].parsed_bytes = 0;
+        workers[i].failed = 0;
+        /* the invalid member is preceded by a growing number of valid ones */
+        strcpy(workers[i].invalid, "[");
+        while (strlen(workers[i].invalid) < (1 + (2 * (i % 16))))
+        {
+            strcat(workers[i].invalid, "1,");
+        }
+        workers[i].error_offset = strlen(workers[i].invalid);
+        strcat(workers[i].invalid, "x]");
+        if (pthread_create(&workers[i].thread, NULL, run_worker, &workers[i]) != 0)
+        {
+            fprintf(stderr, "Failed to create a thread.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (i = 0; i < thread_count; i++)
+    {
+        pthread_join(workers[i].thread, NULL);
+        if (workers[i].failed)
+        {
+            fprintf(stderr, "Thread %lu got a wrong result.\n", (unsigned long)i);
+            exit(EXIT_FAILURE);
+        }
+        parsed_bytes += workers[i].parsed_bytes;
+    }
+
+    return ((double)parsed_bytes / (1024.0 * 1024.0)) / (now() - start);
+}
+
+int CJSON_CDECL main(int argc, char **argv)
+{
+    corpus input;
+    worker *workers = NULL;
+    size_t maximum_threads = 8;
+    size_t thread_count = 0;
+    size_t i = 0;
+    int mode = 0;
+
+    input.seconds = 1.0;
+    input.total_length = 0;
+    if (argc > 1)
+    {
+        maximum_threads = (size_t)strtoul(argv[1], NULL, 10);
+    }
+    if (argc > 2)
+    {
+        input.seconds = atof(argv[2]);
+    }
+    if ((maximum_threads == 0) || (input.seconds <= 0))
+    {
+        fprintf(stderr, "usage: %s [maximum threads] [seconds per measurement]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    workers = (worker*)malloc(maximum_threads * sizeof(worker));
+    if (workers == NULL)
+    {
+        return EXIT_FAILURE;
+    }
+    for (i = 0; i < DOCUMENT_COUNT; i++)
+    {
+        input.documents[i] = create_detections((unsigned long)i, i, &input.lengths[i]);
+        if (input.documents[i] == NULL)
+        {
+            return EXIT_FAILURE;
+        }
+        input.total_length += input.lengths[i];
+    }
+
+    for (mode = 0; mode < 2; mode++)
+    {
+        double single = 0;
+
+        input.use_arena = (mode == 1);
+        printf("%s:\n", input.use_arena ? "arena per thread" : "malloc");
+        for (thread_count = 1; thread_count <= maximum_threads; thread_count *= 2)
+        {
+            double throughput = measure(&input, workers, thread_count);
+            if (thread_count == 1)
+            {
+                single = throughput;
+            }
+            printf("  %2lu threads: %8.2f MB/s, %5.2fx\n", (unsigned long)thread_count, throughput, throughput / single);
+        }
+    }
+
+    for (i = 0; i < DOCUMENT_COUNT; i++)
+    {
+        free(input.documents[i]);
+    }
+    free(workers);
+
+    return EXIT_SUCCESS;
+}
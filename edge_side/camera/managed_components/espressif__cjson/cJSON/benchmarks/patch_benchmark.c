@@ -0,0 +1,229 @@
+/*
+  Copyright (c) 2009-2017 Dave Gamble and cJSON contributors
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+
+/* Applies and generates JSON Patches (RFC 6902) and Merge Patches (RFC 7396) for incremental config updates:
+ * a config with 256 cameras that gets a few settings of some cameras changed at a time.
+ * usage: patch_benchmark [iterations] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../cJSON.h"
+#include "../cJSON_Utils.h"
+
+static size_t allocation_count = 0;
+
+static void * CJSON_CDECL counting_malloc(size_t size)
+{
+    allocation_count++;
+    return malloc(size);
+}
+
+static void CJSON_CDECL counting_free(void *pointer)
+{
+    free(pointer);
+}
+
+static cJSON *create_config(int cameras)
+{
+    cJSON *config = cJSON_CreateObject();
+    cJSON *list = NULL;
+    cJSON *section = NULL;
+    char text[64];
+    int i = 0;
+
+    cJSON_AddNumberToObject(config, "version", 3);
+    section = cJSON_AddObjectToObject(config, "model");
+    cJSON_AddStringToObject(section, "weights", "weights/yolov11n_ncnn_model");
+    cJSON_AddNumberToObject(section, "confidence", 0.25);
+    cJSON_AddNumberToObject(section, "iou", 0.45);
+
+    list = cJSON_AddArrayToObject(config, "cameras");
+    for (i = 0; i < cameras; i++)
+    {
+        cJSON *camera = cJSON_CreateObject();
+
+        sprintf(text, "cam-%03d", i);
+        cJSON_AddStringToObject(camera, "id", text);
+        sprintf(text, "rtsp://10.0.%d.%d:554/stream1", i / 200, (i % 200) + 20);
+        cJSON_AddStringToObject(camera, "url", text);
+        cJSON_AddBoolToObject(camera, "enabled", (i % 5) != 0);
+        section = cJSON_AddObjectToObject(camera, "settings");
+        cJSON_AddNumberToObject(section, "brightness", (double)(i % 5) - 2.0);
+        cJSON_AddNumberToObject(section, "contrast", (double)(i % 3) - 1.0);
+        cJSON_AddNumberToObject(section, "saturation", 0);
+        cJSON_AddNumberToObject(section, "quality", 8 + (i % 10));
+        cJSON_AddStringToObject(section, "framesize", "VGA");
+        cJSON_AddItemToArray(list, camera);
+    }
+
+    return config;
+}
+
+/* changes three settings of every eighth camera and adds one, undo puts the original values back */
+static cJSON *create_settings_patches(const cJSON *config, cJSON_bool undo)
+{
+    cJSON *patches = cJSON_CreateArray();
+    const cJSON *camera = NULL;
+    char path[64];
+    int i = 0;
+
+    cJSON_ArrayForEach(camera, cJSON_GetObjectItemCaseSensitive(config, "cameras"))
+    {
+        const cJSON *settings = cJSON_GetObjectItemCaseSensitive(camera, "settings");
+        cJSON *value = NULL;
+
+        if ((i % 8) == 0)
+        {
+            sprintf(path, "/cameras/%d/settings/brightness", i);
+            value = undo ? cJSON_Duplicate(cJSON_GetObjectItemCaseSensitive(settings, "brightness"), 1) : cJSON_CreateNumber(1);
+            cJSONUtils_AddPatchToArray(patches, "replace", path, value);
+            cJSON_Delete(value);
+
+            sprintf(path, "/cameras/%d/settings/quality", i);
+            value = undo ? cJSON_Duplicate(cJSON_GetObjectItemCaseSensitive(settings, "quality"), 1) : cJSON_CreateNumber(12);
+            cJSONUtils_AddPatchToArray(patches, "replace", path, value);
+            cJSON_Delete(value);
+
+            sprintf(path, "/cameras/%d/settings/framesize", i);
+            value = cJSON_CreateString(undo ? "VGA" : "SVGA");
+            cJSONUtils_AddPatchToArray(patches, "replace", path, value);
+            cJSON_Delete(value);
+
+            sprintf(path, "/cameras/%d/settings/exposure", i);
+            value = cJSON_CreateNumber(300);
+            cJSONUtils_AddPatchToArray(patches, undo ? "remove" : "add", path, undo ? NULL : value);
+            cJSON_Delete(value);
+        }
+        i++;
+    }
+
+    return patches;
+}
+
+static void report(const char *name, unsigned long operations, double seconds, size_t allocations)
+{
+    printf("%-32s %10.0f ops/s, %8.1f allocs/op\n", name, (double)operations / seconds, (double)allocations / (double)operations);
+}
+
+int CJSON_CDECL main(int argc, char **argv)
+{
+    cJSON_Hooks hooks = { counting_malloc, counting_free };
+    unsigned long iterations = 2000;
+    unsigned long iteration = 0;
+    cJSON *config = NULL;
+    cJSON *unchanged = NULL;
+    cJSON *changed = NULL;
+    cJSON *patches = NULL;
+    cJSON *undo = NULL;
+    cJSON *merge_patch = NULL;
+    clock_t start = 0;
+    size_t allocations = 0;
+    int patch_count = 0;
+
+    if (argc > 1)
+    {
+        iterations = strtoul(argv[1], NULL, 10);
+    }
+    if (iterations == 0)
+    {
+        fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    cJSON_InitHooks(&hooks);
+    config = create_config(256);
+    patches = create_settings_patches(config, 0);
+    undo = create_settings_patches(config, 1);
+    patch_count = cJSON_GetArraySize(patches);
+    unchanged = cJSON_Duplicate(config, 1);
+    changed = cJSON_Duplicate(config, 1);
+    if ((config == NULL) || (unchanged == NULL) || (changed == NULL) || (cJSONUtils_ApplyPatchesCaseSensitive(changed, patches) != 0))
+    {
+        fprintf(stderr, "Failed to create the config.\n");
+        return EXIT_FAILURE;
+    }
+    printf("config with 256 cameras, %d patches per batch\n", patch_count);
+
+    /* the patches and then the undo patches, so every batch starts from the same config */
+    allocations = allocation_count;
+    start = clock();
+    for (iteration = 0; iteration < iterations; iteration++)
+    {
+        if ((cJSONUtils_ApplyPatchesCaseSensitive(config, patches) != 0) || (cJSONUtils_ApplyPatchesCaseSensitive(config, undo) != 0))
+        {
+            fprintf(stderr, "Failed to apply the patches.\n");
+            return EXIT_FAILURE;
+        }
+    }
+    report("ApplyPatches, per patch", 2 * iterations * (unsigned long)patch_count, (double)(clock() - start) / CLOCKS_PER_SEC, allocation_count - allocations);
+
+    allocations = allocation_count;
+    start = clock();
+    for (iteration = 0; iteration < iterations; iteration++)
+    {
+        cJSON_Delete(cJSONUtils_GeneratePatchesCaseSensitive(config, changed));
+    }
+    report("GeneratePatches", iterations, (double)(clock() - start) / CLOCKS_PER_SEC, allocation_count - allocations);
+
+    allocations = allocation_count;
+    start = clock();
+    for (iteration = 0; iteration < iterations; iteration++)
+    {
+        if (cJSONUtils_GenerateMergePatchCaseSensitive(config, unchanged) != NULL)
+        {
+            fprintf(stderr, "Unchanged config has a merge patch.\n");
+            return EXIT_FAILURE;
+        }
+    }
+    report("GenerateMergePatch, unchanged", iterations, (double)(clock() - start) / CLOCKS_PER_SEC, allocation_count - allocations);
+
+    /* the cameras are an array, which merge patches replace as a whole */
+    allocations = allocation_count;
+    start = clock();
+    for (iteration = 0; iteration < iterations; iteration++)
+    {
+        cJSON_Delete(cJSONUtils_GenerateMergePatchCaseSensitive(config, changed));
+    }
+    report("GenerateMergePatch, changed", iterations, (double)(clock() - start) / CLOCKS_PER_SEC, allocation_count - allocations);
+
+    merge_patch = cJSON_Parse("{\"version\":4,\"model\":{\"confidence\":0.3,\"iou\":null,\"input_size\":640}}");
+    allocations = allocation_count;
+    start = clock();
+    for (iteration = 0; iteration < iterations; iteration++)
+    {
+        config = cJSONUtils_MergePatchCaseSensitive(config, merge_patch);
+    }
+    report("MergePatch", iterations, (double)(clock() - start) / CLOCKS_PER_SEC, allocation_count - allocations);
+
+    cJSON_Delete(merge_patch);
+    cJSON_Delete(undo);
+    cJSON_Delete(patches);
+    cJSON_Delete(changed);
+    cJSON_Delete(unchanged);
+    cJSON_Delete(config);
+
+    return EXIT_SUCCESS;
+}
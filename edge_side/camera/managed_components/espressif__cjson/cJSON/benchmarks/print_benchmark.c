@@ -0,0 +1,164 @@
+/*
+  Copyright (c) 2009-2017 Dave Gamble and cJSON contributors
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+/* Prints detection results (bounding boxes with float coordinates and scores) with cJSON_PrintUnformatted
+ * and compares the number formatting with the previous sprintf("%1.15g") + sscanf approach.
+ * usage: print_benchmark [iterations] */
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../cJSON.h"
+
+static cJSON *create_detections(unsigned long seed, int boxes)
+{
+    cJSON *detections = cJSON_CreateObject();
+    cJSON *array = cJSON_AddArrayToObject(detections, "boxes");
+    int i = 0;
+
+    cJSON_AddStringToObject(detections, "camera", "cam-1");
+    cJSON_AddNumberToObject(detections, "timestamp", 1700000000.0 + ((double)seed / 15.0));
+    cJSON_AddNumberToObject(detections, "people_count", boxes);
+    for (i = 0; i < boxes; i++)
+    {
+        cJSON *box = cJSON_CreateObject();
+        seed = (seed * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+        /* model output scaled back to the frame, so coordinates are rarely integers */
+        cJSON_AddNumberToObject(box, "x", (double)(seed % 64000UL) / 100.0 + 0.3);
+        cJSON_AddNumberToObject(box, "y", (double)(seed % 48000UL) / 100.0);
+        cJSON_AddNumberToObject(box, "w", (double)(seed % 12000UL) / 97.0);
+        cJSON_AddNumberToObject(box, "h", (double)(seed % 20000UL) / 101.0);
+        cJSON_AddStringToObject(box, "label", "person");
+        cJSON_AddNumberToObject(box, "score", (double)(seed % 1000UL) / 1000.0);
+        cJSON_AddItemToArray(array, box);
+    }
+
+    return detections;
+}
+
+/* the number formatting cJSON used before */
+static int previous_print_number(double d, char *buffer)
+{
+    double test = 0.0;
+    int length = sprintf(buffer, "%1.15g", d);
+
+    if ((sscanf(buffer, "%lg", &test) != 1) || (fabs(test - d) > (fabs(d) * DBL_EPSILON)))
+    {
+        length = sprintf(buffer, "%1.17g", d);
+    }
+
+    return length;
+}
+
+static size_t collect_numbers(const cJSON *item, double *numbers, size_t count)
+{
+    for (; item != NULL; item = item->next)
+    {
+        if (cJSON_IsNumber(item))
+        {
+            numbers[count++] = item->valuedouble;
+        }
+        count = collect_numbers(item->child, numbers, count);
+    }
+
+    return count;
+}
+
+int CJSON_CDECL main(int argc, char **argv)
+{
+    static const int box_counts[] = { 0, 1, 10, 50, 200 };
+    cJSON *documents[sizeof(box_counts) / sizeof(box_counts[0])];
+    cJSON *number_array = NULL;
+    double *numbers = NULL;
+    size_t number_count = 0;
+    size_t printed_bytes = 0;
+    unsigned long iterations = 2000;
+    unsigned long iteration = 0;
+    double seconds = 0;
+    clock_t start = 0;
+    char buffer[32];
+    size_t i = 0;
+
+    if (argc > 1)
+    {
+        iterations = strtoul(argv[1], NULL, 10);
+    }
+
+    numbers = (double*)malloc(10000 * sizeof(double));
+    if (numbers == NULL)
+    {
+        return EXIT_FAILURE;
+    }
+    for (i = 0; i < (sizeof(documents) / sizeof(documents[0])); i++)
+    {
+        documents[i] = create_detections((unsigned long)i, box_counts[i]);
+        number_count = collect_numbers(documents[i], numbers, number_count);
+    }
+
+    start = clock();
+    for (iteration = 0; iteration < iterations; iteration++)
+    {
+        for (i = 0; i < (sizeof(documents) / sizeof(documents[0])); i++)
+        {
+            char *printed = cJSON_PrintUnformatted(documents[i]);
+            printed_bytes += strlen(printed);
+            cJSON_free(printed);
+        }
+    }
+    seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    printf("cJSON_PrintUnformatted, 0-200 boxes: %8.2f MB/s\n", ((double)printed_bytes / (1024.0 * 1024.0)) / seconds);
+
+    /* all numbers of the documents in one array, which is mostly number formatting */
+    number_array = cJSON_CreateDoubleArray(numbers, (int)number_count);
+    start = clock();
+    for (iteration = 0; iteration < iterations; iteration++)
+    {
+        cJSON_free(cJSON_PrintUnformatted(number_array));
+    }
+    seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    printf("numbers with cJSON:                 %8.2f M numbers/s\n", ((double)number_count * (double)iterations / 1e6) / seconds);
+    cJSON_Delete(number_array);
+
+    printed_bytes = 0;
+    start = clock();
+    for (iteration = 0; iteration < iterations; iteration++)
+    {
+        for (i = 0; i < number_count; i++)
+        {
+            printed_bytes += (size_t)previous_print_number(numbers[i], buffer);
+        }
+    }
+    seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    printf("numbers with %%1.15g + sscanf:       %8.2f M numbers/s\n", ((double)number_count * (double)iterations / 1e6) / seconds);
+
+    for (i = 0; i < (sizeof(documents) / sizeof(documents[0])); i++)
+    {
+        cJSON_Delete(documents[i]);
+    }
+    free(numbers);
+
+    return (printed_bytes > 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,332 @@
+/*
+  Copyright (c) 2009-2017 Dave Gamble and cJSON contributors
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+/* Compares building a tree with cJSON_ParseWithLength against walking the same input with the pull parser.
+ * The input is a replayed history log of detection results, once with one result per line
+ * and once as a single array holding all of them.
+ * usage: pull_benchmark [megabytes] [chunk size] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../cJSON.h"
+
+/* every allocation is prefixed with its size so that the peak can be tracked */
+typedef union
+{
+    size_t size;
+    double alignment;
+} allocation_header;
+
+static size_t allocated_bytes = 0;
+static size_t peak_bytes = 0;
+
+static void * CJSON_CDECL counting_malloc(size_t size)
+{
+    allocation_header *header = (allocation_header*)malloc(sizeof(allocation_header) + size);
+    if (header == NULL)
+    {
+        return NULL;
+    }
+
+    header->size = size;
+    allocated_bytes += size;
+    if (allocated_bytes > peak_bytes)
+    {
+        peak_bytes = allocated_bytes;
+    }
+
+    return header + 1;
+}
+
+static void CJSON_CDECL counting_free(void *pointer)
+{
+    allocation_header *header = NULL;
+
+    if (pointer == NULL)
+    {
+        return;
+    }
+
+    header = ((allocation_header*)pointer) - 1;
+    allocated_bytes -= header->size;
+    free(header);
+}
+
+static char *create_history(size_t minimum_length, size_t *length)
+{
+    static const char * const labels[] = { "person", "person", "bicycle", "car" };
+    size_t capacity = minimum_length + 4096;
+    char *history = (char*)malloc(capacity);
+    size_t used = 0;
+    unsigned long frame = 0;
+
+    if (history == NULL)
+    {
+        return NULL;
+    }
+
+    while (used < minimum_length)
+    {
+        size_t boxes = frame % 8;
+        size_t i = 0;
+
+        used += (size_t)sprintf(history + used, "{\"camera\":\"cam-%lu\",\"frame\":%lu,\"timestamp\":%.3f,\"people_count\":%lu,\"boxes\":[",
+                frame % 4, frame, 1700000000.0 + ((double)frame / 15.0), (unsigned long)boxes);
+        for (i = 0; i < boxes; i++)
+        {
+            used += (size_t)sprintf(history + used, "%s{\"x\":%lu,\"y\":%lu,\"w\":%lu,\"h\":%lu,\"label\":\"%s\",\"score\":%.4f}",
+                    (i == 0) ? "" : ",", (frame * 7 + i * 13) % 640, (frame * 3 + i * 29) % 480,
+                    40 + (i * 11) % 120, 80 + (i * 17) % 200, labels[(frame + i) % 4], 0.5 + ((double)((frame + i) % 500) / 1000.0));
+        }
+        used += (size_t)sprintf(history + used, "]}\n");
+        frame++;
+    }
+
+    *length = used;
+    return history;
+}
+
+/* both variants compute the same result so that neither can skip work */
+static size_t count_people_in_tree(const cJSON *line)
+{
+    const cJSON *box = NULL;
+    size_t people = 0;
+
+    cJSON_ArrayForEach(box, cJSON_GetObjectItemCaseSensitive(line, "boxes"))
+    {
+        const cJSON *label = cJSON_GetObjectItemCaseSensitive(box, "label");
+        if (cJSON_IsString(label) && (strcmp(label->valuestring, "person") == 0))
+        {
+            people++;
+        }
+    }
+
+    return people;
+}
+
+static size_t run_tree_lines(const char *history, size_t length)
+{
+    const char *line = history;
+    const char *end = history + length;
+    size_t people = 0;
+
+    while (line < end)
+    {
+        const char *line_end = (const char*)memchr(line, '\n', (size_t)(end - line));
+        cJSON *parsed = NULL;
+
+        if (line_end == NULL)
+        {
+            line_end = end;
+        }
+        parsed = cJSON_ParseWithLength(line, (size_t)(line_end - line));
+        if (parsed == NULL)
+        {
+            fprintf(stderr, "Failed to parse a line.\n");
+            exit(EXIT_FAILURE);
+        }
+        people += count_people_in_tree(parsed);
+        cJSON_Delete(parsed);
+
+        line = line_end + 1;
+    }
+
+    return people;
+}
+
+static size_t run_tree_document(const char *history, size_t length)
+{
+    cJSON *parsed = cJSON_ParseWithLength(history, length);
+    const cJSON *line = NULL;
+    size_t people = 0;
+
+    if (parsed == NULL)
+    {
+        fprintf(stderr, "Failed to parse the history.\n");
+        exit(EXIT_FAILURE);
+    }
+    cJSON_ArrayForEach(line, parsed)
+    {
+        people += count_people_in_tree(line);
+    }
+    cJSON_Delete(parsed);
+
+    return people;
+}
+
+/* labels are at depth 3 in the lines and at depth 4 in the array */
+static size_t run_pull(const char *history, size_t length, size_t chunk_size, size_t label_depth)
+{
+    cJSON_PullParser *parser = cJSON_CreatePullParser(chunk_size);
+    size_t position = 0;
+    size_t people = 0;
+    int is_label = 0;
+    int event = cJSON_PullNeedMore;
+
+    if (parser == NULL)
+    {
+        fprintf(stderr, "Failed to create the pull parser.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    while ((event = cJSON_PullNext(parser)) != cJSON_PullEnd)
+    {
+        switch (event)
+        {
+            case cJSON_PullNeedMore:
+                if (position == length)
+                {
+                    cJSON_PullFinish(parser);
+                }
+                position += cJSON_PullFeed(parser, history + position, length - position);
+                break;
+
+            case cJSON_PullError:
+                fprintf(stderr, "Failed to pull parse the history.\n");
+                exit(EXIT_FAILURE);
+
+            case cJSON_PullKey:
+                is_label = (cJSON_PullGetDepth(parser) == label_depth) && (strcmp(cJSON_PullGetValue(parser)->valuestring, "label") == 0);
+                break;
+
+            case cJSON_PullString:
+                if (is_label && (strcmp(cJSON_PullGetValue(parser)->valuestring, "person") == 0))
+                {
+                    people++;
+                }
+                is_label = 0;
+                break;
+
+            default:
+                is_label = 0;
+                break;
+        }
+    }
+
+    cJSON_DeletePullParser(parser);
+
+    return people;
+}
+
+static void report(const char *name, size_t length, double seconds, size_t peak)
+{
+    printf("%-28s %8.2f MB/s, peak %10lu bytes\n", name, ((double)length / (1024.0 * 1024.0)) / seconds, (unsigned long)peak);
+}
+
+typedef size_t (*tree_function)(const char *history, size_t length);
+
+static size_t benchmark_tree(const char *name, tree_function function, const char *history, size_t length)
+{
+    clock_t start = clock();
+    size_t people = 0;
+
+    peak_bytes = 0;
+    people = function(history, length);
+    report(name, length, (double)(clock() - start) / CLOCKS_PER_SEC, peak_bytes);
+
+    return people;
+}
+
+static size_t benchmark_pull(const char *name, const char *history, size_t length, size_t chunk_size, size_t label_depth)
+{
+    clock_t start = clock();
+    size_t people = 0;
+
+    peak_bytes = 0;
+    people = run_pull(history, length, chunk_size, label_depth);
+    report(name, length, (double)(clock() - start) / CLOCKS_PER_SEC, peak_bytes);
+
+    return people;
+}
+
+int CJSON_CDECL main(int argc, char **argv)
+{
+    cJSON_Hooks hooks = { counting_malloc, counting_free };
+    size_t megabytes = 8;
+    size_t chunk_size = 4096;
+    size_t length = 0;
+    size_t people[4];
+    size_t i = 0;
+    char *lines = NULL;
+    char *document = NULL;
+
+    if (argc > 1)
+    {
+        megabytes = (size_t)strtoul(argv[1], NULL, 10);
+    }
+    if (argc > 2)
+    {
+        chunk_size = (size_t)strtoul(argv[2], NULL, 10);
+    }
+    if ((megabytes == 0) || (chunk_size == 0))
+    {
+        fprintf(stderr, "usage: %s [megabytes] [chunk size]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    lines = create_history(megabytes * 1024 * 1024, &length);
+    document = (char*)malloc(length + 1);
+    if ((lines == NULL) || (document == NULL))
+    {
+        fprintf(stderr, "Failed to allocate the input.\n");
+        free(lines);
+        return EXIT_FAILURE;
+    }
+
+    /* the same results as one array: "[" + lines with '\n' turned into ',' + "]" */
+    document[0] = '[';
+    memcpy(document + 1, lines, length);
+    for (i = 1; i < length; i++)
+    {
+        if (document[i] == '\n')
+        {
+            document[i] = ',';
+        }
+    }
+    document[length] = ']';
+
+    cJSON_InitHooks(&hooks);
+
+    printf("input: %lu bytes, chunk size %lu bytes\n", (unsigned long)length, (unsigned long)chunk_size);
+    people[0] = benchmark_tree("tree, one line at a time", run_tree_lines, lines, length);
+    people[1] = benchmark_pull("pull, lines", lines, length, chunk_size, 3);
+    people[2] = benchmark_tree("tree, whole array", run_tree_document, document, length + 1);
+    people[3] = benchmark_pull("pull, whole array", document, length + 1, chunk_size, 4);
+
+    free(document);
+    free(lines);
+
+    for (i = 1; i < (sizeof(people) / sizeof(people[0])); i++)
+    {
+        if (people[i] != people[0])
+        {
+            fprintf(stderr, "Results differ: %lu vs. %lu people.\n", (unsigned long)people[i], (unsigned long)people[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    printf("%lu people in every run\n", (unsigned long)people[0]);
+
+    return EXIT_SUCCESS;
+}
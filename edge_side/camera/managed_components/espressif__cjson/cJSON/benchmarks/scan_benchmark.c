@@ -0,0 +1,146 @@
+/*
+  Copyright (c) 2009-2017 Dave Gamble and cJSON contributors
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+/* Measures how fast cJSON_ParseWithLength gets through input that is mostly whitespace or mostly string
+ * contents, which is where skipping whitespace and scanning strings dominate.
+ * usage: scan_benchmark [megabytes] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../cJSON.h"
+
+/* detection results printed with cJSON_Print, nested a few levels deep so the indentation adds up */
+static char *create_formatted(size_t minimum_length, size_t *length)
+{
+    cJSON *history = cJSON_CreateArray();
+    char *printed = NULL;
+    unsigned long frame = 0;
+
+    for (*length = 0; *length < minimum_length; *length += 400)
+    {
+        cJSON *result = cJSON_CreateObject();
+        cJSON *boxes = cJSON_AddArrayToObject(cJSON_AddObjectToObject(result, "detections"), "boxes");
+        cJSON *box = cJSON_CreateObject();
+
+        cJSON_AddNumberToObject(result, "frame", (double)frame++);
+        cJSON_AddStringToObject(box, "label", "person");
+        cJSON_AddNumberToObject(box, "x", 120);
+        cJSON_AddNumberToObject(box, "y", 40);
+        cJSON_AddItemToArray(boxes, box);
+        cJSON_AddItemToArray(history, result);
+    }
+
+    printed = cJSON_Print(history);
+    cJSON_Delete(history);
+    *length = strlen(printed);
+
+    return printed;
+}
+
+/* snapshots with a base64 encoded thumbnail each, so most of the input is string contents */
+static char *create_strings(size_t minimum_length, size_t *length)
+{
+    static const char base64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    char *json = (char*)malloc(minimum_length + 8192);
+    unsigned long state = 1;
+    size_t used = 0;
+
+    if (json == NULL)
+    {
+        return NULL;
+    }
+
+    json[used++] = '[';
+    while (used < minimum_length)
+    {
+        size_t i = 0;
+
+        used += (size_t)sprintf(json + used, "{\"camera\":\"cam-1\",\"thumbnail\":\"");
+        for (i = 0; i < 4096; i++)
+        {
+            state = (state * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+            json[used++] = base64[(state >> 16) % 64];
+        }
+        used += (size_t)sprintf(json + used, "\"},");
+    }
+    json[used - 1] = ']';
+    json[used] = '\0';
+    *length = used;
+
+    return json;
+}
+
+static void benchmark(const char *name, const char *json, size_t length)
+{
+    unsigned long iterations = 0;
+    clock_t start = clock();
+    double seconds = 0;
+
+    /* run for at least a second */
+    do
+    {
+        cJSON *parsed = cJSON_ParseWithLength(json, length);
+        if (parsed == NULL)
+        {
+            fprintf(stderr, "Failed to parse %s.\n", name);
+            exit(EXIT_FAILURE);
+        }
+        cJSON_Delete(parsed);
+        iterations++;
+        seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    } while (seconds < 1.0);
+
+    printf("%-24s %8.3f GB/s\n", name, ((double)length * (double)iterations / (1024.0 * 1024.0 * 1024.0)) / seconds);
+}
+
+int CJSON_CDECL main(int argc, char **argv)
+{
+    size_t megabytes = 4;
+    size_t length = 0;
+    char *json = NULL;
+
+    if (argc > 1)
+    {
+        megabytes = (size_t)strtoul(argv[1], NULL, 10);
+    }
+
+    json = create_formatted(megabytes * 1024 * 1024, &length);
+    if (json == NULL)
+    {
+        return EXIT_FAILURE;
+    }
+    benchmark("formatted detections", json, length);
+    cJSON_free(json);
+
+    json = create_strings(megabytes * 1024 * 1024, &length);
+    if (json == NULL)
+    {
+        return EXIT_FAILURE;
+    }
+    benchmark("base64 thumbnails", json, length);
+    free(json);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,139 @@
+/*
+  Copyright (c) 2009-2017 Dave Gamble and cJSON contributors
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+/* Compares looking up every known field of a command with cJSON_GetObjectItemCaseSensitive against a single
+ * cJSON_MatchSchema walk, for the camera command (4 fields) and for a command set with dozens of fields.
+ * usage: schema_benchmark [iterations] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../cJSON.h"
+
+#define max_fields 48
+
+static void benchmark(const char *name, size_t field_count, size_t member_count, unsigned long iterations)
+{
+    cJSON_SchemaField fields[max_fields];
+    char keys[max_fields][24];
+    const cJSON *slots[max_fields];
+    cJSON *command = cJSON_CreateObject();
+    cJSON_Schema *schema = NULL;
+    unsigned long iteration = 0;
+    size_t found_by_lookup = 0;
+    size_t found_by_schema = 0;
+    double lookup_seconds = 0;
+    double schema_seconds = 0;
+    clock_t start = 0;
+    size_t i = 0;
+
+    for (i = 0; i < field_count; i++)
+    {
+        static const char * const camera_keys[] = { "brightness", "contrast", "saturation", "quality" };
+        if (i < 4)
+        {
+            strcpy(keys[i], camera_keys[i]);
+        }
+        else
+        {
+            sprintf(keys[i], "setting_%lu", (unsigned long)i);
+        }
+        fields[i].key = keys[i];
+        fields[i].types = cJSON_Number;
+        fields[i].required = 0;
+    }
+    /* commands usually set a few of the fields, in any order */
+    for (i = 0; i < member_count; i++)
+    {
+        cJSON_AddNumberToObject(command, keys[(i * 7) % field_count], (double)i);
+    }
+
+    schema = cJSON_CreateSchema(fields, field_count);
+    if ((schema == NULL) || (command == NULL))
+    {
+        fprintf(stderr, "Failed to create the schema.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    start = clock();
+    for (iteration = 0; iteration < iterations; iteration++)
+    {
+        for (i = 0; i < field_count; i++)
+        {
+            const cJSON *field = cJSON_GetObjectItemCaseSensitive(command, keys[i]);
+            if (cJSON_IsNumber(field))
+            {
+                found_by_lookup++;
+            }
+        }
+    }
+    lookup_seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    start = clock();
+    for (iteration = 0; iteration < iterations; iteration++)
+    {
+        if (cJSON_MatchSchema(schema, command, slots, NULL) != cJSON_SchemaOk)
+        {
+            fprintf(stderr, "Failed to match the schema.\n");
+            exit(EXIT_FAILURE);
+        }
+        for (i = 0; i < field_count; i++)
+        {
+            if (slots[i] != NULL)
+            {
+                found_by_schema++;
+            }
+        }
+    }
+    schema_seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    if (found_by_lookup != found_by_schema)
+    {
+        fprintf(stderr, "Results differ: %lu vs. %lu fields.\n", (unsigned long)found_by_lookup, (unsigned long)found_by_schema);
+        exit(EXIT_FAILURE);
+    }
+
+    printf("%-32s lookups %8.2f M commands/s, schema %8.2f M commands/s\n", name,
+            ((double)iterations / 1e6) / lookup_seconds, ((double)iterations / 1e6) / schema_seconds);
+
+    cJSON_DeleteSchema(schema);
+    cJSON_Delete(command);
+}
+
+int CJSON_CDECL main(int argc, char **argv)
+{
+    unsigned long iterations = 1000000;
+
+    if (argc > 1)
+    {
+        iterations = strtoul(argv[1], NULL, 10);
+    }
+
+    benchmark("camera command, 4 of 4 fields", 4, 4, iterations);
+    benchmark("camera command, 1 of 4 fields", 4, 1, iterations);
+    benchmark("12 of 48 fields", 48, 12, iterations / 10);
+    benchmark("48 of 48 fields", 48, 48, iterations / 10);
+
+    return EXIT_SUCCESS;
+}
@@ -49,6 +49,18 @@
 #include <locale.h>
 #endif
 
+/* vector instructions for scanning the input, define CJSON_DISABLE_SIMD to use the portable version */
+#if !defined(CJSON_DISABLE_SIMD) && defined(__AVX2__)
+#include <immintrin.h>
+#define CJSON_SIMD_AVX2
+#elif !defined(CJSON_DISABLE_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)))
+#include <emmintrin.h>
+#define CJSON_SIMD_SSE2
+#elif !defined(CJSON_DISABLE_SIMD) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#include <arm_neon.h>
+#define CJSON_SIMD_NEON
+#endif
+
 #if defined(_MSC_VER)
 #pragma warning (pop)
 #endif
@@ -158,6 +170,7 @@ typedef struct internal_hooks
     void *(CJSON_CDECL *allocate)(size_t size);
     void (CJSON_CDECL *deallocate)(void *pointer);
     void *(CJSON_CDECL *reallocate)(void *pointer, size_t size);
+    cJSON_Arena *arena; /* if set, items and strings are allocated from here instead */
 } internal_hooks;
 
 #if defined(_MSC_VER)
@@ -183,7 +196,67 @@ static void * CJSON_CDECL internal_realloc(void *pointer, size_t size)
 /* strlen of character literals resolved at compile time */
 #define static_strlen(string_literal) (sizeof(string_literal) - sizeof(""))
 
-static internal_hooks global_hooks = { internal_malloc, internal_free, internal_realloc };
+static internal_hooks global_hooks = { internal_malloc, internal_free, internal_realloc, NULL };
+
+/* every arena allocation is aligned to the size of this, which is enough for cJSON items */
+typedef union
+{
+    void *pointer;
+    double number;
+    size_t size;
+} arena_alignment;
+
+static void *arena_allocate(cJSON_Arena * const arena, size_t size)
+{
+    size_t start = 0;
+
+    if ((arena == NULL) || (arena->buffer == NULL))
+    {
+        return NULL;
+    }
+
+    start = arena->offset + ((sizeof(arena_alignment) - (arena->offset % sizeof(arena_alignment))) % sizeof(arena_alignment));
+    if ((start > arena->size) || (size > (arena->size - start)))
+    {
+        return NULL; /* out of space */
+    }
+
+    arena->last_offset = start;
+    arena->offset = start + size;
+
+    return arena->buffer + start;
+}
+
+/* Only the most recent allocation can be handed back, everything else stays until the arena is reset.
+ * This is enough for the temporary buffers of the parser, which are freed right after they are allocated. */
+static void arena_deallocate(cJSON_Arena * const arena, void *pointer)
+{
+    if ((arena != NULL) && (pointer != NULL) && ((unsigned char*)pointer == (arena->buffer + arena->last_offset)))
+    {
+        arena->offset = arena->last_offset;
+    }
+}
+
+static void *hooks_allocate(const internal_hooks * const hooks, size_t size)
+{
+    if (hooks->arena != NULL)
+    {
+        return arena_allocate(hooks->arena, size);
+    }
+
+    return hooks->allocate(size);
+}
+
+static void hooks_deallocate(const internal_hooks * const hooks, void *pointer)
+{
+    if (hooks->arena != NULL)
+    {
+        arena_deallocate(hooks->arena, pointer);
+        return;
+    }
+
+    hooks->deallocate(pointer);
+}
 
 static unsigned char* cJSON_strdup(const unsigned char* string, const internal_hooks * const hooks)
 {
@@ -196,7 +269,7 @@ static unsigned char* cJSON_strdup(const unsigned char* string, const internal_h
     }
 
     length = strlen((const char*)string) + sizeof("");
-    copy = (unsigned char*)hooks->allocate(length);
+    copy = (unsigned char*)hooks_allocate(hooks, length);
     if (copy == NULL)
     {
         return NULL;
@@ -206,41 +279,38 @@ static unsigned char* cJSON_strdup(const unsigned char* string, const internal_h
     return copy;
 }
 
-CJSON_PUBLIC(void) cJSON_InitHooks(cJSON_Hooks* hooks)
+/* NULL hooks or functions mean the ones of the standard library */
+static void set_hooks(internal_hooks * const target, const cJSON_Hooks * const hooks)
 {
-    if (hooks == NULL)
-    {
-        /* Reset hooks */
-        global_hooks.allocate = malloc;
-        global_hooks.deallocate = free;
-        global_hooks.reallocate = realloc;
-        return;
-    }
-
-    global_hooks.allocate = malloc;
-    if (hooks->malloc_fn != NULL)
+    target->allocate = malloc;
+    if ((hooks != NULL) && (hooks->malloc_fn != NULL))
     {
-        global_hooks.allocate = hooks->malloc_fn;
+        target->allocate = hooks->malloc_fn;
     }
 
-    global_hooks.deallocate = free;
-    if (hooks->free_fn != NULL)
+    target->deallocate = free;
+    if ((hooks != NULL) && (hooks->free_fn != NULL))
     {
-        global_hooks.deallocate = hooks->free_fn;
+        target->deallocate = hooks->free_fn;
     }
 
     /* use realloc only if both free and malloc are used */
-    global_hooks.reallocate = NULL;
-    if ((global_hooks.allocate == malloc) && (global_hooks.deallocate == free))
+    target->reallocate = NULL;
+    if ((target->allocate == malloc) && (target->deallocate == free))
     {
-        global_hooks.reallocate = realloc;
+        target->reallocate = realloc;
     }
 }
 
+CJSON_PUBLIC(void) cJSON_InitHooks(cJSON_Hooks* hooks)
+{
+    set_hooks(&global_hooks, hooks);
+}
+
 /* Internal constructor. */
 static cJSON *cJSON_New_Item(const internal_hooks * const hooks)
 {
-    cJSON* node = (cJSON*)hooks->allocate(sizeof(cJSON));
+    cJSON* node = (cJSON*)hooks_allocate(hooks, sizeof(cJSON));
     if (node)
     {
         memset(node, '\0', sizeof(cJSON));
@@ -249,32 +319,48 @@ static cJSON *cJSON_New_Item(const internal_hooks * const hooks)
     return node;
 }
 
-/* Delete a cJSON structure. */
-CJSON_PUBLIC(void) cJSON_Delete(cJSON *item)
+static void delete_object_index(cJSON * const object);
+
+/* Delete a cJSON structure. Arena items are left alone, they are released with their arena. */
+static void delete_item(cJSON *item, const internal_hooks * const hooks)
 {
     cJSON *next = NULL;
     while (item != NULL)
     {
         next = item->next;
+        if (item->type & cJSON_IsIndexed)
+        {
+            delete_object_index(item);
+        }
         if (!(item->type & cJSON_IsReference) && (item->child != NULL))
         {
-            cJSON_Delete(item->child);
+            delete_item(item->child, hooks);
+        }
+        if (item->type & cJSON_InArena)
+        {
+            item = next;
+            continue;
         }
         if (!(item->type & cJSON_IsReference) && (item->valuestring != NULL))
         {
-            global_hooks.deallocate(item->valuestring);
+            hooks->deallocate(item->valuestring);
             item->valuestring = NULL;
         }
         if (!(item->type & cJSON_StringIsConst) && (item->string != NULL))
         {
-            global_hooks.deallocate(item->string);
+            hooks->deallocate(item->string);
             item->string = NULL;
         }
-        global_hooks.deallocate(item);
+        hooks->deallocate(item);
         item = next;
     }
 }
 
+CJSON_PUBLIC(void) cJSON_Delete(cJSON *item)
+{
+    delete_item(item, &global_hooks);
+}
+
 /* get the decimal point character of the current locale */
 static unsigned char get_decimal_point(void)
 {
@@ -293,6 +379,7 @@ typedef struct
     size_t offset;
     size_t depth; /* How deeply nested (in arrays/objects) is the input at the current offset. */
     internal_hooks hooks;
+    cJSON_bool in_situ; /* unescape strings inside of content instead of copying them (content is writable then) */
 } parse_buffer;
 
 /* check if the given size is left to read in a given parse buffer (starting with 1) */
@@ -303,84 +390,349 @@ typedef struct
 /* get a pointer to the buffer at the position */
 #define buffer_at_offset(buffer) ((buffer)->content + (buffer)->offset)
 
+/* The scanners below skip whole blocks of 32 (AVX2), 16 (SSE2, NEON) or sizeof(unsigned long) bytes
+ * as long as none of them is interesting and leave the exact position to a byte at a time loop. */
+
+/* the portable version treats an unsigned long as a vector of bytes */
+#define bytes_repeated(byte) ((~0UL / 255) * (unsigned long)(byte))
+#define word_has_zero_byte(word) ((((word) - bytes_repeated(1)) & ~(word) & bytes_repeated(128)) != 0)
+#define word_has_byte_above_space(word) (((((word) + bytes_repeated(127 - 32)) | (word)) & bytes_repeated(128)) != 0)
+
+/* get the position of the first byte after position that is not whitespace (any byte <= 32 counts as whitespace) */
+static size_t skip_whitespace_bytes(const unsigned char * const content, size_t position, const size_t length)
+{
+    if ((position < length) && (content[position] > 32))
+    {
+        return position;
+    }
+
+#if defined(CJSON_SIMD_AVX2)
+    {
+        const __m256i space = _mm256_set1_epi8(32);
+        while ((length - position) >= 32)
+        {
+            /* max(byte, 32) is 32 for every whitespace byte */
+            __m256i bytes = _mm256_loadu_si256((const __m256i*)(const void*)(content + position));
+            if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(bytes, space), space)) != -1)
+            {
+                break;
+            }
+            position += 32;
+        }
+    }
+#elif defined(CJSON_SIMD_SSE2)
+    {
+        const __m128i space = _mm_set1_epi8(32);
+        while ((length - position) >= 16)
+        {
+            __m128i bytes = _mm_loadu_si128((const __m128i*)(const void*)(content + position));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(bytes, space), space)) != 0xFFFF)
+            {
+                break;
+            }
+            position += 16;
+        }
+    }
+#elif defined(CJSON_SIMD_NEON)
+    {
+        const uint8x16_t space = vdupq_n_u8(32);
+        while ((length - position) >= 16)
+        {
+            uint64x2_t above = vreinterpretq_u64_u8(vcgtq_u8(vld1q_u8(content + position), space));
+            if ((vgetq_lane_u64(above, 0) | vgetq_lane_u64(above, 1)) != 0)
+            {
+                break;
+            }
+            position += 16;
+        }
+    }
+#endif
+    while ((length - position) >= sizeof(unsigned long))
+    {
+        unsigned long word = 0;
+        memcpy(&word, content + position, sizeof(word));
+        if (word_has_byte_above_space(word))
+        {
+            break;
+        }
+        position += sizeof(word);
+    }
+
+    while ((position < length) && (content[position] <= 32))
+    {
+        position++;
+    }
+
+    return position;
+}
+
+/* get the position of the first '\"' or '\\' after position or length if there is none */
+static size_t find_quote_or_backslash(const unsigned char * const content, size_t position, const size_t length)
+{
+#if defined(CJSON_SIMD_AVX2)
+    {
+        const __m256i quote = _mm256_set1_epi8('\"');
+        const __m256i backslash = _mm256_set1_epi8('\\');
+        while ((length - position) >= 32)
+        {
+            __m256i bytes = _mm256_loadu_si256((const __m256i*)(const void*)(content + position));
+            if (_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(bytes, quote), _mm256_cmpeq_epi8(bytes, backslash))) != 0)
+            {
+                break;
+            }
+            position += 32;
+        }
+    }
+#elif defined(CJSON_SIMD_SSE2)
+    {
+        const __m128i quote = _mm_set1_epi8('\"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        while ((length - position) >= 16)
+        {
+            __m128i bytes = _mm_loadu_si128((const __m128i*)(const void*)(content + position));
+            if (_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(bytes, quote), _mm_cmpeq_epi8(bytes, backslash))) != 0)
+            {
+                break;
+            }
+            position += 16;
+        }
+    }
+#elif defined(CJSON_SIMD_NEON)
+    {
+        const uint8x16_t quote = vdupq_n_u8('\"');
+        const uint8x16_t backslash = vdupq_n_u8('\\');
+        while ((length - position) >= 16)
+        {
+            uint8x16_t bytes = vld1q_u8(content + position);
+            uint64x2_t found = vreinterpretq_u64_u8(vorrq_u8(vceqq_u8(bytes, quote), vceqq_u8(bytes, backslash)));
+            if ((vgetq_lane_u64(found, 0) | vgetq_lane_u64(found, 1)) != 0)
+            {
+                break;
+            }
+            position += 16;
+        }
+    }
+#endif
+    while ((length - position) >= sizeof(unsigned long))
+    {
+        unsigned long word = 0;
+        memcpy(&word, content + position, sizeof(word));
+        if (word_has_zero_byte(word ^ bytes_repeated('\"')) || word_has_zero_byte(word ^ bytes_repeated('\\')))
+        {
+            break;
+        }
+        position += sizeof(word);
+    }
+
+    while ((position < length) && (content[position] != '\"') && (content[position] != '\\'))
+    {
+        position++;
+    }
+
+    return position;
+}
+
+/* powers of ten that are exactly representable as a double */
+static const double exact_powers_of_ten[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* up to 15 decimal digits always fit into the 53 bit mantissa of a double */
+#define max_exact_digits 15
+
+/* Scan a number (like strtod, but only in the format that JSON uses) and return its length, 0 if there is none.
+ * If it has at most 15 significant digits and a small enough exponent, the digits and the power of ten are both
+ * exact doubles and a single multiplication or division rounds correctly, so the value is computed right away
+ * and is_exact is set. This doesn't depend on the locale. */
+static size_t scan_number(const parse_buffer * const input_buffer, double * const number, cJSON_bool * const is_exact)
+{
+    const unsigned char *content = buffer_at_offset(input_buffer);
+    const size_t available = input_buffer->length - input_buffer->offset;
+    size_t length = 0;
+    size_t exponent_end = 0;
+    double mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    int explicit_exponent = 0;
+    cJSON_bool negative = false;
+    cJSON_bool negative_exponent = false;
+    cJSON_bool has_digits = false;
+
+    *is_exact = true;
+
+    if ((length < available) && (content[length] == '-'))
+    {
+        negative = true;
+        length++;
+    }
+
+    /* integer part */
+    for (; (length < available) && (content[length] >= '0') && (content[length] <= '9'); length++)
+    {
+        has_digits = true;
+        if ((mantissa == 0) && (content[length] == '0'))
+        {
+            continue; /* leading zero */
+        }
+        if (digits == max_exact_digits)
+        {
+            *is_exact = false;
+            continue;
+        }
+        mantissa = (mantissa * 10) + (double)(content[length] - '0');
+        digits++;
+    }
+
+    /* fraction */
+    if ((length < available) && (content[length] == '.'))
+    {
+        for (length++; (length < available) && (content[length] >= '0') && (content[length] <= '9'); length++)
+        {
+            has_digits = true;
+            if ((mantissa == 0) && (content[length] == '0'))
+            {
+                /* leading zeros only move the decimal point (without overflowing on absurdly long inputs) */
+                if (exponent > -1000)
+                {
+                    exponent--;
+                }
+                continue;
+            }
+            if (digits == max_exact_digits)
+            {
+                *is_exact = false;
+                continue;
+            }
+            mantissa = (mantissa * 10) + (double)(content[length] - '0');
+            digits++;
+            exponent--;
+        }
+    }
+
+    if (!has_digits)
+    {
+        return 0;
+    }
+
+    /* the exponent only belongs to the number if it has at least one digit */
+    if ((length < available) && ((content[length] == 'e') || (content[length] == 'E')))
+    {
+        exponent_end = length + 1;
+        if ((exponent_end < available) && ((content[exponent_end] == '+') || (content[exponent_end] == '-')))
+        {
+            negative_exponent = (content[exponent_end] == '-');
+            exponent_end++;
+        }
+        if ((exponent_end < available) && (content[exponent_end] >= '0') && (content[exponent_end] <= '9'))
+        {
+            for (; (exponent_end < available) && (content[exponent_end] >= '0') && (content[exponent_end] <= '9'); exponent_end++)
+            {
+                /* anything this large is out of range anyway */
+                if (explicit_exponent < 10000)
+                {
+                    explicit_exponent = (explicit_exponent * 10) + (content[exponent_end] - '0');
+                }
+            }
+            length = exponent_end;
+            exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+        }
+    }
+
+    if (!*is_exact)
+    {
+        return length;
+    }
+
+    if ((mantissa == 0) || (exponent == 0))
+    {
+        *number = mantissa;
+    }
+    else if ((exponent < 0) && (exponent >= -22))
+    {
+        *number = mantissa / exact_powers_of_ten[-exponent];
+    }
+    else if ((exponent > 0) && (exponent <= 22))
+    {
+        *number = mantissa * exact_powers_of_ten[exponent];
+    }
+    else if ((exponent > 22) && (exponent <= (22 + max_exact_digits - digits)))
+    {
+        /* move some of the exponent into the mantissa while that stays exact */
+        *number = (mantissa * exact_powers_of_ten[exponent - 22]) * exact_powers_of_ten[22];
+    }
+    else
+    {
+        *is_exact = false;
+        return length;
+    }
+
+    if (negative)
+    {
+        *number = -*number;
+    }
+
+    return length;
+}
+
 /* Parse the input text to generate a number, and populate the result into item. */
 static cJSON_bool parse_number(cJSON * const item, parse_buffer * const input_buffer)
 {
     double number = 0;
     unsigned char *after_end = NULL;
-    unsigned char *number_c_string;
-    unsigned char decimal_point = get_decimal_point();
+    unsigned char small_number_c_string[64];
+    unsigned char *number_c_string = small_number_c_string;
     size_t i = 0;
     size_t number_string_length = 0;
-    cJSON_bool has_decimal_point = false;
+    cJSON_bool is_exact = false;
 
     if ((input_buffer == NULL) || (input_buffer->content == NULL))
     {
         return false;
     }
 
-    /* copy the number into a temporary buffer and replace '.' with the decimal point
-     * of the current locale (for strtod)
-     * This also takes care of '\0' not necessarily being available for marking the end of the input */
-    for (i = 0; can_access_at_index(input_buffer, i); i++)
-    {
-        switch (buffer_at_offset(input_buffer)[i])
-        {
-            case '0':
-            case '1':
-            case '2':
-            case '3':
-            case '4':
-            case '5':
-            case '6':
-            case '7':
-            case '8':
-            case '9':
-            case '+':
-            case '-':
-            case 'e':
-            case 'E':
-                number_string_length++;
-                break;
-
-            case '.':
-                number_string_length++;
-                has_decimal_point = true;
-                break;
-
-            default:
-                goto loop_end;
-        }
-    }
-loop_end:
-    /* malloc for temporary buffer, add 1 for '\0' */
-    number_c_string = (unsigned char *) input_buffer->hooks.allocate(number_string_length + 1);
-    if (number_c_string == NULL)
+    number_string_length = scan_number(input_buffer, &number, &is_exact);
+    if (number_string_length == 0)
     {
-        return false; /* allocation failure */
+        return false; /* parse_error */
     }
 
-    memcpy(number_c_string, buffer_at_offset(input_buffer), number_string_length);
-    number_c_string[number_string_length] = '\0';
-
-    if (has_decimal_point)
+    if (!is_exact)
     {
+        /* Use strtod for correct rounding of everything else. Copy the number into a temporary buffer
+         * and replace '.' with the decimal point of the current locale, this also takes care of '\0'
+         * not necessarily being available for marking the end of the input */
+        if (number_string_length >= sizeof(small_number_c_string))
+        {
+            number_c_string = (unsigned char *) hooks_allocate(&input_buffer->hooks, number_string_length + 1);
+            if (number_c_string == NULL)
+            {
+                return false; /* allocation failure */
+            }
+        }
+
+        memcpy(number_c_string, buffer_at_offset(input_buffer), number_string_length);
+        number_c_string[number_string_length] = '\0';
+
         for (i = 0; i < number_string_length; i++)
         {
             if (number_c_string[i] == '.')
             {
-                /* replace '.' with the decimal point of the current locale (for strtod) */
-                number_c_string[i] = decimal_point;
+                number_c_string[i] = get_decimal_point();
             }
         }
-    }
 
-    number = strtod((const char*)number_c_string, (char**)&after_end);
-    if (number_c_string == after_end)
-    {
-        /* free the temporary buffer */
-        input_buffer->hooks.deallocate(number_c_string);
-        return false; /* parse_error */
+        number = strtod((const char*)number_c_string, (char**)&after_end);
+        number_string_length = (size_t)(after_end - number_c_string);
+        if (number_c_string != small_number_c_string)
+        {
+            /* free the temporary buffer */
+            hooks_deallocate(&input_buffer->hooks, number_c_string);
+        }
+        if (number_string_length == 0)
+        {
+            return false; /* parse_error */
+        }
     }
 
     item->valuedouble = number;
@@ -401,9 +753,7 @@ loop_end:
 
     item->type = cJSON_Number;
 
-    input_buffer->offset += (size_t)(after_end - number_c_string);
-    /* free the temporary buffer */
-    input_buffer->hooks.deallocate(number_c_string);
+    input_buffer->offset += number_string_length;
     return true;
 }
 
@@ -418,6 +768,11 @@ CJSON_PUBLIC(double) cJSON_SetNumberHelper(cJSON *object, double number)
     {
         object->valueint = INT_MIN;
     }
+    else if (number != number)
+    {
+        /* NaN has no integer value */
+        object->valueint = 0;
+    }
     else
     {
         object->valueint = (int)number;
@@ -456,6 +811,11 @@ CJSON_PUBLIC(char*) cJSON_SetValuestring(cJSON *object, const char *valuestring)
         strcpy(object->valuestring, valuestring);
         return object->valuestring;
     }
+    if (object->type & cJSON_InArena)
+    {
+        /* strings in an arena can only be overwritten in place */
+        return NULL;
+    }
     copy = (char*) cJSON_strdup((const unsigned char*)valuestring, &global_hooks);
     if (copy == NULL)
     {
@@ -479,6 +839,8 @@ typedef struct
     cJSON_bool noalloc;
     cJSON_bool format; /* is this print a formatted print */
     internal_hooks hooks;
+    cJSON_PrintSink sink; /* if set, the printed text is handed to sink whenever the buffer is full and the buffer is reused */
+    void *sink_context;
 } printbuffer;
 
 /* realloc printbuffer if necessary to have at least "needed" bytes more */
@@ -510,6 +872,21 @@ static unsigned char* ensure(printbuffer * const p, size_t needed)
         return p->buffer + p->offset;
     }
 
+    if ((p->sink != NULL) && (p->offset > 0))
+    {
+        /* everything before offset is final, hand it over and start from the beginning */
+        if (!p->sink(p->sink_context, (const char*)p->buffer, p->offset))
+        {
+            return NULL;
+        }
+        needed -= p->offset;
+        p->offset = 0;
+        if (needed <= p->length)
+        {
+            return p->buffer;
+        }
+    }
+
     if (p->noalloc) {
         return NULL;
     }
@@ -587,76 +964,661 @@ static cJSON_bool compare_double(double a, double b)
     return (fabs(a - b) <= maxVal * DBL_EPSILON);
 }
 
-/* Render the number nicely from the given item into a string. */
-static cJSON_bool print_number(const cJSON * const item, printbuffer * const output_buffer)
+/* same output as sprintf with "%d" */
+static int print_int(const int number, unsigned char * const output)
 {
-    unsigned char *output_pointer = NULL;
-    double d = item->valuedouble;
+    unsigned char digits[sizeof(int) * 3];
+    unsigned int magnitude = (unsigned int)number;
     int length = 0;
-    size_t i = 0;
-    unsigned char number_buffer[26] = {0}; /* temporary buffer to print the number into */
-    unsigned char decimal_point = get_decimal_point();
-    double test = 0.0;
+    int i = 0;
 
-    if (output_buffer == NULL)
+    if (number < 0)
     {
-        return false;
+        magnitude = 0U - magnitude;
+        output[length++] = '-';
     }
 
-    /* This checks for NaN and Infinity */
-    if (isnan(d) || isinf(d))
-    {
-        length = sprintf((char*)number_buffer, "null");
-    }
-    else if(d == (double)item->valueint)
-    {
-        length = sprintf((char*)number_buffer, "%d", item->valueint);
-    }
-    else
+    do
     {
-        /* Try 15 decimal places of precision to avoid nonsignificant nonzero digits */
-        length = sprintf((char*)number_buffer, "%1.15g", d);
-
-        /* Check whether the original double can be recovered */
-        if ((sscanf((char*)number_buffer, "%lg", &test) != 1) || !compare_double((double)test, d))
-        {
-            /* If not, print with 17 decimal places of precision */
-            length = sprintf((char*)number_buffer, "%1.17g", d);
-        }
-    }
+        digits[i++] = (unsigned char)('0' + (magnitude % 10));
+        magnitude /= 10;
+    } while (magnitude > 0);
 
-    /* sprintf failed or buffer overrun occurred */
-    if ((length < 0) || (length > (int)(sizeof(number_buffer) - 1)))
+    while (i > 0)
     {
-        return false;
+        output[length++] = digits[--i];
     }
 
-    /* reserve appropriate space in the output */
-    output_pointer = ensure(output_buffer, (size_t)length + sizeof(""));
-    if (output_pointer == NULL)
-    {
-        return false;
-    }
+    return length;
+}
 
-    /* copy the printed number to the output and replace locale
-     * dependent decimal point with '.' */
-    for (i = 0; i < ((size_t)length); i++)
+/* Shortest round trip printing of doubles with Grisu2 (Florian Loitsch, "Printing Floating-Point Numbers Quickly
+ * and Accurately with Integers", 2010). C89 has no 64 bit integer type, so 64 bit values are kept in two 32 bit halves. */
+typedef struct
+{
+    unsigned long high;
+    unsigned long low;
+} grisu_uint64;
+
+/* f * 2^e */
+typedef struct
+{
+    grisu_uint64 f;
+    int e;
+} grisu_fp;
+
+#define grisu_mask32 0xFFFFFFFFUL
+
+/* normalized 10^-348, 10^-340, ..., 10^340 */
+static const grisu_fp grisu_cached_powers[] = {
+    { { 0xfa8fd5a0UL, 0x081c0288UL }, -1220 },
+    { { 0xbaaee17fUL, 0xa23ebf76UL }, -1193 },
+    { { 0x8b16fb20UL, 0x3055ac76UL }, -1166 },
+    { { 0xcf42894aUL, 0x5dce35eaUL }, -1140 },
+    { { 0x9a6bb0aaUL, 0x55653b2dUL }, -1113 },
+    { { 0xe61acf03UL, 0x3d1a45dfUL }, -1087 },
+    { { 0xab70fe17UL, 0xc79ac6caUL }, -1060 },
+    { { 0xff77b1fcUL, 0xbebcdc4fUL }, -1034 },
+    { { 0xbe5691efUL, 0x416bd60cUL }, -1007 },
+    { { 0x8dd01fadUL, 0x907ffc3cUL }, -980 },
+    { { 0xd3515c28UL, 0x31559a83UL }, -954 },
+    { { 0x9d71ac8fUL, 0xada6c9b5UL }, -927 },
+    { { 0xea9c2277UL, 0x23ee8bcbUL }, -901 },
+    { { 0xaecc4991UL, 0x4078536dUL }, -874 },
+    { { 0x823c1279UL, 0x5db6ce57UL }, -847 },
+    { { 0xc2109436UL, 0x4dfb5637UL }, -821 },
+    { { 0x9096ea6fUL, 0x3848984fUL }, -794 },
+    { { 0xd77485cbUL, 0x25823ac7UL }, -768 },
+    { { 0xa086cfcdUL, 0x97bf97f4UL }, -741 },
+    { { 0xef340a98UL, 0x172aace5UL }, -715 },
+    { { 0xb23867fbUL, 0x2a35b28eUL }, -688 },
+    { { 0x84c8d4dfUL, 0xd2c63f3bUL }, -661 },
+    { { 0xc5dd4427UL, 0x1ad3cdbaUL }, -635 },
+    { { 0x936b9fceUL, 0xbb25c996UL }, -608 },
+    { { 0xdbac6c24UL, 0x7d62a584UL }, -582 },
+    { { 0xa3ab6658UL, 0x0d5fdaf6UL }, -555 },
+    { { 0xf3e2f893UL, 0xdec3f126UL }, -529 },
+    { { 0xb5b5ada8UL, 0xaaff80b8UL }, -502 },
+    { { 0x87625f05UL, 0x6c7c4a8bUL }, -475 },
+    { { 0xc9bcff60UL, 0x34c13053UL }, -449 },
+    { { 0x964e858cUL, 0x91ba2655UL }, -422 },
+    { { 0xdff97724UL, 0x70297ebdUL }, -396 },
+    { { 0xa6dfbd9fUL, 0xb8e5b88fUL }, -369 },
+    { { 0xf8a95fcfUL, 0x88747d94UL }, -343 },
+    { { 0xb9447093UL, 0x8fa89bcfUL }, -316 },
+    { { 0x8a08f0f8UL, 0xbf0f156bUL }, -289 },
+    { { 0xcdb02555UL, 0x653131b6UL }, -263 },
+    { { 0x993fe2c6UL, 0xd07b7facUL }, -236 },
+    { { 0xe45c10c4UL, 0x2a2b3b06UL }, -210 },
+    { { 0xaa242499UL, 0x697392d3UL }, -183 },
+    { { 0xfd87b5f2UL, 0x8300ca0eUL }, -157 },
+    { { 0xbce50864UL, 0x92111aebUL }, -130 },
+    { { 0x8cbccc09UL, 0x6f5088ccUL }, -103 },
+    { { 0xd1b71758UL, 0xe219652cUL }, -77 },
+    { { 0x9c400000UL, 0x00000000UL }, -50 },
+    { { 0xe8d4a510UL, 0x00000000UL }, -24 },
+    { { 0xad78ebc5UL, 0xac620000UL }, 3 },
+    { { 0x813f3978UL, 0xf8940984UL }, 30 },
+    { { 0xc097ce7bUL, 0xc90715b3UL }, 56 },
+    { { 0x8f7e32ceUL, 0x7bea5c70UL }, 83 },
+    { { 0xd5d238a4UL, 0xabe98068UL }, 109 },
+    { { 0x9f4f2726UL, 0x179a2245UL }, 136 },
+    { { 0xed63a231UL, 0xd4c4fb27UL }, 162 },
+    { { 0xb0de6538UL, 0x8cc8ada8UL }, 189 },
+    { { 0x83c7088eUL, 0x1aab65dbUL }, 216 },
+    { { 0xc45d1df9UL, 0x42711d9aUL }, 242 },
+    { { 0x924d692cUL, 0xa61be758UL }, 269 },
+    { { 0xda01ee64UL, 0x1a708deaUL }, 295 },
+    { { 0xa26da399UL, 0x9aef774aUL }, 322 },
+    { { 0xf209787bUL, 0xb47d6b85UL }, 348 },
+    { { 0xb454e4a1UL, 0x79dd1877UL }, 375 },
+    { { 0x865b8692UL, 0x5b9bc5c2UL }, 402 },
+    { { 0xc83553c5UL, 0xc8965d3dUL }, 428 },
+    { { 0x952ab45cUL, 0xfa97a0b3UL }, 455 },
+    { { 0xde469fbdUL, 0x99a05fe3UL }, 481 },
+    { { 0xa59bc234UL, 0xdb398c25UL }, 508 },
+    { { 0xf6c69a72UL, 0xa3989f5cUL }, 534 },
+    { { 0xb7dcbf53UL, 0x54e9beceUL }, 561 },
+    { { 0x88fcf317UL, 0xf22241e2UL }, 588 },
+    { { 0xcc20ce9bUL, 0xd35c78a5UL }, 614 },
+    { { 0x98165af3UL, 0x7b2153dfUL }, 641 },
+    { { 0xe2a0b5dcUL, 0x971f303aUL }, 667 },
+    { { 0xa8d9d153UL, 0x5ce3b396UL }, 694 },
+    { { 0xfb9b7cd9UL, 0xa4a7443cUL }, 720 },
+    { { 0xbb764c4cUL, 0xa7a44410UL }, 747 },
+    { { 0x8bab8eefUL, 0xb6409c1aUL }, 774 },
+    { { 0xd01fef10UL, 0xa657842cUL }, 800 },
+    { { 0x9b10a4e5UL, 0xe9913129UL }, 827 },
+    { { 0xe7109bfbUL, 0xa19c0c9dUL }, 853 },
+    { { 0xac2820d9UL, 0x623bf429UL }, 880 },
+    { { 0x80444b5eUL, 0x7aa7cf85UL }, 907 },
+    { { 0xbf21e440UL, 0x03acdd2dUL }, 933 },
+    { { 0x8e679c2fUL, 0x5e44ff8fUL }, 960 },
+    { { 0xd433179dUL, 0x9c8cb841UL }, 986 },
+    { { 0x9e19db92UL, 0xb4e31ba9UL }, 1013 },
+    { { 0xeb96bf6eUL, 0xbadf77d9UL }, 1039 },
+    { { 0xaf87023bUL, 0x9bf0ee6bUL }, 1066 }
+};
+
+static const unsigned long grisu_powers_of_ten[] = {
+    1UL, 10UL, 100UL, 1000UL, 10000UL, 100000UL, 1000000UL, 10000000UL, 100000000UL, 1000000000UL
+};
+
+static grisu_uint64 grisu_make(const unsigned long high, const unsigned long low)
+{
+    grisu_uint64 result;
+
+    result.high = high;
+    result.low = low;
+
+    return result;
+}
+
+static grisu_uint64 grisu_add(const grisu_uint64 a, const grisu_uint64 b)
+{
+    grisu_uint64 sum;
+
+    sum.low = (a.low + b.low) & grisu_mask32;
+    sum.high = (a.high + b.high + ((sum.low < a.low) ? 1UL : 0UL)) & grisu_mask32;
+
+    return sum;
+}
+
+static grisu_uint64 grisu_subtract(const grisu_uint64 a, const grisu_uint64 b)
+{
+    grisu_uint64 difference;
+
+    difference.low = (a.low - b.low) & grisu_mask32;
+    difference.high = (a.high - b.high - ((a.low < b.low) ? 1UL : 0UL)) & grisu_mask32;
+
+    return difference;
+}
+
+static cJSON_bool grisu_less(const grisu_uint64 a, const grisu_uint64 b)
+{
+    return (a.high < b.high) || ((a.high == b.high) && (a.low < b.low));
+}
+
+/* shift has to be less than 64 */
+static grisu_uint64 grisu_shift_left(const grisu_uint64 a, const int shift)
+{
+    if (shift == 0)
+    {
+        return a;
+    }
+    if (shift >= 32)
+    {
+        return grisu_make((a.low << (shift - 32)) & grisu_mask32, 0);
+    }
+
+    return grisu_make(((a.high << shift) | (a.low >> (32 - shift))) & grisu_mask32, (a.low << shift) & grisu_mask32);
+}
+
+static grisu_uint64 grisu_shift_right(const grisu_uint64 a, const int shift)
+{
+    if (shift == 0)
+    {
+        return a;
+    }
+    if (shift >= 32)
+    {
+        return grisu_make(0, a.high >> (shift - 32));
+    }
+
+    return grisu_make(a.high >> shift, ((a.low >> shift) | (a.high << (32 - shift))) & grisu_mask32);
+}
+
+static grisu_uint64 grisu_multiply_10(const grisu_uint64 a)
+{
+    return grisu_add(grisu_shift_left(a, 3), grisu_shift_left(a, 1));
+}
+
+/* full 64 bit product of two 32 bit numbers, unsigned long is only guaranteed to hold 32 bits */
+static grisu_uint64 grisu_multiply_32(const unsigned long a, const unsigned long b)
+{
+    const unsigned long a_low = a & 0xFFFFUL;
+    const unsigned long a_high = a >> 16;
+    const unsigned long b_low = b & 0xFFFFUL;
+    const unsigned long b_high = b >> 16;
+    const unsigned long low = a_low * b_low;
+    const unsigned long middle_a = a_high * b_low;
+    const unsigned long middle_b = a_low * b_high;
+    const unsigned long middle = (low >> 16) + (middle_a & 0xFFFFUL) + (middle_b & 0xFFFFUL);
+
+    return grisu_make(((a_high * b_high) + (middle_a >> 16) + (middle_b >> 16) + (middle >> 16)) & grisu_mask32,
+            (((middle & 0xFFFFUL) << 16) | (low & 0xFFFFUL)) & grisu_mask32);
+}
+
+/* upper 64 bits of the 128 bit product, rounded */
+static grisu_fp grisu_multiply(const grisu_fp x, const grisu_fp y)
+{
+    const grisu_uint64 ac = grisu_multiply_32(x.f.high, y.f.high);
+    const grisu_uint64 bc = grisu_multiply_32(x.f.low, y.f.high);
+    const grisu_uint64 ad = grisu_multiply_32(x.f.high, y.f.low);
+    const grisu_uint64 bd = grisu_multiply_32(x.f.low, y.f.low);
+    grisu_uint64 middle = grisu_make(0, bd.high);
+    grisu_fp product;
+
+    middle = grisu_add(middle, grisu_make(0, ad.low));
+    middle = grisu_add(middle, grisu_make(0, bc.low));
+    middle = grisu_add(middle, grisu_make(0, 0x80000000UL));
+
+    product.f = grisu_add(ac, grisu_make(0, ad.high));
+    product.f = grisu_add(product.f, grisu_make(0, bc.high));
+    product.f = grisu_add(product.f, grisu_make(0, middle.high));
+    product.e = x.e + y.e + 64;
+
+    return product;
+}
+
+static grisu_fp grisu_normalize(grisu_fp x)
+{
+    if (x.f.high == 0)
+    {
+        x.f = grisu_make(x.f.low, 0);
+        x.e -= 32;
+    }
+    while ((x.f.high & 0x80000000UL) == 0)
+    {
+        x.f = grisu_shift_left(x.f, 1);
+        x.e--;
+    }
+
+    return x;
+}
+
+/* the significand of a positive finite double as integer */
+static grisu_fp grisu_from_double(const double number)
+{
+    int exponent = 0;
+    double significand = frexp(number, &exponent);
+    double high = 0;
+    grisu_fp x;
+
+    /* 53 bit significand, subnormals keep the smallest exponent */
+    exponent -= 53;
+    if (exponent < -1074)
+    {
+        significand = ldexp(significand, 53 - (-1074 - exponent));
+        exponent = -1074;
+    }
+    else
+    {
+        significand = ldexp(significand, 53);
+    }
+
+    high = floor(significand / 4294967296.0);
+    x.f = grisu_make((unsigned long)high, (unsigned long)(significand - (high * 4294967296.0)));
+    x.e = exponent;
+
+    return x;
+}
+
+/* move the last digit down while that gets it closer to the exact value and stays inside of the round trip interval */
+static void grisu_round(unsigned char * const digits, const int length, const grisu_uint64 delta, grisu_uint64 rest, const grisu_uint64 ten_kappa, const grisu_uint64 wp_w)
+{
+    while (grisu_less(rest, wp_w) && !grisu_less(grisu_subtract(delta, rest), ten_kappa)
+            && (grisu_less(grisu_add(rest, ten_kappa), wp_w)
+                || grisu_less(grisu_subtract(grisu_add(rest, ten_kappa), wp_w), grisu_subtract(wp_w, rest))))
+    {
+        digits[length - 1]--;
+        rest = grisu_add(rest, ten_kappa);
+    }
+}
+
+/* generate the shortest digits in the interval (Mp - delta, Mp], starting with the ones closest to w */
+static int grisu_generate_digits(const grisu_fp w, const grisu_fp mp, grisu_uint64 delta, unsigned char * const digits, int * const decimal_exponent)
+{
+    const int shift = -mp.e;
+    const grisu_uint64 one = grisu_shift_left(grisu_make(0, 1), shift);
+    const grisu_uint64 fraction_mask = grisu_subtract(one, grisu_make(0, 1));
+    grisu_uint64 wp_w = grisu_subtract(mp.f, w.f);
+    unsigned long p1 = grisu_shift_right(mp.f, shift).low;
+    grisu_uint64 p2 = grisu_make(mp.f.high & fraction_mask.high, mp.f.low & fraction_mask.low);
+    int kappa = 1;
+    int length = 0;
+    int i = 0;
+
+    while ((kappa < 10) && (p1 >= grisu_powers_of_ten[kappa]))
+    {
+        kappa++;
+    }
+
+    /* integer part */
+    while (kappa > 0)
     {
-        if (number_buffer[i] == decimal_point)
+        unsigned long digit = p1 / grisu_powers_of_ten[kappa - 1];
+        grisu_uint64 rest;
+
+        p1 %= grisu_powers_of_ten[kappa - 1];
+        if ((digit != 0) || (length != 0))
         {
-            output_pointer[i] = '.';
-            continue;
+            digits[length++] = (unsigned char)('0' + digit);
+        }
+        kappa--;
+
+        rest = grisu_add(grisu_shift_left(grisu_make(0, p1), shift), p2);
+        if (!grisu_less(delta, rest))
+        {
+            *decimal_exponent += kappa;
+            grisu_round(digits, length, delta, rest, grisu_shift_left(grisu_make(0, grisu_powers_of_ten[kappa]), shift), wp_w);
+            return length;
+        }
+    }
+
+    /* fractional part */
+    for (;;)
+    {
+        unsigned long digit = 0;
+
+        p2 = grisu_multiply_10(p2);
+        delta = grisu_multiply_10(delta);
+        digit = grisu_shift_right(p2, shift).low;
+        if ((digit != 0) || (length != 0))
+        {
+            digits[length++] = (unsigned char)('0' + digit);
+        }
+        p2 = grisu_make(p2.high & fraction_mask.high, p2.low & fraction_mask.low);
+        kappa--;
+
+        if (grisu_less(p2, delta))
+        {
+            *decimal_exponent += kappa;
+            /* scale the distance to w to the same unit (mod 2^64) */
+            if (-kappa < 20)
+            {
+                for (i = 0; i < -kappa; i++)
+                {
+                    wp_w = grisu_multiply_10(wp_w);
+                }
+            }
+            else
+            {
+                wp_w = grisu_make(0, 0);
+            }
+            grisu_round(digits, length, delta, p2, one, wp_w);
+            return length;
+        }
+    }
+}
+
+/* shortest digits so that digits * 10^decimal_exponent is read back as number (positive and finite) */
+static int grisu2(const double number, unsigned char * const digits, int * const decimal_exponent)
+{
+    const grisu_fp v = grisu_from_double(number);
+    grisu_fp plus;
+    grisu_fp minus;
+    grisu_fp cached_power;
+    grisu_fp w;
+    double k = 0;
+    int index = 0;
+
+    /* boundaries of the interval that is rounded to number */
+    plus.f = grisu_add(grisu_shift_left(v.f, 1), grisu_make(0, 1));
+    plus.e = v.e - 1;
+    plus = grisu_normalize(plus);
+    if ((v.f.high == 0x00100000UL) && (v.f.low == 0))
+    {
+        /* the next lower double is closer on powers of two */
+        minus.f = grisu_subtract(grisu_shift_left(v.f, 2), grisu_make(0, 1));
+        minus.e = v.e - 2;
+    }
+    else
+    {
+        minus.f = grisu_subtract(grisu_shift_left(v.f, 1), grisu_make(0, 1));
+        minus.e = v.e - 1;
+    }
+    minus.f = grisu_shift_left(minus.f, minus.e - plus.e);
+    minus.e = plus.e;
+
+    /* cached power that brings the exponent of plus into [-60, -32] */
+    k = ((double)(-61 - plus.e) * 0.30102999566398114) + 347;
+    index = (int)k;
+    if ((k - index) > 0.0)
+    {
+        index++;
+    }
+    index = (index >> 3) + 1;
+    *decimal_exponent = -(-348 + (index * 8));
+    cached_power = grisu_cached_powers[index];
+
+    w = grisu_multiply(grisu_normalize(v), cached_power);
+    plus = grisu_multiply(plus, cached_power);
+    minus = grisu_multiply(minus, cached_power);
+    /* stay strictly inside of the interval */
+    minus.f = grisu_add(minus.f, grisu_make(0, 1));
+    plus.f = grisu_subtract(plus.f, grisu_make(0, 1));
+
+    return grisu_generate_digits(w, plus, grisu_subtract(plus.f, minus.f), digits, decimal_exponent);
+}
+
+/* every integer up to 2^53 is exactly representable as a double */
+#define max_exact_integer 9007199254740992.0
+
+/* print the digits of a non-negative integer below 2^53 that is stored in a double */
+static int print_integer_digits(const double integer, unsigned char * const output)
+{
+    /* split into two halves that each fit into an unsigned long */
+    double high = floor(integer / 1e8);
+    double low = integer - (high * 1e8);
+    unsigned long high_part = 0;
+    unsigned long low_part = 0;
+    unsigned char digits[16];
+    int length = 0;
+    int i = 0;
+
+    /* the division might have been rounded up */
+    if (low < 0)
+    {
+        high -= 1;
+        low += 1e8;
+    }
+    high_part = (unsigned long)high;
+    low_part = (unsigned long)low;
+
+    /* the lower half is padded with zeroes to 8 digits when there is an upper half */
+    for (i = 0; (i < 8) && ((i == 0) || (low_part > 0) || (high_part > 0)); i++)
+    {
+        digits[i] = (unsigned char)('0' + (low_part % 10));
+        low_part /= 10;
+    }
+
+    while ((high_part > 0) && (i < (int)sizeof(digits)))
+    {
+        digits[i++] = (unsigned char)('0' + (high_part % 10));
+        high_part /= 10;
+    }
+
+    while (i > 0)
+    {
+        output[length++] = digits[--i];
+    }
+
+    return length;
+}
+
+/* Find the shortest decimal with up to 15 digits that is read back as number (positive and finite), which covers
+ * most numbers in practice (it always finds one between 1e-7 and 1e37 if there is one). The integer digits and the power
+ * of ten are both exact, so their quotient or product is rounded exactly like strtod rounds the decimal, which makes
+ * the comparison an exact round trip check. Returns 0 if there is none, Grisu2 is used then. It is not always the
+ * shortest when a shorter decimal is within a fraction of the rounding boundary, but that is rare. */
+static int shortest_exact_decimal(const double number, unsigned char * const digits, int * const exponent)
+{
+    const int powers = (int)(sizeof(exact_powers_of_ten) / sizeof(exact_powers_of_ten[0]));
+    double candidate = 0;
+    int power = 0;
+
+    if (number < max_exact_integer)
+    {
+        /* as few decimal places as possible */
+        for (power = 0; power < powers; power++)
+        {
+            double scaled = number * exact_powers_of_ten[power];
+            if (scaled >= 1e15)
+            {
+                break;
+            }
+
+            candidate = floor(scaled + 0.5);
+            if ((candidate / exact_powers_of_ten[power]) == number)
+            {
+                *exponent = -power;
+                return print_integer_digits(candidate, digits);
+            }
+        }
+
+        return 0;
+    }
+
+    /* as many trailing zeroes as possible */
+    for (power = powers - 1; power > 0; power--)
+    {
+        candidate = floor((number / exact_powers_of_ten[power]) + 0.5);
+        if (candidate >= 1e15)
+        {
+            break;
+        }
+        if ((candidate > 0) && ((candidate * exact_powers_of_ten[power]) == number))
+        {
+            *exponent = power;
+            return print_integer_digits(candidate, digits);
+        }
+    }
+
+    return 0;
+}
+
+/* Lay out digits * 10^exponent the way "%1.15g" does, or "%1.17g" if more than 15 digits are needed. */
+static int print_decimal(const unsigned char * const digits, int digits_length, int exponent, const cJSON_bool negative, unsigned char * const output)
+{
+    int length = 0;
+    int position = 0;
+    int i = 0;
+
+    /* %g doesn't print trailing zeroes */
+    while ((digits_length > 1) && (digits[digits_length - 1] == '0'))
+    {
+        digits_length--;
+        exponent++;
+    }
+    /* exponent of the first digit */
+    position = digits_length - 1 + exponent;
+
+    if (negative)
+    {
+        output[length++] = '-';
+    }
+
+    if ((position < -4) || (position >= ((digits_length <= 15) ? 15 : 17)))
+    {
+        output[length++] = digits[0];
+        if (digits_length > 1)
+        {
+            output[length++] = '.';
+            memcpy(output + length, digits + 1, (size_t)(digits_length - 1));
+            length += digits_length - 1;
+        }
+
+        output[length++] = 'e';
+        output[length++] = (position < 0) ? '-' : '+';
+        if (position < 0)
+        {
+            position = -position;
+        }
+        /* at least two digits */
+        if (position >= 100)
+        {
+            output[length++] = (unsigned char)('0' + (position / 100));
+        }
+        output[length++] = (unsigned char)('0' + ((position / 10) % 10));
+        output[length++] = (unsigned char)('0' + (position % 10));
+    }
+    else if (position < 0)
+    {
+        output[length++] = '0';
+        output[length++] = '.';
+        for (i = -1; i > position; i--)
+        {
+            output[length++] = '0';
+        }
+        memcpy(output + length, digits, (size_t)digits_length);
+        length += digits_length;
+    }
+    else
+    {
+        for (i = 0; (i < digits_length) || (i <= position); i++)
+        {
+            if (i == (position + 1))
+            {
+                output[length++] = '.';
+            }
+            output[length++] = (i < digits_length) ? digits[i] : (unsigned char)'0';
+        }
+    }
+
+    return length;
+}
+
+/* Render the number nicely from the given item into a string. */
+static cJSON_bool print_number(const cJSON * const item, printbuffer * const output_buffer)
+{
+    unsigned char *output_pointer = NULL;
+    double d = item->valuedouble;
+    int length = 0;
+    int digits_length = 0;
+    int exponent = 0;
+    unsigned char number_buffer[26] = {0}; /* temporary buffer to print the number into */
+    unsigned char digits[18];
+
+    if (output_buffer == NULL)
+    {
+        return false;
+    }
+
+    /* This checks for NaN and Infinity */
+    if (isnan(d) || isinf(d))
+    {
+        length = sprintf((char*)number_buffer, "null");
+    }
+    else if(d == (double)item->valueint)
+    {
+        length = print_int(item->valueint, number_buffer);
+    }
+    else
+    {
+        digits_length = shortest_exact_decimal(fabs(d), digits, &exponent);
+        if (digits_length == 0)
+        {
+            digits_length = grisu2(fabs(d), digits, &exponent);
         }
+        length = print_decimal(digits, digits_length, exponent, d < 0, number_buffer);
+    }
+
+    /* buffer overrun occurred */
+    if ((length < 0) || (length > (int)(sizeof(number_buffer) - 1)))
+    {
+        return false;
+    }
 
-        output_pointer[i] = number_buffer[i];
+    /* reserve appropriate space in the output */
+    output_pointer = ensure(output_buffer, (size_t)length + sizeof(""));
+    if (output_pointer == NULL)
+    {
+        return false;
     }
-    output_pointer[i] = '\0';
+
+    /* the number is printed without the locale, so the decimal point already is '.' */
+    memcpy(output_pointer, number_buffer, (size_t)length);
+    output_pointer[length] = '\0';
 
     output_buffer->offset += (size_t)length;
 
     return true;
 }
 
+/* returned by parse_hex4 for anything but 4 hex digits, valid results are at most 0xFFFF */
+#define INVALID_HEX4 0x10000U
+
 /* parse 4 digit hexadecimal number */
 static unsigned parse_hex4(const unsigned char * const input)
 {
@@ -680,7 +1642,7 @@ static unsigned parse_hex4(const unsigned char * const input)
         }
         else /* invalid */
         {
-            return 0;
+            return INVALID_HEX4;
         }
 
         if (i < 3)
@@ -715,7 +1677,7 @@ static unsigned char utf16_literal_to_utf8(const unsigned char * const input_poi
     first_code = parse_hex4(first_sequence + 2);
 
     /* check that the code is valid */
-    if (((first_code >= 0xDC00) && (first_code <= 0xDFFF)))
+    if ((first_code == INVALID_HEX4) || ((first_code >= 0xDC00) && (first_code <= 0xDFFF)))
     {
         goto fail;
     }
@@ -815,6 +1777,8 @@ fail:
     return 0;
 }
 
+static void* cast_away_const(const void* string);
+
 /* Parse the input text into an unescaped cinput, and populate item. */
 static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_buffer)
 {
@@ -833,32 +1797,42 @@ static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_bu
         /* calculate approximate size of the output (overestimate) */
         size_t allocation_length = 0;
         size_t skipped_bytes = 0;
-        while (((size_t)(input_end - input_buffer->content) < input_buffer->length) && (*input_end != '\"'))
+        for (;;)
         {
+            input_end = input_buffer->content + find_quote_or_backslash(input_buffer->content, (size_t)(input_end - input_buffer->content), input_buffer->length);
+            if (((size_t)(input_end - input_buffer->content) >= input_buffer->length) || (*input_end == '\"'))
+            {
+                break;
+            }
+
             /* is escape sequence */
-            if (input_end[0] == '\\')
+            if ((size_t)(input_end + 1 - input_buffer->content) >= input_buffer->length)
             {
-                if ((size_t)(input_end + 1 - input_buffer->content) >= input_buffer->length)
-                {
-                    /* prevent buffer overflow when last input character is a backslash */
-                    goto fail;
-                }
-                skipped_bytes++;
-                input_end++;
+                /* prevent buffer overflow when last input character is a backslash */
+                goto fail;
             }
-            input_end++;
+            skipped_bytes++;
+            input_end += 2;
         }
         if (((size_t)(input_end - input_buffer->content) >= input_buffer->length) || (*input_end != '\"'))
         {
             goto fail; /* string ended unexpectedly */
         }
 
-        /* This is at most how much we need for the output */
-        allocation_length = (size_t) (input_end - buffer_at_offset(input_buffer)) - skipped_bytes;
-        output = (unsigned char*)input_buffer->hooks.allocate(allocation_length + sizeof(""));
-        if (output == NULL)
+        if (input_buffer->in_situ)
         {
-            goto fail; /* allocation failure */
+            /* unescaping never makes the string longer and the closing quote makes room for the terminator */
+            output = (unsigned char*)cast_away_const(input_pointer);
+        }
+        else
+        {
+            /* This is at most how much we need for the output */
+            allocation_length = (size_t) (input_end - buffer_at_offset(input_buffer)) - skipped_bytes;
+            output = (unsigned char*)hooks_allocate(&input_buffer->hooks, allocation_length + sizeof(""));
+            if (output == NULL)
+            {
+                goto fail; /* allocation failure */
+            }
         }
     }
 
@@ -868,7 +1842,20 @@ static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_bu
     {
         if (*input_pointer != '\\')
         {
-            *output_pointer++ = *input_pointer++;
+            /* copy everything up to the next escape sequence at once, quotes inside are always escaped */
+            size_t run_length = find_quote_or_backslash(input_pointer, 0, (size_t)(input_end - input_pointer));
+            if (run_length == 0)
+            {
+                /* an unescaped quote: an escape sequence was longer than the scan above assumed */
+                goto fail;
+            }
+            if (output_pointer != input_pointer)
+            {
+                /* in situ the output can overlap the input */
+                memmove(output_pointer, input_pointer, run_length);
+            }
+            output_pointer += run_length;
+            input_pointer += run_length;
         }
         /* escape sequence */
         else
@@ -923,6 +1910,11 @@ static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_bu
     *output_pointer = '\0';
 
     item->type = cJSON_String;
+    if (input_buffer->in_situ)
+    {
+        /* the string belongs to the input */
+        item->type |= cJSON_IsReference;
+    }
     item->valuestring = (char*)output;
 
     input_buffer->offset = (size_t) (input_end - input_buffer->content);
@@ -931,9 +1923,9 @@ static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_bu
     return true;
 
 fail:
-    if (output != NULL)
+    if ((output != NULL) && !input_buffer->in_situ)
     {
-        input_buffer->hooks.deallocate(output);
+        hooks_deallocate(&input_buffer->hooks, output);
         output = NULL;
     }
 
@@ -1094,10 +2086,7 @@ static parse_buffer *buffer_skip_whitespace(parse_buffer * const buffer)
         return buffer;
     }
 
-    while (can_access_at_index(buffer, 0) && (buffer_at_offset(buffer)[0] <= 32))
-    {
-       buffer->offset++;
-    }
+    buffer->offset = skip_whitespace_bytes(buffer->content, buffer->offset, buffer->length);
 
     if (buffer->offset == buffer->length)
     {
@@ -1139,14 +2128,15 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return
 }
 
 /* Parse an object - create a new root, and populate. */
-CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated)
+static cJSON *parse(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated, const cJSON_bool in_situ, const internal_hooks * const hooks, error * const parse_error)
 {
-    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0 } };
+    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0, 0 }, 0 };
     cJSON *item = NULL;
+    size_t arena_offset = 0;
 
     /* reset error position */
-    global_error.json = NULL;
-    global_error.position = 0;
+    parse_error->json = NULL;
+    parse_error->position = 0;
 
     if (value == NULL || 0 == buffer_length)
     {
@@ -1156,10 +2146,17 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer
     buffer.content = (const unsigned char*)value;
     buffer.length = buffer_length;
     buffer.offset = 0;
-    buffer.hooks = global_hooks;
+    buffer.hooks = *hooks;
+    buffer.in_situ = in_situ;
 
-    item = cJSON_New_Item(&global_hooks);
-    if (item == NULL) /* memory fail */
+    if (hooks->arena != NULL)
+    {
+        /* remember where this document starts so a failed parse can give the space back */
+        arena_offset = hooks->arena->offset;
+    }
+
+    item = cJSON_New_Item(hooks);
+    if (item == NULL) /* memory fail */
     {
         goto fail;
     }
@@ -1184,12 +2181,22 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer
         *return_parse_end = (const char*)buffer_at_offset(&buffer);
     }
 
+    if (hooks->arena != NULL)
+    {
+        item->type |= cJSON_InArena;
+    }
+
     return item;
 
 fail:
-    if (item != NULL)
+    if (hooks->arena != NULL)
     {
-        cJSON_Delete(item);
+        hooks->arena->offset = arena_offset;
+        hooks->arena->last_offset = arena_offset;
+    }
+    else if (item != NULL)
+    {
+        delete_item(item, hooks);
     }
 
     if (value != NULL)
@@ -1198,35 +2205,534 @@ fail:
         local_error.json = (const unsigned char*)value;
         local_error.position = 0;
 
-        if (buffer.offset < buffer.length)
+        if (buffer.offset < buffer.length)
+        {
+            local_error.position = buffer.offset;
+        }
+        else if (buffer.length > 0)
+        {
+            local_error.position = buffer.length - 1;
+        }
+
+        if (return_parse_end != NULL)
+        {
+            *return_parse_end = (const char*)local_error.json + local_error.position;
+        }
+
+        *parse_error = local_error;
+    }
+
+    return NULL;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated)
+{
+    return parse(value, buffer_length, return_parse_end, require_null_terminated, false, &global_hooks, &global_error);
+}
+
+/* Default options for cJSON_Parse */
+CJSON_PUBLIC(cJSON *) cJSON_Parse(const char *value)
+{
+    return cJSON_ParseWithOpts(value, 0, 0);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithLength(const char *value, size_t buffer_length)
+{
+    return cJSON_ParseWithLengthOpts(value, buffer_length, 0, 0);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseInSitu(char *value, size_t buffer_length)
+{
+    return parse(value, buffer_length, NULL, false, true, &global_hooks, &global_error);
+}
+
+CJSON_PUBLIC(void) cJSON_InitArena(cJSON_Arena *arena, void *buffer, size_t size)
+{
+    size_t misalignment = 0;
+
+    if (arena == NULL)
+    {
+        return;
+    }
+
+    arena->buffer = (unsigned char*)buffer;
+    arena->size = 0;
+    arena->offset = 0;
+    arena->last_offset = 0;
+
+    if (buffer == NULL)
+    {
+        return;
+    }
+
+    /* make sure that the first allocation is aligned too */
+    misalignment = (size_t)buffer % sizeof(arena_alignment);
+    if (misalignment != 0)
+    {
+        misalignment = sizeof(arena_alignment) - misalignment;
+        if (misalignment >= size)
+        {
+            arena->buffer = NULL;
+            return;
+        }
+        arena->buffer += misalignment;
+    }
+    arena->size = size - misalignment;
+}
+
+CJSON_PUBLIC(void) cJSON_ResetArena(cJSON_Arena *arena)
+{
+    if (arena == NULL)
+    {
+        return;
+    }
+
+    arena->offset = 0;
+    arena->last_offset = 0;
+}
+
+CJSON_PUBLIC(size_t) cJSON_GetArenaUsage(const cJSON_Arena *arena)
+{
+    if (arena == NULL)
+    {
+        return 0;
+    }
+
+    return arena->offset;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithArena(const char *value, size_t buffer_length, cJSON_Arena *arena)
+{
+    internal_hooks hooks = global_hooks;
+
+    if ((arena == NULL) || (arena->buffer == NULL))
+    {
+        return NULL;
+    }
+
+    hooks.arena = arena;
+
+    return parse(value, buffer_length, NULL, false, false, &hooks, &global_error);
+}
+
+CJSON_PUBLIC(void) cJSON_InitContext(cJSON_Context *context, const cJSON_Hooks *hooks)
+{
+    if (context == NULL)
+    {
+        return;
+    }
+
+    context->hooks.malloc_fn = NULL;
+    context->hooks.free_fn = NULL;
+    if (hooks != NULL)
+    {
+        context->hooks = *hooks;
+    }
+    context->arena = NULL;
+    context->error = NULL;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_ParseCtx(cJSON_Context *context, const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated)
+{
+    internal_hooks hooks = { NULL, NULL, NULL, NULL };
+    error parse_error = { NULL, 0 };
+    cJSON *item = NULL;
+
+    if (context == NULL)
+    {
+        return NULL;
+    }
+
+    set_hooks(&hooks, &context->hooks);
+    if (context->arena != NULL)
+    {
+        if (context->arena->buffer == NULL)
+        {
+            context->error = value;
+            return NULL;
+        }
+        hooks.arena = context->arena;
+    }
+
+    item = parse(value, buffer_length, return_parse_end, require_null_terminated, false, &hooks, &parse_error);
+    context->error = NULL;
+    if ((item == NULL) && (value != NULL))
+    {
+        context->error = value + parse_error.position;
+    }
+
+    return item;
+}
+
+CJSON_PUBLIC(void) cJSON_DeleteCtx(const cJSON_Context *context, cJSON *item)
+{
+    internal_hooks hooks = { NULL, NULL, NULL, NULL };
+
+    if (context == NULL)
+    {
+        return;
+    }
+
+    set_hooks(&hooks, &context->hooks);
+    delete_item(item, &hooks);
+}
+
+/* what the pull parser expects next */
+#define pull_first_value 0
+#define pull_value 1
+#define pull_value_or_end_array 2
+#define pull_key 3
+#define pull_key_or_end_object 4
+#define pull_colon 5
+#define pull_comma_or_end 6
+#define pull_next_value 7 /* after a complete top level value */
+#define pull_failed 8
+
+struct cJSON_PullParser
+{
+    /* content is the window, length is how much of it is filled and depth the number of open containers */
+    parse_buffer buffer;
+    unsigned char *window;
+    size_t size;
+    /* scratch item that holds the value of the last event */
+    cJSON value;
+    int state;
+    cJSON_bool finished;
+    /* one bit per nesting level, set for objects and cleared for arrays */
+    unsigned char is_object[(CJSON_NESTING_LIMIT + 7) / 8];
+};
+
+CJSON_PUBLIC(cJSON_PullParser *) cJSON_CreatePullParser(size_t buffer_size)
+{
+    cJSON_PullParser *parser = NULL;
+
+    if ((buffer_size == 0) || (buffer_size > ((size_t)-1 - sizeof(cJSON_PullParser))))
+    {
+        return NULL;
+    }
+
+    /* the window directly follows the parser in the same allocation */
+    parser = (cJSON_PullParser*)global_hooks.allocate(sizeof(cJSON_PullParser) + buffer_size);
+    if (parser == NULL)
+    {
+        return NULL;
+    }
+    memset(parser, '\0', sizeof(cJSON_PullParser));
+
+    parser->window = (unsigned char*)(parser + 1);
+    parser->size = buffer_size;
+    parser->buffer.content = parser->window;
+    parser->buffer.hooks = global_hooks;
+    /* the window is ours, so strings can be unescaped where they are */
+    parser->buffer.in_situ = true;
+    parser->state = pull_first_value;
+
+    return parser;
+}
+
+CJSON_PUBLIC(void) cJSON_DeletePullParser(cJSON_PullParser *parser)
+{
+    if (parser != NULL)
+    {
+        parser->buffer.hooks.deallocate(parser);
+    }
+}
+
+CJSON_PUBLIC(size_t) cJSON_PullFeed(cJSON_PullParser *parser, const char *data, size_t length)
+{
+    parse_buffer *buffer = NULL;
+    size_t accepted = 0;
+
+    if ((parser == NULL) || (data == NULL) || parser->finished)
+    {
+        return 0;
+    }
+
+    buffer = &parser->buffer;
+
+    /* drop everything that has already been consumed */
+    if (buffer->offset > 0)
+    {
+        memmove(parser->window, buffer_at_offset(buffer), buffer->length - buffer->offset);
+        buffer->length -= buffer->offset;
+        buffer->offset = 0;
+    }
+
+    accepted = parser->size - buffer->length;
+    if (length < accepted)
+    {
+        accepted = length;
+    }
+    memcpy(parser->window + buffer->length, data, accepted);
+    buffer->length += accepted;
+
+    return accepted;
+}
+
+CJSON_PUBLIC(void) cJSON_PullFinish(cJSON_PullParser *parser)
+{
+    if (parser != NULL)
+    {
+        parser->finished = true;
+    }
+}
+
+/* check if the scalar at the current offset is complete, otherwise it might continue in the next chunk */
+static cJSON_bool pull_token_complete(const cJSON_PullParser * const parser)
+{
+    const parse_buffer * const buffer = &parser->buffer;
+    const unsigned char * const token = buffer_at_offset(buffer);
+    const size_t available = buffer->length - buffer->offset;
+    size_t i = 0;
+
+    if (parser->finished)
+    {
+        /* let the parse functions report incomplete tokens */
+        return true;
+    }
+
+    switch (token[0])
+    {
+        case '\"':
+            for (i = 1; i < available; i++)
+            {
+                if (token[i] == '\\')
+                {
+                    i++;
+                }
+                else if (token[i] == '\"')
+                {
+                    return true;
+                }
+            }
+            return false;
+
+        case 't':
+        case 'n':
+            return available >= static_strlen("true");
+
+        case 'f':
+            return available >= static_strlen("false");
+
+        default:
+            /* numbers end with the first character that can't be part of them */
+            for (i = 0; i < available; i++)
+            {
+                if (((token[i] < '0') || (token[i] > '9')) && (token[i] != '+') && (token[i] != '-')
+                        && (token[i] != 'e') && (token[i] != 'E') && (token[i] != '.'))
+                {
+                    return true;
+                }
+            }
+            return false;
+    }
+}
+
+static int pull_need_more(cJSON_PullParser * const parser)
+{
+    /* the token already fills the whole window, more input can't complete it */
+    if ((parser->buffer.offset == 0) && (parser->buffer.length == parser->size))
+    {
+        parser->state = pull_failed;
+        return cJSON_PullError;
+    }
+
+    return cJSON_PullNeedMore;
+}
+
+static int pull_start_container(cJSON_PullParser * const parser, const cJSON_bool is_object)
+{
+    parse_buffer * const buffer = &parser->buffer;
+    const unsigned char bit = (unsigned char)(1 << (buffer->depth % 8));
+
+    if (buffer->depth >= CJSON_NESTING_LIMIT)
+    {
+        parser->state = pull_failed;
+        return cJSON_PullError; /* too deeply nested */
+    }
+
+    if (is_object)
+    {
+        parser->is_object[buffer->depth / 8] |= bit;
+    }
+    else
+    {
+        parser->is_object[buffer->depth / 8] &= (unsigned char)~bit;
+    }
+    buffer->depth++;
+    buffer->offset++;
+
+    parser->value.type = is_object ? cJSON_Object : cJSON_Array;
+    parser->state = is_object ? pull_key_or_end_object : pull_value_or_end_array;
+
+    return is_object ? cJSON_PullStartObject : cJSON_PullStartArray;
+}
+
+static int pull_end_container(cJSON_PullParser * const parser, const cJSON_bool is_object)
+{
+    parse_buffer * const buffer = &parser->buffer;
+
+    buffer->depth--;
+    buffer->offset++;
+
+    parser->value.type = is_object ? cJSON_Object : cJSON_Array;
+    parser->state = (buffer->depth == 0) ? pull_next_value : pull_comma_or_end;
+
+    return is_object ? cJSON_PullEndObject : cJSON_PullEndArray;
+}
+
+CJSON_PUBLIC(int) cJSON_PullNext(cJSON_PullParser *parser)
+{
+    parse_buffer *buffer = NULL;
+    unsigned char current = '\0';
+    cJSON_bool in_object = false;
+
+    if (parser == NULL)
+    {
+        return cJSON_PullError;
+    }
+
+    buffer = &parser->buffer;
+
+    for (;;)
+    {
+        if (parser->state == pull_failed)
+        {
+            return cJSON_PullError;
+        }
+
+        while ((buffer->offset < buffer->length) && (buffer_at_offset(buffer)[0] <= 32))
+        {
+            buffer->offset++;
+        }
+
+        if (buffer->offset == buffer->length)
+        {
+            if (!parser->finished)
+            {
+                return cJSON_PullNeedMore;
+            }
+            if (parser->state == pull_next_value)
+            {
+                return cJSON_PullEnd;
+            }
+            goto fail; /* input ended unexpectedly */
+        }
+
+        current = buffer_at_offset(buffer)[0];
+        in_object = (buffer->depth > 0) && ((parser->is_object[(buffer->depth - 1) / 8] & (1 << ((buffer->depth - 1) % 8))) != 0);
+        memset(&parser->value, '\0', sizeof(cJSON));
+
+        switch (parser->state)
+        {
+            case pull_colon:
+                if (current != ':')
+                {
+                    goto fail;
+                }
+                buffer->offset++;
+                parser->state = pull_value;
+                continue;
+
+            case pull_comma_or_end:
+                if (current == ',')
+                {
+                    buffer->offset++;
+                    parser->state = in_object ? pull_key : pull_value;
+                    continue;
+                }
+                if (current == (in_object ? '}' : ']'))
+                {
+                    return pull_end_container(parser, in_object);
+                }
+                goto fail;
+
+            case pull_key_or_end_object:
+                if (current == '}')
+                {
+                    return pull_end_container(parser, true);
+                }
+                /* fall through */
+            case pull_key:
+                if (current != '\"')
+                {
+                    goto fail;
+                }
+                if (!pull_token_complete(parser))
+                {
+                    return pull_need_more(parser);
+                }
+                if (!parse_string(&parser->value, buffer))
+                {
+                    goto fail;
+                }
+                parser->state = pull_colon;
+                return cJSON_PullKey;
+
+            case pull_value_or_end_array:
+                if (current == ']')
+                {
+                    return pull_end_container(parser, false);
+                }
+                break;
+
+            default:
+                break;
+        }
+
+        /* everything else expects a value */
+        if ((current == '{') || (current == '['))
         {
-            local_error.position = buffer.offset;
+            return pull_start_container(parser, current == '{');
         }
-        else if (buffer.length > 0)
+        if (!pull_token_complete(parser))
         {
-            local_error.position = buffer.length - 1;
+            return pull_need_more(parser);
         }
-
-        if (return_parse_end != NULL)
+        if (!parse_value(&parser->value, buffer))
         {
-            *return_parse_end = (const char*)local_error.json + local_error.position;
+            goto fail;
         }
+        parser->state = (buffer->depth == 0) ? pull_next_value : pull_comma_or_end;
 
-        global_error = local_error;
+        switch (parser->value.type & 0xFF)
+        {
+            case cJSON_String:
+                return cJSON_PullString;
+            case cJSON_Number:
+                return cJSON_PullNumber;
+            case cJSON_True:
+                return cJSON_PullTrue;
+            case cJSON_False:
+                return cJSON_PullFalse;
+            default:
+                return cJSON_PullNull;
+        }
     }
 
-    return NULL;
+fail:
+    parser->state = pull_failed;
+    return cJSON_PullError;
 }
 
-/* Default options for cJSON_Parse */
-CJSON_PUBLIC(cJSON *) cJSON_Parse(const char *value)
+CJSON_PUBLIC(const cJSON *) cJSON_PullGetValue(const cJSON_PullParser *parser)
 {
-    return cJSON_ParseWithOpts(value, 0, 0);
+    if (parser == NULL)
+    {
+        return NULL;
+    }
+
+    return &parser->value;
 }
 
-CJSON_PUBLIC(cJSON *) cJSON_ParseWithLength(const char *value, size_t buffer_length)
+CJSON_PUBLIC(size_t) cJSON_PullGetDepth(const cJSON_PullParser *parser)
 {
-    return cJSON_ParseWithLengthOpts(value, buffer_length, 0, 0);
+    if (parser == NULL)
+    {
+        return 0;
+    }
+
+    return parser->buffer.depth;
 }
 
 #define cjson_min(a, b) (((a) < (b)) ? (a) : (b))
@@ -1311,7 +2817,7 @@ CJSON_PUBLIC(char *) cJSON_PrintUnformatted(const cJSON *item)
 
 CJSON_PUBLIC(char *) cJSON_PrintBuffered(const cJSON *item, int prebuffer, cJSON_bool fmt)
 {
-    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0 } };
+    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0, 0 }, 0, 0 };
 
     if (prebuffer < 0)
     {
@@ -1342,7 +2848,7 @@ CJSON_PUBLIC(char *) cJSON_PrintBuffered(const cJSON *item, int prebuffer, cJSON
 
 CJSON_PUBLIC(cJSON_bool) cJSON_PrintPreallocated(cJSON *item, char *buffer, const int length, const cJSON_bool format)
 {
-    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0 } };
+    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0, 0 }, 0, 0 };
 
     if ((length < 0) || (buffer == NULL))
     {
@@ -1359,6 +2865,115 @@ CJSON_PUBLIC(cJSON_bool) cJSON_PrintPreallocated(cJSON *item, char *buffer, cons
     return print_value(item, &p);
 }
 
+CJSON_PUBLIC(cJSON_bool) cJSON_PrintToBuffer(const cJSON *item, char *buffer, size_t length, cJSON_bool format)
+{
+    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0, 0 }, 0, 0 };
+
+    if ((item == NULL) || (buffer == NULL) || (length == 0) || (length == (size_t)-1))
+    {
+        return false;
+    }
+
+    /* ensure keeps one byte spare after what is asked for, but everything that is printed asks for all
+     * it writes including the terminator, so pretending to have one more byte makes an exact length enough */
+    p.buffer = (unsigned char*)buffer;
+    p.length = length + 1;
+    p.offset = 0;
+    p.noalloc = true;
+    p.format = format;
+    p.hooks = global_hooks;
+
+    return print_value(item, &p);
+}
+
+/* print item and hand everything that is left in the buffer to the sink */
+static cJSON_bool print_to_sink(const cJSON * const item, printbuffer * const p)
+{
+    if (!print_value(item, p))
+    {
+        return false;
+    }
+    update_offset(p);
+
+    return (p->offset == 0) || p->sink(p->sink_context, (const char*)p->buffer, p->offset);
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_PrintToSink(const cJSON *item, cJSON_bool format, size_t chunk_size, cJSON_PrintSink sink, void *context)
+{
+    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0, 0 }, 0, 0 };
+    cJSON_bool success = false;
+
+    if ((item == NULL) || (sink == NULL) || (chunk_size == 0) || (chunk_size > INT_MAX))
+    {
+        return false;
+    }
+
+    p.buffer = (unsigned char*)global_hooks.allocate(chunk_size);
+    if (p.buffer == NULL)
+    {
+        return false;
+    }
+    p.length = chunk_size;
+    p.offset = 0;
+    p.noalloc = false;
+    p.format = format;
+    p.hooks = global_hooks;
+    p.sink = sink;
+    p.sink_context = context;
+
+    success = print_to_sink(item, &p);
+
+    /* ensure frees the buffer if growing it fails */
+    if (p.buffer != NULL)
+    {
+        global_hooks.deallocate(p.buffer);
+    }
+
+    return success;
+}
+
+static cJSON_bool CJSON_CDECL count_printed(void *context, const char *data, size_t length)
+{
+    (void)data;
+    *(size_t*)context += length;
+
+    return true;
+}
+
+CJSON_PUBLIC(size_t) cJSON_PrintedLength(const cJSON *item, cJSON_bool format)
+{
+    unsigned char chunk[256];
+    printbuffer p = { 0, 0, 0, 0, 0, 0, { 0, 0, 0, 0 }, 0, 0 };
+    size_t length = 0;
+
+    if (item == NULL)
+    {
+        return 0;
+    }
+
+    /* count in a chunk on the stack first, that is enough unless there are very long strings */
+    p.buffer = chunk;
+    p.length = sizeof(chunk);
+    p.offset = 0;
+    p.noalloc = true;
+    p.format = format;
+    p.hooks = global_hooks;
+    p.sink = count_printed;
+    p.sink_context = &length;
+    if (print_to_sink(item, &p))
+    {
+        return length;
+    }
+
+    length = 0;
+    if (!cJSON_PrintToSink(item, format, sizeof(chunk), count_printed, &length))
+    {
+        return 0;
+    }
+
+    return length;
+}
+
 /* Parser core - when encountering text, process appropriately. */
 static cJSON_bool parse_value(cJSON * const item, parse_buffer * const input_buffer)
 {
@@ -1554,6 +3169,10 @@ static cJSON_bool parse_array(cJSON * const item, parse_buffer * const input_buf
         {
             goto fail; /* failed to parse value */
         }
+        if (input_buffer->hooks.arena != NULL)
+        {
+            current_item->type |= cJSON_InArena;
+        }
         buffer_skip_whitespace(input_buffer);
     }
     while (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ','));
@@ -1578,9 +3197,10 @@ success:
     return true;
 
 fail:
-    if (head != NULL)
+    /* arena items are given back all at once by the caller */
+    if ((head != NULL) && (input_buffer->hooks.arena == NULL))
     {
-        cJSON_Delete(head);
+        delete_item(head, &input_buffer->hooks);
     }
 
     return false;
@@ -1722,6 +3342,11 @@ static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_bu
         /* swap valuestring and string, because we parsed the name */
         current_item->string = current_item->valuestring;
         current_item->valuestring = NULL;
+        if (input_buffer->in_situ)
+        {
+            /* the name belongs to the input */
+            current_item->type = cJSON_StringIsConst;
+        }
 
         if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != ':'))
         {
@@ -1735,6 +3360,15 @@ static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_bu
         {
             goto fail; /* failed to parse value */
         }
+        if (input_buffer->hooks.arena != NULL)
+        {
+            /* the key isn't owned by the item, it goes away with the arena */
+            current_item->type |= cJSON_InArena | cJSON_StringIsConst;
+        }
+        else if (input_buffer->in_situ)
+        {
+            current_item->type |= cJSON_StringIsConst;
+        }
         buffer_skip_whitespace(input_buffer);
     }
     while (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ','));
@@ -1758,9 +3392,10 @@ success:
     return true;
 
 fail:
-    if (head != NULL)
+    /* arena items are given back all at once by the caller */
+    if ((head != NULL) && (input_buffer->hooks.arena == NULL))
     {
-        cJSON_Delete(head);
+        delete_item(head, &input_buffer->hooks);
     }
 
     return false;
@@ -1850,87 +3485,343 @@ static cJSON_bool print_object(const cJSON * const item, printbuffer * const out
             *output_pointer++ = ',';
         }
 
-        if (output_buffer->format)
-        {
-            *output_pointer++ = '\n';
-        }
-        *output_pointer = '\0';
-        output_buffer->offset += length;
+        if (output_buffer->format)
+        {
+            *output_pointer++ = '\n';
+        }
+        *output_pointer = '\0';
+        output_buffer->offset += length;
+
+        current_item = current_item->next;
+    }
+
+    output_pointer = ensure(output_buffer, output_buffer->format ? (output_buffer->depth + 1) : 2);
+    if (output_pointer == NULL)
+    {
+        return false;
+    }
+    if (output_buffer->format)
+    {
+        size_t i;
+        for (i = 0; i < (output_buffer->depth - 1); i++)
+        {
+            *output_pointer++ = '\t';
+        }
+    }
+    *output_pointer++ = '}';
+    *output_pointer = '\0';
+    output_buffer->depth--;
+
+    return true;
+}
+
+/* Get Array size/item / object item. */
+CJSON_PUBLIC(int) cJSON_GetArraySize(const cJSON *array)
+{
+    cJSON *child = NULL;
+    size_t size = 0;
+
+    if (array == NULL)
+    {
+        return 0;
+    }
+
+    child = array->child;
+
+    while(child != NULL)
+    {
+        size++;
+        child = child->next;
+    }
+
+    /* FIXME: Can overflow here. Cannot be fixed without breaking the API */
+
+    return (int)size;
+}
+
+static cJSON* get_array_item(const cJSON *array, size_t index)
+{
+    cJSON *current_child = NULL;
+
+    if (array == NULL)
+    {
+        return NULL;
+    }
+
+    current_child = array->child;
+    while ((current_child != NULL) && (index > 0))
+    {
+        index--;
+        current_child = current_child->next;
+    }
+
+    return current_child;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_GetArrayItem(const cJSON *array, int index)
+{
+    if (index < 0)
+    {
+        return NULL;
+    }
+
+    return get_array_item(array, (size_t)index);
+}
+
+/* Hash index of the keys of an object, see cJSON_EnableObjectIndex.
+ * Open addressing with linear probing, keys are hashed case insensitively so that both lookup variants can use it.
+ * Items are inserted in list order and removal shifts entries back instead of leaving tombstones,
+ * so among equal keys the probe sequence always finds the first one in the list, just like the linear scan. */
+typedef struct
+{
+    cJSON *item; /* NULL marks an empty slot */
+    size_t hash;
+} object_index_slot;
+
+/* Objects don't use valuestring, so an object with cJSON_IsIndexed set keeps its index there */
+typedef struct
+{
+    object_index_slot *slots;
+    size_t capacity; /* power of two, 0 until the index is built */
+    size_t count;
+} object_index;
+
+static size_t hash_key(const unsigned char *key)
+{
+    /* FNV-1a */
+    size_t hash = (size_t)2166136261U;
+    for (; *key != '\0'; key++)
+    {
+        hash ^= (size_t)tolower(*key);
+        hash *= (size_t)16777619U;
+    }
+
+    return hash;
+}
+
+static object_index *find_object_index(const cJSON * const object)
+{
+    if (!(object->type & cJSON_IsIndexed))
+    {
+        return NULL;
+    }
+
+    return (object_index*)(void*)object->valuestring;
+}
+
+/* forget the contents of the index, it is rebuilt on the next lookup */
+static void invalidate_object_index(object_index * const index)
+{
+    if (index->slots != NULL)
+    {
+        global_hooks.deallocate(index->slots);
+    }
+    index->slots = NULL;
+    index->capacity = 0;
+    index->count = 0;
+}
+
+static void object_index_insert_slot(object_index * const index, cJSON * const item, const size_t hash)
+{
+    size_t position = hash & (index->capacity - 1);
+    while (index->slots[position].item != NULL)
+    {
+        position = (position + 1) & (index->capacity - 1);
+    }
+
+    index->slots[position].item = item;
+    index->slots[position].hash = hash;
+    index->count++;
+}
+
+static cJSON_bool build_object_index(const cJSON * const object, object_index * const index)
+{
+    cJSON *child = NULL;
+    size_t count = 0;
+    size_t capacity = 8;
+
+    for (child = object->child; child != NULL; child = child->next)
+    {
+        count++;
+    }
+    /* keep the load factor at 50% at most */
+    while (capacity < (count * 2))
+    {
+        capacity *= 2;
+    }
+
+    index->slots = (object_index_slot*)global_hooks.allocate(capacity * sizeof(object_index_slot));
+    if (index->slots == NULL)
+    {
+        return false;
+    }
+    memset(index->slots, '\0', capacity * sizeof(object_index_slot));
+    index->capacity = capacity;
+    index->count = 0;
+
+    for (child = object->child; child != NULL; child = child->next)
+    {
+        if (child->string != NULL)
+        {
+            object_index_insert_slot(index, child, hash_key((const unsigned char*)child->string));
+        }
+    }
+
+    return true;
+}
+
+static cJSON_bool object_index_find_slot(const object_index * const index, const cJSON * const item, size_t *position)
+{
+    *position = hash_key((const unsigned char*)item->string) & (index->capacity - 1);
+    while (index->slots[*position].item != NULL)
+    {
+        if (index->slots[*position].item == item)
+        {
+            return true;
+        }
+        *position = (*position + 1) & (index->capacity - 1);
+    }
+
+    return false;
+}
+
+/* called after item was appended to object */
+static void object_index_added(const cJSON * const object, cJSON * const item)
+{
+    object_index *index = find_object_index(object);
+    if ((index == NULL) || (index->capacity == 0) || (item->string == NULL))
+    {
+        return;
+    }
+
+    if (((index->count + 1) * 2) > index->capacity)
+    {
+        invalidate_object_index(index);
+        return;
+    }
+
+    object_index_insert_slot(index, item, hash_key((const unsigned char*)item->string));
+}
 
-        current_item = current_item->next;
+/* called before item is unlinked from object */
+static void object_index_removed(const cJSON * const object, const cJSON * const item)
+{
+    object_index *index = find_object_index(object);
+    size_t position = 0;
+    size_t next = 0;
+
+    if ((index == NULL) || (index->capacity == 0) || (item->string == NULL))
+    {
+        return;
     }
 
-    output_pointer = ensure(output_buffer, output_buffer->format ? (output_buffer->depth + 1) : 2);
-    if (output_pointer == NULL)
+    if (!object_index_find_slot(index, item, &position))
     {
-        return false;
+        return;
     }
-    if (output_buffer->format)
+
+    /* shift the following entries of the cluster back if that doesn't move them in front of their home slot */
+    next = (position + 1) & (index->capacity - 1);
+    while (index->slots[next].item != NULL)
     {
-        size_t i;
-        for (i = 0; i < (output_buffer->depth - 1); i++)
+        size_t home = index->slots[next].hash & (index->capacity - 1);
+        if (((next - home) & (index->capacity - 1)) >= ((next - position) & (index->capacity - 1)))
         {
-            *output_pointer++ = '\t';
+            index->slots[position] = index->slots[next];
+            position = next;
         }
+        next = (next + 1) & (index->capacity - 1);
     }
-    *output_pointer++ = '}';
-    *output_pointer = '\0';
-    output_buffer->depth--;
-
-    return true;
+    index->slots[position].item = NULL;
+    index->count--;
 }
 
-/* Get Array size/item / object item. */
-CJSON_PUBLIC(int) cJSON_GetArraySize(const cJSON *array)
+/* called when replacement takes the place of item in object */
+static void object_index_replaced(const cJSON * const object, const cJSON * const item, cJSON * const replacement)
 {
-    cJSON *child = NULL;
-    size_t size = 0;
+    object_index *index = find_object_index(object);
+    size_t position = 0;
 
-    if (array == NULL)
+    if ((index == NULL) || (index->capacity == 0))
     {
-        return 0;
+        return;
     }
 
-    child = array->child;
-
-    while(child != NULL)
+    if ((item->string == NULL) || (replacement->string == NULL)
+        || (case_insensitive_strcmp((const unsigned char*)item->string, (const unsigned char*)replacement->string) != 0)
+        || !object_index_find_slot(index, item, &position))
     {
-        size++;
-        child = child->next;
+        /* the replacement hashes differently, so it would end up in the wrong order among equal keys */
+        invalidate_object_index(index);
+        return;
     }
 
-    /* FIXME: Can overflow here. Cannot be fixed without breaking the API */
+    index->slots[position].item = replacement;
+}
 
-    return (int)size;
+static void delete_object_index(cJSON * const object)
+{
+    object_index *index = find_object_index(object);
+    if (index != NULL)
+    {
+        invalidate_object_index(index);
+        global_hooks.deallocate(index);
+    }
+    object->valuestring = NULL;
+    object->type &= ~cJSON_IsIndexed;
 }
 
-static cJSON* get_array_item(const cJSON *array, size_t index)
+CJSON_PUBLIC(cJSON_bool) cJSON_EnableObjectIndex(cJSON *object)
 {
-    cJSON *current_child = NULL;
+    object_index *index = NULL;
 
-    if (array == NULL)
+    if (!cJSON_IsObject(object))
     {
-        return NULL;
+        return false;
     }
 
-    current_child = array->child;
-    while ((current_child != NULL) && (index > 0))
+    if (object->type & cJSON_IsIndexed)
     {
-        index--;
-        current_child = current_child->next;
+        return true;
     }
 
-    return current_child;
+    index = (object_index*)global_hooks.allocate(sizeof(object_index));
+    if (index == NULL)
+    {
+        return false;
+    }
+    memset(index, '\0', sizeof(object_index));
+
+    object->valuestring = (char*)(void*)index;
+    object->type |= cJSON_IsIndexed;
+
+    return true;
 }
 
-CJSON_PUBLIC(cJSON *) cJSON_GetArrayItem(const cJSON *array, int index)
+CJSON_PUBLIC(void) cJSON_DisableObjectIndex(cJSON *object)
 {
-    if (index < 0)
+    if ((object == NULL) || !(object->type & cJSON_IsIndexed))
     {
-        return NULL;
+        return;
     }
 
-    return get_array_item(array, (size_t)index);
+    delete_object_index(object);
+}
+
+static cJSON *get_indexed_object_item(const object_index * const index, const char * const name, const cJSON_bool case_sensitive)
+{
+    size_t position = hash_key((const unsigned char*)name) & (index->capacity - 1);
+    while (index->slots[position].item != NULL)
+    {
+        cJSON *candidate = index->slots[position].item;
+        if (case_sensitive ? (strcmp(name, candidate->string) == 0) : (case_insensitive_strcmp((const unsigned char*)name, (const unsigned char*)candidate->string) == 0))
+        {
+            return candidate;
+        }
+        position = (position + 1) & (index->capacity - 1);
+    }
+
+    return NULL;
 }
 
 static cJSON *get_object_item(const cJSON * const object, const char * const name, const cJSON_bool case_sensitive)
@@ -1942,6 +3833,16 @@ static cJSON *get_object_item(const cJSON * const object, const char * const nam
         return NULL;
     }
 
+    if (object->type & cJSON_IsIndexed)
+    {
+        object_index *index = find_object_index(object);
+        if ((index != NULL) && ((index->capacity != 0) || build_object_index(object, index)))
+        {
+            return get_indexed_object_item(index, name, case_sensitive);
+        }
+        /* fall back to a linear scan if the index couldn't be built */
+    }
+
     current_element = object->child;
     if (case_sensitive)
     {
@@ -1980,6 +3881,183 @@ CJSON_PUBLIC(cJSON_bool) cJSON_HasObjectItem(const cJSON *object, const char *st
     return cJSON_GetObjectItem(object, string) ? 1 : 0;
 }
 
+/* A schema is a hash table of its keys (open addressing with linear probing like the object index),
+ * so matching an object costs one hash and usually one strcmp per member. Small schemas skip the hashing. */
+typedef struct
+{
+    size_t hash;
+    size_t field; /* index of the field + 1, 0 marks an empty slot */
+} schema_slot;
+
+struct cJSON_Schema
+{
+    const cJSON_SchemaField *fields;
+    size_t count;
+    size_t capacity; /* power of two, at least twice the count */
+    schema_slot *slots; /* allocated together with the schema */
+};
+
+/* up to this many fields are matched by comparing the keys one by one */
+#define max_linear_schema 8
+
+/* keys are compared case sensitively here, so hash them as they are (FNV-1a) */
+static size_t hash_schema_key(const unsigned char *key)
+{
+    size_t hash = (size_t)2166136261U;
+    for (; *key != '\0'; key++)
+    {
+        hash ^= (size_t)*key;
+        hash *= (size_t)16777619U;
+    }
+
+    return hash;
+}
+
+static size_t find_schema_slot(const cJSON_Schema * const schema, const char * const key, const size_t hash)
+{
+    size_t position = hash & (schema->capacity - 1);
+    while (schema->slots[position].field != 0)
+    {
+        const schema_slot *slot = &schema->slots[position];
+        if ((slot->hash == hash) && (strcmp(schema->fields[slot->field - 1].key, key) == 0))
+        {
+            break;
+        }
+        position = (position + 1) & (schema->capacity - 1);
+    }
+
+    return position;
+}
+
+CJSON_PUBLIC(cJSON_Schema *) cJSON_CreateSchema(const cJSON_SchemaField *fields, size_t count)
+{
+    cJSON_Schema *schema = NULL;
+    size_t capacity = 4;
+    size_t i = 0;
+
+    if ((fields == NULL) || (count > ((size_t)-1 / (4 * sizeof(schema_slot)))))
+    {
+        return NULL;
+    }
+
+    while (capacity < (2 * count))
+    {
+        capacity *= 2;
+    }
+
+    schema = (cJSON_Schema*)global_hooks.allocate(sizeof(cJSON_Schema) + (capacity * sizeof(schema_slot)));
+    if (schema == NULL)
+    {
+        return NULL;
+    }
+    schema->fields = fields;
+    schema->count = count;
+    schema->capacity = capacity;
+    schema->slots = (schema_slot*)(void*)(schema + 1);
+    memset(schema->slots, 0, capacity * sizeof(schema_slot));
+
+    for (i = 0; i < count; i++)
+    {
+        size_t hash = 0;
+        size_t position = 0;
+
+        if (fields[i].key == NULL)
+        {
+            goto fail;
+        }
+        hash = hash_schema_key((const unsigned char*)fields[i].key);
+        position = find_schema_slot(schema, fields[i].key, hash);
+        if (schema->slots[position].field != 0)
+        {
+            goto fail; /* duplicate key */
+        }
+        schema->slots[position].hash = hash;
+        schema->slots[position].field = i + 1;
+    }
+
+    return schema;
+
+fail:
+    global_hooks.deallocate(schema);
+
+    return NULL;
+}
+
+CJSON_PUBLIC(void) cJSON_DeleteSchema(cJSON_Schema *schema)
+{
+    if (schema != NULL)
+    {
+        global_hooks.deallocate(schema);
+    }
+}
+
+CJSON_PUBLIC(int) cJSON_MatchSchema(const cJSON_Schema *schema, const cJSON *object, const cJSON **slots, size_t *error_field)
+{
+    const cJSON *member = NULL;
+    size_t i = 0;
+
+    if ((schema == NULL) || (slots == NULL) || !cJSON_IsObject(object))
+    {
+        return cJSON_SchemaNotObject;
+    }
+
+    for (i = 0; i < schema->count; i++)
+    {
+        slots[i] = NULL;
+    }
+
+    for (member = object->child; member != NULL; member = member->next)
+    {
+        size_t field = 0;
+
+        if (member->string == NULL)
+        {
+            continue;
+        }
+        if (schema->count <= max_linear_schema)
+        {
+            /* comparing a few keys is cheaper than hashing */
+            for (field = 0; (field < schema->count) && (strcmp(schema->fields[field].key, member->string) != 0); field++)
+            {
+            }
+            field = (field < schema->count) ? (field + 1) : 0;
+        }
+        else
+        {
+            field = schema->slots[find_schema_slot(schema, member->string, hash_schema_key((const unsigned char*)member->string))].field;
+        }
+        if ((field == 0) || (slots[field - 1] != NULL))
+        {
+            continue; /* unknown or repeated key */
+        }
+        field--;
+
+        if ((schema->fields[field].types != 0) && ((member->type & 0xFF & schema->fields[field].types) == 0))
+        {
+            if (error_field != NULL)
+            {
+                *error_field = field;
+            }
+            return cJSON_SchemaWrongType;
+        }
+        slots[field] = member;
+    }
+
+    for (i = 0; i < schema->count; i++)
+    {
+        if (schema->fields[i].required && (slots[i] == NULL))
+        {
+            if (error_field != NULL)
+            {
+                *error_field = i;
+            }
+            return cJSON_SchemaMissing;
+        }
+    }
+
+    return cJSON_SchemaOk;
+}
+
 /* Utility for array list handling. */
 static void suffix_object(cJSON *prev, cJSON *item)
 {
@@ -2005,6 +4083,12 @@ static cJSON *create_reference(const cJSON *item, const internal_hooks * const h
     memcpy(reference, item, sizeof(cJSON));
     reference->string = NULL;
     reference->type |= cJSON_IsReference;
+    if (item->type & cJSON_IsIndexed)
+    {
+        /* the index stays with the original */
+        reference->valuestring = NULL;
+    }
+    reference->type &= ~(cJSON_InArena | cJSON_IsIndexed);
     reference->next = reference->prev = NULL;
     return reference;
 }
@@ -2039,6 +4123,11 @@ static cJSON_bool add_item_to_array(cJSON *array, cJSON *item)
         }
     }
 
+    if (array->type & cJSON_IsIndexed)
+    {
+        object_index_added(array, item);
+    }
+
     return true;
 }
 
@@ -2112,6 +4201,33 @@ CJSON_PUBLIC(cJSON_bool) cJSON_AddItemToObjectCS(cJSON *object, const char *stri
     return add_item_to_object(object, string, item, &global_hooks, true);
 }
 
+CJSON_PUBLIC(cJSON_bool) cJSON_AddItemToObjectInArena(cJSON_Arena *arena, cJSON *object, const char *string, cJSON *item)
+{
+    internal_hooks hooks = global_hooks;
+    char *key = NULL;
+
+    if ((arena == NULL) || (string == NULL))
+    {
+        return false;
+    }
+
+    hooks.arena = arena;
+    key = (char*)cJSON_strdup((const unsigned char*)string, &hooks);
+    if (key == NULL)
+    {
+        return false;
+    }
+
+    /* the key lives as long as the arena, so it can be treated like a constant */
+    if (!add_item_to_object(object, key, item, &global_hooks, true))
+    {
+        arena_deallocate(arena, key);
+        return false;
+    }
+
+    return true;
+}
+
 CJSON_PUBLIC(cJSON_bool) cJSON_AddItemReferenceToArray(cJSON *array, cJSON *item)
 {
     if (array == NULL)
@@ -2247,6 +4363,11 @@ CJSON_PUBLIC(cJSON *) cJSON_DetachItemViaPointer(cJSON *parent, cJSON * const it
         return NULL;
     }
 
+    if (parent->type & cJSON_IsIndexed)
+    {
+        object_index_removed(parent, item);
+    }
+
     if (item != parent->child)
     {
         /* not the first element */
@@ -2336,6 +4457,16 @@ CJSON_PUBLIC(cJSON_bool) cJSON_InsertItemInArray(cJSON *array, int which, cJSON
         return false;
     }
 
+    if (array->type & cJSON_IsIndexed)
+    {
+        /* the new item isn't the last one, so rebuild to keep equal keys in list order */
+        object_index *index = find_object_index(array);
+        if (index != NULL)
+        {
+            invalidate_object_index(index);
+        }
+    }
+
     newitem->next = after_inserted;
     newitem->prev = after_inserted->prev;
     after_inserted->prev = newitem;
@@ -2362,6 +4493,11 @@ CJSON_PUBLIC(cJSON_bool) cJSON_ReplaceItemViaPointer(cJSON * const parent, cJSON
         return true;
     }
 
+    if (parent->type & cJSON_IsIndexed)
+    {
+        object_index_replaced(parent, item, replacement);
+    }
+
     replacement->next = item->next;
     replacement->prev = item->prev;
 
@@ -2504,6 +4640,11 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateNumber(double num)
         {
             item->valueint = INT_MIN;
         }
+        else if (num != num)
+        {
+            /* NaN has no integer value */
+            item->valueint = 0;
+        }
         else
         {
             item->valueint = (int)num;
@@ -2602,6 +4743,69 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateObject(void)
     return item;
 }
 
+/* Create items inside an arena: */
+static cJSON *create_arena_item(cJSON_Arena * const arena, const int type)
+{
+    cJSON *item = (cJSON*)arena_allocate(arena, sizeof(cJSON));
+    if (item != NULL)
+    {
+        memset(item, '\0', sizeof(cJSON));
+        item->type = type | cJSON_InArena;
+    }
+
+    return item;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_CreateNullInArena(cJSON_Arena *arena)
+{
+    return create_arena_item(arena, cJSON_NULL);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_CreateBoolInArena(cJSON_Arena *arena, cJSON_bool boolean)
+{
+    return create_arena_item(arena, boolean ? cJSON_True : cJSON_False);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_CreateNumberInArena(cJSON_Arena *arena, double num)
+{
+    cJSON *item = create_arena_item(arena, cJSON_Number);
+    if (item != NULL)
+    {
+        cJSON_SetNumberHelper(item, num);
+    }
+
+    return item;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_CreateStringInArena(cJSON_Arena *arena, const char *string)
+{
+    cJSON *item = create_arena_item(arena, cJSON_String);
+    internal_hooks hooks = global_hooks;
+
+    if (item != NULL)
+    {
+        hooks.arena = arena;
+        item->valuestring = (char*)cJSON_strdup((const unsigned char*)string, &hooks);
+        if (item->valuestring == NULL)
+        {
+            arena_deallocate(arena, item);
+            return NULL;
+        }
+    }
+
+    return item;
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_CreateArrayInArena(cJSON_Arena *arena)
+{
+    return create_arena_item(arena, cJSON_Array);
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_CreateObjectInArena(cJSON_Arena *arena)
+{
+    return create_arena_item(arena, cJSON_Object);
+}
+
 /* Create Arrays: */
 CJSON_PUBLIC(cJSON *) cJSON_CreateIntArray(const int *numbers, int count)
 {
@@ -2789,11 +4993,11 @@ cJSON * cJSON_Duplicate_rec(const cJSON *item, size_t depth, cJSON_bool recurse)
     {
         goto fail;
     }
-    /* Copy over all vars */
-    newitem->type = item->type & (~cJSON_IsReference);
+    /* Copy over all vars, the copy doesn't live in the arena of the original */
+    newitem->type = item->type & (~(cJSON_IsReference | cJSON_InArena | cJSON_IsIndexed));
     newitem->valueint = item->valueint;
     newitem->valuedouble = item->valuedouble;
-    if (item->valuestring)
+    if (item->valuestring && !(item->type & cJSON_IsIndexed))
     {
         newitem->valuestring = (char*)cJSON_strdup((unsigned char*)item->valuestring, &global_hooks);
         if (!newitem->valuestring)
@@ -2803,7 +5007,16 @@ cJSON * cJSON_Duplicate_rec(const cJSON *item, size_t depth, cJSON_bool recurse)
     }
     if (item->string)
     {
-        newitem->string = (item->type&cJSON_StringIsConst) ? item->string : (char*)cJSON_strdup((unsigned char*)item->string, &global_hooks);
+        if ((item->type & cJSON_StringIsConst) && !(item->type & cJSON_InArena))
+        {
+            newitem->string = item->string;
+        }
+        else
+        {
+            /* keys of arena items go away with the arena, so they are always copied */
+            newitem->string = (char*)cJSON_strdup((unsigned char*)item->string, &global_hooks);
+            newitem->type &= ~cJSON_StringIsConst;
+        }
         if (!newitem->string)
         {
             goto fail;
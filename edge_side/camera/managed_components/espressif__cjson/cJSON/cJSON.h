@@ -98,6 +98,8 @@ then using the CJSON_API_VISIBILITY flag to "export" the same symbols the way CJ
 
 #define cJSON_IsReference 256
 #define cJSON_StringIsConst 512
+#define cJSON_InArena 1024 /* item lives in a cJSON_Arena and is released by cJSON_ResetArena */
+#define cJSON_IsIndexed 2048 /* object has a hash index for its keys, see cJSON_EnableObjectIndex */
 
 /* The cJSON structure: */
 typedef struct cJSON
@@ -131,12 +133,70 @@ typedef struct cJSON_Hooks
 
 typedef int cJSON_bool;
 
+/* Receives printed JSON piece by piece (not null terminated), return 0 to stop printing. */
+typedef cJSON_bool (CJSON_CDECL *cJSON_PrintSink)(void *context, const char *data, size_t length);
+
+/* A caller-provided block of memory that items and strings can be bump-allocated from.
+ * Everything allocated from an arena is released at once with cJSON_ResetArena, cJSON_Delete does not free it.
+ * Treat the members as private, they are only exposed so that an arena can live on the stack. */
+typedef struct cJSON_Arena
+{
+    unsigned char *buffer;
+    size_t size;
+    size_t offset;
+    /* start of the most recent allocation, so that it can be handed back */
+    size_t last_offset;
+} cJSON_Arena;
+
+/* Per-call state for cJSON_ParseCtx, so that threads don't share the hooks or the error position.
+ * Initialize it with cJSON_InitContext, one context must not be used by several threads at the same time. */
+typedef struct cJSON_Context
+{
+    cJSON_Hooks hooks; /* NULL functions mean malloc and free */
+    cJSON_Arena *arena; /* if set, documents are parsed into this arena like with cJSON_ParseWithArena */
+    const char *error; /* where the last cJSON_ParseCtx failed (like cJSON_GetErrorPtr), NULL after a success */
+} cJSON_Context;
+
 /* Limits how deeply nested arrays/objects can be before cJSON rejects to parse them.
  * This is to prevent stack overflows. */
 #ifndef CJSON_NESTING_LIMIT
 #define CJSON_NESTING_LIMIT 1000
 #endif
 
+/* State of an incremental pull parser, see cJSON_CreatePullParser. */
+typedef struct cJSON_PullParser cJSON_PullParser;
+
+/* Events returned by cJSON_PullNext */
+#define cJSON_PullNeedMore    0 /* feed more input (or call cJSON_PullFinish) and try again */
+#define cJSON_PullError       1
+#define cJSON_PullEnd         2 /* all input has been consumed */
+#define cJSON_PullStartObject 3
+#define cJSON_PullEndObject   4
+#define cJSON_PullStartArray  5
+#define cJSON_PullEndArray    6
+#define cJSON_PullKey         7
+#define cJSON_PullString      8
+#define cJSON_PullNumber      9
+#define cJSON_PullTrue        10
+#define cJSON_PullFalse       11
+#define cJSON_PullNull        12
+
+/* Expected member of an object, see cJSON_CreateSchema. */
+typedef struct cJSON_SchemaField
+{
+    const char *key; /* compared case sensitively */
+    int types; /* accepted types, e.g. cJSON_Number or (cJSON_True | cJSON_False), 0 accepts any type */
+    cJSON_bool required;
+} cJSON_SchemaField;
+
+typedef struct cJSON_Schema cJSON_Schema;
+
+/* Results of cJSON_MatchSchema */
+#define cJSON_SchemaOk        0
+#define cJSON_SchemaNotObject 1 /* the matched item is not an object */
+#define cJSON_SchemaWrongType 2 /* a member has a type that its field doesn't accept */
+#define cJSON_SchemaMissing   3 /* a required member is missing */
+
 /* Limits the length of circular references can be before cJSON rejects to parse them.
  * This is to prevent stack overflows. */
 #ifndef CJSON_CIRCULAR_LIMIT
@@ -157,6 +217,48 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithLength(const char *value, size_t buffer_len
 /* If you supply a ptr in return_parse_end and parsing fails, then return_parse_end will contain a pointer to the error so will match cJSON_GetErrorPtr(). */
 CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cJSON_bool require_null_terminated);
 CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated);
+/* In-situ parsing: strings and keys are unescaped inside of value and the items point there instead of owning a copy.
+ * value doesn't need to be null terminated, it is modified (even if parsing fails) and has to outlive the returned tree.
+ * String items are marked with cJSON_IsReference and keys with cJSON_StringIsConst, so cJSON_Delete only frees the items themselves. */
+CJSON_PUBLIC(cJSON *) cJSON_ParseInSitu(char *value, size_t buffer_length);
+
+/* Arena allocation: items and strings are bump-allocated from a caller-provided buffer instead of cJSON_Hooks.
+ * cJSON_Delete skips arena items, call cJSON_ResetArena once the whole document is no longer needed.
+ * Functions that allocate new keys or strings (e.g. cJSON_AddItemToObject, cJSON_ReplaceItemInObject) still use the hooks,
+ * use the InArena variants below to build a document that is released completely by cJSON_ResetArena. */
+CJSON_PUBLIC(void) cJSON_InitArena(cJSON_Arena *arena, void *buffer, size_t size);
+/* Release everything that was allocated from the arena in O(1). */
+CJSON_PUBLIC(void) cJSON_ResetArena(cJSON_Arena *arena);
+/* Returns the number of bytes that are currently in use. */
+CJSON_PUBLIC(size_t) cJSON_GetArenaUsage(const cJSON_Arena *arena);
+/* Parse buffer_length bytes of value into the arena. Returns NULL and leaves the arena untouched on failure (including when it runs out of space). */
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithArena(const char *value, size_t buffer_length, cJSON_Arena *arena);
+
+/* Thread safe parsing: the context brings its own hooks (NULL for malloc/free) instead of the ones from cJSON_InitHooks,
+ * and the error position is stored in context->error instead of the global cJSON_GetErrorPtr.
+ * Parameters are the same as for cJSON_ParseWithLengthOpts. Trees have to be freed with cJSON_DeleteCtx and the same hooks,
+ * the other functions (e.g. cJSON_AddItemToObject) still use the global hooks for anything they allocate. */
+CJSON_PUBLIC(void) cJSON_InitContext(cJSON_Context *context, const cJSON_Hooks *hooks);
+CJSON_PUBLIC(cJSON *) cJSON_ParseCtx(cJSON_Context *context, const char *value, size_t buffer_length, const char **return_parse_end, cJSON_bool require_null_terminated);
+CJSON_PUBLIC(void) cJSON_DeleteCtx(const cJSON_Context *context, cJSON *item);
+
+/* Pull parsing: walk through a JSON text event by event without building a tree.
+ * Input is fed in chunks of any size and copied into a window of buffer_size bytes, which is the only memory the parser uses
+ * (besides the parser itself), so every single key, string or number has to fit into it.
+ * A sequence of whitespace separated values (e.g. JSON lines) is accepted as well. */
+CJSON_PUBLIC(cJSON_PullParser *) cJSON_CreatePullParser(size_t buffer_size);
+CJSON_PUBLIC(void) cJSON_DeletePullParser(cJSON_PullParser *parser);
+/* Copies as much of data into the window as fits and returns the number of bytes that were taken, feed the rest after the next cJSON_PullNext. */
+CJSON_PUBLIC(size_t) cJSON_PullFeed(cJSON_PullParser *parser, const char *data, size_t length);
+/* Signal that there is no more input. */
+CJSON_PUBLIC(void) cJSON_PullFinish(cJSON_PullParser *parser);
+/* Returns the next event (cJSON_PullStartObject etc.). After an error every call returns cJSON_PullError. */
+CJSON_PUBLIC(int) cJSON_PullNext(cJSON_PullParser *parser);
+/* The value of the last event: valuestring for keys and strings, valuedouble/valueint for numbers. It has no next/prev/child.
+ * Strings point into the window and are only valid until the next call to cJSON_PullFeed or cJSON_PullNext. */
+CJSON_PUBLIC(const cJSON *) cJSON_PullGetValue(const cJSON_PullParser *parser);
+/* Number of objects and arrays that are currently open. */
+CJSON_PUBLIC(size_t) cJSON_PullGetDepth(const cJSON_PullParser *parser);
 
 /* Render a cJSON entity to text for transfer/storage. */
 CJSON_PUBLIC(char *) cJSON_Print(const cJSON *item);
@@ -167,6 +269,16 @@ CJSON_PUBLIC(char *) cJSON_PrintBuffered(const cJSON *item, int prebuffer, cJSON
 /* Render a cJSON entity to text using a buffer already allocated in memory with given length. Returns 1 on success and 0 on failure. */
 /* NOTE: cJSON is not always 100% accurate in estimating how much memory it will use, so to be safe allocate 5 bytes more than you actually need */
 CJSON_PUBLIC(cJSON_bool) cJSON_PrintPreallocated(cJSON *item, char *buffer, const int length, const cJSON_bool format);
+/* Length of the text cJSON_Print (format=1) or cJSON_PrintUnformatted (format=0) would return, without the terminator.
+ * Returns 0 on failure. This prints without keeping the output, so it costs about as much as printing. */
+CJSON_PUBLIC(size_t) cJSON_PrintedLength(const cJSON *item, cJSON_bool format);
+/* Render a cJSON entity to text in a buffer of the given length. Unlike with cJSON_PrintPreallocated no spare bytes are
+ * needed, cJSON_PrintedLength + 1 for the terminator is exactly enough. Returns 1 on success and 0 on failure. */
+CJSON_PUBLIC(cJSON_bool) cJSON_PrintToBuffer(const cJSON *item, char *buffer, size_t length, cJSON_bool format);
+/* Render a cJSON entity to text and hand it to sink piece by piece instead of building the whole text in memory.
+ * chunk_size is the size of the buffer that is handed over whenever it is full, it only grows for strings that don't fit.
+ * Returns 1 on success and 0 on failure (including sink returning 0). */
+CJSON_PUBLIC(cJSON_bool) cJSON_PrintToSink(const cJSON *item, cJSON_bool format, size_t chunk_size, cJSON_PrintSink sink, void *context);
 /* Delete a cJSON entity and all subentities. */
 CJSON_PUBLIC(void) cJSON_Delete(cJSON *item);
 
@@ -178,6 +290,21 @@ CJSON_PUBLIC(cJSON *) cJSON_GetArrayItem(const cJSON *array, int index);
 CJSON_PUBLIC(cJSON *) cJSON_GetObjectItem(const cJSON * const object, const char * const string);
 CJSON_PUBLIC(cJSON *) cJSON_GetObjectItemCaseSensitive(const cJSON * const object, const char * const string);
 CJSON_PUBLIC(cJSON_bool) cJSON_HasObjectItem(const cJSON *object, const char *string);
+/* Opt-in hash index for objects with many members, which makes the GetObjectItem variants O(1) instead of a linear scan.
+ * The index is built lazily on the next lookup and kept up to date when items are added, detached or replaced through cJSON's functions.
+ * It is freed by cJSON_Delete or cJSON_DisableObjectIndex (do that before cJSON_ResetArena for arena objects).
+ * The index is kept in the valuestring of the object, which objects don't otherwise use.
+ * While it is enabled, don't change the keys of the members or the child list directly. Building the index on a lookup is not thread safe. */
+CJSON_PUBLIC(cJSON_bool) cJSON_EnableObjectIndex(cJSON *object);
+CJSON_PUBLIC(void) cJSON_DisableObjectIndex(cJSON *object);
+/* Compiled set of expected keys: cJSON_MatchSchema finds all of them with a single walk over the members of an object
+ * instead of one linear scan per key. Returns NULL for duplicate or NULL keys. fields (including the keys) has to outlive the schema. */
+CJSON_PUBLIC(cJSON_Schema *) cJSON_CreateSchema(const cJSON_SchemaField *fields, size_t count);
+CJSON_PUBLIC(void) cJSON_DeleteSchema(cJSON_Schema *schema);
+/* Stores the member for fields[i] in slots[i] (NULL if it is missing, the first one if the key appears more than once) and checks its type.
+ * Members with other keys are ignored. Returns cJSON_SchemaOk or one of the errors above, for cJSON_SchemaWrongType
+ * and cJSON_SchemaMissing *error_field (if not NULL) is set to the index of the field that failed. */
+CJSON_PUBLIC(int) cJSON_MatchSchema(const cJSON_Schema *schema, const cJSON *object, const cJSON **slots, size_t *error_field);
 /* For analysing failed parses. This returns a pointer to the parse error. You'll probably need to look a few chars back to make sense of it. Defined when cJSON_Parse() returns 0. 0 when cJSON_Parse() succeeds. */
 CJSON_PUBLIC(const char *) cJSON_GetErrorPtr(void);
 
@@ -217,6 +344,14 @@ CJSON_PUBLIC(cJSON *) cJSON_CreateStringReference(const char *string);
 CJSON_PUBLIC(cJSON *) cJSON_CreateObjectReference(const cJSON *child);
 CJSON_PUBLIC(cJSON *) cJSON_CreateArrayReference(const cJSON *child);
 
+/* These calls create items inside an arena, strings are copied into the arena as well. */
+CJSON_PUBLIC(cJSON *) cJSON_CreateNullInArena(cJSON_Arena *arena);
+CJSON_PUBLIC(cJSON *) cJSON_CreateBoolInArena(cJSON_Arena *arena, cJSON_bool boolean);
+CJSON_PUBLIC(cJSON *) cJSON_CreateNumberInArena(cJSON_Arena *arena, double num);
+CJSON_PUBLIC(cJSON *) cJSON_CreateStringInArena(cJSON_Arena *arena, const char *string);
+CJSON_PUBLIC(cJSON *) cJSON_CreateArrayInArena(cJSON_Arena *arena);
+CJSON_PUBLIC(cJSON *) cJSON_CreateObjectInArena(cJSON_Arena *arena);
+
 /* These utilities create an Array of count items.
  * The parameter count cannot be greater than the number of elements in the number array, otherwise array access will be out of bounds.*/
 CJSON_PUBLIC(cJSON *) cJSON_CreateIntArray(const int *numbers, int count);
@@ -231,6 +366,8 @@ CJSON_PUBLIC(cJSON_bool) cJSON_AddItemToObject(cJSON *object, const char *string
  * WARNING: When this function was used, make sure to always check that (item->type & cJSON_StringIsConst) is zero before
  * writing to `item->string` */
 CJSON_PUBLIC(cJSON_bool) cJSON_AddItemToObjectCS(cJSON *object, const char *string, cJSON *item);
+/* Append item to the specified object with a copy of string that is allocated from the arena. */
+CJSON_PUBLIC(cJSON_bool) cJSON_AddItemToObjectInArena(cJSON_Arena *arena, cJSON *object, const char *string, cJSON *item);
 /* Append reference to item to the specified array/object. Use this when you want to add an existing cJSON to a new cJSON, but don't want to corrupt your existing cJSON. */
 CJSON_PUBLIC(cJSON_bool) cJSON_AddItemReferenceToArray(cJSON *array, cJSON *item);
 CJSON_PUBLIC(cJSON_bool) cJSON_AddItemReferenceToObject(cJSON *object, const char *string, cJSON *item);
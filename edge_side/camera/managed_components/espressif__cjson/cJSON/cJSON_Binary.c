@@ -0,0 +1,1387 @@
+/*
+  Copyright (c) 2009-2017 Dave Gamble and cJSON contributors
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+/* disable warnings about old C89 functions in MSVC */
+#if !defined(_CRT_SECURE_NO_DEPRECATE) && defined(_MSC_VER)
+#define _CRT_SECURE_NO_DEPRECATE
+#endif
+
+#ifdef __GNUCC__
+#pragma GCC visibility push(default)
+#endif
+#if defined(_MSC_VER)
+#pragma warning (push)
+/* disable warning about single line comments in system headers */
+#pragma warning (disable : 4001)
+#endif
+
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <float.h>
+
+#if defined(_MSC_VER)
+#pragma warning (pop)
+#endif
+#ifdef __GNUCC__
+#pragma GCC visibility pop
+#endif
+
+#include "cJSON_Binary.h"
+
+/* define our own boolean type */
+#ifdef true
+#undef true
+#endif
+#define true ((cJSON_bool)1)
+
+#ifdef false
+#undef false
+#endif
+#define false ((cJSON_bool)0)
+
+/* without a 64 bit integer type, 64 bit values are handled as two 32 bit halves */
+#define two_to_the_32 4294967296.0
+/* whole numbers up to this magnitude are exact in a double */
+#define max_exact_integer 9007199254740992.0
+
+static cJSON_bool is_negative_zero(double number)
+{
+    const double negative_zero = -0.0;
+
+    return (number == 0) && (memcmp(&number, &negative_zero, sizeof(number)) == 0);
+}
+
+/* number (whole and not negative, below 2^64) split into the upper and lower 32 bits */
+static void split_number(double number, unsigned long *high, unsigned long *low)
+{
+    double upper = floor(number / two_to_the_32);
+
+    *high = (unsigned long)upper;
+    *low = (unsigned long)(number - (upper * two_to_the_32));
+}
+
+/* IEEE 754 bits of number in a format with exponent_bits and fraction_bits (5/10, 8/23 or 11/52),
+ * false if the format can't hold number exactly. Bits above the lower 32 end up in high. */
+static cJSON_bool to_ieee754(double number, int exponent_bits, int fraction_bits, unsigned long *high, unsigned long *low)
+{
+    const int bias = (1 << (exponent_bits - 1)) - 1;
+    const unsigned long all_ones = (1UL << exponent_bits) - 1;
+    double magnitude = fabs(number);
+    double fraction = 0;
+    unsigned long biased = 0;
+    unsigned long sign = ((number < 0) || is_negative_zero(number)) ? 1 : 0;
+    int exponent = 0;
+
+    if (number != number)
+    {
+        /* quiet NaN */
+        sign = 0;
+        biased = all_ones;
+        fraction = ldexp(1.0, fraction_bits - 1);
+    }
+    else if (magnitude > DBL_MAX)
+    {
+        biased = all_ones;
+    }
+    else if (magnitude != 0)
+    {
+        /* magnitude is 1.fraction * 2^exponent */
+        frexp(magnitude, &exponent);
+        exponent--;
+        if (exponent > bias)
+        {
+            return false;
+        }
+
+        if (exponent > -bias)
+        {
+            biased = (unsigned long)(exponent + bias);
+            fraction = ldexp(magnitude, fraction_bits - exponent) - ldexp(1.0, fraction_bits);
+        }
+        else
+        {
+            /* subnormal */
+            fraction = ldexp(magnitude, fraction_bits + bias - 1);
+        }
+
+        if (fraction != floor(fraction))
+        {
+            return false;
+        }
+    }
+
+    if (fraction_bits > 32)
+    {
+        unsigned long upper = 0;
+        split_number(fraction, &upper, low);
+        *high = (sign << 31) | (biased << (fraction_bits - 32)) | upper;
+    }
+    else
+    {
+        *high = 0;
+        *low = (sign << (exponent_bits + fraction_bits)) | (biased << fraction_bits) | (unsigned long)fraction;
+    }
+
+    return true;
+}
+
+static double from_ieee754(unsigned long high, unsigned long low, int exponent_bits, int fraction_bits)
+{
+    const int bias = (1 << (exponent_bits - 1)) - 1;
+    const unsigned long all_ones = (1UL << exponent_bits) - 1;
+    unsigned long sign = 0;
+    unsigned long biased = 0;
+    double fraction = 0;
+    double number = 0;
+
+    if (fraction_bits > 32)
+    {
+        sign = (high >> 31) & 1;
+        biased = (high >> (fraction_bits - 32)) & all_ones;
+        fraction = ((double)(high & ((1UL << (fraction_bits - 32)) - 1)) * two_to_the_32) + (double)low;
+    }
+    else
+    {
+        sign = (low >> (exponent_bits + fraction_bits)) & 1;
+        biased = (low >> fraction_bits) & all_ones;
+        fraction = (double)(low & ((1UL << fraction_bits) - 1));
+    }
+
+    if (biased == all_ones)
+    {
+        number = (fraction == 0) ? HUGE_VAL : (HUGE_VAL - HUGE_VAL);
+    }
+    else if (biased == 0)
+    {
+        number = ldexp(fraction, 1 - bias - fraction_bits);
+    }
+    else
+    {
+        number = ldexp(fraction + ldexp(1.0, fraction_bits), (int)biased - bias - fraction_bits);
+    }
+
+    return sign ? -number : number;
+}
+
+/* 1 if doubles are IEEE 754 binary64 stored big endian, 2 if little endian, 0 for anything else */
+static int double_byte_order(void)
+{
+    const double one = 1.0;
+    unsigned char bytes[sizeof(double)];
+
+    memcpy(bytes, &one, sizeof(bytes));
+    if ((sizeof(bytes) == 8) && (bytes[0] == 0x3F) && (bytes[1] == 0xF0))
+    {
+        return 1;
+    }
+    if ((sizeof(bytes) == 8) && (bytes[7] == 0x3F) && (bytes[6] == 0xF0))
+    {
+        return 2;
+    }
+
+    return 0;
+}
+
+/* copies the 8 bytes of a double between native and big endian order, false if it can't be copied directly */
+static cJSON_bool swap_double_bytes(const unsigned char *from, unsigned char *to)
+{
+    size_t i = 0;
+
+    switch (double_byte_order())
+    {
+        case 1:
+            memcpy(to, from, 8);
+            return true;
+        case 2:
+            for (i = 0; i < 8; i++)
+            {
+                to[i] = from[7 - i];
+            }
+            return true;
+        default:
+            return false;
+    }
+}
+
+static void write_bytes(cJSON_BinaryWriter * const writer, const unsigned char *bytes, size_t count)
+{
+    if (writer->failed)
+    {
+        return;
+    }
+
+    writer->written += count;
+    if (writer->buffer == NULL)
+    {
+        /* only counting */
+        return;
+    }
+
+    while (count > 0)
+    {
+        size_t available = writer->length - writer->offset;
+        if (available == 0)
+        {
+            if ((writer->sink == NULL) || !writer->sink(writer->sink_context, (const char*)writer->buffer, writer->offset))
+            {
+                writer->failed = true;
+                return;
+            }
+            writer->offset = 0;
+            available = writer->length;
+        }
+        if (available > count)
+        {
+            available = count;
+        }
+
+        memcpy(writer->buffer + writer->offset, bytes, available);
+        writer->offset += available;
+        bytes += available;
+        count -= available;
+    }
+}
+
+/* initial byte followed by size bytes (0, 1, 2, 4 or 8) of the big endian value high:low */
+static void write_head(cJSON_BinaryWriter * const writer, unsigned char initial, unsigned long high, unsigned long low, size_t size)
+{
+    unsigned char bytes[9];
+    size_t i = 0;
+
+    bytes[0] = initial;
+    for (i = 0; i < size; i++)
+    {
+        size_t shift = 8 * (size - 1 - i);
+        unsigned long word = (shift >= 32) ? high : low;
+        bytes[i + 1] = (unsigned char)((word >> (shift % 32)) & 0xFF);
+    }
+
+    write_bytes(writer, bytes, size + 1);
+}
+
+/* CBOR head with the shortest encoding of the argument */
+static void write_cbor_head(cJSON_BinaryWriter * const writer, unsigned char major, unsigned long high, unsigned long low)
+{
+    unsigned char initial = (unsigned char)(major << 5);
+
+    if (high != 0)
+    {
+        write_head(writer, initial | 27, high, low, 8);
+    }
+    else if (low < 24)
+    {
+        write_head(writer, (unsigned char)(initial | low), 0, 0, 0);
+    }
+    else if (low <= 0xFF)
+    {
+        write_head(writer, initial | 24, 0, low, 1);
+    }
+    else if (low <= 0xFFFF)
+    {
+        write_head(writer, initial | 25, 0, low, 2);
+    }
+    else
+    {
+        write_head(writer, initial | 26, 0, low, 4);
+    }
+}
+
+static void write_cbor_size(cJSON_BinaryWriter * const writer, unsigned char major, size_t size)
+{
+    write_cbor_head(writer, major, (unsigned long)((size >> 16) >> 16), (unsigned long)(size & 0xFFFFFFFFUL));
+}
+
+/* MessagePack has one type per argument size, small ones (below 2^4 or 2^5) are part of the type byte */
+static void write_msgpack_size(cJSON_BinaryWriter * const writer, unsigned char fixed_type, size_t fixed_limit, unsigned char type8, unsigned char type16, unsigned char type32, size_t size)
+{
+    if (size < fixed_limit)
+    {
+        write_head(writer, (unsigned char)(fixed_type | size), 0, 0, 0);
+    }
+    else if ((size <= 0xFF) && (type8 != 0))
+    {
+        write_head(writer, type8, 0, (unsigned long)size, 1);
+    }
+    else if (size <= 0xFFFF)
+    {
+        write_head(writer, type16, 0, (unsigned long)size, 2);
+    }
+    else if (((size >> 16) >> 16) == 0)
+    {
+        write_head(writer, type32, 0, (unsigned long)size, 4);
+    }
+    else
+    {
+        writer->failed = true;
+    }
+}
+
+static void write_integer(cJSON_BinaryWriter * const writer, double number)
+{
+    unsigned long high = 0;
+    unsigned long low = 0;
+
+    if (writer->format == cJSON_CBOR)
+    {
+        /* negative integers are stored as -1 - n */
+        split_number((number < 0) ? (-1.0 - number) : number, &high, &low);
+        write_cbor_head(writer, (number < 0) ? 1 : 0, high, low);
+        return;
+    }
+
+    if (number >= 0)
+    {
+        split_number(number, &high, &low);
+        if (high != 0)
+        {
+            write_head(writer, 0xCF, high, low, 8);
+        }
+        else if (low <= 0x7F)
+        {
+            write_head(writer, (unsigned char)low, 0, 0, 0);
+        }
+        else if (low <= 0xFF)
+        {
+            write_head(writer, 0xCC, 0, low, 1);
+        }
+        else if (low <= 0xFFFF)
+        {
+            write_head(writer, 0xCD, 0, low, 2);
+        }
+        else
+        {
+            write_head(writer, 0xCE, 0, low, 4);
+        }
+        return;
+    }
+
+    if (number >= -32)
+    {
+        write_head(writer, (unsigned char)(256 + (int)number), 0, 0, 0);
+        return;
+    }
+
+    /* two's complement, the lower bytes of it also work for the shorter types */
+    split_number(-1.0 - number, &high, &low);
+    high = ~high & 0xFFFFFFFFUL;
+    low = ~low & 0xFFFFFFFFUL;
+    if (number >= -128)
+    {
+        write_head(writer, 0xD0, 0, low, 1);
+    }
+    else if (number >= -32768)
+    {
+        write_head(writer, 0xD1, 0, low, 2);
+    }
+    else if (number >= -2147483648.0)
+    {
+        write_head(writer, 0xD2, 0, low, 4);
+    }
+    else
+    {
+        write_head(writer, 0xD3, high, low, 8);
+    }
+}
+
+static void write_number(cJSON_BinaryWriter * const writer, double number)
+{
+    unsigned char bytes[9];
+    unsigned long high = 0;
+    unsigned long low = 0;
+
+    if ((number == floor(number)) && (fabs(number) <= max_exact_integer) && !is_negative_zero(number))
+    {
+        write_integer(writer, number);
+    }
+    else if ((number != number) || (fabs(number) > DBL_MAX) || ((fabs(number) <= (double)FLT_MAX) && ((double)(float)number == number)))
+    {
+        if ((writer->format == cJSON_CBOR) && to_ieee754(number, 5, 10, &high, &low))
+        {
+            write_head(writer, 0xF9, 0, low, 2);
+        }
+        else
+        {
+            to_ieee754(number, 8, 23, &high, &low);
+            write_head(writer, (writer->format == cJSON_CBOR) ? 0xFA : 0xCA, 0, low, 4);
+        }
+    }
+    else if (swap_double_bytes((const unsigned char*)&number, bytes + 1))
+    {
+        bytes[0] = (writer->format == cJSON_CBOR) ? 0xFB : 0xCB;
+        write_bytes(writer, bytes, sizeof(bytes));
+    }
+    else
+    {
+        to_ieee754(number, 11, 52, &high, &low);
+        write_head(writer, (writer->format == cJSON_CBOR) ? 0xFB : 0xCB, high, low, 8);
+    }
+}
+
+static void write_string(cJSON_BinaryWriter * const writer, const char *string)
+{
+    size_t length = 0;
+
+    if (string == NULL)
+    {
+        writer->failed = true;
+        return;
+    }
+
+    length = strlen(string);
+    if (writer->format == cJSON_CBOR)
+    {
+        write_cbor_size(writer, 3, length);
+    }
+    else
+    {
+        write_msgpack_size(writer, 0xA0, 32, 0xD9, 0xDA, 0xDB, length);
+    }
+    write_bytes(writer, (const unsigned char*)string, length);
+}
+
+static void write_start(cJSON_BinaryWriter * const writer, cJSON_bool is_object, size_t count)
+{
+    if (writer->format == cJSON_CBOR)
+    {
+        if (count == cJSON_BinaryIndefinite)
+        {
+            write_head(writer, is_object ? 0xBF : 0x9F, 0, 0, 0);
+        }
+        else
+        {
+            write_cbor_size(writer, is_object ? 5 : 4, count);
+        }
+    }
+    else if (count == cJSON_BinaryIndefinite)
+    {
+        writer->failed = true;
+    }
+    else if (is_object)
+    {
+        write_msgpack_size(writer, 0x80, 16, 0, 0xDE, 0xDF, count);
+    }
+    else
+    {
+        write_msgpack_size(writer, 0x90, 16, 0, 0xDC, 0xDD, count);
+    }
+}
+
+static void write_item(cJSON_BinaryWriter * const writer, const cJSON * const item, size_t depth)
+{
+    const cJSON *child = NULL;
+    size_t count = 0;
+
+    if (item == NULL)
+    {
+        writer->failed = true;
+        return;
+    }
+
+    switch (item->type & 0xFF)
+    {
+        case cJSON_NULL:
+            write_head(writer, (writer->format == cJSON_CBOR) ? 0xF6 : 0xC0, 0, 0, 0);
+            return;
+
+        case cJSON_False:
+            write_head(writer, (writer->format == cJSON_CBOR) ? 0xF4 : 0xC2, 0, 0, 0);
+            return;
+
+        case cJSON_True:
+            write_head(writer, (writer->format == cJSON_CBOR) ? 0xF5 : 0xC3, 0, 0, 0);
+            return;
+
+        case cJSON_Number:
+            write_number(writer, item->valuedouble);
+            return;
+
+        case cJSON_String:
+            write_string(writer, item->valuestring);
+            return;
+
+        case cJSON_Array:
+        case cJSON_Object:
+            /* the decoder would reject anything deeper */
+            if (depth >= CJSON_NESTING_LIMIT)
+            {
+                writer->failed = true;
+                return;
+            }
+
+            for (child = item->child; child != NULL; child = child->next)
+            {
+                count++;
+            }
+            write_start(writer, cJSON_IsObject(item), count);
+            for (child = item->child; (child != NULL) && !writer->failed; child = child->next)
+            {
+                if (cJSON_IsObject(item))
+                {
+                    write_string(writer, child->string);
+                }
+                write_item(writer, child, depth + 1);
+            }
+            return;
+
+        default:
+            /* raw and invalid items */
+            writer->failed = true;
+            return;
+    }
+}
+
+CJSON_PUBLIC(void) cJSON_InitBinaryWriter(cJSON_BinaryWriter *writer, int format, unsigned char *buffer, size_t length, cJSON_PrintSink sink, void *context)
+{
+    if (writer == NULL)
+    {
+        return;
+    }
+
+    writer->buffer = buffer;
+    writer->length = length;
+    writer->offset = 0;
+    writer->written = 0;
+    writer->format = format;
+    writer->sink = sink;
+    writer->sink_context = context;
+    writer->failed = ((format != cJSON_CBOR) && (format != cJSON_MessagePack))
+        || ((buffer == NULL) && ((length != 0) || (sink != NULL)))
+        || ((buffer != NULL) && (length == 0));
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_BinaryWriteNull(cJSON_BinaryWriter *writer)
+{
+    if (writer == NULL)
+    {
+        return false;
+    }
+
+    write_head(writer, (writer->format == cJSON_CBOR) ? 0xF6 : 0xC0, 0, 0, 0);
+    return !writer->failed;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_BinaryWriteBool(cJSON_BinaryWriter *writer, cJSON_bool value)
+{
+    if (writer == NULL)
+    {
+        return false;
+    }
+
+    if (writer->format == cJSON_CBOR)
+    {
+        write_head(writer, value ? 0xF5 : 0xF4, 0, 0, 0);
+    }
+    else
+    {
+        write_head(writer, value ? 0xC3 : 0xC2, 0, 0, 0);
+    }
+    return !writer->failed;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_BinaryWriteNumber(cJSON_BinaryWriter *writer, double number)
+{
+    if (writer == NULL)
+    {
+        return false;
+    }
+
+    write_number(writer, number);
+    return !writer->failed;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_BinaryWriteString(cJSON_BinaryWriter *writer, const char *string)
+{
+    if (writer == NULL)
+    {
+        return false;
+    }
+
+    write_string(writer, string);
+    return !writer->failed;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_BinaryStartArray(cJSON_BinaryWriter *writer, size_t count)
+{
+    if (writer == NULL)
+    {
+        return false;
+    }
+
+    write_start(writer, false, count);
+    return !writer->failed;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_BinaryStartObject(cJSON_BinaryWriter *writer, size_t count)
+{
+    if (writer == NULL)
+    {
+        return false;
+    }
+
+    write_start(writer, true, count);
+    return !writer->failed;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_BinaryWriteEnd(cJSON_BinaryWriter *writer)
+{
+    if (writer == NULL)
+    {
+        return false;
+    }
+
+    if (writer->format == cJSON_CBOR)
+    {
+        /* "break" */
+        write_head(writer, 0xFF, 0, 0, 0);
+    }
+    else
+    {
+        writer->failed = true;
+    }
+    return !writer->failed;
+}
+
+CJSON_PUBLIC(cJSON_bool) cJSON_BinaryWriteItem(cJSON_BinaryWriter *writer, const cJSON *item)
+{
+    if (writer == NULL)
+    {
+        return false;
+    }
+
+    write_item(writer, item, 0);
+    return !writer->failed;
+}
+
+CJSON_PUBLIC(size_t) cJSON_FinishBinaryWriter(cJSON_BinaryWriter *writer)
+{
+    if ((writer == NULL) || writer->failed)
+    {
+        return 0;
+    }
+
+    if ((writer->sink != NULL) && (writer->offset > 0))
+    {
+        if (!writer->sink(writer->sink_context, (const char*)writer->buffer, writer->offset))
+        {
+            writer->failed = true;
+            return 0;
+        }
+        writer->offset = 0;
+    }
+
+    return writer->written;
+}
+
+CJSON_PUBLIC(size_t) cJSON_EncodeBinaryToBuffer(const cJSON *item, int format, unsigned char *buffer, size_t length)
+{
+    cJSON_BinaryWriter writer;
+
+    if (buffer == NULL)
+    {
+        return 0;
+    }
+
+    cJSON_InitBinaryWriter(&writer, format, buffer, length, NULL, NULL);
+    write_item(&writer, item, 0);
+
+    return cJSON_FinishBinaryWriter(&writer);
+}
+
+CJSON_PUBLIC(unsigned char *) cJSON_EncodeBinary(const cJSON *item, int format, size_t *length)
+{
+    cJSON_BinaryWriter writer;
+    unsigned char *buffer = NULL;
+    size_t size = 0;
+
+    if (length == NULL)
+    {
+        return NULL;
+    }
+
+    /* count first so that the buffer has the exact size */
+    cJSON_InitBinaryWriter(&writer, format, NULL, 0, NULL, NULL);
+    write_item(&writer, item, 0);
+    size = cJSON_FinishBinaryWriter(&writer);
+    if (size == 0)
+    {
+        return NULL;
+    }
+
+    buffer = (unsigned char*)cJSON_malloc(size);
+    if (buffer == NULL)
+    {
+        return NULL;
+    }
+    if (cJSON_EncodeBinaryToBuffer(item, format, buffer, size) != size)
+    {
+        cJSON_free(buffer);
+        return NULL;
+    }
+
+    *length = size;
+    return buffer;
+}
+
+typedef struct
+{
+    const unsigned char *content;
+    size_t length;
+    size_t offset;
+    size_t depth; /* How deeply nested (in arrays/objects) is the input at the current offset. */
+} binary_buffer;
+
+/* check if size more bytes can be read from the buffer */
+#define can_read(buffer, size) ((size) <= ((buffer)->length - (buffer)->offset))
+
+/* big endian unsigned integer of size bytes (1, 2, 4 or 8), the upper 32 bits go to high */
+static cJSON_bool read_uint(binary_buffer * const input, size_t size, unsigned long *high, unsigned long *low)
+{
+    size_t i = 0;
+
+    if (!can_read(input, size))
+    {
+        return false;
+    }
+
+    *high = 0;
+    *low = 0;
+    for (i = 0; i < size; i++)
+    {
+        if ((i + 4) < size)
+        {
+            *high = (*high << 8) | input->content[input->offset + i];
+        }
+        else
+        {
+            *low = (*low << 8) | input->content[input->offset + i];
+        }
+    }
+    input->offset += size;
+
+    return true;
+}
+
+/* copy of length bytes with a terminating zero, text may not contain zeros since cJSON strings couldn't hold them */
+static unsigned char *copy_bytes(binary_buffer * const input, size_t length, cJSON_bool is_text)
+{
+    const unsigned char *bytes = input->content + input->offset;
+    unsigned char *copy = NULL;
+
+    if (!can_read(input, length) || (is_text && (memchr(bytes, '\0', length) != NULL)))
+    {
+        return NULL;
+    }
+
+    copy = (unsigned char*)cJSON_malloc(length + 1);
+    if (copy == NULL)
+    {
+        return NULL;
+    }
+    memcpy(copy, bytes, length);
+    copy[length] = '\0';
+    input->offset += length;
+
+    return copy;
+}
+
+/* RFC 4648 section 5 without padding */
+static char *encode_base64url(const unsigned char *bytes, size_t length)
+{
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+    size_t encoded_length = ((length / 3) * 4) + ((((length % 3) * 4) + 2) / 3);
+    char *encoded = NULL;
+    char *output = NULL;
+    size_t i = 0;
+
+    if (length > (((size_t)-1) / 2))
+    {
+        return NULL;
+    }
+
+    encoded = (char*)cJSON_malloc(encoded_length + 1);
+    if (encoded == NULL)
+    {
+        return NULL;
+    }
+
+    output = encoded;
+    for (i = 0; (i + 2) < length; i += 3)
+    {
+        *output++ = alphabet[bytes[i] >> 2];
+        *output++ = alphabet[((bytes[i] & 0x03) << 4) | (bytes[i + 1] >> 4)];
+        *output++ = alphabet[((bytes[i + 1] & 0x0F) << 2) | (bytes[i + 2] >> 6)];
+        *output++ = alphabet[bytes[i + 2] & 0x3F];
+    }
+    if (i < length)
+    {
+        *output++ = alphabet[bytes[i] >> 2];
+        if ((i + 1) < length)
+        {
+            *output++ = alphabet[((bytes[i] & 0x03) << 4) | (bytes[i + 1] >> 4)];
+            *output++ = alphabet[(bytes[i + 1] & 0x0F) << 2];
+        }
+        else
+        {
+            *output++ = alphabet[(bytes[i] & 0x03) << 4];
+        }
+    }
+    *output = '\0';
+
+    return encoded;
+}
+
+/* takes ownership of string */
+static cJSON *create_string(char *string)
+{
+    cJSON *item = NULL;
+
+    if (string == NULL)
+    {
+        return NULL;
+    }
+
+    item = cJSON_CreateNull();
+    if (item == NULL)
+    {
+        cJSON_free(string);
+        return NULL;
+    }
+    item->type = cJSON_String;
+    item->valuestring = string;
+
+    return item;
+}
+
+static cJSON *create_base64url_string(unsigned char *bytes, size_t length)
+{
+    char *string = NULL;
+
+    if (bytes == NULL)
+    {
+        return NULL;
+    }
+
+    string = encode_base64url(bytes, length);
+    cJSON_free(bytes);
+
+    return create_string(string);
+}
+
+/* the argument following the initial byte: info below 24 is the argument itself, 24 to 27 are followed by 1 to 8 bytes */
+static cJSON_bool read_cbor_argument(binary_buffer * const input, unsigned char info, unsigned long *high, unsigned long *low)
+{
+    if (info < 24)
+    {
+        *high = 0;
+        *low = info;
+        return true;
+    }
+    if (info > 27)
+    {
+        return false;
+    }
+
+    return read_uint(input, (size_t)1 << (info - 24), high, low);
+}
+
+static cJSON_bool read_cbor_size(binary_buffer * const input, unsigned char info, size_t *size)
+{
+    unsigned long high = 0;
+    unsigned long low = 0;
+
+    if (!read_cbor_argument(input, info, &high, &low) || (high != 0) || ((unsigned long)(size_t)low != low))
+    {
+        return false;
+    }
+
+    *size = (size_t)low;
+    return true;
+}
+
+/* copy of a text (major type 3) or byte string (major type 2), the chunks of indefinite strings are joined */
+static unsigned char *read_cbor_string(binary_buffer * const input, unsigned char major, unsigned char info, size_t *length)
+{
+    unsigned char *copy = NULL;
+    size_t start = 0;
+    size_t end = 0;
+    size_t chunk = 0;
+    size_t total = 0;
+
+    if (info != 31)
+    {
+        if (!read_cbor_size(input, info, length))
+        {
+            return NULL;
+        }
+        return copy_bytes(input, *length, major == 3);
+    }
+
+    /* measure all chunks first, then copy them */
+    start = input->offset;
+    for (;;)
+    {
+        unsigned char initial = 0;
+
+        if (!can_read(input, 1))
+        {
+            return NULL;
+        }
+        initial = input->content[input->offset++];
+        if (initial == 0xFF)
+        {
+            break;
+        }
+        if (((initial >> 5) != major) || ((initial & 0x1F) == 31)
+                || !read_cbor_size(input, initial & 0x1F, &chunk) || !can_read(input, chunk)
+                || ((major == 3) && (memchr(input->content + input->offset, '\0', chunk) != NULL)))
+        {
+            return NULL;
+        }
+        input->offset += chunk;
+        total += chunk;
+    }
+    end = input->offset;
+
+    copy = (unsigned char*)cJSON_malloc(total + 1);
+    if (copy == NULL)
+    {
+        return NULL;
+    }
+
+    input->offset = start;
+    total = 0;
+    while (input->content[input->offset] != 0xFF)
+    {
+        unsigned char initial = input->content[input->offset++];
+        read_cbor_size(input, initial & 0x1F, &chunk);
+        memcpy(copy + total, input->content + input->offset, chunk);
+        input->offset += chunk;
+        total += chunk;
+    }
+    copy[total] = '\0';
+    input->offset = end;
+
+    *length = total;
+    return copy;
+}
+
+static char *read_cbor_key(binary_buffer * const input)
+{
+    unsigned char initial = 0;
+    size_t length = 0;
+
+    if (!can_read(input, 1))
+    {
+        return NULL;
+    }
+    initial = input->content[input->offset++];
+    if ((initial >> 5) != 3)
+    {
+        return NULL;
+    }
+
+    return (char*)read_cbor_string(input, 3, initial & 0x1F, &length);
+}
+
+static cJSON *read_double(binary_buffer * const input)
+{
+    unsigned long high = 0;
+    unsigned long low = 0;
+    double number = 0;
+
+    if (can_read(input, 8) && swap_double_bytes(input->content + input->offset, (unsigned char*)&number))
+    {
+        input->offset += 8;
+        return cJSON_CreateNumber(number);
+    }
+
+    return read_uint(input, 8, &high, &low) ? cJSON_CreateNumber(from_ieee754(high, low, 11, 52)) : NULL;
+}
+
+static cJSON *decode_cbor(binary_buffer * const input);
+
+static cJSON *decode_cbor_container(binary_buffer * const input, cJSON_bool is_object, unsigned char info)
+{
+    cJSON *container = NULL;
+    size_t count = 0;
+    size_t i = 0;
+
+    if (input->depth >= CJSON_NESTING_LIMIT)
+    {
+        return NULL; /* too deeply nested */
+    }
+    if ((info != 31) && !read_cbor_size(input, info, &count))
+    {
+        return NULL;
+    }
+
+    container = is_object ? cJSON_CreateObject() : cJSON_CreateArray();
+    if (container == NULL)
+    {
+        return NULL;
+    }
+
+    input->depth++;
+    /* every item takes at least one byte, so a bogus count runs out of input */
+    for (i = 0; (info == 31) || (i < count); i++)
+    {
+        char *key = NULL;
+        cJSON *value = NULL;
+
+        if (info == 31)
+        {
+            if (!can_read(input, 1))
+            {
+                goto fail;
+            }
+            if (input->content[input->offset] == 0xFF)
+            {
+                input->offset++;
+                break;
+            }
+        }
+
+        if (is_object)
+        {
+            key = read_cbor_key(input);
+            if (key == NULL)
+            {
+                goto fail;
+            }
+        }
+        value = decode_cbor(input);
+        if (value == NULL)
+        {
+            cJSON_free(key);
+            goto fail;
+        }
+        value->string = key;
+        cJSON_AddItemToArray(container, value);
+    }
+    input->depth--;
+
+    return container;
+
+fail:
+    cJSON_Delete(container);
+    return NULL;
+}
+
+static cJSON *decode_cbor(binary_buffer * const input)
+{
+    unsigned char initial = 0;
+    unsigned char info = 0;
+    unsigned long high = 0;
+    unsigned long low = 0;
+    size_t length = 0;
+    unsigned char *bytes = NULL;
+    cJSON *item = NULL;
+
+    if (!can_read(input, 1))
+    {
+        return NULL;
+    }
+    initial = input->content[input->offset++];
+    info = initial & 0x1F;
+
+    switch (initial >> 5)
+    {
+        case 0:
+        case 1:
+            if (!read_cbor_argument(input, info, &high, &low))
+            {
+                return NULL;
+            }
+            if ((initial >> 5) == 0)
+            {
+                return cJSON_CreateNumber(((double)high * two_to_the_32) + (double)low);
+            }
+            return cJSON_CreateNumber(-1.0 - (((double)high * two_to_the_32) + (double)low));
+
+        case 2:
+            bytes = read_cbor_string(input, 2, info, &length);
+            return create_base64url_string(bytes, length);
+
+        case 3:
+            return create_string((char*)read_cbor_string(input, 3, info, &length));
+
+        case 4:
+            return decode_cbor_container(input, false, info);
+
+        case 5:
+            return decode_cbor_container(input, true, info);
+
+        case 6:
+            /* tags only add meaning to the value that follows */
+            if ((input->depth >= CJSON_NESTING_LIMIT) || !read_cbor_argument(input, info, &high, &low))
+            {
+                return NULL;
+            }
+            input->depth++;
+            item = decode_cbor(input);
+            input->depth--;
+            return item;
+
+        default:
+            break;
+    }
+
+    switch (info)
+    {
+        case 20:
+            return cJSON_CreateFalse();
+        case 21:
+            return cJSON_CreateTrue();
+        case 22:
+        case 23:
+            /* null and undefined */
+            return cJSON_CreateNull();
+        case 25:
+            return read_uint(input, 2, &high, &low) ? cJSON_CreateNumber(from_ieee754(high, low, 5, 10)) : NULL;
+        case 26:
+            return read_uint(input, 4, &high, &low) ? cJSON_CreateNumber(from_ieee754(high, low, 8, 23)) : NULL;
+        case 27:
+            return read_double(input);
+        default:
+            /* other simple values and a misplaced "break" */
+            return NULL;
+    }
+}
+
+/* strings are 0xA0-0xBF (up to 31 bytes) or 0xD9-0xDB followed by a 1, 2 or 4 byte length */
+static cJSON_bool read_msgpack_string_length(binary_buffer * const input, unsigned char type, size_t *length)
+{
+    unsigned long high = 0;
+    unsigned long low = 0;
+
+    if ((type & 0xE0) == 0xA0)
+    {
+        *length = type & 0x1Fu;
+        return true;
+    }
+    if ((type < 0xD9) || (type > 0xDB) || !read_uint(input, (size_t)1 << (type - 0xD9), &high, &low))
+    {
+        return false;
+    }
+
+    *length = (size_t)low;
+    return true;
+}
+
+static cJSON *decode_msgpack(binary_buffer * const input);
+
+static cJSON *decode_msgpack_container(binary_buffer * const input, cJSON_bool is_object, size_t count)
+{
+    cJSON *container = NULL;
+    size_t i = 0;
+
+    if (input->depth >= CJSON_NESTING_LIMIT)
+    {
+        return NULL; /* too deeply nested */
+    }
+
+    container = is_object ? cJSON_CreateObject() : cJSON_CreateArray();
+    if (container == NULL)
+    {
+        return NULL;
+    }
+
+    input->depth++;
+    for (i = 0; i < count; i++)
+    {
+        char *key = NULL;
+        cJSON *value = NULL;
+
+        if (is_object)
+        {
+            size_t length = 0;
+            if (!can_read(input, 1) || !read_msgpack_string_length(input, input->content[input->offset++], &length))
+            {
+                goto fail;
+            }
+            key = (char*)copy_bytes(input, length, true);
+            if (key == NULL)
+            {
+                goto fail;
+            }
+        }
+        value = decode_msgpack(input);
+        if (value == NULL)
+        {
+            cJSON_free(key);
+            goto fail;
+        }
+        value->string = key;
+        cJSON_AddItemToArray(container, value);
+    }
+    input->depth--;
+
+    return container;
+
+fail:
+    cJSON_Delete(container);
+    return NULL;
+}
+
+static cJSON *decode_msgpack(binary_buffer * const input)
+{
+    unsigned char type = 0;
+    unsigned long high = 0;
+    unsigned long low = 0;
+    size_t length = 0;
+    size_t size = 0;
+
+    if (!can_read(input, 1))
+    {
+        return NULL;
+    }
+    type = input->content[input->offset++];
+
+    if (type <= 0x7F)
+    {
+        return cJSON_CreateNumber(type);
+    }
+    if (type >= 0xE0)
+    {
+        return cJSON_CreateNumber((double)type - 256.0);
+    }
+    if (type <= 0x8F)
+    {
+        return decode_msgpack_container(input, true, type & 0x0Fu);
+    }
+    if (type <= 0x9F)
+    {
+        return decode_msgpack_container(input, false, type & 0x0Fu);
+    }
+    if (read_msgpack_string_length(input, type, &length))
+    {
+        return create_string((char*)copy_bytes(input, length, true));
+    }
+
+    switch (type)
+    {
+        case 0xC0:
+            return cJSON_CreateNull();
+        case 0xC2:
+            return cJSON_CreateFalse();
+        case 0xC3:
+            return cJSON_CreateTrue();
+
+        case 0xC4:
+        case 0xC5:
+        case 0xC6:
+            /* bin 8, 16 and 32 */
+            if (!read_uint(input, (size_t)1 << (type - 0xC4), &high, &low))
+            {
+                return NULL;
+            }
+            length = (size_t)low;
+            return create_base64url_string(copy_bytes(input, length, false), length);
+
+        case 0xCA:
+            return read_uint(input, 4, &high, &low) ? cJSON_CreateNumber(from_ieee754(high, low, 8, 23)) : NULL;
+        case 0xCB:
+            return read_double(input);
+
+        case 0xCC:
+        case 0xCD:
+        case 0xCE:
+        case 0xCF:
+            /* uint 8, 16, 32 and 64 */
+            if (!read_uint(input, (size_t)1 << (type - 0xCC), &high, &low))
+            {
+                return NULL;
+            }
+            return cJSON_CreateNumber(((double)high * two_to_the_32) + (double)low);
+
+        case 0xD0:
+        case 0xD1:
+        case 0xD2:
+        case 0xD3:
+            /* int 8, 16, 32 and 64 in two's complement */
+            size = (size_t)1 << (type - 0xD0);
+            if (!read_uint(input, size, &high, &low))
+            {
+                return NULL;
+            }
+            if (size == 8)
+            {
+                if ((high & 0x80000000UL) == 0)
+                {
+                    return cJSON_CreateNumber(((double)high * two_to_the_32) + (double)low);
+                }
+                return cJSON_CreateNumber(-(((double)(~high & 0xFFFFFFFFUL) * two_to_the_32) + (double)(~low & 0xFFFFFFFFUL) + 1.0));
+            }
+            if ((low >> ((8 * size) - 1)) != 0)
+            {
+                return cJSON_CreateNumber((double)low - ldexp(1.0, (int)(8 * size)));
+            }
+            return cJSON_CreateNumber((double)low);
+
+        case 0xDC:
+        case 0xDD:
+        case 0xDE:
+        case 0xDF:
+            /* array 16, array 32, map 16 and map 32 */
+            if (!read_uint(input, ((type & 1) == 0) ? 2 : 4, &high, &low))
+            {
+                return NULL;
+            }
+            return decode_msgpack_container(input, type >= 0xDE, (size_t)low);
+
+        default:
+            /* extension types and the unused 0xC1 */
+            return NULL;
+    }
+}
+
+CJSON_PUBLIC(cJSON *) cJSON_DecodeBinary(const unsigned char *data, size_t length, int format)
+{
+    binary_buffer input = { 0, 0, 0, 0 };
+    cJSON *item = NULL;
+
+    if (data == NULL)
+    {
+        return NULL;
+    }
+
+    input.content = data;
+    input.length = length;
+    if (format == cJSON_CBOR)
+    {
+        item = decode_cbor(&input);
+    }
+    else if (format == cJSON_MessagePack)
+    {
+        item = decode_msgpack(&input);
+    }
+
+    /* one value that spans all of data */
+    if ((item != NULL) && (input.offset != input.length))
+    {
+        cJSON_Delete(item);
+        return NULL;
+    }
+
+    return item;
+}
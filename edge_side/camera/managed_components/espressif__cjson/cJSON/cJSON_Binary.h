@@ -0,0 +1,85 @@
+/*
+  Copyright (c) 2009-2017 Dave Gamble and cJSON contributors
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#ifndef cJSON_Binary__h
+#define cJSON_Binary__h
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "cJSON.h"
+
+/* Binary encodings of cJSON trees. Allocations go through cJSON_malloc/cJSON_free, so cJSON_InitHooks applies. */
+#define cJSON_CBOR        0 /* RFC 8949 */
+#define cJSON_MessagePack 1
+
+/* Item count for cJSON_BinaryStartArray/cJSON_BinaryStartObject when it isn't known up front (CBOR only). */
+#define cJSON_BinaryIndefinite ((size_t)-1)
+
+/* Encode item into a buffer allocated with cJSON_malloc, *length is set to its size. Raw items can't be encoded.
+ * Numbers become integers when they are whole and within +-2^53, otherwise the shortest float that holds them exactly. */
+CJSON_PUBLIC(unsigned char *) cJSON_EncodeBinary(const cJSON *item, int format, size_t *length);
+/* Encode into a buffer of the caller, returns the number of bytes written or 0 if it doesn't fit. */
+CJSON_PUBLIC(size_t) cJSON_EncodeBinaryToBuffer(const cJSON *item, int format, unsigned char *buffer, size_t length);
+/* Decode exactly one value spanning all of data. Byte strings become base64url strings (RFC 8949 section 6.1),
+ * CBOR tags are skipped and undefined becomes null. Map keys have to be strings. */
+CJSON_PUBLIC(cJSON *) cJSON_DecodeBinary(const unsigned char *data, size_t length, int format);
+
+/* Streaming encoder, writes values one after the other without building a tree.
+ * Output is collected in buffer and handed to sink whenever the buffer is full, without a sink running out of space fails.
+ * With buffer NULL and length 0 the writer only counts the bytes, e.g. to allocate the exact size.
+ * Errors are sticky: after a failed call everything fails and cJSON_FinishBinaryWriter returns 0. */
+typedef struct cJSON_BinaryWriter
+{
+    /* private */
+    unsigned char *buffer;
+    size_t length;
+    size_t offset;
+    size_t written;
+    int format;
+    cJSON_bool failed;
+    cJSON_PrintSink sink;
+    void *sink_context;
+} cJSON_BinaryWriter;
+
+CJSON_PUBLIC(void) cJSON_InitBinaryWriter(cJSON_BinaryWriter *writer, int format, unsigned char *buffer, size_t length, cJSON_PrintSink sink, void *context);
+CJSON_PUBLIC(cJSON_bool) cJSON_BinaryWriteNull(cJSON_BinaryWriter *writer);
+CJSON_PUBLIC(cJSON_bool) cJSON_BinaryWriteBool(cJSON_BinaryWriter *writer, cJSON_bool value);
+CJSON_PUBLIC(cJSON_bool) cJSON_BinaryWriteNumber(cJSON_BinaryWriter *writer, double number);
+CJSON_PUBLIC(cJSON_bool) cJSON_BinaryWriteString(cJSON_BinaryWriter *writer, const char *string);
+/* An object with count members is followed by count pairs of cJSON_BinaryWriteString for the key and the value.
+ * Indefinite arrays and objects are closed with cJSON_BinaryWriteEnd. */
+CJSON_PUBLIC(cJSON_bool) cJSON_BinaryStartArray(cJSON_BinaryWriter *writer, size_t count);
+CJSON_PUBLIC(cJSON_bool) cJSON_BinaryStartObject(cJSON_BinaryWriter *writer, size_t count);
+CJSON_PUBLIC(cJSON_bool) cJSON_BinaryWriteEnd(cJSON_BinaryWriter *writer);
+/* Encode an existing tree as the next value. */
+CJSON_PUBLIC(cJSON_bool) cJSON_BinaryWriteItem(cJSON_BinaryWriter *writer, const cJSON *item);
+/* Hands the rest of the buffer to the sink. Returns the total number of bytes written, 0 on failure. */
+CJSON_PUBLIC(size_t) cJSON_FinishBinaryWriter(cJSON_BinaryWriter *writer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
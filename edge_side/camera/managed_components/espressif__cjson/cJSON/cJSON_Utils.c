@@ -298,17 +298,14 @@ static cJSON_bool decode_array_index_from_pointer(const unsigned char * const po
     return 1;
 }
 
-static cJSON *get_item_from_pointer(cJSON * const object, const char * pointer, const cJSON_bool case_sensitive)
+/* follow the tokens of pointer up to length, anything after that is ignored */
+static cJSON *follow_pointer(cJSON * const object, const char *pointer, const size_t length, const cJSON_bool case_sensitive)
 {
+    const char * const end = pointer + length;
     cJSON *current_element = object;
 
-    if (pointer == NULL)
-    {
-        return NULL;
-    }
-
     /* follow path of the pointer */
-    while ((pointer[0] == '/') && (current_element != NULL))
+    while ((pointer < end) && (pointer[0] == '/') && (current_element != NULL))
     {
         pointer++;
         if (cJSON_IsArray(current_element))
@@ -336,7 +333,7 @@ static cJSON *get_item_from_pointer(cJSON * const object, const char * pointer,
         }
 
         /* skip to the next path token or end of string */
-        while ((pointer[0] != '\0') && (pointer[0] != '/'))
+        while ((pointer < end) && (pointer[0] != '/'))
         {
             pointer++;
         }
@@ -345,139 +342,24 @@ static cJSON *get_item_from_pointer(cJSON * const object, const char * pointer,
     return current_element;
 }
 
-CJSON_PUBLIC(cJSON *) cJSONUtils_GetPointer(cJSON * const object, const char *pointer)
-{
-    return get_item_from_pointer(object, pointer, false);
-}
-
-CJSON_PUBLIC(cJSON *) cJSONUtils_GetPointerCaseSensitive(cJSON * const object, const char *pointer)
-{
-    return get_item_from_pointer(object, pointer, true);
-}
-
-/* JSON Patch implementation. */
-static void decode_pointer_inplace(unsigned char *string)
+static cJSON *get_item_from_pointer(cJSON * const object, const char * pointer, const cJSON_bool case_sensitive)
 {
-    unsigned char *decoded_string = string;
-
-    if (string == NULL) {
-        return;
-    }
-
-    for (; *string; (void)decoded_string++, string++)
+    if (pointer == NULL)
     {
-        if (string[0] == '~')
-        {
-            if (string[1] == '0')
-            {
-                decoded_string[0] = '~';
-            }
-            else if (string[1] == '1')
-            {
-                decoded_string[1] = '/';
-            }
-            else
-            {
-                /* invalid escape sequence */
-                return;
-            }
-
-            string++;
-        }
+        return NULL;
     }
 
-    decoded_string[0] = '\0';
+    return follow_pointer(object, pointer, strlen(pointer), case_sensitive);
 }
 
-/* non-broken cJSON_DetachItemFromArray */
-static cJSON *detach_item_from_array(cJSON *array, size_t which)
+CJSON_PUBLIC(cJSON *) cJSONUtils_GetPointer(cJSON * const object, const char *pointer)
 {
-    cJSON *c = array->child;
-    while (c && (which > 0))
-    {
-        c = c->next;
-        which--;
-    }
-    if (!c)
-    {
-        /* item doesn't exist */
-        return NULL;
-    }
-    if (c != array->child)
-    {
-        /* not the first element */
-        c->prev->next = c->next;
-    }
-    if (c->next)
-    {
-        c->next->prev = c->prev;
-    }
-    if (c == array->child)
-    {
-        array->child = c->next;
-    }
-    else if (c->next == NULL)
-    {
-        array->child->prev = c->prev;
-    }
-    /* make sure the detached item doesn't point anywhere anymore */
-    c->prev = c->next = NULL;
-
-    return c;
+    return get_item_from_pointer(object, pointer, false);
 }
 
-/* detach an item at the given path */
-static cJSON *detach_path(cJSON *object, const unsigned char *path, const cJSON_bool case_sensitive)
+CJSON_PUBLIC(cJSON *) cJSONUtils_GetPointerCaseSensitive(cJSON * const object, const char *pointer)
 {
-    unsigned char *parent_pointer = NULL;
-    unsigned char *child_pointer = NULL;
-    cJSON *parent = NULL;
-    cJSON *detached_item = NULL;
-
-    /* copy path and split it in parent and child */
-    parent_pointer = cJSONUtils_strdup(path);
-    if (parent_pointer == NULL) {
-        goto cleanup;
-    }
-
-    child_pointer = (unsigned char*)strrchr((char*)parent_pointer, '/'); /* last '/' */
-    if (child_pointer == NULL)
-    {
-        goto cleanup;
-    }
-    /* split strings */
-    child_pointer[0] = '\0';
-    child_pointer++;
-
-    parent = get_item_from_pointer(object, (char*)parent_pointer, case_sensitive);
-    decode_pointer_inplace(child_pointer);
-
-    if (cJSON_IsArray(parent))
-    {
-        size_t index = 0;
-        if (!decode_array_index_from_pointer(child_pointer, &index))
-        {
-            goto cleanup;
-        }
-        detached_item = detach_item_from_array(parent, index);
-    }
-    else if (cJSON_IsObject(parent))
-    {
-        detached_item = cJSON_DetachItemFromObject(parent, (char*)child_pointer);
-    }
-    else
-    {
-        /* Couldn't find object to remove child from. */
-        goto cleanup;
-    }
-
-cleanup:
-    if (parent_pointer != NULL)
-    {
-        cJSON_free(parent_pointer);
-    }
-
-    return detached_item;
+    return get_item_from_pointer(object, pointer, true);
 }
 
 /* sort lists using mergesort */
@@ -594,11 +476,22 @@ static cJSON *sort_list(cJSON *list, const cJSON_bool case_sensitive)
 
 static void sort_object(cJSON * const object, const cJSON_bool case_sensitive)
 {
+    cJSON *last = NULL;
+
     if (object == NULL)
     {
         return;
     }
     object->child = sort_list(object->child, case_sensitive);
+
+    /* the first element's prev points to the last one, which adding items relies on */
+    if (object->child != NULL)
+    {
+        for (last = object->child; last->next != NULL; last = last->next)
+        {
+        }
+        object->child->prev = last;
+    }
 }
 
 static cJSON_bool compare_json(cJSON *a, cJSON *b, const cJSON_bool case_sensitive)
@@ -737,6 +630,176 @@ static cJSON *get_object_item(const cJSON * const object, const char* name, cons
     return cJSON_GetObjectItem(object, name);
 }
 
+/* JSON Patch implementation. */
+
+/* decode the ~0 and ~1 escape sequences of the last token of a pointer.
+ * Tokens without escapes are returned as they are, the others are decoded into buffer
+ * if they fit and into memory that is returned in allocated if they don't.
+ * NULL for invalid escape sequences. */
+static const unsigned char *decode_pointer_token(const unsigned char * const token, unsigned char * const buffer, const size_t buffer_size, unsigned char ** const allocated)
+{
+    const unsigned char *source = token;
+    unsigned char *decoded = buffer;
+    unsigned char *destination = NULL;
+    size_t length = 0;
+
+    *allocated = NULL;
+    if (strchr((const char*)token, '~') == NULL)
+    {
+        return token;
+    }
+
+    length = strlen((const char*)token);
+    if (length >= buffer_size)
+    {
+        decoded = (unsigned char*)cJSON_malloc(length + sizeof(""));
+        if (decoded == NULL)
+        {
+            return NULL;
+        }
+        *allocated = decoded;
+    }
+
+    for (destination = decoded; source[0] != '\0'; (void)source++, destination++)
+    {
+        if (source[0] == '~')
+        {
+            if ((source[1] != '0') && (source[1] != '1'))
+            {
+                /* invalid escape sequence */
+                return NULL;
+            }
+            destination[0] = (source[1] == '0') ? '~' : '/';
+            source++;
+        }
+        else
+        {
+            destination[0] = source[0];
+        }
+    }
+    destination[0] = '\0';
+
+    return decoded;
+}
+
+/* the child of parent that a decoded pointer token refers to */
+static cJSON *get_child_from_token(const cJSON * const parent, const unsigned char * const token, const cJSON_bool case_sensitive)
+{
+    if (cJSON_IsArray(parent))
+    {
+        size_t index = 0;
+        if (!decode_array_index_from_pointer(token, &index))
+        {
+            return NULL;
+        }
+
+        return get_array_item(parent, index);
+    }
+
+    if (cJSON_IsObject(parent))
+    {
+        return get_object_item(parent, (const char*)token, case_sensitive);
+    }
+
+    return NULL;
+}
+
+/* The parent that the last patch modified. Patches only ever change children of the parent
+ * they resolved, so it stays valid for the next patch with the same parent pointer, which
+ * is what consecutive updates of one object or array look like. */
+typedef struct
+{
+    const char *path;
+    size_t length;
+    cJSON *parent;
+} parent_cache;
+
+/* resolve the parent of the last token of path, token is set to that last (still encoded) token */
+static cJSON *resolve_parent(cJSON * const object, const char * const path, const unsigned char ** const token, parent_cache * const cache, const cJSON_bool case_sensitive)
+{
+    const char *last_slash = strrchr(path, '/');
+    size_t length = 0;
+
+    if (last_slash == NULL)
+    {
+        return NULL;
+    }
+    length = (size_t)(last_slash - path);
+    *token = (const unsigned char*)last_slash + 1;
+
+    if ((cache->parent == NULL) || (cache->length != length) || (strncmp(cache->path, path, length) != 0))
+    {
+        cache->parent = follow_pointer(object, path, length, case_sensitive);
+        cache->path = path;
+        cache->length = length;
+    }
+
+    return cache->parent;
+}
+
+/* give item its key (NULL for array elements) before it is linked into a parent */
+static cJSON_bool set_item_key(cJSON * const item, const unsigned char * const key)
+{
+    unsigned char *copy = NULL;
+
+    if (key != NULL)
+    {
+        copy = cJSONUtils_strdup(key);
+        if (copy == NULL)
+        {
+            return false;
+        }
+    }
+
+    if (!(item->type & cJSON_StringIsConst) && (item->string != NULL))
+    {
+        cJSON_free(item->string);
+    }
+    item->string = (char*)copy;
+    item->type &= ~cJSON_StringIsConst;
+
+    return true;
+}
+
+/* replace child with replacement where it is, so it keeps its position and the object index stays valid */
+static cJSON_bool replace_child(cJSON * const parent, cJSON * const child, cJSON * const replacement)
+{
+    if (!set_item_key(replacement, cJSON_IsObject(parent) ? (const unsigned char*)child->string : NULL))
+    {
+        return false;
+    }
+
+    return cJSON_ReplaceItemViaPointer(parent, child, replacement);
+}
+
+/* find the item at path through the parent cache, parent is set to its parent */
+static cJSON *find_item(cJSON * const object, const char * const path, cJSON ** const parent, parent_cache * const cache, const cJSON_bool case_sensitive)
+{
+    const unsigned char *token = NULL;
+    const unsigned char *key = NULL;
+    unsigned char *allocated_key = NULL;
+    unsigned char key_buffer[64];
+    cJSON *item = NULL;
+
+    *parent = resolve_parent(object, path, &token, cache, case_sensitive);
+    if (*parent == NULL)
+    {
+        return NULL;
+    }
+
+    key = decode_pointer_token(token, key_buffer, sizeof(key_buffer), &allocated_key);
+    if (key != NULL)
+    {
+        item = get_child_from_token(*parent, key, case_sensitive);
+    }
+    if (allocated_key != NULL)
+    {
+        cJSON_free(allocated_key);
+    }
+
+    return item;
+}
+
 enum patch_operation { INVALID, ADD, REMOVE, REPLACE, MOVE, COPY, TEST };
 
 static enum patch_operation decode_patch_operation(const cJSON * const patch, const cJSON_bool case_sensitive)
@@ -788,6 +851,8 @@ static void overwrite_item(cJSON * const root, const cJSON replacement)
         return;
     }
 
+    /* an index lives in valuestring */
+    cJSON_DisableObjectIndex(root);
     if (root->string != NULL)
     {
         cJSON_free(root->string);
@@ -804,14 +869,17 @@ static void overwrite_item(cJSON * const root, const cJSON replacement)
     memcpy(root, &replacement, sizeof(cJSON));
 }
 
-static int apply_patch(cJSON *object, const cJSON *patch, const cJSON_bool case_sensitive)
+static int apply_patch(cJSON *object, const cJSON *patch, parent_cache * const cache, const cJSON_bool case_sensitive)
 {
     cJSON *path = NULL;
     cJSON *value = NULL;
     cJSON *parent = NULL;
+    cJSON *child = NULL;
     enum patch_operation opcode = INVALID;
-    unsigned char *parent_pointer = NULL;
-    unsigned char *child_pointer = NULL;
+    const unsigned char *token = NULL;
+    const unsigned char *key = NULL;
+    unsigned char *allocated_key = NULL;
+    unsigned char key_buffer[64];
     int status = 0;
 
     path = get_object_item(patch, "path", case_sensitive);
@@ -838,6 +906,9 @@ static int apply_patch(cJSON *object, const cJSON *patch, const cJSON_bool case_
     /* special case for replacing the root */
     if (path->valuestring[0] == '\0')
     {
+        /* the cached parent goes away with the old root */
+        cache->parent = NULL;
+
         if (opcode == REMOVE)
         {
             static const cJSON invalid = { NULL, NULL, NULL, cJSON_Invalid, NULL, 0, 0, NULL};
@@ -886,16 +957,15 @@ static int apply_patch(cJSON *object, const cJSON *patch, const cJSON_bool case_
 
     if ((opcode == REMOVE) || (opcode == REPLACE))
     {
-        /* Get rid of old. */
-        cJSON *old_item = detach_path(object, (unsigned char*)path->valuestring, case_sensitive);
-        if (old_item == NULL)
+        child = find_item(object, path->valuestring, &parent, cache, case_sensitive);
+        if (child == NULL)
         {
             status = 13;
             goto cleanup;
         }
-        cJSON_Delete(old_item);
         if (opcode == REMOVE)
         {
+            cJSON_Delete(cJSON_DetachItemViaPointer(parent, child));
             /* For Remove, this job is done. */
             status = 0;
             goto cleanup;
@@ -906,7 +976,7 @@ static int apply_patch(cJSON *object, const cJSON *patch, const cJSON_bool case_
     if ((opcode == MOVE) || (opcode == COPY))
     {
         cJSON *from = get_object_item(patch, "from", case_sensitive);
-        if (from == NULL)
+        if (!cJSON_IsString(from))
         {
             /* missing "from" for copy/move. */
             status = 4;
@@ -915,7 +985,11 @@ static int apply_patch(cJSON *object, const cJSON *patch, const cJSON_bool case_
 
         if (opcode == MOVE)
         {
-            value = detach_path(object, (unsigned char*)from->valuestring, case_sensitive);
+            value = find_item(object, from->valuestring, &parent, cache, case_sensitive);
+            if (value != NULL)
+            {
+                cJSON_DetachItemViaPointer(parent, value);
+            }
         }
         if (opcode == COPY)
         {
@@ -956,23 +1030,21 @@ static int apply_patch(cJSON *object, const cJSON *patch, const cJSON_bool case_
         }
     }
 
-    /* Now, just add "value" to "path". */
-
-    /* split pointer in parent and child */
-    parent_pointer = cJSONUtils_strdup((unsigned char*)path->valuestring);
-    if (parent_pointer) {
-        child_pointer = (unsigned char*)strrchr((char*)parent_pointer, '/');
-    }
-    if (child_pointer != NULL)
+    if (opcode == REPLACE)
     {
-        child_pointer[0] = '\0';
-        child_pointer++;
+        /* the parent is still the one found above, replace the old value in place */
+        if (!replace_child(parent, child, value))
+        {
+            status = 8;
+            goto cleanup;
+        }
+        value = NULL;
+        goto cleanup;
     }
-    parent = get_item_from_pointer(object, (char*)parent_pointer, case_sensitive);
-    decode_pointer_inplace(child_pointer);
 
-    /* add, remove, replace, move, copy, test. */
-    if ((parent == NULL) || (child_pointer == NULL))
+    /* Now, just add "value" to "path". */
+    parent = resolve_parent(object, path->valuestring, &token, cache, case_sensitive);
+    if (parent == NULL)
     {
         /* Couldn't find object to add to. */
         status = 9;
@@ -980,7 +1052,9 @@ static int apply_patch(cJSON *object, const cJSON *patch, const cJSON_bool case_
     }
     else if (cJSON_IsArray(parent))
     {
-        if (strcmp((char*)child_pointer, "-") == 0)
+        /* array elements have no key */
+        set_item_key(value, NULL);
+        if (strcmp((const char*)token, "-") == 0)
         {
             cJSON_AddItemToArray(parent, value);
             value = NULL;
@@ -988,7 +1062,7 @@ static int apply_patch(cJSON *object, const cJSON *patch, const cJSON_bool case_
         else
         {
             size_t index = 0;
-            if (!decode_array_index_from_pointer(child_pointer, &index))
+            if (!decode_array_index_from_pointer(token, &index))
             {
                 status = 11;
                 goto cleanup;
@@ -1004,15 +1078,29 @@ static int apply_patch(cJSON *object, const cJSON *patch, const cJSON_bool case_
     }
     else if (cJSON_IsObject(parent))
     {
-        if (case_sensitive)
+        key = decode_pointer_token(token, key_buffer, sizeof(key_buffer), &allocated_key);
+        if (key == NULL)
         {
-            cJSON_DeleteItemFromObjectCaseSensitive(parent, (char*)child_pointer);
+            /* invalid escape sequence in the key. */
+            status = 9;
+            goto cleanup;
         }
-        else
+
+        /* an existing member is replaced where it is */
+        child = get_object_item(parent, (const char*)key, case_sensitive);
+        if (child != NULL)
+        {
+            if (!replace_child(parent, child, value))
+            {
+                status = 8;
+                goto cleanup;
+            }
+        }
+        else if (!cJSON_AddItemToObject(parent, (const char*)key, value))
         {
-            cJSON_DeleteItemFromObject(parent, (char*)child_pointer);
+            status = 8;
+            goto cleanup;
         }
-        cJSON_AddItemToObject(parent, (char*)child_pointer, value);
         value = NULL;
     }
     else /* parent is not an object */
@@ -1027,16 +1115,17 @@ cleanup:
     {
         cJSON_Delete(value);
     }
-    if (parent_pointer != NULL)
+    if (allocated_key != NULL)
     {
-        cJSON_free(parent_pointer);
+        cJSON_free(allocated_key);
     }
 
     return status;
 }
 
-CJSON_PUBLIC(int) cJSONUtils_ApplyPatches(cJSON * const object, const cJSON * const patches)
+static int apply_patches(cJSON * const object, const cJSON * const patches, const cJSON_bool case_sensitive)
 {
+    parent_cache cache = { NULL, 0, NULL };
     const cJSON *current_patch = NULL;
     int status = 0;
 
@@ -1053,7 +1142,7 @@ CJSON_PUBLIC(int) cJSONUtils_ApplyPatches(cJSON * const object, const cJSON * co
 
     while (current_patch != NULL)
     {
-        status = apply_patch(object, current_patch, false);
+        status = apply_patch(object, current_patch, &cache, case_sensitive);
         if (status != 0)
         {
             return status;
@@ -1064,33 +1153,14 @@ CJSON_PUBLIC(int) cJSONUtils_ApplyPatches(cJSON * const object, const cJSON * co
     return 0;
 }
 
-CJSON_PUBLIC(int) cJSONUtils_ApplyPatchesCaseSensitive(cJSON * const object, const cJSON * const patches)
+CJSON_PUBLIC(int) cJSONUtils_ApplyPatches(cJSON * const object, const cJSON * const patches)
 {
-    const cJSON *current_patch = NULL;
-    int status = 0;
-
-    if (!cJSON_IsArray(patches))
-    {
-        /* malformed patches. */
-        return 1;
-    }
-
-    if (patches != NULL)
-    {
-        current_patch = patches->child;
-    }
-
-    while (current_patch != NULL)
-    {
-        status = apply_patch(object, current_patch, true);
-        if (status != 0)
-        {
-            return status;
-        }
-        current_patch = current_patch->next;
-    }
+    return apply_patches(object, patches, false);
+}
 
-    return 0;
+CJSON_PUBLIC(int) cJSONUtils_ApplyPatchesCaseSensitive(cJSON * const object, const cJSON * const patches)
+{
+    return apply_patches(object, patches, true);
 }
 
 static void compose_patch(cJSON * const patches, const unsigned char * const operation, const unsigned char * const path, const unsigned char *suffix, const cJSON * const value)
@@ -1138,8 +1208,62 @@ CJSON_PUBLIC(void) cJSONUtils_AddPatchToArray(cJSON * const array, const char *
     compose_patch(array, (const unsigned char*)operation, (const unsigned char*)path, NULL, value);
 }
 
-static void create_patches(cJSON * const patches, const unsigned char * const path, cJSON * const from, cJSON * const to, const cJSON_bool case_sensitive)
+/* the pointer of the value create_patches is at, tokens are appended on the way down
+ * and cut off again on the way back up, so there is one allocation for all paths */
+typedef struct
+{
+    unsigned char *pointer;
+    size_t length;
+    size_t size;
+} pointer_buffer;
+
+static cJSON_bool push_pointer_token(pointer_buffer * const path, const unsigned char * const token)
+{
+    size_t required = path->length + pointer_encoded_length(token) + sizeof("/");
+
+    if (required > path->size)
+    {
+        size_t new_size = (2 * path->size > required) ? 2 * path->size : required;
+        unsigned char *new_pointer = (unsigned char*)cJSON_malloc(new_size);
+        if (new_pointer == NULL)
+        {
+            return false;
+        }
+        memcpy(new_pointer, path->pointer, path->length + sizeof(""));
+        cJSON_free(path->pointer);
+        path->pointer = new_pointer;
+        path->size = new_size;
+    }
+
+    path->pointer[path->length] = '/';
+    encode_string_as_pointer(path->pointer + path->length + 1, token);
+    path->length = required - sizeof("");
+
+    return true;
+}
+
+static void pop_pointer_token(pointer_buffer * const path, const size_t length)
+{
+    path->length = length;
+    path->pointer[length] = '\0';
+}
+
+/* compose a patch for the child token of the current path */
+static void compose_child_patch(cJSON * const patches, const unsigned char * const operation, pointer_buffer * const path, const unsigned char * const token, const cJSON * const value)
+{
+    const size_t length = path->length;
+
+    if (push_pointer_token(path, token))
+    {
+        compose_patch(patches, operation, path->pointer, NULL, value);
+        pop_pointer_token(path, length);
+    }
+}
+
+static void create_patches(cJSON * const patches, pointer_buffer * const path, cJSON * const from, cJSON * const to, const cJSON_bool case_sensitive)
 {
+    const size_t path_length = path->length;
+
     if ((from == NULL) || (to == NULL))
     {
         return;
@@ -1147,7 +1271,7 @@ static void create_patches(cJSON * const patches, const unsigned char * const pa
 
     if ((from->type & 0xFF) != (to->type & 0xFF))
     {
-        compose_patch(patches, (const unsigned char*)"replace", path, 0, to);
+        compose_patch(patches, (const unsigned char*)"replace", path->pointer, 0, to);
         return;
     }
 
@@ -1156,14 +1280,14 @@ static void create_patches(cJSON * const patches, const unsigned char * const pa
         case cJSON_Number:
             if ((from->valueint != to->valueint) || !compare_double(from->valuedouble, to->valuedouble))
             {
-                compose_patch(patches, (const unsigned char*)"replace", path, NULL, to);
+                compose_patch(patches, (const unsigned char*)"replace", path->pointer, NULL, to);
             }
             return;
 
         case cJSON_String:
             if (strcmp(from->valuestring, to->valuestring) != 0)
             {
-                compose_patch(patches, (const unsigned char*)"replace", path, NULL, to);
+                compose_patch(patches, (const unsigned char*)"replace", path->pointer, NULL, to);
             }
             return;
 
@@ -1172,7 +1296,7 @@ static void create_patches(cJSON * const patches, const unsigned char * const pa
             size_t index = 0;
             cJSON *from_child = from->child;
             cJSON *to_child = to->child;
-            unsigned char *new_path = (unsigned char*)cJSON_malloc(strlen((const char*)path) + 20 + sizeof("/")); /* Allow space for 64bit int. log10(2^64) = 20 */
+            unsigned char index_token[24]; /* Allow space for 64bit int. log10(2^64) = 20 */
 
             /* generate patches for all array elements that exist in both "from" and "to" */
             for (index = 0; (from_child != NULL) && (to_child != NULL); (void)(from_child = from_child->next), (void)(to_child = to_child->next), index++)
@@ -1182,11 +1306,16 @@ static void create_patches(cJSON * const patches, const unsigned char * const pa
                  * if size_t is an alias of unsigned long, or if it is bigger */
                 if (index > ULONG_MAX)
                 {
-                    cJSON_free(new_path);
                     return;
                 }
-                sprintf((char*)new_path, "%s/%lu", path, (unsigned long)index); /* path of the current array element */
-                create_patches(patches, new_path, from_child, to_child, case_sensitive);
+                sprintf((char*)index_token, "%lu", (unsigned long)index);
+                /* path of the current array element */
+                if (!push_pointer_token(path, index_token))
+                {
+                    return;
+                }
+                create_patches(patches, path, from_child, to_child, case_sensitive);
+                pop_pointer_token(path, path_length);
             }
 
             /* remove leftover elements from 'from' that are not in 'to' */
@@ -1197,18 +1326,16 @@ static void create_patches(cJSON * const patches, const unsigned char * const pa
                  * if size_t is an alias of unsigned long, or if it is bigger */
                 if (index > ULONG_MAX)
                 {
-                    cJSON_free(new_path);
                     return;
                 }
-                sprintf((char*)new_path, "%lu", (unsigned long)index);
-                compose_patch(patches, (const unsigned char*)"remove", path, new_path, NULL);
+                sprintf((char*)index_token, "%lu", (unsigned long)index);
+                compose_child_patch(patches, (const unsigned char*)"remove", path, index_token, NULL);
             }
             /* add new elements in 'to' that were not in 'from' */
             for (; (to_child != NULL); (void)(to_child = to_child->next), index++)
             {
-                compose_patch(patches, (const unsigned char*)"add", path, (const unsigned char*)"-", to_child);
+                compose_child_patch(patches, (const unsigned char*)"add", path, (const unsigned char*)"-", to_child);
             }
-            cJSON_free(new_path);
             return;
         }
 
@@ -1240,17 +1367,13 @@ static void create_patches(cJSON * const patches, const unsigned char * const pa
 
                 if (diff == 0)
                 {
-                    /* both object keys are the same */
-                    size_t path_length = strlen((const char*)path);
-                    size_t from_child_name_length = pointer_encoded_length((unsigned char*)from_child->string);
-                    unsigned char *new_path = (unsigned char*)cJSON_malloc(path_length + from_child_name_length + sizeof("/"));
-
-                    sprintf((char*)new_path, "%s/", path);
-                    encode_string_as_pointer(new_path + path_length + 1, (unsigned char*)from_child->string);
-
-                    /* create a patch for the element */
-                    create_patches(patches, new_path, from_child, to_child, case_sensitive);
-                    cJSON_free(new_path);
+                    /* both object keys are the same, create a patch for the element */
+                    if (!push_pointer_token(path, (unsigned char*)from_child->string))
+                    {
+                        return;
+                    }
+                    create_patches(patches, path, from_child, to_child, case_sensitive);
+                    pop_pointer_token(path, path_length);
 
                     from_child = from_child->next;
                     to_child = to_child->next;
@@ -1258,14 +1381,14 @@ static void create_patches(cJSON * const patches, const unsigned char * const pa
                 else if (diff < 0)
                 {
                     /* object element doesn't exist in 'to' --> remove it */
-                    compose_patch(patches, (const unsigned char*)"remove", path, (unsigned char*)from_child->string, NULL);
+                    compose_child_patch(patches, (const unsigned char*)"remove", path, (unsigned char*)from_child->string, NULL);
 
                     from_child = from_child->next;
                 }
                 else
                 {
                     /* object element doesn't exist in 'from' --> add it */
-                    compose_patch(patches, (const unsigned char*)"add", path, (unsigned char*)to_child->string, to_child);
+                    compose_child_patch(patches, (const unsigned char*)"add", path, (unsigned char*)to_child->string, to_child);
 
                     to_child = to_child->next;
                 }
@@ -1278,8 +1401,9 @@ static void create_patches(cJSON * const patches, const unsigned char * const pa
     }
 }
 
-CJSON_PUBLIC(cJSON *) cJSONUtils_GeneratePatches(cJSON * const from, cJSON * const to)
+static cJSON *generate_patches(cJSON * const from, cJSON * const to, const cJSON_bool case_sensitive)
 {
+    pointer_buffer path = { NULL, 0, 0 };
     cJSON *patches = NULL;
 
     if ((from == NULL) || (to == NULL))
@@ -1287,27 +1411,31 @@ CJSON_PUBLIC(cJSON *) cJSONUtils_GeneratePatches(cJSON * const from, cJSON * con
         return NULL;
     }
 
-    patches = cJSON_CreateArray();
-    create_patches(patches, (const unsigned char*)"", from, to, false);
-
-    return patches;
-}
-
-CJSON_PUBLIC(cJSON *) cJSONUtils_GeneratePatchesCaseSensitive(cJSON * const from, cJSON * const to)
-{
-    cJSON *patches = NULL;
-
-    if ((from == NULL) || (to == NULL))
+    path.size = 256;
+    path.pointer = (unsigned char*)cJSON_malloc(path.size);
+    if (path.pointer == NULL)
     {
         return NULL;
     }
+    path.pointer[0] = '\0';
 
     patches = cJSON_CreateArray();
-    create_patches(patches, (const unsigned char*)"", from, to, true);
+    create_patches(patches, &path, from, to, case_sensitive);
+    cJSON_free(path.pointer);
 
     return patches;
 }
 
+CJSON_PUBLIC(cJSON *) cJSONUtils_GeneratePatches(cJSON * const from, cJSON * const to)
+{
+    return generate_patches(from, to, false);
+}
+
+CJSON_PUBLIC(cJSON *) cJSONUtils_GeneratePatchesCaseSensitive(cJSON * const from, cJSON * const to)
+{
+    return generate_patches(from, to, true);
+}
+
 CJSON_PUBLIC(void) cJSONUtils_SortObject(cJSON * const object)
 {
     sort_object(object, false);
@@ -1318,63 +1446,87 @@ CJSON_PUBLIC(void) cJSONUtils_SortObjectCaseSensitive(cJSON * const object)
     sort_object(object, true);
 }
 
-static cJSON *merge_patch(cJSON *target, const cJSON * const patch, const cJSON_bool case_sensitive)
+static cJSON *merge_patch(cJSON *target, const cJSON * const patch, const cJSON_bool case_sensitive);
+
+/* merge an object patch into an object, members that stay are updated where they are */
+static cJSON_bool merge_object_patch(cJSON * const target, const cJSON * const patch, const cJSON_bool case_sensitive)
 {
     cJSON *patch_child = NULL;
 
-    if (!cJSON_IsObject(patch))
+    for (patch_child = patch->child; patch_child != NULL; patch_child = patch_child->next)
     {
-        /* scalar value, array or NULL, just duplicate */
-        cJSON_Delete(target);
-        return cJSON_Duplicate(patch, 1);
-    }
-
-    if (!cJSON_IsObject(target))
-    {
-        cJSON_Delete(target);
-        target = cJSON_CreateObject();
-    }
+        cJSON *member = get_object_item(target, patch_child->string, case_sensitive);
+        cJSON *replacement = NULL;
 
-    patch_child = patch->child;
-    while (patch_child != NULL)
-    {
         if (cJSON_IsNull(patch_child))
         {
             /* NULL is the indicator to remove a value, see RFC7396 */
-            if (case_sensitive)
+            if (member != NULL)
             {
-                cJSON_DeleteItemFromObjectCaseSensitive(target, patch_child->string);
+                cJSON_Delete(cJSON_DetachItemViaPointer(target, member));
             }
-            else
+            continue;
+        }
+
+        if (cJSON_IsObject(patch_child) && cJSON_IsObject(member))
+        {
+            /* nested objects are patched in place instead of being rebuilt */
+            if (!merge_object_patch(member, patch_child, case_sensitive))
             {
-                cJSON_DeleteItemFromObject(target, patch_child->string);
+                return false;
             }
+            continue;
         }
-        else
+
+        replacement = merge_patch(NULL, patch_child, case_sensitive);
+        if (replacement == NULL)
         {
-            cJSON *replace_me = NULL;
-            cJSON *replacement = NULL;
+            return false;
+        }
 
-            if (case_sensitive)
-            {
-                replace_me = cJSON_DetachItemFromObjectCaseSensitive(target, patch_child->string);
-            }
-            else
+        if (member != NULL)
+        {
+            if (!replace_child(target, member, replacement))
             {
-                replace_me = cJSON_DetachItemFromObject(target, patch_child->string);
+                cJSON_Delete(replacement);
+                return false;
             }
+        }
+        else if (!cJSON_AddItemToObject(target, patch_child->string, replacement))
+        {
+            cJSON_Delete(replacement);
+            return false;
+        }
+    }
 
-            replacement = merge_patch(replace_me, patch_child, case_sensitive);
-            if (replacement == NULL)
-            {
-                cJSON_Delete(target);
-                return NULL;
-            }
+    return true;
+}
 
-            cJSON_AddItemToObject(target, patch_child->string, replacement);
+static cJSON *merge_patch(cJSON *target, const cJSON * const patch, const cJSON_bool case_sensitive)
+{
+    if (!cJSON_IsObject(patch))
+    {
+        /* scalar value, array or NULL, just duplicate */
+        cJSON_Delete(target);
+        return cJSON_Duplicate(patch, 1);
+    }
+
+    if (!cJSON_IsObject(target))
+    {
+        cJSON_Delete(target);
+        target = cJSON_CreateObject();
+        if (target == NULL)
+        {
+            return NULL;
         }
-        patch_child = patch_child->next;
     }
+
+    if (!merge_object_patch(target, patch, case_sensitive))
+    {
+        cJSON_Delete(target);
+        return NULL;
+    }
+
     return target;
 }
 
@@ -1408,19 +1560,17 @@ static cJSON *generate_merge_patch(cJSON * const from, cJSON * const to, const c
 
     from_child = from->child;
     to_child = to->child;
-    patch = cJSON_CreateObject();
-    if (patch == NULL)
-    {
-        return NULL;
-    }
+    /* the patch object is only created for the first difference, unchanged subtrees don't allocate */
     while (from_child || to_child)
     {
+        cJSON *change = NULL;
+        const char *key = NULL;
         int diff;
         if (from_child != NULL)
         {
             if (to_child != NULL)
             {
-                diff = strcmp(from_child->string, to_child->string);
+                diff = compare_strings((unsigned char*)from_child->string, (unsigned char*)to_child->string, case_sensitive);
             }
             else
             {
@@ -1435,36 +1585,57 @@ static cJSON *generate_merge_patch(cJSON * const from, cJSON * const to, const c
         if (diff < 0)
         {
             /* from has a value that to doesn't have -> remove */
-            cJSON_AddItemToObject(patch, from_child->string, cJSON_CreateNull());
+            key = from_child->string;
+            change = cJSON_CreateNull();
 
             from_child = from_child->next;
         }
         else if (diff > 0)
         {
             /* to has a value that from doesn't have -> add to patch */
-            cJSON_AddItemToObject(patch, to_child->string, cJSON_Duplicate(to_child, 1));
+            key = to_child->string;
+            change = cJSON_Duplicate(to_child, 1);
 
             to_child = to_child->next;
         }
         else
         {
             /* object key exists in both objects */
-            if (!compare_json(from_child, to_child, case_sensitive))
+            key = to_child->string;
+            if (from_child == to_child)
+            {
+                /* the very same subtree */
+            }
+            else if (cJSON_IsObject(from_child) && cJSON_IsObject(to_child))
+            {
+                /* recursing finds the differences in the same walk that compares, NULL if there are none */
+                change = generate_merge_patch(from_child, to_child, case_sensitive);
+            }
+            else if (!compare_json(from_child, to_child, case_sensitive))
             {
-                /* not identical --> generate a patch */
-                cJSON_AddItemToObject(patch, to_child->string, cJSONUtils_GenerateMergePatch(from_child, to_child));
+                /* not identical --> replace */
+                change = cJSON_Duplicate(to_child, 1);
             }
 
             /* next key in the object */
             from_child = from_child->next;
             to_child = to_child->next;
         }
-    }
-    if (patch->child == NULL)
-    {
-        /* no patch generated */
-        cJSON_Delete(patch);
-        return NULL;
+
+        if (change == NULL)
+        {
+            continue;
+        }
+        if (patch == NULL)
+        {
+            patch = cJSON_CreateObject();
+            if (patch == NULL)
+            {
+                cJSON_Delete(change);
+                return NULL;
+            }
+        }
+        cJSON_AddItemToObject(patch, key, change);
     }
 
     return patch;
@@ -0,0 +1,213 @@
+/*
+  Copyright (c) 2009-2017 Dave Gamble and cJSON contributors
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity/examples/unity_config.h"
+#include "unity/src/unity.h"
+#include "common.h"
+
+static size_t allocation_count = 0;
+
+static void * CJSON_CDECL counting_malloc(size_t size)
+{
+    allocation_count++;
+    return malloc(size);
+}
+
+static void CJSON_CDECL normal_free(void *pointer)
+{
+    free(pointer);
+}
+
+static cJSON_Hooks counting_hooks = {
+    counting_malloc,
+    normal_free
+};
+
+static double arena_memory[512];
+
+static void arena_should_handle_null_and_tiny_buffers(void)
+{
+    cJSON_Arena arena;
+
+    cJSON_InitArena(NULL, arena_memory, sizeof(arena_memory));
+    cJSON_ResetArena(NULL);
+    TEST_ASSERT_EQUAL_UINT(0, cJSON_GetArenaUsage(NULL));
+
+    cJSON_InitArena(&arena, NULL, 0);
+    TEST_ASSERT_NULL(cJSON_ParseWithArena("{}", 3, &arena));
+    TEST_ASSERT_NULL(cJSON_CreateObjectInArena(&arena));
+    TEST_ASSERT_NULL(cJSON_ParseWithArena("{}", 3, NULL));
+
+    cJSON_InitArena(&arena, arena_memory, 1);
+    TEST_ASSERT_NULL(cJSON_CreateObjectInArena(&arena));
+}
+
+static void arena_should_parse_without_using_the_hooks(void)
+{
+    const char json[] = "{\"count\":3,\"boxes\":[[1.5,2,30,40],[5,6,70,80.25]],\"camera\":\"cam-\\u00e9\",\"ok\":true,\"none\":null}";
+    cJSON_Arena arena;
+    cJSON *root = NULL;
+    cJSON *boxes = NULL;
+    char *printed = NULL;
+
+    cJSON_InitArena(&arena, arena_memory, sizeof(arena_memory));
+
+    allocation_count = 0;
+    cJSON_InitHooks(&counting_hooks);
+    root = cJSON_ParseWithArena(json, sizeof(json), &arena);
+    TEST_ASSERT_EQUAL_UINT(0, allocation_count);
+    cJSON_InitHooks(NULL);
+
+    TEST_ASSERT_NOT_NULL(root);
+    TEST_ASSERT_BITS(cJSON_InArena, cJSON_InArena, root->type);
+    TEST_ASSERT_TRUE(cJSON_IsObject(root));
+    TEST_ASSERT_EQUAL_DOUBLE(3, cJSON_GetNumberValue(cJSON_GetObjectItemCaseSensitive(root, "count")));
+    TEST_ASSERT_EQUAL_STRING("cam-\xc3\xa9", cJSON_GetStringValue(cJSON_GetObjectItemCaseSensitive(root, "camera")));
+    TEST_ASSERT_TRUE(cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(root, "ok")));
+    TEST_ASSERT_TRUE(cJSON_IsNull(cJSON_GetObjectItemCaseSensitive(root, "none")));
+
+    boxes = cJSON_GetObjectItemCaseSensitive(root, "boxes");
+    TEST_ASSERT_EQUAL_INT(2, cJSON_GetArraySize(boxes));
+    TEST_ASSERT_BITS(cJSON_InArena, cJSON_InArena, cJSON_GetArrayItem(boxes, 1)->child->type);
+
+    printed = cJSON_PrintUnformatted(root);
+    TEST_ASSERT_EQUAL_STRING("{\"count\":3,\"boxes\":[[1.5,2,30,40],[5,6,70,80.25]],\"camera\":\"cam-\xc3\xa9\",\"ok\":true,\"none\":null}", printed);
+    free(printed);
+
+    /* deleting is harmless, the arena still owns everything */
+    cJSON_Delete(root);
+    TEST_ASSERT_TRUE(cJSON_GetArenaUsage(&arena) > 0);
+    cJSON_ResetArena(&arena);
+    TEST_ASSERT_EQUAL_UINT(0, cJSON_GetArenaUsage(&arena));
+}
+
+static void arena_should_give_back_space_after_failed_parse(void)
+{
+    cJSON_Arena arena;
+    size_t used = 0;
+
+    cJSON_InitArena(&arena, arena_memory, sizeof(arena_memory));
+    TEST_ASSERT_NOT_NULL(cJSON_ParseWithArena("[1,2,3]", 8, &arena));
+    used = cJSON_GetArenaUsage(&arena);
+
+    TEST_ASSERT_NULL(cJSON_ParseWithArena("{\"a\":[1,2,{\"b\":\"c\"", 19, &arena));
+    TEST_ASSERT_EQUAL_UINT(used, cJSON_GetArenaUsage(&arena));
+}
+
+static void arena_should_fail_when_out_of_space(void)
+{
+    static double small_memory[8];
+    cJSON_Arena arena;
+
+    cJSON_InitArena(&arena, small_memory, sizeof(small_memory));
+    TEST_ASSERT_NULL(cJSON_ParseWithArena("[1,2,3,4,5,6,7,8,9,10]", 23, &arena));
+    TEST_ASSERT_EQUAL_UINT(0, cJSON_GetArenaUsage(&arena));
+}
+
+static void arena_should_build_documents(void)
+{
+    cJSON_Arena arena;
+    cJSON *root = NULL;
+    cJSON *boxes = NULL;
+    char *printed = NULL;
+
+    cJSON_InitArena(&arena, arena_memory, sizeof(arena_memory));
+
+    allocation_count = 0;
+    cJSON_InitHooks(&counting_hooks);
+    root = cJSON_CreateObjectInArena(&arena);
+    boxes = cJSON_CreateArrayInArena(&arena);
+    TEST_ASSERT_TRUE(cJSON_AddItemToObjectInArena(&arena, root, "status", cJSON_CreateStringInArena(&arena, "ok")));
+    TEST_ASSERT_TRUE(cJSON_AddItemToObjectInArena(&arena, root, "count", cJSON_CreateNumberInArena(&arena, 2)));
+    TEST_ASSERT_TRUE(cJSON_AddItemToObjectInArena(&arena, root, "boxes", boxes));
+    TEST_ASSERT_TRUE(cJSON_AddItemToArray(boxes, cJSON_CreateNumberInArena(&arena, 0.5)));
+    TEST_ASSERT_TRUE(cJSON_AddItemToArray(boxes, cJSON_CreateBoolInArena(&arena, false)));
+    TEST_ASSERT_TRUE(cJSON_AddItemToArray(boxes, cJSON_CreateNullInArena(&arena)));
+    TEST_ASSERT_EQUAL_UINT(0, allocation_count);
+    cJSON_InitHooks(NULL);
+
+    TEST_ASSERT_BITS(cJSON_StringIsConst, cJSON_StringIsConst, cJSON_GetObjectItemCaseSensitive(root, "status")->type);
+
+    printed = cJSON_PrintUnformatted(root);
+    TEST_ASSERT_EQUAL_STRING("{\"status\":\"ok\",\"count\":2,\"boxes\":[0.5,false,null]}", printed);
+    free(printed);
+
+    cJSON_ResetArena(&arena);
+}
+
+static void arena_items_should_be_duplicated_onto_the_heap(void)
+{
+    cJSON_Arena arena;
+    cJSON *root = NULL;
+    cJSON *copy = NULL;
+    cJSON *name = NULL;
+
+    cJSON_InitArena(&arena, arena_memory, sizeof(arena_memory));
+    root = cJSON_ParseWithArena("{\"name\":\"camera\",\"list\":[1,2]}", 31, &arena);
+    TEST_ASSERT_NOT_NULL(root);
+
+    copy = cJSON_Duplicate(root, true);
+    TEST_ASSERT_NOT_NULL(copy);
+    name = cJSON_GetObjectItemCaseSensitive(copy, "name");
+    TEST_ASSERT_BITS(cJSON_InArena | cJSON_StringIsConst, 0, name->type);
+    TEST_ASSERT_TRUE(name->string < (char*)arena.buffer || name->string >= (char*)arena.buffer + arena.size);
+
+    /* overwriting the arena must not affect the copy */
+    memset(arena_memory, 0, sizeof(arena_memory));
+    cJSON_ResetArena(&arena);
+    TEST_ASSERT_EQUAL_STRING("camera", cJSON_GetStringValue(name));
+    TEST_ASSERT_EQUAL_INT(2, cJSON_GetArraySize(cJSON_GetObjectItemCaseSensitive(copy, "list")));
+
+    cJSON_Delete(copy);
+}
+
+static void arena_strings_should_only_be_set_in_place(void)
+{
+    cJSON_Arena arena;
+    cJSON *string = NULL;
+
+    cJSON_InitArena(&arena, arena_memory, sizeof(arena_memory));
+    string = cJSON_CreateStringInArena(&arena, "abc");
+    TEST_ASSERT_NOT_NULL(cJSON_SetValuestring(string, "xy"));
+    TEST_ASSERT_EQUAL_STRING("xy", string->valuestring);
+    TEST_ASSERT_NULL(cJSON_SetValuestring(string, "longer than before"));
+    TEST_ASSERT_EQUAL_STRING("xy", string->valuestring);
+}
+
+int CJSON_CDECL main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(arena_should_handle_null_and_tiny_buffers);
+    RUN_TEST(arena_should_parse_without_using_the_hooks);
+    RUN_TEST(arena_should_give_back_space_after_failed_parse);
+    RUN_TEST(arena_should_fail_when_out_of_space);
+    RUN_TEST(arena_should_build_documents);
+    RUN_TEST(arena_items_should_be_duplicated_onto_the_heap);
+    RUN_TEST(arena_strings_should_only_be_set_in_place);
+
+    return UNITY_END();
+}
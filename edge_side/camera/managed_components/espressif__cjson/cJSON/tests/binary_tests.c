@@ -0,0 +1,461 @@
+/*
+  Copyright (c) 2009-2017 Dave Gamble and cJSON contributors
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity/examples/unity_config.h"
+#include "unity/src/unity.h"
+#include "common.h"
+#include "../cJSON_Binary.h"
+
+static size_t from_hex(const char *hex, unsigned char *bytes)
+{
+    size_t length = 0;
+    unsigned int byte = 0;
+
+    for (; *hex != '\0'; hex += 2)
+    {
+        TEST_ASSERT_EQUAL_INT(1, sscanf(hex, "%2x", &byte));
+        bytes[length++] = (unsigned char)byte;
+    }
+
+    return length;
+}
+
+static void to_hex(const unsigned char *bytes, size_t length, char *hex)
+{
+    size_t i = 0;
+
+    for (i = 0; i < length; i++)
+    {
+        sprintf(hex + (2 * i), "%02x", bytes[i]);
+    }
+    hex[2 * length] = '\0';
+}
+
+static void assert_encoding(int format, cJSON *item, const char *expected)
+{
+    unsigned char *encoded = NULL;
+    size_t length = 0;
+    char hex[256];
+    cJSON *decoded = NULL;
+
+    TEST_ASSERT_NOT_NULL(item);
+    encoded = cJSON_EncodeBinary(item, format, &length);
+    TEST_ASSERT_NOT_NULL(encoded);
+    to_hex(encoded, length, hex);
+    TEST_ASSERT_EQUAL_STRING(expected, hex);
+
+    decoded = cJSON_DecodeBinary(encoded, length, format);
+    TEST_ASSERT_TRUE_MESSAGE(cJSON_Compare(item, decoded, true), expected);
+
+    cJSON_free(encoded);
+    cJSON_Delete(decoded);
+    cJSON_Delete(item);
+}
+
+static void assert_json_encoding(int format, const char *json, const char *expected)
+{
+    assert_encoding(format, cJSON_Parse(json), expected);
+}
+
+static cJSON *decode_hex(int format, const char *hex)
+{
+    unsigned char bytes[512];
+    size_t length = from_hex(hex, bytes);
+
+    return cJSON_DecodeBinary(bytes, length, format);
+}
+
+static void assert_decoding(int format, const char *hex, const char *expected_json)
+{
+    cJSON *decoded = decode_hex(format, hex);
+    char *printed = NULL;
+
+    TEST_ASSERT_NOT_NULL_MESSAGE(decoded, hex);
+    printed = cJSON_PrintUnformatted(decoded);
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(expected_json, printed, hex);
+
+    cJSON_free(printed);
+    cJSON_Delete(decoded);
+}
+
+static void binary_should_encode_cbor_like_rfc8949(void)
+{
+    /* RFC 8949 appendix A, except that whole floats are encoded as integers */
+    assert_json_encoding(cJSON_CBOR, "0", "00");
+    assert_json_encoding(cJSON_CBOR, "23", "17");
+    assert_json_encoding(cJSON_CBOR, "24", "1818");
+    assert_json_encoding(cJSON_CBOR, "100", "1864");
+    assert_json_encoding(cJSON_CBOR, "1000", "1903e8");
+    assert_json_encoding(cJSON_CBOR, "1000000", "1a000f4240");
+    assert_json_encoding(cJSON_CBOR, "1000000000000", "1b000000e8d4a51000");
+    assert_json_encoding(cJSON_CBOR, "-1", "20");
+    assert_json_encoding(cJSON_CBOR, "-100", "3863");
+    assert_json_encoding(cJSON_CBOR, "-1000", "3903e7");
+    assert_json_encoding(cJSON_CBOR, "1.5", "f93e00");
+    assert_json_encoding(cJSON_CBOR, "1.1", "fb3ff199999999999a");
+    assert_json_encoding(cJSON_CBOR, "-4.1", "fbc010666666666666");
+    assert_json_encoding(cJSON_CBOR, "5.960464477539063e-8", "f90001");
+    assert_json_encoding(cJSON_CBOR, "0.00006103515625", "f90400");
+    assert_json_encoding(cJSON_CBOR, "3.4028234663852886e+38", "fa7f7fffff");
+    assert_json_encoding(cJSON_CBOR, "1.0e+300", "fb7e37e43c8800759c");
+    assert_json_encoding(cJSON_CBOR, "false", "f4");
+    assert_json_encoding(cJSON_CBOR, "true", "f5");
+    assert_json_encoding(cJSON_CBOR, "null", "f6");
+    assert_json_encoding(cJSON_CBOR, "\"\"", "60");
+    assert_json_encoding(cJSON_CBOR, "\"IETF\"", "6449455446");
+    assert_json_encoding(cJSON_CBOR, "\"\\u00fc\"", "62c3bc");
+    assert_json_encoding(cJSON_CBOR, "[]", "80");
+    assert_json_encoding(cJSON_CBOR, "[1,[2,3],[4,5]]", "8301820203820405");
+    assert_json_encoding(cJSON_CBOR, "{}", "a0");
+    assert_json_encoding(cJSON_CBOR, "{\"a\":1,\"b\":[2,3]}", "a26161016162820203");
+    assert_encoding(cJSON_CBOR, cJSON_CreateNumber(-0.0), "f98000");
+}
+
+static void binary_should_encode_messagepack(void)
+{
+    assert_json_encoding(cJSON_MessagePack, "127", "7f");
+    assert_json_encoding(cJSON_MessagePack, "128", "cc80");
+    assert_json_encoding(cJSON_MessagePack, "256", "cd0100");
+    assert_json_encoding(cJSON_MessagePack, "65536", "ce00010000");
+    assert_json_encoding(cJSON_MessagePack, "4294967296", "cf0000000100000000");
+    assert_json_encoding(cJSON_MessagePack, "-1", "ff");
+    assert_json_encoding(cJSON_MessagePack, "-32", "e0");
+    assert_json_encoding(cJSON_MessagePack, "-33", "d0df");
+    assert_json_encoding(cJSON_MessagePack, "-129", "d1ff7f");
+    assert_json_encoding(cJSON_MessagePack, "-32769", "d2ffff7fff");
+    assert_json_encoding(cJSON_MessagePack, "-2147483649", "d3ffffffff7fffffff");
+    assert_json_encoding(cJSON_MessagePack, "1.5", "ca3fc00000");
+    assert_json_encoding(cJSON_MessagePack, "1.1", "cb3ff199999999999a");
+    assert_json_encoding(cJSON_MessagePack, "[null,false,true]", "93c0c2c3");
+    assert_json_encoding(cJSON_MessagePack, "{\"a\":\"b\"}", "81a161a162");
+    assert_json_encoding(cJSON_MessagePack, "\"0123456789abcdef0123456789abcdef\"",
+            "d9203031323334353637383961626364656630313233343536373839616263646566");
+    assert_json_encoding(cJSON_MessagePack, "[1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16]", "dc00100102030405060708090a0b0c0d0e0f10");
+}
+
+static void assert_number_round_trip(int format, double number)
+{
+    cJSON *item = cJSON_CreateNumber(number);
+    cJSON *decoded = NULL;
+    unsigned char *encoded = NULL;
+    size_t length = 0;
+
+    encoded = cJSON_EncodeBinary(item, format, &length);
+    TEST_ASSERT_NOT_NULL(encoded);
+    decoded = cJSON_DecodeBinary(encoded, length, format);
+    TEST_ASSERT_TRUE(cJSON_IsNumber(decoded));
+    if (number != number)
+    {
+        TEST_ASSERT_TRUE(decoded->valuedouble != decoded->valuedouble);
+    }
+    else
+    {
+        TEST_ASSERT_EQUAL_MEMORY(&number, &decoded->valuedouble, sizeof(number));
+    }
+
+    cJSON_free(encoded);
+    cJSON_Delete(decoded);
+    cJSON_Delete(item);
+}
+
+static void binary_should_round_trip_numbers_exactly(void)
+{
+    static const double special[] = { 0.0, -0.0, 1e-320, -4.9e-324, 2.2250738585072014e-308, 1.7976931348623157e308, 9007199254740992.0,
+        -9007199254740992.0, 9007199254740994.0, 18446744073709551616.0, -2147483648.0, 65504.0, 65520.0, 6.103515625e-05, 0.1f };
+    unsigned long seed = 42;
+    double number = 0;
+    size_t i = 0;
+    int format = 0;
+
+    for (format = cJSON_CBOR; format <= cJSON_MessagePack; format++)
+    {
+        for (i = 0; i < (sizeof(special) / sizeof(special[0])); i++)
+        {
+            assert_number_round_trip(format, special[i]);
+            assert_number_round_trip(format, -special[i]);
+        }
+        assert_number_round_trip(format, HUGE_VAL);
+        assert_number_round_trip(format, -HUGE_VAL);
+        assert_number_round_trip(format, HUGE_VAL - HUGE_VAL);
+
+        for (i = 0; i < 20000; i++)
+        {
+            seed = (seed * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+            number = ldexp((double)seed, (int)(seed % 200) - 100);
+            assert_number_round_trip(format, (i % 2) ? number : -number);
+            assert_number_round_trip(format, floor(number));
+            assert_number_round_trip(format, (double)(float)number);
+        }
+    }
+}
+
+static void binary_should_round_trip_documents(void)
+{
+    static const char * const files[] = { "inputs/test1", "inputs/test2", "inputs/test3", "inputs/test4", "inputs/test5", "inputs/test7" };
+    size_t i = 0;
+    int format = 0;
+
+    for (i = 0; i < (sizeof(files) / sizeof(files[0])); i++)
+    {
+        char *json = read_file(files[i]);
+        cJSON *tree = cJSON_Parse(json);
+
+        TEST_ASSERT_NOT_NULL(tree);
+        for (format = cJSON_CBOR; format <= cJSON_MessagePack; format++)
+        {
+            size_t length = 0;
+            unsigned char *encoded = cJSON_EncodeBinary(tree, format, &length);
+            cJSON *decoded = NULL;
+
+            TEST_ASSERT_NOT_NULL(encoded);
+            /* binary is smaller than the (formatted) input */
+            TEST_ASSERT_TRUE(length < strlen(json));
+            decoded = cJSON_DecodeBinary(encoded, length, format);
+            TEST_ASSERT_TRUE_MESSAGE(cJSON_Compare(tree, decoded, true), files[i]);
+
+            cJSON_free(encoded);
+            cJSON_Delete(decoded);
+        }
+
+        cJSON_Delete(tree);
+        free(json);
+    }
+}
+
+static void binary_should_decode_what_it_never_encodes(void)
+{
+    /* indefinite lengths */
+    assert_decoding(cJSON_CBOR, "9f018202039f0405ffff", "[1,[2,3],[4,5]]");
+    assert_decoding(cJSON_CBOR, "bf61610161629f0203ffff", "{\"a\":1,\"b\":[2,3]}");
+    assert_decoding(cJSON_CBOR, "7f657374726561646d696e67ff", "\"streaming\"");
+    /* byte strings become base64url */
+    assert_decoding(cJSON_CBOR, "4401020304", "\"AQIDBA\"");
+    assert_decoding(cJSON_CBOR, "5f42fbff41feff", "\"-__-\"");
+    /* tags are skipped */
+    assert_decoding(cJSON_CBOR, "c074323031332d30332d32315432303a30343a30305a", "\"2013-03-21T20:04:00Z\"");
+    assert_decoding(cJSON_CBOR, "f7", "null");
+    assert_decoding(cJSON_CBOR, "f93c00", "1");
+    assert_decoding(cJSON_CBOR, "fa47c35000", "100000");
+    assert_decoding(cJSON_CBOR, "f90001", "5.960464477539063e-08");
+    assert_decoding(cJSON_CBOR, "1bffffffffffffffff", "1.8446744073709552e+19");
+    assert_decoding(cJSON_CBOR, "3bffffffffffffffff", "-1.8446744073709552e+19");
+
+    assert_decoding(cJSON_MessagePack, "c403010203", "\"AQID\"");
+    assert_decoding(cJSON_MessagePack, "d3ffffffffffffffff", "-1");
+    assert_decoding(cJSON_MessagePack, "d30000000100000000", "4294967296");
+    assert_decoding(cJSON_MessagePack, "d2ffffffff", "-1");
+    assert_decoding(cJSON_MessagePack, "cb3ff8000000000000", "1.5");
+    assert_decoding(cJSON_MessagePack, "de0001a161dc0000", "{\"a\":[]}");
+}
+
+static void binary_should_reject_invalid_input(void)
+{
+    static const char * const invalid_cbor[] = {
+        "", "ff", "1c", "f8ff", "a10102", "6100", "7f4161ff", "7f6161", "9f01", "820102ff", "0000", "1a0001", "5f01ff", "c0"
+    };
+    static const char * const invalid_msgpack[] = {
+        "", "c1", "d40100", "81c0c0", "a100", "9201", "c403", "0000"
+    };
+    unsigned char bytes[64];
+    unsigned char *deep = (unsigned char*)malloc(CJSON_NESTING_LIMIT + 2);
+    size_t length = 0;
+    size_t i = 0;
+    cJSON *item = NULL;
+
+    for (i = 0; i < (sizeof(invalid_cbor) / sizeof(invalid_cbor[0])); i++)
+    {
+        TEST_ASSERT_NULL_MESSAGE(decode_hex(cJSON_CBOR, invalid_cbor[i]), invalid_cbor[i]);
+    }
+    for (i = 0; i < (sizeof(invalid_msgpack) / sizeof(invalid_msgpack[0])); i++)
+    {
+        TEST_ASSERT_NULL_MESSAGE(decode_hex(cJSON_MessagePack, invalid_msgpack[i]), invalid_msgpack[i]);
+    }
+
+    /* every prefix of a valid encoding is truncated */
+    length = from_hex("a26161fb3ff199999999999a61629f63616263ff", bytes);
+    for (i = 0; i < length; i++)
+    {
+        TEST_ASSERT_NULL(cJSON_DecodeBinary(bytes, i, cJSON_CBOR));
+    }
+    item = cJSON_DecodeBinary(bytes, length, cJSON_CBOR);
+    TEST_ASSERT_NOT_NULL(item);
+    cJSON_Delete(item);
+
+    /* nesting */
+    memset(deep, 0x81, CJSON_NESTING_LIMIT + 1);
+    deep[CJSON_NESTING_LIMIT] = 0x00;
+    item = cJSON_DecodeBinary(deep, CJSON_NESTING_LIMIT + 1, cJSON_CBOR);
+    TEST_ASSERT_NOT_NULL(item);
+    cJSON_Delete(item);
+    memset(deep, 0x91, CJSON_NESTING_LIMIT + 2);
+    deep[CJSON_NESTING_LIMIT + 1] = 0x00;
+    TEST_ASSERT_NULL(cJSON_DecodeBinary(deep, CJSON_NESTING_LIMIT + 2, cJSON_MessagePack));
+    free(deep);
+
+    TEST_ASSERT_NULL(cJSON_DecodeBinary(NULL, 0, cJSON_CBOR));
+    TEST_ASSERT_NULL(cJSON_DecodeBinary(bytes, length, 2));
+}
+
+typedef struct
+{
+    unsigned char output[256];
+    size_t length;
+    size_t calls;
+} collected_output;
+
+static cJSON_bool CJSON_CDECL collect_output(void *context, const char *data, size_t length)
+{
+    collected_output *collected = (collected_output*)context;
+
+    TEST_ASSERT_TRUE((collected->length + length) <= sizeof(collected->output));
+    memcpy(collected->output + collected->length, data, length);
+    collected->length += length;
+    collected->calls++;
+
+    return true;
+}
+
+static void binary_writer_should_match_the_tree_encoder(void)
+{
+    cJSON *tree = cJSON_Parse("{\"camera\":\"cam-1\",\"people_count\":2,\"boxes\":[{\"x\":12.5,\"score\":0.93},{\"x\":-3,\"score\":null}],\"ok\":true}");
+    const cJSON *boxes = cJSON_GetObjectItemCaseSensitive(tree, "boxes");
+    collected_output collected;
+    cJSON_BinaryWriter writer;
+    unsigned char chunk[7];
+    unsigned char *expected = NULL;
+    size_t expected_length = 0;
+    int format = 0;
+
+    for (format = cJSON_CBOR; format <= cJSON_MessagePack; format++)
+    {
+        memset(&collected, 0, sizeof(collected));
+        cJSON_InitBinaryWriter(&writer, format, chunk, sizeof(chunk), collect_output, &collected);
+        TEST_ASSERT_TRUE(cJSON_BinaryStartObject(&writer, 4));
+        TEST_ASSERT_TRUE(cJSON_BinaryWriteString(&writer, "camera"));
+        TEST_ASSERT_TRUE(cJSON_BinaryWriteString(&writer, "cam-1"));
+        TEST_ASSERT_TRUE(cJSON_BinaryWriteString(&writer, "people_count"));
+        TEST_ASSERT_TRUE(cJSON_BinaryWriteNumber(&writer, 2));
+        TEST_ASSERT_TRUE(cJSON_BinaryWriteString(&writer, "boxes"));
+        TEST_ASSERT_TRUE(cJSON_BinaryWriteItem(&writer, boxes));
+        TEST_ASSERT_TRUE(cJSON_BinaryWriteString(&writer, "ok"));
+        TEST_ASSERT_TRUE(cJSON_BinaryWriteBool(&writer, true));
+
+        expected = cJSON_EncodeBinary(tree, format, &expected_length);
+        TEST_ASSERT_EQUAL_UINT(expected_length, cJSON_FinishBinaryWriter(&writer));
+        TEST_ASSERT_EQUAL_UINT(expected_length, collected.length);
+        TEST_ASSERT_EQUAL_MEMORY(expected, collected.output, expected_length);
+        TEST_ASSERT_EQUAL_UINT((expected_length + sizeof(chunk) - 1) / sizeof(chunk), collected.calls);
+
+        /* the same into a buffer that is large enough */
+        TEST_ASSERT_EQUAL_UINT(expected_length, cJSON_EncodeBinaryToBuffer(tree, format, collected.output, expected_length));
+        TEST_ASSERT_EQUAL_MEMORY(expected, collected.output, expected_length);
+        TEST_ASSERT_EQUAL_UINT(0, cJSON_EncodeBinaryToBuffer(tree, format, collected.output, expected_length - 1));
+        cJSON_free(expected);
+    }
+
+    cJSON_Delete(tree);
+}
+
+static void binary_writer_should_handle_indefinite_lengths(void)
+{
+    cJSON_BinaryWriter writer;
+    unsigned char buffer[32];
+    cJSON *decoded = NULL;
+    char *printed = NULL;
+    size_t length = 0;
+
+    cJSON_InitBinaryWriter(&writer, cJSON_CBOR, buffer, sizeof(buffer), NULL, NULL);
+    cJSON_BinaryStartObject(&writer, cJSON_BinaryIndefinite);
+    cJSON_BinaryWriteString(&writer, "boxes");
+    cJSON_BinaryStartArray(&writer, cJSON_BinaryIndefinite);
+    cJSON_BinaryWriteNumber(&writer, 1);
+    cJSON_BinaryWriteNull(&writer);
+    cJSON_BinaryWriteEnd(&writer);
+    cJSON_BinaryWriteEnd(&writer);
+    length = cJSON_FinishBinaryWriter(&writer);
+    TEST_ASSERT_EQUAL_UINT(12, length);
+
+    decoded = cJSON_DecodeBinary(buffer, length, cJSON_CBOR);
+    printed = cJSON_PrintUnformatted(decoded);
+    TEST_ASSERT_EQUAL_STRING("{\"boxes\":[1,null]}", printed);
+    cJSON_free(printed);
+    cJSON_Delete(decoded);
+
+    /* MessagePack can't */
+    cJSON_InitBinaryWriter(&writer, cJSON_MessagePack, buffer, sizeof(buffer), NULL, NULL);
+    TEST_ASSERT_FALSE(cJSON_BinaryStartArray(&writer, cJSON_BinaryIndefinite));
+    TEST_ASSERT_FALSE(cJSON_BinaryWriteNull(&writer));
+    TEST_ASSERT_EQUAL_UINT(0, cJSON_FinishBinaryWriter(&writer));
+}
+
+static void binary_writer_should_fail_cleanly(void)
+{
+    cJSON_BinaryWriter writer;
+    unsigned char buffer[4];
+    cJSON *raw = cJSON_CreateRaw("{}");
+    size_t length = 0;
+
+    /* counting only */
+    cJSON_InitBinaryWriter(&writer, cJSON_CBOR, NULL, 0, NULL, NULL);
+    TEST_ASSERT_TRUE(cJSON_BinaryWriteString(&writer, "0123456789"));
+    TEST_ASSERT_EQUAL_UINT(11, cJSON_FinishBinaryWriter(&writer));
+
+    /* out of space without a sink */
+    cJSON_InitBinaryWriter(&writer, cJSON_CBOR, buffer, sizeof(buffer), NULL, NULL);
+    TEST_ASSERT_FALSE(cJSON_BinaryWriteString(&writer, "0123456789"));
+    TEST_ASSERT_EQUAL_UINT(0, cJSON_FinishBinaryWriter(&writer));
+
+    cJSON_InitBinaryWriter(&writer, cJSON_CBOR, buffer, 0, NULL, NULL);
+    TEST_ASSERT_FALSE(cJSON_BinaryWriteNull(&writer));
+    cJSON_InitBinaryWriter(&writer, 2, buffer, sizeof(buffer), NULL, NULL);
+    TEST_ASSERT_FALSE(cJSON_BinaryWriteNull(&writer));
+    cJSON_InitBinaryWriter(&writer, cJSON_CBOR, buffer, sizeof(buffer), NULL, NULL);
+    TEST_ASSERT_FALSE(cJSON_BinaryWriteString(&writer, NULL));
+    TEST_ASSERT_FALSE(cJSON_BinaryWriteItem(NULL, raw));
+
+    TEST_ASSERT_NULL(cJSON_EncodeBinary(raw, cJSON_CBOR, &length));
+    TEST_ASSERT_NULL(cJSON_EncodeBinary(NULL, cJSON_CBOR, &length));
+    TEST_ASSERT_NULL(cJSON_EncodeBinary(raw, cJSON_CBOR, NULL));
+    TEST_ASSERT_EQUAL_UINT(0, cJSON_EncodeBinaryToBuffer(raw, cJSON_CBOR, NULL, 10));
+    cJSON_Delete(raw);
+}
+
+int CJSON_CDECL main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(binary_should_encode_cbor_like_rfc8949);
+    RUN_TEST(binary_should_encode_messagepack);
+    RUN_TEST(binary_should_round_trip_numbers_exactly);
+    RUN_TEST(binary_should_round_trip_documents);
+    RUN_TEST(binary_should_decode_what_it_never_encodes);
+    RUN_TEST(binary_should_reject_invalid_input);
+    RUN_TEST(binary_writer_should_match_the_tree_encoder);
+    RUN_TEST(binary_writer_should_handle_indefinite_lengths);
+    RUN_TEST(binary_writer_should_fail_cleanly);
+
+    return UNITY_END();
+}
@@ -70,11 +70,180 @@ static void cjson_utils_functions_shouldnt_crash_with_null_pointers(void)
     cJSON_Delete(item);
 }
 
+static void assert_patched(const char *document, const char *patches, const cJSON_bool case_sensitive, const char *expected)
+{
+    cJSON *object = cJSON_Parse(document);
+    cJSON *patch_array = cJSON_Parse(patches);
+    char *printed = NULL;
+
+    TEST_ASSERT_NOT_NULL(object);
+    TEST_ASSERT_NOT_NULL(patch_array);
+    if (case_sensitive)
+    {
+        TEST_ASSERT_EQUAL_INT(0, cJSONUtils_ApplyPatchesCaseSensitive(object, patch_array));
+    }
+    else
+    {
+        TEST_ASSERT_EQUAL_INT(0, cJSONUtils_ApplyPatches(object, patch_array));
+    }
+    printed = cJSON_PrintUnformatted(object);
+    TEST_ASSERT_EQUAL_STRING(expected, printed);
+
+    cJSON_free(printed);
+    cJSON_Delete(patch_array);
+    cJSON_Delete(object);
+}
+
+static void cjson_utils_patches_should_update_members_in_place(void)
+{
+    /* consecutive patches on the same parent, members that are replaced keep their position */
+    assert_patched("{\"a\":1,\"b\":{\"x\":1,\"y\":2},\"c\":3}",
+        "[{\"op\":\"replace\",\"path\":\"/b/x\",\"value\":10},"
+        "{\"op\":\"add\",\"path\":\"/b/y\",\"value\":[20]},"
+        "{\"op\":\"add\",\"path\":\"/b/m~1n~0\",\"value\":true},"
+        "{\"op\":\"move\",\"from\":\"/c\",\"path\":\"/b/c\"},"
+        "{\"op\":\"remove\",\"path\":\"/b/x\"},"
+        "{\"op\":\"add\",\"path\":\"/b/y/0\",\"value\":{\"k\":null}},"
+        "{\"op\":\"replace\",\"path\":\"/a\",\"value\":\"one\"}]",
+        false,
+        "{\"a\":\"one\",\"b\":{\"y\":[{\"k\":null},20],\"m/n~\":true,\"c\":3}}");
+
+    /* case sensitive patches only touch the member with the exact key */
+    assert_patched("{\"a\":1,\"A\":2}", "[{\"op\":\"remove\",\"path\":\"/A\"}]", true, "{\"a\":1}");
+    assert_patched("{\"a\":1,\"A\":2}", "[{\"op\":\"replace\",\"path\":\"/A\",\"value\":3}]", true, "{\"a\":1,\"A\":3}");
+
+    /* the root goes away with a replace, the next patch has to find the new one */
+    assert_patched("{\"a\":{\"b\":1}}",
+        "[{\"op\":\"add\",\"path\":\"/a/c\",\"value\":2},"
+        "{\"op\":\"replace\",\"path\":\"\",\"value\":{\"a\":{}}},"
+        "{\"op\":\"add\",\"path\":\"/a/d\",\"value\":3}]",
+        false,
+        "{\"a\":{\"d\":3}}");
+}
+
+static void cjson_utils_patches_should_keep_the_object_index_valid(void)
+{
+    cJSON *object = cJSON_CreateObject();
+    cJSON *patches = cJSON_CreateArray();
+    char key[16];
+    char path[32];
+    int i = 0;
+
+    TEST_ASSERT_NOT_NULL(object);
+    TEST_ASSERT_NOT_NULL(patches);
+    for (i = 0; i < 100; i++)
+    {
+        sprintf(key, "key%d", i);
+        cJSON_AddNumberToObject(object, key, i);
+    }
+    TEST_ASSERT_TRUE(cJSON_EnableObjectIndex(object));
+    TEST_ASSERT_NOT_NULL(cJSON_GetObjectItem(object, "key0"));
+
+    for (i = 0; i < 100; i += 2)
+    {
+        cJSON *value = cJSON_CreateNumber(-i);
+        sprintf(path, "/key%d", i);
+        cJSONUtils_AddPatchToArray(patches, ((i % 4) == 0) ? "replace" : "add", path, value);
+        cJSON_Delete(value);
+        sprintf(path, "/key%d", i + 1);
+        cJSONUtils_AddPatchToArray(patches, "remove", path, NULL);
+    }
+    TEST_ASSERT_EQUAL_INT(0, cJSONUtils_ApplyPatches(object, patches));
+
+    TEST_ASSERT_EQUAL_INT(50, cJSON_GetArraySize(object));
+    for (i = 0; i < 100; i++)
+    {
+        cJSON *member = NULL;
+        sprintf(key, "key%d", i);
+        member = cJSON_GetObjectItem(object, key);
+        if ((i % 2) == 0)
+        {
+            TEST_ASSERT_NOT_NULL(member);
+            TEST_ASSERT_EQUAL_DOUBLE(-i, member->valuedouble);
+        }
+        else
+        {
+            TEST_ASSERT_NULL(member);
+        }
+    }
+
+    cJSON_Delete(patches);
+    cJSON_Delete(object);
+}
+
+static void cjson_utils_generated_patches_should_handle_long_paths(void)
+{
+    char long_key[400];
+    char expected_path[2 * (sizeof(long_key) + 2) + sizeof("/value")];
+    cJSON *from = cJSON_CreateObject();
+    cJSON *to = NULL;
+    cJSON *inner = NULL;
+    cJSON *patches = NULL;
+
+    memset(long_key, 'k', sizeof(long_key) - 1);
+    long_key[sizeof(long_key) - 1] = '\0';
+    /* a '/' that has to be escaped as ~1 */
+    long_key[10] = '/';
+
+    inner = cJSON_AddObjectToObject(from, long_key);
+    cJSON_AddNumberToObject(cJSON_AddObjectToObject(inner, long_key), "value", 1);
+    to = cJSON_Duplicate(from, 1);
+    cJSON_SetNumberValue(cJSON_GetObjectItem(cJSON_GetObjectItem(cJSON_GetObjectItem(to, long_key), long_key), "value"), 2);
+
+    patches = cJSONUtils_GeneratePatchesCaseSensitive(from, to);
+    TEST_ASSERT_EQUAL_INT(1, cJSON_GetArraySize(patches));
+
+    sprintf(expected_path, "/%.10s~1%s/%.10s~1%s/value", long_key, long_key + 11, long_key, long_key + 11);
+    TEST_ASSERT_EQUAL_STRING(expected_path, cJSON_GetObjectItem(cJSON_GetArrayItem(patches, 0), "path")->valuestring);
+
+    TEST_ASSERT_EQUAL_INT(0, cJSONUtils_ApplyPatchesCaseSensitive(from, patches));
+    TEST_ASSERT_TRUE(cJSON_Compare(from, to, true));
+
+    cJSON_Delete(patches);
+    cJSON_Delete(to);
+    cJSON_Delete(from);
+}
+
+static void cjson_utils_merge_patches_should_only_contain_changes(void)
+{
+    cJSON *from = cJSON_Parse("{\"cameras\":{\"cam-1\":{\"fps\":15,\"zones\":[1,2]},\"cam-2\":{\"fps\":30}},\"o\":{\"a\":1},\"name\":\"edge\"}");
+    cJSON *to = cJSON_Parse("{\"cameras\":{\"cam-1\":{\"fps\":15,\"zones\":[1,2]},\"cam-2\":{\"fps\":10}},\"o\":{\"A\":1},\"name\":\"edge\",\"added\":true}");
+    cJSON *unchanged = cJSON_Duplicate(from, 1);
+    cJSON *patch = NULL;
+    char *printed = NULL;
+
+    TEST_ASSERT_NOT_NULL(from);
+    TEST_ASSERT_NOT_NULL(to);
+    TEST_ASSERT_NULL(cJSONUtils_GenerateMergePatch(from, unchanged));
+
+    /* nested objects are compared with the same case sensitivity */
+    patch = cJSONUtils_GenerateMergePatchCaseSensitive(from, to);
+    printed = cJSON_PrintUnformatted(patch);
+    TEST_ASSERT_EQUAL_STRING("{\"added\":true,\"cameras\":{\"cam-2\":{\"fps\":10}},\"o\":{\"A\":1,\"a\":null}}", printed);
+    cJSON_free(printed);
+
+    /* applying it updates the members in place, new ones are added after the sorted members */
+    from = cJSONUtils_MergePatchCaseSensitive(from, patch);
+    TEST_ASSERT_TRUE(cJSON_Compare(from, to, true));
+    printed = cJSON_PrintUnformatted(from);
+    TEST_ASSERT_EQUAL_STRING("{\"cameras\":{\"cam-1\":{\"fps\":15,\"zones\":[1,2]},\"cam-2\":{\"fps\":10}},\"name\":\"edge\",\"o\":{\"A\":1},\"added\":true}", printed);
+    cJSON_free(printed);
+
+    cJSON_Delete(patch);
+    cJSON_Delete(unchanged);
+    cJSON_Delete(to);
+    cJSON_Delete(from);
+}
+
 int main(void)
 {
     UNITY_BEGIN();
 
     RUN_TEST(cjson_utils_functions_shouldnt_crash_with_null_pointers);
+    RUN_TEST(cjson_utils_patches_should_update_members_in_place);
+    RUN_TEST(cjson_utils_patches_should_keep_the_object_index_valid);
+    RUN_TEST(cjson_utils_generated_patches_should_handle_long_paths);
+    RUN_TEST(cjson_utils_merge_patches_should_only_contain_changes);
 
     return UNITY_END();
 }
@@ -0,0 +1,240 @@
+/*
+  Copyright (c) 2009-2017 Dave Gamble and cJSON contributors
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity/examples/unity_config.h"
+#include "unity/src/unity.h"
+#include "common.h"
+
+static cJSON *create_numbered_object(int count)
+{
+    cJSON *object = cJSON_CreateObject();
+    char key[32];
+    int i = 0;
+
+    for (i = 0; i < count; i++)
+    {
+        sprintf(key, "member_%d", i);
+        cJSON_AddNumberToObject(object, key, i);
+    }
+
+    return object;
+}
+
+/* compare every lookup against the linear scan of an identical object without index */
+static void assert_same_lookups(const cJSON *indexed, const cJSON *plain, const char * const *keys, int count)
+{
+    int i = 0;
+
+    for (i = 0; i < count; i++)
+    {
+        cJSON *expected = cJSON_GetObjectItemCaseSensitive(plain, keys[i]);
+        cJSON *actual = cJSON_GetObjectItemCaseSensitive(indexed, keys[i]);
+        if (expected == NULL)
+        {
+            TEST_ASSERT_NULL(actual);
+            continue;
+        }
+        TEST_ASSERT_NOT_NULL(actual);
+        TEST_ASSERT_EQUAL_STRING(expected->string, actual->string);
+        TEST_ASSERT_EQUAL_DOUBLE(expected->valuedouble, actual->valuedouble);
+    }
+}
+
+static void object_index_should_find_all_members(void)
+{
+    static const int sizes[] = { 0, 1, 10, 100, 1000, 10000 };
+    size_t size_index = 0;
+
+    for (size_index = 0; size_index < (sizeof(sizes) / sizeof(sizes[0])); size_index++)
+    {
+        cJSON *object = create_numbered_object(sizes[size_index]);
+        char key[32];
+        int i = 0;
+
+        TEST_ASSERT_TRUE(cJSON_EnableObjectIndex(object));
+        TEST_ASSERT_BITS(cJSON_IsIndexed, cJSON_IsIndexed, object->type);
+
+        for (i = 0; i < sizes[size_index]; i++)
+        {
+            cJSON *found = NULL;
+            sprintf(key, "member_%d", i);
+            found = cJSON_GetObjectItemCaseSensitive(object, key);
+            TEST_ASSERT_NOT_NULL(found);
+            TEST_ASSERT_EQUAL_INT(i, found->valueint);
+
+            sprintf(key, "MEMBER_%d", i);
+            TEST_ASSERT_NULL(cJSON_GetObjectItemCaseSensitive(object, key));
+            TEST_ASSERT_EQUAL_PTR(found, cJSON_GetObjectItem(object, key));
+        }
+        TEST_ASSERT_NULL(cJSON_GetObjectItem(object, "missing"));
+
+        cJSON_Delete(object);
+    }
+}
+
+static void object_index_should_return_the_first_of_duplicate_keys(void)
+{
+    cJSON *object = cJSON_Parse("{\"a\":1,\"A\":2,\"a\":3,\"b\":4}");
+
+    TEST_ASSERT_TRUE(cJSON_EnableObjectIndex(object));
+    TEST_ASSERT_EQUAL_INT(1, cJSON_GetObjectItemCaseSensitive(object, "a")->valueint);
+    TEST_ASSERT_EQUAL_INT(2, cJSON_GetObjectItemCaseSensitive(object, "A")->valueint);
+    TEST_ASSERT_EQUAL_INT(1, cJSON_GetObjectItem(object, "A")->valueint);
+
+    cJSON_DeleteItemFromObjectCaseSensitive(object, "a");
+    TEST_ASSERT_EQUAL_INT(2, cJSON_GetObjectItem(object, "a")->valueint);
+    TEST_ASSERT_EQUAL_INT(3, cJSON_GetObjectItemCaseSensitive(object, "a")->valueint);
+
+    cJSON_InsertItemInArray(object, 0, cJSON_CreateNumber(0));
+    cJSON_GetArrayItem(object, 0)->string = (char*)cJSON_strdup((const unsigned char*)"a", &global_hooks);
+    cJSON_DisableObjectIndex(object);
+    TEST_ASSERT_TRUE(cJSON_EnableObjectIndex(object));
+    TEST_ASSERT_EQUAL_INT(0, cJSON_GetObjectItem(object, "a")->valueint);
+
+    cJSON_Delete(object);
+}
+
+static void object_index_should_follow_modifications(void)
+{
+    const char *keys[] = { "member_0", "member_1", "member_5", "member_9", "member_10", "member_42", "new", "NEW", "other" };
+    cJSON *indexed = create_numbered_object(10);
+    cJSON *plain = create_numbered_object(10);
+    cJSON *replacement = NULL;
+    int i = 0;
+
+    TEST_ASSERT_TRUE(cJSON_EnableObjectIndex(indexed));
+    assert_same_lookups(indexed, plain, keys, 9);
+
+    /* add enough items to force the index to grow */
+    for (i = 10; i < 50; i++)
+    {
+        char key[32];
+        sprintf(key, "member_%d", i);
+        cJSON_AddNumberToObject(indexed, key, i);
+        cJSON_AddNumberToObject(plain, key, i);
+        assert_same_lookups(indexed, plain, keys, 9);
+    }
+
+    cJSON_AddNumberToObject(indexed, "new", 100);
+    cJSON_AddNumberToObject(plain, "new", 100);
+    assert_same_lookups(indexed, plain, keys, 9);
+
+    cJSON_DeleteItemFromObjectCaseSensitive(indexed, "member_5");
+    cJSON_DeleteItemFromObjectCaseSensitive(plain, "member_5");
+    cJSON_DeleteItemFromObjectCaseSensitive(indexed, "member_0");
+    cJSON_DeleteItemFromObjectCaseSensitive(plain, "member_0");
+    assert_same_lookups(indexed, plain, keys, 9);
+
+    cJSON_ReplaceItemInObjectCaseSensitive(indexed, "member_9", cJSON_CreateNumber(-9));
+    cJSON_ReplaceItemInObjectCaseSensitive(plain, "member_9", cJSON_CreateNumber(-9));
+    assert_same_lookups(indexed, plain, keys, 9);
+
+    /* replacement with a different key */
+    replacement = cJSON_CreateNumber(7);
+    replacement->string = (char*)cJSON_strdup((const unsigned char*)"other", &global_hooks);
+    cJSON_ReplaceItemViaPointer(indexed, cJSON_GetObjectItem(indexed, "member_42"), replacement);
+    replacement = cJSON_CreateNumber(7);
+    replacement->string = (char*)cJSON_strdup((const unsigned char*)"other", &global_hooks);
+    cJSON_ReplaceItemViaPointer(plain, cJSON_GetObjectItem(plain, "member_42"), replacement);
+    assert_same_lookups(indexed, plain, keys, 9);
+
+    replacement = cJSON_CreateNumber(-1);
+    replacement->string = (char*)cJSON_strdup((const unsigned char*)"new", &global_hooks);
+    cJSON_InsertItemInArray(indexed, 3, replacement);
+    replacement = cJSON_CreateNumber(-1);
+    replacement->string = (char*)cJSON_strdup((const unsigned char*)"new", &global_hooks);
+    cJSON_InsertItemInArray(plain, 3, replacement);
+    assert_same_lookups(indexed, plain, keys, 9);
+
+    cJSON_Delete(indexed);
+    cJSON_Delete(plain);
+}
+
+static void object_index_should_not_be_copied(void)
+{
+    cJSON *object = create_numbered_object(20);
+    cJSON *copy = NULL;
+    cJSON *reference = NULL;
+
+    TEST_ASSERT_TRUE(cJSON_EnableObjectIndex(object));
+    TEST_ASSERT_NOT_NULL(cJSON_GetObjectItem(object, "member_3"));
+
+    copy = cJSON_Duplicate(object, true);
+    reference = cJSON_CreateObjectReference(object);
+    TEST_ASSERT_BITS(cJSON_IsIndexed, 0, copy->type);
+    TEST_ASSERT_NULL(copy->valuestring);
+    TEST_ASSERT_BITS(cJSON_IsIndexed, 0, reference->type);
+    TEST_ASSERT_NULL(reference->valuestring);
+    TEST_ASSERT_TRUE(cJSON_Compare(object, copy, true));
+
+    cJSON_Delete(reference);
+    cJSON_Delete(copy);
+
+    cJSON_DisableObjectIndex(object);
+    TEST_ASSERT_BITS(cJSON_IsIndexed, 0, object->type);
+    TEST_ASSERT_NULL(object->valuestring);
+    TEST_ASSERT_NOT_NULL(cJSON_GetObjectItem(object, "member_3"));
+
+    cJSON_Delete(object);
+}
+
+static void object_index_should_only_be_enabled_on_objects(void)
+{
+    cJSON *array = cJSON_CreateArray();
+
+    TEST_ASSERT_FALSE(cJSON_EnableObjectIndex(NULL));
+    TEST_ASSERT_FALSE(cJSON_EnableObjectIndex(array));
+    cJSON_DisableObjectIndex(NULL);
+
+    cJSON_Delete(array);
+}
+
+static void object_index_should_be_freed_with_nested_objects(void)
+{
+    cJSON *root = cJSON_Parse("{\"outer\":{\"inner\":{\"value\":1}}}");
+    cJSON *outer = cJSON_GetObjectItem(root, "outer");
+
+    TEST_ASSERT_TRUE(cJSON_EnableObjectIndex(root));
+    TEST_ASSERT_TRUE(cJSON_EnableObjectIndex(outer));
+    TEST_ASSERT_TRUE(cJSON_EnableObjectIndex(cJSON_GetObjectItem(outer, "inner")));
+    TEST_ASSERT_NOT_NULL(cJSON_GetObjectItem(cJSON_GetObjectItem(outer, "inner"), "value"));
+
+    cJSON_Delete(root);
+}
+
+int CJSON_CDECL main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(object_index_should_find_all_members);
+    RUN_TEST(object_index_should_return_the_first_of_duplicate_keys);
+    RUN_TEST(object_index_should_follow_modifications);
+    RUN_TEST(object_index_should_not_be_copied);
+    RUN_TEST(object_index_should_only_be_enabled_on_objects);
+    RUN_TEST(object_index_should_be_freed_with_nested_objects);
+
+    return UNITY_END();
+}
@@ -0,0 +1,163 @@
+/*
+  Copyright (c) 2009-2017 Dave Gamble and cJSON contributors
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+
+#include "unity/examples/unity_config.h"
+#include "unity/src/unity.h"
+#include "common.h"
+
+static size_t context_allocations = 0;
+static size_t context_frees = 0;
+
+static void * CJSON_CDECL context_malloc(size_t size)
+{
+    context_allocations++;
+    return malloc(size);
+}
+
+static void CJSON_CDECL context_free(void *pointer)
+{
+    if (pointer != NULL)
+    {
+        context_frees++;
+    }
+    free(pointer);
+}
+
+static void * CJSON_CDECL failing_malloc(size_t size)
+{
+    (void)size;
+    return NULL;
+}
+
+static void parse_context_should_handle_null(void)
+{
+    cJSON_Context context;
+
+    cJSON_InitContext(NULL, NULL);
+    cJSON_InitContext(&context, NULL);
+    TEST_ASSERT_NULL(cJSON_ParseCtx(NULL, "[]", 2, NULL, false));
+    TEST_ASSERT_NULL(cJSON_ParseCtx(&context, NULL, 2, NULL, false));
+    TEST_ASSERT_NULL(context.error);
+    TEST_ASSERT_NULL(cJSON_ParseCtx(&context, "[]", 0, NULL, false));
+    cJSON_DeleteCtx(NULL, NULL);
+    cJSON_DeleteCtx(&context, NULL);
+}
+
+static void parse_context_should_report_errors_in_the_context(void)
+{
+    const char valid[] = "{\"a\":[1,2]}";
+    const char invalid[] = "{\"a\":[1,}";
+    const char *parse_end = NULL;
+    cJSON_Context context;
+    cJSON *item = NULL;
+
+    cJSON_InitContext(&context, NULL);
+
+    /* the global error position is left alone */
+    TEST_ASSERT_NULL(cJSON_Parse("[x]"));
+    TEST_ASSERT_EQUAL_STRING("x]", cJSON_GetErrorPtr());
+
+    TEST_ASSERT_NULL(cJSON_ParseCtx(&context, invalid, sizeof(invalid), &parse_end, true));
+    TEST_ASSERT_EQUAL_PTR(invalid + 8, context.error);
+    TEST_ASSERT_EQUAL_PTR(context.error, parse_end);
+    TEST_ASSERT_EQUAL_STRING("x]", cJSON_GetErrorPtr());
+
+    item = cJSON_ParseCtx(&context, valid, sizeof(valid) - 1, &parse_end, false);
+    TEST_ASSERT_NOT_NULL(item);
+    TEST_ASSERT_NULL(context.error);
+    TEST_ASSERT_EQUAL_PTR(valid + sizeof(valid) - 1, parse_end);
+    TEST_ASSERT_EQUAL_INT(2, cJSON_GetArraySize(cJSON_GetObjectItem(item, "a")));
+    cJSON_DeleteCtx(&context, item);
+
+    /* trailing garbage */
+    TEST_ASSERT_NULL(cJSON_ParseCtx(&context, "[] x", 5, NULL, true));
+    TEST_ASSERT_NOT_NULL(context.error);
+    TEST_ASSERT_EQUAL_STRING("x", context.error);
+}
+
+static void parse_context_should_use_its_own_hooks(void)
+{
+    cJSON_Hooks hooks = { context_malloc, context_free };
+    cJSON_Hooks failing_hooks = { failing_malloc, NULL };
+    cJSON_Context context;
+    cJSON *item = NULL;
+    const char json[] = "{\"name\":\"cam-1\",\"boxes\":[{\"label\":\"person\",\"score\":0.5}]}";
+
+    cJSON_InitContext(&context, &hooks);
+    context_allocations = 0;
+    context_frees = 0;
+
+    item = cJSON_ParseCtx(&context, json, sizeof(json) - 1, NULL, false);
+    TEST_ASSERT_NOT_NULL(item);
+    TEST_ASSERT_TRUE(context_allocations > 0);
+    TEST_ASSERT_EQUAL_UINT(0, context_frees);
+    cJSON_DeleteCtx(&context, item);
+    TEST_ASSERT_EQUAL_UINT(context_allocations, context_frees);
+
+    /* failed parses give everything back */
+    TEST_ASSERT_NULL(cJSON_ParseCtx(&context, json, sizeof(json) - 3, NULL, false));
+    TEST_ASSERT_EQUAL_UINT(context_allocations, context_frees);
+
+    /* the global hooks are not involved */
+    cJSON_InitContext(&context, &failing_hooks);
+    TEST_ASSERT_NULL(cJSON_ParseCtx(&context, json, sizeof(json) - 1, NULL, false));
+    TEST_ASSERT_EQUAL_PTR(json, context.error);
+    item = cJSON_Parse(json);
+    TEST_ASSERT_NOT_NULL(item);
+    cJSON_Delete(item);
+}
+
+static void parse_context_should_parse_into_an_arena(void)
+{
+    double memory[256];
+    cJSON_Arena arena;
+    cJSON_Context context;
+    cJSON *item = NULL;
+
+    cJSON_InitArena(&arena, memory, sizeof(memory));
+    cJSON_InitContext(&context, NULL);
+    context.arena = &arena;
+
+    item = cJSON_ParseCtx(&context, "[1,2,3]", 7, NULL, false);
+    TEST_ASSERT_NOT_NULL(item);
+    TEST_ASSERT_TRUE(item->type & cJSON_InArena);
+    TEST_ASSERT_TRUE(cJSON_GetArenaUsage(&arena) > 0);
+    cJSON_DeleteCtx(&context, item);
+    cJSON_ResetArena(&arena);
+
+    cJSON_InitArena(&arena, NULL, 0);
+    TEST_ASSERT_NULL(cJSON_ParseCtx(&context, "[]", 2, NULL, false));
+    TEST_ASSERT_NOT_NULL(context.error);
+}
+
+int CJSON_CDECL main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(parse_context_should_handle_null);
+    RUN_TEST(parse_context_should_report_errors_in_the_context);
+    RUN_TEST(parse_context_should_use_its_own_hooks);
+    RUN_TEST(parse_context_should_parse_into_an_arena);
+
+    return UNITY_END();
+}
@@ -64,10 +64,18 @@ static void parse_hex4_should_parse_mixed_case(void)
     TEST_ASSERT_EQUAL_INT(0xBEEF, parse_hex4((const unsigned char*)"BEEF"));
 }
 
+static void parse_hex4_should_reject_invalid_digits(void)
+{
+    TEST_ASSERT_EQUAL_INT(INVALID_HEX4, parse_hex4((const unsigned char*)"000\""));
+    TEST_ASSERT_EQUAL_INT(INVALID_HEX4, parse_hex4((const unsigned char*)"g000"));
+    TEST_ASSERT_EQUAL_INT(INVALID_HEX4, parse_hex4((const unsigned char*)"00 0"));
+}
+
 int CJSON_CDECL main(void)
 {
     UNITY_BEGIN();
     RUN_TEST(parse_hex4_should_parse_all_combinations);
     RUN_TEST(parse_hex4_should_parse_mixed_case);
+    RUN_TEST(parse_hex4_should_reject_invalid_digits);
     return UNITY_END();
 }
@@ -0,0 +1,154 @@
+/*
+  Copyright (c) 2009-2017 Dave Gamble and cJSON contributors
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity/examples/unity_config.h"
+#include "unity/src/unity.h"
+#include "common.h"
+
+static size_t allocation_count = 0;
+
+static void * CJSON_CDECL counting_malloc(size_t size)
+{
+    allocation_count++;
+    return malloc(size);
+}
+
+static void CJSON_CDECL normal_free(void *pointer)
+{
+    free(pointer);
+}
+
+static cJSON_Hooks counting_hooks = {
+    counting_malloc,
+    normal_free
+};
+
+static void parse_in_situ_should_point_into_the_input(void)
+{
+    char json[] = "{\"status\":\"ok\",\"message\":\"line\\nbreak \\\"quoted\\\"\",\"empty\":\"\"}";
+    cJSON *root = NULL;
+    cJSON *message = NULL;
+    cJSON *status = NULL;
+
+    root = cJSON_ParseInSitu(json, sizeof(json) - 1);
+    TEST_ASSERT_NOT_NULL(root);
+
+    status = cJSON_GetObjectItemCaseSensitive(root, "status");
+    TEST_ASSERT_EQUAL_STRING("ok", cJSON_GetStringValue(status));
+    TEST_ASSERT_TRUE((status->valuestring > json) && (status->valuestring < (json + sizeof(json))));
+    TEST_ASSERT_TRUE((status->string > json) && (status->string < (json + sizeof(json))));
+    TEST_ASSERT_BITS(cJSON_IsReference | cJSON_StringIsConst, cJSON_IsReference | cJSON_StringIsConst, status->type);
+
+    message = cJSON_GetObjectItemCaseSensitive(root, "message");
+    TEST_ASSERT_EQUAL_STRING("line\nbreak \"quoted\"", cJSON_GetStringValue(message));
+    TEST_ASSERT_EQUAL_STRING("", cJSON_GetStringValue(cJSON_GetObjectItemCaseSensitive(root, "empty")));
+
+    cJSON_Delete(root);
+}
+
+static void parse_in_situ_should_only_allocate_items(void)
+{
+    char json[] = "{\"camera\":\"cam1\",\"people_count\":2,\"boxes\":[{\"label\":\"person\"},{\"label\":\"person\"}]}";
+    cJSON *root = NULL;
+
+    allocation_count = 0;
+    cJSON_InitHooks(&counting_hooks);
+    root = cJSON_ParseInSitu(json, strlen(json));
+    cJSON_InitHooks(NULL);
+    TEST_ASSERT_NOT_NULL(root);
+
+    /* root, camera, people_count, boxes, two objects and two labels */
+    TEST_ASSERT_EQUAL_UINT(8, allocation_count);
+
+    cJSON_Delete(root);
+}
+
+static void parse_in_situ_should_not_need_a_null_terminator(void)
+{
+    char json[] = "[\"abc\",\"def\"]XXXX";
+    cJSON *root = cJSON_ParseInSitu(json, 13);
+
+    TEST_ASSERT_NOT_NULL(root);
+    TEST_ASSERT_EQUAL_STRING("abc", cJSON_GetArrayItem(root, 0)->valuestring);
+    TEST_ASSERT_EQUAL_STRING("def", cJSON_GetArrayItem(root, 1)->valuestring);
+    TEST_ASSERT_EQUAL_MEMORY("XXXX", json + 13, 4);
+
+    cJSON_Delete(root);
+}
+
+static void parse_in_situ_should_unescape_utf16(void)
+{
+    char json[] = "[\"\\u00e9\\u20ac\\ud83d\\ude00 \\/\"]";
+    cJSON *root = cJSON_ParseInSitu(json, sizeof(json) - 1);
+
+    TEST_ASSERT_NOT_NULL(root);
+    TEST_ASSERT_EQUAL_STRING("\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80 /", root->child->valuestring);
+
+    cJSON_Delete(root);
+}
+
+static void parse_in_situ_should_fail_on_invalid_input(void)
+{
+    char unterminated[] = "{\"key\":\"value";
+    char invalid_escape[] = "[\"\\x\"]";
+    char missing_value[] = "{\"key\":}";
+
+    TEST_ASSERT_NULL(cJSON_ParseInSitu(NULL, 10));
+    TEST_ASSERT_NULL(cJSON_ParseInSitu(unterminated, sizeof(unterminated) - 1));
+    TEST_ASSERT_NULL(cJSON_ParseInSitu(invalid_escape, sizeof(invalid_escape) - 1));
+    TEST_ASSERT_NULL(cJSON_ParseInSitu(missing_value, sizeof(missing_value) - 1));
+}
+
+static void parse_in_situ_items_should_be_duplicated(void)
+{
+    char json[] = "{\"name\":\"camera\"}";
+    cJSON *root = cJSON_ParseInSitu(json, sizeof(json) - 1);
+    cJSON *copy = cJSON_Duplicate(root, true);
+
+    TEST_ASSERT_NOT_NULL(copy);
+    TEST_ASSERT_BITS(cJSON_IsReference, 0, copy->child->type);
+    memset(json, 'X', sizeof(json) - 1);
+    TEST_ASSERT_EQUAL_STRING("camera", copy->child->valuestring);
+
+    TEST_ASSERT_NULL(cJSON_SetValuestring(root->child, "a longer value"));
+
+    cJSON_Delete(copy);
+    cJSON_Delete(root);
+}
+
+int CJSON_CDECL main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(parse_in_situ_should_point_into_the_input);
+    RUN_TEST(parse_in_situ_should_only_allocate_items);
+    RUN_TEST(parse_in_situ_should_not_need_a_null_terminator);
+    RUN_TEST(parse_in_situ_should_unescape_utf16);
+    RUN_TEST(parse_in_situ_should_fail_on_invalid_input);
+    RUN_TEST(parse_in_situ_items_should_be_duplicated);
+
+    return UNITY_END();
+}
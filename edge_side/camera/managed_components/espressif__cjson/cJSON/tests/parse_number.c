@@ -45,7 +45,7 @@ static void assert_is_number(cJSON *number_item)
 
 static void assert_parse_number(const char *string, int integer, double real)
 {
-    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0 } };
+    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0, 0 }, 0 };
     buffer.content = (const unsigned char*)string;
     buffer.length = strlen(string) + sizeof("");
     buffer.hooks = global_hooks;
@@ -58,7 +58,7 @@ static void assert_parse_number(const char *string, int integer, double real)
 
 static void assert_parse_big_number(const char *string)
 {
-    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0 } };
+    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0, 0 }, 0 };
     buffer.content = (const unsigned char*)string;
     buffer.length = strlen(string) + sizeof("");
     buffer.hooks = global_hooks;
@@ -115,6 +115,90 @@ static void parse_number_should_parse_big_numbers(void)
     assert_parse_big_number("999999999999999999999999999999999999999999999991234567890.1234567");
 }
 
+/* parse the start of string and compare the value and the length with what strtod reads */
+static void assert_parse_number_like_strtod(const char *string)
+{
+    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0, 0 }, 0 };
+    char *end = NULL;
+    double expected = strtod(string, &end);
+
+    buffer.content = (const unsigned char*)string;
+    buffer.length = strlen(string);
+    buffer.hooks = global_hooks;
+
+    TEST_ASSERT_TRUE_MESSAGE(parse_number(item, &buffer), string);
+    /* compare the bits, this also tells 0 and -0 apart */
+    TEST_ASSERT_EQUAL_MEMORY_MESSAGE(&expected, &item->valuedouble, sizeof(double), string);
+    TEST_ASSERT_EQUAL_UINT_MESSAGE((size_t)(end - string), buffer.offset, string);
+}
+
+static void parse_number_should_round_like_strtod(void)
+{
+    static const char * const numbers[] = {
+        "-0", "-0.0", "0e10", "0.000", "0.1", "0.2", "0.3", "0.30000000000000004", "12.5", "0.93125", "1700000000.067",
+        "123456789012345", "1234567890123456", "9007199254740993", "999999999999999.9", "0.000000000000000000000123",
+        "1e22", "1e23", "123456789e30", "123456789012345e-30", "1e-22", "1.5e-23", "4.35e-3", "1e37",
+        "1.7976931348623157e308", "1.7976931348623159e308", "2.2250738585072014e-308", "5e-324", "2e-324",
+        "00012.50", "1.", "-.5", "1E+2", "1e-0", "1e00000000000000000000001", "1e-99999999999999999999",
+        "0.000000000000000000000000000000000000000000000000000000000000000000000000000000000001"
+    };
+    unsigned long state = 7;
+    char number[32];
+    size_t i = 0;
+
+    for (i = 0; i < (sizeof(numbers) / sizeof(numbers[0])); i++)
+    {
+        assert_parse_number_like_strtod(numbers[i]);
+    }
+
+    for (i = 0; i < 100000; i++)
+    {
+        state = (state * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+        sprintf(number, "%lu.%lue%d", state % 100000UL, state % 1000UL, (int)(state % 81UL) - 40);
+        assert_parse_number_like_strtod(number);
+        sprintf(number, "%.*g", (int)(state % 17UL) + 1, ldexp((double)state, (int)(state % 200UL) - 100));
+        assert_parse_number_like_strtod(number);
+    }
+}
+
+static void parse_number_should_stop_where_the_number_ends(void)
+{
+    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0, 0 }, 0 };
+
+    /* no hexadecimal numbers, unlike strtod */
+    buffer.content = (const unsigned char*)"0x10";
+    buffer.length = 4;
+    buffer.hooks = global_hooks;
+    TEST_ASSERT_TRUE(parse_number(item, &buffer));
+    TEST_ASSERT_EQUAL_DOUBLE(0, item->valuedouble);
+    TEST_ASSERT_EQUAL_UINT(1, buffer.offset);
+
+    assert_parse_number_like_strtod("1e");
+    assert_parse_number_like_strtod("1e+");
+    assert_parse_number_like_strtod("1.5E-x");
+    assert_parse_number_like_strtod("12,34");
+    assert_parse_number_like_strtod("-7]");
+    assert_parse_number_like_strtod("3e4e5");
+    assert_parse_number_like_strtod("1+2");
+}
+
+static void parse_number_should_fail_without_digits(void)
+{
+    static const char * const invalid[] = { "-", "-.", ".", "-e5", "--1", "+1" };
+    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0, 0 }, 0 };
+    size_t i = 0;
+
+    buffer.hooks = global_hooks;
+    for (i = 0; i < (sizeof(invalid) / sizeof(invalid[0])); i++)
+    {
+        buffer.content = (const unsigned char*)invalid[i];
+        buffer.length = strlen(invalid[i]);
+        buffer.offset = 0;
+        TEST_ASSERT_FALSE_MESSAGE(parse_number(item, &buffer), invalid[i]);
+        TEST_ASSERT_EQUAL_UINT(0, buffer.offset);
+    }
+}
+
 int CJSON_CDECL main(void)
 {
     /* initialize cJSON item */
@@ -126,5 +210,8 @@ int CJSON_CDECL main(void)
     RUN_TEST(parse_number_should_parse_positive_reals);
     RUN_TEST(parse_number_should_parse_negative_reals);
     RUN_TEST(parse_number_should_parse_big_numbers);
+    RUN_TEST(parse_number_should_round_like_strtod);
+    RUN_TEST(parse_number_should_stop_where_the_number_ends);
+    RUN_TEST(parse_number_should_fail_without_digits);
     return UNITY_END();
 }
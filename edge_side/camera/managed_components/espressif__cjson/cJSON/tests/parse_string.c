@@ -45,7 +45,7 @@ static void assert_is_string(cJSON *string_item)
 
 static void assert_parse_string(const char *string, const char *expected)
 {
-    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0 } };
+    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0, 0 }, 0 };
     buffer.content = (const unsigned char*)string;
     buffer.length = strlen(string) + sizeof("");
     buffer.hooks = global_hooks;
@@ -59,7 +59,7 @@ static void assert_parse_string(const char *string, const char *expected)
 
 static void assert_not_parse_string(const char * const string)
 {
-    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0 } };
+    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0, 0 }, 0 };
     buffer.content = (const unsigned char*)string;
     buffer.length = strlen(string) + sizeof("");
     buffer.hooks = global_hooks;
@@ -112,6 +112,21 @@ static void parse_string_should_not_overflow_with_closing_backslash(void)
     reset(item);
 }
 
+static void parse_string_should_not_parse_invalid_utf16_literals(void)
+{
+    /* an invalid digit used to be read as 0, leaving the parser stuck on the escaped quote */
+    assert_not_parse_string("\"\\u000\\\"x\"");
+    reset(item);
+    assert_not_parse_string("\"\\u00\"");
+    reset(item);
+    assert_not_parse_string("\"\\u12G4\"");
+    reset(item);
+    assert_not_parse_string("\"\\uD83D\\udcx1\"");
+    reset(item);
+    assert_not_parse_string("\"\\u");
+    reset(item);
+}
+
 static void parse_string_should_parse_bug_94(void)
 {
     const char string[] = "\"~!@\\\\#$%^&*()\\\\\\\\-\\\\+{}[]:\\\\;\\\\\\\"\\\\<\\\\>?/.,DC=ad,DC=com\"";
@@ -131,5 +146,6 @@ int CJSON_CDECL main(void)
     RUN_TEST(parse_string_should_not_parse_invalid_backslash);
     RUN_TEST(parse_string_should_parse_bug_94);
     RUN_TEST(parse_string_should_not_overflow_with_closing_backslash);
+    RUN_TEST(parse_string_should_not_parse_invalid_utf16_literals);
     return UNITY_END();
 }
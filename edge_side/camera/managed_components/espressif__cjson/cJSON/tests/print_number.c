@@ -30,7 +30,7 @@ static void assert_print_number(const char *expected, double input)
     unsigned char new_buffer[26];
     unsigned int i = 0;
     cJSON item[1];
-    printbuffer buffer = { 0, 0, 0, 0, 0, 0, { 0, 0, 0 } };
+    printbuffer buffer = { 0, 0, 0, 0, 0, 0, { 0, 0, 0, 0 }, 0, 0 };
     buffer.buffer = printed;
     buffer.length = sizeof(printed);
     buffer.offset = 0;
@@ -88,7 +88,7 @@ static void print_number_should_print_positive_reals(void)
     assert_print_number("1000000000000", 10e11);
     assert_print_number("1.23e+129", 123e+127);
     assert_print_number("1.23e-126", 123e-128);
-    assert_print_number("3.1415926535897931", 3.1415926535897931);
+    assert_print_number("3.141592653589793", 3.1415926535897931);
 }
 
 static void print_number_should_print_negative_reals(void)
@@ -100,6 +100,129 @@ static void print_number_should_print_negative_reals(void)
     assert_print_number("-1.23e-126", -123e-128);
 }
 
+static void print_number_should_print_the_shortest_round_trip(void)
+{
+    assert_print_number("0.1", 0.1);
+    assert_print_number("0.30000000000000004", 0.1 + 0.2);
+    assert_print_number("12.5", 12.5);
+    assert_print_number("0.93125", 0.93125);
+    assert_print_number("1700000000.067", 1700000000.067);
+    assert_print_number("-0.0001", -0.0001);
+    assert_print_number("1e-05", 0.00001);
+    assert_print_number("123456789012", 123456789012.0);
+    assert_print_number("1e+15", 1e15);
+    assert_print_number("9007199254740992", 9007199254740992.0);
+    assert_print_number("1.2345678901234568e+17", 123456789012345678.0);
+    assert_print_number("1e+23", 1e23);
+    assert_print_number("1.7976931348623157e+308", 1.7976931348623157e308);
+    assert_print_number("5e-324", 4.9406564584124654e-324);
+}
+
+/* number of significant digits in a printed number, without leading and trailing zeroes */
+static int count_digits(const char *number)
+{
+    int digits = 0;
+    int zeroes = 0;
+
+    for (; (*number != '\0') && (*number != 'e'); number++)
+    {
+        if ((*number < '0') || (*number > '9'))
+        {
+            continue;
+        }
+        if (*number == '0')
+        {
+            zeroes++;
+            continue;
+        }
+        if (digits > 0)
+        {
+            digits += zeroes;
+        }
+        zeroes = 0;
+        digits++;
+    }
+
+    return digits;
+}
+
+static void print_number_should_print_large_integral_doubles(void)
+{
+    /* outside the int range integral doubles go through the same path as reals, with the %g layout:
+     * plain digits below 1e15 (or 1e17 for 16 and 17 digits), exponent form from there */
+    assert_print_number("2147483648", 2147483648.0);
+    assert_print_number("-4294967296", -4294967296.0);
+    assert_print_number("123456789012345", 123456789012345.0);
+    assert_print_number("9007199254740994", 9007199254740994.0);
+    assert_print_number("1e+20", 1e20);
+    assert_print_number("-1e+20", -1e20);
+    assert_print_number("1.152921504606847e+18", 1152921504606846976.0); /* 2^60 */
+    assert_print_number("1.8446744073709552e+19", 18446744073709551616.0); /* 2^64 */
+    /* the shortest digits that read back, where "%1.17g" printed -4.6116860184273879e+18 */
+    assert_print_number("-4.611686018427388e+18", -4611686018427387904.0); /* -2^62 */
+}
+
+static void print_number_should_round_trip(void)
+{
+    static const double powers_of_ten[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8 };
+    unsigned long state = 42;
+    int i = 0;
+
+    for (i = 0; i < 100000; i++)
+    {
+        unsigned char printed[32];
+        char shortest[32];
+        printbuffer buffer = { 0, 0, 0, 0, 0, 0, { 0, 0, 0, 0 }, 0, 0 };
+        cJSON item[1];
+        double number = 0;
+        int precision = 0;
+
+        /* mix numbers with few decimal places (like coordinates and scores) and arbitrary ones */
+        state = (state * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+        if ((i % 2) == 0)
+        {
+            number = (double)(state % 100000000UL) / powers_of_ten[state % 9];
+        }
+        else
+        {
+            number = ldexp((double)state / 2147483648.0 + 1.0 / 3.0, (int)(state % 2048UL) - 1024);
+        }
+        if ((i % 3) == 0)
+        {
+            number = -number;
+        }
+
+        buffer.buffer = printed;
+        buffer.length = sizeof(printed);
+        buffer.noalloc = true;
+        buffer.hooks = global_hooks;
+        memset(item, 0, sizeof(item));
+        cJSON_SetNumberValue(item, number);
+        TEST_ASSERT_TRUE(print_number(item, &buffer));
+        TEST_ASSERT_EQUAL_DOUBLE(number, strtod((const char*)printed, NULL));
+        TEST_ASSERT_TRUE_MESSAGE(strtod((const char*)printed, NULL) == number, (const char*)printed);
+
+        for (precision = 1; precision < 17; precision++)
+        {
+            sprintf(shortest, "%1.*g", precision, number);
+            if (strtod(shortest, NULL) == number)
+            {
+                break;
+            }
+        }
+        /* up to 15 digits between 1e-7 and 1e37 it is always the shortest, elsewhere Grisu2 can miss
+         * a shorter decimal that is within a fraction of the rounding boundary */
+        if ((precision <= 15) && (fabs(number) >= 1e-7) && (fabs(number) < 1e37))
+        {
+            TEST_ASSERT_EQUAL_INT_MESSAGE(precision, count_digits((const char*)printed), (const char*)printed);
+        }
+        else
+        {
+            TEST_ASSERT_TRUE_MESSAGE(count_digits((const char*)printed) <= 17, (const char*)printed);
+        }
+    }
+}
+
 static void print_number_should_print_non_number(void)
 {
     TEST_IGNORE();
@@ -119,6 +242,9 @@ int CJSON_CDECL main(void)
     RUN_TEST(print_number_should_print_positive_integers);
     RUN_TEST(print_number_should_print_positive_reals);
     RUN_TEST(print_number_should_print_negative_reals);
+    RUN_TEST(print_number_should_print_the_shortest_round_trip);
+    RUN_TEST(print_number_should_print_large_integral_doubles);
+    RUN_TEST(print_number_should_round_trip);
     RUN_TEST(print_number_should_print_non_number);
 
     return UNITY_END();
@@ -0,0 +1,217 @@
+/*
+  Copyright (c) 2009-2017 Dave Gamble and cJSON contributors
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity/examples/unity_config.h"
+#include "unity/src/unity.h"
+#include "common.h"
+
+typedef struct
+{
+    char text[16384];
+    size_t length;
+    size_t calls;
+    size_t fail_after; /* number of calls that succeed, 0 for all */
+} collected;
+
+static cJSON_bool CJSON_CDECL collect(void *context, const char *data, size_t length)
+{
+    collected *output = (collected*)context;
+
+    TEST_ASSERT_TRUE(length > 0);
+    TEST_ASSERT_TRUE((output->length + length) < sizeof(output->text));
+    output->calls++;
+    if ((output->fail_after != 0) && (output->calls > output->fail_after))
+    {
+        return false;
+    }
+    memcpy(output->text + output->length, data, length);
+    output->length += length;
+    output->text[output->length] = '\0';
+
+    return true;
+}
+
+static cJSON *parse_input(const char *name)
+{
+    char path[64];
+    char *content = NULL;
+    cJSON *parsed = NULL;
+
+    sprintf(path, "inputs/%s", name);
+    content = read_file(path);
+    TEST_ASSERT_NOT_NULL_MESSAGE(content, path);
+    parsed = cJSON_Parse(content);
+    TEST_ASSERT_NOT_NULL_MESSAGE(parsed, path);
+    free(content);
+
+    return parsed;
+}
+
+static const char * const inputs[] = { "test1", "test2", "test3", "test4", "test5", "test7", "test8", "test9", "test10", "test11" };
+
+static void printed_length_should_match_print(void)
+{
+    size_t i = 0;
+
+    for (i = 0; i < (sizeof(inputs) / sizeof(inputs[0])); i++)
+    {
+        cJSON *parsed = parse_input(inputs[i]);
+        char *formatted = cJSON_Print(parsed);
+        char *unformatted = cJSON_PrintUnformatted(parsed);
+
+        TEST_ASSERT_EQUAL_UINT_MESSAGE(strlen(formatted), cJSON_PrintedLength(parsed, true), inputs[i]);
+        TEST_ASSERT_EQUAL_UINT_MESSAGE(strlen(unformatted), cJSON_PrintedLength(parsed, false), inputs[i]);
+
+        cJSON_free(formatted);
+        cJSON_free(unformatted);
+        cJSON_Delete(parsed);
+    }
+
+    TEST_ASSERT_EQUAL_UINT(0, cJSON_PrintedLength(NULL, false));
+}
+
+static void print_to_buffer_should_need_exactly_the_printed_length(void)
+{
+    size_t i = 0;
+    int format = 0;
+
+    for (i = 0; i < (sizeof(inputs) / sizeof(inputs[0])); i++)
+    {
+        cJSON *parsed = parse_input(inputs[i]);
+
+        for (format = 0; format <= 1; format++)
+        {
+            char *expected = format ? cJSON_Print(parsed) : cJSON_PrintUnformatted(parsed);
+            size_t length = cJSON_PrintedLength(parsed, format);
+            /* with a guard byte that must stay untouched */
+            char *buffer = (char*)malloc(length + 2);
+
+            buffer[length + 1] = 'X';
+            TEST_ASSERT_TRUE_MESSAGE(cJSON_PrintToBuffer(parsed, buffer, length + 1, format), inputs[i]);
+            TEST_ASSERT_EQUAL_STRING(expected, buffer);
+            TEST_ASSERT_EQUAL_INT('X', buffer[length + 1]);
+
+            buffer[length] = 'X';
+            TEST_ASSERT_FALSE_MESSAGE(cJSON_PrintToBuffer(parsed, buffer, length, format), inputs[i]);
+            TEST_ASSERT_EQUAL_INT('X', buffer[length]);
+
+            free(buffer);
+            cJSON_free(expected);
+        }
+
+        cJSON_Delete(parsed);
+    }
+}
+
+static void print_to_sink_should_produce_the_same_text_in_pieces(void)
+{
+    static collected output;
+    size_t i = 0;
+    size_t chunk_size = 0;
+
+    for (i = 0; i < (sizeof(inputs) / sizeof(inputs[0])); i++)
+    {
+        cJSON *parsed = parse_input(inputs[i]);
+        char *expected = cJSON_Print(parsed);
+
+        for (chunk_size = 1; chunk_size <= 300; chunk_size += (chunk_size < 40) ? 1 : 37)
+        {
+            memset(&output, 0, sizeof(output));
+            TEST_ASSERT_TRUE(cJSON_PrintToSink(parsed, true, chunk_size, collect, &output));
+            TEST_ASSERT_EQUAL_STRING_MESSAGE(expected, output.text, inputs[i]);
+        }
+
+        cJSON_free(expected);
+        cJSON_Delete(parsed);
+    }
+}
+
+static void print_to_sink_should_hand_over_full_chunks(void)
+{
+    static collected output;
+    cJSON *array = cJSON_CreateArray();
+    cJSON *long_string = NULL;
+    char text[600];
+    int i = 0;
+
+    for (i = 0; i < 100; i++)
+    {
+        cJSON_AddItemToArray(array, cJSON_CreateNumber(i));
+    }
+    memset(&output, 0, sizeof(output));
+    TEST_ASSERT_TRUE(cJSON_PrintToSink(array, false, 64, collect, &output));
+    /* 291 bytes in chunks of up to 64 */
+    TEST_ASSERT_EQUAL_UINT(291, output.length);
+    TEST_ASSERT_TRUE(output.calls >= 5);
+    TEST_ASSERT_TRUE(output.calls <= 6);
+
+    /* a string that doesn't fit into a chunk is handed over in one piece */
+    memset(text, 'a', sizeof(text) - 1);
+    text[sizeof(text) - 1] = '\0';
+    long_string = cJSON_CreateString(text);
+    memset(&output, 0, sizeof(output));
+    TEST_ASSERT_TRUE(cJSON_PrintToSink(long_string, false, 64, collect, &output));
+    TEST_ASSERT_EQUAL_UINT(sizeof(text) + 1, output.length);
+    TEST_ASSERT_EQUAL_UINT(1, output.calls);
+    TEST_ASSERT_EQUAL_UINT(sizeof(text) + 1, cJSON_PrintedLength(long_string, false));
+
+    cJSON_Delete(long_string);
+    cJSON_Delete(array);
+}
+
+static void print_to_sink_should_stop_when_the_sink_fails(void)
+{
+    static collected output;
+    cJSON *parsed = parse_input("test1");
+
+    memset(&output, 0, sizeof(output));
+    output.fail_after = 2;
+    TEST_ASSERT_FALSE(cJSON_PrintToSink(parsed, true, 32, collect, &output));
+    TEST_ASSERT_EQUAL_UINT(3, output.calls);
+
+    memset(&output, 0, sizeof(output));
+    TEST_ASSERT_FALSE(cJSON_PrintToSink(NULL, true, 32, collect, &output));
+    TEST_ASSERT_FALSE(cJSON_PrintToSink(parsed, true, 32, NULL, &output));
+    TEST_ASSERT_FALSE(cJSON_PrintToSink(parsed, true, 0, collect, &output));
+    TEST_ASSERT_FALSE(cJSON_PrintToBuffer(parsed, NULL, 10, true));
+    TEST_ASSERT_FALSE(cJSON_PrintToBuffer(parsed, output.text, 0, true));
+    TEST_ASSERT_EQUAL_UINT(0, output.calls);
+
+    cJSON_Delete(parsed);
+}
+
+int CJSON_CDECL main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(printed_length_should_match_print);
+    RUN_TEST(print_to_buffer_should_need_exactly_the_printed_length);
+    RUN_TEST(print_to_sink_should_produce_the_same_text_in_pieces);
+    RUN_TEST(print_to_sink_should_hand_over_full_chunks);
+    RUN_TEST(print_to_sink_should_stop_when_the_sink_fails);
+
+    return UNITY_END();
+}
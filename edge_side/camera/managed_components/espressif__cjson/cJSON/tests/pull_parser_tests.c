@@ -0,0 +1,334 @@
+/*
+  Copyright (c) 2009-2017 Dave Gamble and cJSON contributors
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity/examples/unity_config.h"
+#include "unity/src/unity.h"
+#include "common.h"
+
+static const char document[] =
+    "{\"camera\":\"cam-\\u00e9\\\"1\\\"\",\"people_count\":3,\"ok\":true,\"error\":null,\"stale\":false,"
+    "\"boxes\":[[10,20.5,-30,4e2],[],{},[{\"label\":\"person\",\"score\":0.875}]],\"empty\":\"\",\"ratio\":-1.25E-3}";
+
+static void append_text(char *log, const char *text)
+{
+    strcat(log, text);
+    strcat(log, " ");
+}
+
+static void append_event(char *log, const int event, const cJSON *value)
+{
+    char number[64];
+
+    switch (event)
+    {
+        case cJSON_PullStartObject:
+            append_text(log, "{");
+            break;
+        case cJSON_PullEndObject:
+            append_text(log, "}");
+            break;
+        case cJSON_PullStartArray:
+            append_text(log, "[");
+            break;
+        case cJSON_PullEndArray:
+            append_text(log, "]");
+            break;
+        case cJSON_PullKey:
+            strcat(log, "k:");
+            append_text(log, value->valuestring);
+            break;
+        case cJSON_PullString:
+            strcat(log, "s:");
+            append_text(log, value->valuestring);
+            break;
+        case cJSON_PullNumber:
+            sprintf(number, "%.17g", value->valuedouble);
+            append_text(log, number);
+            break;
+        case cJSON_PullTrue:
+            append_text(log, "true");
+            break;
+        case cJSON_PullFalse:
+            append_text(log, "false");
+            break;
+        case cJSON_PullNull:
+            append_text(log, "null");
+            break;
+        default:
+            TEST_FAIL_MESSAGE("Unexpected event.");
+    }
+}
+
+/* walk a parsed tree and log the events the pull parser should produce */
+static void append_tree(char *log, const cJSON *item)
+{
+    const cJSON *child = NULL;
+
+    if (item->string != NULL)
+    {
+        strcat(log, "k:");
+        append_text(log, item->string);
+    }
+
+    switch (item->type & 0xFF)
+    {
+        case cJSON_Object:
+        case cJSON_Array:
+            append_text(log, cJSON_IsObject(item) ? "{" : "[");
+            for (child = item->child; child != NULL; child = child->next)
+            {
+                append_tree(log, child);
+            }
+            append_text(log, cJSON_IsObject(item) ? "}" : "]");
+            break;
+        case cJSON_String:
+            append_event(log, cJSON_PullString, item);
+            break;
+        case cJSON_Number:
+            append_event(log, cJSON_PullNumber, item);
+            break;
+        case cJSON_True:
+            append_text(log, "true");
+            break;
+        case cJSON_False:
+            append_text(log, "false");
+            break;
+        default:
+            append_text(log, "null");
+            break;
+    }
+}
+
+/* feed json in chunks of chunk_size bytes and log all events, returns the last event (end or error) */
+static int pull_events(const char *json, size_t length, size_t chunk_size, size_t window_size, char *log)
+{
+    cJSON_PullParser *parser = cJSON_CreatePullParser(window_size);
+    size_t position = 0;
+    int event = cJSON_PullNeedMore;
+
+    TEST_ASSERT_NOT_NULL(parser);
+    log[0] = '\0';
+
+    for (;;)
+    {
+        event = cJSON_PullNext(parser);
+        if (event == cJSON_PullNeedMore)
+        {
+            size_t chunk = length - position;
+            if (chunk == 0)
+            {
+                cJSON_PullFinish(parser);
+                continue;
+            }
+            if (chunk > chunk_size)
+            {
+                chunk = chunk_size;
+            }
+            position += cJSON_PullFeed(parser, json + position, chunk);
+            continue;
+        }
+        if ((event == cJSON_PullEnd) || (event == cJSON_PullError))
+        {
+            break;
+        }
+        append_event(log, event, cJSON_PullGetValue(parser));
+    }
+
+    if (event == cJSON_PullError)
+    {
+        TEST_ASSERT_EQUAL_INT(cJSON_PullError, cJSON_PullNext(parser));
+    }
+    cJSON_DeletePullParser(parser);
+
+    return event;
+}
+
+static void pull_parser_should_produce_the_same_as_the_tree(void)
+{
+    char expected[1024];
+    char actual[1024];
+    cJSON *tree = cJSON_Parse(document);
+
+    TEST_ASSERT_NOT_NULL(tree);
+    expected[0] = '\0';
+    append_tree(expected, tree);
+    cJSON_Delete(tree);
+
+    TEST_ASSERT_EQUAL_INT(cJSON_PullEnd, pull_events(document, sizeof(document) - 1, sizeof(document), sizeof(document), actual));
+    TEST_ASSERT_EQUAL_STRING(expected, actual);
+}
+
+static void pull_parser_should_handle_tokens_split_across_chunks(void)
+{
+    char expected[1024];
+    char actual[1024];
+    size_t chunk_size = 0;
+
+    TEST_ASSERT_EQUAL_INT(cJSON_PullEnd, pull_events(document, sizeof(document) - 1, sizeof(document), sizeof(document), expected));
+
+    for (chunk_size = 1; chunk_size < 40; chunk_size++)
+    {
+        /* the longest token is the 17 byte camera string */
+        TEST_ASSERT_EQUAL_INT(cJSON_PullEnd, pull_events(document, sizeof(document) - 1, chunk_size, 24, actual));
+        TEST_ASSERT_EQUAL_STRING(expected, actual);
+    }
+}
+
+static void pull_parser_should_accept_scalars_and_sequences(void)
+{
+    char log[256];
+
+    TEST_ASSERT_EQUAL_INT(cJSON_PullEnd, pull_events("42", 2, 1, 8, log));
+    TEST_ASSERT_EQUAL_STRING("42 ", log);
+    TEST_ASSERT_EQUAL_INT(cJSON_PullEnd, pull_events(" \"text\" ", 8, 3, 8, log));
+    TEST_ASSERT_EQUAL_STRING("s:text ", log);
+
+    TEST_ASSERT_EQUAL_INT(cJSON_PullEnd, pull_events("{\"a\":1}\n{\"a\":2}\n[null]\n", 23, 5, 8, log));
+    TEST_ASSERT_EQUAL_STRING("{ k:a 1 } { k:a 2 } [ null ] ", log);
+}
+
+static void pull_parser_should_report_errors(void)
+{
+    char log[256];
+    static const char * const invalid[] = {
+        "",
+        "   ",
+        "[1,2",
+        "[1,2,]",
+        "{\"a\":1,}",
+        "{\"a\" 1}",
+        "{\"a\":1]",
+        "[1}",
+        "{1:2}",
+        "[tru]",
+        "[nul",
+        "[\"unterminated",
+        "[\"\\x\"]",
+        "[-]",
+        "1 2 x"
+    };
+    size_t i = 0;
+
+    for (i = 0; i < (sizeof(invalid) / sizeof(invalid[0])); i++)
+    {
+        TEST_ASSERT_EQUAL_INT_MESSAGE(cJSON_PullError, pull_events(invalid[i], strlen(invalid[i]), 2, 16, log), invalid[i]);
+    }
+
+    /* tokens have to fit into the window */
+    TEST_ASSERT_EQUAL_INT(cJSON_PullError, pull_events("[\"0123456789\"]", 14, 4, 8, log));
+    TEST_ASSERT_EQUAL_INT(cJSON_PullEnd, pull_events("[\"0123456789\"]", 14, 4, 12, log));
+}
+
+static void pull_parser_should_limit_nesting(void)
+{
+    char *deep = (char*)malloc(CJSON_NESTING_LIMIT + 1);
+    /* "[ " for every level that is accepted */
+    char *log = (char*)malloc((2 * CJSON_NESTING_LIMIT) + 1);
+
+    memset(deep, '[', CJSON_NESTING_LIMIT + 1);
+    TEST_ASSERT_EQUAL_INT(cJSON_PullError, pull_events(deep, CJSON_NESTING_LIMIT + 1, 64, 64, log));
+    TEST_ASSERT_EQUAL_UINT(2 * CJSON_NESTING_LIMIT, strlen(log));
+
+    free(log);
+    free(deep);
+}
+
+static void pull_parser_should_run_in_a_small_window(void)
+{
+    static const char box[] = "{\"x\":12.5,\"y\":40,\"w\":100,\"h\":220,\"label\":\"person\",\"score\":0.93125},";
+    const size_t count = 30000;
+    const size_t length = 1 + (count * (sizeof(box) - 1));
+    char *json = (char*)malloc(length);
+    cJSON_PullParser *parser = cJSON_CreatePullParser(64);
+    size_t position = 0;
+    size_t labels = 0;
+    size_t i = 0;
+    int event = cJSON_PullNeedMore;
+
+    TEST_ASSERT_NOT_NULL(parser);
+    json[0] = '[';
+    for (i = 0; i < count; i++)
+    {
+        memcpy(json + 1 + (i * (sizeof(box) - 1)), box, sizeof(box) - 1);
+    }
+    json[length - 1] = ']';
+
+    while ((event = cJSON_PullNext(parser)) != cJSON_PullEnd)
+    {
+        TEST_ASSERT_NOT_EQUAL(cJSON_PullError, event);
+        if (event == cJSON_PullNeedMore)
+        {
+            if (position == length)
+            {
+                cJSON_PullFinish(parser);
+            }
+            position += cJSON_PullFeed(parser, json + position, length - position);
+        }
+        else if ((event == cJSON_PullKey) && (strcmp(cJSON_PullGetValue(parser)->valuestring, "label") == 0))
+        {
+            TEST_ASSERT_EQUAL_UINT(2, cJSON_PullGetDepth(parser));
+            labels++;
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT(count, labels);
+    TEST_ASSERT_EQUAL_UINT(0, cJSON_PullGetDepth(parser));
+
+    cJSON_DeletePullParser(parser);
+    free(json);
+}
+
+static void pull_parser_should_handle_null_arguments(void)
+{
+    cJSON_PullParser *parser = cJSON_CreatePullParser(8);
+
+    TEST_ASSERT_NULL(cJSON_CreatePullParser(0));
+    TEST_ASSERT_EQUAL_INT(cJSON_PullError, cJSON_PullNext(NULL));
+    TEST_ASSERT_EQUAL_UINT(0, cJSON_PullFeed(NULL, "1", 1));
+    TEST_ASSERT_EQUAL_UINT(0, cJSON_PullFeed(parser, NULL, 1));
+    TEST_ASSERT_NULL(cJSON_PullGetValue(NULL));
+    TEST_ASSERT_EQUAL_UINT(0, cJSON_PullGetDepth(NULL));
+    cJSON_PullFinish(NULL);
+    cJSON_DeletePullParser(NULL);
+
+    cJSON_PullFinish(parser);
+    TEST_ASSERT_EQUAL_UINT(0, cJSON_PullFeed(parser, "1", 1));
+    cJSON_DeletePullParser(parser);
+}
+
+int CJSON_CDECL main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(pull_parser_should_produce_the_same_as_the_tree);
+    RUN_TEST(pull_parser_should_handle_tokens_split_across_chunks);
+    RUN_TEST(pull_parser_should_accept_scalars_and_sequences);
+    RUN_TEST(pull_parser_should_report_errors);
+    RUN_TEST(pull_parser_should_limit_nesting);
+    RUN_TEST(pull_parser_should_run_in_a_small_window);
+    RUN_TEST(pull_parser_should_handle_null_arguments);
+
+    return UNITY_END();
+}
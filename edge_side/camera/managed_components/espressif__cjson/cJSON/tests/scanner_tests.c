@@ -0,0 +1,172 @@
+/*
+  Copyright (c) 2009-2017 Dave Gamble and cJSON contributors
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity/examples/unity_config.h"
+#include "unity/src/unity.h"
+#include "common.h"
+
+/* compare the block scanners with byte at a time loops at every alignment and for every length */
+
+static unsigned char input[200];
+
+static size_t expected_non_whitespace(size_t position, size_t length)
+{
+    while ((position < length) && (input[position] <= 32))
+    {
+        position++;
+    }
+
+    return position;
+}
+
+static size_t expected_quote_or_backslash(size_t position, size_t length)
+{
+    while ((position < length) && (input[position] != '\"') && (input[position] != '\\'))
+    {
+        position++;
+    }
+
+    return position;
+}
+
+static void assert_scanners_match(void)
+{
+    size_t position = 0;
+    size_t length = 0;
+
+    for (length = 0; length <= sizeof(input); length++)
+    {
+        for (position = 0; position <= ((length < 40) ? length : 40); position++)
+        {
+            TEST_ASSERT_EQUAL_UINT(expected_non_whitespace(position, length), skip_whitespace_bytes(input, position, length));
+            TEST_ASSERT_EQUAL_UINT(expected_quote_or_backslash(position, length), find_quote_or_backslash(input, position, length));
+        }
+    }
+}
+
+static void scanners_should_find_single_bytes(void)
+{
+    static const unsigned char special[] = { '\"', '\\', 'a', '!', '#', '[', 0x7F, 0x80, 0xA2, 0xDC, 0xFF };
+    size_t i = 0;
+    size_t at = 0;
+
+    for (i = 0; i < sizeof(special); i++)
+    {
+        for (at = 0; at < sizeof(input); at += 7)
+        {
+            memset(input, ' ', sizeof(input));
+            input[at] = special[i];
+            assert_scanners_match();
+
+            memset(input, 'x', sizeof(input));
+            input[at] = special[i];
+            assert_scanners_match();
+        }
+    }
+}
+
+static void scanners_should_treat_all_control_bytes_as_whitespace(void)
+{
+    size_t i = 0;
+
+    for (i = 0; i < sizeof(input); i++)
+    {
+        input[i] = (unsigned char)(i % 33);
+    }
+    assert_scanners_match();
+
+    input[150] = 33;
+    assert_scanners_match();
+}
+
+static void scanners_should_handle_random_input(void)
+{
+    /* mostly whitespace and text with the occasional quote, backslash and high byte */
+    static const unsigned char alphabet[] = { ' ', ' ', '\t', '\n', '\r', 'a', 'b', '\"', '\\', 0xC3, 0xA9, 0x01, '0', ':' };
+    unsigned long state = 1;
+    int round = 0;
+    size_t i = 0;
+
+    for (round = 0; round < 20; round++)
+    {
+        for (i = 0; i < sizeof(input); i++)
+        {
+            state = (state * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+            /* runs of one kind of byte make the blocks interesting */
+            input[i] = ((state >> 16) % 4 == 0) ? alphabet[(state >> 8) % sizeof(alphabet)] : ((round % 2 == 0) ? ' ' : 'x');
+        }
+        assert_scanners_match();
+    }
+}
+
+static void parse_should_not_depend_on_the_block_size(void)
+{
+    char json[300];
+    char expected[64];
+    size_t padding = 0;
+
+    for (padding = 0; padding < 70; padding++)
+    {
+        cJSON *parsed = NULL;
+        char *printed = NULL;
+        size_t length = 0;
+
+        /* whitespace and string contents crossing block boundaries everywhere */
+        memset(json, ' ', padding);
+        length = padding;
+        json[length++] = '[';
+        memset(json + length, '\n', padding);
+        length += padding;
+        strcpy(json + length, "\"ab\\\"c\\\\d\\u00e9 0123456789abcdefghijklmnopqrstuvwxyz\\n\", \"\\\\\"]");
+        length += strlen(json + length);
+
+        parsed = cJSON_ParseWithLength(json, length);
+        TEST_ASSERT_NOT_NULL(parsed);
+        printed = cJSON_PrintUnformatted(parsed);
+        TEST_ASSERT_NOT_NULL(printed);
+        strcpy(expected, "[\"ab\\\"c\\\\d\xc3\xa9 0123456789abcdefghijklmnopqrstuvwxyz\\n\",\"\\\\\"]");
+        TEST_ASSERT_EQUAL_STRING(expected, printed);
+
+        cJSON_free(printed);
+        cJSON_Delete(parsed);
+
+        /* unterminated strings and trailing backslashes at every length */
+        TEST_ASSERT_NULL(cJSON_ParseWithLength(json, padding + 1 + padding + 10));
+        TEST_ASSERT_NULL(cJSON_ParseWithLength(json, padding + 1 + padding + 4));
+    }
+}
+
+int CJSON_CDECL main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(scanners_should_find_single_bytes);
+    RUN_TEST(scanners_should_treat_all_control_bytes_as_whitespace);
+    RUN_TEST(scanners_should_handle_random_input);
+    RUN_TEST(parse_should_not_depend_on_the_block_size);
+
+    return UNITY_END();
+}
@@ -0,0 +1,190 @@
+/*
+  Copyright (c) 2009-2017 Dave Gamble and cJSON contributors
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity/examples/unity_config.h"
+#include "unity/src/unity.h"
+#include "common.h"
+
+#define FIELD_BRIGHTNESS 0
+#define FIELD_QUALITY 1
+#define FIELD_MODE 2
+#define FIELD_ENABLED 3
+#define FIELD_EXTRA 4
+
+static const cJSON_SchemaField fields[] = {
+    { "brightness", cJSON_Number, false },
+    { "quality", cJSON_Number, true },
+    { "mode", cJSON_String, false },
+    { "enabled", cJSON_True | cJSON_False, false },
+    { "extra", 0, false }
+};
+
+static int match(const char *json, const cJSON **slots, size_t *error_field)
+{
+    cJSON_Schema *schema = cJSON_CreateSchema(fields, sizeof(fields) / sizeof(fields[0]));
+    cJSON *object = cJSON_Parse(json);
+    int result = 0;
+
+    TEST_ASSERT_NOT_NULL(schema);
+    TEST_ASSERT_NOT_NULL(object);
+    result = cJSON_MatchSchema(schema, object, slots, error_field);
+
+    /* the slots point into the object, only check them while it exists */
+    if (result == cJSON_SchemaOk)
+    {
+        TEST_ASSERT_TRUE((slots[FIELD_QUALITY] != NULL) && (slots[FIELD_QUALITY]->valueint == 12));
+    }
+    cJSON_Delete(object);
+    cJSON_DeleteSchema(schema);
+
+    return result;
+}
+
+static void schema_should_find_all_fields_in_one_walk(void)
+{
+    cJSON_Schema *schema = cJSON_CreateSchema(fields, sizeof(fields) / sizeof(fields[0]));
+    cJSON *object = cJSON_Parse("{\"unknown\":1,\"extra\":[1],\"quality\":12,\"mode\":\"fast\",\"enabled\":false,\"Brightness\":3}");
+    const cJSON *slots[sizeof(fields) / sizeof(fields[0])];
+    size_t error_field = 42;
+
+    TEST_ASSERT_EQUAL_INT(cJSON_SchemaOk, cJSON_MatchSchema(schema, object, slots, &error_field));
+    TEST_ASSERT_EQUAL_UINT(42, error_field);
+    /* keys are case sensitive */
+    TEST_ASSERT_NULL(slots[FIELD_BRIGHTNESS]);
+    TEST_ASSERT_EQUAL_INT(12, slots[FIELD_QUALITY]->valueint);
+    TEST_ASSERT_EQUAL_STRING("fast", slots[FIELD_MODE]->valuestring);
+    TEST_ASSERT_TRUE(cJSON_IsFalse(slots[FIELD_ENABLED]));
+    TEST_ASSERT_TRUE(cJSON_IsArray(slots[FIELD_EXTRA]));
+
+    /* the same as a lookup per key */
+    TEST_ASSERT_TRUE(slots[FIELD_MODE] == cJSON_GetObjectItemCaseSensitive(object, "mode"));
+
+    cJSON_Delete(object);
+    cJSON_DeleteSchema(schema);
+}
+
+static void schema_should_report_the_failing_field(void)
+{
+    const cJSON *slots[sizeof(fields) / sizeof(fields[0])];
+    size_t error_field = 0;
+
+    TEST_ASSERT_EQUAL_INT(cJSON_SchemaWrongType, match("{\"quality\":12,\"mode\":1}", slots, &error_field));
+    TEST_ASSERT_EQUAL_UINT(FIELD_MODE, error_field);
+    TEST_ASSERT_EQUAL_INT(cJSON_SchemaWrongType, match("{\"quality\":12,\"enabled\":null}", slots, &error_field));
+    TEST_ASSERT_EQUAL_UINT(FIELD_ENABLED, error_field);
+    TEST_ASSERT_EQUAL_INT(cJSON_SchemaMissing, match("{\"brightness\":1}", slots, &error_field));
+    TEST_ASSERT_EQUAL_UINT(FIELD_QUALITY, error_field);
+    TEST_ASSERT_EQUAL_INT(cJSON_SchemaNotObject, match("[12]", slots, &error_field));
+    TEST_ASSERT_EQUAL_INT(cJSON_SchemaOk, match("{\"quality\":12,\"enabled\":true,\"extra\":null}", slots, NULL));
+}
+
+static void schema_should_use_the_first_of_repeated_keys(void)
+{
+    const cJSON *slots[sizeof(fields) / sizeof(fields[0])];
+    size_t error_field = 0;
+
+    /* like cJSON_GetObjectItemCaseSensitive */
+    TEST_ASSERT_EQUAL_INT(cJSON_SchemaOk, match("{\"quality\":12,\"quality\":\"ignored\"}", slots, &error_field));
+    TEST_ASSERT_EQUAL_INT(cJSON_SchemaWrongType, match("{\"quality\":\"first\",\"quality\":12}", slots, &error_field));
+    TEST_ASSERT_EQUAL_UINT(FIELD_QUALITY, error_field);
+}
+
+static void schema_should_scale_to_many_fields(void)
+{
+    cJSON_SchemaField many[100];
+    const cJSON *slots[100];
+    char keys[100][16];
+    cJSON *object = cJSON_CreateObject();
+    cJSON_Schema *schema = NULL;
+    int i = 0;
+
+    for (i = 0; i < 100; i++)
+    {
+        sprintf(keys[i], "key%d", i);
+        many[i].key = keys[i];
+        many[i].types = cJSON_Number;
+        many[i].required = (i % 2) == 0;
+    }
+    /* only the even ones in reverse order */
+    for (i = 98; i >= 0; i -= 2)
+    {
+        cJSON_AddItemToObject(object, keys[i], cJSON_CreateNumber(i));
+    }
+    schema = cJSON_CreateSchema(many, 100);
+    TEST_ASSERT_NOT_NULL(schema);
+
+    TEST_ASSERT_EQUAL_INT(cJSON_SchemaOk, cJSON_MatchSchema(schema, object, slots, NULL));
+    for (i = 0; i < 100; i++)
+    {
+        if ((i % 2) == 0)
+        {
+            TEST_ASSERT_EQUAL_INT(i, slots[i]->valueint);
+        }
+        else
+        {
+            TEST_ASSERT_NULL(slots[i]);
+        }
+    }
+
+    cJSON_DeleteSchema(schema);
+    cJSON_Delete(object);
+}
+
+static void schema_should_reject_invalid_fields(void)
+{
+    static const cJSON_SchemaField duplicate[] = { { "a", 0, false }, { "b", 0, false }, { "a", 0, false } };
+    static const cJSON_SchemaField null_key[] = { { "a", 0, false }, { NULL, 0, false } };
+    cJSON_Schema *empty = cJSON_CreateSchema(duplicate, 0);
+    cJSON *object = cJSON_CreateObject();
+    const cJSON *slot = NULL;
+
+    TEST_ASSERT_NULL(cJSON_CreateSchema(duplicate, 3));
+    TEST_ASSERT_NULL(cJSON_CreateSchema(null_key, 2));
+    TEST_ASSERT_NULL(cJSON_CreateSchema(NULL, 0));
+
+    TEST_ASSERT_NOT_NULL(empty);
+    TEST_ASSERT_EQUAL_INT(cJSON_SchemaOk, cJSON_MatchSchema(empty, object, &slot, NULL));
+    TEST_ASSERT_EQUAL_INT(cJSON_SchemaNotObject, cJSON_MatchSchema(NULL, object, &slot, NULL));
+    TEST_ASSERT_EQUAL_INT(cJSON_SchemaNotObject, cJSON_MatchSchema(empty, NULL, &slot, NULL));
+    TEST_ASSERT_EQUAL_INT(cJSON_SchemaNotObject, cJSON_MatchSchema(empty, object, NULL, NULL));
+
+    cJSON_DeleteSchema(empty);
+    cJSON_DeleteSchema(NULL);
+    cJSON_Delete(object);
+}
+
+int CJSON_CDECL main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(schema_should_find_all_fields_in_one_walk);
+    RUN_TEST(schema_should_report_the_failing_field);
+    RUN_TEST(schema_should_use_the_first_of_repeated_keys);
+    RUN_TEST(schema_should_scale_to_many_fields);
+    RUN_TEST(schema_should_reject_invalid_fields);
+
+    return UNITY_END();
+}
@@ -0,0 +1,497 @@
+// Copyright 2015-2025 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include "img_resize.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Filter weights are Q14 and sum to exactly 1 << 14. Horizontally filtered
+// rows are kept as Q6 int16, which leaves room for the bicubic overshoot
+// (at most 1.125 * 255 * 64), and the vertical pass accumulates Q20 in int32.
+#define WEIGHT_BITS     14
+#define ROW_BITS        6
+#define H_SHIFT         (WEIGHT_BITS - ROW_BITS)
+#define V_SHIFT         (WEIGHT_BITS + ROW_BITS)
+
+typedef struct {
+    uint16_t *start;        // first source index of each output's taps
+    int16_t *weights;       // taps weights per output
+    uint16_t taps;
+} resize_axis_t;
+
+struct img_resizer {
+    uint16_t src_w;
+    uint16_t src_h;
+    uint16_t dst_w;
+    uint16_t dst_h;
+    resize_format_t format;
+    resize_filter_t filter;
+    uint8_t channels;       // working channels, RGB565 is filtered as 3
+    resize_axis_t x;
+    resize_axis_t y;
+    int16_t *rows;          // ring of y.taps horizontally filtered rows
+    int32_t *row_src;       // source row held by each ring slot, -1 if none
+    const int16_t **window; // the y.taps rows of the current output row
+    uint8_t *line;          // RGB565 unpack / pack scratch
+};
+
+static size_t bytes_per_pixel(resize_format_t format)
+{
+    return format == RESIZE_GRAY8 ? 1 : (format == RESIZE_RGB565 ? 2 : 3);
+}
+
+static size_t image_stride(const resize_image_t *img)
+{
+    return img->stride ? img->stride : img->width * bytes_per_pixel(img->format);
+}
+
+static double cubic(double x)
+{
+    // Catmull-Rom, a = -0.5
+    x = fabs(x);
+    if(x < 1.0) {
+        return (1.5 * x - 2.5) * x * x + 1.0;
+    } else if(x < 2.0) {
+        return ((-0.5 * x + 2.5) * x - 4.0) * x + 2.0;
+    }
+    return 0.0;
+}
+
+static int filter_taps(resize_filter_t filter, double scale)
+{
+    if(filter == RESIZE_NEAREST) {
+        return 1;
+    } else if(filter == RESIZE_BICUBIC) {
+        return 4;
+    } else if(filter == RESIZE_AREA && scale > 1.0) {
+        return (int)ceil(scale) + 1;
+    }
+    return 2;
+}
+
+// The n filter taps of one output position, with out of range source indices
+// clamped to the edge and folded into a window of taps <= n pixels at *first.
+// folded is scratch space for n weights.
+static void axis_taps(resize_filter_t filter, uint16_t src, uint16_t dst, uint16_t d, int *first, double *w, double *folded, int n, int taps)
+{
+    double scale = (double)src / dst;
+    int i0;
+
+    for(int k=0; k<n; k++) {
+        w[k] = 0.0;
+    }
+    if(filter == RESIZE_AREA && scale > 1.0) {
+        double lo = d * scale, hi = lo + scale;
+        i0 = (int)floor(lo);
+        for(int k=0; k<n; k++) {
+            double a = i0 + k, b = a + 1.0;
+            double overlap = (b < hi ? b : hi) - (a > lo ? a : lo);
+            if(overlap > 0.0) {
+                w[k] = overlap / scale;
+            }
+        }
+    } else {
+        double center = (d + 0.5) * scale - 0.5;
+        double f;
+        i0 = (int)floor(center);
+        f = center - i0;
+        if(filter == RESIZE_BICUBIC) {
+            i0 -= 1;
+            for(int k=0; k<4; k++) {
+                w[k] = cubic(f + 1 - k);
+            }
+        } else {
+            // bilinear, and area when upscaling
+            w[0] = 1.0 - f;
+            w[1] = f;
+        }
+    }
+
+    int lo = i0 < 0 ? 0 : i0;
+    if(lo + taps > src) {
+        lo = src - taps;
+    }
+    for(int k=0; k<n; k++) {
+        folded[k] = 0.0;
+    }
+    for(int k=0; k<n; k++) {
+        int i = i0 + k;
+        i = i < 0 ? 0 : (i >= src ? src - 1 : i);
+        folded[i - lo] += w[k];
+    }
+    memcpy(w, folded, n * sizeof(double));
+    *first = lo;
+}
+
+static bool axis_init(resize_axis_t *axis, resize_filter_t filter, uint16_t src, uint16_t dst)
+{
+    int n = filter_taps(filter, (double)src / dst);
+    int taps = n < src ? n : src;
+
+    axis->taps = taps;
+    axis->start = (uint16_t *)malloc(dst * sizeof(uint16_t));
+    axis->weights = (int16_t *)malloc((size_t)dst * taps * sizeof(int16_t));
+    // n grows with the downscale factor, too much for a task stack
+    double *w = (double *)malloc(2 * (size_t)n * sizeof(double));
+    if(!axis->start || !axis->weights || !w) {
+        free(w);
+        return false;
+    }
+
+    for(int d=0; d<dst; d++) {
+        int16_t *q = axis->weights + (size_t)d * taps;
+        if(filter == RESIZE_NEAREST) {
+            axis->start[d] = ((2 * d + 1) * src) / (2 * dst);
+            q[0] = 1 << WEIGHT_BITS;
+            continue;
+        }
+        int first, sum = 0, big = 0;
+        axis_taps(filter, src, dst, d, &first, w, w + n, n, taps);
+        for(int k=0; k<taps; k++) {
+            q[k] = (int16_t)lrint(w[k] * (1 << WEIGHT_BITS));
+            sum += q[k];
+            if(q[k] > q[big]) {
+                big = k;
+            }
+        }
+        // rounding residue goes to the largest tap so flat areas stay flat
+        q[big] += (1 << WEIGHT_BITS) - sum;
+        axis->start[d] = first;
+    }
+    free(w);
+    return true;
+}
+
+void img_resizer_free(img_resizer_t *resizer)
+{
+    if(!resizer) {
+        return;
+    }
+    free(resizer->x.start);
+    free(resizer->x.weights);
+    free(resizer->y.start);
+    free(resizer->y.weights);
+    free(resizer->rows);
+    free(resizer->row_src);
+    free(resizer->window);
+    free(resizer->line);
+    free(resizer);
+}
+
+img_resizer_t *img_resizer_create(uint16_t src_width, uint16_t src_height, uint16_t dst_width, uint16_t dst_height, resize_format_t format, resize_filter_t filter)
+{
+    if(!src_width || !src_height || !dst_width || !dst_height) {
+        return NULL;
+    }
+    img_resizer_t *r = (img_resizer_t *)calloc(1, sizeof(img_resizer_t));
+    if(!r) {
+        return NULL;
+    }
+    r->src_w = src_width;
+    r->src_h = src_height;
+    r->dst_w = dst_width;
+    r->dst_h = dst_height;
+    r->format = format;
+    r->filter = filter;
+    r->channels = format == RESIZE_GRAY8 ? 1 : 3;
+    if(!axis_init(&r->x, filter, src_width, dst_width) || !axis_init(&r->y, filter, src_height, dst_height)) {
+        goto fail;
+    }
+    if(filter != RESIZE_NEAREST) {
+        r->rows = (int16_t *)malloc((size_t)dst_width * r->channels * r->y.taps * sizeof(int16_t));
+        r->row_src = (int32_t *)malloc(r->y.taps * sizeof(int32_t));
+        r->window = (const int16_t **)malloc(r->y.taps * sizeof(const int16_t *));
+        if(!r->rows || !r->row_src || !r->window) {
+            goto fail;
+        }
+        if(format == RESIZE_RGB565) {
+            size_t w = src_width > dst_width ? src_width : dst_width;
+            r->line = (uint8_t *)malloc(w * 3);
+            if(!r->line) {
+                goto fail;
+            }
+        }
+    }
+    return r;
+
+fail:
+    img_resizer_free(r);
+    return NULL;
+}
+
+static void unpack_rgb565(const uint8_t *src, uint8_t *dst, size_t count)
+{
+    for(size_t i=0; i<count; i++) {
+        uint8_t hb = *src++;
+        uint8_t lb = *src++;
+        *dst++ = hb & 0xF8;
+        *dst++ = (hb & 0x07) << 5 | (lb & 0xE0) >> 3;
+        *dst++ = (lb & 0x1F) << 3;
+    }
+}
+
+static void pack_rgb565(const uint8_t *src, uint8_t *dst, size_t count)
+{
+    for(size_t i=0; i<count; i++) {
+        uint8_t r = *src++;
+        uint8_t g = *src++;
+        uint8_t b = *src++;
+        *dst++ = (r & 0xF8) | (g >> 5);
+        *dst++ = ((g << 3) & 0xE0) | (b >> 3);
+    }
+}
+
+static void resize_nearest(const img_resizer_t *r, const resize_image_t *src, const resize_image_t *dst)
+{
+    size_t bpp = bytes_per_pixel(r->format);
+    size_t src_stride = image_stride(src), dst_stride = image_stride(dst);
+    const uint16_t *xs = r->x.start;
+
+    for(int y=0; y<r->dst_h; y++) {
+        const uint8_t *s = src->data + r->y.start[y] * src_stride;
+        uint8_t *d = dst->data + y * dst_stride;
+        if(bpp == 1) {
+            for(int x=0; x<r->dst_w; x++) {
+                d[x] = s[xs[x]];
+            }
+        } else if(bpp == 2) {
+            for(int x=0; x<r->dst_w; x++) {
+                d[2 * x] = s[2 * xs[x]];
+                d[2 * x + 1] = s[2 * xs[x] + 1];
+            }
+        } else {
+            for(int x=0; x<r->dst_w; x++) {
+                const uint8_t *p = s + 3 * xs[x];
+                d[3 * x] = p[0];
+                d[3 * x + 1] = p[1];
+                d[3 * x + 2] = p[2];
+            }
+        }
+    }
+}
+
+// Source row of interleaved 8-bit channels to one Q6 row of dst_w pixels
+static void filter_row(const img_resizer_t *r, const uint8_t *s, int16_t *out)
+{
+    const int taps = r->x.taps;
+    const int round = 1 << (H_SHIFT - 1);
+
+    if(r->channels == 1) {
+        for(int x=0; x<r->dst_w; x++) {
+            const uint8_t *p = s + r->x.start[x];
+            const int16_t *w = r->x.weights + x * taps;
+            int32_t acc = round;
+            for(int k=0; k<taps; k++) {
+                acc += p[k] * w[k];
+            }
+            out[x] = acc >> H_SHIFT;
+        }
+    } else if(taps == 2) {
+        for(int x=0; x<r->dst_w; x++) {
+            const uint8_t *p = s + 3 * r->x.start[x];
+            const int16_t *w = r->x.weights + 2 * x;
+            out[0] = (p[0] * w[0] + p[3] * w[1] + round) >> H_SHIFT;
+            out[1] = (p[1] * w[0] + p[4] * w[1] + round) >> H_SHIFT;
+            out[2] = (p[2] * w[0] + p[5] * w[1] + round) >> H_SHIFT;
+            out += 3;
+        }
+    } else {
+        for(int x=0; x<r->dst_w; x++) {
+            const uint8_t *p = s + 3 * r->x.start[x];
+            const int16_t *w = r->x.weights + x * taps;
+            int32_t a0 = round, a1 = round, a2 = round;
+            for(int k=0; k<taps; k++) {
+                a0 += p[3 * k] * w[k];
+                a1 += p[3 * k + 1] * w[k];
+                a2 += p[3 * k + 2] * w[k];
+            }
+            out[0] = a0 >> H_SHIFT;
+            out[1] = a1 >> H_SHIFT;
+            out[2] = a2 >> H_SHIFT;
+            out += 3;
+        }
+    }
+}
+
+// Combine taps filtered rows into count output bytes
+static void filter_column(const int16_t *const *rows, const int16_t *w, int taps, uint8_t *out, size_t count)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i round = _mm_set1_epi32(1 << (V_SHIFT - 1));
+    for(; i + 8 <= count; i += 8) {
+        __m128i lo = round, hi = round;
+        for(int k=0; k<taps; k+=2) {
+            __m128i a = _mm_loadu_si128((const __m128i *)(rows[k] + i));
+            __m128i b = _mm_setzero_si128();
+            int32_t pair = (uint16_t)w[k];
+            if(k + 1 < taps) {
+                b = _mm_loadu_si128((const __m128i *)(rows[k + 1] + i));
+                pair |= (int32_t)((uint32_t)(uint16_t)w[k + 1] << 16);
+            }
+            __m128i wp = _mm_set1_epi32(pair);
+            lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), wp));
+            hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), wp));
+        }
+        lo = _mm_srai_epi32(lo, V_SHIFT);
+        hi = _mm_srai_epi32(hi, V_SHIFT);
+        __m128i v = _mm_packs_epi32(lo, hi);
+        _mm_storel_epi64((__m128i *)(out + i), _mm_packus_epi16(v, v));
+    }
+#endif
+    for(; i < count; i++) {
+        int32_t acc = 1 << (V_SHIFT - 1);
+        for(int k=0; k<taps; k++) {
+            acc += rows[k][i] * w[k];
+        }
+        acc >>= V_SHIFT;
+        out[i] = acc < 0 ? 0 : (acc > 255 ? 255 : acc);
+    }
+}
+
+bool img_resizer_run(img_resizer_t *r, const resize_image_t *src, const resize_image_t *dst)
+{
+    if(!r || !src || !dst || !src->data || !dst->data
+        || src->width != r->src_w || src->height != r->src_h || src->format != r->format
+        || dst->width != r->dst_w || dst->height != r->dst_h || dst->format != r->format) {
+        return false;
+    }
+    if(r->filter == RESIZE_NEAREST) {
+        resize_nearest(r, src, dst);
+        return true;
+    }
+
+    const int taps = r->y.taps;
+    const size_t row_len = (size_t)r->dst_w * r->channels;
+    size_t src_stride = image_stride(src), dst_stride = image_stride(dst);
+    const int16_t **rows = r->window;
+
+    for(int k=0; k<taps; k++) {
+        r->row_src[k] = -1;
+    }
+    for(int y=0; y<r->dst_h; y++) {
+        int first = r->y.start[y];
+        for(int k=0; k<taps; k++) {
+            int sy = first + k;
+            int slot = sy % taps;
+            int16_t *row = r->rows + slot * row_len;
+            if(r->row_src[slot] != sy) {
+                const uint8_t *s = src->data + sy * src_stride;
+                if(r->format == RESIZE_RGB565) {
+                    unpack_rgb565(s, r->line, r->src_w);
+                    s = r->line;
+                }
+                filter_row(r, s, row);
+                r->row_src[slot] = sy;
+            }
+            rows[k] = row;
+        }
+        uint8_t *d = dst->data + y * dst_stride;
+        if(r->format == RESIZE_RGB565) {
+            filter_column(rows, r->y.weights + y * taps, taps, r->line, row_len);
+            pack_rgb565(r->line, d, r->dst_w);
+        } else {
+            filter_column(rows, r->y.weights + y * taps, taps, d, row_len);
+        }
+    }
+    return true;
+}
+
+bool img_resize(const resize_image_t *src, const resize_image_t *dst, resize_filter_t filter)
+{
+    if(!src || !dst || src->format != dst->format) {
+        return false;
+    }
+    img_resizer_t *r = img_resizer_create(src->width, src->height, dst->width, dst->height, src->format, filter);
+    if(!r) {
+        return false;
+    }
+    bool ret = img_resizer_run(r, src, dst);
+    img_resizer_free(r);
+    return ret;
+}
+
+void img_letterbox_rect(uint16_t src_width, uint16_t src_height, uint16_t dst_width, uint16_t dst_height, resize_rect_t *rect)
+{
+    uint32_t w, h;
+    if((uint32_t)dst_width * src_height <= (uint32_t)dst_height * src_width) {
+        w = dst_width;
+        h = ((uint32_t)src_height * dst_width + src_width / 2) / src_width;
+    } else {
+        h = dst_height;
+        w = ((uint32_t)src_width * dst_height + src_height / 2) / src_height;
+    }
+    if(!w) {
+        w = 1;
+    }
+    if(!h) {
+        h = 1;
+    }
+    rect->width = w;
+    rect->height = h;
+    rect->left = (dst_width - w) / 2;
+    rect->top = (dst_height - h) / 2;
+}
+
+static void fill_rect(const resize_image_t *img, int left, int top, int width, int height, const uint8_t pad[3])
+{
+    size_t bpp = bytes_per_pixel(img->format), stride = image_stride(img);
+    uint8_t px[3] = {pad[0], pad[1], pad[2]};
+    if(img->format == RESIZE_RGB565) {
+        pack_rgb565(pad, px, 1);
+    }
+    for(int y=top; y<top + height; y++) {
+        uint8_t *d = img->data + y * stride + left * bpp;
+        if(bpp == 1) {
+            memset(d, px[0], width);
+            continue;
+        }
+        for(int x=0; x<width; x++) {
+            memcpy(d, px, bpp);
+            d += bpp;
+        }
+    }
+}
+
+bool img_letterbox(const resize_image_t *src, const resize_image_t *dst, resize_filter_t filter, const uint8_t pad[3], resize_rect_t *rect)
+{
+    resize_rect_t lb;
+    if(!src || !dst || !pad || src->format != dst->format || !src->width || !src->height || !dst->width || !dst->height) {
+        return false;
+    }
+    img_letterbox_rect(src->width, src->height, dst->width, dst->height, &lb);
+
+    resize_image_t inner = *dst;
+    inner.stride = image_stride(dst);
+    inner.data = dst->data + lb.top * inner.stride + lb.left * bytes_per_pixel(dst->format);
+    inner.width = lb.width;
+    inner.height = lb.height;
+    if(!img_resize(src, &inner, filter)) {
+        return false;
+    }
+
+    fill_rect(dst, 0, 0, dst->width, lb.top, pad);
+    fill_rect(dst, 0, lb.top + lb.height, dst->width, dst->height - lb.top - lb.height, pad);
+    fill_rect(dst, 0, lb.top, lb.left, lb.height, pad);
+    fill_rect(dst, lb.left + lb.width, lb.top, dst->width - lb.left - lb.width, lb.height, pad);
+    if(rect) {
+        *rect = lb;
+    }
+    return true;
+}
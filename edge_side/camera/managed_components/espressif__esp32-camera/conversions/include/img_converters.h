@@ -23,6 +23,7 @@ extern "C" {
 #include <stdbool.h>
 #include "esp_camera.h"
 #include "jpeg_decoder.h"
+#include "img_resize.h"
 
 typedef size_t (* jpg_out_cb)(void * arg, size_t index, const void* data, size_t len);
 
@@ -109,6 +110,36 @@ bool fmt2bmp(uint8_t *src, size_t src_len, uint16_t width, uint16_t height, pixf
  */
 bool frame2bmp(camera_fb_t * fb, uint8_t ** out, size_t * out_len);
 
+/**
+ * @brief Convert image buffer to BMP
+ *
+ * The header is written first and then the pixel rows, padded to 4 bytes, as
+ * they are converted or decoded. Only a few rows (one row of MCUs for JPEG)
+ * are ever held in memory, instead of the whole image like fmt2bmp().
+ *
+ * @param src       Source buffer in JPEG, RGB565, RGB888, YUYV or GRAYSCALE format
+ * @param src_len   Length in bytes of the source buffer
+ * @param width     Width in pixels of the source image
+ * @param height    Height in pixels of the source image
+ * @param format    Format of the source image
+ * @param cb        Callback to be called to write the bytes of the output BMP
+ * @param arg       Pointer to be passed to the callback
+ *
+ * @return true on success, false if a conversion or a callback failed
+ */
+bool fmt2bmp_cb(uint8_t *src, size_t src_len, uint16_t width, uint16_t height, pixformat_t format, jpg_out_cb cb, void * arg);
+
+/**
+ * @brief Convert camera frame buffer to BMP
+ *
+ * @param fb        Source camera frame buffer
+ * @param cb        Callback to be called to write the bytes of the output BMP
+ * @param arg       Pointer to be passed to the callback
+ *
+ * @return true on success, false if a conversion or a callback failed
+ */
+bool frame2bmp_cb(camera_fb_t * fb, jpg_out_cb cb, void * arg);
+
 /**
  * @brief Convert image buffer to RGB888 buffer (used for face detection)
  *
@@ -121,6 +152,97 @@ bool frame2bmp(camera_fb_t * fb, uint8_t ** out, size_t * out_len);
  */
 bool fmt2rgb888(const uint8_t *src_buf, size_t src_len, pixformat_t format, uint8_t * rgb_buf);
 
+typedef enum {
+    TENSOR_FLOAT32,     /*!< float, (pixel - mean) / std */
+    TENSOR_INT8,        /*!< int8, the float value quantized with scale and zero_point */
+} tensor_type_t;
+
+/**
+ * @brief Model input description for fmt2tensor()
+ */
+typedef struct {
+    uint16_t width;         /*!< Tensor width */
+    uint16_t height;        /*!< Tensor height */
+    tensor_type_t type;     /*!< Element type */
+    float mean[3];          /*!< Per channel mean in pixel units, R, G, B */
+    float std[3];           /*!< Per channel standard deviation in pixel units, R, G, B */
+    float scale;            /*!< TENSOR_INT8: quantization scale */
+    int8_t zero_point;      /*!< TENSOR_INT8: quantization zero point */
+    uint8_t pad;            /*!< Letterbox fill, as a pixel value before normalization */
+} tensor_config_t;
+
+/**
+ * @brief YOLO style input: float 0..1, padded with gray 114
+ */
+#define TENSOR_CONFIG_DEFAULT(w, h) { \
+    .width = (w), \
+    .height = (h), \
+    .type = TENSOR_FLOAT32, \
+    .mean = {0, 0, 0}, \
+    .std = {255, 255, 255}, \
+    .scale = 1, \
+    .zero_point = 0, \
+    .pad = 114, \
+}
+
+/**
+ * @brief Where the image landed inside a letterboxed tensor.
+ *        A tensor coordinate x maps back to source pixel (x - left) / scale.
+ */
+typedef struct {
+    float scale;            /*!< Tensor pixels per source pixel */
+    uint16_t left;          /*!< Padding columns on the left */
+    uint16_t top;           /*!< Padding rows on the top */
+    uint16_t width;         /*!< Width of the image area */
+    uint16_t height;        /*!< Height of the image area */
+} tensor_letterbox_t;
+
+/**
+ * @brief Compute the letterbox placement of a src_width x src_height image
+ *        scaled to fit a dst_width x dst_height tensor with its aspect ratio kept
+ *
+ * @param src_width     Width in pixels of the source image
+ * @param src_height    Height in pixels of the source image
+ * @param dst_width     Tensor width
+ * @param dst_height    Tensor height
+ * @param letterbox     Populated with the placement
+ */
+void tensor_letterbox(uint16_t src_width, uint16_t src_height, uint16_t dst_width, uint16_t dst_height, tensor_letterbox_t *letterbox);
+
+/**
+ * @brief Convert image buffer to a planar (CHW) R, G, B model input tensor
+ *
+ * The image is scaled with nearest neighbour sampling to fit the tensor,
+ * centered and padded, and each pixel is normalized through a lookup table,
+ * all in one pass over the tensor rows. Only a few kB of scratch memory are
+ * used for raw formats. JPEG input is decoded first, using the decoder's
+ * 1/2, 1/4 or 1/8 scaling when the tensor is small enough.
+ *
+ * @param src       Source buffer in JPEG, RGB565, RGB888, YUYV or GRAYSCALE format
+ * @param src_len   Length in bytes of the source buffer
+ * @param width     Width in pixels of the source image (ignored for JPEG)
+ * @param height    Height in pixels of the source image (ignored for JPEG)
+ * @param format    Format of the source image
+ * @param config    Tensor description
+ * @param out       Output tensor, 3 * config->width * config->height elements of config->type
+ * @param letterbox Optional, populated with where the image landed in the tensor
+ *
+ * @return true on success
+ */
+bool fmt2tensor(const uint8_t *src, size_t src_len, uint16_t width, uint16_t height, pixformat_t format, const tensor_config_t *config, void *out, tensor_letterbox_t *letterbox);
+
+/**
+ * @brief Convert camera frame buffer to a planar (CHW) model input tensor
+ *
+ * @param fb        Source camera frame buffer
+ * @param config    Tensor description
+ * @param out       Output tensor, 3 * config->width * config->height elements of config->type
+ * @param letterbox Optional, populated with where the image landed in the tensor
+ *
+ * @return true on success
+ */
+bool frame2tensor(camera_fb_t * fb, const tensor_config_t *config, void *out, tensor_letterbox_t *letterbox);
+
 // Macros for backwards compatibility
 #define JPG_SCALE_NONE JPEG_IMAGE_SCALE_0
 #define JPG_SCALE_2X   JPEG_IMAGE_SCALE_1_2
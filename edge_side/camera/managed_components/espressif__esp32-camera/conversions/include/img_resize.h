@@ -0,0 +1,123 @@
+// Copyright 2015-2025 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef _IMG_RESIZE_H_
+#define _IMG_RESIZE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Image resizing with plain C dependencies only, so the same code builds for
+// the camera and for host tools.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum {
+    RESIZE_GRAY8,       /*!< 1 byte per pixel */
+    RESIZE_RGB888,      /*!< 3 bytes per pixel, in any channel order */
+    RESIZE_RGB565,      /*!< 2 bytes per pixel, high byte first like PIXFORMAT_RGB565 */
+} resize_format_t;
+
+typedef enum {
+    RESIZE_NEAREST,     /*!< Pixel replication / decimation, no filtering */
+    RESIZE_BILINEAR,    /*!< 2x2 taps on pixel centres */
+    RESIZE_AREA,        /*!< Box filter over the covered source area, best for downscaling */
+    RESIZE_BICUBIC,     /*!< 4x4 Catmull-Rom taps */
+} resize_filter_t;
+
+/**
+ * @brief An image or a window into one
+ */
+typedef struct {
+    uint8_t *data;          /*!< First pixel */
+    uint16_t width;         /*!< Width in pixels */
+    uint16_t height;        /*!< Height in pixels */
+    size_t stride;          /*!< Bytes from one row to the next, 0 for tightly packed rows */
+    resize_format_t format; /*!< Pixel format */
+} resize_image_t;
+
+typedef struct {
+    uint16_t left;
+    uint16_t top;
+    uint16_t width;
+    uint16_t height;
+} resize_rect_t;
+
+typedef struct img_resizer img_resizer_t;
+
+/**
+ * @brief Prepare a resize between two fixed sizes
+ *
+ * The filter taps are computed once here as 14-bit fixed point weights, so a
+ * resizer should be kept and reused for every frame of a stream. Rows are
+ * filtered horizontally as they are first needed and kept in a ring of as
+ * many rows as the vertical filter has taps, so the working set stays a few
+ * rows regardless of the image size.
+ *
+ * @param src_width     Width in pixels of the source images
+ * @param src_height    Height in pixels of the source images
+ * @param dst_width     Width in pixels of the resized images
+ * @param dst_height    Height in pixels of the resized images
+ * @param format        Pixel format of both source and resized images
+ * @param filter        Interpolation filter
+ *
+ * @return the resizer, or NULL if a size is zero or memory ran out
+ */
+img_resizer_t *img_resizer_create(uint16_t src_width, uint16_t src_height, uint16_t dst_width, uint16_t dst_height, resize_format_t format, resize_filter_t filter);
+
+/**
+ * @brief Resize src into dst, whose sizes and format must match the resizer
+ *
+ * @return true on success
+ */
+bool img_resizer_run(img_resizer_t *resizer, const resize_image_t *src, const resize_image_t *dst);
+
+/**
+ * @brief Free a resizer returned by img_resizer_create()
+ */
+void img_resizer_free(img_resizer_t *resizer);
+
+/**
+ * @brief Resize src into dst in one call
+ *
+ * @return true on success
+ */
+bool img_resize(const resize_image_t *src, const resize_image_t *dst, resize_filter_t filter);
+
+/**
+ * @brief Compute where a src_width x src_height image lands when scaled to
+ *        fit a dst_width x dst_height one with its aspect ratio kept, centered
+ */
+void img_letterbox_rect(uint16_t src_width, uint16_t src_height, uint16_t dst_width, uint16_t dst_height, resize_rect_t *rect);
+
+/**
+ * @brief Resize src to fit dst with its aspect ratio kept and fill the borders
+ *
+ * @param src       Source image
+ * @param dst       Destination image, same format as src
+ * @param filter    Interpolation filter
+ * @param pad       Border color as R, G, B; gray images use pad[0]
+ * @param rect      Optional, populated with where the image landed in dst
+ *
+ * @return true on success
+ */
+bool img_letterbox(const resize_image_t *src, const resize_image_t *dst, resize_filter_t filter, const uint8_t pad[3], resize_rect_t *rect);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _IMG_RESIZE_H_ */
@@ -612,8 +612,14 @@ namespace jpge {
         m_image_bpl_mcu  = m_image_x_mcu * m_num_components;
         m_mcus_per_row   = m_image_x_mcu / m_mcu_x;
 
-        if ((m_mcu_lines[0] = static_cast<uint8*>(jpge_malloc(m_image_bpl_mcu * m_mcu_y))) == NULL) {
-            return false;
+        uint mcu_lines_size = m_image_bpl_mcu * m_mcu_y;
+        if (mcu_lines_size > m_mcu_lines_size) {
+            jpge_free(m_mcu_lines[0]);
+            m_mcu_lines_size = 0;
+            if ((m_mcu_lines[0] = static_cast<uint8*>(jpge_malloc(mcu_lines_size))) == NULL) {
+                return false;
+            }
+            m_mcu_lines_size = mcu_lines_size;
         }
         for (int i = 1; i < m_mcu_y; i++)
             m_mcu_lines[i] = m_mcu_lines[i-1] + m_image_bpl_mcu;
@@ -678,13 +684,14 @@ namespace jpge {
 
     void jpeg_encoder::clear()
     {
-        m_mcu_lines[0] = NULL;
         m_pass_num = 0;
         m_all_stream_writes_succeeded = true;
     }
 
     jpeg_encoder::jpeg_encoder()
     {
+        m_mcu_lines[0] = NULL;
+        m_mcu_lines_size = 0;
         clear();
     }
 
@@ -695,7 +702,7 @@ namespace jpge {
 
     bool jpeg_encoder::init(output_stream *pStream, int width, int height, int src_channels, const params &comp_params)
     {
-        deinit();
+        clear();
         if (((!pStream) || (width < 1) || (height < 1)) || ((src_channels != 1) && (src_channels != 3) && (src_channels != 4)) || (!comp_params.check())) return false;
         m_pStream = pStream;
         m_params = comp_params;
@@ -705,6 +712,8 @@ namespace jpge {
     void jpeg_encoder::deinit()
     {
         jpge_free(m_mcu_lines[0]);
+        m_mcu_lines[0] = NULL;
+        m_mcu_lines_size = 0;
         clear();
     }
 
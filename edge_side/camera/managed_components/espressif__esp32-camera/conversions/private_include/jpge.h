@@ -62,6 +62,9 @@ namespace jpge
             // width, height  - Image dimensions.
             // channels - May be 1, or 3. 1 indicates grayscale, 3 indicates RGB source data.
             // Returns false on out of memory or if a stream write fails.
+            // Calling init() again on the same object reuses the MCU line buffer
+            // when the new image fits in it, so one encoder can serve a stream
+            // of frames without an allocation per frame.
             bool init(output_stream *pStream, int width, int height, int src_channels, const params &comp_params = params());
 
             // Call this method with each source scanline.
@@ -90,6 +93,7 @@ namespace jpge
             int m_mcus_per_row;
             int m_mcu_x, m_mcu_y;
             uint8 *m_mcu_lines[16];
+            uint m_mcu_lines_size;
             uint8 m_mcu_y_ofs;
             sample_array_t m_sample_array[64];
             int16 m_coefficient_array[64];
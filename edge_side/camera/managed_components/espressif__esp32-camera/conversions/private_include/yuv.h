@@ -18,10 +18,20 @@
 extern "C" {
 #endif
 
+#include <stddef.h>
 #include <stdint.h>
 
 void yuv2rgb(uint8_t y, uint8_t u, uint8_t v, uint8_t *r, uint8_t *g, uint8_t *b);
 
+// Convert a run of YUYV (YUV422) pixels, e.g. one line, in a single call.
+// Results match yuv2rgb(). pixels should be even: a trailing odd pixel
+// has no V sample of its own and is skipped.
+void yuv422_to_rgb888(const uint8_t *src, uint8_t *dst, size_t pixels);
+void yuv422_to_bgr888(const uint8_t *src, uint8_t *dst, size_t pixels);
+// RGB565 is written high byte first, the byte order of PIXFORMAT_RGB565 frames
+void yuv422_to_rgb565(const uint8_t *src, uint8_t *dst, size_t pixels);
+void yuv422_to_gray(const uint8_t *src, uint8_t *dst, size_t pixels);
+
 #ifdef __cplusplus
 }
 #endif
@@ -23,6 +23,20 @@
 
 #include "esp_system.h"
 
+#if CONFIG_JD_USE_ROM
+#include "rom/tjpgd.h"
+/* The ROM code of TJPGD is older and has different return type in decode callback */
+typedef unsigned int jpeg_decode_out_t;
+#else
+#include "tjpgd.h"
+typedef int jpeg_decode_out_t;
+#endif
+
+/* If not set JD_FORMAT, it is set in ROM to RGB888 */
+#ifndef JD_FORMAT
+#define JD_FORMAT 0
+#endif
+
 #if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
 #include "esp32-hal-log.h"
 #define TAG ""
@@ -32,6 +46,7 @@ static const char* TAG = "to_bmp";
 #endif
 
 static const int BMP_HEADER_LEN = 54;
+static const int BMP_STREAM_ROWS = 8; // rows converted per callback when streaming raw formats
 static uint8_t work[3100]; // 3.1kB for JPEG decoder, static for legacy reasons
 
 typedef struct {
@@ -51,6 +66,22 @@ typedef struct {
     uint32_t mostimpcolor;
 } bmp_header_t;
 
+typedef struct {
+    jpg_out_cb cb;
+    void * arg;
+    size_t index;
+} bmp_stream_t;
+
+typedef struct {
+    const uint8_t *src;
+    size_t src_len;
+    size_t read;
+    bmp_stream_t *out;
+    uint8_t *band;
+    size_t row_size;
+    uint16_t width;
+} bmp_jpg_decoder_t;
+
 static void *_malloc(size_t size)
 {
     // check if SPIRAM is enabled and allocate on SPIRAM if allocatable
@@ -61,6 +92,61 @@ static void *_malloc(size_t size)
     return malloc(size);
 }
 
+static void bmp_header(uint8_t *buf, uint16_t width, uint16_t height, int bpp, size_t palette_size, size_t image_size)
+{
+    bmp_header_t bitmap = {
+        .filesize = BMP_HEADER_LEN + palette_size + image_size,
+        .reserved = 0,
+        .fileoffset_to_pixelarray = BMP_HEADER_LEN + palette_size,
+        .dibheadersize = 40,
+        .width = width,
+        .height = -height, //set negative for top to bottom
+        .planes = 1,
+        .bitsperpixel = bpp * 8,
+        .compression = 0,
+        .imagesize = image_size,
+        .ypixelpermeter = 0x0B13, //2835 , 72 DPI
+        .xpixelpermeter = 0x0B13, //2835 , 72 DPI
+        .numcolorspallette = 0,
+        .mostimpcolor = 0,
+    };
+    buf[0] = 'B';
+    buf[1] = 'M';
+    memcpy(buf + 2, &bitmap, sizeof(bitmap));
+}
+
+// BMP stores 24-bit pixels as B, G, R; grayscale is indexed through a gray palette
+static void bmp_pixels(const uint8_t *src, uint8_t *dst, size_t pix_count, pixformat_t format)
+{
+    if(format == PIXFORMAT_RGB888) {
+        memcpy(dst, src, pix_count*3);
+    } else if(format == PIXFORMAT_RGB565) {
+        size_t i;
+        uint8_t hb, lb;
+        for(i=0; i<pix_count; i++) {
+            hb = *src++;
+            lb = *src++;
+            *dst++ = (lb & 0x1F) << 3;
+            *dst++ = (hb & 0x07) << 5 | (lb & 0xE0) >> 3;
+            *dst++ = hb & 0xF8;
+        }
+    } else if(format == PIXFORMAT_GRAYSCALE) {
+        memcpy(dst, src, pix_count);
+    } else if(format == PIXFORMAT_YUV422) {
+        yuv422_to_bgr888(src, dst, pix_count);
+    }
+}
+
+static bool bmp_write(bmp_stream_t *stream, const void *data, size_t len)
+{
+    if(stream->cb(stream->arg, stream->index, data, len) != len) {
+        ESP_LOGE(TAG, "BMP write failed at %u", stream->index);
+        return false;
+    }
+    stream->index += len;
+    return true;
+}
+
 static bool jpg2rgb888(const uint8_t *src, size_t src_len, uint8_t * out, esp_jpeg_image_scale_t scale)
 {
     esp_jpeg_image_cfg_t jpeg_cfg = {
@@ -111,7 +197,7 @@ bool jpg2bmp(const uint8_t *src, size_t src_len, uint8_t ** out, size_t * out_le
         .indata_size = src_len,
         .out_format = JPEG_IMAGE_FORMAT_RGB888,
         .out_scale = JPEG_IMAGE_SCALE_0,
-        .flags.swap_color_bytes = 0,
+        .flags.swap_color_bytes = 1, // BMP wants B, G, R
         .advanced.working_buffer = work,
         .advanced.working_buffer_size = sizeof(work),
     };
@@ -142,23 +228,7 @@ bool jpg2bmp(const uint8_t *src, size_t src_len, uint8_t ** out, size_t * out_le
         goto fail;
     }
 
-    output[0] = 'B';
-    output[1] = 'M';
-    bmp_header_t * bitmap  = (bmp_header_t*)&output[2];
-    bitmap->reserved = 0;
-    bitmap->filesize = output_size;
-    bitmap->fileoffset_to_pixelarray = BMP_HEADER_LEN;
-    bitmap->dibheadersize = 40;
-    bitmap->width  =  output_img.width;
-    bitmap->height = -output_img.height; //set negative for top to bottom
-    bitmap->planes = 1;
-    bitmap->bitsperpixel = 24;
-    bitmap->compression = 0;
-    bitmap->imagesize = output_img.output_len;
-    bitmap->ypixelpermeter = 0x0B13 ; //2835 , 72 DPI
-    bitmap->xpixelpermeter = 0x0B13 ; //2835 , 72 DPI
-    bitmap->numcolorspallette = 0;
-    bitmap->mostimpcolor = 0;
+    bmp_header(output, output_img.width, output_img.height, 3, 0, output_img.output_len);
 
     *out = output;
     *out_len = output_size;
@@ -200,26 +270,7 @@ bool fmt2rgb888(const uint8_t *src_buf, size_t src_len, pixformat_t format, uint
             *rgb_buf++ = b;
         }
     } else if(format == PIXFORMAT_YUV422) {
-        pix_count = src_len / 2;
-        int i, maxi = pix_count / 2;
-        uint8_t y0, y1, u, v;
-        uint8_t r, g, b;
-        for(i=0; i<maxi; i++) {
-            y0 = *src_buf++;
-            u = *src_buf++;
-            y1 = *src_buf++;
-            v = *src_buf++;
-
-            yuv2rgb(y0, u, v, &r, &g, &b);
-            *rgb_buf++ = b;
-            *rgb_buf++ = g;
-            *rgb_buf++ = r;
-
-            yuv2rgb(y1, u, v, &r, &g, &b);
-            *rgb_buf++ = b;
-            *rgb_buf++ = g;
-            *rgb_buf++ = r;
-        }
+        yuv422_to_bgr888(src_buf, rgb_buf, src_len / 2);
     }
     return true;
 }
@@ -247,23 +298,7 @@ bool fmt2bmp(uint8_t *src, size_t src_len, uint16_t width, uint16_t height, pixf
         return false;
     }
 
-    out_buf[0] = 'B';
-    out_buf[1] = 'M';
-    bmp_header_t * bitmap  = (bmp_header_t*)&out_buf[2];
-    bitmap->reserved = 0;
-    bitmap->filesize = out_size;
-    bitmap->fileoffset_to_pixelarray = BMP_HEADER_LEN + palette_size;
-    bitmap->dibheadersize = 40;
-    bitmap->width = width;
-    bitmap->height = -height;//set negative for top to bottom
-    bitmap->planes = 1;
-    bitmap->bitsperpixel = bpp * 8;
-    bitmap->compression = 0;
-    bitmap->imagesize = pix_count * bpp;
-    bitmap->ypixelpermeter = 0x0B13 ; //2835 , 72 DPI
-    bitmap->xpixelpermeter = 0x0B13 ; //2835 , 72 DPI
-    bitmap->numcolorspallette = 0;
-    bitmap->mostimpcolor = 0;
+    bmp_header(out_buf, width, height, bpp, palette_size, pix_count * bpp);
 
     uint8_t * palette_buf = out_buf + BMP_HEADER_LEN;
     uint8_t * pix_buf = palette_buf + palette_size;
@@ -283,41 +318,7 @@ bool fmt2bmp(uint8_t *src, size_t src_len, uint16_t width, uint16_t height, pixf
     }
 
     //convert data to RGB888
-    if(format == PIXFORMAT_RGB888) {
-        memcpy(pix_buf, src_buf, pix_count*3);
-    } else if(format == PIXFORMAT_RGB565) {
-        int i;
-        uint8_t hb, lb;
-        for(i=0; i<pix_count; i++) {
-            hb = *src_buf++;
-            lb = *src_buf++;
-            *pix_buf++ = (lb & 0x1F) << 3;
-            *pix_buf++ = (hb & 0x07) << 5 | (lb & 0xE0) >> 3;
-            *pix_buf++ = hb & 0xF8;
-        }
-    } else if(format == PIXFORMAT_GRAYSCALE) {
-        memcpy(pix_buf, src_buf, pix_count);
-    } else if(format == PIXFORMAT_YUV422) {
-        int i, maxi = pix_count / 2;
-        uint8_t y0, y1, u, v;
-        uint8_t r, g, b;
-        for(i=0; i<maxi; i++) {
-            y0 = *src_buf++;
-            u = *src_buf++;
-            y1 = *src_buf++;
-            v = *src_buf++;
-
-            yuv2rgb(y0, u, v, &r, &g, &b);
-            *pix_buf++ = b;
-            *pix_buf++ = g;
-            *pix_buf++ = r;
-
-            yuv2rgb(y1, u, v, &r, &g, &b);
-            *pix_buf++ = b;
-            *pix_buf++ = g;
-            *pix_buf++ = r;
-        }
-    }
+    bmp_pixels(src_buf, pix_buf, pix_count, format);
     *out = out_buf;
     *out_len = out_size;
     return true;
@@ -327,3 +328,174 @@ bool frame2bmp(camera_fb_t * fb, uint8_t ** out, size_t * out_len)
 {
     return fmt2bmp(fb->buf, fb->len, fb->width, fb->height, fb->format, out, out_len);
 }
+
+static unsigned int bmp_jpg_read(JDEC *decoder, uint8_t *buf, unsigned int len)
+{
+    bmp_jpg_decoder_t *jpeg = (bmp_jpg_decoder_t *)decoder->device;
+    if(len > jpeg->src_len - jpeg->read) {
+        len = jpeg->src_len - jpeg->read;
+    }
+    if(buf) {
+        memcpy(buf, jpeg->src + jpeg->read, len);
+    }
+    jpeg->read += len;
+    return len;
+}
+
+// tjpgd hands out MCUs left to right, so a band of rows is complete once the rightmost MCU arrives
+static jpeg_decode_out_t bmp_jpg_write(JDEC *decoder, void *bitmap, JRECT *rect)
+{
+    bmp_jpg_decoder_t *jpeg = (bmp_jpg_decoder_t *)decoder->device;
+    const uint8_t *in = (const uint8_t *)bitmap;
+    int w = rect->right - rect->left + 1;
+    int x, y;
+
+    for(y=rect->top; y<=rect->bottom; y++) {
+        uint8_t *out = jpeg->band + (y - rect->top) * jpeg->row_size + rect->left * 3;
+        for(x=0; x<w; x++) {
+#if JD_FORMAT == 1
+            uint16_t c = in[0] | in[1] << 8;
+            out[0] = c << 3;
+            out[1] = (c >> 3) & 0xFC;
+            out[2] = (c >> 8) & 0xF8;
+            in += 2;
+#else
+            out[0] = in[2];
+            out[1] = in[1];
+            out[2] = in[0];
+            in += 3;
+#endif
+            out += 3;
+        }
+    }
+    if(rect->right + 1 < jpeg->width) {
+        return 1;
+    }
+    return bmp_write(jpeg->out, jpeg->band, (rect->bottom - rect->top + 1) * jpeg->row_size);
+}
+
+static bool jpg2bmp_cb(const uint8_t *src, size_t src_len, jpg_out_cb cb, void * arg)
+{
+    bmp_stream_t stream = { cb, arg, 0 };
+    bmp_jpg_decoder_t jpeg = {
+        .src = src,
+        .src_len = src_len,
+        .out = &stream,
+    };
+    uint8_t header[BMP_HEADER_LEN];
+    JDEC decoder;
+    JRESULT res;
+    bool ret = false;
+
+    res = jd_prepare(&decoder, bmp_jpg_read, work, sizeof(work), &jpeg);
+    if(res != JDR_OK) {
+        ESP_LOGE(TAG, "JPEG prepare failed! %d", res);
+        return false;
+    }
+
+    // only one MCU row is ever held, padded like the BMP rows so it can be written as is
+    jpeg.width = decoder.width;
+    jpeg.row_size = (decoder.width * 3 + 3) & ~3;
+    jpeg.band = (uint8_t *)_malloc(jpeg.row_size * decoder.msy * 8);
+    if(!jpeg.band) {
+        ESP_LOGE(TAG, "_malloc failed! %u", jpeg.row_size * decoder.msy * 8);
+        return false;
+    }
+    memset(jpeg.band, 0, jpeg.row_size * decoder.msy * 8);
+
+    bmp_header(header, decoder.width, decoder.height, 3, 0, jpeg.row_size * decoder.height);
+    if(!bmp_write(&stream, header, BMP_HEADER_LEN)) {
+        goto fail;
+    }
+    res = jd_decomp(&decoder, bmp_jpg_write, 0);
+    if(res != JDR_OK) {
+        ESP_LOGE(TAG, "JPEG decode failed! %d", res);
+        goto fail;
+    }
+    ret = true;
+
+fail:
+    free(jpeg.band);
+    return ret;
+}
+
+bool fmt2bmp_cb(uint8_t *src, size_t src_len, uint16_t width, uint16_t height, pixformat_t format, jpg_out_cb cb, void * arg)
+{
+    if(format == PIXFORMAT_JPEG) {
+        return jpg2bmp_cb(src, src_len, cb, arg);
+    }
+
+    bmp_stream_t stream = { cb, arg, 0 };
+    uint8_t header[BMP_HEADER_LEN];
+    int bpp = (format == PIXFORMAT_GRAYSCALE) ? 1 : 3;
+    int src_bpp = (format == PIXFORMAT_GRAYSCALE) ? 1 : (format == PIXFORMAT_RGB888) ? 3 : 2;
+    int palette_size = (format == PIXFORMAT_GRAYSCALE) ? 4 * 256 : 0;
+    size_t src_row = width * src_bpp;
+    size_t row_len = width * bpp;
+    size_t row_size = (row_len + 3) & ~3;
+    size_t rows = BMP_STREAM_ROWS;
+    uint8_t * row_buf = NULL;
+    bool ret = false;
+    int y;
+
+    if(src_len < src_row * height) {
+        ESP_LOGE(TAG, "Source too short! %u < %u", src_len, src_row * height);
+        return false;
+    }
+
+    bmp_header(header, width, height, bpp, palette_size, row_size * height);
+    if(!bmp_write(&stream, header, BMP_HEADER_LEN)) {
+        return false;
+    }
+
+    if (palette_size > 0) {
+        // Grayscale palette, a quarter at a time
+        uint8_t palette[256];
+        for (int i = 0; i < 256; i += 64) {
+            for (int j = 0; j < 64; ++j) {
+                palette[j * 4] = i + j;
+                palette[j * 4 + 1] = i + j;
+                palette[j * 4 + 2] = i + j;
+                palette[j * 4 + 3] = 0;
+            }
+            if(!bmp_write(&stream, palette, sizeof(palette))) {
+                return false;
+            }
+        }
+    }
+
+    // Rows that are already BMP pixels without padding go out straight from the frame
+    if(row_size == row_len && (format == PIXFORMAT_RGB888 || format == PIXFORMAT_GRAYSCALE)) {
+        return bmp_write(&stream, src, row_len * height);
+    }
+
+    if(rows > height) {
+        rows = height;
+    }
+    row_buf = (uint8_t *)_malloc(row_size * rows);
+    if(!row_buf) {
+        ESP_LOGE(TAG, "_malloc failed! %u", row_size * rows);
+        return false;
+    }
+    memset(row_buf, 0, row_size * rows);
+
+    for(y=0; y<height; y+=rows) {
+        size_t i, n = (height - y < rows) ? height - y : rows;
+        for(i=0; i<n; i++) {
+            bmp_pixels(src + (y + i) * src_row, row_buf + i * row_size, width, format);
+        }
+        if(!bmp_write(&stream, row_buf, row_size * n)) {
+            goto fail;
+        }
+    }
+    ret = true;
+
+fail:
+    free(row_buf);
+    return ret;
+}
+
+bool frame2bmp_cb(camera_fb_t * fb, jpg_out_cb cb, void * arg)
+{
+    return fmt2bmp_cb(fb->buf, fb->len, fb->width, fb->height, fb->format, cb, arg);
+}
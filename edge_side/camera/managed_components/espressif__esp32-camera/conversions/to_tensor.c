@@ -0,0 +1,310 @@
+// Copyright 2015-2025 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include "img_converters.h"
+#include "esp_heap_caps.h"
+#include "yuv.h"
+#include "sdkconfig.h"
+#include "jpeg_decoder.h"
+
+#if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
+#include "esp32-hal-log.h"
+#define TAG ""
+#else
+#include "esp_log.h"
+static const char* TAG = "to_tensor";
+#endif
+
+static void *_malloc(size_t size)
+{
+    void * res = malloc(size);
+    if(res) {
+        return res;
+    }
+
+    // check if SPIRAM is enabled and is allocatable
+#if ((CONFIG_SPIRAM || CONFIG_SPIRAM_SUPPORT) && (CONFIG_SPIRAM_USE_CAPS_ALLOC || CONFIG_SPIRAM_USE_MALLOC))
+    return heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+#endif
+    return NULL;
+}
+
+// Source pixel layouts fmt2tensor() can sample from. RGB888 frames are
+// stored B, G, R like the output of fmt2rgb888(); the JPEG decoder emits R, G, B.
+typedef enum {
+    SAMPLE_RGB565,
+    SAMPLE_YUV422,
+    SAMPLE_GRAY,
+    SAMPLE_BGR888,
+    SAMPLE_RGB888,
+} sample_format_t;
+
+// Fetch the pixels at xmap[0..count) of one source row into planar r, g, b
+static void sample_row(const uint8_t *row, sample_format_t format, const uint16_t *xmap, size_t count, uint8_t *r, uint8_t *g, uint8_t *b)
+{
+    size_t i;
+    const uint8_t *p;
+    switch(format) {
+    case SAMPLE_RGB565:
+        for(i=0; i<count; i++) {
+            p = row + xmap[i] * 2;
+            r[i] = p[0] & 0xF8;
+            g[i] = (p[0] & 0x07) << 5 | (p[1] & 0xE0) >> 3;
+            b[i] = (p[1] & 0x1F) << 3;
+        }
+        break;
+    case SAMPLE_YUV422:
+        for(i=0; i<count; i++) {
+            p = row + (xmap[i] & ~1) * 2;
+            yuv2rgb(row[xmap[i] * 2], p[1], p[3], &r[i], &g[i], &b[i]);
+        }
+        break;
+    case SAMPLE_GRAY:
+        for(i=0; i<count; i++) {
+            r[i] = g[i] = b[i] = row[xmap[i]];
+        }
+        break;
+    case SAMPLE_BGR888:
+        for(i=0; i<count; i++) {
+            p = row + xmap[i] * 3;
+            b[i] = p[0];
+            g[i] = p[1];
+            r[i] = p[2];
+        }
+        break;
+    case SAMPLE_RGB888:
+        for(i=0; i<count; i++) {
+            p = row + xmap[i] * 3;
+            r[i] = p[0];
+            g[i] = p[1];
+            b[i] = p[2];
+        }
+        break;
+    }
+}
+
+static void fill_f32(float *dst, size_t count, float value)
+{
+    while(count--) {
+        *dst++ = value;
+    }
+}
+
+static void fill_i8(int8_t *dst, size_t count, int8_t value)
+{
+    memset(dst, (uint8_t)value, count);
+}
+
+static void lut_row_f32(float *dst, const uint8_t *src, size_t count, const float *lut)
+{
+    for(size_t i=0; i<count; i++) {
+        dst[i] = lut[src[i]];
+    }
+}
+
+static void lut_row_i8(int8_t *dst, const uint8_t *src, size_t count, const int8_t *lut)
+{
+    for(size_t i=0; i<count; i++) {
+        dst[i] = lut[src[i]];
+    }
+}
+
+void tensor_letterbox(uint16_t src_width, uint16_t src_height, uint16_t dst_width, uint16_t dst_height, tensor_letterbox_t *letterbox)
+{
+    resize_rect_t rect;
+    img_letterbox_rect(src_width, src_height, dst_width, dst_height, &rect);
+    letterbox->width = rect.width;
+    letterbox->height = rect.height;
+    letterbox->left = rect.left;
+    letterbox->top = rect.top;
+    letterbox->scale = (float)rect.width / src_width;
+}
+
+static esp_jpeg_image_scale_t jpg_scale_for(float scale)
+{
+    // largest decoder downscale that still leaves at least one source pixel per tensor pixel
+    if(scale * 8 <= 1.0f) {
+        return JPEG_IMAGE_SCALE_1_8;
+    } else if(scale * 4 <= 1.0f) {
+        return JPEG_IMAGE_SCALE_1_4;
+    } else if(scale * 2 <= 1.0f) {
+        return JPEG_IMAGE_SCALE_1_2;
+    }
+    return JPEG_IMAGE_SCALE_0;
+}
+
+bool fmt2tensor(const uint8_t *src, size_t src_len, uint16_t width, uint16_t height, pixformat_t format, const tensor_config_t *config, void *out, tensor_letterbox_t *letterbox)
+{
+    tensor_letterbox_t lb;
+    sample_format_t sample;
+    size_t bpp;
+    uint16_t src_w = width, src_h = height;
+    uint8_t *decoded = NULL;
+    uint8_t *work = NULL;
+    bool ret = false;
+
+    if(!src || !config || !out || !config->width || !config->height) {
+        return false;
+    }
+    for(int c=0; c<3; c++) {
+        if(config->std[c] == 0.0f) {
+            ESP_LOGE(TAG, "std[%d] must not be zero", c);
+            return false;
+        }
+    }
+    if(config->type == TENSOR_INT8 && !(config->scale > 0.0f)) {
+        ESP_LOGE(TAG, "int8 tensors need a positive quantization scale");
+        return false;
+    }
+
+    if(format == PIXFORMAT_JPEG) {
+        esp_jpeg_image_cfg_t jpeg_cfg = {
+            .indata = (uint8_t *)src,
+            .indata_size = src_len,
+            .out_format = JPEG_IMAGE_FORMAT_RGB888,
+            .out_scale = JPEG_IMAGE_SCALE_0,
+            .flags.swap_color_bytes = 0,
+        };
+        esp_jpeg_image_output_t output_img = {};
+        if(esp_jpeg_get_image_info(&jpeg_cfg, &output_img) != ESP_OK || !output_img.width || !output_img.height) {
+            ESP_LOGE(TAG, "Failed to get image info");
+            return false;
+        }
+        width = output_img.width;
+        height = output_img.height;
+        tensor_letterbox(width, height, config->width, config->height, &lb);
+
+        // Let the decoder do the coarse part of the downscale
+        jpeg_cfg.out_scale = jpg_scale_for(lb.scale);
+        if(esp_jpeg_get_image_info(&jpeg_cfg, &output_img) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to get image info");
+            return false;
+        }
+        decoded = (uint8_t *)_malloc(output_img.output_len);
+        if(!decoded) {
+            ESP_LOGE(TAG, "_malloc failed! %u", output_img.output_len);
+            return false;
+        }
+        jpeg_cfg.outbuf = decoded;
+        jpeg_cfg.outbuf_size = output_img.output_len;
+        if(esp_jpeg_decode(&jpeg_cfg, &output_img) != ESP_OK) {
+            ESP_LOGE(TAG, "JPEG decode failed");
+            goto fail;
+        }
+        src = decoded;
+        src_w = output_img.width;
+        src_h = output_img.height;
+        sample = SAMPLE_RGB888;
+        bpp = 3;
+    } else {
+        switch(format) {
+        case PIXFORMAT_RGB565: sample = SAMPLE_RGB565; bpp = 2; break;
+        case PIXFORMAT_YUV422: sample = SAMPLE_YUV422; bpp = 2; break;
+        case PIXFORMAT_GRAYSCALE: sample = SAMPLE_GRAY; bpp = 1; break;
+        case PIXFORMAT_RGB888: sample = SAMPLE_BGR888; bpp = 3; break;
+        default:
+            ESP_LOGE(TAG, "Unsupported format %d", format);
+            return false;
+        }
+        if(!width || !height || src_len < (size_t)width * height * bpp) {
+            ESP_LOGE(TAG, "Source buffer too small for %ux%u", width, height);
+            return false;
+        }
+        tensor_letterbox(width, height, config->width, config->height, &lb);
+    }
+
+    // xmap, three planar rows and the per channel lookup table in one block
+    size_t lut_size = (config->type == TENSOR_FLOAT32) ? 3 * 256 * sizeof(float) : 3 * 256;
+    work = (uint8_t *)_malloc(lut_size + lb.width * (sizeof(uint16_t) + 3));
+    if(!work) {
+        ESP_LOGE(TAG, "_malloc failed! %u", lut_size + lb.width * (sizeof(uint16_t) + 3));
+        goto fail;
+    }
+    uint16_t *xmap = (uint16_t *)(work + lut_size);
+    uint8_t *r = (uint8_t *)(xmap + lb.width);
+    uint8_t *g = r + lb.width;
+    uint8_t *b = g + lb.width;
+
+    for(int c=0; c<3; c++) {
+        for(int v=0; v<256; v++) {
+            float f = (v - config->mean[c]) / config->std[c];
+            if(config->type == TENSOR_FLOAT32) {
+                ((float *)work)[c * 256 + v] = f;
+            } else {
+                long q = lrintf(f / config->scale) + config->zero_point;
+                ((int8_t *)work)[c * 256 + v] = q < -128 ? -128 : (q > 127 ? 127 : q);
+            }
+        }
+    }
+    // sample pixel centres: source x for tensor column i is (i + 0.5) * src_w / lb.width
+    for(size_t i=0; i<lb.width; i++) {
+        xmap[i] = ((2 * i + 1) * src_w) / (2 * lb.width);
+    }
+
+    size_t plane = (size_t)config->width * config->height;
+    size_t right = config->width - lb.left - lb.width;
+    size_t bottom = config->height - lb.top - lb.height;
+    uint8_t *rgb[3] = {r, g, b};
+    for(size_t y=0; y<lb.height; y++) {
+        size_t sy = ((2 * y + 1) * src_h) / (2 * lb.height);
+        sample_row(src + sy * src_w * bpp, sample, xmap, lb.width, r, g, b);
+        size_t o = (lb.top + y) * config->width;
+        for(int c=0; c<3; c++) {
+            if(config->type == TENSOR_FLOAT32) {
+                float *dst = (float *)out + c * plane + o;
+                const float *lut = (const float *)work + c * 256;
+                fill_f32(dst, lb.left, lut[config->pad]);
+                lut_row_f32(dst + lb.left, rgb[c], lb.width, lut);
+                fill_f32(dst + lb.left + lb.width, right, lut[config->pad]);
+            } else {
+                int8_t *dst = (int8_t *)out + c * plane + o;
+                const int8_t *lut = (const int8_t *)work + c * 256;
+                fill_i8(dst, lb.left, lut[config->pad]);
+                lut_row_i8(dst + lb.left, rgb[c], lb.width, lut);
+                fill_i8(dst + lb.left + lb.width, right, lut[config->pad]);
+            }
+        }
+    }
+    for(int c=0; c<3; c++) {
+        if(config->type == TENSOR_FLOAT32) {
+            float *dst = (float *)out + c * plane;
+            float pad = ((const float *)work)[c * 256 + config->pad];
+            fill_f32(dst, lb.top * config->width, pad);
+            fill_f32(dst + (lb.top + lb.height) * config->width, bottom * config->width, pad);
+        } else {
+            int8_t *dst = (int8_t *)out + c * plane;
+            int8_t pad = ((const int8_t *)work)[c * 256 + config->pad];
+            fill_i8(dst, lb.top * config->width, pad);
+            fill_i8(dst + (lb.top + lb.height) * config->width, bottom * config->width, pad);
+        }
+    }
+
+    if(letterbox) {
+        *letterbox = lb;
+    }
+    ret = true;
+
+fail:
+    free(work);
+    free(decoded);
+    return ret;
+}
+
+bool frame2tensor(camera_fb_t * fb, const tensor_config_t *config, void *out, tensor_letterbox_t *letterbox)
+{
+    return fmt2tensor(fb->buf, fb->len, fb->width, fb->height, fb->format, config, out, letterbox);
+}
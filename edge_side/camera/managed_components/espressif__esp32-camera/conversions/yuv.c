@@ -11,9 +11,14 @@
 // WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 // See the License for the specific language governing permissions and
 // limitations under the License.
+#include <string.h>
 #include "yuv.h"
 #include "esp_attr.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 typedef struct {
         int16_t vY;
         int16_t vVr;
@@ -296,3 +301,159 @@ void IRAM_ATTR yuv2rgb(uint8_t y, uint8_t u, uint8_t v, uint8_t *r, uint8_t *g,
     *g = YUYV_CONSTRAIN(gi);
     *b = YUYV_CONSTRAIN(bi);
 }
+
+// Whole-run converters. YUYV pixels come in pairs sharing one U and one V
+// sample, so the chroma terms are looked up once per pair instead of once
+// per pixel. An odd trailing pixel has no V sample and is left unconverted.
+
+#if defined(__SSE2__)
+// Every column of yuv_table is trunc(x * c / 65536) for x = (i - 16) << k
+// (Y) or x = (i - 128) << k (chroma), so mulhi plus a round-toward-zero fixup
+// reproduces yuv2rgb() bit for bit, eight pixels at a time.
+#define YUV_TERM_POS(x, c) _mm_sub_epi16(_mm_mulhi_epi16((x), _mm_set1_epi16(c)), _mm_cmplt_epi16((x), zero))
+#define YUV_TERM_NEG(x, c) _mm_sub_epi16(_mm_mulhi_epi16((x), _mm_set1_epi16(c)), _mm_cmpgt_epi16((x), zero))
+
+static inline void yuv422_decode8(const uint8_t *src, __m128i *r, __m128i *g, __m128i *b)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lo = _mm_set1_epi32(0x0000FFFF);
+    __m128i w = _mm_loadu_si128((const __m128i *)src);
+    __m128i y = _mm_sub_epi16(_mm_and_si128(w, _mm_set1_epi16(0x00FF)), _mm_set1_epi16(16));
+    __m128i uv = _mm_sub_epi16(_mm_srli_epi16(w, 8), _mm_set1_epi16(128));
+    __m128i u = _mm_or_si128(_mm_and_si128(uv, lo), _mm_slli_epi32(uv, 16));
+    __m128i v = _mm_or_si128(_mm_srli_epi32(uv, 16), _mm_andnot_si128(lo, uv));
+
+    __m128i ty = YUV_TERM_POS(_mm_slli_epi16(y, 2), 19070);
+    __m128i ri = _mm_add_epi16(ty, YUV_TERM_POS(_mm_slli_epi16(v, 2), 26149));
+    __m128i gi = _mm_add_epi16(ty, _mm_add_epi16(YUV_TERM_NEG(_mm_slli_epi16(u, 1), -26640), YUV_TERM_NEG(v, -25644)));
+    __m128i bi = _mm_add_epi16(ty, YUV_TERM_POS(_mm_slli_epi16(u, 3), 16531));
+
+    *r = _mm_min_epi16(_mm_max_epi16(ri, zero), _mm_set1_epi16(255));
+    *g = _mm_min_epi16(_mm_max_epi16(gi, zero), _mm_set1_epi16(255));
+    *b = _mm_min_epi16(_mm_max_epi16(bi, zero), _mm_set1_epi16(255));
+}
+
+#undef YUV_TERM_POS
+#undef YUV_TERM_NEG
+#endif
+
+static IRAM_ATTR void yuv422_to_rgb24(const uint8_t *src, uint8_t *dst, size_t pixels, int ri, int bi)
+{
+    size_t i = 0, pairs = pixels / 2;
+#if defined(__SSE2__)
+    // Each pixel goes out as one 4-byte store of R G B x, the x byte being
+    // overwritten by the next pixel, so stop while at least one pair remains.
+    for (; i + 4 < pairs; i += 4) {
+        __m128i r, g, b, c0, c2;
+        uint32_t px[8];
+        yuv422_decode8(src, &r, &g, &b);
+        c0 = ri ? b : r;
+        c2 = ri ? r : b;
+        c0 = _mm_or_si128(c0, _mm_slli_epi16(g, 8));
+        _mm_storeu_si128((__m128i *)px, _mm_unpacklo_epi16(c0, c2));
+        _mm_storeu_si128((__m128i *)(px + 4), _mm_unpackhi_epi16(c0, c2));
+        for (int j = 0; j < 8; j++) {
+            memcpy(dst + 3 * j, &px[j], 4);
+        }
+        src += 16;
+        dst += 24;
+    }
+#endif
+    for (; i < pairs; i++) {
+        int16_t y0 = yuv_table[src[0]].vY;
+        int16_t y1 = yuv_table[src[2]].vY;
+        int16_t vr = yuv_table[src[3]].vVr;
+        int16_t uvg = yuv_table[src[1]].vUg + yuv_table[src[3]].vVg;
+        int16_t ub = yuv_table[src[1]].vUb;
+        int16_t c;
+
+        c = y0 + vr;  dst[ri] = YUYV_CONSTRAIN(c);
+        c = y0 + uvg; dst[1] = YUYV_CONSTRAIN(c);
+        c = y0 + ub;  dst[bi] = YUYV_CONSTRAIN(c);
+        c = y1 + vr;  dst[3 + ri] = YUYV_CONSTRAIN(c);
+        c = y1 + uvg; dst[4] = YUYV_CONSTRAIN(c);
+        c = y1 + ub;  dst[3 + bi] = YUYV_CONSTRAIN(c);
+        src += 4;
+        dst += 6;
+    }
+}
+
+void IRAM_ATTR yuv422_to_rgb888(const uint8_t *src, uint8_t *dst, size_t pixels)
+{
+    yuv422_to_rgb24(src, dst, pixels, 0, 2);
+}
+
+void IRAM_ATTR yuv422_to_bgr888(const uint8_t *src, uint8_t *dst, size_t pixels)
+{
+    yuv422_to_rgb24(src, dst, pixels, 2, 0);
+}
+
+void IRAM_ATTR yuv422_to_rgb565(const uint8_t *src, uint8_t *dst, size_t pixels)
+{
+    size_t i = 0, pairs = pixels / 2;
+#if defined(__SSE2__)
+    for (; i + 4 <= pairs; i += 4) {
+        __m128i r, g, b;
+        yuv422_decode8(src, &r, &g, &b);
+        // big endian RGB565, as the sensors deliver it: hb first in memory
+        __m128i hb = _mm_or_si128(_mm_and_si128(r, _mm_set1_epi16(0xF8)), _mm_srli_epi16(g, 5));
+        __m128i lb = _mm_or_si128(_mm_and_si128(_mm_slli_epi16(g, 3), _mm_set1_epi16(0xE0)), _mm_srli_epi16(b, 3));
+        _mm_storeu_si128((__m128i *)dst, _mm_or_si128(hb, _mm_slli_epi16(lb, 8)));
+        src += 16;
+        dst += 16;
+    }
+#endif
+    for (; i < pairs; i++) {
+        int16_t y0 = yuv_table[src[0]].vY;
+        int16_t y1 = yuv_table[src[2]].vY;
+        int16_t vr = yuv_table[src[3]].vVr;
+        int16_t uvg = yuv_table[src[1]].vUg + yuv_table[src[3]].vVg;
+        int16_t ub = yuv_table[src[1]].vUb;
+        uint8_t r, g, b;
+        int16_t c;
+
+        c = y0 + vr;  r = YUYV_CONSTRAIN(c);
+        c = y0 + uvg; g = YUYV_CONSTRAIN(c);
+        c = y0 + ub;  b = YUYV_CONSTRAIN(c);
+        dst[0] = (r & 0xF8) | (g >> 5);
+        dst[1] = ((g << 3) & 0xE0) | (b >> 3);
+        c = y1 + vr;  r = YUYV_CONSTRAIN(c);
+        c = y1 + uvg; g = YUYV_CONSTRAIN(c);
+        c = y1 + ub;  b = YUYV_CONSTRAIN(c);
+        dst[2] = (r & 0xF8) | (g >> 5);
+        dst[3] = ((g << 3) & 0xE0) | (b >> 3);
+        src += 4;
+        dst += 4;
+    }
+}
+
+void IRAM_ATTR yuv422_to_gray(const uint8_t *src, uint8_t *dst, size_t pixels)
+{
+    size_t i = 0;
+    pixels &= ~(size_t)1;
+#if defined(__SSE2__)
+    for (; i + 16 <= pixels; i += 16) {
+        __m128i mask = _mm_set1_epi16(0x00FF);
+        __m128i w0 = _mm_and_si128(_mm_loadu_si128((const __m128i *)src), mask);
+        __m128i w1 = _mm_and_si128(_mm_loadu_si128((const __m128i *)(src + 16)), mask);
+        _mm_storeu_si128((__m128i *)dst, _mm_packus_epi16(w0, w1));
+        src += 32;
+        dst += 16;
+    }
+#elif defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    // SWAR: two YUYV words hold four luma bytes at bits 0, 16, 32 and 48
+    for (; i + 4 <= pixels; i += 4) {
+        uint32_t w0, w1, out;
+        memcpy(&w0, src, 4);
+        memcpy(&w1, src + 4, 4);
+        out = (w0 & 0xFF) | ((w0 >> 8) & 0xFF00) | ((w1 & 0xFF) << 16) | ((w1 << 8) & 0xFF000000);
+        memcpy(dst, &out, 4);
+        src += 8;
+        dst += 4;
+    }
+#endif
+    for (; i < pixels; i++) {
+        *dst++ = *src;
+        src += 2;
+    }
+}
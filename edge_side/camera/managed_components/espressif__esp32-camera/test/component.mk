@@ -3,6 +3,6 @@
 #
 
 COMPONENT_SRCDIRS += ./
-COMPONENT_PRIV_INCLUDEDIRS += ./
+COMPONENT_PRIV_INCLUDEDIRS += ./ ../conversions/private_include
 
 COMPONENT_ADD_LDFLAGS = -Wl,--whole-archive -l$(COMPONENT_NAME) -Wl,--no-whole-archive
@@ -10,6 +10,7 @@
 #include "esp_timer.h"
 
 #include "esp_camera.h"
+#include "yuv.h"
 
 #ifdef CONFIG_IDF_TARGET_ESP32
 #define BOARD_WROVER_KIT 1
@@ -527,6 +528,314 @@ TEST_CASE("Conversions image 480x320 jpeg decode test", "[camera]")
     img_jpeg_decode_test(2, 0);
 }
 
+typedef void (*yuv422_line_func_t)(const uint8_t *src, uint8_t *dst, size_t pixels);
+
+static void yuv2rgb888_per_pixel(const uint8_t *src, uint8_t *dst, size_t pixels)
+{
+    for (size_t i = 0; i < pixels; i += 2, src += 4, dst += 6) {
+        yuv2rgb(src[0], src[1], src[3], &dst[0], &dst[1], &dst[2]);
+        yuv2rgb(src[2], src[1], src[3], &dst[3], &dst[4], &dst[5]);
+    }
+}
+
+static float yuv422_line_test(const char *name, yuv422_line_func_t convert, const uint8_t *yuv, uint8_t *out, uint32_t img_w, uint32_t img_h, size_t out_bpp, uint32_t times)
+{
+    uint64_t t_total = esp_timer_get_time();
+    for (size_t i = 0; i < times; i++) {
+        for (size_t line = 0; line < img_h; line++) {
+            convert(yuv + line * img_w * 2, out + line * img_w * out_bpp, img_w);
+        }
+    }
+    t_total = esp_timer_get_time() - t_total;
+
+    float mpix = (float)img_w * img_h * times / t_total;
+    printf("%-10s , %4d x %4d , %6.2f Mpixel/s\n", name, img_w, img_h, mpix);
+    return mpix;
+}
+
+TEST_CASE("Conversions YUV422 line converters test", "[camera]")
+{
+    const uint32_t img_w = 320, img_h = 240;
+    uint8_t *yuv = heap_caps_malloc(img_w * img_h * 2, MALLOC_CAP_8BIT);
+    uint8_t *ref = heap_caps_malloc(img_w * img_h * 3, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    uint8_t *out = heap_caps_malloc(img_w * img_h * 3, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    TEST_ASSERT_NOT_NULL(yuv);
+    TEST_ASSERT_NOT_NULL(ref);
+    TEST_ASSERT_NOT_NULL(out);
+
+    // sweep every Y against every U/V pair across the frame
+    for (size_t i = 0; i < img_w * img_h; i += 2) {
+        yuv[i * 2] = i;
+        yuv[i * 2 + 1] = i >> 8;
+        yuv[i * 2 + 2] = ~i;
+        yuv[i * 2 + 3] = (i >> 8) * 7;
+    }
+    yuv2rgb888_per_pixel(yuv, ref, img_w * img_h);
+
+    yuv422_to_rgb888(yuv, out, img_w * img_h);
+    for (size_t i = 0; i < img_w * img_h * 3; i++) {
+        TEST_ASSERT_INT_WITHIN(1, ref[i], out[i]);
+    }
+    yuv422_to_bgr888(yuv, out, img_w * img_h);
+    for (size_t i = 0; i < img_w * img_h * 3; i += 3) {
+        TEST_ASSERT_INT_WITHIN(1, ref[i + 2], out[i]);
+        TEST_ASSERT_INT_WITHIN(1, ref[i], out[i + 2]);
+    }
+    yuv422_to_rgb565(yuv, out, img_w * img_h);
+    for (size_t i = 0; i < img_w * img_h; i++) {
+        TEST_ASSERT_INT_WITHIN(1, ref[i * 3] >> 3, out[i * 2] >> 3);
+        TEST_ASSERT_INT_WITHIN(1, ref[i * 3 + 2] >> 3, out[i * 2 + 1] & 0x1F);
+    }
+    yuv422_to_gray(yuv, out, img_w * img_h);
+    for (size_t i = 0; i < img_w * img_h; i++) {
+        TEST_ASSERT_EQUAL_UINT8(yuv[i * 2], out[i]);
+    }
+
+    printf("converter  , resolution  , throughput\n");
+    float base = yuv422_line_test("yuv2rgb", yuv2rgb888_per_pixel, yuv, out, img_w, img_h, 3, 16);
+    float rgb888 = yuv422_line_test("RGB888", yuv422_to_rgb888, yuv, out, img_w, img_h, 3, 16);
+    yuv422_line_test("BGR888", yuv422_to_bgr888, yuv, out, img_w, img_h, 3, 16);
+    yuv422_line_test("RGB565", yuv422_to_rgb565, yuv, out, img_w, img_h, 2, 16);
+    yuv422_line_test("GRAY8", yuv422_to_gray, yuv, out, img_w, img_h, 1, 16);
+    TEST_ASSERT_GREATER_THAN(base, rgb888);
+
+    heap_caps_free(yuv);
+    heap_caps_free(ref);
+    heap_caps_free(out);
+}
+
+static float tensor_convert_test(const char *name, const uint8_t *src, size_t src_len, uint16_t img_w, uint16_t img_h, pixformat_t format, const tensor_config_t *config, void *tensor, uint32_t times)
+{
+    uint64_t t_total = esp_timer_get_time();
+    for (size_t i = 0; i < times; i++) {
+        TEST_ASSERT_TRUE(fmt2tensor(src, src_len, img_w, img_h, format, config, tensor, NULL));
+    }
+    t_total = esp_timer_get_time() - t_total;
+
+    float mpix = (float)config->width * config->height * times / t_total;
+    printf("%-9s , %s , %4d x %4d , %6.2f ms , %6.2f Mpixel/s\n", name, config->type == TENSOR_FLOAT32 ? "f32 " : "int8",
+           config->width, config->height, t_total / 1000.0f / times, mpix);
+    return mpix;
+}
+
+TEST_CASE("Conversions fmt2tensor test", "[camera]")
+{
+    extern const uint8_t img2_start[] asm("_binary_test_inside_jpeg_start");
+    extern const uint8_t img2_end[]   asm("_binary_test_inside_jpeg_end");
+    const uint16_t img_w = 320, img_h = 240;
+    tensor_config_t config = TENSOR_CONFIG_DEFAULT(224, 224);
+    tensor_letterbox_t lb;
+
+    uint8_t *frame = heap_caps_malloc(img_w * img_h * 3, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    float *tensor = heap_caps_malloc(3 * config.width * config.height * sizeof(float), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    TEST_ASSERT_NOT_NULL(frame);
+    TEST_ASSERT_NOT_NULL(tensor);
+
+    // a flat gray frame lands centered between two bands of padding
+    memset(frame, 200, img_w * img_h);
+    TEST_ASSERT_TRUE(fmt2tensor(frame, img_w * img_h, img_w, img_h, PIXFORMAT_GRAYSCALE, &config, tensor, &lb));
+    TEST_ASSERT_EQUAL(0, lb.left);
+    TEST_ASSERT_EQUAL(28, lb.top);
+    TEST_ASSERT_EQUAL(224, lb.width);
+    TEST_ASSERT_EQUAL(168, lb.height);
+    for (int c = 0; c < 3; c++) {
+        const float *plane = tensor + c * config.width * config.height;
+        TEST_ASSERT_EQUAL_FLOAT(114 / 255.0f, plane[0]);
+        TEST_ASSERT_EQUAL_FLOAT(200 / 255.0f, plane[lb.top * config.width]);
+        TEST_ASSERT_EQUAL_FLOAT(200 / 255.0f, plane[(lb.top + lb.height) * config.width - 1]);
+        TEST_ASSERT_EQUAL_FLOAT(114 / 255.0f, plane[(lb.top + lb.height) * config.width]);
+    }
+    TEST_ASSERT_FALSE(fmt2tensor(frame, img_w * img_h - 1, img_w, img_h, PIXFORMAT_GRAYSCALE, &config, tensor, NULL));
+
+    for (size_t i = 0; i < img_w * img_h * 3; i++) {
+        frame[i] = (i * 2654435761u) >> 24;
+    }
+    printf("format    , type , tensor      , time     , throughput\n");
+    for (int t = 0; t < 2; t++) {
+        config.type = t ? TENSOR_INT8 : TENSOR_FLOAT32;
+        config.scale = 1 / 255.0f;
+        config.zero_point = -128;
+        tensor_convert_test("RGB565", frame, img_w * img_h * 2, img_w, img_h, PIXFORMAT_RGB565, &config, tensor, 16);
+        tensor_convert_test("YUV422", frame, img_w * img_h * 2, img_w, img_h, PIXFORMAT_YUV422, &config, tensor, 16);
+        tensor_convert_test("GRAYSCALE", frame, img_w * img_h, img_w, img_h, PIXFORMAT_GRAYSCALE, &config, tensor, 16);
+        tensor_convert_test("RGB888", frame, img_w * img_h * 3, img_w, img_h, PIXFORMAT_RGB888, &config, tensor, 16);
+        tensor_convert_test("JPEG", img2_start, img2_end - img2_start, 0, 0, PIXFORMAT_JPEG, &config, tensor, 4);
+    }
+
+    heap_caps_free(frame);
+    heap_caps_free(tensor);
+}
+
+typedef struct {
+    const uint8_t *ref;     // expected output, NULL to only count bytes
+    size_t len;
+    size_t min_free;
+    bool match;
+} bmp_sink_t;
+
+static size_t bmp_sink(void * arg, size_t index, const void* data, size_t len)
+{
+    bmp_sink_t *sink = (bmp_sink_t *)arg;
+    size_t free_size = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    if (free_size < sink->min_free) {
+        sink->min_free = free_size;
+    }
+    if (sink->ref && memcmp(sink->ref + index, data, len)) {
+        sink->match = false;
+    }
+    sink->len += len;
+    return len;
+}
+
+static void bmp_stream_test(const char *name, uint8_t *src, size_t src_len, uint16_t img_w, uint16_t img_h, pixformat_t format, uint32_t times)
+{
+    uint8_t *out = NULL;
+    size_t out_len = 0;
+    size_t free_size = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+
+    // the whole-image converter is the reference when no row padding is needed
+    uint64_t t_buf = esp_timer_get_time();
+    for (size_t i = 0; i < times; i++) {
+        TEST_ASSERT_TRUE(fmt2bmp(src, src_len, img_w, img_h, format, &out, &out_len));
+        free(out);
+    }
+    t_buf = esp_timer_get_time() - t_buf;
+    TEST_ASSERT_TRUE(fmt2bmp(src, src_len, img_w, img_h, format, &out, &out_len));
+
+    bmp_sink_t sink = {out, 0, SIZE_MAX, true};
+    TEST_ASSERT_TRUE(fmt2bmp_cb(src, src_len, img_w, img_h, format, bmp_sink, &sink));
+    TEST_ASSERT_EQUAL(out_len, sink.len);
+    TEST_ASSERT_TRUE(sink.match);
+    free(out);
+
+    sink.ref = NULL;
+    uint64_t t_cb = esp_timer_get_time();
+    for (size_t i = 0; i < times; i++) {
+        sink.len = 0;
+        TEST_ASSERT_TRUE(fmt2bmp_cb(src, src_len, img_w, img_h, format, bmp_sink, &sink));
+    }
+    t_cb = esp_timer_get_time() - t_cb;
+
+    printf("%-9s , %7u B , %7u B , %6.2f ms , %6.2f ms\n", name, (uint32_t)out_len, (uint32_t)(free_size - sink.min_free),
+           t_buf / 1000.0f / times, t_cb / 1000.0f / times);
+}
+
+TEST_CASE("Conversions streaming BMP test", "[camera]")
+{
+    extern const uint8_t img2_start[] asm("_binary_test_inside_jpeg_start");
+    extern const uint8_t img2_end[]   asm("_binary_test_inside_jpeg_end");
+    const uint16_t img_w = 320, img_h = 240;
+
+    uint8_t *frame = heap_caps_malloc(img_w * img_h * 3, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    TEST_ASSERT_NOT_NULL(frame);
+    for (size_t i = 0; i < img_w * img_h * 3; i++) {
+        frame[i] = (i * 2654435761u) >> 24;
+    }
+
+    printf("format    , buffered  , streamed  , buffered , streamed\n");
+    bmp_stream_test("RGB565", frame, img_w * img_h * 2, img_w, img_h, PIXFORMAT_RGB565, 8);
+    bmp_stream_test("YUV422", frame, img_w * img_h * 2, img_w, img_h, PIXFORMAT_YUV422, 8);
+    bmp_stream_test("GRAYSCALE", frame, img_w * img_h, img_w, img_h, PIXFORMAT_GRAYSCALE, 8);
+    bmp_stream_test("RGB888", frame, img_w * img_h * 3, img_w, img_h, PIXFORMAT_RGB888, 8);
+    bmp_stream_test("JPEG", (uint8_t *)img2_start, img2_end - img2_start, 0, 0, PIXFORMAT_JPEG, 4);
+
+    // a frame shorter than its dimensions is rejected before anything is written
+    bmp_sink_t sink = {NULL, 0, SIZE_MAX, true};
+    TEST_ASSERT_FALSE(fmt2bmp_cb(frame, img_w * img_h - 1, img_w, img_h, PIXFORMAT_GRAYSCALE, bmp_sink, &sink));
+    TEST_ASSERT_EQUAL(0, sink.len);
+
+    heap_caps_free(frame);
+}
+
+static const char *resize_filter_names[] ={"nearest", "bilinear", "area", "bicubic"};
+static const char *resize_format_names[] = {"GRAY8", "RGB888", "RGB565"};
+
+static float resize_test(const resize_image_t *src, const resize_image_t *dst, resize_filter_t filter, uint32_t times)
+{
+    img_resizer_t *resizer = img_resizer_create(src->width, src->height, dst->width, dst->height, src->format, filter);
+    TEST_ASSERT_NOT_NULL(resizer);
+
+    uint64_t t_total = esp_timer_get_time();
+    for (size_t i = 0; i < times; i++) {
+        TEST_ASSERT_TRUE(img_resizer_run(resizer, src, dst));
+    }
+    t_total = esp_timer_get_time() - t_total;
+    img_resizer_free(resizer);
+
+    float mpix = (float)dst->width * dst->height * times / t_total;
+    printf("%-6s , %-8s , %4d x %4d , %6.2f ms , %6.2f Mpixel/s\n", resize_format_names[src->format], resize_filter_names[filter],
+           dst->width, dst->height, t_total / 1000.0f / times, mpix);
+    return mpix;
+}
+
+TEST_CASE("Conversions resize test", "[camera]")
+{
+    const uint16_t img_w = 320, img_h = 240;
+    const uint16_t sizes[][2] = {{160, 120}, {224, 168}, {640, 480}};
+    const uint8_t pad[3] = {114, 114, 114};
+    const size_t bpp[] = {1, 3, 2};
+    resize_rect_t rect;
+
+    uint8_t *frame = heap_caps_malloc(img_w * img_h * 3, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    uint8_t *out = heap_caps_malloc(640 * 480 * 3, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    TEST_ASSERT_NOT_NULL(frame);
+    TEST_ASSERT_NOT_NULL(out);
+
+    // flat images stay flat through every filter, and same-size resizes are a copy
+    for (int f = RESIZE_GRAY8; f <= RESIZE_RGB565; f++) {
+        for (int k = RESIZE_NEAREST; k <= RESIZE_BICUBIC; k++) {
+            resize_image_t src = {frame, img_w, img_h, 0, f};
+            resize_image_t dst = {out, 224, 168, 0, f};
+            memset(frame, 0xA5, img_w * img_h * bpp[f]);
+            TEST_ASSERT_TRUE(img_resize(&src, &dst, k));
+            for (size_t i = 0; i < dst.width * dst.height * bpp[f]; i++) {
+                TEST_ASSERT_EQUAL_UINT8(0xA5, out[i]);
+            }
+
+            for (size_t i = 0; i < img_w * img_h * bpp[f]; i++) {
+                frame[i] = (i * 2654435761u) >> 24;
+            }
+            dst.width = img_w;
+            dst.height = img_h;
+            TEST_ASSERT_TRUE(img_resize(&src, &dst, k));
+            TEST_ASSERT_EQUAL_UINT8_ARRAY(frame, out, img_w * img_h * bpp[f]);
+        }
+    }
+
+    // a 4:3 frame letterboxed to a square lands between two bands of padding
+    memset(frame, 200, img_w * img_h);
+    resize_image_t src = {frame, img_w, img_h, 0, RESIZE_GRAY8};
+    resize_image_t dst = {out, 224, 224, 0, RESIZE_GRAY8};
+    TEST_ASSERT_TRUE(img_letterbox(&src, &dst, RESIZE_BILINEAR, pad, &rect));
+    TEST_ASSERT_EQUAL(0, rect.left);
+    TEST_ASSERT_EQUAL(28, rect.top);
+    TEST_ASSERT_EQUAL(224, rect.width);
+    TEST_ASSERT_EQUAL(168, rect.height);
+    TEST_ASSERT_EQUAL_UINT8(114, out[rect.top * 224 - 1]);
+    TEST_ASSERT_EQUAL_UINT8(200, out[rect.top * 224]);
+    TEST_ASSERT_EQUAL_UINT8(200, out[(rect.top + rect.height) * 224 - 1]);
+    TEST_ASSERT_EQUAL_UINT8(114, out[(rect.top + rect.height) * 224]);
+    dst.format = RESIZE_RGB888;
+    TEST_ASSERT_FALSE(img_letterbox(&src, &dst, RESIZE_BILINEAR, pad, NULL));
+
+    for (size_t i = 0; i < img_w * img_h * 3; i++) {
+        frame[i] = (i * 2654435761u) >> 24;
+    }
+    printf("format , filter   , output      , time     , throughput\n");
+    for (int f = RESIZE_GRAY8; f <= RESIZE_RGB565; f++) {
+        for (int k = RESIZE_NEAREST; k <= RESIZE_BICUBIC; k++) {
+            for (int s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+                resize_image_t src = {frame, img_w, img_h, 0, f};
+                resize_image_t dst = {out, sizes[s][0], sizes[s][1], 0, f};
+                resize_test(&src, &dst, k, 4);
+            }
+        }
+    }
+
+    heap_caps_free(frame);
+    heap_caps_free(out);
+}
+
 TEST_CASE("Camera driver uses an i2c port initialized by other devices test", "[camera]")
 {
     TEST_ESP_OK(i2c_master_init(I2C_MASTER_NUM));
@@ -0,0 +1,14 @@
+// Host stand-in for the ESP-IDF heap API used by the esp32-camera conversions
+// code (jpge.cpp): capability allocations are plain malloc.
+#pragma once
+
+#include <stdlib.h>
+
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_8BIT (1 << 2)
+
+static inline void *heap_caps_malloc(size_t size, unsigned caps)
+{
+    (void)caps;
+    return malloc(size);
+}
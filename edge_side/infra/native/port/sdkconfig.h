@@ -0,0 +1,9 @@
+// Host build settings for the esp_jpeg copy of tjpgd, matching the Kconfig
+// defaults the cameras are built with plus the fast Huffman decoder.
+#pragma once
+
+#define CONFIG_JD_SZBUF 512
+#define CONFIG_JD_FORMAT 0
+#define CONFIG_JD_USE_SCALE 1
+#define CONFIG_JD_TBLCLIP 1
+#define CONFIG_JD_FASTDECODE 2
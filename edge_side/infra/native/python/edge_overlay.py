@@ -0,0 +1,122 @@
+"""
+Python binding for the native overlay renderer, JPEG encoder and JPEG
+patcher (src/overlay.h, src/frame_encoder.h, src/jpeg_patch.h).
+
+Replaces results[0].plot() followed by cv2.imencode() when sending annotated
+frames to the backend:
+
+    from edge_overlay import annotate_jpeg
+    jpeg = annotate_jpeg(frame, boxes, count=len(boxes), quality=85)
+    frame_base64 = base64.b64encode(jpeg).decode("utf-8")
+
+frame is drawn on in place. When the camera's JPEG is still at hand,
+patch_jpeg(jpeg, boxes, count=len(boxes)) draws into it directly and only
+re-encodes the MCUs under the overlay. Loads libedge_overlay.so from $EDGE_OVERLAY_LIB
+or the native build directory.
+"""
+
+import ctypes
+import os
+
+from edge_post import Detection
+
+_HERE = os.path.dirname(os.path.abspath(__file__))
+
+
+def _load():
+    path = os.environ.get("EDGE_OVERLAY_LIB") or os.path.join(_HERE, "..", "build", "libedge_overlay.so")
+    lib = ctypes.CDLL(path)
+    lib.edge_draw_overlay.restype = None
+    lib.edge_draw_overlay.argtypes = [
+        ctypes.c_void_p, ctypes.c_int, ctypes.c_int,  # bgr, width, height
+        ctypes.POINTER(Detection), ctypes.c_int, ctypes.c_int,  # detections, n, count
+    ]
+    lib.edge_encode_jpeg.restype = ctypes.c_int
+    lib.edge_encode_jpeg.argtypes = [
+        ctypes.c_void_p, ctypes.c_int, ctypes.c_int, ctypes.c_int,  # bgr, width, height, quality
+        ctypes.c_void_p, ctypes.c_int,  # out, capacity
+    ]
+    lib.edge_patch_jpeg.restype = ctypes.c_int
+    lib.edge_patch_jpeg.argtypes = [
+        ctypes.c_char_p, ctypes.c_int,  # jpeg, len
+        ctypes.POINTER(Detection), ctypes.c_int, ctypes.c_int,  # detections, n, count
+        ctypes.c_void_p, ctypes.c_int,  # out, capacity
+    ]
+    return lib
+
+
+_lib = None
+
+
+def _frame(image, size):
+    shape = getattr(image, "shape", None)
+    if size is None:
+        if shape is None or len(shape) != 3 or shape[2] != 3:
+            raise ValueError("pass size=(w, h) for a buffer without an (h, w, 3) shape")
+        size = (shape[1], shape[0])
+    view = memoryview(image).cast("B")
+    if view.readonly:
+        raise ValueError("the frame is drawn on in place and must be writable")
+    if view.nbytes != size[0] * size[1] * 3:
+        raise ValueError("frame is not width x height BGR bytes")
+    return (ctypes.c_char * view.nbytes).from_buffer(view), size
+
+
+def draw(image, detections, count=None, size=None):
+    """
+    Draws (x1, y1, x2, y2, score, class_id) boxes with their tags, and
+    "people: count" unless count is None, into a C-contiguous BGR frame: an
+    (h, w, 3) uint8 numpy array, or any writable buffer with size=(w, h).
+    """
+    global _lib
+    if _lib is None:
+        _lib = _load()
+    buf, (width, height) = _frame(image, size)
+    boxes = (Detection * max(len(detections), 1))(*[Detection(*d) for d in detections])
+    _lib.edge_draw_overlay(ctypes.addressof(buf), width, height, boxes, len(detections),
+                           -1 if count is None else int(count))
+
+
+def encode_jpeg(image, quality=85, size=None):
+    """Encodes a BGR frame like cv2.imencode('.jpg', ...) and returns the bytes."""
+    global _lib
+    if _lib is None:
+        _lib = _load()
+    buf, (width, height) = _frame(image, size)
+    out = ctypes.create_string_buffer(width * height // 2 + 4096)
+    n = _lib.edge_encode_jpeg(ctypes.addressof(buf), width, height, quality, out, len(out))
+    if n < 0:
+        out = ctypes.create_string_buffer(-n)
+        n = _lib.edge_encode_jpeg(ctypes.addressof(buf), width, height, quality, out, len(out))
+    if n <= 0:
+        raise ValueError("cannot encode the frame")
+    return out.raw[:n]
+
+
+def annotate_jpeg(image, detections, count=None, quality=85, size=None):
+    """draw() then encode_jpeg()."""
+    draw(image, detections, count, size)
+    return encode_jpeg(image, quality, size)
+
+
+def patch_jpeg(jpeg, detections, count=None):
+    """
+    Returns the JPEG bytes with the overlay of draw() drawn in, decoding and
+    re-encoding only the MCUs it touches. Returns None for streams the
+    patcher does not handle (progressive, 12-bit, ...); decode, draw() and
+    encode_jpeg() those instead.
+    """
+    global _lib
+    if _lib is None:
+        _lib = _load()
+    jpeg = bytes(jpeg)
+    boxes = (Detection * max(len(detections), 1))(*[Detection(*d) for d in detections])
+    c = -1 if count is None else int(count)
+    out = ctypes.create_string_buffer(len(jpeg) + 4096)
+    n = _lib.edge_patch_jpeg(jpeg, len(jpeg), boxes, len(detections), c, out, len(out))
+    if n < 0:
+        out = ctypes.create_string_buffer(-n)
+        n = _lib.edge_patch_jpeg(jpeg, len(jpeg), boxes, len(detections), c, out, len(out))
+    if n <= 0:
+        return None
+    return out.raw[:n]
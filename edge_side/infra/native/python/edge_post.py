@@ -0,0 +1,79 @@
+"""
+Python binding for the native YOLO decoding and NMS (src/postprocess.h).
+
+Replaces the per-box Python loop over Ultralytics results when the raw head
+output is available (ncnn extractor, onnxruntime, ...):
+
+    from edge_post import decode
+    out0 = ex.extract("out0")[1]                     # (4 + classes, 8400)
+    for x1, y1, x2, y2, score, cls in decode(out0, gain=gain, pad=(px, py), image_size=(w, h)):
+        ...
+
+Loads libedge_post.so from $EDGE_POST_LIB or the native build directory.
+"""
+
+import ctypes
+import os
+
+_HERE = os.path.dirname(os.path.abspath(__file__))
+
+
+class Detection(ctypes.Structure):
+    _fields_ = [
+        ("x1", ctypes.c_float),
+        ("y1", ctypes.c_float),
+        ("x2", ctypes.c_float),
+        ("y2", ctypes.c_float),
+        ("score", ctypes.c_float),
+        ("cls", ctypes.c_int),
+    ]
+
+
+def _load():
+    path = os.environ.get("EDGE_POST_LIB") or os.path.join(_HERE, "..", "build", "libedge_post.so")
+    lib = ctypes.CDLL(path)
+    lib.edge_yolo_decode.restype = ctypes.c_int
+    lib.edge_yolo_decode.argtypes = [
+        ctypes.c_void_p, ctypes.c_int, ctypes.c_int,  # head, anchors, num_classes
+        ctypes.c_float, ctypes.c_float, ctypes.c_int,  # conf, iou, max_det
+        ctypes.c_float, ctypes.c_int, ctypes.c_int,  # gain, pad_x, pad_y
+        ctypes.c_int, ctypes.c_int,  # width, height
+        ctypes.POINTER(Detection), ctypes.c_int,  # out, capacity
+    ]
+    return lib
+
+
+_lib = None
+
+
+def decode(head, num_classes=None, conf=0.25, iou=0.7, max_det=300, gain=1.0, pad=(0, 0), image_size=None):
+    """
+    Decodes a YOLO head output into (x1, y1, x2, y2, score, class_id) tuples,
+    highest score first.
+
+    head: C-contiguous float32 buffer of (4 + num_classes) rows x anchors, e.g.
+          a numpy array (shape gives num_classes) or array.array('f').
+    gain, pad: the letterbox applied to the input; image_size=(w, h) maps the
+          boxes back to the source image like scale_boxes(). Without it boxes
+          stay in model input pixels.
+    """
+    global _lib
+    if _lib is None:
+        _lib = _load()
+
+    shape = getattr(head, "shape", None)
+    if num_classes is None:
+        num_classes = shape[-2] - 4 if shape is not None and len(shape) >= 2 else 1
+    view = memoryview(head).cast("B")
+    if view.nbytes % (4 * (4 + num_classes)):
+        raise ValueError("head is not (4 + num_classes) rows of float32")
+    anchors = view.nbytes // (4 * (4 + num_classes))
+    buf = (ctypes.c_char * view.nbytes).from_buffer(view) if not view.readonly else ctypes.create_string_buffer(view.tobytes())
+
+    out = (Detection * max_det)()
+    width, height = image_size if image_size else (0, 0)
+    n = _lib.edge_yolo_decode(ctypes.addressof(buf), anchors, num_classes, conf, iou, max_det, gain,
+                              int(pad[0]), int(pad[1]), width, height, out, max_det)
+    if n < 0:
+        raise ValueError("invalid head tensor or settings")
+    return [(d.x1, d.y1, d.x2, d.y2, d.score, d.cls) for d in out[:n]]
@@ -0,0 +1,197 @@
+"""
+Python binding for the shared-memory frame ring (src/frame_ring.h).
+
+Replaces frame_queue and the JPEG round trip to the backend when the
+ingest, inference, recorder and backend run as separate processes:
+
+    from edge_ring import FrameRing, RingReader
+    ring = FrameRing("/edge_frames", slots=8, slot_size=1600 * 1200 * 3)   # ingest
+    ring.write(frame, camera=1, width=w, height=h)
+
+    ring = FrameRing("/edge_frames")                                         # inference
+    reader = RingReader(ring)
+    got = reader.next(timeout=0.1, latest=True)
+    if got:
+        image = np.frombuffer(got.data, np.uint8).reshape(got.height, got.width, 3)
+        ...
+        if not reader.valid(got):   # overwritten while in use: drop the result
+            ...
+
+Frame data is a memoryview into shared memory, valid until the next call on
+the same reader. It keeps its reader and the mapping alive: closing the ring
+while readers or frames still use it only takes effect once they are gone.
+Loads libedge_ring.so from $EDGE_RING_LIB or the native build directory.
+"""
+
+import collections
+import ctypes
+import os
+import time
+import weakref
+
+_HERE = os.path.dirname(os.path.abspath(__file__))
+
+BGR = 0
+JPEG = 1
+
+Frame = collections.namedtuple("Frame", "sequence camera format width height timestamp_us data")
+
+
+class FrameInfo(ctypes.Structure):
+    _fields_ = [
+        ("timestamp_us", ctypes.c_uint64),
+        ("camera", ctypes.c_uint32),
+        ("format", ctypes.c_uint32),
+        ("width", ctypes.c_uint32),
+        ("height", ctypes.c_uint32),
+        ("size", ctypes.c_uint32),
+    ]
+
+
+def _load():
+    path = os.environ.get("EDGE_RING_LIB") or os.path.join(_HERE, "..", "build", "libedge_ring.so")
+    lib = ctypes.CDLL(path)
+    lib.edge_ring_create.restype = ctypes.c_void_p
+    lib.edge_ring_create.argtypes = [ctypes.c_char_p, ctypes.c_uint32, ctypes.c_size_t]
+    lib.edge_ring_open.restype = ctypes.c_void_p
+    lib.edge_ring_open.argtypes = [ctypes.c_char_p]
+    lib.edge_ring_close.restype = None
+    lib.edge_ring_close.argtypes = [ctypes.c_void_p]
+    lib.edge_ring_write.restype = ctypes.c_int
+    lib.edge_ring_write.argtypes = [ctypes.c_void_p, ctypes.POINTER(FrameInfo), ctypes.c_void_p]
+    lib.edge_ring_reader.restype = ctypes.c_void_p
+    lib.edge_ring_reader.argtypes = [ctypes.c_void_p, ctypes.c_int]
+    lib.edge_ring_reader_close.restype = None
+    lib.edge_ring_reader_close.argtypes = [ctypes.c_void_p]
+    lib.edge_ring_next.restype = ctypes.c_int
+    lib.edge_ring_next.argtypes = [
+        ctypes.c_void_p, ctypes.c_int, ctypes.c_int64,  # reader, latest, timeout_us
+        ctypes.POINTER(ctypes.c_uint64), ctypes.POINTER(FrameInfo), ctypes.POINTER(ctypes.c_void_p),
+    ]
+    lib.edge_ring_valid.restype = ctypes.c_int
+    lib.edge_ring_valid.argtypes = [ctypes.c_void_p, ctypes.c_uint64]
+    return lib
+
+
+_lib = None
+
+
+def _library():
+    global _lib
+    if _lib is None:
+        _lib = _load()
+    return _lib
+
+
+class FrameRing:
+    """
+    Opens the ring name, or creates it when slots and slot_size are given;
+    the creator removes it again on close(). The mapping stays until the
+    readers and frames of this ring are gone as well.
+    """
+
+    def __init__(self, name, slots=None, slot_size=None):
+        self._ring = None
+        self._users = 0  # readers and frames that still point into the mapping
+        self._closing = False
+        lib = _library()
+        if slots is None:
+            self._ring = lib.edge_ring_open(name.encode())
+        else:
+            self._ring = lib.edge_ring_create(name.encode(), slots, slot_size)
+        if not self._ring:
+            raise OSError("cannot %s frame ring %s" % ("open" if slots is None else "create", name))
+
+    def write(self, data, camera=0, width=0, height=0, format=BGR, timestamp_us=None):
+        """
+        Copies data (bytes, a C-contiguous numpy array, ...) into the next
+        slot. Returns False if a reliable reader is a whole ring behind.
+        """
+        if self._closing:
+            raise ValueError("frame ring is closed")
+        view = memoryview(data).cast("B")
+        info = FrameInfo(time.monotonic_ns() // 1000 if timestamp_us is None else timestamp_us,
+                         camera, format, width, height, view.nbytes)
+        if view.readonly:
+            buf = ctypes.c_char_p(view.tobytes())
+        else:
+            buf = (ctypes.c_char * view.nbytes).from_buffer(view)
+        return bool(_lib.edge_ring_write(self._ring, ctypes.byref(info), buf))
+
+    def close(self):
+        self._closing = True
+        if self._ring and not self._users:
+            _lib.edge_ring_close(self._ring)
+            self._ring = None
+
+    def _acquire(self):
+        self._users += 1
+
+    def _release(self):
+        self._users -= 1
+        if self._closing:
+            self.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def __del__(self):
+        self.close()
+
+
+class RingReader:
+    """
+    Follows ring from the next frame written. A reliable reader gets every
+    frame and holds writers back; a lossy one skips frames it was too slow for.
+    """
+
+    def __init__(self, ring, reliable=False):
+        self._reader = None
+        if ring._closing:
+            raise ValueError("frame ring is closed")
+        self._reader = _lib.edge_ring_reader(ring._ring, 1 if reliable else 0)
+        if not self._reader:
+            raise OSError("no free reader entry in the frame ring")
+        self._ring = ring
+        ring._acquire()
+
+    def next(self, timeout=1.0, latest=False):
+        """The next Frame, or the newest one with latest=True; None on timeout."""
+        if not self._reader:
+            raise ValueError("ring reader is closed")
+        sequence = ctypes.c_uint64()
+        info = FrameInfo()
+        data = ctypes.c_void_p()
+        if not _lib.edge_ring_next(self._reader, 1 if latest else 0, int(timeout * 1e6),
+                                   ctypes.byref(sequence), ctypes.byref(info), ctypes.byref(data)):
+            return None
+        if info.size:
+            buf = (ctypes.c_ubyte * info.size).from_address(data.value)
+            # the memoryview keeps buf alive, buf keeps the reader (and a
+            # reliable reader's hold on the slot) and the mapping
+            buf._reader = self
+            self._ring._acquire()
+            weakref.finalize(buf, self._ring._release)
+            view = memoryview(buf)
+        else:
+            view = memoryview(b"")
+        return Frame(sequence.value, info.camera, info.format, info.width, info.height, info.timestamp_us,
+                     view.cast("B"))
+
+    def valid(self, frame):
+        """False if frame was overwritten since next() returned it."""
+        if not self._reader:
+            raise ValueError("ring reader is closed")
+        return bool(_lib.edge_ring_valid(self._reader, frame.sequence))
+
+    def close(self):
+        if self._reader:
+            _lib.edge_ring_reader_close(self._reader)
+            self._reader = None
+            self._ring._release()
+
+    def __del__(self):
+        self.close()
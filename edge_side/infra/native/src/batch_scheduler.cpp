@@ -0,0 +1,227 @@
+#include "batch_scheduler.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace edge {
+
+using clock_type = std::chrono::steady_clock;
+
+static uint64_t elapsed_us(clock_type::time_point from, clock_type::time_point to)
+{
+    return (uint64_t)std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::microseconds>(to - from).count());
+}
+
+batch_scheduler::batch_scheduler(const batch_config &config, batch_infer_fn infer,
+                                 std::function<void(batch_result &result)> on_result)
+    : m_config(config),
+      m_infer(std::move(infer)),
+      m_on_result(std::move(on_result)),
+      m_infer_us(std::max(1, config.max_batch) + 1, 0.0),
+      m_sizes(std::max(1, config.max_batch) + 1),
+      m_last_report(clock_type::now())
+{
+    m_config.max_batch = std::max(1, m_config.max_batch);
+}
+
+batch_scheduler::~batch_scheduler()
+{
+    stop();
+}
+
+void batch_scheduler::start()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running)
+        return;
+    m_running = true;
+    m_thread = std::thread(&batch_scheduler::run, this);
+}
+
+void batch_scheduler::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+        m_changed.notify_all();
+    }
+    if (m_thread.joinable())
+        m_thread.join();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pending.clear();
+}
+
+void batch_scheduler::submit(frame_ptr frame)
+{
+    clock_type::time_point now = clock_type::now();
+    if (frame->received.time_since_epoch().count() == 0)
+        frame->received = now;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (pending_frame &p : m_pending) {
+        if (p.frame->camera == frame->camera) {
+            p.frame = std::move(frame);
+            p.submitted = now;
+            m_superseded++;
+            m_changed.notify_one();
+            return;
+        }
+    }
+    m_pending.push_back({std::move(frame), now, now});
+    m_changed.notify_one();
+}
+
+double batch_scheduler::estimate_us(int size) const
+{
+    if (m_infer_us[size] > 0)
+        return m_infer_us[size];
+    // not measured yet: scale the nearest smaller size that was
+    for (int s = size - 1; s >= 1; s--)
+        if (m_infer_us[s] > 0)
+            return m_infer_us[s] * size / s;
+    return 0;
+}
+
+clock_type::time_point batch_scheduler::start_deadline() const
+{
+    clock_type::time_point oldest_slot = m_pending[0].waiting_since, oldest_frame = m_pending[0].frame->received;
+    for (const pending_frame &p : m_pending)
+        oldest_frame = std::min(oldest_frame, p.frame->received);
+
+    int next = std::min((int)m_pending.size() + 1, m_config.max_batch);
+    auto budget = m_config.slo - std::chrono::microseconds((int64_t)estimate_us(next));
+    return std::min(oldest_slot + m_config.max_wait, oldest_frame + budget);
+}
+
+void batch_scheduler::run()
+{
+    std::vector<pending_frame> batch;
+    std::vector<const bgr_image *> images;
+    std::vector<std::vector<detection>> detections;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_running) {
+        if (m_pending.empty()) {
+            m_changed.wait(lock);
+            continue;
+        }
+        bool full = (int)m_pending.size() >= m_config.max_batch;
+        if (!full) {
+            clock_type::time_point deadline = start_deadline();
+            if (clock_type::now() < deadline) {
+                // a new frame or a replacement may change the decision
+                m_changed.wait_until(lock, deadline);
+                continue;
+            }
+        }
+
+        // slots are in arrival order, so the longest waiting go first
+        size_t n = std::min(m_pending.size(), (size_t)m_config.max_batch);
+        batch.clear();
+        for (size_t i = 0; i < n; i++)
+            batch.push_back(std::move(m_pending[i]));
+        m_pending.erase(m_pending.begin(), m_pending.begin() + n);
+        lock.unlock();
+
+        clock_type::time_point started = clock_type::now();
+        images.clear();
+        for (const pending_frame &p : batch) {
+            images.push_back(&p.frame->image);
+            m_queue_latency.record(elapsed_us(p.submitted, started));
+        }
+        detections.clear();
+        bool ok = m_infer(images, detections) && detections.size() == n;
+        clock_type::time_point finished = clock_type::now();
+
+        uint64_t us = elapsed_us(started, finished);
+        m_infer_latency.record(us);
+        double &average = m_infer_us[n];
+        average = average > 0 ? average * 0.8 + us * 0.2 : us;
+        m_batches++;
+        (full ? m_full : m_deadline)++;
+        m_sizes[n]++;
+
+        if (!ok) {
+            m_failed += n;
+        } else {
+            for (size_t i = 0; i < n; i++) {
+                batch_result result;
+                result.latency_us = elapsed_us(batch[i].frame->received, finished);
+                result.queue_us = elapsed_us(batch[i].submitted, started);
+                result.batch_size = (int)n;
+                result.detections.swap(detections[i]);
+                result.frame = std::move(batch[i].frame);
+                m_latency.record(result.latency_us);
+                if (result.latency_us > (uint64_t)m_config.slo.count())
+                    m_slo_misses++;
+                m_frames++;
+                if (m_on_result)
+                    m_on_result(result);
+            }
+        }
+        lock.lock();
+    }
+}
+
+batch_report batch_scheduler::report()
+{
+    clock_type::time_point now = clock_type::now();
+    batch_report r;
+    r.seconds = std::chrono::duration<double>(now - m_last_report).count();
+    m_last_report = now;
+
+    r.frames = m_frames.exchange(0);
+    r.batches = m_batches.exchange(0);
+    r.full = m_full.exchange(0);
+    r.deadline = m_deadline.exchange(0);
+    r.superseded = m_superseded.exchange(0);
+    r.failed = m_failed.exchange(0);
+    r.slo_misses = m_slo_misses.exchange(0);
+    r.sizes.resize(m_sizes.size());
+    for (size_t i = 0; i < m_sizes.size(); i++)
+        r.sizes[i] = m_sizes[i].exchange(0);
+
+    r.fps = r.seconds > 0 ? r.frames / r.seconds : 0;
+    uint64_t batched = 0;
+    for (size_t i = 0; i < r.sizes.size(); i++)
+        batched += i * r.sizes[i];
+    r.mean_batch = r.batches ? (double)batched / r.batches : 0;
+    r.fill = r.mean_batch / m_config.max_batch;
+
+    r.queue_p50_us = m_queue_latency.percentile(50);
+    r.queue_p99_us = m_queue_latency.percentile(99);
+    r.infer_p50_us = m_infer_latency.percentile(50);
+    r.infer_p99_us = m_infer_latency.percentile(99);
+    r.latency_p50_us = m_latency.percentile(50);
+    r.latency_p99_us = m_latency.percentile(99);
+    m_queue_latency.reset();
+    m_infer_latency.reset();
+    m_latency.reset();
+    return r;
+}
+
+std::string batch_scheduler::format_report(const batch_report &r)
+{
+    std::string out;
+    char line[256];
+    snprintf(line, sizeof(line),
+             "batches %llu (%llu full, %llu deadline), %.2f fps, mean batch %.2f, fill %.0f%%, superseded %llu, "
+             "failed %llu, SLO misses %llu\n",
+             (unsigned long long)r.batches, (unsigned long long)r.full, (unsigned long long)r.deadline, r.fps,
+             r.mean_batch, 100 * r.fill, (unsigned long long)r.superseded, (unsigned long long)r.failed,
+             (unsigned long long)r.slo_misses);
+    out += line;
+
+    out += "batch sizes:";
+    for (size_t i = 1; i < r.sizes.size(); i++) {
+        snprintf(line, sizeof(line), " %zu:%llu", i, (unsigned long long)r.sizes[i]);
+        out += line;
+    }
+    snprintf(line, sizeof(line), "\nqueue p50/p99 %.2f / %.2f ms, infer %.2f / %.2f ms, end-to-end %.2f / %.2f ms\n",
+             r.queue_p50_us / 1000.0, r.queue_p99_us / 1000.0, r.infer_p50_us / 1000.0, r.infer_p99_us / 1000.0,
+             r.latency_p50_us / 1000.0, r.latency_p99_us / 1000.0);
+    out += line;
+    return out;
+}
+
+} // namespace edge
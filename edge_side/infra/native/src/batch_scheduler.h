@@ -0,0 +1,120 @@
+// Cross-camera dynamic batching in front of the detector.
+//
+// Decoded frames from every camera wait in one pending set that holds at
+// most one frame per camera: a newer frame replaces the one still waiting,
+// since a people count only needs the latest view. A scheduler thread
+// starts a batch as soon as max_batch frames are pending, or when waiting
+// for one more would make the oldest frame miss the latency SLO, judged by
+// the measured inference time of the next batch size (and never later than
+// max_wait). The batch runs as one inference call and each result goes back
+// to its camera through the on_result callback.
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ingest_server.h"
+#include "postprocess.h"
+#include "stats.h"
+
+namespace edge {
+
+struct batch_config {
+    int max_batch = 4;
+    std::chrono::microseconds max_wait{50000}; // longest a frame waits for others to join it
+    std::chrono::microseconds slo{500000};     // received -> result target
+};
+
+// Runs one inference over a batch; out[i] belongs to images[i]
+using batch_infer_fn =
+    std::function<bool(const std::vector<const bgr_image *> &images, std::vector<std::vector<detection>> &out)>;
+
+struct batch_result {
+    frame_ptr frame;
+    std::vector<detection> detections;
+    int batch_size;
+    uint64_t queue_us;   // submit() -> batch start
+    uint64_t latency_us; // frame received -> result
+};
+
+struct batch_report {
+    double seconds;
+    uint64_t frames, batches;
+    uint64_t full, deadline;     // why each batch started
+    uint64_t superseded;         // replaced by a newer frame of the same camera
+    uint64_t failed;             // frames of batches whose inference failed
+    uint64_t slo_misses;         // results later than the SLO
+    double fps;
+    double mean_batch, fill;     // frames per batch, and that over max_batch
+    std::vector<uint64_t> sizes; // batches of each size, index = size
+    uint64_t queue_p50_us, queue_p99_us;
+    uint64_t infer_p50_us, infer_p99_us; // per batch
+    uint64_t latency_p50_us, latency_p99_us;
+};
+
+class batch_scheduler {
+public:
+    batch_scheduler(const batch_config &config, batch_infer_fn infer,
+                    std::function<void(batch_result &result)> on_result);
+    ~batch_scheduler();
+
+    batch_scheduler(const batch_scheduler &) = delete;
+    batch_scheduler &operator=(const batch_scheduler &) = delete;
+
+    void start();
+    // Finishes the batch in flight; frames still pending are discarded
+    void stop();
+
+    // Queues a decoded frame for the next batch
+    void submit(frame_ptr frame);
+
+    // Counters and percentiles since the previous call
+    batch_report report();
+    static std::string format_report(const batch_report &report);
+
+    const batch_config &config() const { return m_config; }
+
+private:
+    struct pending_frame {
+        frame_ptr frame;
+        std::chrono::steady_clock::time_point submitted;
+        // when the camera's slot was taken; a replacement frame keeps its
+        // place so busy cameras are not pushed to the back of the batch
+        std::chrono::steady_clock::time_point waiting_since;
+    };
+
+    void run();
+    // Latest start for the pending frames: max_wait after the oldest slot,
+    // or early enough for a batch one larger to finish within the SLO
+    std::chrono::steady_clock::time_point start_deadline() const;
+    double estimate_us(int size) const;
+
+    batch_config m_config;
+    batch_infer_fn m_infer;
+    std::function<void(batch_result &)> m_on_result;
+
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    std::vector<pending_frame> m_pending;
+    bool m_running = false;
+    std::thread m_thread;
+
+    // moving average of the inference time per batch size, index = size;
+    // only touched by the scheduler thread
+    std::vector<double> m_infer_us;
+
+    std::atomic<uint64_t> m_frames{0}, m_batches{0}, m_full{0}, m_deadline{0};
+    std::atomic<uint64_t> m_superseded{0}, m_failed{0}, m_slo_misses{0};
+    std::vector<std::atomic<uint64_t>> m_sizes;
+    latency_histogram m_queue_latency, m_infer_latency, m_latency;
+    std::chrono::steady_clock::time_point m_last_report;
+};
+
+} // namespace edge
@@ -0,0 +1,365 @@
+// Convolution as a tiled GEMM over packed weights.
+//
+// Weights are packed once at load into blocks of 8 output channels laid out
+// [k][8], and the output is produced in 8 channel x 8 pixel register tiles:
+// each step loads 8 neighbouring input pixels and multiplies them by the 8
+// weights of one k. Input pixels are gathered per tile of TILE outputs into
+// a per-thread panel in the same [k][8] blocking (im2col for kernels larger
+// than 1x1), so the inner loop only ever streams two contiguous arrays.
+// Bias and the fused activation are applied as a tile is stored.
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "layers.h"
+#include "simd.h"
+
+namespace edge {
+
+namespace {
+
+const int BLOCK = 8; // output channels per packed weight block
+const int TILE = 64; // output pixels per work item
+
+inline simd::v8 activate(simd::v8 x, activation_type act)
+{
+    switch (act) {
+    case ACT_RELU:
+        return simd::max(x, simd::splat(0.f));
+    case ACT_SIGMOID:
+        return simd::sigmoid(x);
+    case ACT_SWISH:
+        return simd::swish(x);
+    default:
+        return x;
+    }
+}
+
+// out[o][0..n) = act(bias[o] + sum_k w[k][o] * col[k][0..n)) for one block.
+// col is packed [n / 8][k][8] so every step reads the next 32 bytes.
+void gemm_block(const float *wpack, const float *bias, int outs, int k_total, const float *col, int n, float *out,
+                size_t out_stride, activation_type act)
+{
+    for (int px = 0; px < n; px += 8) {
+        simd::v8 acc[BLOCK];
+        for (int o = 0; o < BLOCK; o++)
+            acc[o] = simd::splat(0.f);
+
+        const float *w = wpack;
+        const float *x = col + (size_t)px * k_total;
+        for (int k = 0; k < k_total; k++) {
+            simd::v8 v = simd::load(x);
+            acc[0] += v * w[0];
+            acc[1] += v * w[1];
+            acc[2] += v * w[2];
+            acc[3] += v * w[3];
+            acc[4] += v * w[4];
+            acc[5] += v * w[5];
+            acc[6] += v * w[6];
+            acc[7] += v * w[7];
+            w += BLOCK;
+            x += 8;
+        }
+
+        int lanes = std::min(8, n - px);
+        for (int o = 0; o < outs; o++) {
+            simd::v8 y = activate(acc[o] + (bias ? bias[o] : 0.f), act);
+            float *dst = out + o * out_stride + px;
+            if (lanes == 8) {
+                simd::store(dst, y);
+            } else {
+                float tmp[8];
+                simd::store(tmp, y);
+                memcpy(dst, tmp, lanes * sizeof(float));
+            }
+        }
+    }
+}
+
+struct conv_params {
+    int num_output = 0;
+    int kernel_w = 1, kernel_h = 1;
+    int dilation_w = 1, dilation_h = 1;
+    int stride_w = 1, stride_h = 1;
+    int pad_left = 0, pad_right = 0, pad_top = 0, pad_bottom = 0;
+    bool bias_term = false;
+    int weight_size = 0;
+    activation_type act = ACT_NONE;
+
+    bool load(const param_dict &pd)
+    {
+        num_output = pd.get(0, 0);
+        kernel_w = pd.get(1, 0);
+        kernel_h = pd.get(11, kernel_w);
+        dilation_w = pd.get(2, 1);
+        dilation_h = pd.get(12, dilation_w);
+        stride_w = pd.get(3, 1);
+        stride_h = pd.get(13, stride_w);
+        pad_left = pd.get(4, 0);
+        pad_right = pd.get(15, pad_left);
+        pad_top = pd.get(14, pad_left);
+        pad_bottom = pd.get(16, pad_top);
+        bias_term = pd.get(5, 0) != 0;
+        weight_size = pd.get(6, 0);
+        int a = pd.get(9, 0);
+        if (a != ACT_NONE && a != ACT_RELU && a != ACT_SIGMOID) {
+            fprintf(stderr, "[Net] Unsupported convolution activation %d\n", a);
+            return false;
+        }
+        act = (activation_type)a;
+        if (pad_left < 0 || pad_top < 0 || pd.get(8, 0) != 0) {
+            fprintf(stderr, "[Net] Unsupported convolution padding or int8 weights\n");
+            return false;
+        }
+        return num_output > 0 && kernel_w > 0 && weight_size > 0;
+    }
+
+    int out_w(int w) const { return (w + pad_left + pad_right - (dilation_w * (kernel_w - 1) + 1)) / stride_w + 1; }
+    int out_h(int h) const { return (h + pad_top + pad_bottom - (dilation_h * (kernel_h - 1) + 1)) / stride_h + 1; }
+};
+
+class convolution_layer : public layer {
+public:
+    bool load_param(const param_dict &pd) override { return m_p.load(pd); }
+
+    bool load_model(model_reader &mr) override
+    {
+        std::vector<float> weights;
+        if (!mr.read_tagged(m_p.weight_size, weights))
+            return false;
+        if (m_p.bias_term && !mr.read_raw(m_p.num_output, m_bias))
+            return false;
+        m_bias.resize(((m_p.num_output + BLOCK - 1) / BLOCK) * BLOCK, 0.f);
+
+        // [out][in][kh][kw] -> [out / 8][k][8], zero padded to whole blocks
+        m_k = m_p.weight_size / m_p.num_output;
+        int blocks = (m_p.num_output + BLOCK - 1) / BLOCK;
+        m_packed.assign((size_t)blocks * m_k * BLOCK, 0.f);
+        for (int o = 0; o < m_p.num_output; o++)
+            for (int k = 0; k < m_k; k++)
+                m_packed[((size_t)(o / BLOCK) * m_k + k) * BLOCK + o % BLOCK] = weights[(size_t)o * m_k + k];
+        return true;
+    }
+
+    bool fuse_activation(activation_type act) override
+    {
+        if (m_p.act != ACT_NONE)
+            return false;
+        m_p.act = act;
+        return true;
+    }
+
+    bool forward(const std::vector<tensor> &bottoms, std::vector<tensor> &tops, thread_pool &pool) const override
+    {
+        std::vector<std::vector<tensor>> outs(1, std::vector<tensor>(1));
+        if (!forward_batch({bottoms}, outs, pool))
+            return false;
+        tops[0] = outs[0][0];
+        return true;
+    }
+
+    // The tiles of every sample go into one parallel_for, so a batch of
+    // small late-stage maps still gives each thread enough work
+    bool forward_batch(const std::vector<std::vector<tensor>> &bottoms, std::vector<std::vector<tensor>> &tops,
+                       thread_pool &pool) const override
+    {
+        const tensor &first = bottoms[0][0];
+        for (const std::vector<tensor> &b : bottoms)
+            if (b[0].dims != 3 || b[0].c * m_p.kernel_w * m_p.kernel_h != m_k || !b[0].same_shape(first))
+                return false;
+        const int samples = (int)bottoms.size();
+        int outw = m_p.out_w(first.w), outh = m_p.out_h(first.h);
+        for (int s = 0; s < samples; s++)
+            tops[s][0] = tensor::make_3d(outw, outh, m_p.num_output);
+
+        const int pixels = outw * outh;
+        const int tiles = (pixels + TILE - 1) / TILE;
+        const int blocks = (m_p.num_output + BLOCK - 1) / BLOCK;
+        const bool direct = m_p.kernel_w == 1 && m_p.kernel_h == 1 && m_p.stride_w == 1 && m_p.stride_h == 1 &&
+                            !m_p.pad_left && !m_p.pad_right && !m_p.pad_top && !m_p.pad_bottom;
+
+        // split the channel blocks too when there are few tiles to share out
+        int groups = 1;
+        while (groups < blocks && samples * tiles * groups < pool.size() * 4)
+            groups *= 2;
+        groups = std::min(groups, blocks);
+        int blocks_per_group = (blocks + groups - 1) / groups;
+
+        pool.parallel_for(samples * tiles * groups, [&](int item) {
+            int sample = item / (tiles * groups), tile = item / groups % tiles, group = item % groups;
+            const tensor &in = bottoms[sample][0];
+            const tensor &out = tops[sample][0];
+            int p0 = tile * TILE, n = std::min(TILE, pixels - p0);
+            static thread_local std::vector<float> col;
+            col.resize((size_t)m_k * TILE);
+            if (direct)
+                pack_direct(in, p0, n, col.data());
+            else
+                im2col(in, p0, n, outw, col.data());
+
+            int b_end = std::min(blocks, (group + 1) * blocks_per_group);
+            for (int b = group * blocks_per_group; b < b_end; b++) {
+                int o0 = b * BLOCK;
+                gemm_block(m_packed.data() + (size_t)b * m_k * BLOCK, m_p.bias_term ? &m_bias[o0] : nullptr,
+                           std::min(BLOCK, m_p.num_output - o0), m_k, col.data(), n, out.channel(o0) + p0,
+                           out.plane(), m_p.act);
+            }
+        });
+        return true;
+    }
+
+private:
+    // Pixels [p0, p0 + n) of a 1x1 convolution input, packed [n / 8][k][8]
+    void pack_direct(const tensor &in, int p0, int n, float *col) const
+    {
+        for (int px = 0; px < n; px += 8) {
+            int lanes = std::min(8, n - px);
+            const float *src = in.data + p0 + px;
+            if (lanes == 8) {
+                for (int k = 0; k < m_k; k++, src += in.plane(), col += 8)
+                    simd::store(col, simd::load(src));
+            } else {
+                for (int k = 0; k < m_k; k++, src += in.plane(), col += 8) {
+                    memset(col, 0, 8 * sizeof(float));
+                    memcpy(col, src, lanes * sizeof(float));
+                }
+            }
+        }
+    }
+
+    // Rows k = (ic, ky, kx) of output pixels [p0, p0 + n), zero outside the
+    // input, in the same packed layout
+    void im2col(const tensor &in, int p0, int n, int outw, float *col) const
+    {
+        int oy[TILE], ox[TILE];
+        for (int t = 0; t < TILE; t++) {
+            // lanes past n read as padding
+            oy[t] = t < n ? (p0 + t) / outw * m_p.stride_h - m_p.pad_top : -(1 << 20);
+            ox[t] = t < n ? (p0 + t) % outw * m_p.stride_w - m_p.pad_left : -(1 << 20);
+        }
+        for (int px = 0; px < n; px += 8) {
+            const int *y0 = oy + px, *x0 = ox + px;
+            for (int q = 0; q < in.c; q++) {
+                const float *src = in.channel(q);
+                for (int ky = 0; ky < m_p.kernel_h; ky++)
+                    for (int kx = 0; kx < m_p.kernel_w; kx++) {
+                        int dy = ky * m_p.dilation_h, dx = kx * m_p.dilation_w;
+                        for (int t = 0; t < 8; t++) {
+                            int y = y0[t] + dy, x = x0[t] + dx;
+                            col[t] = (unsigned)y < (unsigned)in.h && (unsigned)x < (unsigned)in.w ? src[y * in.w + x] : 0.f;
+                        }
+                        col += 8;
+                    }
+            }
+        }
+    }
+
+    conv_params m_p;
+    int m_k = 0;
+    std::vector<float> m_packed;
+    std::vector<float> m_bias;
+};
+
+// One filter per channel (group == channels == num_output)
+class convolution_depthwise_layer : public layer {
+public:
+    bool load_param(const param_dict &pd) override
+    {
+        m_group = pd.get(7, 1);
+        return m_p.load(pd);
+    }
+
+    bool load_model(model_reader &mr) override
+    {
+        if (m_group != m_p.num_output || m_p.weight_size != m_p.num_output * m_p.kernel_w * m_p.kernel_h) {
+            fprintf(stderr, "[Net] %s: only depthwise grouping is supported\n", name.c_str());
+            return false;
+        }
+        if (!mr.read_tagged(m_p.weight_size, m_weights))
+            return false;
+        if (m_p.bias_term)
+            return mr.read_raw(m_p.num_output, m_bias);
+        m_bias.assign(m_p.num_output, 0.f);
+        return true;
+    }
+
+    bool fuse_activation(activation_type act) override
+    {
+        if (m_p.act != ACT_NONE)
+            return false;
+        m_p.act = act;
+        return true;
+    }
+
+    bool forward(const std::vector<tensor> &bottoms, std::vector<tensor> &tops, thread_pool &pool) const override
+    {
+        const tensor &in = bottoms[0];
+        if (in.dims != 3 || in.c != m_group)
+            return false;
+        int outw = m_p.out_w(in.w), outh = m_p.out_h(in.h);
+        tensor out = tensor::make_3d(outw, outh, in.c);
+        int kw = m_p.kernel_w, kh = m_p.kernel_h;
+
+        pool.parallel_for(in.c, [&](int q) {
+            // zero-padded copy of the plane keeps the inner loop branch free
+            int pw = in.w + m_p.pad_left + m_p.pad_right, ph = in.h + m_p.pad_top + m_p.pad_bottom;
+            static thread_local std::vector<float> padded;
+            padded.assign((size_t)pw * ph + 8, 0.f);
+            for (int y = 0; y < in.h; y++)
+                memcpy(&padded[(size_t)(y + m_p.pad_top) * pw + m_p.pad_left], in.channel(q) + (size_t)y * in.w,
+                       in.w * sizeof(float));
+
+            const float *w = &m_weights[(size_t)q * kw * kh];
+            float *dst = out.channel(q);
+            std::vector<float> acc(outw);
+            for (int oy = 0; oy < outh; oy++) {
+                std::fill(acc.begin(), acc.end(), m_bias[q]);
+                for (int ky = 0; ky < kh; ky++) {
+                    const float *row = &padded[(size_t)(oy * m_p.stride_h + ky * m_p.dilation_h) * pw];
+                    for (int kx = 0; kx < kw; kx++) {
+                        float wk = w[ky * kw + kx];
+                        const float *src = row + kx * m_p.dilation_w;
+                        if (m_p.stride_w == 1) {
+                            for (int ox = 0; ox < outw; ox++)
+                                acc[ox] += src[ox] * wk;
+                        } else {
+                            for (int ox = 0; ox < outw; ox++)
+                                acc[ox] += src[ox * m_p.stride_w] * wk;
+                        }
+                    }
+                }
+                int ox = 0;
+                for (; ox + 8 <= outw; ox += 8)
+                    simd::store(dst + ox, activate(simd::load(&acc[ox]), m_p.act));
+                for (; ox < outw; ox++) {
+                    float tmp[8] = {acc[ox]};
+                    simd::store(tmp, activate(simd::load(tmp), m_p.act));
+                    dst[ox] = tmp[0];
+                }
+                dst += outw;
+            }
+        });
+        tops[0] = out;
+        return true;
+    }
+
+private:
+    conv_params m_p;
+    int m_group = 1;
+    std::vector<float> m_weights;
+    std::vector<float> m_bias;
+};
+
+} // namespace
+
+std::unique_ptr<layer> create_convolution()
+{
+    return std::unique_ptr<layer>(new convolution_layer);
+}
+
+std::unique_ptr<layer> create_convolution_depthwise()
+{
+    return std::unique_ptr<layer>(new convolution_depthwise_layer);
+}
+
+} // namespace edge
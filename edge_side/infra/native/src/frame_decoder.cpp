@@ -0,0 +1,86 @@
+#include "frame_decoder.h"
+
+#include <cstring>
+
+#include "tjpgd.h"
+
+namespace edge {
+
+namespace {
+
+// Pool size esp_jpeg uses with JD_FASTDECODE == 2
+const size_t WORK_SIZE = 65472;
+
+struct session {
+    const uint8_t *src;
+    size_t len;
+    size_t read;
+    bgr_image *out;
+};
+
+size_t read_input(JDEC *jd, uint8_t *buf, size_t len)
+{
+    session *s = (session *)jd->device;
+    if (len > s->len - s->read)
+        len = s->len - s->read;
+    if (buf)
+        memcpy(buf, s->src + s->read, len);
+    s->read += len;
+    return len;
+}
+
+// tjpgd emits R, G, B per MCU block; store it B, G, R
+int write_block(JDEC *jd, void *bitmap, JRECT *rect)
+{
+    session *s = (session *)jd->device;
+    const uint8_t *in = (const uint8_t *)bitmap;
+    size_t stride = (size_t)s->out->width * 3;
+    int w = rect->right - rect->left + 1;
+
+    for (int y = rect->top; y <= rect->bottom; y++) {
+        uint8_t *dst = s->out->data.data() + y * stride + rect->left * 3;
+        for (int x = 0; x < w; x++) {
+            dst[0] = in[2];
+            dst[1] = in[1];
+            dst[2] = in[0];
+            dst += 3;
+            in += 3;
+        }
+    }
+    return 1;
+}
+
+} // namespace
+
+frame_decoder::frame_decoder()
+    : m_work(WORK_SIZE)
+{
+}
+
+bool frame_decoder::decode(const uint8_t *jpeg, size_t len, bgr_image &out, uint8_t scale)
+{
+    JDEC jd;
+    session s = {jpeg, len, 0, &out};
+    if (scale > 3)
+        return false;
+    if (jd_prepare(&jd, read_input, m_work.data(), m_work.size(), &s) != JDR_OK)
+        return false;
+
+    out.width = jd.width >> scale;
+    out.height = jd.height >> scale;
+    out.data.resize((size_t)out.width * out.height * 3);
+    return jd_decomp(&jd, write_block, scale) == JDR_OK;
+}
+
+bool frame_decoder::probe(const uint8_t *jpeg, size_t len, uint16_t &width, uint16_t &height)
+{
+    JDEC jd;
+    session s = {jpeg, len, 0, nullptr};
+    if (jd_prepare(&jd, read_input, m_work.data(), m_work.size(), &s) != JDR_OK)
+        return false;
+    width = jd.width;
+    height = jd.height;
+    return true;
+}
+
+} // namespace edge
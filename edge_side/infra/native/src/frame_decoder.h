@@ -0,0 +1,32 @@
+// JPEG decoding with the tjpgd decoder the cameras ship in esp_jpeg.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace edge {
+
+// Interleaved B, G, R pixels, the layout cv2.imdecode returns
+struct bgr_image {
+    std::vector<uint8_t> data;
+    uint16_t width = 0;
+    uint16_t height = 0;
+};
+
+class frame_decoder {
+public:
+    frame_decoder();
+
+    // Decodes a baseline JPEG, optionally downscaled by 1 << scale (0..3).
+    // The image buffer is reused across calls. Returns false on a bad stream.
+    bool decode(const uint8_t *jpeg, size_t len, bgr_image &out, uint8_t scale = 0);
+
+    // Reads the image size without decoding
+    bool probe(const uint8_t *jpeg, size_t len, uint16_t &width, uint16_t &height);
+
+private:
+    std::vector<uint8_t> m_work; // tjpgd memory pool, one per decoder so workers never share it
+};
+
+} // namespace edge
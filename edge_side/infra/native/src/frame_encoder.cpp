@@ -0,0 +1,50 @@
+#include "frame_encoder.h"
+
+#include <cstring>
+#include <mutex>
+
+namespace edge {
+
+// serialises init(), the only place jpge writes its shared tables
+static std::mutex s_tables;
+
+bool frame_encoder::vector_stream::put_buf(const void *buf, int len)
+{
+    // called with NULL once the image is complete
+    if (buf)
+        out->insert(out->end(), (const uint8_t *)buf, (const uint8_t *)buf + len);
+    return true;
+}
+
+frame_encoder::frame_encoder(int quality, jpge::subsampling_t subsampling)
+{
+    m_params.m_quality = quality;
+    m_params.m_subsampling = subsampling;
+}
+
+bool frame_encoder::encode(const uint8_t *bgr, int width, int height, std::vector<uint8_t> &out)
+{
+    out.clear();
+    m_stream.out = &out;
+    {
+        std::lock_guard<std::mutex> lock(s_tables);
+        if (!m_encoder.init(&m_stream, width, height, 3, m_params))
+            return false;
+    }
+
+    m_scanline.resize((size_t)width * 3);
+    for (int y = 0; y < height; y++) {
+        const uint8_t *src = bgr + (size_t)y * width * 3;
+        uint8_t *dst = m_scanline.data();
+        for (int x = 0; x < width; x++, src += 3, dst += 3) {
+            dst[0] = src[2];
+            dst[1] = src[1];
+            dst[2] = src[0];
+        }
+        if (!m_encoder.process_scanline(m_scanline.data()))
+            return false;
+    }
+    return m_encoder.process_scanline(nullptr);
+}
+
+} // namespace edge
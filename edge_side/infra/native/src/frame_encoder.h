@@ -0,0 +1,38 @@
+// JPEG encoding with the jpge encoder the cameras use (esp32-camera
+// conversions), the native replacement for cv2.imencode of annotated frames.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "jpge.h"
+
+namespace edge {
+
+class frame_encoder {
+public:
+    // jpge keeps its quantisation and Huffman tables in globals that init()
+    // rebuilds when the quality changes, so all encoders of a process should
+    // use the same quality
+    explicit frame_encoder(int quality = 85, jpge::subsampling_t subsampling = jpge::H2V2);
+
+    // Encodes width x height interleaved B, G, R pixels into out. The encoder,
+    // its MCU buffer and out's capacity are reused across calls.
+    bool encode(const uint8_t *bgr, int width, int height, std::vector<uint8_t> &out);
+
+private:
+    class vector_stream : public jpge::output_stream {
+    public:
+        std::vector<uint8_t> *out = nullptr;
+        bool put_buf(const void *buf, int len) override;
+        jpge::uint get_size() const override { return (jpge::uint)out->size(); }
+    };
+
+    jpge::params m_params;
+    jpge::jpeg_encoder m_encoder;
+    vector_stream m_stream;
+    std::vector<uint8_t> m_scanline; // one row in the R, G, B order jpge takes
+};
+
+} // namespace edge
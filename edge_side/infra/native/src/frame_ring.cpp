@@ -0,0 +1,455 @@
+#include "frame_ring.h"
+
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <memory>
+#include <new>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace edge {
+
+namespace {
+
+const uint32_t MAGIC = 0x45524e47; // set last by create()
+const uint32_t VERSION = 1;
+const uint64_t NO_CURSOR = UINT64_MAX;
+const uint32_t REAPING = UINT32_MAX;
+
+size_t round_up(size_t n, size_t to)
+{
+    return (n + to - 1) / to * to;
+}
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "the ring needs address-free 64-bit atomics");
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex words are plain 32-bit integers");
+
+void futex_wait(std::atomic<uint32_t> *word, uint32_t expected, std::chrono::microseconds timeout)
+{
+    struct timespec ts;
+    ts.tv_sec = (time_t)(timeout.count() / 1000000);
+    ts.tv_nsec = (long)(timeout.count() % 1000000) * 1000;
+    // not FUTEX_PRIVATE_FLAG: the word is shared between processes
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAIT, expected, &ts, nullptr, 0);
+}
+
+void futex_wake(std::atomic<uint32_t> *word)
+{
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+} // namespace
+
+// A reliable reader; pid 0 marks a free entry
+struct frame_ring::reader_entry {
+    alignas(64) std::atomic<uint32_t> pid;
+    std::atomic<uint64_t> cursor; // oldest frame still in use, NO_CURSOR for none
+};
+
+// Start of the shared memory. Fields before magic are written once by the
+// creator, before it publishes magic.
+struct frame_ring::header {
+    std::atomic<uint32_t> magic;
+    uint32_t version;
+    uint32_t slots;
+    uint64_t slot_size, stride, offset;
+    alignas(64) std::atomic<uint64_t> claimed;
+    alignas(64) std::atomic<uint32_t> notify; // futex word, bumped by every publish()
+    std::atomic<uint32_t> waiters;
+    reader_entry readers[MAX_READERS];
+};
+
+// Start of each slot; the data follows at the next cache line
+struct frame_ring::slot_header {
+    std::atomic<uint64_t> sequence; // 2n + 1 while frame n is written, 2n + 2 once published
+    frame_info info;
+};
+
+frame_ring::~frame_ring()
+{
+    close();
+}
+
+bool frame_ring::create(const std::string &name, uint32_t slots, size_t slot_size)
+{
+    close();
+    if (slots == 0 || slots > (1u << 20) || slot_size == 0) {
+        fprintf(stderr, "[Ring] Bad ring of %u slots of %zu bytes\n", slots, slot_size);
+        return false;
+    }
+    uint32_t n = 2;
+    while (n < slots)
+        n <<= 1;
+    size_t stride = round_up(sizeof(slot_header), 64) + round_up(slot_size, 64);
+    size_t offset = round_up(sizeof(header), 64);
+    size_t size = offset + stride * n;
+
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        fprintf(stderr, "[Ring] Cannot create %s: %s\n", name.c_str(), strerror(errno));
+        return false;
+    }
+    if (ftruncate(fd, (off_t)size) != 0) {
+        fprintf(stderr, "[Ring] Cannot size %s to %zu bytes: %s\n", name.c_str(), size, strerror(errno));
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+    bool mapped = map(fd, size);
+    ::close(fd);
+    if (!mapped) {
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    // ftruncate() zero-filled everything: every slot's sequence is 0
+    header *h = new (m_header) header();
+    h->version = VERSION;
+    h->slots = n;
+    h->slot_size = slot_size;
+    h->stride = stride;
+    h->offset = offset;
+    for (reader_entry &r : h->readers)
+        r.cursor.store(NO_CURSOR, std::memory_order_relaxed);
+    h->magic.store(MAGIC, std::memory_order_release);
+
+    m_name = name;
+    m_owner = true;
+    m_mask = n - 1;
+    m_slot_size = slot_size;
+    m_stride = stride;
+    m_slots = reinterpret_cast<uint8_t *>(m_header) + offset;
+    return true;
+}
+
+bool frame_ring::open(const std::string &name)
+{
+    close();
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        fprintf(stderr, "[Ring] Cannot open %s: %s\n", name.c_str(), strerror(errno));
+        return false;
+    }
+    struct stat st;
+    bool mapped = fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(header) && map(fd, (size_t)st.st_size);
+    ::close(fd);
+    if (!mapped) {
+        fprintf(stderr, "[Ring] %s is not a frame ring\n", name.c_str());
+        return false;
+    }
+
+    const header *h = m_header;
+    if (h->magic.load(std::memory_order_acquire) != MAGIC || h->version != VERSION || h->slots < 2 ||
+        (h->slots & (h->slots - 1)) || h->offset < sizeof(header) ||
+        h->stride < sizeof(slot_header) + h->slot_size || h->offset + h->stride * h->slots != m_size) {
+        fprintf(stderr, "[Ring] %s is not a frame ring, or not one of this version\n", name.c_str());
+        close();
+        return false;
+    }
+    m_name = name;
+    m_mask = h->slots - 1;
+    m_slot_size = h->slot_size;
+    m_stride = h->stride;
+    m_slots = reinterpret_cast<uint8_t *>(m_header) + h->offset;
+    return true;
+}
+
+bool frame_ring::map(int fd, size_t size)
+{
+    void *p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        fprintf(stderr, "[Ring] Cannot map %zu bytes: %s\n", size, strerror(errno));
+        return false;
+    }
+    m_header = static_cast<header *>(p);
+    m_size = size;
+    return true;
+}
+
+void frame_ring::close()
+{
+    if (m_header)
+        munmap(m_header, m_size);
+    if (m_owner)
+        shm_unlink(m_name.c_str());
+    m_header = nullptr;
+    m_size = 0;
+    m_owner = false;
+    m_name.clear();
+    m_mask = 0;
+    m_slot_size = m_stride = 0;
+    m_slots = nullptr;
+}
+
+bool frame_ring::remove(const std::string &name)
+{
+    return shm_unlink(name.c_str()) == 0;
+}
+
+uint64_t frame_ring::written() const
+{
+    return m_header ? m_header->claimed.load(std::memory_order_relaxed) : 0;
+}
+
+frame_ring::slot_header *frame_ring::slot_at(uint64_t sequence) const
+{
+    return reinterpret_cast<slot_header *>(m_slots + (sequence & m_mask) * m_stride);
+}
+
+uint8_t *frame_ring::slot_data(slot_header *slot)
+{
+    return reinterpret_cast<uint8_t *>(slot) + round_up(sizeof(slot_header), 64);
+}
+
+bool frame_ring::try_claim(ring_slot &slot)
+{
+    if (!m_header)
+        return false;
+    header *h = m_header;
+    uint64_t slots = m_mask + 1;
+    uint64_t n = h->claimed.load(std::memory_order_relaxed);
+    bool reaped = false;
+    for (;;) {
+        slot_header *s = slot_at(n);
+        // the frame a lap back must be published before its slot is reused
+        uint64_t expected = n >= slots ? 2 * (n - slots) + 2 : 0;
+        if (s->sequence.load(std::memory_order_acquire) != expected) {
+            uint64_t now = h->claimed.load(std::memory_order_relaxed);
+            if (now == n)
+                return false;
+            n = now;
+            continue;
+        }
+        if (n >= slots) {
+            bool free = true;
+            for (reader_entry &r : h->readers)
+                if (r.pid.load(std::memory_order_relaxed) && r.cursor.load(std::memory_order_acquire) <= n - slots)
+                    free = false;
+            if (!free) {
+                if (reaped)
+                    return false;
+                reap_readers();
+                reaped = true;
+                continue;
+            }
+        }
+        if (h->claimed.compare_exchange_weak(n, n + 1, std::memory_order_relaxed)) {
+            s->sequence.store(2 * n + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            slot.sequence = n;
+            slot.info = &s->info;
+            slot.data = slot_data(s);
+            return true;
+        }
+    }
+}
+
+void frame_ring::publish(const ring_slot &slot)
+{
+    header *h = m_header;
+    slot_at(slot.sequence)->sequence.store(2 * slot.sequence + 2, std::memory_order_release);
+    // seq_cst pairs with the waiters increment in ring_reader::read(): either
+    // the reader sees the new notify value or this sees its waiter
+    h->notify.fetch_add(1, std::memory_order_seq_cst);
+    if (h->waiters.load(std::memory_order_seq_cst))
+        futex_wake(&h->notify);
+}
+
+bool frame_ring::try_write(const frame_info &info, const void *data)
+{
+    ring_slot slot;
+    if (info.size > m_slot_size || !try_claim(slot))
+        return false;
+    *slot.info = info;
+    if (info.size)
+        memcpy(slot.data, data, info.size);
+    publish(slot);
+    return true;
+}
+
+void frame_ring::reap_readers()
+{
+    for (reader_entry &r : m_header->readers) {
+        uint32_t pid = r.pid.load(std::memory_order_relaxed);
+        if (!pid || pid == REAPING || kill((pid_t)pid, 0) == 0 || errno != ESRCH)
+            continue;
+        // only the writer that wins the entry clears it
+        if (r.pid.compare_exchange_strong(pid, REAPING, std::memory_order_acquire)) {
+            fprintf(stderr, "[Ring] Dropped reader %d of %s, its process is gone\n", (int)pid, m_name.c_str());
+            r.cursor.store(NO_CURSOR, std::memory_order_relaxed);
+            r.pid.store(0, std::memory_order_release);
+        }
+    }
+}
+
+ring_reader::ring_reader(frame_ring &ring, bool reliable) : m_ring(ring), m_reliable(reliable)
+{
+    if (!ring.m_header)
+        return;
+    m_next = ring.m_header->claimed.load(std::memory_order_acquire);
+    if (!reliable)
+        return;
+    for (int i = 0; i < frame_ring::MAX_READERS; i++) {
+        uint32_t free = 0;
+        if (ring.m_header->readers[i].pid.compare_exchange_strong(free, (uint32_t)getpid())) {
+            m_entry = i;
+            set_cursor(m_next);
+            return;
+        }
+    }
+    fprintf(stderr, "[Ring] %s already has %d reliable readers\n", ring.m_name.c_str(), frame_ring::MAX_READERS);
+}
+
+ring_reader::~ring_reader()
+{
+    if (m_entry < 0 || !m_ring.m_header)
+        return;
+    frame_ring::reader_entry &r = m_ring.m_header->readers[m_entry];
+    r.cursor.store(NO_CURSOR, std::memory_order_release);
+    r.pid.store(0, std::memory_order_release);
+}
+
+void ring_reader::set_cursor(uint64_t sequence)
+{
+    if (m_entry >= 0)
+        m_ring.m_header->readers[m_entry].cursor.store(sequence, std::memory_order_release);
+}
+
+bool ring_reader::next(ring_view &view, std::chrono::microseconds timeout)
+{
+    return read(view, timeout);
+}
+
+bool ring_reader::latest(ring_view &view, std::chrono::microseconds timeout)
+{
+    if (m_ring.m_header) {
+        uint64_t claimed = m_ring.m_header->claimed.load(std::memory_order_acquire);
+        if (claimed > m_next + 1)
+            m_next = claimed - 1;
+    }
+    return read(view, timeout);
+}
+
+bool ring_reader::read(ring_view &view, std::chrono::microseconds timeout)
+{
+    frame_ring::header *h = m_ring.m_header;
+    if (!h || !attached())
+        return false;
+    uint64_t slots = m_ring.m_mask + 1;
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    // everything before m_next is given back
+    set_cursor(m_next);
+    for (;;) {
+        uint32_t ticket = h->notify.load(std::memory_order_seq_cst);
+        uint64_t claimed = h->claimed.load(std::memory_order_acquire);
+        if (claimed > m_next + slots) {
+            m_skipped += claimed - slots - m_next;
+            m_next = claimed - slots;
+            set_cursor(m_next);
+        }
+
+        frame_ring::slot_header *s = m_ring.slot_at(m_next);
+        uint64_t published = 2 * m_next + 2;
+        uint64_t sequence = s->sequence.load(std::memory_order_acquire);
+        if (sequence == published) {
+            view.sequence = m_next;
+            view.info = s->info;
+            view.data = frame_ring::slot_data(s);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (s->sequence.load(std::memory_order_relaxed) == published) {
+                m_next++;
+                return true;
+            }
+            continue; // overwritten while copying the info
+        }
+        if (sequence > published) {
+            // lapped: a later frame is (being) written over it
+            m_skipped++;
+            m_next++;
+            set_cursor(m_next);
+            continue;
+        }
+
+        auto left = std::chrono::duration_cast<std::chrono::microseconds>(deadline - std::chrono::steady_clock::now());
+        if (left.count() <= 0)
+            return false;
+        h->waiters.fetch_add(1, std::memory_order_seq_cst);
+        // returns at once if a publish() bumped notify since ticket was read
+        futex_wait(&h->notify, ticket, left);
+        h->waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+bool ring_reader::valid(const ring_view &view) const
+{
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return m_ring.slot_at(view.sequence)->sequence.load(std::memory_order_relaxed) == 2 * view.sequence + 2;
+}
+
+} // namespace edge
+
+extern "C" edge::frame_ring *edge_ring_create(const char *name, uint32_t slots, size_t slot_size)
+{
+    std::unique_ptr<edge::frame_ring> ring(new edge::frame_ring());
+    return name && ring->create(name, slots, slot_size) ? ring.release() : nullptr;
+}
+
+extern "C" edge::frame_ring *edge_ring_open(const char *name)
+{
+    std::unique_ptr<edge::frame_ring> ring(new edge::frame_ring());
+    return name && ring->open(name) ? ring.release() : nullptr;
+}
+
+extern "C" void edge_ring_close(edge::frame_ring *ring)
+{
+    delete ring;
+}
+
+extern "C" int edge_ring_write(edge::frame_ring *ring, const edge::frame_info *info, const void *data)
+{
+    return ring && info && (data || !info->size) && ring->try_write(*info, data);
+}
+
+// Null for a reliable reader when the ring has no free entry
+extern "C" edge::ring_reader *edge_ring_reader(edge::frame_ring *ring, int reliable)
+{
+    if (!ring || !ring->is_open())
+        return nullptr;
+    std::unique_ptr<edge::ring_reader> reader(new edge::ring_reader(*ring, reliable != 0));
+    return reader->attached() ? reader.release() : nullptr;
+}
+
+extern "C" void edge_ring_reader_close(edge::ring_reader *reader)
+{
+    delete reader;
+}
+
+// 1 with the frame's number, info and data, 0 on timeout
+extern "C" int edge_ring_next(edge::ring_reader *reader, int latest, int64_t timeout_us, uint64_t *sequence,
+                              edge::frame_info *info, const uint8_t **data)
+{
+    edge::ring_view view;
+    std::chrono::microseconds timeout(timeout_us > 0 ? timeout_us : 0);
+    if (!reader || !(latest ? reader->latest(view, timeout) : reader->next(view, timeout)))
+        return 0;
+    *sequence = view.sequence;
+    *info = view.info;
+    *data = view.data;
+    return 1;
+}
+
+extern "C" int edge_ring_valid(edge::ring_reader *reader, uint64_t sequence)
+{
+    edge::ring_view view;
+    view.sequence = sequence;
+    return reader && reader->valid(view);
+}
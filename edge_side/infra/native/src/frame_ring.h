@@ -0,0 +1,151 @@
+// Frames shared between processes through a POSIX shared-memory ring.
+//
+// The ring is a fixed number of fixed-size slots in one shm_open() object.
+// Frames are numbered; frame n lives in slot n % slots. Writers claim the
+// next number with one CAS on a shared index, fill the slot in place and
+// publish it by bumping the slot's sequence, so ingest can decode straight
+// into shared memory and no frame is ever copied between processes.
+//
+// Each slot's sequence doubles as a seqlock: it is odd while the slot is
+// being written and 2n + 2 once frame n is in it. Readers follow the ring on
+// their own cursor and never block a writer. A reader that falls a whole ring
+// behind skips to the oldest frame still there, and valid() tells it whether
+// the frame it was looking at was overwritten meanwhile. A reliable reader
+// (say, a recorder) instead holds writers back: its cursor is kept in the
+// shared header, and try_claim() fails rather than overwrite a frame it has
+// not finished. Reliable readers whose process died are dropped; a writer
+// that dies between try_claim() and publish() stalls the ring until it is
+// created again.
+//
+// Idle readers sleep on a futex in the shared header; a writer only makes
+// the wake-up system call when someone is waiting.
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace edge {
+
+enum frame_format : uint32_t {
+    FRAME_BGR = 0,  // width x height x 3, as decoded
+    FRAME_JPEG = 1, // as the camera sent it
+};
+
+// Stored in front of every frame
+struct frame_info {
+    uint64_t timestamp_us = 0; // steady clock, which all processes share
+    uint32_t camera = 0;
+    uint32_t format = FRAME_BGR;
+    uint32_t width = 0, height = 0;
+    uint32_t size = 0;         // bytes of data used
+};
+
+// A claimed slot to write one frame into
+struct ring_slot {
+    uint64_t sequence = 0;
+    frame_info *info = nullptr;
+    uint8_t *data = nullptr;
+};
+
+// A frame as a reader sees it: info copied out, data still in the ring
+struct ring_view {
+    uint64_t sequence = 0;
+    frame_info info;
+    const uint8_t *data = nullptr;
+};
+
+class frame_ring {
+public:
+    static const int MAX_READERS = 16;
+
+    frame_ring() = default;
+    ~frame_ring();
+
+    frame_ring(const frame_ring &) = delete;
+    frame_ring &operator=(const frame_ring &) = delete;
+
+    // Creates the shared memory object name ("/edge_frames"), replacing any
+    // old one. slots is rounded up to a power of two. The creator unlinks the
+    // object again when closed or destroyed.
+    bool create(const std::string &name, uint32_t slots, size_t slot_size);
+    // Maps a ring another process created
+    bool open(const std::string &name);
+    void close();
+    static bool remove(const std::string &name);
+
+    bool is_open() const { return m_header != nullptr; }
+    uint32_t slots() const { return (uint32_t)(m_mask + 1); }
+    size_t slot_size() const { return m_slot_size; }
+    // Frames claimed so far
+    uint64_t written() const;
+
+    // Writing, from any number of threads and processes. False when the
+    // slot to claim still holds a frame a reliable reader has not finished,
+    // or one another writer is still filling.
+    bool try_claim(ring_slot &slot);
+    void publish(const ring_slot &slot);
+    // try_claim(), copy, publish(); also false if info.size > slot_size()
+    bool try_write(const frame_info &info, const void *data);
+
+private:
+    friend class ring_reader;
+    struct header;
+    struct slot_header;
+    struct reader_entry;
+
+    bool map(int fd, size_t size);
+    slot_header *slot_at(uint64_t sequence) const;
+    static uint8_t *slot_data(slot_header *slot);
+    // Frees the entries of reliable readers whose process has gone
+    void reap_readers();
+
+    std::string m_name;
+    bool m_owner = false;
+    header *m_header = nullptr;
+    size_t m_size = 0;
+    // copies of the header's layout
+    uint64_t m_mask = 0;
+    size_t m_slot_size = 0, m_stride = 0;
+    uint8_t *m_slots = nullptr;
+};
+
+class ring_reader {
+public:
+    // Reads frames published from now on. A reliable reader is never
+    // overwritten; a lossy one skips what it was too slow for.
+    explicit ring_reader(frame_ring &ring, bool reliable = false);
+    ~ring_reader();
+
+    ring_reader(const ring_reader &) = delete;
+    ring_reader &operator=(const ring_reader &) = delete;
+
+    // False when a reliable reader found no free entry in the ring
+    bool attached() const { return m_entry >= 0 || !m_reliable; }
+
+    // The frame after the previous one, which is given back. False if none
+    // was published within timeout.
+    bool next(ring_view &view, std::chrono::microseconds timeout);
+    // The newest frame, skipping any backlog
+    bool latest(ring_view &view, std::chrono::microseconds timeout);
+    // True if the frame's slot has not been reused since next() returned it.
+    // Always true for reliable readers; call it after using the data.
+    bool valid(const ring_view &view) const;
+
+    // Frames that were overwritten before this reader got to them
+    uint64_t skipped() const { return m_skipped; }
+
+private:
+    bool read(ring_view &view, std::chrono::microseconds timeout);
+    void set_cursor(uint64_t sequence);
+
+    frame_ring &m_ring;
+    bool m_reliable;
+    int m_entry = -1;
+    uint64_t m_next = 0;
+    uint64_t m_skipped = 0;
+};
+
+} // namespace edge
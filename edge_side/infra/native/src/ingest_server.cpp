@@ -0,0 +1,472 @@
+#include "ingest_server.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "ws_protocol.h"
+
+namespace edge {
+
+namespace {
+
+using clock = std::chrono::steady_clock;
+
+const size_t READ_CHUNK = 64 * 1024;
+const int READS_PER_EVENT = 4; // then let the other cameras have a turn
+
+uint64_t elapsed_us(clock::time_point from, clock::time_point to)
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(to - from).count();
+}
+
+} // namespace
+
+struct ingest_server::connection {
+    int fd;
+    bool upgraded = false;
+    bool closing = false;       // close once the output is flushed
+    bool dead = false;          // closed, freed after the current event
+    bool want_write = false;
+    std::string request;        // handshake bytes until the upgrade completes
+    ws::frame_parser parser;
+    std::vector<uint8_t> out;
+    size_t out_pos = 0;
+    uint64_t sequence = 0;
+    std::shared_ptr<camera_stats> stats;
+
+    connection(int fd, size_t max_message)
+        : fd(fd), parser(max_message)
+    {
+    }
+};
+
+ingest_server::ingest_server(const ingest_config &config)
+    : m_config(config),
+      m_decode_queue(config.decode_queue),
+      m_ready_queue(config.ready_queue)
+{
+}
+
+ingest_server::~ingest_server()
+{
+    stop();
+}
+
+bool ingest_server::start()
+{
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(m_config.port);
+    if (inet_pton(AF_INET, m_config.host.c_str(), &addr.sin_addr) != 1) {
+        fprintf(stderr, "[Ingest] Bad listen address %s\n", m_config.host.c_str());
+        return false;
+    }
+
+    m_listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int one = 1;
+    setsockopt(m_listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (m_listen_fd < 0 || bind(m_listen_fd, (sockaddr *)&addr, sizeof(addr)) != 0 || listen(m_listen_fd, 128) != 0) {
+        fprintf(stderr, "[Ingest] Cannot listen on %s:%u: %s\n", m_config.host.c_str(), m_config.port, strerror(errno));
+        stop();
+        return false;
+    }
+    socklen_t addr_len = sizeof(addr);
+    getsockname(m_listen_fd, (sockaddr *)&addr, &addr_len);
+    m_port = ntohs(addr.sin_port);
+
+    m_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    m_wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = m_listen_fd;
+    epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_listen_fd, &ev);
+    ev.data.fd = m_wake_fd;
+    epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_wake_fd, &ev);
+
+    m_last_report = clock::now();
+    m_running = true;
+    m_io_thread = std::thread(&ingest_server::io_loop, this);
+    for (int i = 0; i < m_config.decode_threads; i++)
+        m_decode_threads.emplace_back(&ingest_server::decode_loop, this);
+    return true;
+}
+
+void ingest_server::stop()
+{
+    if (m_running.exchange(false)) {
+        uint64_t one = 1;
+        if (write(m_wake_fd, &one, sizeof(one)) < 0)
+            perror("[Ingest] wake");
+        m_decode_ready.post((int)m_decode_threads.size());
+        m_io_thread.join();
+        for (auto &t : m_decode_threads)
+            t.join();
+        m_decode_threads.clear();
+    }
+    for (int *fd : {&m_listen_fd, &m_epoll_fd, &m_wake_fd}) {
+        if (*fd >= 0)
+            close(*fd);
+        *fd = -1;
+    }
+}
+
+void ingest_server::io_loop()
+{
+    epoll_event events[64];
+    while (m_running) {
+        int n = epoll_wait(m_epoll_fd, events, 64, -1);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("[Ingest] epoll_wait");
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            int fd = events[i].data.fd;
+            if (fd == m_listen_fd) {
+                accept_all();
+                continue;
+            }
+            if (fd == m_wake_fd)
+                continue;
+            if (fd >= (int)m_connections.size() || !m_connections[fd])
+                continue;
+
+            connection &c = *m_connections[fd];
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+                on_readable(c);
+            if (!c.dead && (events[i].events & EPOLLOUT))
+                on_writable(c);
+            if (c.dead)
+                m_connections[fd].reset();
+        }
+    }
+
+    for (auto &c : m_connections) {
+        if (c) {
+            close_connection(c->fd);
+            c.reset();
+        }
+    }
+}
+
+void ingest_server::accept_all()
+{
+    for (;;) {
+        sockaddr_in addr;
+        socklen_t len = sizeof(addr);
+        int fd = accept4(m_listen_fd, (sockaddr *)&addr, &len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                perror("[Ingest] accept");
+            return;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        if (fd >= (int)m_connections.size())
+            m_connections.resize(fd + 1);
+        m_connections[fd].reset(new connection(fd, m_config.max_message));
+        auto stats = std::make_shared<camera_stats>();
+        char ip[INET_ADDRSTRLEN] = "?";
+        inet_ntop(AF_INET, &addr.sin_addr, ip, sizeof(ip));
+        stats->peer = std::string(ip) + ":" + std::to_string(ntohs(addr.sin_port));
+        m_connections[fd]->stats = stats;
+
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+    }
+}
+
+void ingest_server::on_readable(connection &c)
+{
+    static thread_local std::vector<uint8_t> buf(READ_CHUNK);
+
+    for (int round = 0; round < READS_PER_EVENT; round++) {
+        ssize_t n = recv(c.fd, buf.data(), buf.size(), 0);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            close_connection(c.fd);
+            return;
+        }
+        if (n < 0)
+            return;
+
+        const uint8_t *p = buf.data();
+        size_t left = (size_t)n;
+        std::string rest;
+        if (!c.upgraded) {
+            std::string key, path;
+            c.request.append((const char *)p, left);
+            int used = ws::parse_upgrade(c.request.data(), c.request.size(), key, path);
+            if (used < 0) {
+                static const char bad[] = "HTTP/1.1 400 Bad Request\r\nConnection: close\r\n\r\n";
+                c.out.insert(c.out.end(), bad, bad + sizeof(bad) - 1);
+                c.closing = true;
+                flush(c);
+                return;
+            }
+            if (used == 0)
+                continue;
+
+            c.upgraded = true;
+            c.stats->path = path;
+            {
+                std::lock_guard<std::mutex> lock(m_stats_mutex);
+                c.stats->camera = m_next_camera++;
+                m_cameras.push_back(c.stats);
+            }
+            std::string response = ws::upgrade_response(key);
+            c.out.insert(c.out.end(), response.begin(), response.end());
+            if (!m_config.greeting.empty())
+                ws::append_frame(c.out, ws::OP_FIN | ws::OP_TEXT, m_config.greeting.data(), m_config.greeting.size());
+            flush(c);
+            if (c.dead)
+                return;
+
+            rest = c.request.substr(used);
+            c.request.clear();
+            c.request.shrink_to_fit();
+            p = (const uint8_t *)rest.data();
+            left = rest.size();
+        }
+
+        while (left) {
+            size_t used = 0;
+            ws::frame_parser::result r = c.parser.feed(p, left, used);
+            p += used;
+            left -= used;
+            if (r == ws::frame_parser::MESSAGE) {
+                if (!handle_message(c))
+                    return;
+            } else if (r != ws::frame_parser::NEED_MORE) {
+                uint16_t code = r == ws::frame_parser::ERROR_TOO_BIG ? ws::CLOSE_TOO_BIG : ws::CLOSE_PROTOCOL;
+                uint8_t payload[2] = {(uint8_t)(code >> 8), (uint8_t)code};
+                c.closing = true;
+                send_frame(c, ws::OP_FIN | ws::OP_CLOSE, payload, sizeof(payload));
+                return;
+            }
+        }
+        if ((size_t)n < buf.size())
+            return;
+    }
+}
+
+bool ingest_server::handle_message(connection &c)
+{
+    const std::vector<uint8_t> &payload = c.parser.payload();
+    switch (c.parser.opcode()) {
+    case ws::OP_BINARY: {
+        frame_ptr f(new frame);
+        f->camera = c.stats->camera;
+        f->sequence = c.sequence++;
+        f->received = clock::now();
+        f->stats = c.stats;
+        f->jpeg = c.parser.take_payload();
+        c.stats->received.fetch_add(1, std::memory_order_relaxed);
+        c.stats->bytes.fetch_add(f->jpeg.size(), std::memory_order_relaxed);
+        // workers that fall behind decode the newest frames: drop the oldest queued one
+        while (!m_decode_queue.try_push(std::move(f))) {
+            frame_ptr stale;
+            if (m_decode_queue.try_pop(stale))
+                stale->stats->dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        m_decode_ready.post();
+        break;
+    }
+    case ws::OP_TEXT:
+        if (m_config.on_text)
+            m_config.on_text(c.stats->camera, std::string(payload.begin(), payload.end()));
+        break;
+    case ws::OP_PING:
+        send_frame(c, ws::OP_FIN | ws::OP_PONG, payload.data(), payload.size());
+        break;
+    case ws::OP_CLOSE:
+        // echo the status code and hang up
+        c.closing = true;
+        send_frame(c, ws::OP_FIN | ws::OP_CLOSE, payload.data(), payload.size() < 2 ? payload.size() : 2);
+        return false;
+    default:
+        break;
+    }
+    return !c.dead;
+}
+
+void ingest_server::send_frame(connection &c, uint8_t opcode, const void *data, size_t len)
+{
+    ws::append_frame(c.out, opcode, data, len);
+    flush(c);
+}
+
+void ingest_server::on_writable(connection &c)
+{
+    flush(c);
+}
+
+void ingest_server::flush(connection &c)
+{
+    while (c.out_pos < c.out.size()) {
+        ssize_t n = send(c.fd, c.out.data() + c.out_pos, c.out.size() - c.out_pos, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                if (!c.want_write) {
+                    epoll_event ev = {};
+                    ev.events = EPOLLIN | EPOLLOUT;
+                    ev.data.fd = c.fd;
+                    epoll_ctl(m_epoll_fd, EPOLL_CTL_MOD, c.fd, &ev);
+                    c.want_write = true;
+                }
+                return;
+            }
+            close_connection(c.fd);
+            return;
+        }
+        c.out_pos += (size_t)n;
+    }
+    c.out.clear();
+    c.out_pos = 0;
+    if (c.want_write) {
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.fd = c.fd;
+        epoll_ctl(m_epoll_fd, EPOLL_CTL_MOD, c.fd, &ev);
+        c.want_write = false;
+    }
+    if (c.closing)
+        close_connection(c.fd);
+}
+
+void ingest_server::close_connection(int fd)
+{
+    connection &c = *m_connections[fd];
+    if (c.dead)
+        return;
+    epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    c.dead = true;
+    c.stats->connected = false;
+}
+
+void ingest_server::decode_loop()
+{
+    frame_decoder decoder;
+    while (m_running) {
+        frame_ptr f;
+        if (!m_decode_queue.try_pop(f)) {
+            m_decode_ready.wait_for(std::chrono::milliseconds(100));
+            continue;
+        }
+
+        camera_stats &stats = *f->stats;
+        if (!decoder.decode(f->jpeg.data(), f->jpeg.size(), f->image, m_config.decode_scale)) {
+            stats.errors.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        f->decoded = clock::now();
+        stats.decoded.fetch_add(1, std::memory_order_relaxed);
+        stats.decode_latency.record(elapsed_us(f->received, f->decoded));
+
+        // keep the freshest frames: make room by dropping the oldest one
+        while (!m_ready_queue.try_push(std::move(f))) {
+            frame_ptr stale;
+            if (m_ready_queue.try_pop(stale))
+                stale->stats->dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        m_frame_ready.post();
+    }
+}
+
+bool ingest_server::next_frame(frame_ptr &out, std::chrono::microseconds timeout)
+{
+    clock::time_point deadline = clock::now() + timeout;
+    for (;;) {
+        if (m_ready_queue.try_pop(out)) {
+            camera_stats &stats = *out->stats;
+            stats.delivered.fetch_add(1, std::memory_order_relaxed);
+            stats.deliver_latency.record(elapsed_us(out->received, clock::now()));
+            return true;
+        }
+        clock::time_point now = clock::now();
+        if (now >= deadline)
+            return false;
+        m_frame_ready.wait_for(std::chrono::duration_cast<std::chrono::microseconds>(deadline - now));
+    }
+}
+
+std::vector<camera_report> ingest_server::report()
+{
+    std::lock_guard<std::mutex> lock(m_stats_mutex);
+    clock::time_point now = clock::now();
+    double seconds = std::chrono::duration<double>(now - m_last_report).count();
+    m_last_report = now;
+
+    std::vector<camera_report> reports;
+    for (size_t i = 0; i < m_cameras.size();) {
+        camera_stats &s = *m_cameras[i];
+        camera_report r;
+        r.camera = s.camera;
+        r.peer = s.peer;
+        r.path = s.path;
+        r.connected = s.connected;
+        r.seconds = seconds;
+
+        uint64_t received = s.received, decoded = s.decoded, delivered = s.delivered;
+        uint64_t dropped = s.dropped, errors = s.errors;
+        r.received = received - s.last_received;
+        r.decoded = decoded - s.last_decoded;
+        r.delivered = delivered - s.last_delivered;
+        r.dropped = dropped - s.last_dropped;
+        r.errors = errors - s.last_errors;
+        s.last_received = received;
+        s.last_decoded = decoded;
+        s.last_delivered = delivered;
+        s.last_dropped = dropped;
+        s.last_errors = errors;
+
+        r.fps_in = seconds > 0 ? r.received / seconds : 0;
+        r.fps_out = seconds > 0 ? r.delivered / seconds : 0;
+        r.decode_p50_us = s.decode_latency.percentile(50);
+        r.decode_p99_us = s.decode_latency.percentile(99);
+        r.deliver_p50_us = s.deliver_latency.percentile(50);
+        r.deliver_p99_us = s.deliver_latency.percentile(99);
+        s.decode_latency.reset();
+        s.deliver_latency.reset();
+        reports.push_back(r);
+
+        if (!r.connected)
+            m_cameras.erase(m_cameras.begin() + i);
+        else
+            i++;
+    }
+    return reports;
+}
+
+std::string ingest_server::format_report(const std::vector<camera_report> &reports)
+{
+    std::string out;
+    char line[256];
+    snprintf(line, sizeof(line), "%-6s %-21s %8s %8s %6s %5s %18s %18s\n", "camera", "peer", "in fps", "out fps",
+             "drop", "err", "decode p50/p99 ms", "deliver p50/p99 ms");
+    out += line;
+    for (const camera_report &r : reports) {
+        snprintf(line, sizeof(line), "%-6u %-21s %8.2f %8.2f %6llu %5llu %8.2f / %7.2f %8.2f / %7.2f%s\n", r.camera,
+                 r.peer.c_str(), r.fps_in, r.fps_out, (unsigned long long)r.dropped, (unsigned long long)r.errors,
+                 r.decode_p50_us / 1000.0, r.decode_p99_us / 1000.0, r.deliver_p50_us / 1000.0,
+                 r.deliver_p99_us / 1000.0, r.connected ? "" : "  (disconnected)");
+        out += line;
+    }
+    return out;
+}
+
+} // namespace edge
@@ -0,0 +1,141 @@
+// Native ingest server for the ESP32 camera WebSocket streams.
+//
+// One I/O thread multiplexes every camera connection with epoll and only
+// parses frames; JPEG messages go through a lock-free queue to a pool of
+// decode workers, and decoded frames through a second queue to whoever runs
+// inference. A slow consumer therefore never stalls the sockets: when a queue
+// is full the stalest frame is dropped and counted against its camera.
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "frame_decoder.h"
+#include "mpmc_queue.h"
+#include "stats.h"
+
+namespace edge {
+
+// Counters of one camera connection, shared by the threads handling its frames
+struct camera_stats {
+    uint32_t camera = 0;
+    std::string peer;
+    std::string path;
+    std::atomic<bool> connected{true};
+
+    std::atomic<uint64_t> received{0};  // binary messages read off the socket
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> decoded{0};
+    std::atomic<uint64_t> delivered{0}; // handed out by next_frame()
+    std::atomic<uint64_t> dropped{0};   // queue overflow
+    std::atomic<uint64_t> errors{0};    // undecodable JPEG
+
+    latency_histogram decode_latency;   // received -> decoded, includes queueing
+    latency_histogram deliver_latency;  // received -> next_frame()
+
+    // values at the previous report, only touched by report()
+    uint64_t last_received = 0, last_decoded = 0, last_delivered = 0, last_dropped = 0, last_errors = 0;
+};
+
+struct frame {
+    uint32_t camera = 0;
+    uint64_t sequence = 0; // per camera, counts every received message
+    std::chrono::steady_clock::time_point received;
+    std::chrono::steady_clock::time_point decoded;
+    std::vector<uint8_t> jpeg;
+    bgr_image image;
+    std::shared_ptr<camera_stats> stats;
+};
+
+using frame_ptr = std::unique_ptr<frame>;
+
+struct ingest_config {
+    std::string host = "0.0.0.0";
+    uint16_t port = 8080;           // 0 picks a free port, see ingest_server::port()
+    int decode_threads = 2;
+    size_t decode_queue = 64;
+    size_t ready_queue = 16;
+    size_t max_message = 4 << 20;
+    uint8_t decode_scale = 0;       // decode at 1 / (1 << scale) of the camera resolution
+    // Sent to every camera as it connects, same as DEFAULT_CAMERA_SETTINGS in ws_server.py
+    std::string greeting = "{\"brightness\": 1, \"contrast\": 1, \"saturation\": 1, \"quality\": 8}";
+    // Text messages from the cameras (command replies), called on the I/O thread
+    std::function<void(uint32_t camera, const std::string &text)> on_text;
+};
+
+struct camera_report {
+    uint32_t camera;
+    std::string peer;
+    std::string path;
+    bool connected;
+    double seconds;
+    uint64_t received, decoded, delivered, dropped, errors;
+    double fps_in, fps_out;
+    uint64_t decode_p50_us, decode_p99_us;
+    uint64_t deliver_p50_us, deliver_p99_us;
+};
+
+class ingest_server {
+public:
+    explicit ingest_server(const ingest_config &config);
+    ~ingest_server();
+
+    ingest_server(const ingest_server &) = delete;
+    ingest_server &operator=(const ingest_server &) = delete;
+
+    // Binds, listens and starts the I/O and decode threads
+    bool start();
+    void stop();
+    uint16_t port() const { return m_port; }
+
+    // Next decoded frame, oldest first. False if none arrived within timeout.
+    bool next_frame(frame_ptr &out, std::chrono::microseconds timeout);
+
+    // Per-camera rates and latency percentiles since the previous call.
+    // Cameras that disconnected are reported once more, then forgotten.
+    std::vector<camera_report> report();
+    static std::string format_report(const std::vector<camera_report> &reports);
+
+private:
+    struct connection;
+
+    void io_loop();
+    void decode_loop();
+    void accept_all();
+    void on_readable(connection &c);
+    void on_writable(connection &c);
+    bool handle_message(connection &c);
+    void send_frame(connection &c, uint8_t opcode, const void *data, size_t len);
+    void flush(connection &c);
+    void close_connection(int fd);
+
+    ingest_config m_config;
+    uint16_t m_port = 0;
+    int m_listen_fd = -1;
+    int m_epoll_fd = -1;
+    int m_wake_fd = -1;
+    std::atomic<bool> m_running{false};
+    uint32_t m_next_camera = 1;
+
+    std::thread m_io_thread;
+    std::vector<std::thread> m_decode_threads;
+    std::vector<std::unique_ptr<connection>> m_connections; // indexed by fd
+
+    mpmc_queue<frame_ptr> m_decode_queue;
+    semaphore m_decode_ready;
+    mpmc_queue<frame_ptr> m_ready_queue;
+    semaphore m_frame_ready;
+
+    std::mutex m_stats_mutex;
+    std::vector<std::shared_ptr<camera_stats>> m_cameras;
+    std::chrono::steady_clock::time_point m_last_report;
+};
+
+} // namespace edge
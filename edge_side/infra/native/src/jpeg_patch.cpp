@@ -0,0 +1,915 @@
+#include "jpeg_patch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+namespace edge {
+
+static const int LOOKUP_BITS = 9;
+
+// zigzag position -> row * 8 + column
+static const uint8_t NATURAL[64] = {0,  1,  8,  16, 9,  2,  3,  10, 17, 24, 32, 25, 18, 11, 4,  5,
+                                    12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6,  7,  14, 21, 28,
+                                    35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+                                    58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63};
+
+// The Huffman tables of ITU T.81 Annex K, as jpge and the cameras use them
+static const uint8_t DC_LUM_BITS[17] = {0, 0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0};
+static const uint8_t DC_CHROMA_BITS[17] = {0, 0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0};
+static const uint8_t DC_VALUES[12] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+static const uint8_t AC_LUM_BITS[17] = {0, 0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d};
+static const uint8_t AC_LUM_VALUES[162] = {
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07, 0x22, 0x71, 0x14,
+    0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0, 0x24, 0x33, 0x62, 0x72, 0x82, 0x09,
+    0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a,
+    0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65,
+    0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88,
+    0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9,
+    0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca,
+    0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea,
+    0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa};
+static const uint8_t AC_CHROMA_BITS[17] = {0, 0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77};
+static const uint8_t AC_CHROMA_VALUES[162] = {
+    0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71, 0x13, 0x22, 0x32,
+    0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0, 0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16,
+    0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39,
+    0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64,
+    0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86,
+    0x87, 0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+    0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8,
+    0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9,
+    0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa};
+
+static inline int extend(int v, int size)
+{
+    return v < (1 << (size - 1)) ? v - (1 << size) + 1 : v;
+}
+
+// Reads the destuffed scan. Bits are taken 64 at a time, so m_data ends in
+// 8 bytes of padding; decoding past the end of a restart interval shows as
+// overrun().
+class jpeg_patcher::bit_reader {
+public:
+    explicit bit_reader(const std::vector<uint8_t> &data)
+        : m_data(data.data()),
+          m_size(data.size())
+    {
+    }
+
+    // Reads from byte begin, with the interval ending at byte end
+    void seek(size_t begin, size_t end)
+    {
+        m_pos = begin * 8;
+        m_end = end * 8;
+    }
+
+    size_t position() const { return m_pos; }
+    bool overrun() const { return m_pos > m_end; }
+
+    uint32_t peek(int n)
+    {
+        size_t byte = m_pos >> 3;
+        if (byte + 8 > m_size)
+            return 0; // far past the end, overrun() already says so
+        uint64_t word;
+        memcpy(&word, m_data + byte, 8);
+        word = __builtin_bswap64(word);
+        return (uint32_t)((word << (m_pos & 7)) >> (64 - n));
+    }
+
+    void skip(int n) { m_pos += n; }
+
+    int get(int n)
+    {
+        if (!n)
+            return 0;
+        int v = (int)peek(n);
+        skip(n);
+        return v;
+    }
+
+    // Next Huffman coded value, -1 for a code the table does not have
+    int decode(const huffman_table &t)
+    {
+        uint32_t look = peek(16);
+        uint16_t e = t.lookup[look >> (16 - LOOKUP_BITS)];
+        if (e) {
+            skip(e >> 8);
+            return e & 0xFF;
+        }
+        for (int len = LOOKUP_BITS + 1; len <= 16; len++) {
+            int32_t code = (int32_t)(look >> (16 - len));
+            if (code <= t.max_code[len]) {
+                skip(len);
+                return t.values[t.value_offset[len] + code];
+            }
+        }
+        return -1;
+    }
+
+    // Next Huffman coded value and, in extra, the signed number in the
+    // value & 15 bits after it
+    int decode(const huffman_table &t, int &extra)
+    {
+        uint32_t look = peek(16);
+        uint16_t e = t.fast[look >> (16 - LOOKUP_BITS)];
+        if (e) {
+            int total = e >> 8, v = e & 0xFF, size = v & 15;
+            skip(total);
+            extra = size ? extend((int)(look >> (16 - total)) & ((1 << size) - 1), size) : 0;
+            return v;
+        }
+        int v = decode(t);
+        if (v < 0)
+            return -1;
+        int size = v & 15;
+        extra = size ? extend(get(size), size) : 0;
+        return v;
+    }
+
+private:
+    const uint8_t *m_data;
+    size_t m_size;
+    size_t m_pos = 0, m_end = 0; // in bits
+};
+
+class jpeg_patcher::bit_writer {
+public:
+    explicit bit_writer(std::vector<uint8_t> &out)
+        : m_out(out)
+    {
+    }
+
+    void put(uint32_t bits, int n)
+    {
+        m_acc = (m_acc << n) | (bits & ((1u << n) - 1));
+        m_n += n;
+        while (m_n >= 8) {
+            m_n -= 8;
+            uint8_t b = (uint8_t)(m_acc >> m_n);
+            m_out.push_back(b);
+            if (b == 0xFF)
+                m_out.push_back(0);
+        }
+    }
+
+    bool code(const huffman_table &t, int value)
+    {
+        if (!t.size[value])
+            return false;
+        put(t.code[value], t.size[value]);
+        return true;
+    }
+
+    // Bits [begin, end) of the destuffed scan, as they are
+    void copy(const uint8_t *data, size_t begin, size_t end)
+    {
+        for (; begin + 24 <= end; begin += 24)
+            put(read(data, begin, 24), 24);
+        if (begin < end)
+            put(read(data, begin, (int)(end - begin)), (int)(end - begin));
+    }
+
+    // Pads the last byte with ones, as T.81 asks before a marker
+    void align()
+    {
+        if (m_n)
+            put(0x7F, 8 - m_n);
+    }
+
+    void marker(uint8_t m)
+    {
+        align();
+        m_out.push_back(0xFF);
+        m_out.push_back(m);
+    }
+
+private:
+    static uint32_t read(const uint8_t *data, size_t pos, int n)
+    {
+        const uint8_t *p = data + (pos >> 3);
+        uint32_t word = (uint32_t)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+        return (word << (pos & 7)) >> (32 - n);
+    }
+
+    std::vector<uint8_t> &m_out;
+    uint64_t m_acc = 0;
+    int m_n = 0;
+};
+
+// AAN scale factors: cos(k pi / 16) * sqrt(2), 1 for k = 0
+static const float AAN[8] = {1.0f, 1.387039845f, 1.306562965f, 1.175875602f,
+                             1.0f, 0.785694958f, 0.541196100f, 0.275899379f};
+
+// One 8-point pass of the Arai-Agui-Nakajima forward DCT, outputs scaled by
+// AAN[u] * sqrt(8)
+static inline void fdct8(float *d, int stride)
+{
+    float tmp0 = d[0] + d[7 * stride], tmp7 = d[0] - d[7 * stride];
+    float tmp1 = d[stride] + d[6 * stride], tmp6 = d[stride] - d[6 * stride];
+    float tmp2 = d[2 * stride] + d[5 * stride], tmp5 = d[2 * stride] - d[5 * stride];
+    float tmp3 = d[3 * stride] + d[4 * stride], tmp4 = d[3 * stride] - d[4 * stride];
+
+    float tmp10 = tmp0 + tmp3, tmp13 = tmp0 - tmp3;
+    float tmp11 = tmp1 + tmp2, tmp12 = tmp1 - tmp2;
+    d[0] = tmp10 + tmp11;
+    d[4 * stride] = tmp10 - tmp11;
+    float z1 = (tmp12 + tmp13) * 0.707106781f;
+    d[2 * stride] = tmp13 + z1;
+    d[6 * stride] = tmp13 - z1;
+
+    tmp10 = tmp4 + tmp5;
+    tmp11 = tmp5 + tmp6;
+    tmp12 = tmp6 + tmp7;
+    float z5 = (tmp10 - tmp12) * 0.382683433f;
+    float z2 = 0.541196100f * tmp10 + z5;
+    float z4 = 1.306562965f * tmp12 + z5;
+    float z3 = tmp11 * 0.707106781f;
+    float z11 = tmp7 + z3, z13 = tmp7 - z3;
+    d[5 * stride] = z13 + z2;
+    d[3 * stride] = z13 - z2;
+    d[stride] = z11 + z4;
+    d[7 * stride] = z11 - z4;
+}
+
+// The matching inverse pass, inputs prescaled by AAN[u] / sqrt(8)
+static inline void idct8(float *d, int stride)
+{
+    float tmp0 = d[0], tmp1 = d[2 * stride], tmp2 = d[4 * stride], tmp3 = d[6 * stride];
+    float tmp10 = tmp0 + tmp2, tmp11 = tmp0 - tmp2;
+    float tmp13 = tmp1 + tmp3, tmp12 = (tmp1 - tmp3) * 1.414213562f - tmp13;
+    tmp0 = tmp10 + tmp13;
+    tmp3 = tmp10 - tmp13;
+    tmp1 = tmp11 + tmp12;
+    tmp2 = tmp11 - tmp12;
+
+    float tmp4 = d[stride], tmp5 = d[3 * stride], tmp6 = d[5 * stride], tmp7 = d[7 * stride];
+    float z13 = tmp6 + tmp5, z10 = tmp6 - tmp5, z11 = tmp4 + tmp7, z12 = tmp4 - tmp7;
+    tmp7 = z11 + z13;
+    tmp11 = (z11 - z13) * 1.414213562f;
+    float z5 = (z10 + z12) * 1.847759065f;
+    tmp10 = 1.082392200f * z12 - z5;
+    tmp12 = -2.613125930f * z10 + z5;
+    tmp6 = tmp12 - tmp7;
+    tmp5 = tmp11 - tmp6;
+    tmp4 = tmp10 + tmp5;
+
+    d[0] = tmp0 + tmp7;
+    d[7 * stride] = tmp0 - tmp7;
+    d[stride] = tmp1 + tmp6;
+    d[6 * stride] = tmp1 - tmp6;
+    d[2 * stride] = tmp2 + tmp5;
+    d[5 * stride] = tmp2 - tmp5;
+    d[4 * stride] = tmp3 + tmp4;
+    d[3 * stride] = tmp3 - tmp4;
+}
+
+// Samples of a block from its dequantised, prescaled coefficients, by row v
+// and column u
+static void idct8x8(float *f, float *out, int stride)
+{
+    for (int v = 0; v < 8; v++)
+        idct8(f + v * 8, 1);
+    for (int x = 0; x < 8; x++)
+        idct8(f + x, 8);
+    for (int y = 0; y < 8; y++)
+        for (int x = 0; x < 8; x++)
+            out[y * stride + x] = f[y * 8 + x] + 128;
+}
+
+// Scaled coefficients of level shifted samples, in place
+static void fdct8x8(float *f)
+{
+    for (int y = 0; y < 8; y++)
+        fdct8(f + y * 8, 1);
+    for (int u = 0; u < 8; u++)
+        fdct8(f + u, 8);
+}
+
+static inline uint8_t clamp_u8(float v)
+{
+    return (uint8_t)std::min(255.f, std::max(0.f, v + 0.5f));
+}
+
+static inline int bit_count(int v)
+{
+    unsigned a = (unsigned)(v < 0 ? -v : v);
+    return a ? 32 - __builtin_clz(a) : 0;
+}
+
+static inline uint16_t read16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] << 8 | p[1]);
+}
+
+static inline void write16(std::vector<uint8_t> &out, int v)
+{
+    out.push_back((uint8_t)(v >> 8));
+    out.push_back((uint8_t)v);
+}
+
+jpeg_patcher::jpeg_patcher(const overlay_style &style)
+    : m_renderer(style)
+{
+    standard_table(m_standard_dc[0], false, false);
+    standard_table(m_standard_dc[1], false, true);
+    standard_table(m_standard_ac[0], true, false);
+    standard_table(m_standard_ac[1], true, true);
+}
+
+bool jpeg_patcher::annotate(const uint8_t *jpeg, size_t len, const std::vector<detection> &detections, int count,
+                            std::vector<uint8_t> &out)
+{
+    m_use_standard = false;
+    if (!jpeg || !parse(jpeg, len))
+        return false;
+    destuff(jpeg, len);
+    plan(detections, count);
+    if (!decode_scan())
+        return false;
+    redraw(detections, count);
+    if (encode(jpeg, len, out))
+        return true;
+
+    // A redrawn block needs a code the stream's tables lack: code all of the
+    // scan again with the standard tables
+    m_use_standard = true;
+    plan(detections, count);
+    decode_scan();
+    redraw(detections, count);
+    return encode(jpeg, len, out);
+}
+
+void jpeg_patcher::plan(const std::vector<detection> &detections, int count)
+{
+    int mcu_w = 8 * m_hmax, mcu_h = 8 * m_vmax;
+    m_renderer.plan(m_width, m_height, detections, count);
+    m_touched.assign(mcus(), false);
+    for (const rect &r : m_renderer.dirty()) {
+        if (r.x1 <= r.x0 || r.y1 <= r.y0)
+            continue;
+        for (int my = r.y0 / mcu_h; my <= (r.y1 - 1) / mcu_h; my++)
+            for (int mx = r.x0 / mcu_w; mx <= (r.x1 - 1) / mcu_w; mx++)
+                m_touched[(size_t)my * m_mcus_x + mx] = true;
+    }
+
+    // An untouched MCU is copied bit for bit unless the DC prediction it
+    // starts from changes: after a redrawn MCU, or where the input and the
+    // output disagree on a restart
+    int restart = output_restart();
+    m_recode.assign(mcus(), m_use_standard);
+    for (size_t m = 0; m < mcus(); m++) {
+        bool in = m_restart && m && m % m_restart == 0, out = restart && m && m % restart == 0;
+        if (m_touched[m] || in != out || (!out && m && m_touched[m - 1]))
+            m_recode[m] = true;
+    }
+}
+
+void jpeg_patcher::redraw(const std::vector<detection> &detections, int count)
+{
+    size_t pixels = (size_t)m_width * m_height * 3;
+    if (m_pixels_size < pixels) {
+        m_pixels.reset(new uint8_t[pixels]);
+        m_pixels_size = pixels;
+    }
+    m_patched = 0;
+    for (int my = 0; my < m_mcus_y; my++)
+        for (int mx = 0; mx < m_mcus_x; mx++)
+            if (m_touched[(size_t)my * m_mcus_x + mx]) {
+                mcu_to_pixels(mx, my);
+                m_patched++;
+            }
+    m_renderer.draw(bgr_view(m_pixels.get(), m_width, m_height), detections, count);
+    for (int my = 0; my < m_mcus_y; my++)
+        for (int mx = 0; mx < m_mcus_x; mx++)
+            if (m_touched[(size_t)my * m_mcus_x + mx])
+                pixels_to_mcu(mx, my);
+}
+
+bool jpeg_patcher::encode(const uint8_t *jpeg, size_t len, std::vector<uint8_t> &out)
+{
+    out.clear();
+    out.reserve(len + 1024);
+    write_header(jpeg, out);
+    return encode_scan(out);
+}
+
+bool jpeg_patcher::parse(const uint8_t *jpeg, size_t len)
+{
+    m_components.clear();
+    m_segments.clear();
+    m_restart = 0;
+    memset(m_quant_defined, 0, sizeof(m_quant_defined));
+    for (int i = 0; i < 4; i++)
+        m_dc[i].defined = m_ac[i].defined = false;
+
+    if (len < 4 || jpeg[0] != 0xFF || jpeg[1] != 0xD8)
+        return false;
+    size_t pos = 2;
+    bool frame = false;
+    while (pos < len) {
+        if (jpeg[pos] != 0xFF)
+            return false;
+        size_t start = pos;
+        while (pos < len && jpeg[pos] == 0xFF)
+            pos++;
+        if (pos + 3 > len)
+            return false;
+        uint8_t marker = jpeg[pos++];
+        size_t size = read16(jpeg + pos);
+        if (size < 2 || pos + size > len)
+            return false;
+        const uint8_t *p = jpeg + pos + 2, *end = jpeg + pos + size;
+        pos += size;
+
+        switch (marker) {
+        case 0xC0: // baseline
+        case 0xC1: // extended sequential, Huffman coded
+        {
+            if (frame || end - p < 6 || p[0] != 8)
+                return false;
+            m_height = read16(p + 1);
+            m_width = read16(p + 3);
+            int n = p[5];
+            if (!m_width || !m_height || (n != 1 && n != 3) || end - p < 6 + 3 * n)
+                return false;
+            m_hmax = m_vmax = 1;
+            for (int i = 0; i < n; i++) {
+                component c;
+                c.id = p[6 + 3 * i];
+                c.h = p[7 + 3 * i] >> 4;
+                c.v = p[7 + 3 * i] & 15;
+                c.tq = p[8 + 3 * i];
+                if (c.h < 1 || c.h > 2 || c.v < 1 || c.v > 2 || c.tq > 3)
+                    return false;
+                // a single component scan is one block per MCU, whatever the factors
+                if (n == 1)
+                    c.h = c.v = 1;
+                m_hmax = std::max(m_hmax, c.h);
+                m_vmax = std::max(m_vmax, c.v);
+                m_components.push_back(c);
+            }
+            frame = true;
+            break;
+        }
+        case 0xC4: // DHT, one or more tables
+            while (p < end) {
+                if (end - p < 17 || (p[0] >> 4) > 1 || (p[0] & 15) > 3)
+                    return false;
+                huffman_table &t = ((p[0] >> 4) ? m_ac : m_dc)[p[0] & 15];
+                memcpy(t.bits, p, 17);
+                t.bits[0] = 0;
+                int n = 0;
+                for (int i = 1; i <= 16; i++)
+                    n += t.bits[i];
+                if (n > 256 || end - p < 17 + n)
+                    return false;
+                memcpy(t.values, p + 17, n);
+                if (!build(t))
+                    return false;
+                p += 17 + n;
+            }
+            break;
+        case 0xDB: // DQT, one or more tables
+            while (p < end) {
+                int precision = p[0] >> 4, id = p[0] & 15;
+                if (id > 3 || precision > 1 || end - p < 1 + 64 * (precision + 1))
+                    return false;
+                for (int k = 0; k < 64; k++)
+                    m_quant[id][k] = precision ? read16(p + 1 + 2 * k) : p[1 + k];
+                for (int k = 0; k < 64; k++) {
+                    if (!m_quant[id][k])
+                        return false;
+                    float aan = AAN[NATURAL[k] >> 3] * AAN[NATURAL[k] & 7];
+                    m_idct_scale[id][k] = m_quant[id][k] * aan / 8;
+                    m_fdct_scale[id][k] = 1 / (m_quant[id][k] * aan * 8);
+                }
+                m_quant_defined[id] = true;
+                p += 1 + 64 * (precision + 1);
+            }
+            break;
+        case 0xDD: // DRI
+            if (end - p < 2)
+                return false;
+            m_restart = read16(p);
+            break;
+        case 0xDA: // SOS
+        {
+            if (!frame || end - p < 1)
+                return false;
+            int n = p[0];
+            // the whole image in one interleaved scan
+            if (n != (int)m_components.size() || end - p < 4 + 2 * n)
+                return false;
+            for (int i = 0; i < n; i++) {
+                // in frame order, which is the order the blocks are coded in
+                component &c = m_components[i];
+                if (c.id != p[1 + 2 * i])
+                    return false;
+                c.td = p[2 + 2 * i] >> 4;
+                c.ta = p[2 + 2 * i] & 15;
+                if (c.td > 3 || c.ta > 3 || !m_dc[c.td].defined || !m_ac[c.ta].defined || !m_quant_defined[c.tq])
+                    return false;
+            }
+            const uint8_t *tail = p + 1 + 2 * n;
+            if (tail[0] != 0 || tail[1] != 63 || tail[2] != 0)
+                return false;
+            m_sos = start;
+            m_scan = pos;
+
+            int mcu_w = 8 * m_hmax, mcu_h = 8 * m_vmax;
+            m_mcus_x = (m_width + mcu_w - 1) / mcu_w;
+            m_mcus_y = (m_height + mcu_h - 1) / mcu_h;
+            for (component &c : m_components) {
+                c.blocks_w = m_mcus_x * c.h;
+                c.blocks_h = m_mcus_y * c.v;
+                c.coef.resize((size_t)c.blocks_w * c.blocks_h * 64);
+            }
+            return true;
+        }
+        case 0xC2: case 0xC3: case 0xC5: case 0xC6: case 0xC7:
+        case 0xC9: case 0xCA: case 0xCB: case 0xCD: case 0xCE: case 0xCF:
+            return false; // progressive, lossless, hierarchical or arithmetic coded
+        default:
+            break;
+        }
+        m_segments.push_back({marker, start, pos - start});
+    }
+    return false;
+}
+
+void jpeg_patcher::destuff(const uint8_t *jpeg, size_t len)
+{
+    m_data.clear();
+    m_intervals.assign(1, 0);
+    const uint8_t *p = jpeg + m_scan, *end = jpeg + len;
+    while (p < end) {
+        const uint8_t *ff = (const uint8_t *)memchr(p, 0xFF, end - p);
+        if (!ff)
+            ff = end; // cut short, decode_scan() will tell
+        m_data.insert(m_data.end(), p, ff);
+        p = ff;
+        if (p + 1 >= end)
+            break;
+        if (p[1] == 0x00) {
+            m_data.push_back(0xFF);
+            p += 2;
+        } else if (p[1] >= 0xD0 && p[1] <= 0xD7) {
+            m_intervals.push_back(m_data.size());
+            p += 2;
+        } else if (p[1] == 0xFF) {
+            p++; // fill byte
+        } else {
+            break; // EOI
+        }
+    }
+    m_intervals.push_back(m_data.size());
+    m_data.insert(m_data.end(), 8, 0);
+}
+
+bool jpeg_patcher::decode_block(bit_reader &r, int16_t *block, int &pred, const huffman_table &dc,
+                                const huffman_table &ac)
+{
+    int diff;
+    int s = r.decode(dc, diff);
+    if (s < 0 || s > 11)
+        return false;
+    pred += diff;
+    if (block) {
+        memset(block, 0, 64 * sizeof(int16_t));
+        block[0] = (int16_t)pred;
+    }
+    for (int k = 1; k < 64;) {
+        int value;
+        int rs = r.decode(ac, value);
+        if (rs < 0)
+            return false;
+        int run = rs >> 4, size = rs & 15;
+        if (!size) {
+            if (run != 15)
+                break; // end of block
+            k += 16;
+            continue;
+        }
+        k += run;
+        if (k > 63 || size > 10)
+            return false;
+        if (block)
+            block[k] = (int16_t)value;
+        k++;
+    }
+    return true;
+}
+
+bool jpeg_patcher::decode_scan()
+{
+    bit_reader r(m_data);
+    size_t interval = 0, n = m_components.size();
+    r.seek(m_intervals[0], m_intervals[1]);
+    m_mcu_bits.resize(2 * mcus());
+    m_last_dc.resize(n * mcus());
+    int pred[3] = {0, 0, 0};
+    for (size_t m = 0; m < mcus(); m++) {
+        if (m_restart && m && m % m_restart == 0) {
+            if (++interval + 1 >= m_intervals.size())
+                return false;
+            r.seek(m_intervals[interval], m_intervals[interval + 1]);
+            pred[0] = pred[1] = pred[2] = 0;
+        }
+        int mx = (int)(m % m_mcus_x), my = (int)(m / m_mcus_x);
+        m_mcu_bits[2 * m] = r.position();
+        for (size_t ci = 0; ci < n; ci++) {
+            component &c = m_components[ci];
+            for (int by = 0; by < c.v; by++)
+                for (int bx = 0; bx < c.h; bx++) {
+                    // copied MCUs only need their DC values followed
+                    int16_t *block = m_recode[m] ? c.block(mx * c.h + bx, my * c.v + by) : nullptr;
+                    if (!decode_block(r, block, pred[ci], m_dc[c.td], m_ac[c.ta]))
+                        return false;
+                }
+            m_last_dc[m * n + ci] = (int16_t)pred[ci];
+        }
+        m_mcu_bits[2 * m + 1] = r.position();
+        if (r.overrun())
+            return false;
+    }
+    return true;
+}
+
+void jpeg_patcher::mcu_to_pixels(int mx, int my)
+{
+    float planes[3][16 * 16];
+    for (size_t ci = 0; ci < m_components.size(); ci++) {
+        component &comp = m_components[ci];
+        const float *scale = m_idct_scale[comp.tq];
+        int stride = 8 * comp.h;
+        for (int by = 0; by < comp.v; by++)
+            for (int bx = 0; bx < comp.h; bx++) {
+                const int16_t *coef = comp.block(mx * comp.h + bx, my * comp.v + by);
+                float f[64];
+                for (int k = 0; k < 64; k++)
+                    f[NATURAL[k]] = coef[k] * scale[k];
+                idct8x8(f, planes[ci] + by * 8 * stride + bx * 8, stride);
+            }
+    }
+
+    int x0 = mx * 8 * m_hmax, y0 = my * 8 * m_vmax;
+    int x1 = std::min(x0 + 8 * m_hmax, m_width), y1 = std::min(y0 + 8 * m_vmax, m_height);
+    if (m_components.size() == 1) {
+        for (int y = y0; y < y1; y++) {
+            uint8_t *p = m_pixels.get() + ((size_t)y * m_width + x0) * 3;
+            for (int x = x0; x < x1; x++, p += 3)
+                p[0] = p[1] = p[2] = clamp_u8(planes[0][(y - y0) * 8 + x - x0]);
+        }
+        return;
+    }
+    // sampling factors are 1 or 2, so upsampling is a shift
+    int sx[3], sy[3];
+    for (int ci = 0; ci < 3; ci++) {
+        sx[ci] = m_components[ci].h < m_hmax;
+        sy[ci] = m_components[ci].v < m_vmax;
+    }
+    for (int y = y0; y < y1; y++) {
+        const float *row[3];
+        for (int ci = 0; ci < 3; ci++)
+            row[ci] = planes[ci] + ((y - y0) >> sy[ci]) * 8 * m_components[ci].h;
+        uint8_t *p = m_pixels.get() + ((size_t)y * m_width + x0) * 3;
+        for (int x = x0; x < x1; x++, p += 3) {
+            int i = x - x0;
+            float luma = row[0][i >> sx[0]];
+            float cb = row[1][i >> sx[1]] - 128, cr = row[2][i >> sx[2]] - 128;
+            p[0] = clamp_u8(luma + 1.772f * cb);
+            p[1] = clamp_u8(luma - 0.344136f * cb - 0.714136f * cr);
+            p[2] = clamp_u8(luma + 1.402f * cr);
+        }
+    }
+}
+
+void jpeg_patcher::pixels_to_mcu(int mx, int my)
+{
+    int mcu_w = 8 * m_hmax, mcu_h = 8 * m_vmax;
+    int x0 = mx * mcu_w, y0 = my * mcu_h;
+    // full resolution planes, the image's last row and column repeated past its edge
+    float planes[3][16 * 16];
+    int columns = std::min(mcu_w, m_width - x0);
+    for (int y = 0; y < mcu_h; y++) {
+        const uint8_t *p = m_pixels.get() + ((size_t)std::min(y0 + y, m_height - 1) * m_width + x0) * 3;
+        float *luma = planes[0] + y * mcu_w, *cb = planes[1] + y * mcu_w, *cr = planes[2] + y * mcu_w;
+        for (int x = 0; x < columns; x++, p += 3) {
+            float b = p[0], g = p[1], r = p[2];
+            luma[x] = 0.299f * r + 0.587f * g + 0.114f * b;
+            cb[x] = -0.168736f * r - 0.331264f * g + 0.5f * b + 128;
+            cr[x] = 0.5f * r - 0.418688f * g - 0.081312f * b + 128;
+        }
+        for (int x = columns; x < mcu_w; x++) {
+            luma[x] = luma[columns - 1];
+            cb[x] = cb[columns - 1];
+            cr[x] = cr[columns - 1];
+        }
+    }
+
+    for (size_t ci = 0; ci < m_components.size(); ci++) {
+        component &comp = m_components[ci];
+        const float *scale = m_fdct_scale[comp.tq];
+        int fx = m_hmax / comp.h, fy = m_vmax / comp.v;
+        for (int by = 0; by < comp.v; by++)
+            for (int bx = 0; bx < comp.h; bx++) {
+                float f[64];
+                for (int y = 0; y < 8; y++) {
+                    // average of the fx x fy pixels under each sample, with
+                    // fx and fy 1 or 2
+                    const float *r0 = planes[ci] + (by * 8 + y) * fy * mcu_w + bx * 8 * fx;
+                    const float *r1 = r0 + (fy - 1) * mcu_w;
+                    for (int x = 0; x < 8; x++) {
+                        int i = x * fx, j = i + fx - 1;
+                        f[y * 8 + x] = (r0[i] + r0[j] + r1[i] + r1[j]) * 0.25f - 128;
+                    }
+                }
+                fdct8x8(f);
+                int16_t *coef = comp.block(mx * comp.h + bx, my * comp.v + by);
+                for (int k = 0; k < 64; k++) {
+                    // AC values of up to 10 bits, DC differences of up to 11
+                    float a = f[NATURAL[k]] * scale[k];
+                    int level = (int)(a < 0 ? a - 0.5f : a + 0.5f);
+                    coef[k] = (int16_t)std::min(1023, std::max(k ? -1023 : -1024, level));
+                }
+            }
+    }
+}
+
+bool jpeg_patcher::encode_block(bit_writer &w, const int16_t *block, int &pred, const huffman_table &dc,
+                                const huffman_table &ac)
+{
+    int diff = block[0] - pred;
+    pred = block[0];
+    int size = bit_count(diff);
+    if (!w.code(dc, size))
+        return false;
+    if (size)
+        w.put(diff < 0 ? diff - 1 : diff, size);
+    int run = 0;
+    for (int k = 1; k < 64; k++) {
+        int v = block[k];
+        if (!v) {
+            run++;
+            continue;
+        }
+        for (; run > 15; run -= 16)
+            if (!w.code(ac, 0xF0))
+                return false;
+        size = bit_count(v);
+        if (!w.code(ac, run << 4 | size))
+            return false;
+        w.put(v < 0 ? v - 1 : v, size);
+        run = 0;
+    }
+    return !run || w.code(ac, 0x00);
+}
+
+bool jpeg_patcher::encode_scan(std::vector<uint8_t> &out)
+{
+    bit_writer w(out);
+    int restart = output_restart();
+    size_t n = m_components.size();
+    int pred[3] = {0, 0, 0};
+    for (size_t m = 0; m < mcus(); m++) {
+        if (restart && m && m % restart == 0) {
+            w.marker((uint8_t)(0xD0 + (m / restart - 1) % 8));
+            pred[0] = pred[1] = pred[2] = 0;
+        }
+        if (!m_recode[m]) {
+            w.copy(m_data.data(), m_mcu_bits[2 * m], m_mcu_bits[2 * m + 1]);
+            for (size_t ci = 0; ci < n; ci++)
+                pred[ci] = m_last_dc[m * n + ci];
+            continue;
+        }
+        int mx = (int)(m % m_mcus_x), my = (int)(m / m_mcus_x);
+        for (size_t ci = 0; ci < n; ci++) {
+            component &c = m_components[ci];
+            const huffman_table &dc = m_use_standard ? m_standard_dc[ci ? 1 : 0] : m_dc[c.td];
+            const huffman_table &ac = m_use_standard ? m_standard_ac[ci ? 1 : 0] : m_ac[c.ta];
+            for (int by = 0; by < c.v; by++)
+                for (int bx = 0; bx < c.h; bx++)
+                    if (!encode_block(w, c.block(mx * c.h + bx, my * c.v + by), pred[ci], dc, ac))
+                        return false;
+        }
+    }
+    w.marker(0xD9);
+    return true;
+}
+
+void jpeg_patcher::write_header(const uint8_t *jpeg, std::vector<uint8_t> &out)
+{
+    out.push_back(0xFF);
+    out.push_back(0xD8);
+    for (const segment &s : m_segments) {
+        if (s.marker == 0xDD || (s.marker == 0xC4 && m_use_standard))
+            continue;
+        out.insert(out.end(), jpeg + s.offset, jpeg + s.offset + s.size);
+    }
+    if (m_use_standard) {
+        // Y uses table 0, the chroma components table 1
+        out.push_back(0xFF);
+        out.push_back(0xC4);
+        size_t length_at = out.size();
+        write16(out, 0);
+        for (int i = 0; i < 2; i++)
+            for (int ac = 0; ac < 2; ac++) {
+                const huffman_table &t = ac ? m_standard_ac[i] : m_standard_dc[i];
+                int n = std::accumulate(t.bits + 1, t.bits + 17, 0);
+                out.push_back((uint8_t)(ac << 4 | i));
+                out.insert(out.end(), t.bits + 1, t.bits + 17);
+                out.insert(out.end(), t.values, t.values + n);
+            }
+        size_t length = out.size() - length_at;
+        out[length_at] = (uint8_t)(length >> 8);
+        out[length_at + 1] = (uint8_t)length;
+    }
+    int restart = output_restart();
+    if (restart) {
+        out.push_back(0xFF);
+        out.push_back(0xDD);
+        write16(out, 4);
+        write16(out, restart);
+    }
+    if (!m_use_standard) {
+        out.insert(out.end(), jpeg + m_sos, jpeg + m_scan);
+        return;
+    }
+    out.push_back(0xFF);
+    out.push_back(0xDA);
+    write16(out, 6 + 2 * (int)m_components.size());
+    out.push_back((uint8_t)m_components.size());
+    for (size_t ci = 0; ci < m_components.size(); ci++) {
+        out.push_back((uint8_t)m_components[ci].id);
+        out.push_back(ci ? 0x11 : 0x00);
+    }
+    out.push_back(0);
+    out.push_back(63);
+    out.push_back(0);
+}
+
+void jpeg_patcher::standard_table(huffman_table &t, bool ac, bool chroma)
+{
+    const uint8_t *bits = ac ? (chroma ? AC_CHROMA_BITS : AC_LUM_BITS) : (chroma ? DC_CHROMA_BITS : DC_LUM_BITS);
+    const uint8_t *values = ac ? (chroma ? AC_CHROMA_VALUES : AC_LUM_VALUES) : DC_VALUES;
+    memcpy(t.bits, bits, 17);
+    memcpy(t.values, values, std::accumulate(bits + 1, bits + 17, 0));
+    build(t);
+}
+
+bool jpeg_patcher::build(huffman_table &t)
+{
+    memset(t.lookup, 0, sizeof(t.lookup));
+    memset(t.fast, 0, sizeof(t.fast));
+    memset(t.size, 0, sizeof(t.size));
+    int32_t code = 0;
+    int k = 0;
+    for (int len = 1; len <= 16; len++) {
+        t.value_offset[len] = k - code;
+        for (int i = 0; i < t.bits[len]; i++, k++, code++) {
+            // more codes of this length than there is room for
+            if (code >= 1 << len)
+                return false;
+            uint8_t v = t.values[k];
+            t.code[v] = (uint16_t)code;
+            t.size[v] = (uint8_t)len;
+            if (len <= LOOKUP_BITS) {
+                int shift = LOOKUP_BITS - len;
+                int total = len + (v & 15);
+                for (int j = 0; j < 1 << shift; j++) {
+                    t.lookup[code << shift | j] = (uint16_t)(len << 8 | v);
+                    if (total <= LOOKUP_BITS)
+                        t.fast[code << shift | j] = (uint16_t)(total << 8 | v);
+                }
+            }
+        }
+        t.max_code[len] = t.bits[len] ? code - 1 : -1;
+        code <<= 1;
+    }
+    t.max_code[17] = INT32_MAX;
+    t.defined = true;
+    return true;
+}
+
+} // namespace edge
+
+// Returns the annotated JPEG's size, or minus the size when capacity is too
+// small, or 0 when the stream is not one jpeg_patcher handles
+extern "C" int edge_patch_jpeg(const uint8_t *jpeg, int len, const edge::detection *detections, int n, int count,
+                               uint8_t *out, int capacity)
+{
+    static thread_local edge::jpeg_patcher patcher;
+    static thread_local std::vector<uint8_t> annotated;
+    if (!jpeg || len <= 0 || n < 0)
+        return 0;
+    std::vector<edge::detection> boxes(detections, detections + (detections ? n : 0));
+    if (!patcher.annotate(jpeg, len, boxes, count, annotated))
+        return 0;
+    if (annotated.size() > (size_t)capacity || !out)
+        return -(int)annotated.size();
+    memcpy(out, annotated.data(), annotated.size());
+    return (int)annotated.size();
+}
@@ -0,0 +1,136 @@
+// Annotating a camera JPEG without decoding and re-encoding all of it.
+//
+// The scan is only Huffman decoded, to find where each MCU's bits start and
+// end; there is no IDCT or colour conversion. The MCUs the overlay touches
+// (overlay_renderer::plan()) are turned into pixels, drawn on, and
+// transformed and quantised back with the stream's own tables. The new scan
+// copies the bits of every other MCU as they are, and Huffman codes only the
+// redrawn MCUs and the ones right after them, whose DC difference to the
+// previous block changed. Untouched MCUs therefore decode exactly as before,
+// pixel work follows the overlay's perimeter, and the rest of the frame
+// costs a Huffman decode and a bit copy.
+//
+// Handles what the cameras send: baseline Huffman JPEGs with 1 or 3
+// components, sampling factors 1 or 2, with or without restart intervals.
+// The stream's Huffman tables are kept unless a redrawn block needs a code
+// they lack, in which case the scan is written with the standard tables.
+// Anything else (progressive, arithmetic coding, 12-bit) is refused and the
+// caller falls back to frame_decoder + overlay_renderer + frame_encoder.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "overlay.h"
+
+namespace edge {
+
+class jpeg_patcher {
+public:
+    explicit jpeg_patcher(const overlay_style &style = overlay_style());
+
+    // Writes jpeg with overlay_renderer::draw(detections, count) applied to
+    // out. Returns false for streams it does not handle or cannot parse.
+    bool annotate(const uint8_t *jpeg, size_t len, const std::vector<detection> &detections, int count,
+                  std::vector<uint8_t> &out);
+
+    // Restart interval of the output in MCUs: -1 keeps the input's, 0 drops them
+    void set_restart_interval(int mcus) { m_out_restart = mcus; }
+
+    // About the last annotate()
+    size_t mcus() const { return (size_t)m_mcus_x * m_mcus_y; }
+    size_t patched_mcus() const { return m_patched; }
+    bool standard_tables() const { return m_use_standard; }
+
+    overlay_renderer &renderer() { return m_renderer; }
+
+private:
+    struct huffman_table {
+        bool defined = false;
+        uint8_t bits[17];   // codes per length, index 1..16
+        uint8_t values[256];
+        // decoding: codes of up to 9 bits resolve in one step, and together
+        // with the value & 15 extra bits that follow them if those fit too
+        uint16_t lookup[1 << 9]; // length << 8 | value, 0 for longer codes
+        uint16_t fast[1 << 9];   // (length + extra bits) << 8 | value, or 0
+        int32_t max_code[18];
+        int32_t value_offset[17];
+        // encoding
+        uint16_t code[256];
+        uint8_t size[256]; // 0: value has no code
+    };
+
+    struct component {
+        int id = 0, h = 0, v = 0, tq = 0; // sampling factors, quantisation table
+        int td = 0, ta = 0;               // Huffman tables of the scan
+        int blocks_w = 0, blocks_h = 0;
+        std::vector<int16_t> coef; // 64 per block in zigzag order, of recoded MCUs only
+        int16_t *block(int bx, int by) { return &coef[((size_t)by * blocks_w + bx) * 64]; }
+    };
+
+    // A marker segment before SOS, as offsets into the input
+    struct segment {
+        uint8_t marker;
+        size_t offset, size;
+    };
+
+    class bit_reader;
+    class bit_writer;
+
+    bool parse(const uint8_t *jpeg, size_t len);
+    // Entropy-coded data without stuffing and restart markers into m_data
+    void destuff(const uint8_t *jpeg, size_t len);
+    // m_touched and m_recode for the overlay
+    void plan(const std::vector<detection> &detections, int count);
+    bool decode_scan();
+    void redraw(const std::vector<detection> &detections, int count);
+    void mcu_to_pixels(int mx, int my);
+    void pixels_to_mcu(int mx, int my);
+    // False when a block needs a code the tables lack
+    bool encode(const uint8_t *jpeg, size_t len, std::vector<uint8_t> &out);
+    bool encode_scan(std::vector<uint8_t> &out);
+    void write_header(const uint8_t *jpeg, std::vector<uint8_t> &out);
+    int output_restart() const { return m_out_restart < 0 ? m_restart : m_out_restart; }
+
+    // block may be null to only follow the DC prediction
+    static bool decode_block(bit_reader &r, int16_t *block, int &pred, const huffman_table &dc,
+                             const huffman_table &ac);
+    static bool encode_block(bit_writer &w, const int16_t *block, int &pred, const huffman_table &dc,
+                             const huffman_table &ac);
+    static bool build(huffman_table &t);
+    static void standard_table(huffman_table &t, bool ac, bool chroma);
+
+    overlay_renderer m_renderer;
+    int m_out_restart = -1;
+
+    int m_width = 0, m_height = 0;
+    int m_hmax = 1, m_vmax = 1;
+    int m_mcus_x = 0, m_mcus_y = 0;
+    int m_restart = 0;
+    size_t m_sos = 0, m_scan = 0; // offsets of the SOS marker and of the entropy-coded data
+    std::vector<segment> m_segments;
+    std::vector<component> m_components;
+    uint16_t m_quant[4][64];
+    // dequantisation and quantisation multipliers with the AAN DCT scaling
+    float m_idct_scale[4][64], m_fdct_scale[4][64];
+    bool m_quant_defined[4];
+    huffman_table m_dc[4], m_ac[4];
+    huffman_table m_standard_dc[2], m_standard_ac[2];
+    bool m_use_standard = false;
+
+    std::vector<uint8_t> m_data;       // destuffed scan
+    std::vector<size_t> m_intervals;   // byte offsets of the restart intervals in m_data, and its end
+    std::vector<size_t> m_mcu_bits;    // first and last + 1 bit of each MCU in m_data
+    std::vector<int16_t> m_last_dc;    // per MCU and component: the DC prediction after it
+    std::vector<bool> m_touched;       // per MCU: redrawn
+    std::vector<bool> m_recode;        // per MCU: Huffman coded from coefficients rather than copied
+    size_t m_patched = 0;
+    // decoded pixels of touched MCUs only; left uninitialised so the pages
+    // of the rest of the frame are never faulted in
+    std::unique_ptr<uint8_t[]> m_pixels;
+    size_t m_pixels_size = 0;
+};
+
+} // namespace edge
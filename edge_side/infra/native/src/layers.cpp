@@ -0,0 +1,863 @@
+#include "layers.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include "simd.h"
+
+namespace edge {
+
+// defined in conv.cpp
+std::unique_ptr<layer> create_convolution();
+std::unique_ptr<layer> create_convolution_depthwise();
+
+bool param_dict::parse(const std::vector<std::string> &tokens, size_t first)
+{
+    for (size_t i = first; i < tokens.size(); i++) {
+        const std::string &kv = tokens[i];
+        size_t eq = kv.find('=');
+        if (eq == std::string::npos)
+            return false;
+        int id = atoi(kv.c_str());
+        bool array = id <= -23300;
+        if (array)
+            id = -id - 23300;
+
+        std::vector<float> values;
+        const char *p = kv.c_str() + eq + 1;
+        for (;;) {
+            char *end;
+            values.push_back(strtof(p, &end));
+            if (end == p)
+                return false;
+            p = end;
+            if (*p != ',')
+                break;
+            p++;
+        }
+        // arrays start with their element count
+        if (array)
+            values.erase(values.begin());
+        m_values[id] = values;
+    }
+    return true;
+}
+
+int param_dict::get(int id, int def) const
+{
+    auto it = m_values.find(id);
+    return it == m_values.end() || it->second.empty() ? def : (int)it->second[0];
+}
+
+float param_dict::get(int id, float def) const
+{
+    auto it = m_values.find(id);
+    return it == m_values.end() || it->second.empty() ? def : it->second[0];
+}
+
+std::vector<float> param_dict::get_array(int id) const
+{
+    auto it = m_values.find(id);
+    return it == m_values.end() ? std::vector<float>() : it->second;
+}
+
+static float half_to_float(uint16_t h)
+{
+    uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+    uint32_t exponent = (h >> 10) & 0x1f;
+    uint32_t mantissa = h & 0x3ff;
+    uint32_t bits;
+    if (exponent == 0x1f) {
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    } else if (exponent) {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    } else if (mantissa) {
+        // subnormal: renormalise
+        exponent = 113;
+        while (!(mantissa & 0x400)) {
+            mantissa <<= 1;
+            exponent--;
+        }
+        bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+    } else {
+        bits = sign;
+    }
+    float f;
+    memcpy(&f, &bits, 4);
+    return f;
+}
+
+bool model_reader::read_tagged(size_t count, std::vector<float> &out)
+{
+    uint32_t tag;
+    if (fread(&tag, 4, 1, m_file) != 1)
+        return false;
+    if (tag == 0)
+        return read_raw(count, out);
+    if (tag == 0x01306B47) {
+        std::vector<uint16_t> half((count + 1) & ~(size_t)1); // padded to 4 bytes
+        if (fread(half.data(), 2, half.size(), m_file) != half.size())
+            return false;
+        out.resize(count);
+        for (size_t i = 0; i < count; i++)
+            out[i] = half_to_float(half[i]);
+        return true;
+    }
+    fprintf(stderr, "[Net] Unsupported weight storage tag 0x%08x (only fp32 and fp16)\n", tag);
+    return false;
+}
+
+bool model_reader::read_raw(size_t count, std::vector<float> &out)
+{
+    out.resize(count);
+    return fread(out.data(), 4, count, m_file) == count;
+}
+
+std::vector<int> shape_of(const tensor &t)
+{
+    switch (t.dims) {
+    case 1:
+        return {t.w};
+    case 2:
+        return {t.h, t.w};
+    case 3:
+        return {t.c, t.h, t.w};
+    default:
+        return {t.c, t.d, t.h, t.w};
+    }
+}
+
+tensor make_tensor(const std::vector<int> &s)
+{
+    switch (s.size()) {
+    case 1:
+        return tensor::make(1, s[0]);
+    case 2:
+        return tensor::make(2, s[1], s[0]);
+    case 3:
+        return tensor::make(3, s[2], s[1], 1, s[0]);
+    default:
+        return tensor::make(4, s[3], s[2], s[1], s[0]);
+    }
+}
+
+// Splits a shape around an axis: outer * extent * inner elements
+static void around_axis(const std::vector<int> &shape, int axis, size_t &outer, size_t &inner)
+{
+    outer = inner = 1;
+    for (int i = 0; i < axis; i++)
+        outer *= shape[i];
+    for (size_t i = axis + 1; i < shape.size(); i++)
+        inner *= shape[i];
+}
+
+static int positive_axis(int axis, int dims)
+{
+    return axis < 0 ? axis + dims : axis;
+}
+
+namespace {
+
+class input_layer : public layer {
+public:
+    bool forward(const std::vector<tensor> &, std::vector<tensor> &, thread_pool &) const override { return true; }
+};
+
+class split_layer : public layer {
+public:
+    bool forward(const std::vector<tensor> &bottoms, std::vector<tensor> &tops, thread_pool &) const override
+    {
+        for (tensor &t : tops)
+            t = bottoms[0];
+        return true;
+    }
+};
+
+class activation_layer : public layer {
+public:
+    explicit activation_layer(activation_type act)
+        : m_act(act)
+    {
+    }
+
+    bool forward(const std::vector<tensor> &bottoms, std::vector<tensor> &tops, thread_pool &pool) const override
+    {
+        const tensor &in = bottoms[0];
+        tensor out = make_tensor(shape_of(in));
+        size_t n = in.total();
+        const size_t CHUNK = 16384;
+        int chunks = (int)((n + CHUNK - 1) / CHUNK);
+        pool.parallel_for(chunks, [&](int i) {
+            size_t begin = i * CHUNK, end = std::min(n, begin + CHUNK);
+            size_t j = begin;
+            for (; j + 8 <= end; j += 8) {
+                simd::v8 x = simd::load(in.data + j);
+                simd::store(out.data + j, m_act == ACT_SWISH ? simd::swish(x) : simd::sigmoid(x));
+            }
+            for (; j < end; j++) {
+                float x = in.data[j];
+                out.data[j] = m_act == ACT_SWISH ? x / (1.f + expf(-x)) : 1.f / (1.f + expf(-x));
+            }
+        });
+        tops[0] = out;
+        return true;
+    }
+
+private:
+    activation_type m_act;
+};
+
+class binary_op_layer : public layer {
+public:
+    enum { ADD, SUB, MUL, DIV, MAX, MIN, POW, RSUB, RDIV };
+
+    bool load_param(const param_dict &pd) override
+    {
+        m_op = pd.get(0, 0);
+        m_with_scalar = pd.get(1, 0) != 0;
+        m_b = pd.get(2, 0.f);
+        return m_op >= ADD && m_op <= RDIV;
+    }
+
+    static float apply(int op, float a, float b)
+    {
+        switch (op) {
+        case ADD: return a + b;
+        case SUB: return a - b;
+        case MUL: return a * b;
+        case DIV: return a / b;
+        case MAX: return std::max(a, b);
+        case MIN: return std::min(a, b);
+        case POW: return powf(a, b);
+        case RSUB: return b - a;
+        default: return b / a;
+        }
+    }
+
+    bool forward(const std::vector<tensor> &bottoms, std::vector<tensor> &tops, thread_pool &) const override
+    {
+        const tensor &a = bottoms[0];
+        if (m_with_scalar) {
+            tensor out = make_tensor(shape_of(a));
+            size_t n = a.total();
+            for (size_t i = 0; i < n; i++)
+                out.data[i] = apply(m_op, a.data[i], m_b);
+            tops[0] = out;
+            return true;
+        }
+
+        // numpy broadcasting, shapes right-aligned on w
+        const tensor &b = bottoms[1];
+        std::vector<int> sa = shape_of(a), sb = shape_of(b);
+        size_t rank = std::max(sa.size(), sb.size());
+        sa.insert(sa.begin(), rank - sa.size(), 1);
+        sb.insert(sb.begin(), rank - sb.size(), 1);
+        std::vector<int> so(rank);
+        for (size_t i = 0; i < rank; i++) {
+            if (sa[i] != sb[i] && sa[i] != 1 && sb[i] != 1)
+                return false;
+            so[i] = std::max(sa[i], sb[i]);
+        }
+        tensor out = make_tensor(so);
+
+        if (sa == sb) {
+            size_t n = out.total();
+            const float *pa = a.data, *pb = b.data;
+            float *po = out.data;
+            switch (m_op) {
+            case ADD: for (size_t i = 0; i < n; i++) po[i] = pa[i] + pb[i]; break;
+            case SUB: for (size_t i = 0; i < n; i++) po[i] = pa[i] - pb[i]; break;
+            case MUL: for (size_t i = 0; i < n; i++) po[i] = pa[i] * pb[i]; break;
+            default: for (size_t i = 0; i < n; i++) po[i] = apply(m_op, pa[i], pb[i]); break;
+            }
+            tops[0] = out;
+            return true;
+        }
+
+        // strides of zero repeat a size-one axis
+        std::vector<size_t> stride_a(rank), stride_b(rank);
+        size_t step_a = 1, step_b = 1;
+        for (size_t i = rank; i-- > 0;) {
+            stride_a[i] = sa[i] == 1 ? 0 : step_a;
+            stride_b[i] = sb[i] == 1 ? 0 : step_b;
+            step_a *= sa[i];
+            step_b *= sb[i];
+        }
+        std::vector<int> index(rank, 0);
+        size_t n = out.total();
+        for (size_t i = 0; i < n; i++) {
+            size_t ia = 0, ib = 0;
+            for (size_t k = 0; k < rank; k++) {
+                ia += index[k] * stride_a[k];
+                ib += index[k] * stride_b[k];
+            }
+            out.data[i] = apply(m_op, a.data[ia], b.data[ib]);
+            for (size_t k = rank; k-- > 0;) {
+                if (++index[k] < so[k])
+                    break;
+                index[k] = 0;
+            }
+        }
+        tops[0] = out;
+        return true;
+    }
+
+private:
+    int m_op = ADD;
+    bool m_with_scalar = false;
+    float m_b = 0;
+};
+
+class concat_layer : public layer {
+public:
+    bool load_param(const param_dict &pd) override
+    {
+        m_axis = pd.get(0, 0);
+        return true;
+    }
+
+    bool forward(const std::vector<tensor> &bottoms, std::vector<tensor> &tops, thread_pool &) const override
+    {
+        std::vector<int> shape = shape_of(bottoms[0]);
+        int axis = positive_axis(m_axis, (int)shape.size());
+        int extent = 0;
+        for (const tensor &t : bottoms) {
+            std::vector<int> s = shape_of(t);
+            if (s.size() != shape.size())
+                return false;
+            extent += s[axis];
+        }
+        shape[axis] = extent;
+        tensor out = make_tensor(shape);
+
+        size_t outer, inner;
+        around_axis(shape, axis, outer, inner);
+        size_t out_row = (size_t)extent * inner, offset = 0;
+        for (const tensor &t : bottoms) {
+            size_t row = (size_t)shape_of(t)[axis] * inner;
+            for (size_t o = 0; o < outer; o++)
+                memcpy(out.data + o * out_row + offset, t.data + o * row, row * sizeof(float));
+            offset += row;
+        }
+        tops[0] = out;
+        return true;
+    }
+
+private:
+    int m_axis = 0;
+};
+
+class slice_layer : public layer {
+public:
+    bool load_param(const param_dict &pd) override
+    {
+        for (float s : pd.get_array(0))
+            m_slices.push_back((int)s);
+        m_axis = pd.get(1, 0);
+        return !m_slices.empty();
+    }
+
+    bool forward(const std::vector<tensor> &bottoms, std::vector<tensor> &tops, thread_pool &) const override
+    {
+        const tensor &in = bottoms[0];
+        std::vector<int> shape = shape_of(in);
+        int axis = positive_axis(m_axis, (int)shape.size());
+        size_t outer, inner;
+        around_axis(shape, axis, outer, inner);
+
+        int start = 0;
+        for (size_t i = 0; i < tops.size(); i++) {
+            int n = m_slices[i];
+            if (n == -233)
+                n = (shape[axis] - start) / (int)(tops.size() - i);
+            if (n < 0 || start + n > shape[axis])
+                return false;
+
+            std::vector<int> s = shape;
+            s[axis] = n;
+            if (outer == 1) {
+                // a contiguous range: share the input's storage
+                tensor view = in;
+                view.data = in.data + (size_t)start * inner;
+                tensor shaped = make_tensor(s);
+                view.dims = shaped.dims;
+                view.w = shaped.w;
+                view.h = shaped.h;
+                view.d = shaped.d;
+                view.c = shaped.c;
+                tops[i] = view;
+            } else {
+                tensor out = make_tensor(s);
+                for (size_t o = 0; o < outer; o++)
+                    memcpy(out.data + o * n * inner, in.data + (o * shape[axis] + start) * inner,
+                           n * inner * sizeof(float));
+                tops[i] = out;
+            }
+            start += n;
+        }
+        return true;
+    }
+
+private:
+    std::vector<int> m_slices;
+    int m_axis = 0;
+};
+
+class reshape_layer : public layer {
+public:
+    bool load_param(const param_dict &pd) override
+    {
+        m_w = pd.get(0, -233);
+        m_h = pd.get(1, -233);
+        m_d = pd.get(11, -233);
+        m_c = pd.get(2, -233);
+        return pd.get(3, 0) == 0; // legacy permute flag
+    }
+
+    bool forward(const std::vector<tensor> &bottoms, std::vector<tensor> &tops, thread_pool &) const override
+    {
+        const tensor &in = bottoms[0];
+        int dims = m_h == -233 ? 1 : m_c == -233 ? 2 : m_d == -233 ? 3 : 4;
+        int want[4] = {m_w, m_h, m_d, m_c};
+        int have[4] = {in.w, in.h, in.d, in.c};
+        int used[4] = {dims >= 1, dims >= 2, dims == 4, dims >= 3};
+
+        size_t known = 1;
+        int infer = -1;
+        for (int i = 0; i < 4; i++) {
+            if (!used[i]) {
+                want[i] = 1;
+                continue;
+            }
+            if (want[i] == 0)
+                want[i] = have[i];
+            if (want[i] == -1)
+                infer = i;
+            else
+                known *= want[i];
+        }
+        if (infer >= 0)
+            want[infer] = (int)(in.total() / known);
+        if ((size_t)want[0] * want[1] * want[2] * want[3] != in.total())
+            return false;
+        tops[0] = in.reshaped(dims, want[0], want[1], want[2], want[3]);
+        return true;
+    }
+
+private:
+    int m_w, m_h, m_d, m_c;
+};
+
+class permute_layer : public layer {
+public:
+    bool load_param(const param_dict &pd) override
+    {
+        m_order = pd.get(0, 0);
+        return m_order >= 0 && m_order <= 5;
+    }
+
+    bool forward(const std::vector<tensor> &bottoms, std::vector<tensor> &tops, thread_pool &) const override
+    {
+        const tensor &in = bottoms[0];
+        if (in.dims == 2) {
+            if (m_order == 0) {
+                tops[0] = in;
+                return true;
+            }
+            tensor out = tensor::make_2d(in.h, in.w);
+            for (int y = 0; y < in.h; y++)
+                for (int x = 0; x < in.w; x++)
+                    out.data[(size_t)x * in.h + y] = in.data[(size_t)y * in.w + x];
+            tops[0] = out;
+            return true;
+        }
+        if (in.dims != 3)
+            return false;
+
+        // which input axis (0 = w, 1 = h, 2 = c) becomes output w, h and c
+        static const int ORDERS[6][3] = {{0, 1, 2}, {1, 0, 2}, {0, 2, 1}, {2, 0, 1}, {1, 2, 0}, {2, 1, 0}};
+        const int *order = ORDERS[m_order];
+        int extent[3] = {in.w, in.h, in.c};
+        size_t stride[3] = {1, (size_t)in.w, (size_t)in.w * in.h};
+        tensor out = tensor::make_3d(extent[order[0]], extent[order[1]], extent[order[2]]);
+        size_t sx = stride[order[0]], sy = stride[order[1]], sq = stride[order[2]];
+
+        float *dst = out.data;
+        for (int q = 0; q < out.c; q++)
+            for (int y = 0; y < out.h; y++) {
+                const float *src = in.data + q * sq + y * sy;
+                for (int x = 0; x < out.w; x++)
+                    *dst++ = src[x * sx];
+            }
+        tops[0] = out;
+        return true;
+    }
+
+private:
+    int m_order = 0;
+};
+
+class softmax_layer : public layer {
+public:
+    bool load_param(const param_dict &pd) override
+    {
+        m_axis = pd.get(0, 0);
+        return true;
+    }
+
+    bool forward(const std::vector<tensor> &bottoms, std::vector<tensor> &tops, thread_pool &pool) const override
+    {
+        const tensor &in = bottoms[0];
+        std::vector<int> shape = shape_of(in);
+        int axis = positive_axis(m_axis, (int)shape.size());
+        size_t outer, inner;
+        around_axis(shape, axis, outer, inner);
+        size_t n = shape[axis];
+        tensor out = make_tensor(shape);
+
+        pool.parallel_for((int)outer, [&](int o) {
+            const float *src = in.data + o * n * inner;
+            float *dst = out.data + o * n * inner;
+            if (inner == 1) {
+                float m = -FLT_MAX, sum = 0;
+                for (size_t i = 0; i < n; i++)
+                    m = std::max(m, src[i]);
+                for (size_t i = 0; i < n; i++) {
+                    dst[i] = expf(src[i] - m);
+                    sum += dst[i];
+                }
+                for (size_t i = 0; i < n; i++)
+                    dst[i] /= sum;
+                return;
+            }
+            // reduce across rows, vectorising over the inner extent
+            std::vector<float> m(src, src + inner), sum(inner, 0.f);
+            for (size_t i = 1; i < n; i++)
+                for (size_t j = 0; j < inner; j++)
+                    m[j] = std::max(m[j], src[i * inner + j]);
+            for (size_t i = 0; i < n; i++) {
+                size_t j = 0;
+                for (; j + 8 <= inner; j += 8) {
+                    simd::v8 e = simd::exp(simd::load(src + i * inner + j) - simd::load(&m[j]));
+                    simd::store(dst + i * inner + j, e);
+                    simd::store(&sum[j], simd::load(&sum[j]) + e);
+                }
+                for (; j < inner; j++) {
+                    dst[i * inner + j] = expf(src[i * inner + j] - m[j]);
+                    sum[j] += dst[i * inner + j];
+                }
+            }
+            for (size_t j = 0; j < inner; j++)
+                sum[j] = 1.f / sum[j];
+            for (size_t i = 0; i < n; i++)
+                for (size_t j = 0; j < inner; j++)
+                    dst[i * inner + j] *= sum[j];
+        });
+        tops[0] = out;
+        return true;
+    }
+
+private:
+    int m_axis = 0;
+};
+
+class pooling_layer : public layer {
+public:
+    bool load_param(const param_dict &pd) override
+    {
+        m_type = pd.get(0, 0);
+        m_kernel_w = pd.get(1, 0);
+        m_kernel_h = pd.get(11, m_kernel_w);
+        m_stride_w = pd.get(2, 1);
+        m_stride_h = pd.get(12, m_stride_w);
+        m_pad_left = pd.get(3, 0);
+        m_pad_right = pd.get(14, m_pad_left);
+        m_pad_top = pd.get(13, m_pad_left);
+        m_pad_bottom = pd.get(15, m_pad_top);
+        m_global = pd.get(4, 0) != 0;
+        m_pad_mode = pd.get(5, 0);
+        m_count_include_pad = pd.get(6, 0) != 0;
+        return (m_type == 0 || m_type == 1) && pd.get(7, 0) == 0;
+    }
+
+    bool forward(const std::vector<tensor> &bottoms, std::vector<tensor> &tops, thread_pool &pool) const override
+    {
+        const tensor &in = bottoms[0];
+        if (in.dims != 3)
+            return false;
+        if (m_global) {
+            tensor out = tensor::make_1d(in.c);
+            for (int q = 0; q < in.c; q++) {
+                const float *p = in.channel(q);
+                float acc = m_type == 0 ? -FLT_MAX : 0.f;
+                for (size_t i = 0; i < in.plane(); i++)
+                    acc = m_type == 0 ? std::max(acc, p[i]) : acc + p[i];
+                out.data[q] = m_type == 0 ? acc : acc / in.plane();
+            }
+            tops[0] = out;
+            return true;
+        }
+
+        int pl = m_pad_left, pr = m_pad_right, pt = m_pad_top, pb = m_pad_bottom;
+        if (m_pad_mode == 0) {
+            // full padding: extend right/bottom until the last window fits
+            int wtail = (in.w + pl + pr - m_kernel_w) % m_stride_w;
+            int htail = (in.h + pt + pb - m_kernel_h) % m_stride_h;
+            if (wtail)
+                pr += m_stride_w - wtail;
+            if (htail)
+                pb += m_stride_h - htail;
+        } else if (m_pad_mode == 2 || m_pad_mode == 3) {
+            int wpad = std::max(0, ((in.w + m_stride_w - 1) / m_stride_w - 1) * m_stride_w + m_kernel_w - in.w);
+            int hpad = std::max(0, ((in.h + m_stride_h - 1) / m_stride_h - 1) * m_stride_h + m_kernel_h - in.h);
+            pl = m_pad_mode == 2 ? wpad / 2 : wpad - wpad / 2;
+            pt = m_pad_mode == 2 ? hpad / 2 : hpad - hpad / 2;
+            pr = wpad - pl;
+            pb = hpad - pt;
+        }
+        int outw = (in.w + pl + pr - m_kernel_w) / m_stride_w + 1;
+        int outh = (in.h + pt + pb - m_kernel_h) / m_stride_h + 1;
+        tensor out = tensor::make_3d(outw, outh, in.c);
+
+        pool.parallel_for(in.c, [&](int q) {
+            const float *src = in.channel(q);
+            float *dst = out.channel(q);
+            for (int oy = 0; oy < outh; oy++) {
+                int y0 = oy * m_stride_h - pt;
+                int ya = std::max(y0, 0), yb = std::min(y0 + m_kernel_h, in.h);
+                for (int ox = 0; ox < outw; ox++) {
+                    int x0 = ox * m_stride_w - pl;
+                    int xa = std::max(x0, 0), xb = std::min(x0 + m_kernel_w, in.w);
+                    float acc = m_type == 0 ? -FLT_MAX : 0.f;
+                    for (int y = ya; y < yb; y++)
+                        for (int x = xa; x < xb; x++)
+                            acc = m_type == 0 ? std::max(acc, src[y * in.w + x]) : acc + src[y * in.w + x];
+                    if (m_type == 1) {
+                        int count = m_count_include_pad ? m_kernel_w * m_kernel_h : (yb - ya) * (xb - xa);
+                        acc /= count;
+                    }
+                    dst[oy * outw + ox] = acc;
+                }
+            }
+        });
+        tops[0] = out;
+        return true;
+    }
+
+private:
+    int m_type, m_kernel_w, m_kernel_h, m_stride_w, m_stride_h;
+    int m_pad_left, m_pad_right, m_pad_top, m_pad_bottom, m_pad_mode;
+    bool m_global, m_count_include_pad;
+};
+
+class interp_layer : public layer {
+public:
+    bool load_param(const param_dict &pd) override
+    {
+        m_type = pd.get(0, 0);
+        m_height_scale = pd.get(1, 1.f);
+        m_width_scale = pd.get(2, 1.f);
+        m_out_h = pd.get(3, 0);
+        m_out_w = pd.get(4, 0);
+        m_align_corner = pd.get(7, 0) != 0;
+        return (m_type == 1 || m_type == 2) && pd.get(6, 0) == 0;
+    }
+
+    bool forward(const std::vector<tensor> &bottoms, std::vector<tensor> &tops, thread_pool &pool) const override
+    {
+        const tensor &in = bottoms[0];
+        if (in.dims != 3)
+            return false;
+        int outw = m_out_w ? m_out_w : (int)(in.w * m_width_scale);
+        int outh = m_out_h ? m_out_h : (int)(in.h * m_height_scale);
+        tensor out = tensor::make_3d(outw, outh, in.c);
+        float sx = m_out_w ? (float)in.w / outw : 1.f / m_width_scale;
+        float sy = m_out_h ? (float)in.h / outh : 1.f / m_height_scale;
+
+        pool.parallel_for(in.c, [&](int q) {
+            const float *src = in.channel(q);
+            float *dst = out.channel(q);
+            for (int y = 0; y < outh; y++) {
+                if (m_type == 1) {
+                    const float *row = src + std::min((int)(y * sy), in.h - 1) * in.w;
+                    for (int x = 0; x < outw; x++)
+                        dst[x] = row[std::min((int)(x * sx), in.w - 1)];
+                } else {
+                    float fy = m_align_corner ? y * (float)(in.h - 1) / std::max(outh - 1, 1) : (y + 0.5f) * sy - 0.5f;
+                    fy = std::max(fy, 0.f);
+                    int y0 = std::min((int)fy, in.h - 1), y1 = std::min(y0 + 1, in.h - 1);
+                    float wy = fy - y0;
+                    for (int x = 0; x < outw; x++) {
+                        float fx = m_align_corner ? x * (float)(in.w - 1) / std::max(outw - 1, 1) : (x + 0.5f) * sx - 0.5f;
+                        fx = std::max(fx, 0.f);
+                        int x0 = std::min((int)fx, in.w - 1), x1 = std::min(x0 + 1, in.w - 1);
+                        float wx = fx - x0;
+                        float top = src[y0 * in.w + x0] * (1 - wx) + src[y0 * in.w + x1] * wx;
+                        float bottom = src[y1 * in.w + x0] * (1 - wx) + src[y1 * in.w + x1] * wx;
+                        dst[x] = top * (1 - wy) + bottom * wy;
+                    }
+                }
+                dst += outw;
+            }
+        });
+        tops[0] = out;
+        return true;
+    }
+
+private:
+    int m_type, m_out_w, m_out_h;
+    float m_height_scale, m_width_scale;
+    bool m_align_corner;
+};
+
+// Batched matrix product over the channels of 2D/3D operands
+class matmul_layer : public layer {
+public:
+    bool load_param(const param_dict &pd) override
+    {
+        m_trans_b = pd.get(0, 0) != 0;
+        return true;
+    }
+
+    bool forward(const std::vector<tensor> &bottoms, std::vector<tensor> &tops, thread_pool &pool) const override
+    {
+        const tensor &a = bottoms[0], &b = bottoms[1];
+        if (a.dims < 2 || a.dims > 3 || b.dims < 2 || b.dims > 3)
+            return false;
+        int m = a.h, k = a.w;
+        int n = m_trans_b ? b.h : b.w;
+        if ((m_trans_b ? b.w : b.h) != k)
+            return false;
+        int batch = std::max(a.c, b.c);
+        if ((a.c != batch && a.c != 1) || (b.c != batch && b.c != 1))
+            return false;
+        tensor out = a.dims == 3 || b.dims == 3 ? tensor::make_3d(n, m, batch) : tensor::make_2d(n, m);
+
+        // B as k x n rows, so the inner loop runs along contiguous output
+        tensor bt = b;
+        if (m_trans_b) {
+            bt = tensor::make_3d(n, k, b.c);
+            for (int q = 0; q < b.c; q++)
+                for (int j = 0; j < n; j++)
+                    for (int i = 0; i < k; i++)
+                        bt.channel(q)[(size_t)i * n + j] = b.channel(q)[(size_t)j * k + i];
+        }
+
+        pool.parallel_for(batch * m, [&](int item) {
+            int q = item / m, i = item % m;
+            const float *arow = a.channel(a.c == 1 ? 0 : q) + (size_t)i * k;
+            const float *bmat = bt.channel(bt.c == 1 ? 0 : q);
+            float *orow = out.channel(q) + (size_t)i * n;
+            memset(orow, 0, n * sizeof(float));
+            for (int p = 0; p < k; p++) {
+                float s = arow[p];
+                const float *brow = bmat + (size_t)p * n;
+                int j = 0;
+                for (; j + 8 <= n; j += 8)
+                    simd::store(orow + j, simd::load(orow + j) + simd::load(brow + j) * s);
+                for (; j < n; j++)
+                    orow[j] += brow[j] * s;
+            }
+        });
+        tops[0] = out;
+        return true;
+    }
+
+private:
+    bool m_trans_b = false;
+};
+
+class memory_data_layer : public layer {
+public:
+    bool load_param(const param_dict &pd) override
+    {
+        m_w = pd.get(0, 0);
+        m_h = pd.get(1, 0);
+        m_d = pd.get(11, 0);
+        m_c = pd.get(2, 0);
+        return pd.get(21, 1) == 1;
+    }
+
+    bool load_model(model_reader &mr) override
+    {
+        if (m_d)
+            m_data = tensor::make(4, m_w, m_h, m_d, m_c);
+        else if (m_c)
+            m_data = tensor::make_3d(m_w, m_h, m_c);
+        else if (m_h)
+            m_data = tensor::make_2d(m_w, m_h);
+        else
+            m_data = tensor::make_1d(std::max(m_w, 1));
+        std::vector<float> values;
+        if (!mr.read_raw(m_data.total(), values))
+            return false;
+        memcpy(m_data.data, values.data(), values.size() * sizeof(float));
+        return true;
+    }
+
+    bool forward(const std::vector<tensor> &, std::vector<tensor> &tops, thread_pool &) const override
+    {
+        tops[0] = m_data;
+        return true;
+    }
+
+private:
+    int m_w, m_h, m_d, m_c;
+    tensor m_data;
+};
+
+} // namespace
+
+bool layer::forward_batch(const std::vector<std::vector<tensor>> &bottoms, std::vector<std::vector<tensor>> &tops,
+                          thread_pool &pool) const
+{
+    for (size_t s = 0; s < bottoms.size(); s++)
+        if (!forward(bottoms[s], tops[s], pool))
+            return false;
+    return true;
+}
+
+std::unique_ptr<layer> create_layer(const std::string &type)
+{
+    std::unique_ptr<layer> l;
+    if (type == "Input")
+        l.reset(new input_layer);
+    else if (type == "Convolution")
+        l = create_convolution();
+    else if (type == "ConvolutionDepthWise")
+        l = create_convolution_depthwise();
+    else if (type == "Swish")
+        l.reset(new activation_layer(ACT_SWISH));
+    else if (type == "Sigmoid")
+        l.reset(new activation_layer(ACT_SIGMOID));
+    else if (type == "Split")
+        l.reset(new split_layer);
+    else if (type == "Slice")
+        l.reset(new slice_layer);
+    else if (type == "Concat")
+        l.reset(new concat_layer);
+    else if (type == "BinaryOp")
+        l.reset(new binary_op_layer);
+    else if (type == "Reshape")
+        l.reset(new reshape_layer);
+    else if (type == "Permute")
+        l.reset(new permute_layer);
+    else if (type == "Softmax")
+        l.reset(new softmax_layer);
+    else if (type == "Pooling")
+        l.reset(new pooling_layer);
+    else if (type == "Interp")
+        l.reset(new interp_layer);
+    else if (type == "MatMul")
+        l.reset(new matmul_layer);
+    else if (type == "MemoryData")
+        l.reset(new memory_data_layer);
+    if (l)
+        l->type = type;
+    return l;
+}
+
+} // namespace edge
@@ -0,0 +1,88 @@
+// Layers of an ncnn graph, as written by pnnx for the YOLO export.
+//
+// Parameters and weights follow ncnn's param/bin formats, so a layer reads
+// the same ids (0=num_output, 1=kernel_w, ...) as its ncnn counterpart and
+// produces the same numbers. Only the layer types and options the detector
+// uses are implemented; anything else fails to load with a message rather
+// than computing something different.
+#pragma once
+
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensor.h"
+#include "thread_pool.h"
+
+namespace edge {
+
+// key=value pairs of one param line; arrays use ids -23300 - key
+class param_dict {
+public:
+    bool parse(const std::vector<std::string> &tokens, size_t first);
+
+    int get(int id, int def) const;
+    float get(int id, float def) const;
+    std::vector<float> get_array(int id) const;
+    bool has(int id) const { return m_values.count(id) != 0; }
+
+private:
+    std::map<int, std::vector<float>> m_values;
+};
+
+// Sequential reader of model.ncnn.bin
+class model_reader {
+public:
+    explicit model_reader(FILE *file)
+        : m_file(file)
+    {
+    }
+
+    // A weight blob: 4-byte storage tag followed by fp32 or fp16 data
+    bool read_tagged(size_t count, std::vector<float> &out);
+    // Raw fp32 data without a tag (biases, MemoryData)
+    bool read_raw(size_t count, std::vector<float> &out);
+
+private:
+    FILE *m_file;
+};
+
+enum activation_type {
+    ACT_NONE = 0,
+    ACT_RELU = 1,
+    ACT_SIGMOID = 4,
+    ACT_SWISH = 100, // not an ncnn value: set when a Swish layer is fused in
+};
+
+class layer {
+public:
+    virtual ~layer() = default;
+
+    virtual bool load_param(const param_dict &) { return true; }
+    virtual bool load_model(model_reader &) { return true; }
+    virtual bool forward(const std::vector<tensor> &bottoms, std::vector<tensor> &tops, thread_pool &pool) const = 0;
+    // forward() for each sample of a batch, [sample][blob]. Layers whose
+    // work per sample is too small to keep every thread busy override it
+    // to spread one parallel_for over the whole batch.
+    virtual bool forward_batch(const std::vector<std::vector<tensor>> &bottoms, std::vector<std::vector<tensor>> &tops,
+                               thread_pool &pool) const;
+
+    // Lets a following Swish/Sigmoid run inside this layer's output loop
+    virtual bool fuse_activation(activation_type) { return false; }
+
+    std::string type;
+    std::string name;
+    std::vector<int> bottoms;
+    std::vector<int> tops;
+};
+
+// nullptr for a type this runtime does not implement
+std::unique_ptr<layer> create_layer(const std::string &type);
+
+// Shape as a list of extents, outermost first: (c, d, h, w) trimmed to dims
+std::vector<int> shape_of(const tensor &t);
+tensor make_tensor(const std::vector<int> &shape);
+
+} // namespace edge
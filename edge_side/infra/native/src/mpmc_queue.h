@@ -0,0 +1,161 @@
+// Bounded lock-free multi-producer multi-consumer queue.
+//
+// Each cell carries a sequence number telling producers and consumers whose
+// turn it is, so push and pop are one CAS on a shared index plus a release
+// store on the cell, and never take a lock. A full or empty queue returns
+// false immediately; callers that want to sleep pair it with a semaphore.
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace edge {
+
+template <typename T>
+class mpmc_queue {
+public:
+    explicit mpmc_queue(size_t capacity)
+    {
+        size_t n = 2;
+        while (n < capacity)
+            n <<= 1;
+        m_mask = n - 1;
+        m_cells.reset(new cell[n]);
+        for (size_t i = 0; i < n; i++)
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    ~mpmc_queue()
+    {
+        T item;
+        while (try_pop(item)) {
+        }
+    }
+
+    mpmc_queue(const mpmc_queue &) = delete;
+    mpmc_queue &operator=(const mpmc_queue &) = delete;
+
+    bool try_push(T &&item)
+    {
+        size_t pos = m_enqueue.load(std::memory_order_relaxed);
+        for (;;) {
+            cell &c = m_cells[pos & m_mask];
+            size_t seq = c.sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (m_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    new (&c.storage) T(std::move(item));
+                    c.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_enqueue.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool try_pop(T &item)
+    {
+        size_t pos = m_dequeue.load(std::memory_order_relaxed);
+        for (;;) {
+            cell &c = m_cells[pos & m_mask];
+            size_t seq = c.sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (diff == 0) {
+                if (m_dequeue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    T *stored = reinterpret_cast<T *>(&c.storage);
+                    item = std::move(*stored);
+                    stored->~T();
+                    c.sequence.store(pos + m_mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_dequeue.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    size_t capacity() const { return m_mask + 1; }
+
+    // Only a hint while other threads push and pop
+    size_t size_approx() const
+    {
+        size_t tail = m_dequeue.load(std::memory_order_relaxed);
+        size_t head = m_enqueue.load(std::memory_order_relaxed);
+        return head > tail ? head - tail : 0;
+    }
+
+private:
+    struct cell {
+        std::atomic<size_t> sequence;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    };
+
+    std::unique_ptr<cell[]> m_cells;
+    size_t m_mask;
+    alignas(64) std::atomic<size_t> m_enqueue{0};
+    alignas(64) std::atomic<size_t> m_dequeue{0};
+};
+
+// Counting semaphore that only touches the mutex when a thread has to sleep.
+// Used to park consumers of an mpmc_queue: post() after each push, wait()
+// before retrying a pop. Extra posts only cause a spurious wake-up.
+class semaphore {
+public:
+    void post(int n = 1)
+    {
+        int old = m_count.fetch_add(n, std::memory_order_release);
+        int waiters = old < 0 ? -old : 0;
+        if (waiters) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_wakeups += n < waiters ? n : waiters;
+            if (n > 1)
+                m_cond.notify_all();
+            else
+                m_cond.notify_one();
+        }
+    }
+
+    // Returns false if the timeout passed without a post
+    bool wait_for(std::chrono::microseconds timeout)
+    {
+        int old = m_count.fetch_sub(1, std::memory_order_acquire);
+        if (old > 0)
+            return true;
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_cond.wait_for(lock, timeout, [this] { return m_wakeups > 0; })) {
+            m_wakeups--;
+            return true;
+        }
+        // give the count back unless a post raced with the timeout
+        int count = m_count.load(std::memory_order_relaxed);
+        while (count < 0) {
+            if (m_count.compare_exchange_weak(count, count + 1, std::memory_order_relaxed))
+                return false;
+        }
+        m_cond.wait(lock, [this] { return m_wakeups > 0; });
+        m_wakeups--;
+        return true;
+    }
+
+private:
+    std::atomic<int> m_count{0};
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    int m_wakeups = 0;
+};
+
+} // namespace edge
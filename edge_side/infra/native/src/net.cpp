@@ -0,0 +1,227 @@
+#include "net.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
+namespace edge {
+
+net::net(int threads)
+    : m_pool(threads)
+{
+}
+
+net::~net() = default;
+
+int net::blob_index(const std::string &name) const
+{
+    for (size_t i = 0; i < m_blob_names.size(); i++)
+        if (m_blob_names[i] == name)
+            return (int)i;
+    return -1;
+}
+
+bool net::load(const std::string &param_path, const std::string &bin_path)
+{
+    FILE *param = fopen(param_path.c_str(), "r");
+    if (!param) {
+        fprintf(stderr, "[Net] Cannot open %s\n", param_path.c_str());
+        return false;
+    }
+    bool ok = load_param(param);
+    fclose(param);
+    if (!ok)
+        return false;
+
+    FILE *bin = fopen(bin_path.c_str(), "rb");
+    if (!bin) {
+        fprintf(stderr, "[Net] Cannot open %s\n", bin_path.c_str());
+        return false;
+    }
+    model_reader reader(bin);
+    for (auto &l : m_layers) {
+        if (!l->load_model(reader)) {
+            fprintf(stderr, "[Net] Cannot load weights of %s %s\n", l->type.c_str(), l->name.c_str());
+            ok = false;
+            break;
+        }
+    }
+    if (ok && fgetc(bin) != EOF) {
+        fprintf(stderr, "[Net] %s is longer than the graph expects\n", bin_path.c_str());
+        ok = false;
+    }
+    fclose(bin);
+    if (ok)
+        fuse();
+    return ok;
+}
+
+bool net::load_param(FILE *file)
+{
+    char line[4096];
+    int magic = 0, layer_count = 0, blob_count = 0;
+    if (!fgets(line, sizeof(line), file) || sscanf(line, "%d", &magic) != 1 || magic != 7767517) {
+        fprintf(stderr, "[Net] Not an ncnn param file\n");
+        return false;
+    }
+    if (!fgets(line, sizeof(line), file) || sscanf(line, "%d %d", &layer_count, &blob_count) != 2)
+        return false;
+
+    m_layers.clear();
+    m_blob_names.clear();
+    auto blob = [this](const std::string &name) {
+        int i = blob_index(name);
+        if (i < 0) {
+            i = (int)m_blob_names.size();
+            m_blob_names.push_back(name);
+        }
+        return i;
+    };
+
+    while (fgets(line, sizeof(line), file)) {
+        std::istringstream ss(line);
+        std::vector<std::string> tokens;
+        std::string token;
+        while (ss >> token)
+            tokens.push_back(token);
+        if (tokens.empty())
+            continue;
+        if (tokens.size() < 4)
+            return false;
+
+        std::unique_ptr<layer> l = create_layer(tokens[0]);
+        if (!l) {
+            fprintf(stderr, "[Net] Layer type %s is not implemented\n", tokens[0].c_str());
+            return false;
+        }
+        l->name = tokens[1];
+        size_t bottoms = std::stoul(tokens[2]), tops = std::stoul(tokens[3]);
+        if (tokens.size() < 4 + bottoms + tops)
+            return false;
+        for (size_t i = 0; i < bottoms; i++)
+            l->bottoms.push_back(blob(tokens[4 + i]));
+        for (size_t i = 0; i < tops; i++)
+            l->tops.push_back(blob(tokens[4 + bottoms + i]));
+
+        param_dict pd;
+        if (!pd.parse(tokens, 4 + bottoms + tops) || !l->load_param(pd)) {
+            fprintf(stderr, "[Net] Bad parameters for %s %s\n", l->type.c_str(), l->name.c_str());
+            return false;
+        }
+        m_layers.push_back(std::move(l));
+    }
+    if ((int)m_layers.size() != layer_count)
+        fprintf(stderr, "[Net] Expected %d layers, read %zu\n", layer_count, m_layers.size());
+    return !m_layers.empty();
+}
+
+void net::fuse()
+{
+    auto count = [this] {
+        m_producer.assign(m_blob_names.size(), -1);
+        m_consumers.assign(m_blob_names.size(), 0);
+        for (size_t i = 0; i < m_layers.size(); i++) {
+            for (int b : m_layers[i]->bottoms)
+                m_consumers[b]++;
+            for (int t : m_layers[i]->tops)
+                m_producer[t] = (int)i;
+        }
+    };
+    count();
+
+    // an activation whose input nobody else reads runs inside the convolution
+    std::vector<layer *> order;
+    for (auto &l : m_layers)
+        order.push_back(l.get());
+    std::vector<std::unique_ptr<layer>> kept;
+    for (auto &l : m_layers) {
+        if ((l->type == "Swish" || l->type == "Sigmoid") && m_consumers[l->bottoms[0]] == 1) {
+            int p = m_producer[l->bottoms[0]];
+            layer *prev = p >= 0 ? order[p] : nullptr;
+            if (prev && prev->tops.size() == 1 &&
+                prev->fuse_activation(l->type == "Swish" ? ACT_SWISH : ACT_SIGMOID)) {
+                prev->tops[0] = l->tops[0];
+                prev->name += "+" + l->name;
+                continue;
+            }
+        }
+        kept.push_back(std::move(l));
+    }
+    m_layers = std::move(kept);
+    count();
+}
+
+bool net::forward(const std::string &input, const tensor &in, const std::string &output, tensor &out,
+                  std::vector<layer_timing> *timings)
+{
+    std::vector<tensor> outs;
+    if (!forward_batch(input, {in}, output, outs, timings))
+        return false;
+    out = outs[0];
+    return true;
+}
+
+bool net::forward_batch(const std::string &input, const std::vector<tensor> &ins, const std::string &output,
+                        std::vector<tensor> &outs, std::vector<layer_timing> *timings)
+{
+    int in_blob = blob_index(input), out_blob = blob_index(output);
+    if (in_blob < 0 || out_blob < 0) {
+        fprintf(stderr, "[Net] No blob named %s\n", in_blob < 0 ? input.c_str() : output.c_str());
+        return false;
+    }
+    if (ins.empty())
+        return false;
+
+    // blobs[sample][blob]; every layer runs on the whole batch before the next
+    const size_t samples = ins.size();
+    std::vector<std::vector<tensor>> blobs(samples, std::vector<tensor>(m_blob_names.size()));
+    std::vector<int> pending = m_consumers;
+    for (size_t s = 0; s < samples; s++)
+        blobs[s][in_blob] = ins[s];
+    if (timings)
+        timings->clear();
+
+    std::vector<std::vector<tensor>> bottoms(samples), tops(samples);
+    for (auto &l : m_layers) {
+        if (l->type == "Input")
+            continue;
+        for (size_t s = 0; s < samples; s++) {
+            bottoms[s].clear();
+            for (int b : l->bottoms)
+                bottoms[s].push_back(blobs[s][b]);
+            tops[s].assign(l->tops.size(), tensor());
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        if (!l->forward_batch(bottoms, tops, m_pool)) {
+            fprintf(stderr, "[Net] %s %s failed\n", l->type.c_str(), l->name.c_str());
+            return false;
+        }
+        if (timings) {
+            double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+            timings->push_back({l->name, l->type, us});
+        }
+
+        for (size_t s = 0; s < samples; s++) {
+            for (size_t i = 0; i < tops[s].size(); i++)
+                blobs[s][l->tops[i]] = tops[s][i];
+            bottoms[s].clear();
+        }
+        // drop inputs nobody reads any more
+        for (int b : l->bottoms)
+            if (--pending[b] == 0 && b != out_blob)
+                for (size_t s = 0; s < samples; s++)
+                    blobs[s][b] = tensor();
+        if (!blobs[0][out_blob].empty()) {
+            outs.resize(samples);
+            for (size_t s = 0; s < samples; s++)
+                outs[s] = blobs[s][out_blob];
+            return true;
+        }
+    }
+    fprintf(stderr, "[Net] Blob %s was never produced\n", output.c_str());
+    return false;
+}
+
+} // namespace edge
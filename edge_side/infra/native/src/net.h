@@ -0,0 +1,58 @@
+// Inference engine for ncnn models (model.ncnn.param + model.ncnn.bin).
+//
+// Loads the graph pnnx writes for a YOLO export and runs it without the ncnn
+// library. Layers execute in file order; each blob is released as soon as
+// its last consumer has run, and Convolution + Swish pairs are fused at load.
+// A batch runs each layer on every sample before moving on, so the batch
+// shares one pass over each layer's weights and thread pool dispatch.
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "layers.h"
+#include "tensor.h"
+#include "thread_pool.h"
+
+namespace edge {
+
+struct layer_timing {
+    std::string name;
+    std::string type;
+    double us;
+};
+
+class net {
+public:
+    // threads <= 0 uses every hardware thread
+    explicit net(int threads = 0);
+    ~net();
+
+    bool load(const std::string &param_path, const std::string &bin_path);
+
+    // Feeds input into blob `input` and computes blob `output`. When timings
+    // is given it receives one entry per executed layer.
+    bool forward(const std::string &input, const tensor &in, const std::string &output, tensor &out,
+                 std::vector<layer_timing> *timings = nullptr);
+    // Same for several inputs of one shape, layer by layer across the batch.
+    // Timings are per layer for the whole batch.
+    bool forward_batch(const std::string &input, const std::vector<tensor> &ins, const std::string &output,
+                       std::vector<tensor> &outs, std::vector<layer_timing> *timings = nullptr);
+
+    int blob_index(const std::string &name) const;
+    size_t layer_count() const { return m_layers.size(); }
+    int threads() const { return m_pool.size(); }
+
+private:
+    bool load_param(FILE *file);
+    void fuse();
+
+    thread_pool m_pool;
+    std::vector<std::unique_ptr<layer>> m_layers;
+    std::vector<std::string> m_blob_names;
+    std::vector<int> m_producer;  // layer writing each blob
+    std::vector<int> m_consumers; // number of layers reading each blob
+};
+
+} // namespace edge
@@ -0,0 +1,247 @@
+#include "overlay.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+#include "frame_encoder.h"
+
+namespace edge {
+
+// 5x7 font for ' ' .. '~', one byte per column, bit 0 the top row and bit 7
+// the descender row
+static const uint8_t FONT[95][5] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00}, {0x00, 0x00, 0x5F, 0x00, 0x00}, {0x00, 0x07, 0x00, 0x07, 0x00},
+    {0x14, 0x7F, 0x14, 0x7F, 0x14}, {0x24, 0x2A, 0x7F, 0x2A, 0x12}, {0x23, 0x13, 0x08, 0x64, 0x62},
+    {0x36, 0x49, 0x56, 0x20, 0x50}, {0x00, 0x08, 0x07, 0x03, 0x00}, {0x00, 0x1C, 0x22, 0x41, 0x00},
+    {0x00, 0x41, 0x22, 0x1C, 0x00}, {0x2A, 0x1C, 0x7F, 0x1C, 0x2A}, {0x08, 0x08, 0x3E, 0x08, 0x08},
+    {0x00, 0x80, 0x70, 0x30, 0x00}, {0x08, 0x08, 0x08, 0x08, 0x08}, {0x00, 0x00, 0x60, 0x60, 0x00},
+    {0x20, 0x10, 0x08, 0x04, 0x02}, {0x3E, 0x51, 0x49, 0x45, 0x3E}, {0x00, 0x42, 0x7F, 0x40, 0x00},
+    {0x72, 0x49, 0x49, 0x49, 0x46}, {0x21, 0x41, 0x49, 0x4D, 0x33}, {0x18, 0x14, 0x12, 0x7F, 0x10},
+    {0x27, 0x45, 0x45, 0x45, 0x39}, {0x3C, 0x4A, 0x49, 0x49, 0x31}, {0x41, 0x21, 0x11, 0x09, 0x07},
+    {0x36, 0x49, 0x49, 0x49, 0x36}, {0x46, 0x49, 0x49, 0x29, 0x1E}, {0x00, 0x00, 0x14, 0x00, 0x00},
+    {0x00, 0x40, 0x34, 0x00, 0x00}, {0x00, 0x08, 0x14, 0x22, 0x41}, {0x14, 0x14, 0x14, 0x14, 0x14},
+    {0x00, 0x41, 0x22, 0x14, 0x08}, {0x02, 0x01, 0x59, 0x09, 0x06}, {0x3E, 0x41, 0x5D, 0x59, 0x4E},
+    {0x7C, 0x12, 0x11, 0x12, 0x7C}, {0x7F, 0x49, 0x49, 0x49, 0x36}, {0x3E, 0x41, 0x41, 0x41, 0x22},
+    {0x7F, 0x41, 0x41, 0x41, 0x3E}, {0x7F, 0x49, 0x49, 0x49, 0x41}, {0x7F, 0x09, 0x09, 0x09, 0x01},
+    {0x3E, 0x41, 0x41, 0x51, 0x73}, {0x7F, 0x08, 0x08, 0x08, 0x7F}, {0x00, 0x41, 0x7F, 0x41, 0x00},
+    {0x20, 0x40, 0x41, 0x3F, 0x01}, {0x7F, 0x08, 0x14, 0x22, 0x41}, {0x7F, 0x40, 0x40, 0x40, 0x40},
+    {0x7F, 0x02, 0x1C, 0x02, 0x7F}, {0x7F, 0x04, 0x08, 0x10, 0x7F}, {0x3E, 0x41, 0x41, 0x41, 0x3E},
+    {0x7F, 0x09, 0x09, 0x09, 0x06}, {0x3E, 0x41, 0x51, 0x21, 0x5E}, {0x7F, 0x09, 0x19, 0x29, 0x46},
+    {0x26, 0x49, 0x49, 0x49, 0x32}, {0x03, 0x01, 0x7F, 0x01, 0x03}, {0x3F, 0x40, 0x40, 0x40, 0x3F},
+    {0x1F, 0x20, 0x40, 0x20, 0x1F}, {0x3F, 0x40, 0x38, 0x40, 0x3F}, {0x63, 0x14, 0x08, 0x14, 0x63},
+    {0x03, 0x04, 0x78, 0x04, 0x03}, {0x61, 0x59, 0x49, 0x4D, 0x43}, {0x00, 0x7F, 0x41, 0x41, 0x41},
+    {0x02, 0x04, 0x08, 0x10, 0x20}, {0x00, 0x41, 0x41, 0x41, 0x7F}, {0x04, 0x02, 0x01, 0x02, 0x04},
+    {0x40, 0x40, 0x40, 0x40, 0x40}, {0x00, 0x03, 0x07, 0x08, 0x00}, {0x20, 0x54, 0x54, 0x78, 0x40},
+    {0x7F, 0x28, 0x44, 0x44, 0x38}, {0x38, 0x44, 0x44, 0x44, 0x28}, {0x38, 0x44, 0x44, 0x28, 0x7F},
+    {0x38, 0x54, 0x54, 0x54, 0x18}, {0x00, 0x08, 0x7E, 0x09, 0x02}, {0x18, 0xA4, 0xA4, 0x9C, 0x78},
+    {0x7F, 0x08, 0x04, 0x04, 0x78}, {0x00, 0x44, 0x7D, 0x40, 0x00}, {0x20, 0x40, 0x40, 0x3D, 0x00},
+    {0x7F, 0x10, 0x28, 0x44, 0x00}, {0x00, 0x41, 0x7F, 0x40, 0x00}, {0x7C, 0x04, 0x78, 0x04, 0x78},
+    {0x7C, 0x08, 0x04, 0x04, 0x78}, {0x38, 0x44, 0x44, 0x44, 0x38}, {0xFC, 0x18, 0x24, 0x24, 0x18},
+    {0x18, 0x24, 0x24, 0x18, 0xFC}, {0x7C, 0x08, 0x04, 0x04, 0x08}, {0x48, 0x54, 0x54, 0x54, 0x24},
+    {0x04, 0x04, 0x3F, 0x44, 0x24}, {0x3C, 0x40, 0x40, 0x20, 0x7C}, {0x1C, 0x20, 0x40, 0x20, 0x1C},
+    {0x3C, 0x40, 0x30, 0x40, 0x3C}, {0x44, 0x28, 0x10, 0x28, 0x44}, {0x4C, 0x90, 0x90, 0x90, 0x7C},
+    {0x44, 0x64, 0x54, 0x4C, 0x44}, {0x00, 0x08, 0x36, 0x41, 0x00}, {0x00, 0x00, 0x77, 0x00, 0x00},
+    {0x00, 0x41, 0x36, 0x08, 0x00}, {0x02, 0x01, 0x02, 0x04, 0x02},
+};
+static const int GLYPH_W = 5, GLYPH_H = 8, ADVANCE = 6;
+
+static rect clip(rect r, const bgr_view &image)
+{
+    return {std::max(r.x0, 0), std::max(r.y0, 0), std::min(r.x1, image.width), std::min(r.y1, image.height)};
+}
+
+static bool empty(const rect &r)
+{
+    return r.x0 >= r.x1 || r.y0 >= r.y1;
+}
+
+static int round_px(float v)
+{
+    return (int)std::lround(v);
+}
+
+overlay_renderer::overlay_renderer(const overlay_style &style)
+    : m_style(style)
+{
+}
+
+color overlay_renderer::class_color(int cls)
+{
+    static const uint32_t PALETTE[20] = {0xFF3838, 0xFF9D97, 0xFF701F, 0xFFB21D, 0xCFD231, 0x48F90A, 0x92CC17,
+                                         0x3DDB86, 0x1A9334, 0x00D4BB, 0x2C99A8, 0x00C2FF, 0x344593, 0x6473FF,
+                                         0x0018EC, 0x8438FF, 0x520085, 0xCB38FF, 0xFF95C8, 0xFF37C7};
+    uint32_t rgb = PALETTE[(unsigned)cls % 20];
+    return {(uint8_t)rgb, (uint8_t)(rgb >> 8), (uint8_t)(rgb >> 16)};
+}
+
+void overlay_renderer::paint(bgr_view image, rect r, color c)
+{
+    r = clip(r, image);
+    if (empty(r) || m_planning)
+        return;
+    // one pixel, then doubling copies of what is there: a run of any length
+    // takes log2(width) memcpys, and every row after that one more
+    size_t run = (size_t)(r.x1 - r.x0) * 3;
+    if (m_run.size() < run)
+        m_run.resize(run);
+    m_run[0] = c.b;
+    m_run[1] = c.g;
+    m_run[2] = c.r;
+    for (size_t have = 3; have < run; have *= 2)
+        memcpy(&m_run[have], &m_run[0], std::min(have, run - have));
+
+    size_t stride = (size_t)image.width * 3;
+    uint8_t *row = image.data + (size_t)r.y0 * stride + (size_t)r.x0 * 3;
+    for (int y = r.y0; y < r.y1; y++, row += stride)
+        memcpy(row, m_run.data(), run);
+}
+
+void overlay_renderer::fill(bgr_view image, rect r, color c)
+{
+    paint(image, r, c);
+    r = clip(r, image);
+    if (!empty(r))
+        m_dirty.push_back(r);
+}
+
+void overlay_renderer::outline(bgr_view image, rect r, int width, color c)
+{
+    int lo = width / 2, hi = width - lo;
+    int x0 = r.x0 - lo, y0 = r.y0 - lo, x1 = r.x1 + hi, y1 = r.y1 + hi;
+    // four bands, so the inside stays untouched and out of dirty()
+    fill(image, {x0, y0, x1, y0 + width}, c);
+    fill(image, {x0, y1 - width, x1, y1}, c);
+    fill(image, {x0, y0 + width, x0 + width, y1 - width}, c);
+    fill(image, {x1 - width, y0 + width, x1, y1 - width}, c);
+}
+
+int overlay_renderer::text_width(const char *s, int scale)
+{
+    size_t n = strlen(s);
+    return n ? (int)(n * ADVANCE - (ADVANCE - GLYPH_W)) * scale : 0;
+}
+
+int overlay_renderer::text_height(int scale)
+{
+    return GLYPH_H * scale;
+}
+
+int overlay_renderer::text(bgr_view image, int x, int y, const char *s, int scale, color c)
+{
+    size_t n = strlen(s);
+    // each glyph row of the whole string at once, as horizontal runs of set
+    // pixels, so a scaled string is a few dozen fills rather than one per dot
+    for (int gy = 0; gy < GLYPH_H; gy++) {
+        int start = -1;
+        int columns = (int)n * ADVANCE;
+        for (int col = 0; col <= columns; col++) {
+            bool on = false;
+            if (col < columns && col % ADVANCE < GLYPH_W) {
+                unsigned ch = (unsigned char)s[col / ADVANCE];
+                const uint8_t *glyph = FONT[ch >= 32 && ch < 127 ? ch - 32 : '?' - 32];
+                on = (glyph[col % ADVANCE] >> gy) & 1;
+            }
+            if (on && start < 0) {
+                start = col;
+            } else if (!on && start >= 0) {
+                paint(image, {x + start * scale, y + gy * scale, x + col * scale, y + (gy + 1) * scale}, c);
+                start = -1;
+            }
+        }
+    }
+    int width = text_width(s, scale);
+    rect r = clip({x, y, x + width, y + text_height(scale)}, image);
+    if (!empty(r))
+        m_dirty.push_back(r);
+    return width;
+}
+
+void overlay_renderer::tag(bgr_view image, const detection &d, int line_width, int scale, color c)
+{
+    char label[64];
+    const char *name = d.cls >= 0 && (size_t)d.cls < m_style.names.size() ? m_style.names[d.cls].c_str() : nullptr;
+    if (name)
+        snprintf(label, sizeof(label), "%s %.2f", name, d.score);
+    else
+        snprintf(label, sizeof(label), "%d %.2f", d.cls, d.score);
+
+    int pad = scale;
+    int w = text_width(label, scale) + 2 * pad, h = text_height(scale) + 2 * pad;
+    int x = round_px(d.x1) - line_width / 2, y = round_px(d.y1) - line_width / 2;
+    // above the box when it fits, like Ultralytics, otherwise just inside
+    int top = y - h >= 0 ? y - h : y;
+    fill(image, {x, top, x + w, top + h}, c);
+    bool light = 0.299f * c.r + 0.587f * c.g + 0.114f * c.b > 160;
+    color ink = light ? color{0, 0, 0} : color{255, 255, 255};
+    text(image, x + pad, top + pad, label, scale, ink);
+}
+
+void overlay_renderer::draw(bgr_view image, const std::vector<detection> &detections, int count)
+{
+    m_dirty.clear();
+    int line_width = m_style.line_width;
+    if (line_width <= 0)
+        line_width = std::max((int)std::lround((image.width + image.height) / 2.0 * 0.003), 2);
+    int scale = m_style.font_scale > 0 ? m_style.font_scale : line_width;
+
+    for (const detection &d : detections) {
+        color c = class_color(d.cls);
+        outline(image, {round_px(d.x1), round_px(d.y1), round_px(d.x2), round_px(d.y2)}, line_width, c);
+        if (m_style.labels)
+            tag(image, d, line_width, scale, c);
+    }
+
+    if (count >= 0) {
+        char banner[32];
+        snprintf(banner, sizeof(banner), "people: %d", count);
+        int pad = 2 * scale;
+        fill(image, {0, 0, text_width(banner, scale) + 2 * pad, text_height(scale) + 2 * pad}, color{0, 0, 0});
+        text(image, pad, pad, banner, scale, color{255, 255, 255});
+    }
+}
+
+void overlay_renderer::plan(int width, int height, const std::vector<detection> &detections, int count)
+{
+    m_planning = true;
+    draw(bgr_view(nullptr, width, height), detections, count);
+    m_planning = false;
+}
+
+} // namespace edge
+
+// C entry points for python/edge_overlay.py, one renderer and encoder per
+// calling thread
+
+extern "C" void edge_draw_overlay(uint8_t *bgr, int width, int height, const edge::detection *detections, int n,
+                                  int count)
+{
+    static thread_local edge::overlay_renderer renderer;
+    if (!bgr || width <= 0 || height <= 0 || n < 0)
+        return;
+    std::vector<edge::detection> boxes(detections, detections + (detections ? n : 0));
+    renderer.draw(edge::bgr_view(bgr, width, height), boxes, count);
+}
+
+// Returns the JPEG size, or minus the size when capacity is too small (out is
+// left alone; encoding again is deterministic), or 0 on failure
+extern "C" int edge_encode_jpeg(const uint8_t *bgr, int width, int height, int quality, uint8_t *out, int capacity)
+{
+    static thread_local std::unique_ptr<edge::frame_encoder> encoder;
+    static thread_local int encoder_quality = 0;
+    static thread_local std::vector<uint8_t> jpeg;
+    if (!bgr || width <= 0 || height <= 0 || quality < 1 || quality > 100)
+        return 0;
+    if (!encoder || encoder_quality != quality) {
+        encoder.reset(new edge::frame_encoder(quality));
+        encoder_quality = quality;
+    }
+    if (!encoder->encode(bgr, width, height, jpeg))
+        return 0;
+    if (jpeg.size() > (size_t)capacity || !out)
+        return -(int)jpeg.size();
+    memcpy(out, jpeg.data(), jpeg.size());
+    return (int)jpeg.size();
+}
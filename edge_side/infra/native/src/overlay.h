@@ -0,0 +1,82 @@
+// Annotated frames for the backend without OpenCV or Ultralytics: boxes,
+// class/score tags and the people count are drawn straight into the decoded
+// frame in the look of results.plot(), ready for frame_encoder.
+//
+// Every primitive comes down to clipped rectangle fills, and a fill copies
+// one prepared run of pixels per row, so drawing costs memcpy bandwidth over
+// the painted area. Text uses a built-in 5x7 font scaled by whole pixels.
+// The renderer keeps the rectangles it painted, so an encoder can tell which
+// parts of the frame changed.
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "frame_decoder.h"
+#include "postprocess.h"
+
+namespace edge {
+
+struct color {
+    uint8_t b, g, r;
+};
+
+// Pixel rectangle, x1 and y1 exclusive
+struct rect {
+    int x0, y0, x1, y1;
+};
+
+// Interleaved B, G, R pixels owned by someone else (a bgr_image, a numpy array)
+struct bgr_view {
+    uint8_t *data;
+    int width, height;
+
+    bgr_view(uint8_t *data, int width, int height) : data(data), width(width), height(height) {}
+    bgr_view(bgr_image &image) : data(image.data.data()), width(image.width), height(image.height) {}
+};
+
+struct overlay_style {
+    int line_width = 0; // 0: max(round((w + h) / 2 * 0.003), 2) like Ultralytics
+    int font_scale = 0; // 0: the line width
+    bool labels = true; // class name and score above each box
+    std::vector<std::string> names = {"person"};
+};
+
+class overlay_renderer {
+public:
+    explicit overlay_renderer(const overlay_style &style = overlay_style());
+
+    // Boxes with their tags, then "people: count" in the top left corner
+    // unless count is negative. Starts a new dirty() list.
+    void draw(bgr_view image, const std::vector<detection> &detections, int count = -1);
+    // The dirty() list draw() would leave on a width x height frame,
+    // without touching any pixels
+    void plan(int width, int height, const std::vector<detection> &detections, int count = -1);
+
+    void fill(bgr_view image, rect r, color c);
+    // A frame of the given width centred on the edges of r
+    void outline(bgr_view image, rect r, int width, color c);
+    // Text with its top left corner at (x, y); returns its width
+    int text(bgr_view image, int x, int y, const char *s, int scale, color c);
+
+    static int text_width(const char *s, int scale);
+    static int text_height(int scale);
+    // Ultralytics' colour palette, by class
+    static color class_color(int cls);
+
+    // Rectangles painted since the last draw(), clipped to the image
+    const std::vector<rect> &dirty() const { return m_dirty; }
+
+private:
+    // Fills without recording the area
+    void paint(bgr_view image, rect r, color c);
+    void tag(bgr_view image, const detection &d, int line_width, int scale, color c);
+
+    overlay_style m_style;
+    std::vector<uint8_t> m_run;
+    std::vector<rect> m_dirty;
+    bool m_planning = false;
+};
+
+} // namespace edge
@@ -0,0 +1,166 @@
+#include "postprocess.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "simd.h"
+
+namespace edge {
+
+detection_decoder::detection_decoder(const decode_config &config)
+    : m_config(config)
+{
+}
+
+static detection corner_box(const float *head, int anchors, int i, float score, int cls)
+{
+    // xywh2xyxy
+    float cx = head[i], cy = head[anchors + i];
+    float hw = head[2 * (size_t)anchors + i] / 2, hh = head[3 * (size_t)anchors + i] / 2;
+    return {cx - hw, cy - hh, cx + hw, cy + hh, score, cls};
+}
+
+const std::vector<detection> &detection_decoder::filter(const float *head, int anchors)
+{
+    m_candidates.clear();
+    const int classes = m_config.num_classes;
+    const float *scores = head + 4 * (size_t)anchors;
+
+    // best class per anchor, first one on ties like argmax; most blocks of
+    // 8 anchors end at the threshold compare
+    const simd::v8 threshold = simd::splat(m_config.conf);
+    int i = 0;
+    for (; i + 8 <= anchors; i += 8) {
+        simd::v8 best = simd::load(scores + i);
+        simd::v8 cls = simd::splat(0.f);
+        for (int c = 1; c < classes; c++) {
+            simd::v8 s = simd::load(scores + (size_t)c * anchors + i);
+            simd::v8i better = s > best;
+            best = better ? s : best;
+            cls = better ? simd::splat((float)c) : cls;
+        }
+        for (unsigned mask = simd::movemask(best > threshold); mask; mask &= mask - 1) {
+            int lane = __builtin_ctz(mask);
+            m_candidates.push_back(corner_box(head, anchors, i + lane, best[lane], (int)cls[lane]));
+        }
+    }
+    for (; i < anchors; i++) {
+        int best = 0;
+        for (int c = 1; c < classes; c++)
+            if (scores[(size_t)c * anchors + i] > scores[(size_t)best * anchors + i])
+                best = c;
+        float score = scores[(size_t)best * anchors + i];
+        if (score > m_config.conf)
+            m_candidates.push_back(corner_box(head, anchors, i, score, best));
+    }
+    return m_candidates;
+}
+
+// torchvision.ops.box_iou without the +1, against 8 kept boxes at a time
+bool detection_decoder::overlaps_kept(const detection &d) const
+{
+    const simd::v8 x1 = simd::splat(d.x1), y1 = simd::splat(d.y1), x2 = simd::splat(d.x2), y2 = simd::splat(d.y2);
+    const simd::v8 area = simd::splat((d.x2 - d.x1) * (d.y2 - d.y1));
+    const simd::v8 cls = simd::splat((float)d.cls), zero = simd::splat(0.f);
+    for (size_t j = 0; j < m_kept; j += 8) {
+        simd::v8 iw = simd::min(x2, simd::load(&m_x2[j])) - simd::max(x1, simd::load(&m_x1[j]));
+        simd::v8 ih = simd::min(y2, simd::load(&m_y2[j])) - simd::max(y1, simd::load(&m_y1[j]));
+        simd::v8 inter = simd::max(iw, zero) * simd::max(ih, zero);
+        simd::v8 iou = inter / (area + simd::load(&m_area[j]) - inter);
+        if (simd::movemask((iou > m_config.iou) & (simd::load(&m_cls[j]) == cls)))
+            return true;
+    }
+    return false;
+}
+
+void detection_decoder::keep(const detection &d)
+{
+    // padding lanes carry class -1, so they never match
+    if (m_kept % 8 == 0) {
+        size_t size = m_kept + 8;
+        for (std::vector<float> *v : {&m_x1, &m_y1, &m_x2, &m_y2, &m_area})
+            v->resize(size, 0.f);
+        m_cls.resize(size, -1.f);
+    }
+    m_x1[m_kept] = d.x1;
+    m_y1[m_kept] = d.y1;
+    m_x2[m_kept] = d.x2;
+    m_y2[m_kept] = d.y2;
+    m_area[m_kept] = (d.x2 - d.x1) * (d.y2 - d.y1);
+    m_cls[m_kept] = (float)d.cls;
+    m_kept++;
+}
+
+void detection_decoder::suppress(std::vector<detection> &out)
+{
+    std::stable_sort(m_candidates.begin(), m_candidates.end(),
+                     [](const detection &a, const detection &b) { return a.score > b.score; });
+
+    // a box survives unless a higher scoring survivor of its class overlaps
+    // it, so only survivors need checking and the scan ends at max_det
+    out.clear();
+    m_x1.clear();
+    m_y1.clear();
+    m_x2.clear();
+    m_y2.clear();
+    m_area.clear();
+    m_cls.clear();
+    m_kept = 0;
+    for (const detection &d : m_candidates) {
+        if ((int)out.size() >= m_config.max_det)
+            break;
+        if (overlaps_kept(d))
+            continue;
+        keep(d);
+        out.push_back(d);
+    }
+}
+
+void detection_decoder::decode(const float *head, int anchors, const letterbox &lb, int width, int height,
+                               std::vector<detection> &out)
+{
+    filter(head, anchors);
+    suppress(out);
+    scale_boxes(out, lb, width, height);
+}
+
+void scale_boxes(std::vector<detection> &boxes, const letterbox &lb, int width, int height)
+{
+    for (detection &d : boxes) {
+        d.x1 = std::min(std::max((d.x1 - lb.pad_x) / lb.gain, 0.f), (float)width);
+        d.x2 = std::min(std::max((d.x2 - lb.pad_x) / lb.gain, 0.f), (float)width);
+        d.y1 = std::min(std::max((d.y1 - lb.pad_y) / lb.gain, 0.f), (float)height);
+        d.y2 = std::min(std::max((d.y2 - lb.pad_y) / lb.gain, 0.f), (float)height);
+    }
+}
+
+} // namespace edge
+
+int edge_yolo_decode(const float *head, int anchors, int num_classes, float conf, float iou, int max_det, float gain,
+                     int pad_x, int pad_y, int width, int height, edge::detection *out, int capacity)
+{
+    if (!head || anchors <= 0 || num_classes <= 0 || (!out && capacity > 0))
+        return -1;
+
+    // one decoder per calling thread, rebuilt only when the settings change
+    static thread_local edge::detection_decoder decoder;
+    static thread_local std::vector<edge::detection> detections;
+    const edge::decode_config &c = decoder.config();
+    if (c.num_classes != num_classes || c.conf != conf || c.iou != iou || c.max_det != max_det) {
+        edge::decode_config config;
+        config.num_classes = num_classes;
+        config.conf = conf;
+        config.iou = iou;
+        config.max_det = max_det;
+        decoder = edge::detection_decoder(config);
+    }
+
+    decoder.filter(head, anchors);
+    decoder.suppress(detections);
+    if (width > 0 && height > 0)
+        edge::scale_boxes(detections, {gain, pad_x, pad_y}, width, height);
+    int n = std::min((int)detections.size(), capacity);
+    if (n > 0)
+        memcpy(out, detections.data(), n * sizeof(edge::detection));
+    return n;
+}
@@ -0,0 +1,78 @@
+// Decoding and NMS for the output of a YOLOv8/v11 detect head.
+//
+// The head tensor is (4 + classes) rows of one float per anchor: cx, cy, w,
+// h in model input pixels, then a score row per class. Filtering runs 8
+// anchors at a time and only anchors above the threshold are materialised,
+// so the cost of a frame is one pass over the score rows plus NMS on the few
+// survivors. Results match Ultralytics non_max_suppression() with
+// agnostic=False, multi_label=False.
+//
+// The same code is exported with C linkage for the Python binding in
+// python/edge_post.py.
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace edge {
+
+struct detection {
+    float x1, y1, x2, y2; // corner coordinates
+    float score;
+    int cls;
+};
+
+// Scale and offset mapping model input pixels back to the source image
+struct letterbox {
+    float gain;
+    int pad_x, pad_y;
+};
+
+struct decode_config {
+    int num_classes = 1;
+    float conf = 0.25f; // same defaults as Ultralytics predict
+    float iou = 0.7f;
+    int max_det = 300;
+};
+
+class detection_decoder {
+public:
+    explicit detection_decoder(const decode_config &config = decode_config());
+
+    // Full pipeline: filter, NMS and scale_boxes() into a width x height
+    // source image. Buffers are reused across calls.
+    void decode(const float *head, int anchors, const letterbox &lb, int width, int height,
+                std::vector<detection> &out);
+
+    // Stages of decode(), exposed for tests and the benchmark.
+    // Anchors whose best class score is above conf, as corner boxes in
+    // model pixels, in anchor order
+    const std::vector<detection> &filter(const float *head, int anchors);
+    // Greedy per-class NMS of the filtered boxes, highest score first, stopping at max_det
+    void suppress(std::vector<detection> &out);
+
+    const decode_config &config() const { return m_config; }
+
+private:
+    bool overlaps_kept(const detection &d) const;
+    void keep(const detection &d);
+
+    decode_config m_config;
+    std::vector<detection> m_candidates;
+    // kept boxes as structure of arrays, padded to whole vectors
+    std::vector<float> m_x1, m_y1, m_x2, m_y2, m_area;
+    std::vector<float> m_cls; // class ids, exact in float
+    size_t m_kept = 0;
+};
+
+// Undoes the letterbox and clips to the image, like Ultralytics scale_boxes()
+void scale_boxes(std::vector<detection> &boxes, const letterbox &lb, int width, int height);
+
+} // namespace edge
+
+extern "C" {
+// decode() for callers without C++: writes at most `capacity` detections
+// to `out` and returns how many. width/height <= 0 skips scale_boxes().
+int edge_yolo_decode(const float *head, int anchors, int num_classes, float conf, float iou, int max_det, float gain,
+                     int pad_x, int pad_y, int width, int height, edge::detection *out, int capacity);
+}
@@ -0,0 +1,94 @@
+// 8-lane float vectors on GCC/Clang vector extensions.
+//
+// The same source compiles to AVX/AVX-512 on x86 and to pairs of NEON
+// registers on the Raspberry Pi, so kernels are written once.
+#pragma once
+
+#include <cstdint>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+namespace edge {
+namespace simd {
+
+typedef float v8 __attribute__((vector_size(32)));
+typedef int32_t v8i __attribute__((vector_size(32)));
+typedef float v8u __attribute__((vector_size(32), aligned(4), may_alias));
+
+static inline v8 load(const float *p)
+{
+    return *(const v8u *)p;
+}
+
+static inline void store(float *p, v8 v)
+{
+    *(v8u *)p = v;
+}
+
+static inline v8 splat(float x)
+{
+    return v8{x, x, x, x, x, x, x, x};
+}
+
+static inline v8 max(v8 a, v8 b)
+{
+    return a > b ? a : b;
+}
+
+static inline v8 min(v8 a, v8 b)
+{
+    return a < b ? a : b;
+}
+
+// One bit per lane of a comparison result, lane 0 in bit 0
+static inline unsigned movemask(v8i m)
+{
+#if defined(__AVX__)
+    return (unsigned)_mm256_movemask_ps((__m256)m);
+#else
+    unsigned bits = 0;
+    for (int i = 0; i < 8; i++)
+        bits |= (unsigned)(m[i] & 1) << i;
+    return bits;
+#endif
+}
+
+// Cephes expf, about 1 ulp over the clamped range
+static inline v8 exp(v8 x)
+{
+    x = min(max(x, splat(-88.3762626647949f)), splat(88.3762626647949f));
+
+    v8 fx = x * 1.44269504088896341f + 0.5f;
+    v8 t = __builtin_convertvector(__builtin_convertvector(fx, v8i), v8);
+    t += __builtin_convertvector(t > fx, v8); // floor: trunc rounded up for negatives
+    fx = t;
+
+    x -= fx * 0.693359375f;
+    x -= fx * -2.12194440e-4f;
+
+    v8 y = splat(1.9875691500E-4f);
+    y = y * x + 1.3981999507E-3f;
+    y = y * x + 8.3334519073E-3f;
+    y = y * x + 4.1665795894E-2f;
+    y = y * x + 1.6666665459E-1f;
+    y = y * x + 5.0000001201E-1f;
+    y = y * x * x + x + 1.0f;
+
+    v8i e = (__builtin_convertvector(fx, v8i) + 127) << 23;
+    return y * (v8)e;
+}
+
+static inline v8 sigmoid(v8 x)
+{
+    return 1.0f / (1.0f + exp(-x));
+}
+
+static inline v8 swish(v8 x)
+{
+    return x / (1.0f + exp(-x));
+}
+
+} // namespace simd
+} // namespace edge
@@ -0,0 +1,63 @@
+#include "stats.h"
+
+namespace edge {
+
+int latency_histogram::bucket_of(uint64_t us)
+{
+    if (us < 8)
+        return (int)us;
+    int msb = 63 - __builtin_clzll(us);
+    int bucket = (msb - 2) * 8 + (int)((us >> (msb - 3)) & 7);
+    return bucket < BUCKETS ? bucket : BUCKETS - 1;
+}
+
+uint64_t latency_histogram::bucket_value(int bucket)
+{
+    if (bucket < 8)
+        return (uint64_t)bucket;
+    int msb = bucket / 8 + 2;
+    uint64_t low = (uint64_t)(8 + bucket % 8) << (msb - 3);
+    // middle of the bucket
+    return low + ((uint64_t)1 << (msb - 3)) / 2;
+}
+
+void latency_histogram::record(uint64_t us)
+{
+    m_buckets[bucket_of(us)].fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(us, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t latency_histogram::percentile(double p) const
+{
+    uint64_t total = 0;
+    for (int i = 0; i < BUCKETS; i++)
+        total += m_buckets[i].load(std::memory_order_relaxed);
+    if (!total)
+        return 0;
+
+    uint64_t rank = (uint64_t)(p / 100.0 * (double)(total - 1)) + 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+        seen += m_buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank)
+            return bucket_value(i);
+    }
+    return bucket_value(BUCKETS - 1);
+}
+
+double latency_histogram::mean() const
+{
+    uint64_t n = count();
+    return n ? (double)m_sum.load(std::memory_order_relaxed) / (double)n : 0.0;
+}
+
+void latency_histogram::reset()
+{
+    for (int i = 0; i < BUCKETS; i++)
+        m_buckets[i].store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_count.store(0, std::memory_order_relaxed);
+}
+
+} // namespace edge
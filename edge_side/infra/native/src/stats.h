@@ -0,0 +1,33 @@
+// Lock-free counters and latency histograms for the per-camera report.
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace edge {
+
+// Log-linear histogram of microsecond latencies: 8 sub-buckets per power of
+// two, so any percentile is within 12.5% of the true value. Recording is two
+// relaxed atomic adds and may run on any thread.
+class latency_histogram {
+public:
+    static const int BUCKETS = 8 * 32;
+
+    void record(uint64_t us);
+    // Percentile (0..100) of everything recorded since the last reset
+    uint64_t percentile(double p) const;
+    uint64_t count() const { return m_count.load(std::memory_order_relaxed); }
+    double mean() const;
+    void reset();
+
+private:
+    static int bucket_of(uint64_t us);
+    static uint64_t bucket_value(int bucket);
+
+    std::atomic<uint32_t> m_buckets[BUCKETS] = {};
+    std::atomic<uint64_t> m_count{0};
+    std::atomic<uint64_t> m_sum{0};
+};
+
+} // namespace edge
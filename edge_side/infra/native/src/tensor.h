@@ -0,0 +1,75 @@
+// Dense float tensor with ncnn's shape conventions.
+//
+// Shapes are (w), (w, h), (w, h, c) or (w, h, d, c) with w varying fastest.
+// Unlike ncnn::Mat there is no per-channel padding: the data is one
+// contiguous run, so Reshape is free and a channel range of a tensor is a
+// view into the same storage. Views share ownership of the buffer.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+
+namespace edge {
+
+struct tensor {
+    int dims = 0;
+    int w = 0, h = 1, d = 1, c = 1;
+    float *data = nullptr;
+    std::shared_ptr<float> storage;
+
+    tensor() = default;
+
+    static tensor make(int dims, int w, int h = 1, int d = 1, int c = 1)
+    {
+        tensor t;
+        t.dims = dims;
+        t.w = w;
+        t.h = h;
+        t.d = d;
+        t.c = c;
+        // 64 byte alignment and a tail of slack so kernels may over-read a vector
+        size_t bytes = ((t.total() + 16) * sizeof(float) + 63) & ~(size_t)63;
+        t.data = (float *)aligned_alloc(64, bytes);
+        t.storage.reset(t.data, free);
+        return t;
+    }
+    static tensor make_1d(int w) { return make(1, w); }
+    static tensor make_2d(int w, int h) { return make(2, w, h); }
+    static tensor make_3d(int w, int h, int c) { return make(3, w, h, 1, c); }
+
+    bool empty() const { return !data; }
+    size_t plane() const { return (size_t)w * h * d; }
+    size_t total() const { return plane() * c; }
+    float *channel(int q) const { return data + plane() * q; }
+    float *row(int y) const { return data + (size_t)w * y; }
+
+    // Channels [q, q + n) of a 3D or 4D tensor, sharing storage
+    tensor channels(int q, int n) const
+    {
+        tensor t = *this;
+        t.c = n;
+        t.data = channel(q);
+        return t;
+    }
+
+    // Same data, new shape; the element count must match
+    tensor reshaped(int new_dims, int new_w, int new_h = 1, int new_d = 1, int new_c = 1) const
+    {
+        tensor t = *this;
+        t.dims = new_dims;
+        t.w = new_w;
+        t.h = new_h;
+        t.d = new_d;
+        t.c = new_c;
+        return t;
+    }
+
+    bool same_shape(const tensor &o) const
+    {
+        return dims == o.dims && w == o.w && h == o.h && d == o.d && c == o.c;
+    }
+};
+
+} // namespace edge
@@ -0,0 +1,80 @@
+#include "thread_pool.h"
+
+namespace edge {
+
+thread_pool::thread_pool(int threads)
+{
+    if (threads <= 0)
+        threads = (int)std::thread::hardware_concurrency();
+    for (int i = 1; i < threads; i++)
+        m_workers.emplace_back(&thread_pool::worker, this);
+}
+
+thread_pool::~thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_start.notify_all();
+    for (auto &t : m_workers)
+        t.join();
+}
+
+void thread_pool::run_items()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_next < m_items) {
+        int i = m_next++;
+        const std::function<void(int)> &fn = *m_fn;
+        lock.unlock();
+        fn(i);
+        lock.lock();
+    }
+}
+
+void thread_pool::worker()
+{
+    unsigned seen = 0;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_start.wait(lock, [&] { return m_stop || m_generation != seen; });
+        if (m_stop)
+            return;
+        seen = m_generation;
+        m_busy++;
+        lock.unlock();
+        run_items();
+        lock.lock();
+        if (--m_busy == 0)
+            m_done.notify_all();
+    }
+}
+
+void thread_pool::parallel_for(int n, const std::function<void(int)> &fn)
+{
+    if (n <= 0)
+        return;
+    if (m_workers.empty() || n == 1) {
+        for (int i = 0; i < n; i++)
+            fn(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_fn = &fn;
+        m_items = n;
+        m_next = 0;
+        m_generation++;
+    }
+    m_start.notify_all();
+    run_items();
+
+    // items are all claimed; wait for the workers still running theirs
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [&] { return m_busy == 0; });
+    m_fn = nullptr;
+}
+
+} // namespace edge
@@ -0,0 +1,43 @@
+// Fixed set of worker threads for data-parallel loops inside one inference.
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace edge {
+
+class thread_pool {
+public:
+    // threads <= 0 uses every hardware thread; the calling thread counts as one
+    explicit thread_pool(int threads = 0);
+    ~thread_pool();
+
+    thread_pool(const thread_pool &) = delete;
+    thread_pool &operator=(const thread_pool &) = delete;
+
+    int size() const { return (int)m_workers.size() + 1; }
+
+    // Runs fn(i) for i in [0, n), spread over the pool, and waits for all of
+    // them. Items are handed out one at a time, so uneven work balances out.
+    void parallel_for(int n, const std::function<void(int)> &fn);
+
+private:
+    void worker();
+    void run_items();
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    const std::function<void(int)> *m_fn = nullptr;
+    int m_items = 0;
+    int m_next = 0;
+    int m_busy = 0;
+    unsigned m_generation = 0;
+    bool m_stop = false;
+};
+
+} // namespace edge
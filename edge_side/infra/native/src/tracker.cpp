@@ -0,0 +1,421 @@
+#include "tracker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace edge {
+
+// ByteTrack's noise model: standard deviations proportional to box height
+static const float STD_POSITION = 1.f / 20, STD_VELOCITY = 1.f / 160;
+static const float ASPECT_X = 1e-2f, ASPECT_V = 1e-5f, ASPECT_MEASURE = 1e-1f;
+// buffered IoU stops growing at three times the box size
+static const float MAX_BUFFER = 1.f;
+// counters forget tracks not seen for this many updates
+static const int FORGET_AFTER = 300;
+
+void kalman_axis::predict(float q_x, float q_v)
+{
+    x += v;
+    pxx += 2 * pxv + pvv + q_x;
+    pxv += pvv;
+    pvv += q_v;
+}
+
+void kalman_axis::update(float z, float r)
+{
+    float s = pxx + r;
+    float k_x = pxx / s, k_v = pxv / s;
+    float innovation = z - x;
+    x += k_x * innovation;
+    v += k_v * innovation;
+    pvv -= k_v * pxv;
+    pxv *= 1 - k_x;
+    pxx *= 1 - k_x;
+}
+
+float box_iou(const detection &a, const detection &b)
+{
+    float iw = std::min(a.x2, b.x2) - std::max(a.x1, b.x1);
+    float ih = std::min(a.y2, b.y2) - std::max(a.y1, b.y1);
+    if (iw <= 0 || ih <= 0)
+        return 0;
+    float inter = iw * ih;
+    return inter / ((a.x2 - a.x1) * (a.y2 - a.y1) + (b.x2 - b.x1) * (b.y2 - b.y1) - inter);
+}
+
+std::vector<int> assign_min_cost(const std::vector<std::vector<float>> &cost)
+{
+    const size_t rows = cost.size(), cols = rows ? cost[0].size() : 0;
+    std::vector<int> result(rows, -1);
+    if (!rows || !cols)
+        return result;
+
+    // the potentials method below needs n <= m, so work on the transpose
+    // when there are more rows than columns
+    const bool transposed = rows > cols;
+    const size_t n = transposed ? cols : rows, m = transposed ? rows : cols;
+    auto at = [&](size_t i, size_t j) { return (double)(transposed ? cost[j][i] : cost[i][j]); };
+
+    const double INF = std::numeric_limits<double>::infinity();
+    std::vector<double> u(n + 1, 0), v(m + 1, 0), min_v(m + 1);
+    std::vector<size_t> p(m + 1, 0), way(m + 1, 0);
+    std::vector<bool> used(m + 1);
+    for (size_t i = 1; i <= n; i++) {
+        p[0] = i;
+        size_t j0 = 0;
+        std::fill(min_v.begin(), min_v.end(), INF);
+        std::fill(used.begin(), used.end(), false);
+        do {
+            used[j0] = true;
+            size_t i0 = p[j0], j1 = 0;
+            double delta = INF;
+            for (size_t j = 1; j <= m; j++) {
+                if (used[j])
+                    continue;
+                double reduced = at(i0 - 1, j - 1) - u[i0] - v[j];
+                if (reduced < min_v[j]) {
+                    min_v[j] = reduced;
+                    way[j] = j0;
+                }
+                if (min_v[j] < delta) {
+                    delta = min_v[j];
+                    j1 = j;
+                }
+            }
+            for (size_t j = 0; j <= m; j++) {
+                if (used[j]) {
+                    u[p[j]] += delta;
+                    v[j] -= delta;
+                } else {
+                    min_v[j] -= delta;
+                }
+            }
+            j0 = j1;
+        } while (p[j0] != 0);
+        do {
+            size_t j1 = way[j0];
+            p[j0] = p[j1];
+            j0 = j1;
+        } while (j0);
+    }
+
+    for (size_t j = 1; j <= m; j++) {
+        if (!p[j])
+            continue;
+        if (transposed)
+            result[j - 1] = (int)(p[j] - 1);
+        else
+            result[p[j] - 1] = (int)(j - 1);
+    }
+    return result;
+}
+
+static detection grow(const detection &d, float by)
+{
+    float dx = (d.x2 - d.x1) * by, dy = (d.y2 - d.y1) * by;
+    return {d.x1 - dx, d.y1 - dy, d.x2 + dx, d.y2 + dy, d.score, d.cls};
+}
+
+// Pairs tracks[track_ids] with dets[det_ids] where IoU >= min_iou and calls
+// on_match for each; matched ids are removed from both lists. Both boxes of
+// a pair grow by buffer for every frame the track went unmatched beyond the
+// last one, so a track that has coasted through skipped frames still
+// overlaps where its person turned up
+template <typename F>
+static void associate(std::vector<track> &tracks, std::vector<int> &track_ids, const std::vector<detection> &dets,
+                      std::vector<int> &det_ids, float min_iou, float buffer, F on_match)
+{
+    if (track_ids.empty() || det_ids.empty())
+        return;
+    // pairs below the threshold get a cost no real pair can reach, so the
+    // assignment only uses them when nothing else is left
+    std::vector<std::vector<float>> cost(track_ids.size(), std::vector<float>(det_ids.size()));
+    for (size_t i = 0; i < track_ids.size(); i++) {
+        const track &t = tracks[track_ids[i]];
+        float by = std::min(buffer * (t.lost_frames - 1), MAX_BUFFER);
+        detection box = grow(t.box, by);
+        for (size_t j = 0; j < det_ids.size(); j++) {
+            float iou = box_iou(box, by > 0 ? grow(dets[det_ids[j]], by) : dets[det_ids[j]]);
+            cost[i][j] = iou >= min_iou ? 1 - iou : 1e3f;
+        }
+    }
+
+    std::vector<int> assignment = assign_min_cost(cost);
+    std::vector<bool> track_used(track_ids.size()), det_used(det_ids.size());
+    for (size_t i = 0; i < assignment.size(); i++) {
+        int j = assignment[i];
+        if (j < 0 || cost[i][j] > 1)
+            continue;
+        on_match(tracks[track_ids[i]], dets[det_ids[j]]);
+        track_used[i] = true;
+        det_used[j] = true;
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < track_ids.size(); i++)
+        if (!track_used[i])
+            track_ids[kept++] = track_ids[i];
+    track_ids.resize(kept);
+    kept = 0;
+    for (size_t j = 0; j < det_ids.size(); j++)
+        if (!det_used[j])
+            det_ids[kept++] = det_ids[j];
+    det_ids.resize(kept);
+}
+
+tracker::tracker(const track_config &config)
+    : m_config(config)
+{
+}
+
+void tracker::refresh_box(track &t)
+{
+    float cx = t.axes[0].x, cy = t.axes[1].x, h = t.axes[3].x, w = t.axes[2].x * h;
+    t.box.x1 = cx - w / 2;
+    t.box.y1 = cy - h / 2;
+    t.box.x2 = cx + w / 2;
+    t.box.y2 = cy + h / 2;
+}
+
+void tracker::advance()
+{
+    m_frame++;
+    for (track &t : m_tracks) {
+        float h = std::max(t.axes[3].x, 1.f);
+        float q_x = (STD_POSITION * h) * (STD_POSITION * h), q_v = (STD_VELOCITY * h) * (STD_VELOCITY * h);
+        t.axes[0].predict(q_x, q_v);
+        t.axes[1].predict(q_x, q_v);
+        t.axes[2].predict(ASPECT_X * ASPECT_X, ASPECT_V * ASPECT_V);
+        t.axes[3].predict(q_x, q_v);
+        t.lost_frames++;
+        refresh_box(t);
+    }
+}
+
+static void measure(const detection &d, float z[4])
+{
+    float w = d.x2 - d.x1, h = d.y2 - d.y1;
+    z[0] = (d.x1 + d.x2) / 2;
+    z[1] = (d.y1 + d.y2) / 2;
+    z[2] = h > 0 ? w / h : 0;
+    z[3] = h;
+}
+
+const std::vector<track> &tracker::update(const std::vector<detection> &detections)
+{
+    advance();
+
+    std::vector<int> high, low;
+    for (size_t i = 0; i < detections.size(); i++) {
+        if (detections[i].score >= m_config.high_score)
+            high.push_back((int)i);
+        else if (detections[i].score >= m_config.low_score)
+            low.push_back((int)i);
+    }
+
+    auto correct = [this](track &t, const detection &d) {
+        float z[4];
+        measure(d, z);
+        float r = (STD_POSITION * z[3]) * (STD_POSITION * z[3]);
+        t.axes[0].update(z[0], r);
+        t.axes[1].update(z[1], r);
+        t.axes[2].update(z[2], ASPECT_MEASURE * ASPECT_MEASURE);
+        t.axes[3].update(z[3], r);
+        t.box.score = d.score;
+        t.box.cls = d.cls;
+        t.hits++;
+        t.lost_frames = 0;
+        t.lost = false;
+        if (t.hits >= 2)
+            t.confirmed = true;
+        refresh_box(t);
+    };
+
+    // confident detections against every confirmed track, lost ones included
+    std::vector<int> confirmed, tentative;
+    for (size_t i = 0; i < m_tracks.size(); i++)
+        (m_tracks[i].confirmed ? confirmed : tentative).push_back((int)i);
+    associate(m_tracks, confirmed, detections, high, m_config.match_iou, m_config.buffer, correct);
+
+    // weak detections only keep tracks that were being followed alive
+    std::vector<int> followed;
+    for (int i : confirmed)
+        if (!m_tracks[i].lost)
+            followed.push_back(i);
+    associate(m_tracks, followed, detections, low, m_config.low_match_iou, m_config.buffer, correct);
+    for (int i : followed)
+        m_tracks[i].lost = true;
+
+    // a new track needs a second detection to be confirmed; one that misses
+    // it is dropped below
+    associate(m_tracks, tentative, detections, high, m_config.tentative_iou, m_config.buffer, correct);
+    for (int i : tentative)
+        m_tracks[i].lost_frames = m_config.max_lost_frames + 1;
+
+    for (int i : high) {
+        const detection &d = detections[i];
+        if (d.score < m_config.new_track_score)
+            continue;
+        track t;
+        t.id = m_next_id++;
+        t.box = d;
+        float z[4];
+        measure(d, z);
+        float h = std::max(z[3], 1.f);
+        const float std_x[4] = {2 * STD_POSITION * h, 2 * STD_POSITION * h, ASPECT_X, 2 * STD_POSITION * h};
+        const float std_v[4] = {10 * STD_VELOCITY * h, 10 * STD_VELOCITY * h, ASPECT_V, 10 * STD_VELOCITY * h};
+        for (int k = 0; k < 4; k++) {
+            t.axes[k].x = z[k];
+            t.axes[k].pxx = std_x[k] * std_x[k];
+            t.axes[k].pvv = std_v[k] * std_v[k];
+        }
+        t.hits = 1;
+        // like ByteTrack, tracks of the very first frame start confirmed
+        t.confirmed = m_frame == 1;
+        m_tracks.push_back(t);
+    }
+
+    m_tracks.erase(std::remove_if(m_tracks.begin(), m_tracks.end(),
+                                  [this](const track &t) { return t.lost_frames > m_config.max_lost_frames; }),
+                   m_tracks.end());
+    return collect();
+}
+
+const std::vector<track> &tracker::predict()
+{
+    advance();
+    m_tracks.erase(std::remove_if(m_tracks.begin(), m_tracks.end(),
+                                  [this](const track &t) { return t.lost_frames > m_config.max_lost_frames; }),
+                   m_tracks.end());
+    return collect();
+}
+
+const std::vector<track> &tracker::collect()
+{
+    m_active.clear();
+    for (const track &t : m_tracks)
+        if (t.confirmed && !t.lost)
+            m_active.push_back(t);
+    return m_active;
+}
+
+static point anchor_of(const detection &d, anchor where)
+{
+    float x = (d.x1 + d.x2) / 2;
+    return {x, where == anchor::bottom_center ? d.y2 : (d.y1 + d.y2) / 2};
+}
+
+line_counter::line_counter(point a, point b, float margin, anchor where)
+    : m_a(a),
+      m_b(b),
+      m_margin(margin),
+      m_anchor(where)
+{
+}
+
+void line_counter::update(const std::vector<track> &tracks)
+{
+    m_updates++;
+    float dx = m_b.x - m_a.x, dy = m_b.y - m_a.y;
+    float length_sq = dx * dx + dy * dy;
+    float length = std::sqrt(length_sq);
+    if (length <= 0)
+        return;
+
+    for (const track &t : tracks) {
+        point p = anchor_of(t.box, m_anchor);
+        // signed distance, positive on the right of a -> b in image
+        // coordinates (y down)
+        float distance = (dx * (p.y - m_a.y) - dy * (p.x - m_a.x)) / length;
+        int side = distance > m_margin ? -1 : distance < -m_margin ? 1 : 0;
+
+        auto it = m_sides.find(t.id);
+        if (it == m_sides.end()) {
+            m_sides[t.id] = {side, m_updates};
+            continue;
+        }
+        it->second.last_frame = m_updates;
+        if (!side || side == it->second.side)
+            continue;
+        // only crossings between the two end points count
+        float along = (dx * (p.x - m_a.x) + dy * (p.y - m_a.y)) / length_sq;
+        if (it->second.side && along >= 0 && along <= 1)
+            (side > 0 ? m_totals.entries : m_totals.exits)++;
+        it->second.side = side;
+    }
+
+    for (auto it = m_sides.begin(); it != m_sides.end();)
+        it = m_updates - it->second.last_frame > FORGET_AFTER ? m_sides.erase(it) : std::next(it);
+}
+
+zone_counter::zone_counter(const std::vector<point> &polygon, float margin, anchor where)
+    : m_polygon(polygon),
+      m_margin(margin),
+      m_anchor(where)
+{
+}
+
+static bool inside_polygon(const std::vector<point> &polygon, point p)
+{
+    bool inside = false;
+    for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+        const point &a = polygon[i], &b = polygon[j];
+        if ((a.y > p.y) != (b.y > p.y) && p.x < (b.x - a.x) * (p.y - a.y) / (b.y - a.y) + a.x)
+            inside = !inside;
+    }
+    return inside;
+}
+
+static float distance_to_border(const std::vector<point> &polygon, point p)
+{
+    float best = std::numeric_limits<float>::max();
+    for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+        const point &a = polygon[j], &b = polygon[i];
+        float dx = b.x - a.x, dy = b.y - a.y, length_sq = dx * dx + dy * dy;
+        float t = length_sq > 0 ? std::min(std::max(((p.x - a.x) * dx + (p.y - a.y) * dy) / length_sq, 0.f), 1.f) : 0;
+        float ex = a.x + t * dx - p.x, ey = a.y + t * dy - p.y;
+        best = std::min(best, std::sqrt(ex * ex + ey * ey));
+    }
+    return best;
+}
+
+void zone_counter::update(const std::vector<track> &tracks)
+{
+    m_updates++;
+    if (m_polygon.size() < 3)
+        return;
+
+    for (const track &t : tracks) {
+        point p = anchor_of(t.box, m_anchor);
+        bool inside = inside_polygon(m_polygon, p);
+        bool decided = distance_to_border(m_polygon, p) > m_margin;
+
+        auto it = m_states.find(t.id);
+        if (it == m_states.end()) {
+            // a track first seen on the border waits until it is clear of it
+            if (decided)
+                m_states[t.id] = {inside, m_updates};
+            continue;
+        }
+        it->second.last_frame = m_updates;
+        if (decided && inside != it->second.inside) {
+            (inside ? m_totals.entries : m_totals.exits)++;
+            it->second.inside = inside;
+        }
+    }
+
+    for (auto it = m_states.begin(); it != m_states.end();)
+        it = m_updates - it->second.last_frame > FORGET_AFTER ? m_states.erase(it) : std::next(it);
+}
+
+size_t zone_counter::occupancy() const
+{
+    size_t n = 0;
+    for (const auto &it : m_states)
+        if (it.second.inside && it.second.last_frame == m_updates)
+            n++;
+    return n;
+}
+
+} // namespace edge
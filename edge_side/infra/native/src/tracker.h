@@ -0,0 +1,146 @@
+// Multi-object tracking and line/zone counting on top of the detector.
+//
+// The tracker follows ByteTrack: every track carries a constant-velocity
+// Kalman filter over (cx, cy, w / h, h), detections are split by score,
+// the confident ones are matched first (Hungarian on 1 - IoU) and the weak
+// ones only to tracks still unmatched, so a person partly hidden for a few
+// frames keeps their id. On frames where the detector does not run,
+// predict() moves every track by its velocity; counting then sees smooth
+// positions on every frame while inference runs only every Nth one. The
+// IoU of a track that coasted through skipped frames is taken over boxes
+// grown in proportion, since its person may have moved a box width.
+//
+// The counters turn track positions into entries and exits: a track is
+// counted once each time its anchor point crosses the line (or the zone
+// border) by more than a small margin, which absorbs box jitter.
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "postprocess.h"
+
+namespace edge {
+
+struct track_config {
+    float high_score = 0.5f;      // first association round
+    float low_score = 0.1f;       // below this detections are ignored
+    float new_track_score = 0.6f; // unmatched detections above this start a track
+    float match_iou = 0.2f;       // minimum IoU of the first round (ByteTrack match_thresh 0.8)
+    float low_match_iou = 0.5f;   // second round, weak detections
+    float tentative_iou = 0.3f;   // unconfirmed tracks
+    int max_lost_frames = 30;     // frames a track survives without a match
+    float buffer = 0.15f;         // box growth per frame without a match, for matching after skipped frames
+};
+
+// One coordinate of the state with its velocity; the ByteTrack noise model
+// keeps the 8-dimensional covariance block diagonal in these pairs
+struct kalman_axis {
+    float x = 0, v = 0;             // position, velocity per frame
+    float pxx = 0, pxv = 0, pvv = 0; // covariance
+
+    void predict(float q_x, float q_v);
+    void update(float z, float r);
+};
+
+struct track {
+    int id = 0;
+    detection box{};      // current estimate, same coordinates as the detections
+    int hits = 0;         // detector frames with a match
+    int lost_frames = 0;  // frames since the last match
+    bool confirmed = false;
+    bool lost = false;    // unmatched at the last detector run
+    kalman_axis axes[4];  // cx, cy, aspect, height
+};
+
+class tracker {
+public:
+    explicit tracker(const track_config &config = track_config());
+
+    // A frame where the detector ran: predict, associate, start and retire
+    // tracks. Returns the confirmed tracks that are currently matched.
+    const std::vector<track> &update(const std::vector<detection> &detections);
+    // A frame without inference: tracks only move
+    const std::vector<track> &predict();
+
+    // Every live track, including tentative and lost ones
+    const std::vector<track> &tracks() const { return m_tracks; }
+    int frame() const { return m_frame; }
+
+private:
+    void advance();
+    void refresh_box(track &t);
+    const std::vector<track> &collect();
+
+    track_config m_config;
+    std::vector<track> m_tracks;
+    std::vector<track> m_active;
+    int m_next_id = 1;
+    int m_frame = 0;
+};
+
+// Minimum cost assignment of rows to columns (Hungarian algorithm). Returns
+// for each row its column, or -1 where the matrix has more rows than columns.
+std::vector<int> assign_min_cost(const std::vector<std::vector<float>> &cost);
+
+float box_iou(const detection &a, const detection &b);
+
+struct point {
+    float x, y;
+};
+
+// Where on a box the counters look: the feet of a standing person by default
+enum class anchor { bottom_center, center };
+
+struct count_totals {
+    uint64_t entries = 0, exits = 0;
+};
+
+// Counts crossings of the segment a -> b. Moving from its right side to its
+// left side (as seen looking from a to b) is an entry, the reverse an exit.
+class line_counter {
+public:
+    line_counter(point a, point b, float margin = 4.f, anchor where = anchor::bottom_center);
+
+    void update(const std::vector<track> &tracks);
+    const count_totals &totals() const { return m_totals; }
+
+private:
+    struct state {
+        int side;
+        int last_frame;
+    };
+
+    point m_a, m_b;
+    float m_margin;
+    anchor m_anchor;
+    count_totals m_totals;
+    std::map<int, state> m_sides;
+    int m_updates = 0;
+};
+
+// Counts tracks entering and leaving a polygon, and how many are inside
+class zone_counter {
+public:
+    zone_counter(const std::vector<point> &polygon, float margin = 4.f, anchor where = anchor::bottom_center);
+
+    void update(const std::vector<track> &tracks);
+    const count_totals &totals() const { return m_totals; }
+    size_t occupancy() const;
+
+private:
+    struct state {
+        bool inside;
+        int last_frame;
+    };
+
+    std::vector<point> m_polygon;
+    float m_margin;
+    anchor m_anchor;
+    count_totals m_totals;
+    std::map<int, state> m_states;
+    int m_updates = 0;
+};
+
+} // namespace edge
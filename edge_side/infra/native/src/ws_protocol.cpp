@@ -0,0 +1,361 @@
+#include "ws_protocol.h"
+
+#include <algorithm>
+#include <cstring>
+#include <strings.h>
+
+namespace edge {
+namespace ws {
+
+namespace {
+
+const char GUID[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+inline uint32_t rol(uint32_t v, int n) { return (v << n) | (v >> (32 - n)); }
+
+void sha1(const uint8_t *data, size_t len, uint8_t digest[20])
+{
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    std::vector<uint8_t> msg(data, data + len);
+    uint64_t bits = (uint64_t)len * 8;
+    msg.push_back(0x80);
+    while (msg.size() % 64 != 56)
+        msg.push_back(0);
+    for (int i = 7; i >= 0; i--)
+        msg.push_back((uint8_t)(bits >> (i * 8)));
+
+    for (size_t chunk = 0; chunk < msg.size(); chunk += 64) {
+        uint32_t w[80];
+        for (int i = 0; i < 16; i++) {
+            const uint8_t *p = &msg[chunk + i * 4];
+            w[i] = (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+        }
+        for (int i = 16; i < 80; i++)
+            w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; i++) {
+            uint32_t f, k;
+            if (i < 20) {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            } else if (i < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            } else if (i < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            } else {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+            uint32_t t = rol(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rol(b, 30);
+            b = a;
+            a = t;
+        }
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+        h[4] += e;
+    }
+    for (int i = 0; i < 5; i++) {
+        digest[i * 4] = (uint8_t)(h[i] >> 24);
+        digest[i * 4 + 1] = (uint8_t)(h[i] >> 16);
+        digest[i * 4 + 2] = (uint8_t)(h[i] >> 8);
+        digest[i * 4 + 3] = (uint8_t)h[i];
+    }
+}
+
+std::string base64(const uint8_t *data, size_t len)
+{
+    static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    out.reserve((len + 2) / 3 * 4);
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t v = (uint32_t)data[i] << 16;
+        if (i + 1 < len)
+            v |= (uint32_t)data[i + 1] << 8;
+        if (i + 2 < len)
+            v |= data[i + 2];
+        out.push_back(table[(v >> 18) & 63]);
+        out.push_back(table[(v >> 12) & 63]);
+        out.push_back(i + 1 < len ? table[(v >> 6) & 63] : '=');
+        out.push_back(i + 2 < len ? table[v & 63] : '=');
+    }
+    return out;
+}
+
+std::string trim(const char *begin, const char *end)
+{
+    while (begin < end && (*begin == ' ' || *begin == '\t'))
+        begin++;
+    while (end > begin && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r'))
+        end--;
+    return std::string(begin, end);
+}
+
+bool contains_token(const std::string &value, const char *token)
+{
+    size_t n = strlen(token);
+    for (size_t i = 0; i + n <= value.size(); i++) {
+        if (strncasecmp(value.c_str() + i, token, n) == 0)
+            return true;
+    }
+    return false;
+}
+
+// XORs len bytes with the frame mask, starting at offset pos of the frame payload
+void unmask(uint8_t *dst, const uint8_t *src, size_t len, const uint8_t mask[4], uint64_t pos)
+{
+    uint8_t rotated[8];
+    for (int i = 0; i < 8; i++)
+        rotated[i] = mask[(pos + i) & 3];
+    uint64_t word;
+    memcpy(&word, rotated, sizeof(word));
+
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t v;
+        memcpy(&v, src + i, sizeof(v));
+        v ^= word;
+        memcpy(dst + i, &v, sizeof(v));
+    }
+    for (; i < len; i++)
+        dst[i] = src[i] ^ rotated[i & 7];
+}
+
+} // namespace
+
+std::string accept_key(const std::string &client_key)
+{
+    std::string text = client_key + GUID;
+    uint8_t digest[20];
+    sha1((const uint8_t *)text.data(), text.size(), digest);
+    return base64(digest, sizeof(digest));
+}
+
+int parse_upgrade(const char *data, size_t len, std::string &key, std::string &path)
+{
+    const char *end = nullptr;
+    for (size_t i = 3; i < len; i++) {
+        if (data[i - 3] == '\r' && data[i - 2] == '\n' && data[i - 1] == '\r' && data[i] == '\n') {
+            end = data + i + 1;
+            break;
+        }
+    }
+    if (!end)
+        return len > 8192 ? -1 : 0;
+    if (len < 4 || strncmp(data, "GET ", 4) != 0)
+        return -1;
+
+    const char *line = data;
+    const char *eol = (const char *)memchr(line, '\n', end - line);
+    const char *target = data + 4;
+    const char *target_end = (const char *)memchr(target, ' ', eol - target);
+    if (!target_end)
+        return -1;
+    path.assign(target, target_end);
+
+    bool upgrade = false, connection = false;
+    std::string version;
+    key.clear();
+    for (line = eol + 1; line < end; line = eol + 1) {
+        eol = (const char *)memchr(line, '\n', end - line);
+        const char *colon = (const char *)memchr(line, ':', eol - line);
+        if (!colon)
+            continue;
+        std::string name = trim(line, colon);
+        std::string value = trim(colon + 1, eol);
+        if (strcasecmp(name.c_str(), "Upgrade") == 0)
+            upgrade = contains_token(value, "websocket");
+        else if (strcasecmp(name.c_str(), "Connection") == 0)
+            connection = contains_token(value, "upgrade");
+        else if (strcasecmp(name.c_str(), "Sec-WebSocket-Key") == 0)
+            key = value;
+        else if (strcasecmp(name.c_str(), "Sec-WebSocket-Version") == 0)
+            version = value;
+    }
+    if (!upgrade || !connection || key.empty() || version != "13")
+        return -1;
+    return (int)(end - data);
+}
+
+std::string upgrade_response(const std::string &client_key)
+{
+    return "HTTP/1.1 101 Switching Protocols\r\n"
+           "Upgrade: websocket\r\n"
+           "Connection: Upgrade\r\n"
+           "Sec-WebSocket-Accept: " + accept_key(client_key) + "\r\n\r\n";
+}
+
+void append_frame(std::vector<uint8_t> &out, uint8_t opcode, const void *payload, size_t len, const uint8_t *mask)
+{
+    uint8_t mask_bit = mask ? 0x80 : 0;
+    out.push_back(opcode);
+    if (len < 126) {
+        out.push_back(mask_bit | (uint8_t)len);
+    } else if (len <= 0xffff) {
+        out.push_back(mask_bit | 126);
+        out.push_back((uint8_t)(len >> 8));
+        out.push_back((uint8_t)len);
+    } else {
+        out.push_back(mask_bit | 127);
+        for (int i = 7; i >= 0; i--)
+            out.push_back((uint8_t)((uint64_t)len >> (i * 8)));
+    }
+    size_t at = out.size();
+    if (mask)
+        out.insert(out.end(), mask, mask + 4);
+    out.insert(out.end(), (const uint8_t *)payload, (const uint8_t *)payload + len);
+    if (mask && len)
+        unmask(&out[at + 4], &out[at + 4], len, mask, 0);
+}
+
+frame_parser::frame_parser(size_t max_message)
+    : m_max_message(max_message)
+{
+}
+
+const std::vector<uint8_t> &frame_parser::payload() const
+{
+    return m_ready_control ? m_control : m_message;
+}
+
+std::vector<uint8_t> frame_parser::take_payload()
+{
+    std::vector<uint8_t> out;
+    if (m_ready_control)
+        out.swap(m_control);
+    else
+        out.swap(m_message);
+    m_ready_opcode = 0;
+    return out;
+}
+
+bool frame_parser::header_complete()
+{
+    uint8_t b0 = m_header[0], b1 = m_header[1];
+    m_frame_fin = (b0 & OP_FIN) != 0;
+    m_frame_opcode = b0 & 0x0f;
+    m_masked = (b1 & 0x80) != 0;
+
+    uint64_t len = b1 & 0x7f;
+    size_t at = 2;
+    if (len == 126) {
+        len = (uint64_t)m_header[2] << 8 | m_header[3];
+        at = 4;
+    } else if (len == 127) {
+        len = 0;
+        for (int i = 0; i < 8; i++)
+            len = len << 8 | m_header[2 + i];
+        at = 10;
+    }
+    if (m_masked)
+        memcpy(m_mask, m_header + at, 4);
+    m_frame_left = len;
+    m_frame_pos = 0;
+
+    if (b0 & 0x70)
+        return false; // no extensions were negotiated
+    if (m_require_mask && !m_masked)
+        return false;
+    if (m_frame_opcode >= OP_CLOSE) {
+        return m_frame_opcode <= OP_PONG && m_frame_fin && len <= 125;
+    }
+    if (m_frame_opcode == OP_CONT) {
+        if (!m_message_opcode)
+            return false;
+    } else if (m_frame_opcode == OP_TEXT || m_frame_opcode == OP_BINARY) {
+        if (m_message_opcode)
+            return false;
+        m_message_opcode = m_frame_opcode;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+frame_parser::result frame_parser::feed(const uint8_t *data, size_t len, size_t &consumed)
+{
+    size_t pos = 0;
+
+    // the previous message has been handed out, start the next one afresh
+    if (m_ready_opcode) {
+        if (m_ready_control)
+            m_control.clear();
+        else
+            m_message.clear();
+        m_ready_opcode = 0;
+    }
+
+    for (;;) {
+        if (m_header_len < m_header_need) {
+            while (m_header_len < m_header_need && pos < len) {
+                m_header[m_header_len++] = data[pos++];
+                if (m_header_len == 2) {
+                    uint8_t code = m_header[1] & 0x7f;
+                    m_header_need = 2 + ((m_header[1] & 0x80) ? 4 : 0) + (code == 126 ? 2 : code == 127 ? 8 : 0);
+                }
+            }
+            if (m_header_len < m_header_need) {
+                consumed = pos;
+                return NEED_MORE;
+            }
+            if (!header_complete()) {
+                consumed = pos;
+                return ERROR_PROTOCOL;
+            }
+            if (m_frame_opcode < OP_CLOSE) {
+                if (m_frame_left > m_max_message - m_message.size()) {
+                    consumed = pos;
+                    return ERROR_TOO_BIG;
+                }
+                m_message.reserve(m_message.size() + (size_t)m_frame_left);
+            } else {
+                m_control.clear();
+            }
+        }
+
+        std::vector<uint8_t> &dst = m_frame_opcode >= OP_CLOSE ? m_control : m_message;
+        size_t n = (size_t)std::min<uint64_t>(m_frame_left, len - pos);
+        if (n) {
+            size_t at = dst.size();
+            dst.resize(at + n);
+            if (m_masked)
+                unmask(&dst[at], data + pos, n, m_mask, m_frame_pos);
+            else
+                memcpy(&dst[at], data + pos, n);
+            pos += n;
+            m_frame_left -= n;
+            m_frame_pos += n;
+        }
+        if (m_frame_left) {
+            consumed = pos;
+            return NEED_MORE;
+        }
+
+        // frame finished, the next bytes are a new header
+        m_header_len = 0;
+        m_header_need = 2;
+        if (m_frame_opcode >= OP_CLOSE) {
+            m_ready_opcode = m_frame_opcode;
+            m_ready_control = true;
+            consumed = pos;
+            return MESSAGE;
+        }
+        if (m_frame_fin) {
+            m_ready_opcode = m_message_opcode;
+            m_ready_control = false;
+            m_message_opcode = 0;
+            consumed = pos;
+            return MESSAGE;
+        }
+    }
+}
+
+} // namespace ws
+} // namespace edge
@@ -0,0 +1,99 @@
+// WebSocket (RFC 6455) server side handshake and framing.
+//
+// The opcodes keep the values of ws_transport_opcodes_t used by the cameras'
+// esp_websocket_client, so a message seen here reads the same as it was sent.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace edge {
+namespace ws {
+
+enum opcode : uint8_t {
+    OP_CONT   = 0x00,
+    OP_TEXT   = 0x01,
+    OP_BINARY = 0x02,
+    OP_CLOSE  = 0x08,
+    OP_PING   = 0x09,
+    OP_PONG   = 0x0a,
+    OP_FIN    = 0x80,
+};
+
+enum close_code : uint16_t {
+    CLOSE_NORMAL       = 1000,
+    CLOSE_PROTOCOL     = 1002,
+    CLOSE_TOO_BIG      = 1009,
+};
+
+// Sec-WebSocket-Accept value for a client's Sec-WebSocket-Key
+std::string accept_key(const std::string &client_key);
+
+// Parses an HTTP upgrade request.
+// Returns the request length once the headers are complete and valid, 0 while
+// more bytes are needed and -1 if it is not a WebSocket upgrade.
+int parse_upgrade(const char *data, size_t len, std::string &key, std::string &path);
+
+// 101 Switching Protocols response for a parsed upgrade request
+std::string upgrade_response(const std::string &client_key);
+
+// Appends one frame to out. Server frames go unmasked; clients pass a mask.
+void append_frame(std::vector<uint8_t> &out, uint8_t opcode, const void *payload, size_t len, const uint8_t *mask = nullptr);
+
+// Incremental frame reader reassembling fragmented messages.
+//
+// Payloads are unmasked straight into the message buffer, so a binary frame
+// costs one pass over its bytes. Control frames may arrive in the middle of a
+// fragmented message and are reported on their own.
+class frame_parser {
+public:
+    enum result {
+        NEED_MORE,      // all input consumed, no message complete
+        MESSAGE,        // a message is ready in opcode() / payload()
+        ERROR_PROTOCOL, // malformed or unmasked client frame
+        ERROR_TOO_BIG,  // message longer than max_message
+    };
+
+    explicit frame_parser(size_t max_message);
+
+    // Consumes input up to the end of the next complete message and sets
+    // consumed to the bytes used. After MESSAGE, call feed() again with the
+    // rest of the input.
+    result feed(const uint8_t *data, size_t len, size_t &consumed);
+
+    uint8_t opcode() const { return m_ready_opcode; }
+    const std::vector<uint8_t> &payload() const;
+    // Moves a data message payload out, leaving the parser a fresh buffer
+    std::vector<uint8_t> take_payload();
+
+    void set_require_mask(bool require) { m_require_mask = require; }
+
+private:
+    bool header_complete();
+
+    size_t m_max_message;
+    bool m_require_mask = true;
+
+    uint8_t m_header[14];
+    size_t m_header_len = 0;
+    size_t m_header_need = 2;
+
+    uint8_t m_frame_opcode = 0;
+    bool m_frame_fin = false;
+    bool m_masked = false;
+    uint8_t m_mask[4] = {};
+    uint64_t m_frame_left = 0;
+    uint64_t m_frame_pos = 0;
+
+    uint8_t m_message_opcode = 0; // first opcode of the data message being assembled
+    std::vector<uint8_t> m_message;
+    std::vector<uint8_t> m_control;
+
+    uint8_t m_ready_opcode = 0;
+    bool m_ready_control = false;
+};
+
+} // namespace ws
+} // namespace edge
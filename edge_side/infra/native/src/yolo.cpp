@@ -0,0 +1,168 @@
+#include "yolo.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace edge {
+
+void resize_bilinear(const uint8_t *src, int sw, int sh, uint8_t *dst, int dw, int dh, int channels)
+{
+    const int BITS = 11, ONE = 1 << BITS;
+    double scale_x = (double)sw / dw, scale_y = (double)sh / dh;
+
+    // per destination column: left source pixel and its weight
+    std::vector<int> xofs(dw);
+    std::vector<int> xw(dw);
+    for (int x = 0; x < dw; x++) {
+        float fx = (float)((x + 0.5) * scale_x - 0.5);
+        int sx = (int)floorf(fx);
+        fx -= sx;
+        if (sx < 0) {
+            fx = 0;
+            sx = 0;
+        }
+        if (sx >= sw - 1) {
+            fx = 0;
+            sx = sw - 1;
+        }
+        xofs[x] = sx;
+        xw[x] = (int)lrintf((1.f - fx) * ONE);
+    }
+
+    std::vector<int> row0(dw * channels), row1(dw * channels);
+    auto horizontal = [&](int y, std::vector<int> &row) {
+        const uint8_t *s = src + (size_t)y * sw * channels;
+        for (int x = 0; x < dw; x++) {
+            const uint8_t *p0 = s + xofs[x] * channels;
+            const uint8_t *p1 = xofs[x] + 1 < sw ? p0 + channels : p0;
+            for (int c = 0; c < channels; c++)
+                row[x * channels + c] = p0[c] * xw[x] + p1[c] * (ONE - xw[x]);
+        }
+    };
+
+    int cached0 = -1, cached1 = -1;
+    for (int y = 0; y < dh; y++) {
+        float fy = (float)((y + 0.5) * scale_y - 0.5);
+        int sy = (int)floorf(fy);
+        fy -= sy;
+        if (sy < 0) {
+            fy = 0;
+            sy = 0;
+        }
+        int sy1 = std::min(sy + 1, sh - 1);
+        if (sy >= sh - 1) {
+            fy = 0;
+            sy = sy1 = sh - 1;
+        }
+        int wy = (int)lrintf((1.f - fy) * ONE);
+
+        if (cached0 != sy) {
+            if (cached1 == sy)
+                std::swap(row0, row1), cached0 = sy, cached1 = -1;
+            else
+                horizontal(sy, row0), cached0 = sy;
+        }
+        if (cached1 != sy1)
+            horizontal(sy1, row1), cached1 = sy1;
+
+        uint8_t *d = dst + (size_t)y * dw * channels;
+        for (int i = 0; i < dw * channels; i++) {
+            int64_t v = (int64_t)row0[i] * wy + (int64_t)row1[i] * (ONE - wy);
+            d[i] = (uint8_t)std::min<int64_t>(255, (v + (1 << (2 * BITS - 1))) >> (2 * BITS));
+        }
+    }
+}
+
+yolo_detector::yolo_detector(const yolo_config &config)
+    : m_config(config),
+      m_net(config.threads),
+      m_decoder(decode_config{config.num_classes, config.conf, config.iou, config.max_det})
+{
+}
+
+bool yolo_detector::load()
+{
+    return m_net.load(m_config.model_dir + "/model.ncnn.param", m_config.model_dir + "/model.ncnn.bin");
+}
+
+letterbox yolo_detector::preprocess(const bgr_image &image, int size, tensor &input)
+{
+    int w = image.width, h = image.height;
+    double gain = std::min((double)size / h, (double)size / w);
+    int nw = (int)lrint(w * gain), nh = (int)lrint(h * gain);
+    // Ultralytics: top = round(dh - 0.1), left = round(dw - 0.1)
+    int pad_x = (int)lrint((size - nw) / 2.0 - 0.1);
+    int pad_y = (int)lrint((size - nh) / 2.0 - 0.1);
+
+    std::vector<uint8_t> resized;
+    const uint8_t *pixels = image.data.data();
+    if (nw != w || nh != h) {
+        resized.resize((size_t)nw * nh * 3);
+        resize_bilinear(image.data.data(), w, h, resized.data(), nw, nh, 3);
+        pixels = resized.data();
+    }
+
+    if (input.empty() || input.w != size || input.h != size || input.c != 3)
+        input = tensor::make_3d(size, size, 3);
+    const float pad = 114.f / 255.f;
+    std::fill(input.data, input.data + input.total(), pad);
+
+    // BGR interleaved -> planar RGB in [0, 1]
+    float *r = input.channel(0), *g = input.channel(1), *b = input.channel(2);
+    for (int y = 0; y < nh; y++) {
+        const uint8_t *src = pixels + (size_t)y * nw * 3;
+        size_t o = (size_t)(y + pad_y) * size + pad_x;
+        for (int x = 0; x < nw; x++) {
+            b[o + x] = src[x * 3 + 0] / 255.f;
+            g[o + x] = src[x * 3 + 1] / 255.f;
+            r[o + x] = src[x * 3 + 2] / 255.f;
+        }
+    }
+    // scale_boxes() derives the offset from the unrounded size
+    return {(float)gain, (int)lrint((size - w * gain) / 2.0 - 0.1), (int)lrint((size - h * gain) / 2.0 - 0.1)};
+}
+
+bool yolo_detector::infer(const tensor &input, tensor &output, std::vector<layer_timing> *timings)
+{
+    return m_net.forward("in0", input, "out0", output, timings);
+}
+
+void yolo_detector::postprocess(const tensor &output, const letterbox &lb, int width, int height,
+                                std::vector<detection> &out)
+{
+    // out0 is (w = anchors, h = 4 + classes)
+    m_decoder.decode(output.data, output.w, lb, width, height, out);
+}
+
+bool yolo_detector::detect(const bgr_image &image, std::vector<detection> &out, std::vector<layer_timing> *timings)
+{
+    std::vector<std::vector<detection>> batch(1);
+    batch[0].swap(out);
+    if (!detect_batch({&image}, batch, timings))
+        return false;
+    out.swap(batch[0]);
+    return true;
+}
+
+bool yolo_detector::detect_batch(const std::vector<const bgr_image *> &images, std::vector<std::vector<detection>> &out,
+                                 std::vector<layer_timing> *timings)
+{
+    const size_t n = images.size();
+    if (m_inputs.size() < n)
+        m_inputs.resize(n);
+    std::vector<letterbox> boxes(n);
+    for (size_t i = 0; i < n; i++)
+        boxes[i] = preprocess(*images[i], m_config.input_size, m_inputs[i]);
+
+    std::vector<tensor> outputs;
+    if (!m_net.forward_batch("in0", std::vector<tensor>(m_inputs.begin(), m_inputs.begin() + n), "out0", outputs,
+                             timings))
+        return false;
+    out.resize(n);
+    for (size_t i = 0; i < n; i++)
+        postprocess(outputs[i], boxes[i], images[i]->width, images[i]->height, out[i]);
+    return true;
+}
+
+} // namespace edge
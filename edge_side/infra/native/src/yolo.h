@@ -0,0 +1,57 @@
+// YOLOv11 detector on the ncnn export in weights/yolov11n_ncnn_model.
+//
+// Reproduces what Ultralytics does around model.predict(): letterbox to the
+// model size with grey (114) padding, RGB / 255 input, then confidence
+// filtering, per-class NMS and mapping the boxes back to the source image
+// (postprocess.h).
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "frame_decoder.h"
+#include "net.h"
+#include "postprocess.h"
+
+namespace edge {
+
+struct yolo_config {
+    std::string model_dir;  // holds model.ncnn.param and model.ncnn.bin
+    int input_size = 640;   // imgsz the model was exported with
+    int num_classes = 1;    // metadata.yaml names
+    float conf = 0.25f;     // same defaults as Ultralytics predict
+    float iou = 0.7f;
+    int max_det = 300;
+    int threads = 0;
+};
+
+class yolo_detector {
+public:
+    explicit yolo_detector(const yolo_config &config);
+
+    bool load();
+    bool detect(const bgr_image &image, std::vector<detection> &out, std::vector<layer_timing> *timings = nullptr);
+    // One inference over several frames (batch_scheduler.h); out[i] belongs to images[i]
+    bool detect_batch(const std::vector<const bgr_image *> &images, std::vector<std::vector<detection>> &out,
+                      std::vector<layer_timing> *timings = nullptr);
+
+    // Building blocks of detect(), exposed for tests and tools
+    static letterbox preprocess(const bgr_image &image, int size, tensor &input);
+    bool infer(const tensor &input, tensor &output, std::vector<layer_timing> *timings = nullptr);
+    void postprocess(const tensor &output, const letterbox &lb, int width, int height, std::vector<detection> &out);
+
+    const yolo_config &config() const { return m_config; }
+    int threads() const { return m_net.threads(); }
+
+private:
+    yolo_config m_config;
+    net m_net;
+    detection_decoder m_decoder;
+    std::vector<tensor> m_inputs; // one per batch slot, reused
+};
+
+// Bilinear resize of interleaved 8-bit pixels with OpenCV's INTER_LINEAR
+// sampling and fixed-point weights
+void resize_bilinear(const uint8_t *src, int sw, int sh, uint8_t *dst, int dw, int dh, int channels);
+
+} // namespace edge
@@ -0,0 +1,240 @@
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "batch_scheduler.h"
+#include "unity.h"
+
+using namespace edge;
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// Stand-in for the detector: one detection per image whose class is the
+// image width, so results can be traced back to their frames
+struct fake_model {
+    std::chrono::milliseconds per_batch{0};
+    bool fail = false;
+    std::mutex mutex;
+    std::vector<size_t> batch_sizes;
+
+    batch_infer_fn fn()
+    {
+        return [this](const std::vector<const bgr_image *> &images, std::vector<std::vector<detection>> &out) {
+            std::this_thread::sleep_for(per_batch);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                batch_sizes.push_back(images.size());
+            }
+            out.resize(images.size());
+            for (size_t i = 0; i < images.size(); i++)
+                out[i] = {{0, 0, 1, 1, 0.9f, images[i]->width}};
+            return !fail;
+        };
+    }
+};
+
+struct collected {
+    std::mutex mutex;
+    std::vector<batch_result> results;
+
+    std::function<void(batch_result &)> fn()
+    {
+        return [this](batch_result &r) {
+            std::lock_guard<std::mutex> lock(mutex);
+            results.push_back(std::move(r));
+        };
+    }
+
+    bool wait_for(size_t n, std::chrono::milliseconds timeout = std::chrono::milliseconds(5000))
+    {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (std::chrono::steady_clock::now() < deadline) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (results.size() >= n)
+                    return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return false;
+    }
+};
+
+static frame_ptr make_frame(uint32_t camera, uint64_t sequence)
+{
+    frame_ptr f(new frame);
+    f->camera = camera;
+    f->sequence = sequence;
+    f->image.width = (uint16_t)camera;
+    f->image.height = 1;
+    return f;
+}
+
+static void full_batch_should_start_at_once_and_scatter_results(void)
+{
+    fake_model model;
+    collected out;
+    batch_config config;
+    config.max_batch = 4;
+    config.max_wait = std::chrono::seconds(10);
+    config.slo = std::chrono::seconds(10);
+    batch_scheduler scheduler(config, model.fn(), out.fn());
+    scheduler.start();
+    for (uint32_t camera = 1; camera <= 4; camera++)
+        scheduler.submit(make_frame(camera, 1));
+
+    TEST_ASSERT_TRUE(out.wait_for(4, std::chrono::milliseconds(2000)));
+    scheduler.stop();
+    for (batch_result &r : out.results) {
+        TEST_ASSERT_EQUAL_INT(4, r.batch_size);
+        TEST_ASSERT_EQUAL_UINT64(1, r.detections.size());
+        TEST_ASSERT_EQUAL_INT((int)r.frame->camera, r.detections[0].cls);
+    }
+
+    batch_report report = scheduler.report();
+    TEST_ASSERT_EQUAL_UINT64(1, report.batches);
+    TEST_ASSERT_EQUAL_UINT64(1, report.full);
+    TEST_ASSERT_EQUAL_UINT64(4, report.frames);
+    TEST_ASSERT_EQUAL_UINT64(1, report.sizes[4]);
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, 1.0, report.fill);
+}
+
+static void partial_batch_should_start_after_max_wait(void)
+{
+    fake_model model;
+    collected out;
+    batch_config config;
+    config.max_batch = 4;
+    config.max_wait = std::chrono::milliseconds(30);
+    batch_scheduler scheduler(config, model.fn(), out.fn());
+    scheduler.start();
+    scheduler.submit(make_frame(1, 1));
+    scheduler.submit(make_frame(2, 1));
+
+    TEST_ASSERT_TRUE(out.wait_for(2));
+    scheduler.stop();
+    TEST_ASSERT_EQUAL_INT(2, out.results[0].batch_size);
+    TEST_ASSERT_TRUE(out.results[0].queue_us >= 25000);
+    TEST_ASSERT_TRUE(out.results[0].queue_us < 1000000);
+
+    batch_report report = scheduler.report();
+    TEST_ASSERT_EQUAL_UINT64(1, report.deadline);
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, 0.5, report.fill);
+}
+
+static void newer_frame_should_replace_a_waiting_one(void)
+{
+    fake_model model;
+    collected out;
+    batch_config config;
+    config.max_batch = 2;
+    batch_scheduler scheduler(config, model.fn(), out.fn());
+    // queued before start, so nothing runs in between
+    scheduler.submit(make_frame(1, 1));
+    scheduler.submit(make_frame(2, 1));
+    scheduler.submit(make_frame(1, 2));
+    scheduler.start();
+
+    TEST_ASSERT_TRUE(out.wait_for(2));
+    scheduler.stop();
+    std::map<uint32_t, uint64_t> sequence;
+    for (batch_result &r : out.results)
+        sequence[r.frame->camera] = r.frame->sequence;
+    TEST_ASSERT_EQUAL_UINT64(2, sequence[1]);
+    TEST_ASSERT_EQUAL_UINT64(1, sequence[2]);
+    // camera 1 kept its place at the front
+    TEST_ASSERT_EQUAL_UINT32(1, out.results[0].frame->camera);
+    TEST_ASSERT_EQUAL_UINT64(1, scheduler.report().superseded);
+}
+
+static void slo_should_cut_the_wait_short(void)
+{
+    fake_model model;
+    model.per_batch = std::chrono::milliseconds(40);
+    collected out;
+    batch_config config;
+    config.max_batch = 8;
+    config.max_wait = std::chrono::seconds(10);
+    config.slo = std::chrono::milliseconds(60);
+    batch_scheduler scheduler(config, model.fn(), out.fn());
+    scheduler.start();
+
+    // no measurement yet: the frame waits until the SLO itself
+    scheduler.submit(make_frame(1, 1));
+    TEST_ASSERT_TRUE(out.wait_for(1));
+    TEST_ASSERT_TRUE(out.results[0].queue_us >= 50000);
+    TEST_ASSERT_TRUE(out.results[0].queue_us < 1000000);
+
+    // now a batch of 2 is expected to take ~80 ms, more than the SLO leaves,
+    // so a lone frame starts without waiting for company
+    scheduler.submit(make_frame(2, 1));
+    TEST_ASSERT_TRUE(out.wait_for(2));
+    scheduler.stop();
+    TEST_ASSERT_TRUE(out.results[1].queue_us < 30000);
+    TEST_ASSERT_EQUAL_INT(1, out.results[1].batch_size);
+
+    batch_report report = scheduler.report();
+    TEST_ASSERT_EQUAL_UINT64(2, report.deadline);
+    // the first frame waited 60 ms and then ran for 40
+    TEST_ASSERT_TRUE(report.slo_misses >= 1);
+}
+
+static void failed_inference_should_count_and_skip_results(void)
+{
+    fake_model model;
+    model.fail = true;
+    batch_config config;
+    config.max_batch = 2;
+    collected out;
+    batch_scheduler scheduler(config, model.fn(), out.fn());
+    scheduler.start();
+    scheduler.submit(make_frame(1, 1));
+    scheduler.submit(make_frame(2, 1));
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(model.mutex);
+            if (!model.batch_sizes.empty())
+                break;
+        }
+        TEST_ASSERT_TRUE(std::chrono::steady_clock::now() < deadline);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    scheduler.stop();
+    TEST_ASSERT_EQUAL_UINT64(0, out.results.size());
+    batch_report report = scheduler.report();
+    TEST_ASSERT_EQUAL_UINT64(2, report.failed);
+    TEST_ASSERT_EQUAL_UINT64(0, report.frames);
+}
+
+static void stop_should_drop_pending_frames(void)
+{
+    fake_model model;
+    collected out;
+    batch_config config;
+    config.max_batch = 4;
+    config.max_wait = std::chrono::seconds(10);
+    config.slo = std::chrono::seconds(10);
+    batch_scheduler scheduler(config, model.fn(), out.fn());
+    scheduler.start();
+    scheduler.submit(make_frame(1, 1));
+    scheduler.stop();
+    TEST_ASSERT_EQUAL_UINT64(0, out.results.size());
+    TEST_ASSERT_EQUAL_UINT64(0, scheduler.report().batches);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(full_batch_should_start_at_once_and_scatter_results);
+    RUN_TEST(partial_batch_should_start_after_max_wait);
+    RUN_TEST(newer_frame_should_replace_a_waiting_one);
+    RUN_TEST(slo_should_cut_the_wait_short);
+    RUN_TEST(failed_inference_should_count_and_skip_results);
+    RUN_TEST(stop_should_drop_pending_frames);
+    return UNITY_END();
+}
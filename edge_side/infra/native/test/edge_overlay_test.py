@@ -0,0 +1,46 @@
+"""Checks python/edge_overlay.py on a plain buffer; run by ctest."""
+
+import os
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), "..", "python"))
+
+from edge_overlay import annotate_jpeg, draw, encode_jpeg, patch_jpeg  # noqa: E402
+
+
+def pixel(frame, width, x, y):
+    i = (y * width + x) * 3
+    return tuple(frame[i:i + 3])
+
+
+def main():
+    width, height = 96, 64
+    frame = bytearray([100]) * (width * height * 3)
+
+    draw(frame, [(20.0, 20.0, 60.0, 50.0, 0.9, 0)], size=(width, height))
+    assert pixel(frame, width, 20, 35) == (0x38, 0x38, 0xFF), pixel(frame, width, 20, 35)
+    assert pixel(frame, width, 40, 45) == (100, 100, 100)
+
+    jpeg = encode_jpeg(frame, quality=80, size=(width, height))
+    assert jpeg[:2] == b"\xff\xd8" and jpeg[-2:] == b"\xff\xd9", jpeg[:4]
+
+    other = bytearray([30]) * (width * height * 3)
+    jpeg = annotate_jpeg(other, [], count=3, size=(width, height))
+    assert pixel(other, width, 1, 1) == (0, 0, 0)
+    assert len(jpeg) > 100
+
+    patched = patch_jpeg(jpeg, [(10.0, 10.0, 50.0, 40.0, 0.8, 0)], count=1)
+    assert patched[:2] == b"\xff\xd8" and patched[-2:] == b"\xff\xd9", patched[:4]
+    assert patched != jpeg
+    assert patch_jpeg(b"\xff\xd8\xff\xd9", []) is None
+
+    try:
+        draw(bytes(frame), [], size=(width, height))
+        raise AssertionError("drew on a read-only buffer")
+    except ValueError:
+        pass
+    print("edge_overlay: OK")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,48 @@
+"""Checks python/edge_post.py against hand-computed boxes; run by ctest."""
+
+import array
+import os
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), "..", "python"))
+
+from edge_post import decode  # noqa: E402
+
+
+def head_of(boxes, classes):
+    """One anchor per (cx, cy, w, h, score, cls) box, as float32 rows."""
+    n = len(boxes)
+    rows = [[0.0] * n for _ in range(4 + classes)]
+    for i, (cx, cy, w, h, score, cls) in enumerate(boxes):
+        rows[0][i], rows[1][i], rows[2][i], rows[3][i] = cx, cy, w, h
+        rows[4 + cls][i] = score
+    return array.array("f", [v for row in rows for v in row])
+
+
+def main():
+    head = head_of([(100, 100, 50, 50, 0.9, 0),
+                    (102, 101, 50, 50, 0.8, 0),
+                    (101, 100, 50, 50, 0.85, 1),
+                    (300, 300, 40, 40, 0.2, 0)], 2)
+
+    dets = decode(head, num_classes=2)
+    assert [round(d[4], 2) for d in dets] == [0.9, 0.85], dets
+    assert [d[5] for d in dets] == [0, 1], dets
+    assert dets[0][:4] == (75.0, 75.0, 125.0, 125.0), dets
+
+    # letterboxed 1280x720 frame: gain 0.5, 140 rows of padding
+    dets = decode(head, num_classes=2, gain=0.5, pad=(0, 140), image_size=(1280, 720))
+    assert dets[0][:4] == (150.0, 0.0, 250.0, 0.0), dets
+
+    assert len(decode(head, num_classes=2, max_det=1)) == 1
+    assert len(decode(bytes(head), num_classes=2, conf=0.95)) == 0
+    try:
+        decode(head, num_classes=3)
+        raise AssertionError("accepted a head of the wrong shape")
+    except ValueError:
+        pass
+    print("edge_post: OK")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,85 @@
+"""Checks python/edge_ring.py within one process; run by ctest."""
+
+import gc
+import os
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), "..", "python"))
+
+from edge_ring import JPEG, FrameRing, RingReader  # noqa: E402
+
+
+def main():
+    name = "/edge_ring_python_%d" % os.getpid()
+    with FrameRing(name, slots=4, slot_size=1000) as ring:
+        other = FrameRing(name)
+        reader = RingReader(other)
+        recorder = RingReader(ring, reliable=True)
+        assert reader.next(timeout=0) is None
+
+        frame = bytearray(range(256)) * 3
+        assert ring.write(frame, camera=2, width=16, height=16)
+        assert ring.write(b"\xff\xd8\xff\xd9", camera=5, format=JPEG, timestamp_us=7)
+
+        got = reader.next(timeout=0)
+        assert got.sequence == 0 and got.camera == 2 and (got.width, got.height) == (16, 16), got
+        assert bytes(got.data) == bytes(frame)
+        assert reader.valid(got)
+        got = reader.next(timeout=0)
+        assert got.format == JPEG and got.timestamp_us == 7 and bytes(got.data) == b"\xff\xd8\xff\xd9", got
+
+        # the recorder has not read anything, so the ring fills up
+        assert ring.write(b"a") and ring.write(b"b")
+        assert not ring.write(b"c")
+        assert recorder.next(timeout=0).sequence == 0
+        assert recorder.next(timeout=0).sequence == 1
+        assert ring.write(b"c")
+        recorder.close()
+
+        # a lossy reader's frame can be overwritten while it holds it
+        held = reader.next(timeout=0)
+        for i in range(4):
+            assert ring.write(b"x%d" % i)
+        assert not reader.valid(held)
+        assert bytes(reader.next(timeout=0, latest=True).data) == b"x3"
+
+        assert not ring.write(bytes(1001))
+        reader.close()
+        other.close()
+
+        # a frame keeps its reader and mapping alive after the last other reference is gone
+        temporary = RingReader(FrameRing(name))
+        assert ring.write(b"kept")
+        kept = temporary.next(timeout=0, latest=True)
+        del temporary
+        gc.collect()
+        assert bytes(kept.data) == b"kept"
+
+        # closing a ring that is still in use waits for its readers and frames
+        late = FrameRing(name)
+        reader = RingReader(late)
+        assert ring.write(b"late")
+        got = reader.next(timeout=0)
+        late.close()
+        assert bytes(got.data) == b"late" and reader.valid(got)
+        try:
+            late.write(b"x")
+            raise AssertionError("wrote to a closed ring")
+        except ValueError:
+            pass
+        reader.close()
+        assert bytes(got.data) == b"late"
+        del got, kept
+        gc.collect()
+        assert late._ring is None
+
+    try:
+        FrameRing(name)
+        raise AssertionError("the ring outlived its creator")
+    except OSError:
+        pass
+    print("edge_ring: OK")
+
+
+if __name__ == "__main__":
+    main()
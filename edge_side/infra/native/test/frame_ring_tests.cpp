@@ -0,0 +1,283 @@
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "frame_ring.h"
+#include "unity.h"
+
+using namespace edge;
+
+static std::string ring_name;
+
+void setUp(void)
+{
+    ring_name = "/edge_ring_test_" + std::to_string(getpid());
+}
+
+void tearDown(void)
+{
+    frame_ring::remove(ring_name);
+}
+
+static const std::chrono::microseconds NO_WAIT(0);
+static const std::chrono::microseconds WAIT(std::chrono::seconds(5));
+
+// A frame whose bytes all derive from its number
+static bool write_frame(frame_ring &ring, uint64_t n, uint32_t size = 1000)
+{
+    ring_slot slot;
+    if (!ring.try_claim(slot))
+        return false;
+    slot.info->camera = (uint32_t)(n % 7);
+    slot.info->width = (uint32_t)n;
+    slot.info->size = size;
+    memset(slot.data, (int)(n & 0xFF), size);
+    ring.publish(slot);
+    return true;
+}
+
+static bool frame_is(const ring_view &view, uint64_t n)
+{
+    if (view.info.width != (uint32_t)n || view.info.camera != n % 7)
+        return false;
+    for (uint32_t i = 0; i < view.info.size; i++)
+        if (view.data[i] != (n & 0xFF))
+            return false;
+    return true;
+}
+
+static void ring_should_round_slots_and_refuse_bad_rings(void)
+{
+    frame_ring ring;
+    TEST_ASSERT_TRUE(ring.create(ring_name, 5, 1000));
+    TEST_ASSERT_EQUAL_UINT32(8, ring.slots());
+    TEST_ASSERT_EQUAL_UINT64(1000, ring.slot_size());
+
+    frame_ring other;
+    TEST_ASSERT_FALSE(other.create(ring_name + "_zero", 0, 1000));
+    TEST_ASSERT_FALSE(other.open(ring_name + "_missing"));
+    TEST_ASSERT_FALSE(other.is_open());
+
+    // oversized frames are refused before claiming a slot
+    std::vector<uint8_t> big(1001);
+    frame_info info;
+    info.size = (uint32_t)big.size();
+    TEST_ASSERT_FALSE(ring.try_write(info, big.data()));
+    TEST_ASSERT_EQUAL_UINT64(0, ring.written());
+
+    // the creator removes the object
+    ring.close();
+    TEST_ASSERT_FALSE(other.open(ring_name));
+}
+
+static void reader_should_see_frames_written_through_another_mapping(void)
+{
+    frame_ring writer, reader_ring;
+    TEST_ASSERT_TRUE(writer.create(ring_name, 4, 4096));
+    TEST_ASSERT_TRUE(reader_ring.open(ring_name));
+    TEST_ASSERT_EQUAL_UINT32(4, reader_ring.slots());
+
+    ring_reader reader(reader_ring);
+    ring_view view;
+    TEST_ASSERT_FALSE(reader.next(view, NO_WAIT));
+
+    std::vector<uint8_t> jpeg(300, 0xAB);
+    frame_info info;
+    info.camera = 3;
+    info.format = FRAME_JPEG;
+    info.timestamp_us = 12345;
+    info.size = (uint32_t)jpeg.size();
+    TEST_ASSERT_TRUE(writer.try_write(info, jpeg.data()));
+    TEST_ASSERT_TRUE(write_frame(writer, 1));
+
+    TEST_ASSERT_TRUE(reader.next(view, NO_WAIT));
+    TEST_ASSERT_EQUAL_UINT64(0, view.sequence);
+    TEST_ASSERT_EQUAL_UINT32(3, view.info.camera);
+    TEST_ASSERT_EQUAL_UINT32(FRAME_JPEG, view.info.format);
+    TEST_ASSERT_EQUAL_UINT64(12345, view.info.timestamp_us);
+    TEST_ASSERT_EQUAL_UINT32(300, view.info.size);
+    TEST_ASSERT_EQUAL_MEMORY(jpeg.data(), view.data, jpeg.size());
+    TEST_ASSERT_TRUE(reader.valid(view));
+
+    TEST_ASSERT_TRUE(reader.next(view, NO_WAIT));
+    TEST_ASSERT_TRUE(frame_is(view, 1));
+    TEST_ASSERT_FALSE(reader.next(view, NO_WAIT));
+    TEST_ASSERT_EQUAL_UINT64(0, reader.skipped());
+}
+
+static void lossy_reader_should_skip_what_was_overwritten(void)
+{
+    frame_ring ring;
+    TEST_ASSERT_TRUE(ring.create(ring_name, 4, 1000));
+    ring_reader reader(ring), newest(ring);
+
+    ring_view held;
+    TEST_ASSERT_TRUE(write_frame(ring, 0));
+    TEST_ASSERT_TRUE(reader.next(held, NO_WAIT));
+
+    // a lossy reader never holds the writer back
+    for (uint64_t n = 1; n < 10; n++)
+        TEST_ASSERT_TRUE(write_frame(ring, n));
+    TEST_ASSERT_FALSE(reader.valid(held));
+
+    // frames 1..5 are gone, 6..9 are still in the ring
+    ring_view view;
+    for (uint64_t n = 6; n < 10; n++) {
+        TEST_ASSERT_TRUE(reader.next(view, NO_WAIT));
+        TEST_ASSERT_EQUAL_UINT64(n, view.sequence);
+        TEST_ASSERT_TRUE(frame_is(view, n));
+    }
+    TEST_ASSERT_EQUAL_UINT64(5, reader.skipped());
+
+    TEST_ASSERT_TRUE(newest.latest(view, NO_WAIT));
+    TEST_ASSERT_EQUAL_UINT64(9, view.sequence);
+    TEST_ASSERT_FALSE(newest.latest(view, NO_WAIT));
+}
+
+static void reliable_reader_should_hold_writers_back(void)
+{
+    frame_ring ring;
+    TEST_ASSERT_TRUE(ring.create(ring_name, 4, 1000));
+    ring_reader recorder(ring, true);
+    TEST_ASSERT_TRUE(recorder.attached());
+
+    for (uint64_t n = 0; n < 4; n++)
+        TEST_ASSERT_TRUE(write_frame(ring, n));
+    TEST_ASSERT_FALSE(write_frame(ring, 4));
+
+    // frame 0 is in use until the next call
+    ring_view view;
+    TEST_ASSERT_TRUE(recorder.next(view, NO_WAIT));
+    TEST_ASSERT_FALSE(write_frame(ring, 4));
+    TEST_ASSERT_TRUE(recorder.next(view, NO_WAIT));
+    TEST_ASSERT_TRUE(write_frame(ring, 4));
+    TEST_ASSERT_FALSE(write_frame(ring, 5));
+
+    for (uint64_t n = 1; n < 5; n++) {
+        TEST_ASSERT_EQUAL_UINT64(n, view.sequence);
+        TEST_ASSERT_TRUE(frame_is(view, n));
+        TEST_ASSERT_TRUE(recorder.valid(view));
+        if (n < 4) {
+            TEST_ASSERT_TRUE(recorder.next(view, NO_WAIT));
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT64(0, recorder.skipped());
+
+    // detaching frees the writer
+    {
+        ring_reader other(ring, true);
+        TEST_ASSERT_TRUE(other.attached());
+    }
+    TEST_ASSERT_FALSE(recorder.next(view, NO_WAIT));
+    for (uint64_t n = 5; n < 9; n++)
+        TEST_ASSERT_TRUE(write_frame(ring, n));
+}
+
+static void readers_of_a_dead_process_should_be_dropped(void)
+{
+    frame_ring ring;
+    TEST_ASSERT_TRUE(ring.create(ring_name, 2, 64));
+
+    pid_t child = fork();
+    if (child == 0) {
+        frame_ring mine;
+        if (!mine.open(ring_name))
+            _exit(1);
+        // leaks its entry on purpose: no destructors after _exit
+        ring_reader *reader = new ring_reader(mine, true);
+        _exit(reader->attached() ? 0 : 2);
+    }
+    int status = 0;
+    TEST_ASSERT_EQUAL_INT(child, waitpid(child, &status, 0));
+    TEST_ASSERT_EQUAL_INT(0, WEXITSTATUS(status));
+
+    for (uint64_t n = 0; n < 6; n++)
+        TEST_ASSERT_TRUE(write_frame(ring, n, 64));
+}
+
+static void every_frame_should_cross_processes_once(void)
+{
+    const uint64_t FRAMES = 20000;
+    const uint32_t SIZE = 4096;
+    frame_ring ring;
+    TEST_ASSERT_TRUE(ring.create(ring_name, 8, SIZE));
+    ring_reader recorder(ring, true), viewer(ring);
+
+    // two writer processes of 10000 frames each, numbered by the ring
+    std::vector<pid_t> writers;
+    for (int w = 0; w < 2; w++) {
+        pid_t child = fork();
+        if (child == 0) {
+            frame_ring mine;
+            if (!mine.open(ring_name))
+                _exit(1);
+            for (uint64_t i = 0; i < FRAMES / 2; i++) {
+                ring_slot slot;
+                while (!mine.try_claim(slot))
+                    sched_yield();
+                slot.info->width = (uint32_t)slot.sequence;
+                slot.info->camera = (uint32_t)(slot.sequence % 7);
+                slot.info->size = SIZE;
+                memset(slot.data, (int)(slot.sequence & 0xFF), SIZE);
+                mine.publish(slot);
+            }
+            _exit(0);
+        }
+        writers.push_back(child);
+    }
+
+    // a lossy reader on another thread only ever returns whole frames
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> seen{0}, torn{0};
+    std::thread lossy([&] {
+        ring_view view;
+        while (!done.load()) {
+            if (!viewer.next(view, std::chrono::milliseconds(10)))
+                continue;
+            bool whole = frame_is(view, view.sequence);
+            if (viewer.valid(view)) {
+                seen++;
+                torn += !whole;
+            }
+        }
+    });
+
+    ring_view view;
+    uint64_t bad = 0;
+    for (uint64_t n = 0; n < FRAMES; n++) {
+        if (!recorder.next(view, WAIT))
+            break;
+        bad += view.sequence != n || !frame_is(view, n);
+    }
+    done = true;
+    lossy.join();
+    for (pid_t child : writers) {
+        int status = 0;
+        waitpid(child, &status, 0);
+        TEST_ASSERT_EQUAL_INT(0, WEXITSTATUS(status));
+    }
+
+    TEST_ASSERT_EQUAL_UINT64(FRAMES, ring.written());
+    TEST_ASSERT_EQUAL_UINT64(FRAMES - 1, view.sequence);
+    TEST_ASSERT_EQUAL_UINT64(0, bad);
+    TEST_ASSERT_EQUAL_UINT64(0, recorder.skipped());
+    TEST_ASSERT_TRUE(seen.load() > 0);
+    TEST_ASSERT_EQUAL_UINT64(0, torn.load());
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(ring_should_round_slots_and_refuse_bad_rings);
+    RUN_TEST(reader_should_see_frames_written_through_another_mapping);
+    RUN_TEST(lossy_reader_should_skip_what_was_overwritten);
+    RUN_TEST(reliable_reader_should_hold_writers_back);
+    RUN_TEST(readers_of_a_dead_process_should_be_dropped);
+    RUN_TEST(every_frame_should_cross_processes_once);
+    return UNITY_END();
+}
@@ -0,0 +1,313 @@
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <string>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <thread>
+#include <vector>
+
+#include "camera_client.h"
+#include "ingest_server.h"
+#include "unity.h"
+
+using namespace edge;
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static std::vector<uint8_t> s_jpeg;
+
+struct totals {
+    uint64_t received = 0, decoded = 0, delivered = 0, dropped = 0, errors = 0;
+    bool connected = true;
+    int reports = 0;
+};
+
+// report() only returns the change since the last call, so tests add it up
+static void accumulate(ingest_server &server, std::map<uint32_t, totals> &sum)
+{
+    for (const camera_report &r : server.report()) {
+        totals &t = sum[r.camera];
+        t.received += r.received;
+        t.decoded += r.decoded;
+        t.delivered += r.delivered;
+        t.dropped += r.dropped;
+        t.errors += r.errors;
+        t.connected = r.connected;
+        t.reports++;
+    }
+}
+
+static void wait_processed(ingest_server &server, std::map<uint32_t, totals> &sum, uint64_t frames)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    for (;;) {
+        accumulate(server, sum);
+        uint64_t done = 0;
+        for (auto &it : sum)
+            done += it.second.decoded + it.second.errors + it.second.dropped;
+        if (done >= frames || std::chrono::steady_clock::now() > deadline)
+            return;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+}
+
+static ingest_config test_config(void)
+{
+    ingest_config config;
+    config.host = "127.0.0.1";
+    config.port = 0;
+    return config;
+}
+
+static void handshake_should_send_the_camera_settings(void)
+{
+    ingest_config config = test_config();
+    ingest_server server(config);
+    TEST_ASSERT_TRUE(server.start());
+    TEST_ASSERT_NOT_EQUAL(0, server.port());
+
+    camera_client client;
+    TEST_ASSERT_TRUE(client.connect("127.0.0.1", server.port(), "/cam0"));
+    uint8_t opcode = 0;
+    std::vector<uint8_t> payload;
+    TEST_ASSERT_TRUE(client.receive(opcode, payload, 2000));
+    TEST_ASSERT_EQUAL_UINT8(ws::OP_TEXT, opcode);
+    TEST_ASSERT_EQUAL_STRING(config.greeting.c_str(), std::string(payload.begin(), payload.end()).c_str());
+}
+
+static void frames_should_be_decoded_in_order(void)
+{
+    ingest_config config = test_config();
+    config.decode_threads = 1;
+    ingest_server server(config);
+    TEST_ASSERT_TRUE(server.start());
+
+    frame_decoder decoder;
+    bgr_image expected;
+    TEST_ASSERT_TRUE(decoder.decode(s_jpeg.data(), s_jpeg.size(), expected, 0));
+
+    camera_client client;
+    TEST_ASSERT_TRUE(client.connect("127.0.0.1", server.port(), "/cam0"));
+    for (int i = 0; i < 5; i++)
+        TEST_ASSERT_TRUE(client.send_binary(s_jpeg.data(), s_jpeg.size()));
+
+    uint32_t camera = 0;
+    for (uint64_t i = 0; i < 5; i++) {
+        frame_ptr f;
+        TEST_ASSERT_TRUE(server.next_frame(f, std::chrono::seconds(5)));
+        if (!i)
+            camera = f->camera;
+        TEST_ASSERT_EQUAL_UINT32(camera, f->camera);
+        TEST_ASSERT_EQUAL_UINT64(i, f->sequence);
+        TEST_ASSERT_TRUE(f->decoded >= f->received);
+        TEST_ASSERT_EQUAL_INT(expected.width, f->image.width);
+        TEST_ASSERT_EQUAL_INT(expected.height, f->image.height);
+        TEST_ASSERT_TRUE(f->image.data == expected.data);
+    }
+
+    std::vector<camera_report> reports = server.report();
+    TEST_ASSERT_EQUAL_UINT64(1, reports.size());
+    TEST_ASSERT_EQUAL_STRING("/cam0", reports[0].path.c_str());
+    TEST_ASSERT_EQUAL_UINT64(5, reports[0].received);
+    TEST_ASSERT_EQUAL_UINT64(5, reports[0].decoded);
+    TEST_ASSERT_EQUAL_UINT64(5, reports[0].delivered);
+    TEST_ASSERT_EQUAL_UINT64(0, reports[0].dropped);
+    TEST_ASSERT_TRUE(reports[0].fps_in > 0);
+    TEST_ASSERT_TRUE(reports[0].decode_p99_us >= reports[0].decode_p50_us);
+    TEST_ASSERT_TRUE(reports[0].decode_p50_us > 0);
+
+    std::string table = ingest_server::format_report(reports);
+    TEST_ASSERT_TRUE(table.find("127.0.0.1:") != std::string::npos);
+}
+
+static void control_messages_should_be_answered(void)
+{
+    ingest_config config = test_config();
+    std::mutex mutex;
+    std::string text;
+    config.on_text = [&](uint32_t, const std::string &message) {
+        std::lock_guard<std::mutex> lock(mutex);
+        text = message;
+    };
+    ingest_server server(config);
+    TEST_ASSERT_TRUE(server.start());
+
+    camera_client client;
+    uint8_t opcode;
+    std::vector<uint8_t> payload;
+    TEST_ASSERT_TRUE(client.connect("127.0.0.1", server.port()));
+    TEST_ASSERT_TRUE(client.receive(opcode, payload, 2000)); // greeting
+
+    TEST_ASSERT_TRUE(client.send(ws::OP_FIN | ws::OP_PING, "beat", 4));
+    TEST_ASSERT_TRUE(client.receive(opcode, payload, 2000));
+    TEST_ASSERT_EQUAL_UINT8(ws::OP_PONG, opcode);
+    TEST_ASSERT_EQUAL_STRING("beat", std::string(payload.begin(), payload.end()).c_str());
+
+    // the reply arrives on the I/O thread before the pong that follows it
+    TEST_ASSERT_TRUE(client.send_text("{\"status\":\"ok\"}"));
+    TEST_ASSERT_TRUE(client.send(ws::OP_FIN | ws::OP_PING, "", 0));
+    TEST_ASSERT_TRUE(client.receive(opcode, payload, 2000));
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        TEST_ASSERT_EQUAL_STRING("{\"status\":\"ok\"}", text.c_str());
+    }
+
+    const uint8_t bye[2] = {0x03, 0xe8};
+    TEST_ASSERT_TRUE(client.send(ws::OP_FIN | ws::OP_CLOSE, bye, 2));
+    TEST_ASSERT_TRUE(client.receive(opcode, payload, 2000));
+    TEST_ASSERT_EQUAL_UINT8(ws::OP_CLOSE, opcode);
+    TEST_ASSERT_EQUAL_UINT64(2, payload.size());
+    TEST_ASSERT_FALSE(client.receive(opcode, payload, 2000)); // server hung up
+}
+
+static void protocol_errors_should_close_the_connection(void)
+{
+    ingest_server server(test_config());
+    TEST_ASSERT_TRUE(server.start());
+
+    camera_client client;
+    uint8_t opcode;
+    std::vector<uint8_t> payload;
+    TEST_ASSERT_TRUE(client.connect("127.0.0.1", server.port()));
+    TEST_ASSERT_TRUE(client.receive(opcode, payload, 2000));
+
+    // unmasked client frame
+    std::vector<uint8_t> wire;
+    ws::append_frame(wire, ws::OP_FIN | ws::OP_BINARY, "x", 1);
+    TEST_ASSERT_EQUAL_INT((int)wire.size(), (int)send(client.fd(), wire.data(), wire.size(), MSG_NOSIGNAL));
+    TEST_ASSERT_TRUE(client.receive(opcode, payload, 2000));
+    TEST_ASSERT_EQUAL_UINT8(ws::OP_CLOSE, opcode);
+    TEST_ASSERT_EQUAL_INT(ws::CLOSE_PROTOCOL, payload[0] << 8 | payload[1]);
+
+    // plain HTTP gets a 400 and the connection closed
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(server.port());
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    TEST_ASSERT_EQUAL_INT(0, connect(fd, (sockaddr *)&addr, sizeof(addr)));
+    const char request[] = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    TEST_ASSERT_EQUAL_INT((int)sizeof(request) - 1, (int)send(fd, request, sizeof(request) - 1, MSG_NOSIGNAL));
+    std::string response;
+    char buf[256];
+    ssize_t n;
+    while ((n = recv(fd, buf, sizeof(buf), 0)) > 0)
+        response.append(buf, (size_t)n);
+    close(fd);
+    TEST_ASSERT_EQUAL_INT(0, (int)response.find("HTTP/1.1 400"));
+}
+
+static void bad_jpeg_should_count_as_error(void)
+{
+    ingest_server server(test_config());
+    TEST_ASSERT_TRUE(server.start());
+
+    camera_client client;
+    TEST_ASSERT_TRUE(client.connect("127.0.0.1", server.port()));
+    std::vector<uint8_t> truncated(s_jpeg.begin(), s_jpeg.begin() + 200);
+    TEST_ASSERT_TRUE(client.send_binary(truncated.data(), truncated.size()));
+    TEST_ASSERT_TRUE(client.send_binary("not a jpeg", 10));
+
+    std::map<uint32_t, totals> sum;
+    wait_processed(server, sum, 2);
+    TEST_ASSERT_EQUAL_UINT64(1, sum.size());
+    TEST_ASSERT_EQUAL_UINT64(2, sum.begin()->second.errors);
+    frame_ptr f;
+    TEST_ASSERT_FALSE(server.next_frame(f, std::chrono::milliseconds(10)));
+}
+
+static void slow_consumer_should_get_the_newest_frames(void)
+{
+    ingest_config config = test_config();
+    config.decode_threads = 1;
+    config.ready_queue = 2;
+    ingest_server server(config);
+    TEST_ASSERT_TRUE(server.start());
+
+    camera_client client;
+    TEST_ASSERT_TRUE(client.connect("127.0.0.1", server.port()));
+    for (int i = 0; i < 8; i++)
+        TEST_ASSERT_TRUE(client.send_binary(s_jpeg.data(), s_jpeg.size()));
+
+    // wait for all 8 to be decoded; 6 of them get pushed out of the ready queue
+    std::map<uint32_t, totals> sum;
+    wait_processed(server, sum, 8 + 6);
+    TEST_ASSERT_EQUAL_UINT64(8, sum.begin()->second.decoded);
+    TEST_ASSERT_EQUAL_UINT64(6, sum.begin()->second.dropped);
+
+    frame_ptr f;
+    TEST_ASSERT_TRUE(server.next_frame(f, std::chrono::seconds(1)));
+    TEST_ASSERT_EQUAL_UINT64(6, f->sequence);
+    TEST_ASSERT_TRUE(server.next_frame(f, std::chrono::seconds(1)));
+    TEST_ASSERT_EQUAL_UINT64(7, f->sequence);
+    TEST_ASSERT_FALSE(server.next_frame(f, std::chrono::milliseconds(10)));
+}
+
+static void cameras_should_be_reported_separately(void)
+{
+    const int CAMERAS = 4, FRAMES = 10;
+    ingest_config config = test_config();
+    config.decode_queue = 64;
+    config.ready_queue = 64;
+    ingest_server server(config);
+    TEST_ASSERT_TRUE(server.start());
+
+    std::vector<std::unique_ptr<camera_client>> clients;
+    for (int c = 0; c < CAMERAS; c++) {
+        clients.emplace_back(new camera_client);
+        TEST_ASSERT_TRUE(clients.back()->connect("127.0.0.1", server.port(), "/cam" + std::to_string(c)));
+    }
+    std::vector<std::thread> senders;
+    for (auto &client : clients) {
+        camera_client *cc = client.get();
+        senders.emplace_back([cc] {
+            for (int i = 0; i < FRAMES; i++)
+                cc->send_binary(s_jpeg.data(), s_jpeg.size());
+        });
+    }
+    for (auto &t : senders)
+        t.join();
+
+    std::map<uint32_t, int> per_camera;
+    for (int i = 0; i < CAMERAS * FRAMES; i++) {
+        frame_ptr f;
+        TEST_ASSERT_TRUE(server.next_frame(f, std::chrono::seconds(5)));
+        per_camera[f->camera]++;
+    }
+    TEST_ASSERT_EQUAL_UINT64(CAMERAS, per_camera.size());
+    for (auto &it : per_camera)
+        TEST_ASSERT_EQUAL_INT(FRAMES, it.second);
+
+    // a camera that hung up is reported one last time, then dropped
+    clients[0].reset();
+    std::map<uint32_t, totals> sum;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    size_t reported;
+    do {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        reported = server.report().size();
+    } while (reported == CAMERAS && std::chrono::steady_clock::now() < deadline);
+    TEST_ASSERT_EQUAL_UINT64(CAMERAS - 1, reported);
+}
+
+int main(void)
+{
+    std::ifstream file(TEST_PICTURES "/test_inside.jpeg", std::ios::binary);
+    s_jpeg.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    if (s_jpeg.empty())
+        return 1;
+
+    UNITY_BEGIN();
+    RUN_TEST(handshake_should_send_the_camera_settings);
+    RUN_TEST(frames_should_be_decoded_in_order);
+    RUN_TEST(control_messages_should_be_answered);
+    RUN_TEST(protocol_errors_should_close_the_connection);
+    RUN_TEST(bad_jpeg_should_count_as_error);
+    RUN_TEST(slow_consumer_should_get_the_newest_frames);
+    RUN_TEST(cameras_should_be_reported_separately);
+    return UNITY_END();
+}
@@ -0,0 +1,237 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "frame_decoder.h"
+#include "frame_encoder.h"
+#include "jpeg_patch.h"
+#include "overlay.h"
+#include "unity.h"
+
+using namespace edge;
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static std::vector<uint8_t> read_picture(const char *name)
+{
+    std::ifstream file(std::string(TEST_PICTURES) + "/" + name, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static bgr_image decode(const std::vector<uint8_t> &jpeg)
+{
+    frame_decoder decoder;
+    bgr_image image;
+    TEST_ASSERT_TRUE(decoder.decode(jpeg.data(), jpeg.size(), image));
+    return image;
+}
+
+static detection box(float x1, float y1, float x2, float y2)
+{
+    return {x1, y1, x2, y2, 0.8f, 0};
+}
+
+// Pixels that differ between a and b outside the MCUs the overlay touched
+static size_t changed_outside(const bgr_image &a, const bgr_image &b, const std::vector<rect> &dirty, int mcu)
+{
+    int columns = (a.width + mcu - 1) / mcu;
+    std::vector<bool> touched((size_t)columns * ((a.height + mcu - 1) / mcu));
+    for (const rect &r : dirty)
+        for (int y = r.y0 / mcu; y <= (r.y1 - 1) / mcu; y++)
+            for (int x = r.x0 / mcu; x <= (r.x1 - 1) / mcu; x++)
+                touched[(size_t)y * columns + x] = true;
+    size_t n = 0;
+    for (int y = 0; y < a.height; y++)
+        for (int x = 0; x < a.width; x++) {
+            size_t i = ((size_t)y * a.width + x) * 3;
+            if (!touched[(size_t)(y / mcu) * columns + x / mcu])
+                n += memcmp(&a.data[i], &b.data[i], 3) != 0;
+        }
+    return n;
+}
+
+static double mean_difference(const bgr_image &a, const bgr_image &b)
+{
+    double sum = 0;
+    for (size_t i = 0; i < a.data.size(); i++)
+        sum += abs(a.data[i] - b.data[i]);
+    return sum / a.data.size();
+}
+
+static void patch_should_leave_untouched_mcus_bit_exact(void)
+{
+    std::vector<uint8_t> jpeg = read_picture("test_outside.jpeg");
+    TEST_ASSERT_TRUE(jpeg.size() > 0);
+    std::vector<detection> dets = {box(40, 60, 140, 250), box(300, 100, 380, 300)};
+
+    jpeg_patcher patcher;
+    std::vector<uint8_t> out;
+    TEST_ASSERT_TRUE(patcher.annotate(jpeg.data(), jpeg.size(), dets, 2, out));
+    TEST_ASSERT_EQUAL_UINT8(0xFF, out[0]);
+    TEST_ASSERT_EQUAL_UINT8(0xD9, out.back());
+
+    bgr_image original = decode(jpeg), patched = decode(out);
+    TEST_ASSERT_EQUAL_INT(original.width, patched.width);
+    TEST_ASSERT_EQUAL_UINT64(0, changed_outside(original, patched, patcher.renderer().dirty(), 16));
+
+    // boxes, tags and the count are only in the touched MCUs
+    TEST_ASSERT_TRUE(patcher.patched_mcus() > 0);
+    TEST_ASSERT_TRUE(patcher.patched_mcus() < patcher.mcus() / 2);
+
+    // and are closer to drawing on the decoded frame than re-encoding all of it
+    overlay_renderer renderer;
+    renderer.draw(original, dets, 2);
+    frame_encoder encoder(85);
+    std::vector<uint8_t> full;
+    TEST_ASSERT_TRUE(encoder.encode(original.data.data(), original.width, original.height, full));
+    TEST_ASSERT_TRUE(mean_difference(original, patched) < mean_difference(original, decode(full)));
+}
+
+static void no_overlay_should_decode_like_the_input(void)
+{
+    std::vector<uint8_t> jpeg = read_picture("test_inside.jpeg");
+    jpeg_patcher patcher;
+    std::vector<uint8_t> out;
+    TEST_ASSERT_TRUE(patcher.annotate(jpeg.data(), jpeg.size(), {}, -1, out));
+    TEST_ASSERT_EQUAL_UINT64(0, patcher.patched_mcus());
+    TEST_ASSERT_FALSE(patcher.standard_tables());
+
+    bgr_image a = decode(jpeg), b = decode(out);
+    TEST_ASSERT_EQUAL_UINT64(a.data.size(), b.data.size());
+    TEST_ASSERT_TRUE(a.data == b.data);
+    // the same coefficients with the same tables: about the same size
+    TEST_ASSERT_TRUE(out.size() < jpeg.size() + 64);
+}
+
+static void restart_intervals_should_round_trip(void)
+{
+    std::vector<uint8_t> jpeg = read_picture("testimg.jpeg");
+    std::vector<detection> dets = {box(20, 20, 120, 100)};
+    jpeg_patcher patcher;
+    std::vector<uint8_t> plain, restarts, again;
+    TEST_ASSERT_TRUE(patcher.annotate(jpeg.data(), jpeg.size(), dets, 1, plain));
+
+    patcher.set_restart_interval(5);
+    TEST_ASSERT_TRUE(patcher.annotate(jpeg.data(), jpeg.size(), dets, 1, restarts));
+    TEST_ASSERT_TRUE(restarts.size() > plain.size());
+    TEST_ASSERT_TRUE(decode(plain).data == decode(restarts).data);
+
+    // reading a stream with restarts; -1 keeps its interval
+    patcher.set_restart_interval(-1);
+    TEST_ASSERT_TRUE(patcher.annotate(restarts.data(), restarts.size(), {}, -1, again));
+    TEST_ASSERT_EQUAL_UINT64(restarts.size(), again.size());
+    TEST_ASSERT_TRUE(restarts == again);
+}
+
+static void other_samplings_should_patch(void)
+{
+    const int width = 100, height = 70;
+    std::vector<uint8_t> bgr((size_t)width * height * 3);
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++) {
+            uint8_t *p = &bgr[((size_t)y * width + x) * 3];
+            p[0] = (uint8_t)(x * 2);
+            p[1] = (uint8_t)(y * 3);
+            p[2] = (uint8_t)(x + y);
+        }
+    std::vector<detection> dets = {box(30, 20, 70, 60)};
+
+    for (jpge::subsampling_t sampling : {jpge::Y_ONLY, jpge::H1V1, jpge::H2V1}) {
+        frame_encoder encoder(85, sampling);
+        std::vector<uint8_t> jpeg, out;
+        TEST_ASSERT_TRUE(encoder.encode(bgr.data(), width, height, jpeg));
+
+        jpeg_patcher patcher;
+        TEST_ASSERT_TRUE(patcher.annotate(jpeg.data(), jpeg.size(), dets, 1, out));
+        bgr_image original = decode(jpeg), patched = decode(out);
+        int mcu = sampling == jpge::H2V1 ? 16 : 8;
+        // H2V1 MCUs are 16 x 8; compare by 16 x 16 squares, which cover them
+        TEST_ASSERT_EQUAL_UINT64(0, changed_outside(original, patched, patcher.renderer().dirty(), 16));
+        TEST_ASSERT_EQUAL_UINT64((size_t)((width + mcu - 1) / mcu) * ((height + 7) / 8), patcher.mcus());
+
+        overlay_renderer renderer;
+        renderer.draw(original, dets, 1);
+        std::vector<uint8_t> full;
+        TEST_ASSERT_TRUE(encoder.encode(original.data.data(), width, height, full));
+        TEST_ASSERT_TRUE(mean_difference(original, patched) < mean_difference(original, decode(full)));
+    }
+}
+
+// A 64x64 mid-grey JPEG whose Huffman tables have only the two codes it uses:
+// DC difference 0 and end of block, one bit each
+static std::vector<uint8_t> minimal_grey_jpeg()
+{
+    std::vector<uint8_t> jpeg = {0xFF, 0xD8, 0xFF, 0xDB, 0x00, 0x43, 0x00};
+    jpeg.insert(jpeg.end(), 64, 2);
+    const uint8_t frame[] = {0xFF, 0xC0, 0x00, 0x0B, 0x08, 0x00, 0x40, 0x00, 0x40, 0x01, 0x01, 0x11, 0x00};
+    jpeg.insert(jpeg.end(), frame, frame + sizeof(frame));
+    const uint8_t tables[] = {0xFF, 0xC4, 0x00, 0x26};
+    jpeg.insert(jpeg.end(), tables, tables + sizeof(tables));
+    for (uint8_t id : {0x00, 0x10}) {
+        jpeg.push_back(id);
+        jpeg.push_back(1);
+        jpeg.insert(jpeg.end(), 15, 0);
+        jpeg.push_back(0);
+    }
+    const uint8_t scan[] = {0xFF, 0xDA, 0x00, 0x08, 0x01, 0x01, 0x00, 0x00, 0x3F, 0x00};
+    jpeg.insert(jpeg.end(), scan, scan + sizeof(scan));
+    jpeg.insert(jpeg.end(), 64 * 2 / 8, 0x00); // 64 blocks of "0" "0"
+    jpeg.push_back(0xFF);
+    jpeg.push_back(0xD9);
+    return jpeg;
+}
+
+static void missing_codes_should_switch_to_standard_tables(void)
+{
+    std::vector<uint8_t> jpeg = minimal_grey_jpeg(), out;
+    TEST_ASSERT_EQUAL_UINT8(128, decode(jpeg).data[0]);
+
+    jpeg_patcher patcher;
+    TEST_ASSERT_TRUE(patcher.annotate(jpeg.data(), jpeg.size(), {}, -1, out));
+    TEST_ASSERT_FALSE(patcher.standard_tables());
+
+    std::vector<detection> dets = {box(4, 30, 28, 60)};
+    TEST_ASSERT_TRUE(patcher.annotate(jpeg.data(), jpeg.size(), dets, -1, out));
+    TEST_ASSERT_TRUE(patcher.standard_tables());
+    bgr_image patched = decode(out);
+    TEST_ASSERT_TRUE(patcher.patched_mcus() < patcher.mcus());
+    TEST_ASSERT_EQUAL_UINT64(0, changed_outside(decode(jpeg), patched, patcher.renderer().dirty(), 8));
+    // the box's red edge, in grey
+    TEST_ASSERT_INT_WITHIN(10, 115, patched.data[((size_t)45 * 64 + 4) * 3]);
+}
+
+static void bad_streams_should_be_refused(void)
+{
+    std::vector<uint8_t> jpeg = read_picture("test_inside.jpeg");
+    jpeg_patcher patcher;
+    std::vector<uint8_t> out;
+
+    std::vector<uint8_t> cut(jpeg.begin(), jpeg.begin() + jpeg.size() / 2);
+    TEST_ASSERT_FALSE(patcher.annotate(cut.data(), cut.size(), {}, -1, out));
+
+    std::vector<uint8_t> header(jpeg.begin(), jpeg.begin() + 100);
+    TEST_ASSERT_FALSE(patcher.annotate(header.data(), header.size(), {}, -1, out));
+
+    const uint8_t junk[] = {0xFF, 0xD8, 0xFF, 0xC2, 0x00, 0x02, 0xFF, 0xD9};
+    TEST_ASSERT_FALSE(patcher.annotate(junk, sizeof(junk), {}, -1, out));
+    TEST_ASSERT_FALSE(patcher.annotate(nullptr, 0, {}, -1, out));
+
+    // still fine afterwards
+    TEST_ASSERT_TRUE(patcher.annotate(jpeg.data(), jpeg.size(), {}, 1, out));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(patch_should_leave_untouched_mcus_bit_exact);
+    RUN_TEST(no_overlay_should_decode_like_the_input);
+    RUN_TEST(restart_intervals_should_round_trip);
+    RUN_TEST(other_samplings_should_patch);
+    RUN_TEST(missing_codes_should_switch_to_standard_tables);
+    RUN_TEST(bad_streams_should_be_refused);
+    return UNITY_END();
+}
@@ -0,0 +1,147 @@
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "mpmc_queue.h"
+#include "stats.h"
+#include "unity.h"
+
+using namespace edge;
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void queue_should_round_capacity_to_a_power_of_two(void)
+{
+    TEST_ASSERT_EQUAL_UINT64(2, mpmc_queue<int>(1).capacity());
+    TEST_ASSERT_EQUAL_UINT64(16, mpmc_queue<int>(16).capacity());
+    TEST_ASSERT_EQUAL_UINT64(64, mpmc_queue<int>(33).capacity());
+}
+
+static void queue_should_be_fifo_and_bounded(void)
+{
+    mpmc_queue<std::unique_ptr<int>> queue(4);
+    for (int i = 0; i < 4; i++) {
+        std::unique_ptr<int> item(new int(i));
+        TEST_ASSERT_TRUE(queue.try_push(std::move(item)));
+    }
+
+    // a rejected item stays with the caller
+    std::unique_ptr<int> extra(new int(4));
+    TEST_ASSERT_FALSE(queue.try_push(std::move(extra)));
+    TEST_ASSERT_NOT_NULL(extra.get());
+    TEST_ASSERT_EQUAL_UINT64(4, queue.size_approx());
+
+    for (int i = 0; i < 4; i++) {
+        std::unique_ptr<int> item;
+        TEST_ASSERT_TRUE(queue.try_pop(item));
+        TEST_ASSERT_EQUAL_INT(i, *item);
+    }
+    std::unique_ptr<int> item;
+    TEST_ASSERT_FALSE(queue.try_pop(item));
+
+    // leftovers are destroyed with the queue (checked by ASan builds)
+    std::unique_ptr<int> left(new int(5));
+    TEST_ASSERT_TRUE(queue.try_push(std::move(left)));
+}
+
+static void queue_should_deliver_every_item_once_across_threads(void)
+{
+    const int PRODUCERS = 4, CONSUMERS = 4, PER_PRODUCER = 200000;
+    mpmc_queue<uint32_t> queue(256);
+    semaphore ready;
+    std::vector<std::atomic<uint8_t>> seen(PRODUCERS * PER_PRODUCER);
+    std::atomic<int> popped{0}, out_of_order{0};
+    std::vector<std::thread> threads;
+
+    for (int p = 0; p < PRODUCERS; p++) {
+        threads.emplace_back([&, p] {
+            for (int i = 0; i < PER_PRODUCER; i++) {
+                uint32_t value = (uint32_t)(p * PER_PRODUCER + i);
+                while (!queue.try_push(std::move(value)))
+                    std::this_thread::yield();
+                ready.post();
+            }
+        });
+    }
+    for (int c = 0; c < CONSUMERS; c++) {
+        threads.emplace_back([&] {
+            int last[PRODUCERS];
+            for (int &l : last)
+                l = -1;
+            while (popped.load() < PRODUCERS * PER_PRODUCER) {
+                uint32_t value;
+                if (!queue.try_pop(value)) {
+                    ready.wait_for(std::chrono::milliseconds(1));
+                    continue;
+                }
+                seen[value]++;
+                popped++;
+                // items of one producer come out in the order they went in
+                int producer = (int)value / PER_PRODUCER, index = (int)value % PER_PRODUCER;
+                if (index <= last[producer])
+                    out_of_order++;
+                last[producer] = index;
+            }
+        });
+    }
+    for (auto &t : threads)
+        t.join();
+
+    TEST_ASSERT_EQUAL_INT(PRODUCERS * PER_PRODUCER, popped.load());
+    TEST_ASSERT_EQUAL_INT(0, out_of_order.load());
+    for (auto &s : seen)
+        TEST_ASSERT_EQUAL_UINT8(1, s.load());
+}
+
+static void semaphore_should_time_out_and_wake(void)
+{
+    semaphore sem;
+    auto start = std::chrono::steady_clock::now();
+    TEST_ASSERT_FALSE(sem.wait_for(std::chrono::milliseconds(20)));
+    TEST_ASSERT_TRUE(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(20));
+
+    sem.post();
+    TEST_ASSERT_TRUE(sem.wait_for(std::chrono::milliseconds(0)));
+
+    std::thread poster([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        sem.post();
+    });
+    TEST_ASSERT_TRUE(sem.wait_for(std::chrono::seconds(5)));
+    poster.join();
+    TEST_ASSERT_FALSE(sem.wait_for(std::chrono::milliseconds(0)));
+}
+
+static void histogram_percentiles_should_be_within_a_bucket(void)
+{
+    latency_histogram h;
+    TEST_ASSERT_EQUAL_UINT64(0, h.percentile(50));
+    for (uint64_t us = 1; us <= 100000; us++)
+        h.record(us);
+    TEST_ASSERT_EQUAL_UINT64(100000, h.count());
+    TEST_ASSERT_DOUBLE_WITHIN(1.0, 50000.5, h.mean());
+
+    const double ps[] = {1, 50, 90, 99, 99.9};
+    for (double p : ps) {
+        double expected = p * 1000;
+        TEST_ASSERT_DOUBLE_WITHIN(expected * 0.125, expected, (double)h.percentile(p));
+    }
+
+    h.reset();
+    TEST_ASSERT_EQUAL_UINT64(0, h.count());
+    h.record(3);
+    TEST_ASSERT_EQUAL_UINT64(3, h.percentile(99));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(queue_should_round_capacity_to_a_power_of_two);
+    RUN_TEST(queue_should_be_fifo_and_bounded);
+    RUN_TEST(queue_should_deliver_every_item_once_across_threads);
+    RUN_TEST(semaphore_should_time_out_and_wake);
+    RUN_TEST(histogram_percentiles_should_be_within_a_bucket);
+    return UNITY_END();
+}
@@ -0,0 +1,363 @@
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "frame_decoder.h"
+#include "layers.h"
+#include "yolo.h"
+#include "unity.h"
+
+using namespace edge;
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static std::mt19937 s_rng(1234);
+
+static tensor random_tensor(int w, int h, int c)
+{
+    std::uniform_real_distribution<float> dist(-1.f, 1.f);
+    tensor t = tensor::make_3d(w, h, c);
+    for (size_t i = 0; i < t.total(); i++)
+        t.data[i] = dist(s_rng);
+    return t;
+}
+
+static std::vector<float> random_values(size_t n)
+{
+    std::uniform_real_distribution<float> dist(-0.5f, 0.5f);
+    std::vector<float> v(n);
+    for (float &x : v)
+        x = dist(s_rng);
+    return v;
+}
+
+// A layer built from a param line ("0=16 1=3 ...") and, when given, a
+// weight blob followed by a bias in model.ncnn.bin layout
+static std::unique_ptr<layer> make_layer(const char *type, const std::string &params,
+                                         const std::vector<float> &weights = {}, const std::vector<float> &bias = {})
+{
+    std::unique_ptr<layer> l = create_layer(type);
+    TEST_ASSERT_NOT_NULL(l.get());
+
+    std::vector<std::string> tokens;
+    std::istringstream in(params);
+    std::string token;
+    while (in >> token)
+        tokens.push_back(token);
+    param_dict pd;
+    TEST_ASSERT_TRUE(pd.parse(tokens, 0));
+    TEST_ASSERT_TRUE(l->load_param(pd));
+
+    FILE *f = tmpfile();
+    TEST_ASSERT_NOT_NULL(f);
+    if (!weights.empty()) {
+        uint32_t tag = 0;
+        fwrite(&tag, sizeof(tag), 1, f);
+        fwrite(weights.data(), sizeof(float), weights.size(), f);
+    }
+    fwrite(bias.data(), sizeof(float), bias.size(), f);
+    rewind(f);
+    model_reader mr(f);
+    bool loaded = l->load_model(mr);
+    fclose(f);
+    TEST_ASSERT_TRUE(loaded);
+    return l;
+}
+
+static tensor run(const layer &l, const std::vector<tensor> &bottoms, thread_pool &pool)
+{
+    std::vector<tensor> tops(1);
+    TEST_ASSERT_TRUE(l.forward(bottoms, tops, pool));
+    return tops[0];
+}
+
+static void assert_close(const tensor &expected, const tensor &actual, float tolerance)
+{
+    TEST_ASSERT_TRUE(expected.same_shape(actual));
+    for (size_t i = 0; i < expected.total(); i++)
+        if (fabsf(expected.data[i] - actual.data[i]) > tolerance * (1 + fabsf(expected.data[i]))) {
+            char msg[96];
+            snprintf(msg, sizeof(msg), "element %zu: expected %g, got %g", i, expected.data[i], actual.data[i]);
+            TEST_FAIL_MESSAGE(msg);
+        }
+}
+
+static float swish(float x) { return x / (1 + expf(-x)); }
+
+struct conv_case {
+    int c, w, h, outc, kernel, stride, pad, dilation;
+};
+
+// Direct evaluation of the ncnn Convolution formula
+static tensor reference_conv(const tensor &in, const conv_case &cc, const std::vector<float> &weights,
+                             const std::vector<float> &bias, int groups, bool silu)
+{
+    int extent = cc.dilation * (cc.kernel - 1) + 1;
+    int outw = (in.w + 2 * cc.pad - extent) / cc.stride + 1;
+    int outh = (in.h + 2 * cc.pad - extent) / cc.stride + 1;
+    tensor out = tensor::make_3d(outw, outh, cc.outc);
+    int in_per_group = in.c / groups, out_per_group = cc.outc / groups;
+    for (int o = 0; o < cc.outc; o++)
+        for (int y = 0; y < outh; y++)
+            for (int x = 0; x < outw; x++) {
+                double sum = bias.empty() ? 0 : bias[o];
+                int g = o / out_per_group;
+                for (int i = 0; i < in_per_group; i++)
+                    for (int ky = 0; ky < cc.kernel; ky++)
+                        for (int kx = 0; kx < cc.kernel; kx++) {
+                            int iy = y * cc.stride - cc.pad + ky * cc.dilation;
+                            int ix = x * cc.stride - cc.pad + kx * cc.dilation;
+                            if (iy < 0 || iy >= in.h || ix < 0 || ix >= in.w)
+                                continue;
+                            float w = weights[((o * in_per_group + i) * cc.kernel + ky) * cc.kernel + kx];
+                            sum += w * in.channel(g * in_per_group + i)[iy * in.w + ix];
+                        }
+                out.channel(o)[y * outw + x] = silu ? swish((float)sum) : (float)sum;
+            }
+    return out;
+}
+
+static std::string conv_params(const conv_case &cc, size_t weight_size, const char *extra)
+{
+    char line[160];
+    snprintf(line, sizeof(line), "0=%d 1=%d 2=%d 3=%d 4=%d 5=1 6=%zu %s", cc.outc, cc.kernel, cc.dilation,
+             cc.stride, cc.pad, weight_size, extra);
+    return line;
+}
+
+static void param_dict_should_read_scalars_and_arrays(void)
+{
+    std::vector<std::string> tokens = {"Reshape", "name", "0=-1", "1=2.5", "-23303=3,1,0,2"};
+    param_dict pd;
+    TEST_ASSERT_TRUE(pd.parse(tokens, 2));
+    TEST_ASSERT_EQUAL_INT(-1, pd.get(0, 7));
+    TEST_ASSERT_EQUAL_FLOAT(2.5f, pd.get(1, 0.f));
+    TEST_ASSERT_EQUAL_INT(7, pd.get(2, 7));
+    std::vector<float> array = pd.get_array(3);
+    TEST_ASSERT_EQUAL_UINT64(3, array.size());
+    TEST_ASSERT_EQUAL_FLOAT(2.f, array[2]);
+
+    std::vector<std::string> bad = {"0"};
+    TEST_ASSERT_FALSE(param_dict().parse(bad, 0));
+    TEST_ASSERT_NULL(create_layer("LSTM").get());
+}
+
+static void convolution_should_match_reference(void)
+{
+    // covers the 1x1 path, im2col with padding/stride/dilation, partial
+    // channel blocks and pixel counts that are not a multiple of 8
+    const conv_case cases[] = {
+        {16, 20, 20, 32, 1, 1, 0, 1}, {3, 33, 17, 13, 3, 2, 1, 1}, {8, 15, 9, 24, 3, 1, 1, 1},
+        {5, 12, 12, 7, 3, 1, 2, 2},   {4, 11, 7, 9, 5, 1, 2, 1},   {12, 9, 9, 8, 1, 2, 0, 1},
+    };
+    thread_pool pool(3);
+    for (const conv_case &cc : cases) {
+        tensor in = random_tensor(cc.w, cc.h, cc.c);
+        std::vector<float> weights = random_values((size_t)cc.outc * cc.c * cc.kernel * cc.kernel);
+        std::vector<float> bias = random_values(cc.outc);
+
+        auto plain = make_layer("Convolution", conv_params(cc, weights.size(), ""), weights, bias);
+        assert_close(reference_conv(in, cc, weights, bias, 1, false), run(*plain, {in}, pool), 1e-4f);
+
+        auto fused = make_layer("Convolution", conv_params(cc, weights.size(), ""), weights, bias);
+        TEST_ASSERT_TRUE(fused->fuse_activation(ACT_SWISH));
+        TEST_ASSERT_FALSE(fused->fuse_activation(ACT_SIGMOID));
+        assert_close(reference_conv(in, cc, weights, bias, 1, true), run(*fused, {in}, pool), 1e-4f);
+    }
+}
+
+static void depthwise_convolution_should_match_reference(void)
+{
+    const conv_case cases[] = {{16, 20, 20, 16, 3, 1, 1, 1}, {9, 13, 11, 9, 3, 2, 1, 1}, {8, 10, 10, 8, 5, 1, 2, 1}};
+    thread_pool pool(2);
+    for (const conv_case &cc : cases) {
+        tensor in = random_tensor(cc.w, cc.h, cc.c);
+        std::vector<float> weights = random_values((size_t)cc.outc * cc.kernel * cc.kernel);
+        std::vector<float> bias = random_values(cc.outc);
+        std::string group = "7=" + std::to_string(cc.c);
+        auto l = make_layer("ConvolutionDepthWise", conv_params(cc, weights.size(), group.c_str()), weights, bias);
+        TEST_ASSERT_TRUE(l->fuse_activation(ACT_SWISH));
+        assert_close(reference_conv(in, cc, weights, bias, cc.c, true), run(*l, {in}, pool), 1e-4f);
+    }
+}
+
+static void matmul_should_match_reference(void)
+{
+    thread_pool pool(2);
+    const int batch = 3, m = 10, k = 19, n = 21;
+    tensor a = random_tensor(k, m, batch);
+    tensor b = random_tensor(n, k, batch);
+    tensor bt = random_tensor(k, n, 1).reshaped(2, k, n);
+
+    tensor expected = tensor::make_3d(n, m, batch), expected_t = tensor::make_3d(n, m, batch);
+    for (int q = 0; q < batch; q++)
+        for (int i = 0; i < m; i++)
+            for (int j = 0; j < n; j++) {
+                double sum = 0, sum_t = 0;
+                for (int p = 0; p < k; p++) {
+                    sum += a.channel(q)[i * k + p] * b.channel(q)[p * n + j];
+                    sum_t += a.channel(q)[i * k + p] * bt.data[j * k + p];
+                }
+                expected.channel(q)[i * n + j] = (float)sum;
+                expected_t.channel(q)[i * n + j] = (float)sum_t;
+            }
+
+    assert_close(expected, run(*make_layer("MatMul", ""), {a, b}, pool), 1e-5f);
+    // a 2D B is shared by every batch of A
+    assert_close(expected_t, run(*make_layer("MatMul", "0=1"), {a, bt}, pool), 1e-5f);
+}
+
+static void softmax_should_normalise_along_the_axis(void)
+{
+    thread_pool pool(2);
+    tensor in = random_tensor(13, 4, 6);
+    for (size_t i = 0; i < in.total(); i++)
+        in.data[i] *= 20;
+
+    for (int axis = 0; axis < 3; axis++) {
+        tensor out = run(*make_layer("Softmax", "0=" + std::to_string(axis)), {in}, pool);
+        std::vector<int> shape = shape_of(in);
+        size_t inner = 1;
+        for (int i = axis + 1; i < 3; i++)
+            inner *= shape[i];
+        size_t n = shape[axis], outer = in.total() / (n * inner);
+        for (size_t o = 0; o < outer; o++)
+            for (size_t j = 0; j < inner; j++) {
+                double sum = 0, max_in = -1e30;
+                size_t arg = 0, arg_out = 0;
+                for (size_t i = 0; i < n; i++) {
+                    size_t at = (o * n + i) * inner + j;
+                    sum += out.data[at];
+                    if (in.data[at] > max_in) {
+                        max_in = in.data[at];
+                        arg = i;
+                    }
+                    if (out.data[at] > out.data[(o * n + arg_out) * inner + j])
+                        arg_out = i;
+                }
+                TEST_ASSERT_DOUBLE_WITHIN(1e-5, 1.0, sum);
+                TEST_ASSERT_EQUAL_UINT64(arg, arg_out);
+            }
+    }
+}
+
+static void slice_and_concat_should_round_trip(void)
+{
+    thread_pool pool(1);
+    tensor in = random_tensor(6, 5, 7);
+    for (int axis = 0; axis < 3; axis++) {
+        std::vector<int> shape = shape_of(in);
+        int first = shape[axis] / 3;
+        std::unique_ptr<layer> slice = make_layer(
+            "Slice", "-23300=2," + std::to_string(first) + ",-233 1=" + std::to_string(axis));
+        std::vector<tensor> parts(2);
+        TEST_ASSERT_TRUE(slice->forward({in}, parts, pool));
+        TEST_ASSERT_EQUAL_INT(first, shape_of(parts[0])[axis]);
+        TEST_ASSERT_EQUAL_INT(shape[axis] - first, shape_of(parts[1])[axis]);
+
+        tensor joined = run(*make_layer("Concat", "0=" + std::to_string(axis)), parts, pool);
+        assert_close(in, joined, 0);
+    }
+}
+
+static void permute_should_move_axes(void)
+{
+    thread_pool pool(1);
+    tensor in = random_tensor(4, 3, 2);
+    // order type 3 ("w c h"): output w is input c, h is input w, c is input h
+    tensor out = run(*make_layer("Permute", "0=3"), {in}, pool);
+    TEST_ASSERT_EQUAL_INT(2, out.w);
+    TEST_ASSERT_EQUAL_INT(4, out.h);
+    TEST_ASSERT_EQUAL_INT(3, out.c);
+    for (int q = 0; q < in.c; q++)
+        for (int y = 0; y < in.h; y++)
+            for (int x = 0; x < in.w; x++)
+                TEST_ASSERT_EQUAL_FLOAT(in.channel(q)[y * in.w + x], out.channel(y)[x * out.w + q]);
+}
+
+static bgr_image load_frame(const char *path)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::vector<uint8_t> jpeg((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    TEST_ASSERT_FALSE(jpeg.empty());
+    frame_decoder decoder;
+    bgr_image image;
+    TEST_ASSERT_TRUE(decoder.decode(jpeg.data(), jpeg.size(), image));
+    return image;
+}
+
+static void detector_should_find_the_people_in_a_frame(void)
+{
+    bgr_image image = load_frame(TMP_DIR "/result_09cfba71.jpg");
+
+    yolo_config config;
+    config.model_dir = MODEL_DIR;
+    yolo_detector detector(config);
+    TEST_ASSERT_TRUE(detector.load());
+
+    // the same frame annotated by the Python pipeline shows 8 people
+    std::vector<detection> detections;
+    TEST_ASSERT_TRUE(detector.detect(image, detections));
+    TEST_ASSERT_EQUAL_UINT64(8, detections.size());
+    for (size_t i = 0; i < detections.size(); i++) {
+        const detection &d = detections[i];
+        TEST_ASSERT_EQUAL_INT(0, d.cls);
+        TEST_ASSERT_TRUE(d.score > 0.8f);
+        TEST_ASSERT_TRUE(i == 0 || d.score <= detections[i - 1].score);
+        TEST_ASSERT_TRUE(d.x1 >= 0 && d.x1 < d.x2 && d.x2 <= image.width);
+        TEST_ASSERT_TRUE(d.y1 >= 0 && d.y1 < d.y2 && d.y2 <= image.height);
+    }
+
+    // a repeated run reuses the buffers and gives the same answer
+    std::vector<detection> again;
+    std::vector<layer_timing> timings;
+    TEST_ASSERT_TRUE(detector.detect(image, again, &timings));
+    TEST_ASSERT_EQUAL_UINT64(detections.size(), again.size());
+    TEST_ASSERT_EQUAL_FLOAT(detections[0].x1, again[0].x1);
+    TEST_ASSERT_TRUE(timings.size() > 100);
+}
+
+static void batch_should_match_single_frames(void)
+{
+    bgr_image a = load_frame(TMP_DIR "/result_09cfba71.jpg"), b = load_frame(TMP_DIR "/result_73464961.jpg");
+    yolo_config config;
+    config.model_dir = MODEL_DIR;
+    yolo_detector detector(config);
+    TEST_ASSERT_TRUE(detector.load());
+
+    std::vector<detection> single_a, single_b;
+    TEST_ASSERT_TRUE(detector.detect(a, single_a));
+    TEST_ASSERT_TRUE(detector.detect(b, single_b));
+    std::vector<std::vector<detection>> batch;
+    TEST_ASSERT_TRUE(detector.detect_batch({&a, &b, &a}, batch));
+    TEST_ASSERT_EQUAL_UINT64(3, batch.size());
+
+    // same kernels and summation order, so the results are bit-identical
+    const std::vector<detection> *expected[] = {&single_a, &single_b, &single_a};
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL_UINT64(expected[i]->size(), batch[i].size());
+        for (size_t j = 0; j < batch[i].size(); j++)
+            TEST_ASSERT_EQUAL_MEMORY(&(*expected[i])[j], &batch[i][j], sizeof(detection));
+    }
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(param_dict_should_read_scalars_and_arrays);
+    RUN_TEST(convolution_should_match_reference);
+    RUN_TEST(depthwise_convolution_should_match_reference);
+    RUN_TEST(matmul_should_match_reference);
+    RUN_TEST(softmax_should_normalise_along_the_axis);
+    RUN_TEST(slice_and_concat_should_round_trip);
+    RUN_TEST(permute_should_move_axes);
+    RUN_TEST(detector_should_find_the_people_in_a_frame);
+    RUN_TEST(batch_should_match_single_frames);
+    return UNITY_END();
+}
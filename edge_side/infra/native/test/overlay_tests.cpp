@@ -0,0 +1,205 @@
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "frame_decoder.h"
+#include "frame_encoder.h"
+#include "overlay.h"
+#include "unity.h"
+
+using namespace edge;
+
+extern "C" int edge_encode_jpeg(const uint8_t *bgr, int width, int height, int quality, uint8_t *out, int capacity);
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static bgr_image make_image(int width, int height, uint8_t value)
+{
+    bgr_image image;
+    image.width = (uint16_t)width;
+    image.height = (uint16_t)height;
+    image.data.assign((size_t)width * height * 3, value);
+    return image;
+}
+
+static const uint8_t *pixel(const bgr_image &image, int x, int y)
+{
+    return &image.data[((size_t)y * image.width + x) * 3];
+}
+
+static bool is(const bgr_image &image, int x, int y, color c)
+{
+    const uint8_t *p = pixel(image, x, y);
+    return p[0] == c.b && p[1] == c.g && p[2] == c.r;
+}
+
+static size_t count_changed(const bgr_image &image, uint8_t background)
+{
+    size_t n = 0;
+    for (size_t i = 0; i < image.data.size(); i += 3)
+        n += image.data[i] != background || image.data[i + 1] != background || image.data[i + 2] != background;
+    return n;
+}
+
+static void fill_should_clip_to_the_image(void)
+{
+    bgr_image image = make_image(40, 30, 0);
+    overlay_renderer renderer;
+    color red = {0, 0, 255};
+    renderer.fill(image, {-5, 25, 10, 40}, red);
+
+    TEST_ASSERT_EQUAL_UINT64(10 * 5, count_changed(image, 0));
+    TEST_ASSERT_TRUE(is(image, 0, 29, red));
+    TEST_ASSERT_TRUE(is(image, 9, 25, red));
+    TEST_ASSERT_FALSE(is(image, 10, 25, red));
+    TEST_ASSERT_EQUAL_UINT64(1, renderer.dirty().size());
+    TEST_ASSERT_EQUAL_INT(0, renderer.dirty()[0].x0);
+    TEST_ASSERT_EQUAL_INT(30, renderer.dirty()[0].y1);
+
+    // entirely outside: nothing drawn or recorded
+    renderer.fill(image, {50, 0, 60, 10}, red);
+    TEST_ASSERT_EQUAL_UINT64(1, renderer.dirty().size());
+}
+
+static void outline_should_leave_the_inside_alone(void)
+{
+    bgr_image image = make_image(100, 80, 0);
+    overlay_renderer renderer;
+    color c = {10, 20, 30};
+    renderer.outline(image, {20, 10, 60, 50}, 2, c);
+
+    // 2 px centred on each edge: x 19..20 and 59..60, y 9..10 and 49..50
+    TEST_ASSERT_TRUE(is(image, 19, 30, c));
+    TEST_ASSERT_TRUE(is(image, 20, 30, c));
+    TEST_ASSERT_FALSE(is(image, 21, 30, c));
+    TEST_ASSERT_TRUE(is(image, 60, 30, c));
+    TEST_ASSERT_FALSE(is(image, 61, 30, c));
+    TEST_ASSERT_TRUE(is(image, 40, 9, c));
+    TEST_ASSERT_TRUE(is(image, 40, 50, c));
+    TEST_ASSERT_FALSE(is(image, 40, 30, c));
+    TEST_ASSERT_EQUAL_UINT64(2 * 42 * 2 + 2 * 38 * 2, count_changed(image, 0));
+    TEST_ASSERT_EQUAL_UINT64(4, renderer.dirty().size());
+}
+
+static void text_should_render_glyphs(void)
+{
+    bgr_image image = make_image(40, 20, 0);
+    overlay_renderer renderer;
+    color white = {255, 255, 255};
+    int width = renderer.text(image, 2, 3, "1-", 2, white);
+    TEST_ASSERT_EQUAL_INT((2 * 6 - 1) * 2, width);
+    TEST_ASSERT_EQUAL_INT(16, overlay_renderer::text_height(2));
+
+    // '1' has its stem in the middle column, all 7 rows
+    for (int y = 3; y < 3 + 14; y++)
+        TEST_ASSERT_TRUE(is(image, 2 + 2 * 2, y, white));
+    TEST_ASSERT_FALSE(is(image, 2 + 2 * 2, 3 + 14, white));
+    // '-' is row 3 of the second cell
+    TEST_ASSERT_TRUE(is(image, 2 + 6 * 2, 3 + 3 * 2, white));
+    TEST_ASSERT_FALSE(is(image, 2 + 6 * 2, 3 + 2 * 2, white));
+    // the gap between the cells stays empty
+    TEST_ASSERT_FALSE(is(image, 2 + 5 * 2, 3 + 3 * 2, white));
+}
+
+static void draw_should_mark_boxes_tags_and_count(void)
+{
+    bgr_image image = make_image(320, 240, 128);
+    overlay_renderer renderer;
+    std::vector<detection> dets = {{100, 100, 180, 220, 0.87f, 0}, {5, 2, 60, 50, 0.5f, 0}};
+    renderer.draw(image, dets, 2);
+
+    color person = overlay_renderer::class_color(0);
+    TEST_ASSERT_EQUAL_UINT8(0xFF, person.r);
+    TEST_ASSERT_EQUAL_UINT8(0x38, person.g);
+    TEST_ASSERT_TRUE(is(image, 100, 150, person));
+    TEST_ASSERT_TRUE(is(image, 140, 220, person));
+    // the tag sits above the box
+    TEST_ASSERT_TRUE(is(image, 101, 99 - 2, person) || is(image, 101, 99 - 2, {255, 255, 255}));
+    // the inside of the box is untouched
+    TEST_ASSERT_EQUAL_UINT8(128, pixel(image, 140, 180)[0]);
+    // the count banner is black in the corner
+    TEST_ASSERT_TRUE(is(image, 1, 1, {0, 0, 0}));
+
+    // everything painted is inside some dirty rectangle
+    std::vector<bool> covered(image.width * image.height);
+    for (const rect &r : renderer.dirty())
+        for (int y = r.y0; y < r.y1; y++)
+            for (int x = r.x0; x < r.x1; x++)
+                covered[y * image.width + x] = true;
+    for (int y = 0; y < image.height; y++)
+        for (int x = 0; x < image.width; x++)
+            if (pixel(image, x, y)[0] != 128 || pixel(image, x, y)[2] != 128) {
+                TEST_ASSERT_TRUE(covered[y * image.width + x]);
+            }
+
+    // a new draw starts a new list
+    renderer.draw(image, {}, -1);
+    TEST_ASSERT_EQUAL_UINT64(0, renderer.dirty().size());
+}
+
+static void encoder_should_round_trip_through_the_decoder(void)
+{
+    bgr_image image = make_image(160, 120, 0);
+    for (int y = 0; y < image.height; y++)
+        for (int x = 0; x < image.width; x++) {
+            uint8_t *p = &image.data[((size_t)y * image.width + x) * 3];
+            p[0] = (uint8_t)(x * 255 / 159);
+            p[1] = (uint8_t)(y * 255 / 119);
+            p[2] = 100;
+        }
+    overlay_renderer().fill(image, {40, 40, 80, 80}, {0, 0, 255});
+
+    frame_encoder encoder(90);
+    std::vector<uint8_t> jpeg, again;
+    TEST_ASSERT_TRUE(encoder.encode(image.data.data(), image.width, image.height, jpeg));
+    TEST_ASSERT_TRUE(jpeg.size() > 100);
+    TEST_ASSERT_EQUAL_UINT8(0xFF, jpeg[0]);
+    TEST_ASSERT_EQUAL_UINT8(0xD8, jpeg[1]);
+    TEST_ASSERT_EQUAL_UINT8(0xD9, jpeg.back());
+
+    // the same encoder again gives the same bytes
+    TEST_ASSERT_TRUE(encoder.encode(image.data.data(), image.width, image.height, again));
+    TEST_ASSERT_TRUE(jpeg == again);
+
+    frame_decoder decoder;
+    bgr_image decoded;
+    TEST_ASSERT_TRUE(decoder.decode(jpeg.data(), jpeg.size(), decoded));
+    TEST_ASSERT_EQUAL_UINT16(160, decoded.width);
+    TEST_ASSERT_EQUAL_UINT16(120, decoded.height);
+    double error = 0;
+    for (size_t i = 0; i < image.data.size(); i++)
+        error += std::abs((int)image.data[i] - (int)decoded.data[i]);
+    TEST_ASSERT_TRUE(error / image.data.size() < 4.0);
+    TEST_ASSERT_TRUE(pixel(decoded, 60, 60)[2] > 200);
+
+    // odd sizes are padded to whole MCUs inside the encoder
+    bgr_image odd = make_image(37, 21, 200);
+    TEST_ASSERT_TRUE(encoder.encode(odd.data.data(), odd.width, odd.height, jpeg));
+    TEST_ASSERT_TRUE(decoder.decode(jpeg.data(), jpeg.size(), decoded));
+    TEST_ASSERT_EQUAL_UINT16(37, decoded.width);
+    TEST_ASSERT_UINT8_WITHIN(3, 200, pixel(decoded, 36, 20)[1]);
+}
+
+static void c_encoder_should_report_the_size_it_needs(void)
+{
+    bgr_image image = make_image(64, 48, 90);
+    std::vector<uint8_t> out(16);
+    int needed = edge_encode_jpeg(image.data.data(), 64, 48, 85, out.data(), (int)out.size());
+    TEST_ASSERT_TRUE(needed < -100);
+    out.resize(-needed);
+    TEST_ASSERT_EQUAL_INT(-needed, edge_encode_jpeg(image.data.data(), 64, 48, 85, out.data(), (int)out.size()));
+    TEST_ASSERT_EQUAL_INT(0, edge_encode_jpeg(image.data.data(), 64, 48, 0, out.data(), (int)out.size()));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(fill_should_clip_to_the_image);
+    RUN_TEST(outline_should_leave_the_inside_alone);
+    RUN_TEST(text_should_render_glyphs);
+    RUN_TEST(draw_should_mark_boxes_tags_and_count);
+    RUN_TEST(encoder_should_round_trip_through_the_decoder);
+    RUN_TEST(c_encoder_should_report_the_size_it_needs);
+    return UNITY_END();
+}
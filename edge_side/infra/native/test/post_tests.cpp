@@ -0,0 +1,245 @@
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "postprocess.h"
+#include "unity.h"
+
+using namespace edge;
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static std::mt19937 s_rng(7);
+
+static float uniform(float lo, float hi)
+{
+    return std::uniform_real_distribution<float>(lo, hi)(s_rng);
+}
+
+// Random head where a fraction of anchors cluster around a few objects
+static std::vector<float> random_head(int anchors, int classes, int objects)
+{
+    std::vector<float> head((size_t)(4 + classes) * anchors);
+    for (int i = 0; i < anchors; i++) {
+        head[i] = uniform(0, 640);
+        head[anchors + i] = uniform(0, 640);
+        head[2 * (size_t)anchors + i] = uniform(4, 120);
+        head[3 * (size_t)anchors + i] = uniform(4, 240);
+        for (int c = 0; c < classes; c++)
+            head[(size_t)(4 + c) * anchors + i] = uniform(0, 0.3f);
+    }
+    for (int o = 0; o < objects; o++) {
+        float cx = uniform(50, 590), cy = uniform(50, 590), w = uniform(20, 100), h = uniform(40, 200);
+        int cls = (int)uniform(0, (float)classes) % classes;
+        for (int k = 0; k < 30; k++) {
+            int i = (int)uniform(0, (float)anchors) % anchors;
+            head[i] = cx + uniform(-5, 5);
+            head[anchors + i] = cy + uniform(-5, 5);
+            head[2 * (size_t)anchors + i] = w * uniform(0.8f, 1.2f);
+            head[3 * (size_t)anchors + i] = h * uniform(0.8f, 1.2f);
+            head[(size_t)(4 + cls) * anchors + i] = uniform(0.3f, 0.99f);
+        }
+    }
+    return head;
+}
+
+// Ultralytics non_max_suppression() written out directly
+static std::vector<detection> reference(const std::vector<float> &head, int anchors, const decode_config &config)
+{
+    std::vector<detection> candidates;
+    for (int i = 0; i < anchors; i++) {
+        int best = 0;
+        for (int c = 1; c < config.num_classes; c++)
+            if (head[(size_t)(4 + c) * anchors + i] > head[(size_t)(4 + best) * anchors + i])
+                best = c;
+        float score = head[(size_t)(4 + best) * anchors + i];
+        if (score <= config.conf)
+            continue;
+        float cx = head[i], cy = head[anchors + i];
+        float hw = head[2 * (size_t)anchors + i] / 2, hh = head[3 * (size_t)anchors + i] / 2;
+        candidates.push_back({cx - hw, cy - hh, cx + hw, cy + hh, score, best});
+    }
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](const detection &a, const detection &b) { return a.score > b.score; });
+
+    std::vector<detection> out;
+    std::vector<bool> removed(candidates.size(), false);
+    for (size_t i = 0; i < candidates.size() && (int)out.size() < config.max_det; i++) {
+        if (removed[i])
+            continue;
+        const detection &a = candidates[i];
+        for (size_t j = i + 1; j < candidates.size(); j++) {
+            const detection &b = candidates[j];
+            float iw = std::min(a.x2, b.x2) - std::max(a.x1, b.x1);
+            float ih = std::min(a.y2, b.y2) - std::max(a.y1, b.y1);
+            if (b.cls != a.cls || iw <= 0 || ih <= 0)
+                continue;
+            float inter = iw * ih;
+            float area_a = (a.x2 - a.x1) * (a.y2 - a.y1), area_b = (b.x2 - b.x1) * (b.y2 - b.y1);
+            if (inter / (area_a + area_b - inter) > config.iou)
+                removed[j] = true;
+        }
+        out.push_back(a);
+    }
+    return out;
+}
+
+static void assert_same(const std::vector<detection> &expected, const std::vector<detection> &actual)
+{
+    TEST_ASSERT_EQUAL_UINT64(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); i++)
+        TEST_ASSERT_EQUAL_MEMORY(&expected[i], &actual[i], sizeof(detection));
+}
+
+static void decoder_should_match_reference(void)
+{
+    // anchor counts with and without a scalar tail, 1 to 80 classes
+    const int shapes[][3] = {{8400, 1, 12}, {8403, 1, 40}, {2100, 3, 20}, {8400, 80, 40}, {5, 2, 1}};
+    for (const auto &shape : shapes) {
+        int anchors = shape[0];
+        decode_config config;
+        config.num_classes = shape[1];
+        std::vector<float> head = random_head(anchors, config.num_classes, shape[2]);
+
+        detection_decoder decoder(config);
+        std::vector<detection> out;
+        decoder.filter(head.data(), anchors);
+        decoder.suppress(out);
+        assert_same(reference(head, anchors, config), out);
+
+        // buffers are reused, so a second frame must not see the first
+        std::vector<float> other = random_head(anchors, config.num_classes, shape[2] / 2 + 1);
+        decoder.filter(other.data(), anchors);
+        decoder.suppress(out);
+        assert_same(reference(other, anchors, config), out);
+    }
+}
+
+static void filter_should_keep_strictly_greater_scores_and_first_best_class(void)
+{
+    const int anchors = 9;
+    decode_config config;
+    config.num_classes = 2;
+    config.conf = 0.5f;
+    std::vector<float> head((4 + 2) * anchors, 10.f);
+    float *c0 = &head[4 * anchors], *c1 = &head[5 * anchors];
+    for (int i = 0; i < anchors; i++)
+        c0[i] = c1[i] = 0.f;
+    c0[1] = 0.5f;              // at the threshold: dropped
+    c1[3] = 0.6f;              // class 1
+    c0[5] = c1[5] = 0.7f;      // tie goes to class 0
+    c0[8] = 0.9f;              // scalar tail
+    head[8] = 100.f;           // cx of anchor 8
+    head[2 * anchors + 8] = 6; // w of anchor 8
+
+    detection_decoder decoder(config);
+    const std::vector<detection> &found = decoder.filter(head.data(), anchors);
+    TEST_ASSERT_EQUAL_UINT64(3, found.size());
+    TEST_ASSERT_EQUAL_INT(1, found[0].cls);
+    TEST_ASSERT_EQUAL_INT(0, found[1].cls);
+    TEST_ASSERT_EQUAL_FLOAT(0.9f, found[2].score);
+    TEST_ASSERT_EQUAL_FLOAT(97.f, found[2].x1);
+    TEST_ASSERT_EQUAL_FLOAT(103.f, found[2].x2);
+}
+
+// Head with one anchor per box: cx, cy, w, h, score, class
+static std::vector<float> boxes_head(const std::vector<std::vector<float>> &boxes, int classes)
+{
+    int n = (int)boxes.size();
+    std::vector<float> head((size_t)(4 + classes) * n, 0.f);
+    for (int i = 0; i < n; i++) {
+        for (int k = 0; k < 4; k++)
+            head[(size_t)k * n + i] = boxes[i][k];
+        head[(size_t)(4 + (int)boxes[i][5]) * n + i] = boxes[i][4];
+    }
+    return head;
+}
+
+static void nms_should_be_per_class_and_stop_at_max_det(void)
+{
+    decode_config config;
+    config.num_classes = 2;
+    std::vector<float> head = boxes_head({{100, 100, 50, 50, 0.9f, 0},
+                                          {102, 101, 50, 50, 0.8f, 0},  // overlaps the first: removed
+                                          {101, 100, 50, 50, 0.85f, 1}, // same place, other class: kept
+                                          {300, 300, 40, 40, 0.6f, 0},
+                                          {330, 300, 40, 40, 0.5f, 0}}, // IoU 1/7 with the previous: kept
+                                         2);
+    detection_decoder decoder(config);
+    std::vector<detection> out;
+    decoder.filter(head.data(), 5);
+    decoder.suppress(out);
+    TEST_ASSERT_EQUAL_UINT64(4, out.size());
+    const float scores[] = {0.9f, 0.85f, 0.6f, 0.5f};
+    for (int i = 0; i < 4; i++)
+        TEST_ASSERT_EQUAL_FLOAT(scores[i], out[i].score);
+
+    config.max_det = 2;
+    detection_decoder limited(config);
+    limited.filter(head.data(), 5);
+    limited.suppress(out);
+    TEST_ASSERT_EQUAL_UINT64(2, out.size());
+    TEST_ASSERT_EQUAL_INT(1, out[1].cls);
+}
+
+static void decode_should_undo_the_letterbox_and_clip(void)
+{
+    // a 1280x720 frame letterboxed to 640: gain 0.5, 140 rows of padding on top
+    std::vector<float> head = boxes_head({{320, 320, 100, 50, 0.9f, 0}, {5, 150, 20, 20, 0.8f, 0}}, 1);
+    detection_decoder decoder;
+    std::vector<detection> out;
+    decoder.decode(head.data(), 2, {0.5f, 0, 140}, 1280, 720, out);
+    TEST_ASSERT_EQUAL_UINT64(2, out.size());
+    TEST_ASSERT_EQUAL_FLOAT(540.f, out[0].x1);
+    TEST_ASSERT_EQUAL_FLOAT(310.f, out[0].y1);
+    TEST_ASSERT_EQUAL_FLOAT(740.f, out[0].x2);
+    TEST_ASSERT_EQUAL_FLOAT(410.f, out[0].y2);
+    TEST_ASSERT_EQUAL_FLOAT(0.f, out[1].x1); // clipped at the left edge
+    TEST_ASSERT_EQUAL_FLOAT(30.f, out[1].x2);
+}
+
+static void c_api_should_match_the_decoder(void)
+{
+    const int anchors = 8400;
+    std::vector<float> head = random_head(anchors, 1, 30);
+    decode_config config;
+    detection_decoder decoder(config);
+    std::vector<detection> expected;
+    decoder.decode(head.data(), anchors, {0.5f, 0, 140}, 1280, 720, expected);
+    TEST_ASSERT_TRUE(expected.size() > 3);
+
+    std::vector<detection> out(300);
+    int n = edge_yolo_decode(head.data(), anchors, 1, config.conf, config.iou, config.max_det, 0.5f, 0, 140, 1280,
+                             720, out.data(), (int)out.size());
+    out.resize(n);
+    assert_same(expected, out);
+
+    // truncated to the capacity, best first
+    detection first;
+    TEST_ASSERT_EQUAL_INT(1, edge_yolo_decode(head.data(), anchors, 1, config.conf, config.iou, config.max_det, 0.5f,
+                                              0, 140, 1280, 720, &first, 1));
+    TEST_ASSERT_EQUAL_MEMORY(&expected[0], &first, sizeof(detection));
+    // no image size: boxes stay in model pixels
+    std::vector<detection> unscaled;
+    decoder.filter(head.data(), anchors);
+    decoder.suppress(unscaled);
+    TEST_ASSERT_EQUAL_INT(1, edge_yolo_decode(head.data(), anchors, 1, config.conf, config.iou, config.max_det, 1, 0,
+                                              0, 0, 0, &first, 1));
+    TEST_ASSERT_EQUAL_MEMORY(&unscaled[0], &first, sizeof(detection));
+
+    TEST_ASSERT_EQUAL_INT(-1, edge_yolo_decode(nullptr, anchors, 1, 0.25f, 0.7f, 300, 1, 0, 0, 0, 0, &first, 1));
+    TEST_ASSERT_EQUAL_INT(-1, edge_yolo_decode(head.data(), anchors, 0, 0.25f, 0.7f, 300, 1, 0, 0, 0, 0, &first, 1));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(decoder_should_match_reference);
+    RUN_TEST(filter_should_keep_strictly_greater_scores_and_first_best_class);
+    RUN_TEST(nms_should_be_per_class_and_stop_at_max_det);
+    RUN_TEST(decode_should_undo_the_letterbox_and_clip);
+    RUN_TEST(c_api_should_match_the_decoder);
+    return UNITY_END();
+}
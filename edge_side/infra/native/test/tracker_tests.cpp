@@ -0,0 +1,231 @@
+#include <vector>
+
+#include "tracker.h"
+#include "unity.h"
+
+using namespace edge;
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// A 40x100 person box with its feet at (x, y)
+static detection person(float x, float y, float score = 0.9f)
+{
+    return {x - 20, y - 100, x + 20, y, score, 0};
+}
+
+static const track *find_track(const std::vector<track> &tracks, int id)
+{
+    for (const track &t : tracks)
+        if (t.id == id)
+            return &t;
+    return nullptr;
+}
+
+static void assignment_should_minimise_total_cost(void)
+{
+    std::vector<int> a = assign_min_cost({{4, 1, 3}, {2, 0, 5}, {3, 2, 2}});
+    // greedy would take (1, 1) for 0 and end at 4 + 0 + 2 or worse
+    TEST_ASSERT_EQUAL_INT(1, a[0]);
+    TEST_ASSERT_EQUAL_INT(0, a[1]);
+    TEST_ASSERT_EQUAL_INT(2, a[2]);
+
+    std::vector<int> wide = assign_min_cost({{5, 1, 9}, {1, 2, 9}});
+    TEST_ASSERT_EQUAL_INT(1, wide[0]);
+    TEST_ASSERT_EQUAL_INT(0, wide[1]);
+
+    std::vector<int> tall = assign_min_cost({{5, 1}, {1, 9}, {0, 0.5f}});
+    TEST_ASSERT_EQUAL_INT(1, tall[0]);
+    TEST_ASSERT_EQUAL_INT(-1, tall[1]);
+    TEST_ASSERT_EQUAL_INT(0, tall[2]);
+
+    TEST_ASSERT_EQUAL_UINT64(0, assign_min_cost({}).size());
+}
+
+static void kalman_should_learn_velocity_and_extrapolate(void)
+{
+    tracker t;
+    for (int i = 0; i < 15; i++)
+        t.update({person(100 + 6.f * i, 300)});
+    const std::vector<track> &active = t.predict();
+    TEST_ASSERT_EQUAL_UINT64(1, active.size());
+    // next position would be x = 100 + 6 * 15
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 190, (active[0].box.x1 + active[0].box.x2) / 2);
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 300, active[0].box.y2);
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 40, active[0].box.x2 - active[0].box.x1);
+
+    t.predict();
+    const track &moved = t.predict()[0];
+    TEST_ASSERT_FLOAT_WITHIN(2.0f, 202, (moved.box.x1 + moved.box.x2) / 2);
+}
+
+static void new_tracks_should_need_a_second_hit(void)
+{
+    tracker t;
+    t.update({});
+    TEST_ASSERT_EQUAL_UINT64(0, t.update({person(100, 300)}).size());
+    TEST_ASSERT_EQUAL_UINT64(1, t.tracks().size());
+    TEST_ASSERT_EQUAL_UINT64(1, t.update({person(103, 300)}).size());
+
+    // a one-frame false positive never shows up and is dropped at once
+    t.update({person(103, 300), person(400, 300)});
+    TEST_ASSERT_EQUAL_UINT64(2, t.tracks().size());
+    TEST_ASSERT_EQUAL_UINT64(1, t.update({person(106, 300)}).size());
+    TEST_ASSERT_EQUAL_UINT64(1, t.tracks().size());
+
+    // weak detections do not start tracks
+    t.update({person(106, 300), person(400, 300, 0.55f)});
+    TEST_ASSERT_EQUAL_UINT64(1, t.tracks().size());
+}
+
+static void ids_should_survive_crossing_paths(void)
+{
+    tracker t;
+    int a = 0, b = 0;
+    for (int i = 0; i < 60; i++) {
+        // two people walking towards each other, one slightly further away
+        std::vector<detection> dets = {person(50 + 5.f * i, 300), person(350 - 5.f * i, 330)};
+        const std::vector<track> &active = t.update(dets);
+        if (i == 5) {
+            TEST_ASSERT_EQUAL_UINT64(2, active.size());
+            a = active[0].box.x1 < active[1].box.x1 ? active[0].id : active[1].id;
+            b = a == active[0].id ? active[1].id : active[0].id;
+        }
+    }
+    const std::vector<track> &active = t.update({person(350, 300), person(50, 330)});
+    TEST_ASSERT_EQUAL_UINT64(2, active.size());
+    TEST_ASSERT_NOT_NULL(find_track(active, a));
+    TEST_ASSERT_FLOAT_WITHIN(10, 350, find_track(active, a)->box.x1 + 20);
+    TEST_ASSERT_FLOAT_WITHIN(10, 50, find_track(active, b)->box.x1 + 20);
+}
+
+static void weak_detections_should_keep_an_occluded_track(void)
+{
+    tracker t;
+    for (int i = 0; i < 5; i++)
+        t.update({person(100 + 4.f * i, 300)});
+    int id = t.update({person(120, 300)})[0].id;
+
+    // partly hidden: the detector is unsure for a few frames
+    for (int i = 0; i < 4; i++) {
+        const std::vector<track> &active = t.update({person(124 + 4.f * i, 300, 0.3f)});
+        TEST_ASSERT_EQUAL_UINT64(1, active.size());
+        TEST_ASSERT_EQUAL_INT(id, active[0].id);
+    }
+    // and fully hidden for a while, coming back further along
+    for (int i = 0; i < 5; i++)
+        TEST_ASSERT_EQUAL_UINT64(0, t.update({}).size());
+    const std::vector<track> &active = t.update({person(160, 300)});
+    TEST_ASSERT_EQUAL_UINT64(1, active.size());
+    TEST_ASSERT_EQUAL_INT(id, active[0].id);
+}
+
+static void lost_tracks_should_expire(void)
+{
+    track_config config;
+    config.max_lost_frames = 5;
+    tracker t(config);
+    for (int i = 0; i < 3; i++)
+        t.update({person(100, 300)});
+    for (int i = 0; i < 5; i++)
+        t.update({});
+    TEST_ASSERT_EQUAL_UINT64(1, t.tracks().size());
+    t.predict();
+    TEST_ASSERT_EQUAL_UINT64(0, t.tracks().size());
+}
+
+static void line_should_count_once_despite_jitter(void)
+{
+    // vertical line at x = 200, drawn downwards: walking to the right is an entry
+    line_counter line({200, 0}, {200, 480});
+    tracker t;
+    float x = 150;
+    for (int i = 0; i < 80; i++) {
+        // approaches, dithers on the line for a while, then goes on
+        if (i < 20 || i >= 60)
+            x += 5;
+        float jitter = (i % 2 ? 3.f : -3.f);
+        line.update(t.update({person(x + jitter, 300)}));
+    }
+    TEST_ASSERT_EQUAL_UINT64(1, line.totals().entries);
+    TEST_ASSERT_EQUAL_UINT64(0, line.totals().exits);
+
+    // coming back is an exit
+    for (int i = 0; i < 40; i++) {
+        x -= 5;
+        line.update(t.update({person(x, 300)}));
+    }
+    TEST_ASSERT_EQUAL_UINT64(1, line.totals().entries);
+    TEST_ASSERT_EQUAL_UINT64(1, line.totals().exits);
+}
+
+static void line_should_ignore_crossings_beyond_its_ends(void)
+{
+    line_counter line({200, 0}, {200, 200});
+    tracker t;
+    for (int i = 0; i < 40; i++)
+        line.update(t.update({person(150 + 5.f * i, 300)}));
+    TEST_ASSERT_EQUAL_UINT64(0, line.totals().entries);
+}
+
+static void zone_should_count_entries_exits_and_occupancy(void)
+{
+    zone_counter zone({{100, 100}, {300, 100}, {300, 400}, {100, 400}});
+    tracker t;
+    // one person walks through, another stays inside
+    for (int i = 0; i < 60; i++)
+        zone.update(t.update({person(40 + 6.f * i, 250), person(200, 350)}));
+    TEST_ASSERT_EQUAL_UINT64(1, zone.totals().entries);
+    TEST_ASSERT_EQUAL_UINT64(1, zone.totals().exits);
+    TEST_ASSERT_EQUAL_UINT64(1, zone.occupancy());
+
+    zone.update(t.update({person(200, 350), person(40 + 6.f * 60, 250)}));
+    TEST_ASSERT_EQUAL_UINT64(1, zone.occupancy());
+}
+
+static void skipped_frames_should_not_change_the_count(void)
+{
+    // eight walkers crossing the line in both directions at different
+    // speeds and heights, some at the same time
+    struct walker {
+        float x0, y, speed;
+        int start;
+    };
+    const walker walkers[] = {{20, 300, 4, 0},   {620, 320, -5, 10}, {20, 360, 6, 30},  {620, 280, -3, 40},
+                              {20, 420, 5, 80},  {620, 400, -6, 85}, {20, 250, 3, 120}, {620, 440, -4, 130}};
+    for (int stride : {1, 2, 3, 5}) {
+        tracker t;
+        line_counter line({320, 0}, {320, 480});
+        for (int frame = 0; frame < 320; frame++) {
+            if (frame % stride) {
+                line.update(t.predict());
+                continue;
+            }
+            std::vector<detection> dets;
+            for (const walker &w : walkers) {
+                float x = w.x0 + w.speed * (frame - w.start);
+                if (frame >= w.start && x >= 0 && x <= 640)
+                    dets.push_back(person(x, w.y));
+            }
+            line.update(t.update(dets));
+        }
+        TEST_ASSERT_EQUAL_UINT64(4, line.totals().entries);
+        TEST_ASSERT_EQUAL_UINT64(4, line.totals().exits);
+    }
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(assignment_should_minimise_total_cost);
+    RUN_TEST(kalman_should_learn_velocity_and_extrapolate);
+    RUN_TEST(new_tracks_should_need_a_second_hit);
+    RUN_TEST(ids_should_survive_crossing_paths);
+    RUN_TEST(weak_detections_should_keep_an_occluded_track);
+    RUN_TEST(lost_tracks_should_expire);
+    RUN_TEST(line_should_count_once_despite_jitter);
+    RUN_TEST(line_should_ignore_crossings_beyond_its_ends);
+    RUN_TEST(zone_should_count_entries_exits_and_occupancy);
+    RUN_TEST(skipped_frames_should_not_change_the_count);
+    return UNITY_END();
+}
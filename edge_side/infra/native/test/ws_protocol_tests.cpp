@@ -0,0 +1,181 @@
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "unity.h"
+#include "ws_protocol.h"
+
+using namespace edge;
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static const uint8_t MASK[4] = {0x37, 0xfa, 0x21, 0x3d};
+
+static const char UPGRADE[] = "GET /cam0 HTTP/1.1\r\n"
+                              "Host: 192.168.1.10:8080\r\n"
+                              "Upgrade: websocket\r\n"
+                              "Connection: keep-alive, Upgrade\r\n"
+                              "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                              "Sec-WebSocket-Version: 13\r\n"
+                              "\r\n";
+
+static std::vector<uint8_t> pattern(size_t len)
+{
+    std::vector<uint8_t> data(len);
+    for (size_t i = 0; i < len; i++)
+        data[i] = (uint8_t)(i * 131 + (i >> 8));
+    return data;
+}
+
+static void accept_key_should_match_rfc_example(void)
+{
+    TEST_ASSERT_EQUAL_STRING("s3pPLMBiTxaQ9kYGzzhZRbK+xOo=", ws::accept_key("dGhlIHNhbXBsZSBub25jZQ==").c_str());
+}
+
+static void parse_upgrade_should_accept_a_complete_request(void)
+{
+    std::string key, path;
+    std::string request = std::string(UPGRADE) + "\x82\x80";
+    TEST_ASSERT_EQUAL_INT((int)strlen(UPGRADE), ws::parse_upgrade(request.data(), request.size(), key, path));
+    TEST_ASSERT_EQUAL_STRING("dGhlIHNhbXBsZSBub25jZQ==", key.c_str());
+    TEST_ASSERT_EQUAL_STRING("/cam0", path.c_str());
+
+    std::string response = ws::upgrade_response(key);
+    TEST_ASSERT_EQUAL_INT(0, response.find("HTTP/1.1 101"));
+    TEST_ASSERT_TRUE(response.find("Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n") != std::string::npos);
+}
+
+static void parse_upgrade_should_wait_for_the_end_of_headers(void)
+{
+    std::string key, path;
+    for (size_t len = 0; len < strlen(UPGRADE); len++)
+        TEST_ASSERT_EQUAL_INT(0, ws::parse_upgrade(UPGRADE, len, key, path));
+}
+
+static void parse_upgrade_should_reject_other_requests(void)
+{
+    std::string key, path;
+    const char *bad[] = {
+        "POST / HTTP/1.1\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Key: a2V5\r\nSec-WebSocket-Version: 13\r\n\r\n",
+        "GET / HTTP/1.1\r\nConnection: Upgrade\r\nSec-WebSocket-Key: a2V5\r\nSec-WebSocket-Version: 13\r\n\r\n",
+        "GET / HTTP/1.1\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Version: 13\r\n\r\n",
+        "GET / HTTP/1.1\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Key: a2V5\r\nSec-WebSocket-Version: 8\r\n\r\n",
+    };
+    for (const char *request : bad)
+        TEST_ASSERT_EQUAL_INT(-1, ws::parse_upgrade(request, strlen(request), key, path));
+}
+
+static void parser_should_read_every_length_encoding(void)
+{
+    const size_t sizes[] = {0, 1, 125, 126, 127, 65535, 65536, 1 << 20};
+    for (size_t size : sizes) {
+        std::vector<uint8_t> data = pattern(size), wire;
+        ws::append_frame(wire, ws::OP_FIN | ws::OP_BINARY, data.data(), data.size(), MASK);
+        ws::append_frame(wire, ws::OP_FIN | ws::OP_BINARY, data.data(), data.size(), MASK);
+
+        ws::frame_parser parser(2 << 20);
+        size_t used = 0, pos = 0;
+        for (int message = 0; message < 2; message++) {
+            TEST_ASSERT_EQUAL_INT(ws::frame_parser::MESSAGE, parser.feed(wire.data() + pos, wire.size() - pos, used));
+            pos += used;
+            TEST_ASSERT_EQUAL_UINT8(ws::OP_BINARY, parser.opcode());
+            TEST_ASSERT_TRUE(parser.take_payload() == data);
+        }
+        TEST_ASSERT_EQUAL_UINT64(wire.size(), pos);
+    }
+}
+
+static void parser_should_resume_at_any_split(void)
+{
+    std::vector<uint8_t> data = pattern(300), wire;
+    ws::append_frame(wire, ws::OP_FIN | ws::OP_BINARY, data.data(), data.size(), MASK);
+
+    for (size_t split = 0; split <= wire.size(); split++) {
+        ws::frame_parser parser(1024);
+        size_t used = 0;
+        ws::frame_parser::result r = parser.feed(wire.data(), split, used);
+        TEST_ASSERT_EQUAL_UINT64(split, used);
+        if (split < wire.size()) {
+            TEST_ASSERT_EQUAL_INT(ws::frame_parser::NEED_MORE, r);
+            r = parser.feed(wire.data() + split, wire.size() - split, used);
+        }
+        TEST_ASSERT_EQUAL_INT(ws::frame_parser::MESSAGE, r);
+        TEST_ASSERT_TRUE(parser.payload() == data);
+    }
+}
+
+static void parser_should_reassemble_fragments_around_control_frames(void)
+{
+    // the way main.c sends a long reply: TEXT without FIN, CONT, CONT with FIN
+    std::vector<uint8_t> wire;
+    ws::append_frame(wire, ws::OP_TEXT, "{\"status\":", 10, MASK);
+    ws::append_frame(wire, ws::OP_FIN | ws::OP_PING, "hb", 2, MASK);
+    ws::append_frame(wire, ws::OP_CONT, "\"ok\",", 5, MASK);
+    ws::append_frame(wire, ws::OP_FIN | ws::OP_CONT, "\"n\":1}", 6, MASK);
+
+    ws::frame_parser parser(1024);
+    size_t used = 0, pos = 0;
+    TEST_ASSERT_EQUAL_INT(ws::frame_parser::MESSAGE, parser.feed(wire.data(), wire.size(), used));
+    pos += used;
+    TEST_ASSERT_EQUAL_UINT8(ws::OP_PING, parser.opcode());
+    TEST_ASSERT_EQUAL_STRING_LEN("hb", (const char *)parser.payload().data(), 2);
+
+    TEST_ASSERT_EQUAL_INT(ws::frame_parser::MESSAGE, parser.feed(wire.data() + pos, wire.size() - pos, used));
+    pos += used;
+    TEST_ASSERT_EQUAL_UINT64(wire.size(), pos);
+    TEST_ASSERT_EQUAL_UINT8(ws::OP_TEXT, parser.opcode());
+    std::string text(parser.payload().begin(), parser.payload().end());
+    TEST_ASSERT_EQUAL_STRING("{\"status\":\"ok\",\"n\":1}", text.c_str());
+}
+
+static void parser_should_reject_protocol_errors(void)
+{
+    std::vector<std::vector<uint8_t>> cases(5);
+    ws::append_frame(cases[0], ws::OP_FIN | ws::OP_BINARY, "x", 1);            // unmasked
+    ws::append_frame(cases[1], ws::OP_FIN | ws::OP_CONT, "x", 1, MASK);        // nothing to continue
+    ws::append_frame(cases[2], ws::OP_PING, "x", 1, MASK);                      // fragmented control
+    std::vector<uint8_t> big = pattern(126);
+    ws::append_frame(cases[3], ws::OP_FIN | ws::OP_PING, big.data(), big.size(), MASK);
+    ws::append_frame(cases[4], ws::OP_FIN | 0x03, "x", 1, MASK);                // reserved opcode
+
+    for (const std::vector<uint8_t> &wire : cases) {
+        ws::frame_parser parser(1024);
+        size_t used = 0;
+        TEST_ASSERT_EQUAL_INT(ws::frame_parser::ERROR_PROTOCOL, parser.feed(wire.data(), wire.size(), used));
+    }
+
+    // a new message may not start inside a fragmented one
+    std::vector<uint8_t> wire;
+    ws::append_frame(wire, ws::OP_BINARY, "a", 1, MASK);
+    ws::append_frame(wire, ws::OP_FIN | ws::OP_BINARY, "b", 1, MASK);
+    ws::frame_parser parser(1024);
+    size_t used = 0;
+    TEST_ASSERT_EQUAL_INT(ws::frame_parser::ERROR_PROTOCOL, parser.feed(wire.data(), wire.size(), used));
+}
+
+static void parser_should_limit_message_size(void)
+{
+    std::vector<uint8_t> data = pattern(600), wire;
+    ws::append_frame(wire, ws::OP_BINARY, data.data(), 600, MASK);
+    ws::append_frame(wire, ws::OP_FIN | ws::OP_CONT, data.data(), 600, MASK);
+
+    ws::frame_parser parser(1000);
+    size_t used = 0;
+    TEST_ASSERT_EQUAL_INT(ws::frame_parser::ERROR_TOO_BIG, parser.feed(wire.data(), wire.size(), used));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(accept_key_should_match_rfc_example);
+    RUN_TEST(parse_upgrade_should_accept_a_complete_request);
+    RUN_TEST(parse_upgrade_should_wait_for_the_end_of_headers);
+    RUN_TEST(parse_upgrade_should_reject_other_requests);
+    RUN_TEST(parser_should_read_every_length_encoding);
+    RUN_TEST(parser_should_resume_at_any_split);
+    RUN_TEST(parser_should_reassemble_fragments_around_control_frames);
+    RUN_TEST(parser_should_reject_protocol_errors);
+    RUN_TEST(parser_should_limit_message_size);
+    return UNITY_END();
+}
@@ -0,0 +1,155 @@
+// Cost of producing the annotated JPEG the backend receives: decode the
+// camera JPEG, draw boxes, tags and the count into the frame and encode it,
+// against jpeg_patcher redrawing only the MCUs under the overlay.
+//
+// Usage:
+//     annotate_bench frame.jpg                   # detector boxes, median of 50 runs
+//     annotate_bench --out annotated.jpg --patched patched.jpg frame.jpg
+//     annotate_bench --quality 85 --runs 200 frame.jpg ...
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "frame_decoder.h"
+#include "frame_encoder.h"
+#include "jpeg_patch.h"
+#include "overlay.h"
+#include "yolo.h"
+
+using clock_type = std::chrono::steady_clock;
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr, "usage: %s [--model DIR] [--quality N] [--runs N] [--out FILE] [--patched FILE] image.jpg ...\n", argv0);
+}
+
+static bool read_file(const std::string &path, std::vector<uint8_t> &data)
+{
+    std::ifstream file(path, std::ios::binary);
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return !data.empty();
+}
+
+static double median(std::vector<double> v)
+{
+    std::sort(v.begin(), v.end());
+    return v[v.size() / 2];
+}
+
+// Share of the 16x16 MCUs of a 4:2:0 JPEG that the overlay touched
+static double mcu_share(const std::vector<edge::rect> &dirty, int width, int height)
+{
+    int columns = (width + 15) / 16, rows = (height + 15) / 16;
+    std::set<int> touched;
+    for (const edge::rect &r : dirty)
+        for (int y = r.y0 / 16; y <= (r.y1 - 1) / 16; y++)
+            for (int x = r.x0 / 16; x <= (r.x1 - 1) / 16; x++)
+                touched.insert(y * columns + x);
+    return (double)touched.size() / (columns * rows);
+}
+
+int main(int argc, char **argv)
+{
+    edge::yolo_config config;
+    config.model_dir = MODEL_DIR;
+    int quality = 85, runs = 50;
+    std::string out_path, patched_path;
+    std::vector<std::string> images;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--model" && has_value)
+            config.model_dir = argv[++i];
+        else if (arg == "--quality" && has_value)
+            quality = std::min(100, std::max(1, atoi(argv[++i])));
+        else if (arg == "--runs" && has_value)
+            runs = std::max(1, atoi(argv[++i]));
+        else if (arg == "--out" && has_value)
+            out_path = argv[++i];
+        else if (arg == "--patched" && has_value)
+            patched_path = argv[++i];
+        else if (arg[0] == '-') {
+            usage(argv[0]);
+            return 1;
+        } else
+            images.push_back(arg);
+    }
+    if (images.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    edge::yolo_detector detector(config);
+    if (!detector.load())
+        return 1;
+    edge::frame_decoder decoder;
+    edge::frame_encoder encoder(quality);
+    edge::overlay_renderer renderer;
+    edge::jpeg_patcher patcher;
+
+    printf("%-40s %8s %6s %9s %9s %9s %9s %9s %8s\n", "image", "size", "boxes", "decode ms", "draw ms", "encode ms",
+           "total ms", "patch ms", "MCUs");
+    for (const std::string &path : images) {
+        std::vector<uint8_t> jpeg;
+        edge::bgr_image source;
+        if (!read_file(path, jpeg) || !decoder.decode(jpeg.data(), jpeg.size(), source)) {
+            fprintf(stderr, "Cannot decode %s\n", path.c_str());
+            return 1;
+        }
+        std::vector<edge::detection> detections;
+        if (!detector.detect(source, detections))
+            return 1;
+
+        std::vector<double> decode_ms, draw_ms, encode_ms, patch_ms;
+        edge::bgr_image frame;
+        std::vector<uint8_t> annotated, patched;
+        bool patchable = true;
+        for (int r = 0; r < runs; r++) {
+            clock_type::time_point t0 = clock_type::now();
+            decoder.decode(jpeg.data(), jpeg.size(), frame);
+            clock_type::time_point t1 = clock_type::now();
+            renderer.draw(frame, detections, (int)detections.size());
+            clock_type::time_point t2 = clock_type::now();
+            if (!encoder.encode(frame.data.data(), frame.width, frame.height, annotated)) {
+                fprintf(stderr, "Cannot encode %s\n", path.c_str());
+                return 1;
+            }
+            clock_type::time_point t3 = clock_type::now();
+            patchable = patcher.annotate(jpeg.data(), jpeg.size(), detections, (int)detections.size(), patched);
+            clock_type::time_point t4 = clock_type::now();
+            decode_ms.push_back(std::chrono::duration<double, std::milli>(t1 - t0).count());
+            draw_ms.push_back(std::chrono::duration<double, std::milli>(t2 - t1).count());
+            encode_ms.push_back(std::chrono::duration<double, std::milli>(t3 - t2).count());
+            patch_ms.push_back(std::chrono::duration<double, std::milli>(t4 - t3).count());
+        }
+
+        char size[32], patch[32] = "-";
+        snprintf(size, sizeof(size), "%ux%u", source.width, source.height);
+        if (patchable)
+            snprintf(patch, sizeof(patch), "%.3f", median(patch_ms));
+        printf("%-40s %8s %6zu %9.3f %9.3f %9.3f %9.3f %9s %7.1f%%\n", path.c_str(), size, detections.size(),
+               median(decode_ms), median(draw_ms), median(encode_ms),
+               median(decode_ms) + median(draw_ms) + median(encode_ms),
+               patch,
+               100 * mcu_share(renderer.dirty(), source.width, source.height));
+
+        if (!out_path.empty()) {
+            std::ofstream file(out_path, std::ios::binary);
+            file.write((const char *)annotated.data(), annotated.size());
+            printf("  wrote %s, %zu bytes\n", out_path.c_str(), annotated.size());
+        }
+        if (!patched_path.empty() && patchable) {
+            std::ofstream file(patched_path, std::ios::binary);
+            file.write((const char *)patched.data(), patched.size());
+            printf("  wrote %s, %zu bytes\n", patched_path.c_str(), patched.size());
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include "camera_client.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace edge {
+
+camera_client::camera_client()
+    : m_mask_state((uint32_t)(uintptr_t)this | 1),
+      m_parser(64 << 20)
+{
+    m_parser.set_require_mask(false);
+}
+
+camera_client::~camera_client()
+{
+    close();
+}
+
+bool camera_client::connect(const std::string &host, uint16_t port, const std::string &path)
+{
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1)
+        return false;
+
+    m_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (m_fd < 0 || ::connect(m_fd, (sockaddr *)&addr, sizeof(addr)) != 0) {
+        close();
+        return false;
+    }
+    int one = 1;
+    setsockopt(m_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    const std::string key = "dGhlIHNhbXBsZSBub25jZQ==";
+    std::string request = "GET " + path + " HTTP/1.1\r\n"
+                          "Host: " + host + "\r\n"
+                          "Upgrade: websocket\r\n"
+                          "Connection: Upgrade\r\n"
+                          "Sec-WebSocket-Key: " + key + "\r\n"
+                          "Sec-WebSocket-Version: 13\r\n\r\n";
+    if (!send_all(request.data(), request.size())) {
+        close();
+        return false;
+    }
+
+    // read the response headers; anything after them is already WebSocket data
+    std::string response;
+    char buf[1024];
+    size_t end;
+    while ((end = response.find("\r\n\r\n")) == std::string::npos) {
+        ssize_t n = recv(m_fd, buf, sizeof(buf), 0);
+        if (n <= 0) {
+            close();
+            return false;
+        }
+        response.append(buf, (size_t)n);
+    }
+    if (response.compare(0, 12, "HTTP/1.1 101") != 0 ||
+        response.find("Sec-WebSocket-Accept: " + ws::accept_key(key)) == std::string::npos) {
+        close();
+        return false;
+    }
+    m_in.assign(response.begin() + end + 4, response.end());
+    m_in_pos = 0;
+    return true;
+}
+
+void camera_client::close()
+{
+    if (m_fd >= 0)
+        ::close(m_fd);
+    m_fd = -1;
+}
+
+bool camera_client::send(uint8_t opcode, const void *data, size_t len)
+{
+    // xorshift is plenty for a mask that only has to be unpredictable to proxies
+    m_mask_state ^= m_mask_state << 13;
+    m_mask_state ^= m_mask_state >> 17;
+    m_mask_state ^= m_mask_state << 5;
+    uint8_t mask[4];
+    memcpy(mask, &m_mask_state, 4);
+
+    m_out.clear();
+    ws::append_frame(m_out, opcode, data, len, mask);
+    return send_all(m_out.data(), m_out.size());
+}
+
+bool camera_client::send_all(const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    while (len) {
+        ssize_t n = ::send(m_fd, p, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        p += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+bool camera_client::receive(uint8_t &opcode, std::vector<uint8_t> &payload, int timeout_ms)
+{
+    for (;;) {
+        while (m_in_pos < m_in.size()) {
+            size_t used = 0;
+            ws::frame_parser::result r = m_parser.feed(m_in.data() + m_in_pos, m_in.size() - m_in_pos, used);
+            m_in_pos += used;
+            if (r == ws::frame_parser::MESSAGE) {
+                opcode = m_parser.opcode();
+                payload = m_parser.payload();
+                return true;
+            }
+            if (r != ws::frame_parser::NEED_MORE)
+                return false;
+        }
+        m_in.clear();
+        m_in_pos = 0;
+
+        pollfd pfd = {m_fd, POLLIN, 0};
+        if (m_fd < 0 || poll(&pfd, 1, timeout_ms) <= 0)
+            return false;
+        uint8_t buf[4096];
+        ssize_t n = recv(m_fd, buf, sizeof(buf), 0);
+        if (n <= 0)
+            return false;
+        m_in.assign(buf, buf + n);
+    }
+}
+
+} // namespace edge
@@ -0,0 +1,46 @@
+// Blocking WebSocket client that behaves like a camera: masked frames, one
+// JPEG per binary message. Used by the benchmark and the tests.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ws_protocol.h"
+
+namespace edge {
+
+class camera_client {
+public:
+    camera_client();
+    ~camera_client();
+
+    camera_client(const camera_client &) = delete;
+    camera_client &operator=(const camera_client &) = delete;
+
+    // Connects and completes the upgrade handshake
+    bool connect(const std::string &host, uint16_t port, const std::string &path = "/");
+    void close();
+
+    bool send(uint8_t opcode, const void *data, size_t len);
+    bool send_binary(const void *data, size_t len) { return send(ws::OP_FIN | ws::OP_BINARY, data, len); }
+    bool send_text(const std::string &text) { return send(ws::OP_FIN | ws::OP_TEXT, text.data(), text.size()); }
+
+    // Waits up to timeout_ms for the next server message
+    bool receive(uint8_t &opcode, std::vector<uint8_t> &payload, int timeout_ms);
+
+    int fd() const { return m_fd; }
+
+private:
+    bool send_all(const void *data, size_t len);
+
+    int m_fd = -1;
+    uint32_t m_mask_state;
+    ws::frame_parser m_parser;
+    std::vector<uint8_t> m_in;
+    size_t m_in_pos = 0;
+    std::vector<uint8_t> m_out;
+};
+
+} // namespace edge
@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+"""
+Checks the native detector against the ncnn Python runtime and Ultralytics.
+
+Preprocesses an image the way Ultralytics does, runs the same tensor through
+ncnn and through `yolo_detect --input-raw`, and reports the largest output
+difference plus both sets of detections.
+
+Usage:
+  python native/tools/compare_ncnn.py --binary native/build/yolo_detect tmp/latest.jpg
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import tempfile
+
+import cv2
+import ncnn
+import numpy as np
+from ultralytics import YOLO
+
+WEIGHTS = os.path.join(os.path.dirname(__file__), "..", "..", "weights", "yolov11n_ncnn_model")
+
+
+def letterbox(image, size):
+    h, w = image.shape[:2]
+    gain = min(size / h, size / w)
+    nw, nh = round(w * gain), round(h * gain)
+    dw, dh = (size - nw) / 2, (size - nh) / 2
+    resized = cv2.resize(image, (nw, nh), interpolation=cv2.INTER_LINEAR)
+    top, bottom = round(dh - 0.1), round(dh + 0.1)
+    left, right = round(dw - 0.1), round(dw + 0.1)
+    padded = cv2.copyMakeBorder(resized, top, bottom, left, right, cv2.BORDER_CONSTANT, value=(114, 114, 114))
+    return np.ascontiguousarray(padded[:, :, ::-1].transpose(2, 0, 1), dtype=np.float32) / 255.0
+
+
+def run_ncnn(tensor):
+    with ncnn.Net() as net:
+        net.load_param(os.path.join(WEIGHTS, "model.ncnn.param"))
+        net.load_model(os.path.join(WEIGHTS, "model.ncnn.bin"))
+        with net.create_extractor() as ex:
+            ex.input("in0", ncnn.Mat(tensor).clone())
+            _, out = ex.extract("out0")
+            return np.array(out)
+
+
+def main():
+    p = argparse.ArgumentParser()
+    p.add_argument("--binary", default="native/build/yolo_detect", help="yolo_detect executable")
+    p.add_argument("--size", type=int, default=640)
+    p.add_argument("image")
+    args = p.parse_args()
+
+    image = cv2.imread(args.image)
+    tensor = letterbox(image, args.size)
+    expected = run_ncnn(tensor)
+
+    with tempfile.TemporaryDirectory() as tmp:
+        raw_in, raw_out = os.path.join(tmp, "in.f32"), os.path.join(tmp, "out.f32")
+        tensor.tofile(raw_in)
+        subprocess.run([args.binary, "--input-raw", raw_in, "--dump-output", raw_out], check=True)
+        actual = np.fromfile(raw_out, dtype=np.float32).reshape(expected.shape)
+
+    diff = np.abs(actual - expected)
+    print(f"out0 {expected.shape}: max abs diff {diff.max():.6f}, mean {diff.mean():.6f}")
+    print(f"score row: max abs diff {diff[4:].max():.6f}")
+
+    result = YOLO(WEIGHTS, task="detect").predict(args.image, verbose=False)[0]
+    print("ultralytics:")
+    for box, conf in zip(result.boxes.xyxy.tolist(), result.boxes.conf.tolist()):
+        print(f"  {conf:.3f}  [{', '.join(f'{v:.1f}' for v in box)}]")
+
+    native = subprocess.run([args.binary, "--json", args.image], check=True, capture_output=True, text=True)
+    print("native:")
+    for d in json.loads(native.stdout.splitlines()[-1])["detections"]:
+        print(f"  {d['confidence']:.3f}  [{', '.join(f'{v:.1f}' for v in d['bbox'])}]")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,179 @@
+// Ingest throughput benchmark: K simulated cameras stream a JPEG over
+// loopback into an in-process ingest_server while the main thread consumes
+// decoded frames, then prints the per-camera report.
+//
+// Usage:
+//     ingest_bench --cameras 8 --fps 15 --seconds 10 --workers 2
+//     ingest_bench --fps 0                 # send as fast as the socket allows
+//     ingest_bench --cameras 8 --fps 2 --batch 4 --slo-ms 1500
+//                                          # run the detector through batch_scheduler
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <thread>
+
+#include "batch_scheduler.h"
+#include "camera_client.h"
+#include "ingest_server.h"
+#include "yolo.h"
+
+using clock_type = std::chrono::steady_clock;
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [--cameras N] [--fps N] [--seconds N] [--workers N] [--scale 0-3] [--jpeg FILE]\n"
+            "          [--batch N] [--max-wait-ms N] [--slo-ms N] [--threads N]\n",
+            argv0);
+}
+
+int main(int argc, char **argv)
+{
+    int cameras = 4;
+    double fps = 15;
+    double seconds = 5;
+    std::string jpeg_path = TEST_PICTURES "/test_inside.jpeg";
+    edge::ingest_config config;
+    config.host = "127.0.0.1";
+    config.port = 0;
+    config.greeting.clear();
+    edge::batch_config batching;
+    batching.max_batch = 0; // no inference unless --batch is given
+    edge::yolo_config detector_config;
+    detector_config.model_dir = MODEL_DIR;
+
+    for (int i = 1; i < argc; i += 2) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!value) {
+            usage(argv[0]);
+            return 1;
+        }
+        if (!strcmp(arg, "--cameras"))
+            cameras = atoi(value);
+        else if (!strcmp(arg, "--fps"))
+            fps = atof(value);
+        else if (!strcmp(arg, "--seconds"))
+            seconds = atof(value);
+        else if (!strcmp(arg, "--workers"))
+            config.decode_threads = atoi(value);
+        else if (!strcmp(arg, "--scale"))
+            config.decode_scale = (uint8_t)atoi(value);
+        else if (!strcmp(arg, "--jpeg"))
+            jpeg_path = value;
+        else if (!strcmp(arg, "--batch"))
+            batching.max_batch = atoi(value);
+        else if (!strcmp(arg, "--max-wait-ms"))
+            batching.max_wait = std::chrono::microseconds((int64_t)(atof(value) * 1000));
+        else if (!strcmp(arg, "--slo-ms"))
+            batching.slo = std::chrono::microseconds((int64_t)(atof(value) * 1000));
+        else if (!strcmp(arg, "--threads"))
+            detector_config.threads = atoi(value);
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::ifstream file(jpeg_path, std::ios::binary);
+    std::vector<uint8_t> jpeg((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    uint16_t width, height;
+    if (jpeg.empty() || !edge::frame_decoder().probe(jpeg.data(), jpeg.size(), width, height)) {
+        fprintf(stderr, "Cannot read JPEG %s\n", jpeg_path.c_str());
+        return 1;
+    }
+
+    // frames go through the batching scheduler into the detector when asked
+    std::unique_ptr<edge::yolo_detector> detector;
+    std::unique_ptr<edge::batch_scheduler> scheduler;
+    if (batching.max_batch > 0) {
+        detector.reset(new edge::yolo_detector(detector_config));
+        if (!detector->load())
+            return 1;
+        scheduler.reset(new edge::batch_scheduler(
+            batching,
+            [&](const std::vector<const edge::bgr_image *> &images, std::vector<std::vector<edge::detection>> &out) {
+                return detector->detect_batch(images, out);
+            },
+            nullptr));
+        scheduler->start();
+    }
+
+    edge::ingest_server server(config);
+    if (!server.start())
+        return 1;
+    printf("%d cameras x %.0f fps, %ux%u JPEG of %zu bytes, %d decode threads, scale 1/%d\n", cameras, fps, width,
+           height, jpeg.size(), config.decode_threads, 1 << config.decode_scale);
+    if (scheduler)
+        printf("detector: %d threads, batches of up to %d, max wait %.0f ms, SLO %.0f ms\n", detector->threads(),
+               batching.max_batch, batching.max_wait.count() / 1000.0, batching.slo.count() / 1000.0);
+
+    std::atomic<bool> running{true};
+    std::atomic<uint64_t> sent{0};
+    std::vector<std::thread> senders;
+    for (int c = 0; c < cameras; c++) {
+        senders.emplace_back([&, c] {
+            edge::camera_client client;
+            if (!client.connect("127.0.0.1", server.port(), "/cam" + std::to_string(c))) {
+                fprintf(stderr, "camera %d: connect failed\n", c);
+                return;
+            }
+            clock_type::duration period = fps > 0 ? std::chrono::duration_cast<clock_type::duration>(
+                                                        std::chrono::duration<double>(1.0 / fps))
+                                                  : clock_type::duration::zero();
+            clock_type::time_point next = clock_type::now();
+            while (running) {
+                if (!client.send_binary(jpeg.data(), jpeg.size()))
+                    break;
+                sent++;
+                if (fps > 0) {
+                    next += period;
+                    std::this_thread::sleep_until(next);
+                }
+            }
+        });
+    }
+
+    // the consumer only takes frames, the way an idle inference stage would
+    uint64_t consumed = 0;
+    clock_type::time_point start = clock_type::now();
+    clock_type::time_point end = start + std::chrono::duration_cast<clock_type::duration>(
+                                             std::chrono::duration<double>(seconds));
+    server.report();
+    if (scheduler)
+        scheduler->report();
+    while (clock_type::now() < end) {
+        edge::frame_ptr frame;
+        if (server.next_frame(frame, std::chrono::milliseconds(10))) {
+            consumed++;
+            if (scheduler)
+                scheduler->submit(std::move(frame));
+        }
+    }
+    std::vector<edge::camera_report> reports = server.report();
+    running = false;
+    for (auto &t : senders)
+        t.join();
+    server.stop();
+    edge::batch_report batches;
+    if (scheduler) {
+        batches = scheduler->report();
+        scheduler->stop();
+    }
+
+    fputs(edge::ingest_server::format_report(reports).c_str(), stdout);
+    double in = 0, out = 0;
+    for (const edge::camera_report &r : reports) {
+        in += r.fps_in;
+        out += r.fps_out;
+    }
+    printf("total: %.1f frames/s in, %.1f frames/s decoded and delivered (%.1f MB/s of JPEG)\n", in, out,
+           in * jpeg.size() / 1e6);
+    if (scheduler)
+        fputs(edge::batch_scheduler::format_report(batches).c_str(), stdout);
+    return 0;
+}
@@ -0,0 +1,192 @@
+// Times detection decoding + NMS on a YOLO head output.
+//
+// Usage:
+//     post_bench                                  # synthetic 8400 anchors, 1 class
+//     post_bench --classes 80 --objects 40        # COCO-sized head
+//     post_bench --input-raw out0.f32             # a real output from yolo_detect --dump-output
+//
+// Prints the median time per frame of the vectorised decoder and of the
+// straightforward scalar version it replaced, for the same input.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "postprocess.h"
+
+using namespace edge;
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [--anchors N] [--classes N] [--objects N] [--per-object N] [--conf X] [--iou X]\n"
+            "          [--iterations N] [--input-raw FILE]\n",
+            argv0);
+}
+
+// Scores near zero everywhere except clusters of anchors around each
+// object, which is what a trained head produces
+static std::vector<float> synthetic_head(int anchors, int classes, int objects, int per_object)
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> uniform(0.f, 1.f);
+    std::vector<float> head((size_t)(4 + classes) * anchors);
+    for (int i = 0; i < anchors; i++) {
+        head[i] = uniform(rng) * 640;
+        head[anchors + i] = uniform(rng) * 640;
+        head[2 * (size_t)anchors + i] = 8 + uniform(rng) * 100;
+        head[3 * (size_t)anchors + i] = 8 + uniform(rng) * 200;
+        for (int c = 0; c < classes; c++)
+            head[(size_t)(4 + c) * anchors + i] = uniform(rng) * 0.02f;
+    }
+    for (int o = 0; o < objects; o++) {
+        float cx = 40 + uniform(rng) * 560, cy = 40 + uniform(rng) * 560;
+        float w = 20 + uniform(rng) * 80, h = 40 + uniform(rng) * 160, score = 0.3f + uniform(rng) * 0.65f;
+        int cls = (int)(uniform(rng) * classes) % classes;
+        for (int k = 0; k < per_object; k++) {
+            int i = (int)(uniform(rng) * anchors) % anchors;
+            head[i] = cx + (uniform(rng) - 0.5f) * w * 0.2f;
+            head[anchors + i] = cy + (uniform(rng) - 0.5f) * h * 0.2f;
+            head[2 * (size_t)anchors + i] = w * (0.9f + uniform(rng) * 0.2f);
+            head[3 * (size_t)anchors + i] = h * (0.9f + uniform(rng) * 0.2f);
+            head[(size_t)(4 + cls) * anchors + i] = score * (0.7f + uniform(rng) * 0.3f);
+        }
+    }
+    return head;
+}
+
+// The per-anchor loop and O(n^2) removal pass the decoder replaced
+static void scalar_decode(const float *head, int anchors, const decode_config &config, std::vector<detection> &out)
+{
+    std::vector<detection> candidates;
+    for (int i = 0; i < anchors; i++) {
+        int best = 0;
+        float score = head[4 * (size_t)anchors + i];
+        for (int c = 1; c < config.num_classes; c++)
+            if (head[(size_t)(4 + c) * anchors + i] > score) {
+                score = head[(size_t)(4 + c) * anchors + i];
+                best = c;
+            }
+        if (score <= config.conf)
+            continue;
+        float cx = head[i], cy = head[anchors + i];
+        float hw = head[2 * (size_t)anchors + i] / 2, hh = head[3 * (size_t)anchors + i] / 2;
+        candidates.push_back({cx - hw, cy - hh, cx + hw, cy + hh, score, best});
+    }
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](const detection &a, const detection &b) { return a.score > b.score; });
+
+    out.clear();
+    std::vector<bool> removed(candidates.size(), false);
+    for (size_t i = 0; i < candidates.size() && (int)out.size() < config.max_det; i++) {
+        if (removed[i])
+            continue;
+        const detection &a = candidates[i];
+        for (size_t j = i + 1; j < candidates.size(); j++) {
+            const detection &b = candidates[j];
+            if (removed[j] || b.cls != a.cls)
+                continue;
+            float iw = std::min(a.x2, b.x2) - std::max(a.x1, b.x1);
+            float ih = std::min(a.y2, b.y2) - std::max(a.y1, b.y1);
+            if (iw <= 0 || ih <= 0)
+                continue;
+            float inter = iw * ih;
+            float area_a = (a.x2 - a.x1) * (a.y2 - a.y1), area_b = (b.x2 - b.x1) * (b.y2 - b.y1);
+            if (inter / (area_a + area_b - inter) > config.iou)
+                removed[j] = true;
+        }
+        out.push_back(a);
+    }
+}
+
+template <typename F> static double median_us(int iterations, F fn)
+{
+    std::vector<double> times;
+    for (int i = 0; i < iterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        times.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+int main(int argc, char **argv)
+{
+    int anchors = 8400, objects = 12, per_object = 25, iterations = 2000;
+    decode_config config;
+    std::string input_raw;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--anchors" && has_value)
+            anchors = atoi(argv[++i]);
+        else if (arg == "--classes" && has_value)
+            config.num_classes = atoi(argv[++i]);
+        else if (arg == "--objects" && has_value)
+            objects = atoi(argv[++i]);
+        else if (arg == "--per-object" && has_value)
+            per_object = atoi(argv[++i]);
+        else if (arg == "--conf" && has_value)
+            config.conf = (float)atof(argv[++i]);
+        else if (arg == "--iou" && has_value)
+            config.iou = (float)atof(argv[++i]);
+        else if (arg == "--iterations" && has_value)
+            iterations = std::max(1, atoi(argv[++i]));
+        else if (arg == "--input-raw" && has_value)
+            input_raw = argv[++i];
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (anchors <= 0 || config.num_classes <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<float> head;
+    if (!input_raw.empty()) {
+        std::ifstream file(input_raw, std::ios::binary);
+        std::vector<char> raw((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        size_t rows = 4 + config.num_classes;
+        if (raw.empty() || raw.size() % (rows * sizeof(float))) {
+            fprintf(stderr, "%s is not a (%zu x anchors) float32 tensor\n", input_raw.c_str(), rows);
+            return 1;
+        }
+        head.resize(raw.size() / sizeof(float));
+        memcpy(head.data(), raw.data(), raw.size());
+        anchors = (int)(head.size() / rows);
+    } else {
+        head = synthetic_head(anchors, config.num_classes, objects, per_object);
+    }
+
+    detection_decoder decoder(config);
+    std::vector<detection> fast, slow;
+    size_t candidates = decoder.filter(head.data(), anchors).size();
+    decoder.suppress(fast);
+    scalar_decode(head.data(), anchors, config, slow);
+    bool same = fast.size() == slow.size();
+    for (size_t i = 0; same && i < fast.size(); i++)
+        same = !memcmp(&fast[i], &slow[i], sizeof(detection));
+
+    double filter_us = median_us(iterations, [&] { decoder.filter(head.data(), anchors); });
+    double total_us = median_us(iterations, [&] {
+        decoder.filter(head.data(), anchors);
+        decoder.suppress(fast);
+    });
+    double scalar_us = median_us(iterations, [&] { scalar_decode(head.data(), anchors, config, slow); });
+
+    printf("%d anchors x %d classes: %zu candidates -> %zu detections (%s)\n", anchors, config.num_classes,
+           candidates, fast.size(), same ? "identical to scalar" : "DIFFERS from scalar");
+    printf("decoder: %8.1f us/frame (filter %.1f, nms %.1f)\n", total_us, filter_us, total_us - filter_us);
+    printf("scalar:  %8.1f us/frame (%.1fx)\n", scalar_us, scalar_us / total_us);
+    return same ? 0 : 1;
+}
@@ -0,0 +1,298 @@
+// Latency and throughput of handing frames between processes through
+// frame_ring, against sending the same bytes down a pipe to each reader.
+//
+// Usage:
+//     ring_bench                                   # 640x480 BGR, 2 lossy readers, unthrottled
+//     ring_bench --readers 3 --reliable 1 --fps 30 --cameras 8
+//     ring_bench --width 1600 --height 1200 --slots 16 --seconds 10
+//     ring_bench --transport pipe                  # the copying baseline
+//
+// One writer process fills each frame in place (as a decoder writing into
+// the slot would) and stamps it just before publishing. Each reader process
+// reads one byte per cache line of every frame it gets and records the
+// latency from publish to having read it (for pipes, after the copy out). Reliable readers hold the writer back instead of
+// skipping frames.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "frame_ring.h"
+#include "stats.h"
+
+using clock_type = std::chrono::steady_clock;
+
+static const uint32_t END = UINT32_MAX; // camera of the frame that stops the readers
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [--width N] [--height N] [--fps N] [--seconds N] [--cameras N] [--slots N]\n"
+            "          [--readers N] [--reliable N] [--transport ring|pipe]\n",
+            argv0);
+}
+
+static uint64_t now_us()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(clock_type::now().time_since_epoch()).count();
+}
+
+// Reads one byte per cache line, so the frame really crosses to this core
+static uint32_t touch(const uint8_t *data, size_t size)
+{
+    uint32_t sum = 0;
+    for (size_t i = 0; i < size; i += 64)
+        sum += data[i];
+    return sum;
+}
+
+struct reader_result {
+    uint64_t frames = 0, skipped = 0, invalid = 0, bytes = 0;
+    double seconds = 0;
+    edge::latency_histogram latency;
+};
+
+static void print_result(const char *name, int index, reader_result &r)
+{
+    printf("%-8s %2d %8llu %8llu %8llu %9.1f %8.2f %8llu %8llu %8llu\n", name, index, (unsigned long long)r.frames,
+           (unsigned long long)r.skipped, (unsigned long long)r.invalid, r.frames / r.seconds,
+           r.bytes / r.seconds / 1e9, (unsigned long long)r.latency.percentile(50),
+           (unsigned long long)r.latency.percentile(99), (unsigned long long)r.latency.percentile(100));
+    fflush(stdout);
+}
+
+static bool write_all(int fd, const void *data, size_t size)
+{
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    while (size) {
+        ssize_t n = write(fd, p, size);
+        if (n <= 0)
+            return false;
+        p += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+static bool read_all(int fd, void *data, size_t size)
+{
+    uint8_t *p = static_cast<uint8_t *>(data);
+    while (size) {
+        ssize_t n = read(fd, p, size);
+        if (n <= 0)
+            return false;
+        p += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+static int ring_reader_process(const std::string &name, int index, bool reliable)
+{
+    edge::frame_ring ring;
+    if (!ring.open(name))
+        return 1;
+    edge::ring_reader reader(ring, reliable);
+    if (!reader.attached())
+        return 1;
+
+    reader_result r;
+    edge::ring_view view;
+    clock_type::time_point start;
+    volatile uint32_t sink = 0;
+    for (;;) {
+        if (!reader.next(view, std::chrono::seconds(5)))
+            break;
+        if (view.info.camera == END)
+            break;
+        if (!r.frames)
+            start = clock_type::now();
+        sink += touch(view.data, view.info.size);
+        uint64_t received = now_us();
+        if (!reader.valid(view)) {
+            r.invalid++;
+            continue;
+        }
+        r.frames++;
+        r.bytes += view.info.size;
+        r.latency.record(received - view.info.timestamp_us);
+    }
+    r.seconds = std::max(std::chrono::duration<double>(clock_type::now() - start).count(), 1e-9);
+    r.skipped = reader.skipped();
+    print_result(reliable ? "reliable" : "lossy", index, r);
+    return 0;
+}
+
+static int pipe_reader_process(int fd, int index, size_t slot_size)
+{
+    reader_result r;
+    edge::frame_info info;
+    std::vector<uint8_t> frame(slot_size);
+    clock_type::time_point start;
+    volatile uint32_t sink = 0;
+    while (read_all(fd, &info, sizeof(info)) && info.camera != END) {
+        if (!read_all(fd, frame.data(), info.size))
+            break;
+        if (!r.frames)
+            start = clock_type::now();
+        sink += touch(frame.data(), info.size);
+        uint64_t received = now_us();
+        r.frames++;
+        r.bytes += info.size;
+        r.latency.record(received - info.timestamp_us);
+    }
+    r.seconds = std::max(std::chrono::duration<double>(clock_type::now() - start).count(), 1e-9);
+    print_result("pipe", index, r);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int width = 640, height = 480, cameras = 4, readers = 2, reliable = 0;
+    uint32_t slots = 8;
+    double fps = 0, seconds = 5;
+    std::string transport = "ring";
+
+    for (int i = 1; i < argc; i += 2) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!value) {
+            usage(argv[0]);
+            return 1;
+        }
+        if (!strcmp(arg, "--width"))
+            width = atoi(value);
+        else if (!strcmp(arg, "--height"))
+            height = atoi(value);
+        else if (!strcmp(arg, "--fps"))
+            fps = atof(value);
+        else if (!strcmp(arg, "--seconds"))
+            seconds = atof(value);
+        else if (!strcmp(arg, "--cameras"))
+            cameras = atoi(value);
+        else if (!strcmp(arg, "--slots"))
+            slots = (uint32_t)atoi(value);
+        else if (!strcmp(arg, "--readers"))
+            readers = atoi(value);
+        else if (!strcmp(arg, "--reliable"))
+            reliable = atoi(value);
+        else if (!strcmp(arg, "--transport"))
+            transport = value;
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    bool pipes = transport == "pipe";
+    if (width <= 0 || height <= 0 || cameras <= 0 || readers < 0 || reliable < 0 || readers + reliable == 0 ||
+        (!pipes && transport != "ring")) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    size_t frame_size = (size_t)width * height * 3;
+    std::string name = "/edge_ring_bench_" + std::to_string(getpid());
+    edge::frame_ring ring;
+    if (!pipes && !ring.create(name, slots, frame_size))
+        return 1;
+
+    printf("%s, %d x %d BGR (%.2f MB), %d cameras, %s fps", transport.c_str(), width, height, frame_size / 1e6,
+           cameras, fps > 0 ? std::to_string((int)fps).c_str() : "max");
+    if (pipes)
+        printf(", %d readers", readers + reliable);
+    else
+        printf(", %d lossy + %d reliable readers, %u slots", readers, reliable, ring.slots());
+    printf("\n%-8s %2s %8s %8s %8s %9s %8s %8s %8s %8s\n", "reader", "", "frames", "skipped", "invalid", "frames/s",
+           "GB/s", "p50 us", "p99 us", "max us");
+    fflush(stdout);
+
+    // pipe readers all get every frame, like reliable ones
+    std::vector<pid_t> children;
+    std::vector<int> fds;
+    for (int i = 0; i < readers + reliable; i++) {
+        int p[2] = {-1, -1};
+        if (pipes && pipe(p) != 0) {
+            perror("pipe");
+            return 1;
+        }
+        pid_t child = fork();
+        if (child == 0) {
+            if (pipes) {
+                close(p[1]);
+                for (int fd : fds)
+                    close(fd);
+                _exit(pipe_reader_process(p[0], i, frame_size));
+            }
+            _exit(ring_reader_process(name, i, i >= readers));
+        }
+        children.push_back(child);
+        if (pipes) {
+            close(p[0]);
+            fds.push_back(p[1]);
+        }
+    }
+    // readers start from the frames published after they attach
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    std::vector<uint8_t> frame(frame_size);
+    uint64_t written = 0, stalls = 0;
+    auto start = clock_type::now(), next = start;
+    auto end = start + std::chrono::duration_cast<clock_type::duration>(std::chrono::duration<double>(seconds));
+    while (clock_type::now() < end) {
+        edge::frame_info info;
+        info.camera = (uint32_t)(written % cameras);
+        info.width = (uint32_t)width;
+        info.height = (uint32_t)height;
+        info.size = (uint32_t)frame_size;
+        if (pipes) {
+            memset(frame.data(), (int)(written & 0xFF), frame_size);
+            info.timestamp_us = now_us();
+            for (int fd : fds)
+                if (!write_all(fd, &info, sizeof(info)) || !write_all(fd, frame.data(), frame_size))
+                    return 1;
+        } else {
+            edge::ring_slot slot;
+            while (!ring.try_claim(slot)) {
+                stalls++;
+                std::this_thread::yield();
+            }
+            *slot.info = info;
+            memset(slot.data, (int)(written & 0xFF), frame_size);
+            slot.info->timestamp_us = now_us();
+            ring.publish(slot);
+        }
+        written++;
+        if (fps > 0) {
+            next += std::chrono::duration_cast<clock_type::duration>(std::chrono::duration<double>(1 / fps));
+            std::this_thread::sleep_until(next);
+        }
+    }
+    double elapsed = std::chrono::duration<double>(clock_type::now() - start).count();
+
+    edge::frame_info stop;
+    stop.camera = END;
+    if (pipes) {
+        for (int fd : fds) {
+            write_all(fd, &stop, sizeof(stop));
+            close(fd);
+        }
+    } else {
+        while (!ring.try_write(stop, nullptr))
+            std::this_thread::yield();
+    }
+    int failed = 0;
+    for (pid_t child : children) {
+        int status = 0;
+        waitpid(child, &status, 0);
+        failed += !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+    }
+    printf("writer      %8llu frames, %.1f frames/s, %llu stalled claims\n", (unsigned long long)written,
+           written / elapsed, (unsigned long long)stalls);
+    return failed ? 1 : 0;
+}
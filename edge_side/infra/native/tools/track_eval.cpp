@@ -0,0 +1,322 @@
+// Accuracy versus compute of line counting when the detector only runs on
+// every Nth frame and the tracker predicts the frames in between.
+//
+// Usage:
+//     track_eval --synthetic                     # generated scenes with known counts
+//     track_eval --clip DIR --line 320,0,320,480 # JPEG sequence, detector run once
+//     track_eval --clip DIR --line ... --truth 12,9
+//
+// A clip is a directory of JPEG frames whose names sort in capture order.
+// The detector runs once over every frame and each stride replays the cached
+// detections, so only the counting differs between strides. Without --truth
+// the counts of stride 1 are the reference.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "frame_decoder.h"
+#include "tracker.h"
+#include "yolo.h"
+
+using clock_type = std::chrono::steady_clock;
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s --synthetic [--scenes N] [--frames N] [--walkers N] [--seed N] [--strides 1,2,3,5,10]\n"
+            "       %s --clip DIR --line X1,Y1,X2,Y2 [--truth ENTRIES,EXITS] [--model DIR] [--threads N]\n"
+            "          [--conf X] [--strides 1,2,3,5,10]\n",
+            argv0, argv0);
+}
+
+static std::vector<float> parse_list(const char *s)
+{
+    std::vector<float> out;
+    for (const char *p = s; *p;) {
+        char *end;
+        out.push_back(strtof(p, &end));
+        if (end == p)
+            return {};
+        p = *end == ',' ? end + 1 : end;
+    }
+    return out;
+}
+
+// The detections of every frame of a sequence, plus what the counts should be
+struct sequence {
+    int width, height;
+    std::vector<std::vector<edge::detection>> frames;
+    edge::point a, b;
+    edge::count_totals truth;
+};
+
+struct stride_result {
+    edge::count_totals counted;
+    uint64_t detector_frames = 0;
+    double tracker_us = 0; // per frame
+};
+
+static stride_result replay(const sequence &seq, int stride)
+{
+    stride_result r;
+    edge::tracker tracker;
+    edge::line_counter line(seq.a, seq.b);
+    clock_type::time_point start = clock_type::now();
+    for (size_t f = 0; f < seq.frames.size(); f++) {
+        if (f % stride == 0) {
+            line.update(tracker.update(seq.frames[f]));
+            r.detector_frames++;
+        } else {
+            line.update(tracker.predict());
+        }
+    }
+    r.tracker_us = std::chrono::duration<double, std::micro>(clock_type::now() - start).count() / seq.frames.size();
+    r.counted = line.totals();
+    return r;
+}
+
+// People walking in straight lines across a 640x480 view through a vertical
+// counting line, seen by a detector that misses some, is unsure of others,
+// jitters and sees the odd ghost
+static sequence synthetic_scene(std::mt19937 &rng, int frames, int walkers)
+{
+    sequence seq;
+    seq.width = 640;
+    seq.height = 480;
+    seq.a = {320, 40};
+    seq.b = {320, 470};
+    seq.frames.resize(frames);
+
+    std::uniform_real_distribution<float> uniform(0, 1);
+    std::normal_distribution<float> jitter(0, 2.5f);
+    for (int w = 0; w < walkers; w++) {
+        bool rightwards = uniform(rng) < 0.5f;
+        float speed = 2 + 5 * uniform(rng); // px per frame
+        float height = 80 + 80 * uniform(rng);
+        float y0 = 120 + 340 * uniform(rng), y1 = std::min(470.f, std::max(120.f, y0 + 120 * (uniform(rng) - 0.5f)));
+        float x0 = rightwards ? -20 : seq.width + 20, x1 = rightwards ? seq.width + 20 : -20;
+        int duration = (int)(std::fabs(x1 - x0) / speed);
+        int start = (int)((frames - duration) * uniform(rng));
+        if (start < 0)
+            continue;
+        // feet on the line's extent at the crossing, so every walker counts once
+        (rightwards ? seq.truth.entries : seq.truth.exits)++;
+
+        for (int f = 0; f < duration; f++) {
+            float t = (float)f / duration;
+            float x = x0 + (x1 - x0) * t, y = y0 + (y1 - y0) * t;
+            float p = uniform(rng);
+            if (p < 0.08f)
+                continue; // missed
+            float score = p < 0.2f ? 0.15f + 0.3f * uniform(rng) : 0.55f + 0.4f * uniform(rng);
+            float w_box = height * 0.4f;
+            edge::detection d = {x - w_box / 2 + jitter(rng), y - height + jitter(rng), x + w_box / 2 + jitter(rng),
+                                 y + jitter(rng), score, 0};
+            seq.frames[start + f].push_back(d);
+        }
+    }
+
+    for (int f = 0; f < frames; f++) {
+        if (uniform(rng) < 0.03f) {
+            float x = seq.width * uniform(rng), y = 100 + 380 * uniform(rng);
+            seq.frames[f].push_back({x - 20, y - 100, x + 20, y, 0.5f + 0.2f * uniform(rng), 0});
+        }
+    }
+    return seq;
+}
+
+static uint64_t count_error(const edge::count_totals &counted, const edge::count_totals &truth)
+{
+    auto diff = [](uint64_t a, uint64_t b) { return a > b ? a - b : b - a; };
+    return diff(counted.entries, truth.entries) + diff(counted.exits, truth.exits);
+}
+
+static void print_header()
+{
+    printf("%6s %10s %9s %9s %9s %10s %9s %12s\n", "stride", "detector", "compute", "entries", "exits", "abs error",
+           "error %", "tracker us");
+}
+
+static void print_row(int stride, const stride_result &r, uint64_t frames, uint64_t error, uint64_t truth_total)
+{
+    printf("%6d %10llu %8.1f%% %9llu %9llu %10llu %8.1f%% %12.2f\n", stride, (unsigned long long)r.detector_frames,
+           100.0 * r.detector_frames / frames, (unsigned long long)r.counted.entries,
+           (unsigned long long)r.counted.exits, (unsigned long long)error,
+           truth_total ? 100.0 * error / truth_total : 0.0, r.tracker_us);
+}
+
+static int run_synthetic(int scenes, int frames, int walkers, unsigned seed, const std::vector<int> &strides)
+{
+    std::mt19937 rng(seed);
+    std::vector<sequence> all;
+    uint64_t truth_entries = 0, truth_exits = 0, total_frames = 0;
+    for (int s = 0; s < scenes; s++) {
+        all.push_back(synthetic_scene(rng, frames, walkers));
+        truth_entries += all.back().truth.entries;
+        truth_exits += all.back().truth.exits;
+        total_frames += frames;
+    }
+    printf("%d scenes of %d frames, truth %llu entries / %llu exits\n", scenes, frames,
+           (unsigned long long)truth_entries, (unsigned long long)truth_exits);
+
+    print_header();
+    for (int stride : strides) {
+        stride_result sum;
+        uint64_t error = 0;
+        double us = 0;
+        for (const sequence &seq : all) {
+            stride_result r = replay(seq, stride);
+            sum.counted.entries += r.counted.entries;
+            sum.counted.exits += r.counted.exits;
+            sum.detector_frames += r.detector_frames;
+            error += count_error(r.counted, seq.truth);
+            us += r.tracker_us;
+        }
+        sum.tracker_us = us / all.size();
+        print_row(stride, sum, total_frames, error, truth_entries + truth_exits);
+    }
+    return 0;
+}
+
+static bool read_file(const std::string &path, std::vector<uint8_t> &data)
+{
+    std::ifstream file(path, std::ios::binary);
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return !data.empty();
+}
+
+static std::vector<std::string> list_jpegs(const std::string &dir)
+{
+    std::vector<std::string> names;
+    if (DIR *d = opendir(dir.c_str())) {
+        while (dirent *e = readdir(d)) {
+            std::string name = e->d_name;
+            size_t dot = name.rfind('.');
+            std::string ext = dot == std::string::npos ? "" : name.substr(dot + 1);
+            std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+            if (ext == "jpg" || ext == "jpeg")
+                names.push_back(dir + "/" + name);
+        }
+        closedir(d);
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+static int run_clip(const std::string &dir, const edge::yolo_config &config, const std::vector<float> &line,
+                    const std::vector<float> &truth, const std::vector<int> &strides)
+{
+    std::vector<std::string> paths = list_jpegs(dir);
+    if (paths.empty()) {
+        fprintf(stderr, "No JPEG frames in %s\n", dir.c_str());
+        return 1;
+    }
+    edge::yolo_detector detector(config);
+    if (!detector.load())
+        return 1;
+
+    sequence seq;
+    seq.a = {line[0], line[1]};
+    seq.b = {line[2], line[3]};
+    edge::frame_decoder decoder;
+    double detect_ms = 0;
+    for (const std::string &path : paths) {
+        std::vector<uint8_t> jpeg;
+        edge::bgr_image image;
+        if (!read_file(path, jpeg) || !decoder.decode(jpeg.data(), jpeg.size(), image)) {
+            fprintf(stderr, "Cannot decode %s\n", path.c_str());
+            return 1;
+        }
+        seq.frames.emplace_back();
+        clock_type::time_point start = clock_type::now();
+        if (!detector.detect(image, seq.frames.back()))
+            return 1;
+        detect_ms += std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+    }
+    detect_ms /= paths.size();
+    printf("%zu frames, detector %.1f ms/frame (%d threads)\n", paths.size(), detect_ms, detector.threads());
+
+    if (truth.size() == 2) {
+        seq.truth.entries = (uint64_t)truth[0];
+        seq.truth.exits = (uint64_t)truth[1];
+        printf("truth %llu entries / %llu exits\n", (unsigned long long)seq.truth.entries,
+               (unsigned long long)seq.truth.exits);
+    } else {
+        seq.truth = replay(seq, 1).counted;
+        printf("reference (stride 1) %llu entries / %llu exits\n", (unsigned long long)seq.truth.entries,
+               (unsigned long long)seq.truth.exits);
+    }
+
+    print_header();
+    for (int stride : strides) {
+        stride_result r = replay(seq, stride);
+        print_row(stride, r, seq.frames.size(), count_error(r.counted, seq.truth),
+                  seq.truth.entries + seq.truth.exits);
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    edge::yolo_config config;
+    config.model_dir = MODEL_DIR;
+    // the tracker's second round wants the weak detections too
+    config.conf = 0.1f;
+    bool synthetic = false;
+    int scenes = 5, frames = 3000, walkers = 40;
+    unsigned seed = 1;
+    std::string clip;
+    std::vector<float> line, truth;
+    std::vector<int> strides = {1, 2, 3, 5, 10};
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--synthetic")
+            synthetic = true;
+        else if (arg == "--scenes" && has_value)
+            scenes = std::max(1, atoi(argv[++i]));
+        else if (arg == "--frames" && has_value)
+            frames = std::max(1, atoi(argv[++i]));
+        else if (arg == "--walkers" && has_value)
+            walkers = std::max(0, atoi(argv[++i]));
+        else if (arg == "--seed" && has_value)
+            seed = (unsigned)atoi(argv[++i]);
+        else if (arg == "--clip" && has_value)
+            clip = argv[++i];
+        else if (arg == "--line" && has_value)
+            line = parse_list(argv[++i]);
+        else if (arg == "--truth" && has_value)
+            truth = parse_list(argv[++i]);
+        else if (arg == "--model" && has_value)
+            config.model_dir = argv[++i];
+        else if (arg == "--threads" && has_value)
+            config.threads = atoi(argv[++i]);
+        else if (arg == "--conf" && has_value)
+            config.conf = (float)atof(argv[++i]);
+        else if (arg == "--strides" && has_value) {
+            strides.clear();
+            for (float s : parse_list(argv[++i]))
+                if (s >= 1)
+                    strides.push_back((int)s);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (synthetic && !strides.empty())
+        return run_synthetic(scenes, frames, walkers, seed, strides);
+    if (!clip.empty() && line.size() == 4 && !strides.empty() && (truth.empty() || truth.size() == 2))
+        return run_clip(clip, config, line, truth, strides);
+    usage(argv[0]);
+    return 1;
+}
@@ -0,0 +1,141 @@
+// Standalone ingest server: accepts the ESP32 cameras on the same port as
+// ws_server.py, decodes their frames and prints a per-camera report.
+//
+// Usage:
+//     ws_ingest                          # 0.0.0.0:8080, 2 decode threads
+//     ws_ingest --port 9000 --workers 4 --report-interval 5
+//     ws_ingest --batch 4 --slo-ms 1000  # count people, batching across cameras
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "batch_scheduler.h"
+#include "ingest_server.h"
+#include "yolo.h"
+
+static volatile sig_atomic_t g_stop = 0;
+
+static void on_signal(int)
+{
+    g_stop = 1;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [--host ADDR] [--port N] [--workers N] [--scale 0-3] [--report-interval SEC]\n"
+            "          [--batch N] [--max-wait-ms N] [--slo-ms N] [--threads N] [--model DIR]\n",
+            argv0);
+}
+
+int main(int argc, char **argv)
+{
+    edge::ingest_config config;
+    double interval = 2.0;
+    edge::batch_config batching;
+    batching.max_batch = 0; // no inference unless --batch is given
+    edge::yolo_config detector_config;
+    detector_config.model_dir = MODEL_DIR;
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!strcmp(arg, "--help") || !value) {
+            usage(argv[0]);
+            return strcmp(arg, "--help") ? 1 : 0;
+        }
+        if (!strcmp(arg, "--host"))
+            config.host = value;
+        else if (!strcmp(arg, "--port"))
+            config.port = (uint16_t)atoi(value);
+        else if (!strcmp(arg, "--workers"))
+            config.decode_threads = atoi(value);
+        else if (!strcmp(arg, "--scale"))
+            config.decode_scale = (uint8_t)atoi(value);
+        else if (!strcmp(arg, "--report-interval"))
+            interval = atof(value);
+        else if (!strcmp(arg, "--batch"))
+            batching.max_batch = atoi(value);
+        else if (!strcmp(arg, "--max-wait-ms"))
+            batching.max_wait = std::chrono::microseconds((int64_t)(atof(value) * 1000));
+        else if (!strcmp(arg, "--slo-ms"))
+            batching.slo = std::chrono::microseconds((int64_t)(atof(value) * 1000));
+        else if (!strcmp(arg, "--threads"))
+            detector_config.threads = atoi(value);
+        else if (!strcmp(arg, "--model"))
+            detector_config.model_dir = value;
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+        i++;
+    }
+
+    config.on_text = [](uint32_t camera, const std::string &text) {
+        printf("[Ingest] camera %u: %s\n", camera, text.c_str());
+    };
+
+    // latest people count of each camera, written by the scheduler thread
+    std::mutex counts_mutex;
+    std::map<uint32_t, size_t> counts;
+    std::unique_ptr<edge::yolo_detector> detector;
+    std::unique_ptr<edge::batch_scheduler> scheduler;
+    if (batching.max_batch > 0) {
+        detector.reset(new edge::yolo_detector(detector_config));
+        if (!detector->load())
+            return 1;
+        scheduler.reset(new edge::batch_scheduler(
+            batching,
+            [&](const std::vector<const edge::bgr_image *> &images, std::vector<std::vector<edge::detection>> &out) {
+                return detector->detect_batch(images, out);
+            },
+            [&](edge::batch_result &result) {
+                std::lock_guard<std::mutex> lock(counts_mutex);
+                counts[result.frame->camera] = result.detections.size();
+            }));
+        scheduler->start();
+    }
+
+    edge::ingest_server server(config);
+    if (!server.start())
+        return 1;
+    printf("[Ingest] Listening on %s:%u with %d decode threads\n", config.host.c_str(), server.port(),
+           config.decode_threads);
+    if (scheduler)
+        printf("[Ingest] Detector on %d threads, batches of up to %d, SLO %.0f ms\n", detector->threads(),
+               batching.max_batch, batching.slo.count() / 1000.0);
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    // Without a detector frames are taken and discarded as fast as they come
+    auto next_report = std::chrono::steady_clock::now() + std::chrono::duration<double>(interval);
+    while (!g_stop) {
+        edge::frame_ptr frame;
+        if (server.next_frame(frame, std::chrono::milliseconds(100)) && scheduler)
+            scheduler->submit(std::move(frame));
+        if (std::chrono::steady_clock::now() >= next_report) {
+            std::vector<edge::camera_report> reports = server.report();
+            if (!reports.empty())
+                fputs(edge::ingest_server::format_report(reports).c_str(), stdout);
+            if (scheduler) {
+                fputs(edge::batch_scheduler::format_report(scheduler->report()).c_str(), stdout);
+                std::lock_guard<std::mutex> lock(counts_mutex);
+                for (const auto &it : counts)
+                    printf("camera %u: %zu people\n", it.first, it.second);
+            }
+            fflush(stdout);
+            next_report += std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(interval));
+        }
+    }
+
+    printf("[Ingest] Stopping\n");
+    server.stop();
+    if (scheduler)
+        scheduler->stop();
+    return 0;
+}
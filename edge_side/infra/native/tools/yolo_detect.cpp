@@ -0,0 +1,182 @@
+// Runs the native YOLO detector on JPEG files.
+//
+// Usage:
+//     yolo_detect image.jpg ...                  # detections per image
+//     yolo_detect --profile --runs 10 image.jpg  # per-layer timings
+//     yolo_detect --json image.jpg               # one JSON object per image
+//     yolo_detect --input-raw in.f32 --dump-output out.f32
+//                                                # raw tensors, see compare_ncnn.py
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+
+#include "frame_decoder.h"
+#include "yolo.h"
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [--model DIR] [--threads N] [--conf X] [--iou X] [--runs N] [--profile] [--json]\n"
+            "          [--input-raw FILE] [--dump-output FILE] [image.jpg ...]\n",
+            argv0);
+}
+
+static bool read_file(const std::string &path, std::vector<uint8_t> &data)
+{
+    std::ifstream file(path, std::ios::binary);
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return !data.empty();
+}
+
+static bool write_tensor(const std::string &path, const edge::tensor &t)
+{
+    FILE *f = fopen(path.c_str(), "wb");
+    if (!f)
+        return false;
+    bool ok = fwrite(t.data, sizeof(float), t.total(), f) == t.total();
+    fclose(f);
+    return ok;
+}
+
+static void print_profile(const std::vector<std::vector<edge::layer_timing>> &runs)
+{
+    // median over runs for each layer, then a summary per layer type
+    size_t layers = runs[0].size();
+    std::vector<double> median(layers);
+    double total = 0;
+    for (size_t i = 0; i < layers; i++) {
+        std::vector<double> v;
+        for (const auto &r : runs)
+            v.push_back(r[i].us);
+        std::sort(v.begin(), v.end());
+        median[i] = v[v.size() / 2];
+        total += median[i];
+    }
+
+    printf("%-40s %-22s %10s %6s\n", "layer", "type", "ms", "%");
+    for (size_t i = 0; i < layers; i++)
+        printf("%-40s %-22s %10.3f %6.2f\n", runs[0][i].name.c_str(), runs[0][i].type.c_str(), median[i] / 1000,
+               100 * median[i] / total);
+
+    std::map<std::string, std::pair<double, int>> by_type;
+    for (size_t i = 0; i < layers; i++) {
+        by_type[runs[0][i].type].first += median[i];
+        by_type[runs[0][i].type].second++;
+    }
+    printf("\n%-22s %6s %10s %6s\n", "type", "count", "ms", "%");
+    for (const auto &it : by_type)
+        printf("%-22s %6d %10.3f %6.2f\n", it.first.c_str(), it.second.second, it.second.first / 1000,
+               100 * it.second.first / total);
+    printf("%-22s %6zu %10.3f\n", "total", layers, total / 1000);
+}
+
+int main(int argc, char **argv)
+{
+    edge::yolo_config config;
+    config.model_dir = MODEL_DIR;
+    int runs = 1;
+    bool profile = false, json = false;
+    std::string input_raw, dump_output;
+    std::vector<std::string> images;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--profile")
+            profile = true;
+        else if (arg == "--json")
+            json = true;
+        else if (arg == "--model" && has_value)
+            config.model_dir = argv[++i];
+        else if (arg == "--threads" && has_value)
+            config.threads = atoi(argv[++i]);
+        else if (arg == "--conf" && has_value)
+            config.conf = (float)atof(argv[++i]);
+        else if (arg == "--iou" && has_value)
+            config.iou = (float)atof(argv[++i]);
+        else if (arg == "--runs" && has_value)
+            runs = std::max(1, atoi(argv[++i]));
+        else if (arg == "--input-raw" && has_value)
+            input_raw = argv[++i];
+        else if (arg == "--dump-output" && has_value)
+            dump_output = argv[++i];
+        else if (arg[0] == '-') {
+            usage(argv[0]);
+            return 1;
+        } else
+            images.push_back(arg);
+    }
+    if (images.empty() && input_raw.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    edge::yolo_detector detector(config);
+    auto t0 = std::chrono::steady_clock::now();
+    if (!detector.load())
+        return 1;
+    if (!json)
+        printf("Loaded %s in %.0f ms\n", config.model_dir.c_str(),
+               std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+
+    // a preprocessed input straight from Python, so only the network is compared
+    if (!input_raw.empty()) {
+        std::vector<uint8_t> raw;
+        edge::tensor input = edge::tensor::make_3d(config.input_size, config.input_size, 3);
+        if (!read_file(input_raw, raw) || raw.size() != input.total() * sizeof(float)) {
+            fprintf(stderr, "%s is not a 3x%dx%d float32 tensor\n", input_raw.c_str(), config.input_size,
+                    config.input_size);
+            return 1;
+        }
+        memcpy(input.data, raw.data(), raw.size());
+        edge::tensor output;
+        if (!detector.infer(input, output) || (!dump_output.empty() && !write_tensor(dump_output, output)))
+            return 1;
+        printf("out0: %d x %d\n", output.h, output.w);
+        return 0;
+    }
+
+    edge::frame_decoder decoder;
+    for (const std::string &path : images) {
+        std::vector<uint8_t> jpeg;
+        edge::bgr_image image;
+        if (!read_file(path, jpeg) || !decoder.decode(jpeg.data(), jpeg.size(), image)) {
+            fprintf(stderr, "Cannot decode %s\n", path.c_str());
+            return 1;
+        }
+
+        std::vector<edge::detection> detections;
+        std::vector<std::vector<edge::layer_timing>> timings(runs);
+        std::vector<double> totals;
+        for (int r = 0; r < runs; r++) {
+            auto start = std::chrono::steady_clock::now();
+            if (!detector.detect(image, detections, profile ? &timings[r] : nullptr))
+                return 1;
+            totals.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        std::sort(totals.begin(), totals.end());
+
+        if (json) {
+            printf("{\"image\": \"%s\", \"people_count\": %zu, \"detections\": [", path.c_str(), detections.size());
+            for (size_t i = 0; i < detections.size(); i++) {
+                const edge::detection &d = detections[i];
+                printf("%s{\"class_id\": %d, \"confidence\": %.5f, \"bbox\": [%.2f, %.2f, %.2f, %.2f]}",
+                       i ? ", " : "", d.cls, d.score, d.x1, d.y1, d.x2, d.y2);
+            }
+            printf("]}\n");
+        } else {
+            printf("%s: %ux%u, %zu detections, %.1f ms (median of %d, %d threads)\n", path.c_str(), image.width,
+                   image.height, detections.size(), totals[totals.size() / 2], runs, detector.threads());
+            for (const edge::detection &d : detections)
+                printf("  class %d  %.3f  [%.1f, %.1f, %.1f, %.1f]\n", d.cls, d.score, d.x1, d.y1, d.x2, d.y2);
+        }
+        if (profile)
+            print_profile(timings);
+    }
+    return 0;
+}